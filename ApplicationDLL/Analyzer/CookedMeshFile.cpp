@@ -0,0 +1,107 @@
+﻿#include "CookedMeshFile.h"
+#include "../System/ContentHash.h"
+
+namespace
+{
+	/// [offset, offset + count * stride) がファイル内に収まり、境界がそろっているか
+	bool IsSectionInRange(uint64_t offset, uint64_t count, uint64_t stride, uint64_t fileSize)
+	{
+		if (offset % CookedMesh::kSectionAlignment != 0 || offset > fileSize)
+		{
+			return false;
+		}
+		return count <= (fileSize - offset) / stride;
+	}
+}
+
+///====================================================================
+/// <summary>
+/// クック済みメッシュをマップし、ヘッダーと各セクションの範囲を検証します。
+/// ペイロードのハッシュ照合は全体を読むため、ここでは行いません。
+/// </summary>
+/// <param name="filePath">.pmdc ファイルのパス</param>
+/// <returns>成功した場合は true</returns>
+///====================================================================
+bool CookedMeshFile::Open(const std::filesystem::path& filePath)
+{
+	Close();
+
+	if (!m_File.Open(filePath))
+	{
+		return Fail("failed to map file");
+	}
+	if (m_File.GetSize() < sizeof(CookedMesh::CookedMeshHeader))
+	{
+		return Fail("file is too small for cooked mesh header");
+	}
+
+	const auto* header = reinterpret_cast<const CookedMesh::CookedMeshHeader*>(m_File.GetData());
+	if (header->magic != CookedMesh::kMagic)
+	{
+		return Fail("invalid cooked mesh signature");
+	}
+	if (header->version != CookedMesh::kVersion ||
+		header->headerSize != sizeof(CookedMesh::CookedMeshHeader) ||
+		header->vertexStride != sizeof(CookedMesh::CookedVertex))
+	{
+		return Fail("cooked mesh version mismatch");
+	}
+	if (header->fileSize != m_File.GetSize())
+	{
+		return Fail("cooked mesh size mismatch");
+	}
+
+	const uint64_t fileSize = m_File.GetSize();
+	if (!IsSectionInRange(header->subsetOffset, header->subsetCount, sizeof(CookedMesh::CookedSubset), fileSize) ||
+		!IsSectionInRange(header->vertexOffset, header->vertexCount, sizeof(CookedMesh::CookedVertex), fileSize) ||
+		!IsSectionInRange(header->indexOffset, header->indexCount, sizeof(uint16_t), fileSize))
+	{
+		return Fail("cooked mesh section is out of range");
+	}
+
+	const uint8_t* data = m_File.GetData();
+	m_pHeader = header;
+	m_pSubsets = reinterpret_cast<const CookedMesh::CookedSubset*>(data + header->subsetOffset);
+	m_pVertices = reinterpret_cast<const CookedMesh::CookedVertex*>(data + header->vertexOffset);
+	m_pIndices = reinterpret_cast<const uint16_t*>(data + header->indexOffset);
+
+	for (uint32_t i = 0; i < header->subsetCount; ++i)
+	{
+		const uint64_t end = static_cast<uint64_t>(m_pSubsets[i].indexOffset) + m_pSubsets[i].indexCount;
+		if (end > header->indexCount)
+		{
+			return Fail("cooked mesh subset is out of range");
+		}
+	}
+
+	m_IsValid = true;
+	return true;
+}
+
+void CookedMeshFile::Close()
+{
+	m_File.Close();
+	m_IsValid = false;
+	m_LastError.clear();
+	m_pHeader = nullptr;
+	m_pSubsets = nullptr;
+	m_pVertices = nullptr;
+	m_pIndices = nullptr;
+}
+
+bool CookedMeshFile::VerifyPayloadHash() const
+{
+	if (!m_IsValid)
+	{
+		return false;
+	}
+	const size_t headerSize = sizeof(CookedMesh::CookedMeshHeader);
+	return ContentHash::Compute(m_File.GetData() + headerSize, m_File.GetSize() - headerSize) == m_pHeader->payloadHash;
+}
+
+bool CookedMeshFile::Fail(const char* message)
+{
+	Close();
+	m_LastError = message;
+	return false;
+}
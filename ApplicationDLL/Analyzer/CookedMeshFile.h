@@ -0,0 +1,50 @@
+﻿#pragma once
+
+#include "CookedMeshFormat.h"
+#include "MappedFile.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+///=======================================================================
+/// <summary>
+/// クック済みメッシュ（.pmdc）をメモリマップして参照します。
+/// Open 時にヘッダーとセクション範囲を検証するだけで、頂点やインデックスは
+/// コピーせずにマップ領域をそのまま GPU への転送元として使えます。
+/// </summary>
+///=======================================================================
+class CookedMeshFile
+{
+public:
+	bool Open(const std::filesystem::path& filePath);
+	void Close();
+
+	bool IsValid() const { return m_IsValid; }
+	const std::string& GetLastError() const { return m_LastError; }
+
+	/// ペイロード全体を読み直してハッシュを照合します（ツール用）。
+	bool VerifyPayloadHash() const;
+
+	const CookedMesh::CookedMeshHeader& GetHeader() const { return *m_pHeader; }
+	const CookedMesh::CookedSubset* GetSubsets() const { return m_pSubsets; }
+	const CookedMesh::CookedVertex* GetVertices() const { return m_pVertices; }
+	const uint16_t* GetIndices() const { return m_pIndices; }
+
+	uint32_t GetSubsetCount() const { return m_IsValid ? m_pHeader->subsetCount : 0; }
+	uint32_t GetVertexCount() const { return m_IsValid ? m_pHeader->vertexCount : 0; }
+	uint32_t GetIndexCount() const { return m_IsValid ? m_pHeader->indexCount : 0; }
+
+private:
+	bool Fail(const char* message);
+
+	MappedFile m_File;
+	bool m_IsValid = false;
+	std::string m_LastError;
+
+	const CookedMesh::CookedMeshHeader* m_pHeader = nullptr;
+	const CookedMesh::CookedSubset* m_pSubsets = nullptr;
+	const CookedMesh::CookedVertex* m_pVertices = nullptr;
+	const uint16_t* m_pIndices = nullptr;
+};
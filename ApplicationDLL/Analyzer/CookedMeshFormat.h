@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+///=======================================================================
+/// MeshCooker が出力するクック済みメッシュ（.pmdc）のディスクレイアウト。
+/// ファイル全体をそのままマップして参照できるよう、各セクションは
+/// kSectionAlignment 境界に配置します。
+///
+///   [CookedMeshHeader]
+///   [CookedSubset   × subsetCount]
+///   [CookedVertex   × vertexCount]
+///   [uint16_t index × indexCount]
+///=======================================================================
+namespace CookedMesh
+{
+	constexpr uint32_t kMagic = 0x43444D50;	// "PMDC"
+	constexpr uint32_t kVersion = 1;
+	constexpr size_t kSectionAlignment = 16;
+
+	///====================================================================
+	/// GPU にそのまま転送する量子化済み頂点（28 バイト）
+	///   position   : R32G32B32_FLOAT
+	///   normal     : R16G16_SNORM（八面体エンコード）
+	///   uv         : R16G16_FLOAT
+	///   boneIndex  : R16G16_UINT
+	///   boneWeight : R8G8_UNORM（x: boneIndex[0] の影響度, y: エッジフラグ）
+	///====================================================================
+	struct CookedVertex
+	{
+		float position[3];
+		int16_t normal[2];
+		uint16_t uv[2];
+		uint16_t boneIndex[2];
+		uint8_t boneWeight;
+		uint8_t edgeFlag;
+		uint16_t reserved;
+	};
+
+	/// マテリアル 1 つ分の描画範囲
+	struct CookedSubset
+	{
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		uint32_t materialIndex;
+		uint32_t reserved;
+	};
+
+	struct CookedMeshHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t headerSize;
+		uint32_t vertexStride;
+
+		uint64_t sourceHash;	// 元の PMD ファイル全体のハッシュ
+		uint64_t payloadHash;	// ヘッダー以降のデータのハッシュ
+
+		uint64_t fileSize;
+
+		uint32_t subsetCount;
+		uint32_t vertexCount;
+		uint32_t indexCount;
+		uint32_t reserved0;
+
+		uint64_t subsetOffset;
+		uint64_t vertexOffset;
+		uint64_t indexOffset;
+
+		float boundsMin[3];
+		float boundsMax[3];
+		uint64_t reserved1;
+	};
+
+	static_assert(sizeof(CookedVertex) == 28, "CookedVertex must be 28 bytes");
+	static_assert(sizeof(CookedSubset) == 16, "CookedSubset must be 16 bytes");
+	static_assert(sizeof(CookedMeshHeader) % kSectionAlignment == 0, "CookedMeshHeader must keep sections aligned");
+}
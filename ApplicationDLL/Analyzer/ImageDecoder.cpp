@@ -0,0 +1,799 @@
+﻿#include "ImageDecoder.h"
+
+#include "MappedFile.h"
+#include "PngDecoder.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t kBmpFileHeaderSize = 14;
+	constexpr uint32_t kBmpCoreHeaderSize = 12;
+	constexpr uint32_t kBmpInfoHeaderSize = 40;
+	constexpr uint32_t kBmpRgb = 0;
+	constexpr uint32_t kBmpRle8 = 1;
+	constexpr uint32_t kBmpRle4 = 2;
+	constexpr uint32_t kBmpBitFields = 3;
+	constexpr uint32_t kBmpAlphaBitFields = 6;
+
+	constexpr uint32_t kTgaHeaderSize = 18;
+	constexpr uint8_t kTgaColorMapped = 1;
+	constexpr uint8_t kTgaTrueColor = 2;
+	constexpr uint8_t kTgaGrayscale = 3;
+	constexpr uint8_t kTgaRleFlag = 8;
+	constexpr uint8_t kTgaTopOrigin = 0x20;
+	constexpr uint8_t kTgaRightOrigin = 0x10;
+
+	bool Fail(std::string* outError, const char* message)
+	{
+		if (outError != nullptr)
+		{
+			*outError = message;
+		}
+		return false;
+	}
+
+	uint16_t ReadU16(const uint8_t* p) { return static_cast<uint16_t>(p[0] | (p[1] << 8)); }
+	uint32_t ReadU32(const uint8_t* p)
+	{
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) | (static_cast<uint32_t>(p[2]) << 16) |
+			(static_cast<uint32_t>(p[3]) << 24);
+	}
+
+	void StoreRgba(uint8_t* destination, uint8_t r, uint8_t g, uint8_t b, uint8_t a)
+	{
+		destination[0] = r;
+		destination[1] = g;
+		destination[2] = b;
+		destination[3] = a;
+	}
+
+	/// すべての画素のアルファが 0 なら不透明にします（アルファを使わない 32 ビット画像を書き出すツールが多いため）。
+	void FixZeroAlpha(uint8_t* destination, size_t rowPitch, uint32_t width, uint32_t height)
+	{
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			const uint8_t* row = destination + y * rowPitch;
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				if (row[x * 4 + 3] != 0)
+				{
+					return;
+				}
+			}
+		}
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			uint8_t* row = destination + y * rowPitch;
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				row[x * 4 + 3] = 0xFF;
+			}
+		}
+	}
+
+	///=================================================================
+	/// BMP
+	///=================================================================
+
+	/// ビットマスクの 1 チャンネル分
+	struct BitField
+	{
+		uint32_t mask = 0;
+		uint32_t shift = 0;
+		uint32_t bits = 0;
+
+		explicit BitField(uint32_t value = 0) : mask(value)
+		{
+			if (mask == 0)
+			{
+				return;
+			}
+			while (((mask >> shift) & 1) == 0)
+			{
+				++shift;
+			}
+			while (shift + bits < 32 && ((mask >> (shift + bits)) & 1) != 0)
+			{
+				++bits;
+			}
+		}
+
+		uint8_t Extract(uint32_t pixel) const
+		{
+			const uint32_t value = (pixel & mask) >> shift;
+			if (bits >= 8)
+			{
+				return static_cast<uint8_t>(value >> (bits - 8));
+			}
+			return static_cast<uint8_t>(value * 255 / ((1u << bits) - 1));
+		}
+	};
+
+	struct BmpHeader
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		bool isTopDown = false;
+		uint32_t bitCount = 0;
+		uint32_t compression = kBmpRgb;
+		size_t pixelOffset = 0;
+		size_t paletteOffset = 0;
+		uint32_t paletteCount = 0;
+		/// パレットの 1 色のバイト数（OS/2 は 3、それ以外は 4）
+		uint32_t paletteEntrySize = 4;
+		BitField red;
+		BitField green;
+		BitField blue;
+		BitField alpha;
+	};
+
+	bool ParseBmpHeader(const uint8_t* data, size_t size, BmpHeader& outHeader, std::string* outError)
+	{
+		if (size < kBmpFileHeaderSize + kBmpCoreHeaderSize || data[0] != 'B' || data[1] != 'M')
+		{
+			return Fail(outError, "not a BMP file");
+		}
+		const uint32_t headerSize = ReadU32(data + kBmpFileHeaderSize);
+		if (headerSize < kBmpCoreHeaderSize || size < kBmpFileHeaderSize + headerSize)
+		{
+			return Fail(outError, "truncated BMP header");
+		}
+		const uint8_t* info = data + kBmpFileHeaderSize;
+		BmpHeader header;
+		header.pixelOffset = ReadU32(data + 10);
+		int32_t height = 0;
+		if (headerSize == kBmpCoreHeaderSize)
+		{
+			header.width = ReadU16(info + 4);
+			height = ReadU16(info + 6);
+			header.bitCount = ReadU16(info + 10);
+			header.paletteEntrySize = 3;
+		}
+		else if (headerSize >= kBmpInfoHeaderSize)
+		{
+			const int32_t width = static_cast<int32_t>(ReadU32(info + 4));
+			height = static_cast<int32_t>(ReadU32(info + 8));
+			if (width <= 0)
+			{
+				return Fail(outError, "invalid BMP width");
+			}
+			header.width = static_cast<uint32_t>(width);
+			header.bitCount = ReadU16(info + 14);
+			header.compression = ReadU32(info + 16);
+			header.paletteCount = ReadU32(info + 32);
+		}
+		else
+		{
+			return Fail(outError, "unsupported BMP header size");
+		}
+
+		if (height < 0)
+		{
+			header.isTopDown = true;
+			header.height = static_cast<uint32_t>(-static_cast<int64_t>(height));
+		}
+		else
+		{
+			header.height = static_cast<uint32_t>(height);
+		}
+		if (header.width == 0 || header.height == 0 || header.width > IImageDecoder::kMaxDimension || header.height > IImageDecoder::kMaxDimension)
+		{
+			return Fail(outError, "invalid BMP dimensions");
+		}
+
+		header.paletteOffset = kBmpFileHeaderSize + headerSize;
+		switch (header.compression)
+		{
+		case kBmpRgb:
+			if (header.bitCount == 16)
+			{
+				header.red = BitField(0x7C00);
+				header.green = BitField(0x03E0);
+				header.blue = BitField(0x001F);
+			}
+			else if (header.bitCount == 32)
+			{
+				header.red = BitField(0x00FF0000);
+				header.green = BitField(0x0000FF00);
+				header.blue = BitField(0x000000FF);
+				header.alpha = BitField(0xFF000000);
+			}
+			else if (header.bitCount != 1 && header.bitCount != 4 && header.bitCount != 8 && header.bitCount != 24)
+			{
+				return Fail(outError, "unsupported BMP bit count");
+			}
+			break;
+		case kBmpRle8:
+		case kBmpRle4:
+			if (header.bitCount != (header.compression == kBmpRle8 ? 8u : 4u) || header.isTopDown)
+			{
+				return Fail(outError, "invalid BMP RLE header");
+			}
+			break;
+		case kBmpBitFields:
+		case kBmpAlphaBitFields:
+		{
+			if (header.bitCount != 16 && header.bitCount != 32)
+			{
+				return Fail(outError, "invalid BMP bit field depth");
+			}
+			// 40 バイトのヘッダーではマスクがヘッダーの直後に続く
+			const bool hasAlphaMask = header.compression == kBmpAlphaBitFields || headerSize >= 56;
+			const uint8_t* masks = info + kBmpInfoHeaderSize;
+			const size_t maskBytes = hasAlphaMask ? 16 : 12;
+			if (static_cast<size_t>(masks - data) + maskBytes > size)
+			{
+				return Fail(outError, "truncated BMP bit masks");
+			}
+			header.red = BitField(ReadU32(masks));
+			header.green = BitField(ReadU32(masks + 4));
+			header.blue = BitField(ReadU32(masks + 8));
+			if (hasAlphaMask)
+			{
+				header.alpha = BitField(ReadU32(masks + 12));
+			}
+			if (headerSize == kBmpInfoHeaderSize)
+			{
+				header.paletteOffset += maskBytes;
+			}
+			break;
+		}
+		default:
+			return Fail(outError, "unsupported BMP compression");
+		}
+
+		if (header.bitCount <= 8)
+		{
+			const uint32_t maxCount = 1u << header.bitCount;
+			if (header.paletteCount == 0 || header.paletteCount > maxCount)
+			{
+				header.paletteCount = maxCount;
+			}
+			if (header.paletteOffset + static_cast<size_t>(header.paletteCount) * header.paletteEntrySize > size)
+			{
+				return Fail(outError, "truncated BMP palette");
+			}
+		}
+		if (header.pixelOffset >= size)
+		{
+			return Fail(outError, "invalid BMP pixel offset");
+		}
+		outHeader = header;
+		return true;
+	}
+
+	/// パレットを RGBA にします（足りない色は不透明の黒）。
+	void ReadBmpPalette(const uint8_t* data, const BmpHeader& header, uint8_t (&outPalette)[256][4])
+	{
+		memset(outPalette, 0, sizeof(outPalette));
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			outPalette[i][3] = 0xFF;
+		}
+		const uint8_t* entry = data + header.paletteOffset;
+		for (uint32_t i = 0; i < header.paletteCount; ++i, entry += header.paletteEntrySize)
+		{
+			StoreRgba(outPalette[i], entry[2], entry[1], entry[0], 0xFF);
+		}
+	}
+
+	/// 終端の印が無い・途中で切れている場合も、そこまでの画素を使います（書き出すツールによっては省くため）。
+	void DecodeBmpRle(const uint8_t* data, size_t size, const BmpHeader& header, const uint8_t (&palette)[256][4],
+		uint8_t* destination, size_t rowPitch)
+	{
+		// 飛ばされた画素は透明な黒のまま
+		for (uint32_t y = 0; y < header.height; ++y)
+		{
+			memset(destination + y * rowPitch, 0, static_cast<size_t>(header.width) * 4);
+		}
+
+		const bool isRle4 = header.compression == kBmpRle4;
+		const uint8_t* p = data + header.pixelOffset;
+		const uint8_t* const end = data + size;
+		uint32_t x = 0;
+		uint32_t y = 0;
+		const auto writePixel = [&](uint32_t index)
+		{
+			if (x < header.width && y < header.height)
+			{
+				// RLE は常に下の行から
+				memcpy(destination + (header.height - 1 - y) * rowPitch + x * 4, palette[index], 4);
+			}
+			++x;
+		};
+
+		while (end - p >= 2)
+		{
+			const uint32_t count = p[0];
+			const uint32_t value = p[1];
+			p += 2;
+			if (count > 0)
+			{
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					writePixel(isRle4 ? ((i & 1) == 0 ? value >> 4 : value & 0x0F) : value);
+				}
+				continue;
+			}
+			if (value == 0)
+			{
+				x = 0;
+				++y;
+			}
+			else if (value == 1)
+			{
+				return;
+			}
+			else if (value == 2)
+			{
+				if (end - p < 2)
+				{
+					break;
+				}
+				x += p[0];
+				y += p[1];
+				p += 2;
+			}
+			else
+			{
+				// 絶対モード: value 画素をそのまま並べ、2 バイト境界まで詰める
+				const size_t byteCount = isRle4 ? (value + 1) / 2 : value;
+				const size_t paddedCount = (byteCount + 1) & ~static_cast<size_t>(1);
+				if (static_cast<size_t>(end - p) < byteCount)
+				{
+					break;
+				}
+				for (uint32_t i = 0; i < value; ++i)
+				{
+					writePixel(isRle4 ? ((i & 1) == 0 ? p[i / 2] >> 4 : p[i / 2] & 0x0F) : p[i]);
+				}
+				p += static_cast<size_t>(end - p) < paddedCount ? static_cast<size_t>(end - p) : paddedCount;
+			}
+		}
+	}
+}
+
+///=====================================================================
+/// BmpDecoder
+///=====================================================================
+bool BmpDecoder::CanDecode(const uint8_t* data, size_t size) const
+{
+	return size >= kBmpFileHeaderSize + kBmpCoreHeaderSize && data[0] == 'B' && data[1] == 'M';
+}
+
+bool BmpDecoder::ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError) const
+{
+	BmpHeader header;
+	if (!ParseBmpHeader(data, size, header, outError))
+	{
+		return false;
+	}
+	outInfo.width = header.width;
+	outInfo.height = header.height;
+	outInfo.hasAlpha = header.alpha.mask != 0 || header.compression == kBmpRle4 || header.compression == kBmpRle8;
+	return true;
+}
+
+bool BmpDecoder::Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError) const
+{
+	BmpHeader header;
+	if (!ParseBmpHeader(data, size, header, outError))
+	{
+		return false;
+	}
+	uint8_t palette[256][4];
+	if (header.bitCount <= 8)
+	{
+		ReadBmpPalette(data, header, palette);
+	}
+	if (header.compression == kBmpRle8 || header.compression == kBmpRle4)
+	{
+		DecodeBmpRle(data, size, header, palette, destination, rowPitch);
+		return true;
+	}
+
+	const size_t stride = ((static_cast<size_t>(header.width) * header.bitCount + 31) / 32) * 4;
+	if (header.pixelOffset + stride * (header.height - 1) + (static_cast<size_t>(header.width) * header.bitCount + 7) / 8 > size)
+	{
+		return Fail(outError, "truncated BMP pixel data");
+	}
+
+	const uint32_t width = header.width;
+	for (uint32_t y = 0; y < header.height; ++y)
+	{
+		const uint8_t* source = data + header.pixelOffset + stride * y;
+		uint8_t* row = destination + (header.isTopDown ? y : header.height - 1 - y) * rowPitch;
+		switch (header.bitCount)
+		{
+		case 1:
+		case 4:
+		case 8:
+		{
+			const uint32_t bitCount = header.bitCount;
+			const uint32_t mask = (1u << bitCount) - 1;
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint32_t bitOffset = x * bitCount;
+				const uint32_t index = (source[bitOffset / 8] >> (8 - bitCount - bitOffset % 8)) & mask;
+				memcpy(row + x * 4, palette[index], 4);
+			}
+			break;
+		}
+		case 24:
+			for (uint32_t x = 0; x < width; ++x, source += 3)
+			{
+				StoreRgba(row + x * 4, source[2], source[1], source[0], 0xFF);
+			}
+			break;
+		case 32:
+			if (header.compression == kBmpRgb)
+			{
+				// BGRA の R と B を入れ替えるだけ（自動ベクトル化される形にしておく）
+				for (uint32_t x = 0; x < width; ++x)
+				{
+					uint32_t pixel = 0;
+					memcpy(&pixel, source + x * 4, 4);
+					pixel = (pixel & 0xFF00FF00u) | ((pixel >> 16) & 0xFFu) | ((pixel & 0xFFu) << 16);
+					memcpy(row + x * 4, &pixel, 4);
+				}
+				break;
+			}
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint32_t pixel = ReadU32(source + x * 4);
+				StoreRgba(row + x * 4, header.red.Extract(pixel), header.green.Extract(pixel), header.blue.Extract(pixel),
+					header.alpha.mask != 0 ? header.alpha.Extract(pixel) : 0xFF);
+			}
+			break;
+		case 16:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint32_t pixel = ReadU16(source + x * 2);
+				StoreRgba(row + x * 4, header.red.Extract(pixel), header.green.Extract(pixel), header.blue.Extract(pixel),
+					header.alpha.mask != 0 ? header.alpha.Extract(pixel) : 0xFF);
+			}
+			break;
+		default:
+			return Fail(outError, "unsupported BMP bit count");
+		}
+	}
+	if (header.bitCount == 32 && header.compression == kBmpRgb)
+	{
+		FixZeroAlpha(destination, rowPitch, header.width, header.height);
+	}
+	return true;
+}
+
+namespace
+{
+	///=================================================================
+	/// TGA
+	///=================================================================
+
+	struct TgaHeader
+	{
+		uint8_t imageType = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t depth = 0;
+		uint8_t descriptor = 0;
+		uint32_t colorMapFirst = 0;
+		uint32_t colorMapLength = 0;
+		uint32_t colorMapDepth = 0;
+		size_t colorMapOffset = 0;
+		size_t pixelOffset = 0;
+	};
+
+	bool IsTgaColorDepth(uint32_t depth)
+	{
+		return depth == 15 || depth == 16 || depth == 24 || depth == 32;
+	}
+
+	bool ParseTgaHeader(const uint8_t* data, size_t size, TgaHeader& outHeader, std::string* outError)
+	{
+		if (size < kTgaHeaderSize)
+		{
+			return Fail(outError, "truncated TGA header");
+		}
+		TgaHeader header;
+		const uint8_t colorMapType = data[1];
+		header.imageType = data[2];
+		header.colorMapFirst = ReadU16(data + 3);
+		header.colorMapLength = ReadU16(data + 5);
+		header.colorMapDepth = data[7];
+		header.width = ReadU16(data + 12);
+		header.height = ReadU16(data + 14);
+		header.depth = data[16];
+		header.descriptor = data[17];
+
+		const uint8_t baseType = header.imageType & ~kTgaRleFlag;
+		if (colorMapType > 1 || (baseType != kTgaColorMapped && baseType != kTgaTrueColor && baseType != kTgaGrayscale) ||
+			(header.imageType & ~(kTgaRleFlag | 3)) != 0 || (header.descriptor & 0xC0) != 0)
+		{
+			return Fail(outError, "not a TGA file");
+		}
+		if (header.width == 0 || header.height == 0 || header.width > IImageDecoder::kMaxDimension || header.height > IImageDecoder::kMaxDimension)
+		{
+			return Fail(outError, "invalid TGA dimensions");
+		}
+		switch (baseType)
+		{
+		case kTgaColorMapped:
+			if (colorMapType != 1 || header.depth != 8 || !IsTgaColorDepth(header.colorMapDepth) || header.colorMapLength == 0)
+			{
+				return Fail(outError, "invalid TGA color map");
+			}
+			break;
+		case kTgaTrueColor:
+			if (!IsTgaColorDepth(header.depth))
+			{
+				return Fail(outError, "unsupported TGA depth");
+			}
+			break;
+		default:
+			if (header.depth != 8 && header.depth != 16)
+			{
+				return Fail(outError, "unsupported TGA grayscale depth");
+			}
+			break;
+		}
+
+		header.colorMapOffset = kTgaHeaderSize + data[0];
+		const size_t colorMapBytes = colorMapType == 1 ? static_cast<size_t>(header.colorMapLength) * ((header.colorMapDepth + 7) / 8) : 0;
+		header.pixelOffset = header.colorMapOffset + colorMapBytes;
+		if (header.pixelOffset > size)
+		{
+			return Fail(outError, "truncated TGA color map");
+		}
+		outHeader = header;
+		return true;
+	}
+
+	/// 1 画素を RGBA にします（depth はカラーマップの色か画素のビット数）。
+	void ReadTgaColor(const uint8_t* source, uint32_t depth, bool isGrayscale, bool useAlphaBit, uint8_t* destination)
+	{
+		if (isGrayscale)
+		{
+			StoreRgba(destination, source[0], source[0], source[0], depth == 16 ? source[1] : 0xFF);
+			return;
+		}
+		switch (depth)
+		{
+		case 15:
+		case 16:
+		{
+			const uint32_t pixel = ReadU16(source);
+			const auto expand = [](uint32_t value) { return static_cast<uint8_t>((value << 3) | (value >> 2)); };
+			StoreRgba(destination, expand((pixel >> 10) & 0x1F), expand((pixel >> 5) & 0x1F), expand(pixel & 0x1F),
+				useAlphaBit && depth == 16 ? ((pixel & 0x8000) != 0 ? 0xFF : 0) : 0xFF);
+			break;
+		}
+		case 24:
+			StoreRgba(destination, source[2], source[1], source[0], 0xFF);
+			break;
+		default:
+			StoreRgba(destination, source[2], source[1], source[0], source[3]);
+			break;
+		}
+	}
+}
+
+///=====================================================================
+/// TgaDecoder
+///=====================================================================
+bool TgaDecoder::CanDecode(const uint8_t* data, size_t size) const
+{
+	TgaHeader header;
+	return ParseTgaHeader(data, size, header, nullptr);
+}
+
+bool TgaDecoder::ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError) const
+{
+	TgaHeader header;
+	if (!ParseTgaHeader(data, size, header, outError))
+	{
+		return false;
+	}
+	const uint32_t colorDepth = (header.imageType & ~kTgaRleFlag) == kTgaColorMapped ? header.colorMapDepth : header.depth;
+	outInfo.width = header.width;
+	outInfo.height = header.height;
+	outInfo.hasAlpha = colorDepth == 32 || (colorDepth == 16 && (header.descriptor & 0x0F) != 0);
+	return true;
+}
+
+bool TgaDecoder::Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError) const
+{
+	TgaHeader header;
+	if (!ParseTgaHeader(data, size, header, outError))
+	{
+		return false;
+	}
+	const uint8_t baseType = header.imageType & ~kTgaRleFlag;
+	const bool isRle = (header.imageType & kTgaRleFlag) != 0;
+	const bool isGrayscale = baseType == kTgaGrayscale;
+	// 16 ビットの最上位ビットは、属性ビット数が 1 のときだけアルファとして使う
+	const bool useAlphaBit = (header.descriptor & 0x0F) == 1;
+	const uint32_t bytesPerPixel = (header.depth + 7) / 8;
+
+	// カラーマップは先に RGBA にしておく
+	std::vector<uint8_t> colorMap;
+	if (baseType == kTgaColorMapped)
+	{
+		const uint32_t entrySize = (header.colorMapDepth + 7) / 8;
+		colorMap.resize(static_cast<size_t>(header.colorMapLength) * 4);
+		for (uint32_t i = 0; i < header.colorMapLength; ++i)
+		{
+			ReadTgaColor(data + header.colorMapOffset + i * entrySize, header.colorMapDepth, false, useAlphaBit, colorMap.data() + i * 4);
+		}
+	}
+	const auto convert = [&](const uint8_t* source, uint8_t* target)
+	{
+		if (baseType != kTgaColorMapped)
+		{
+			ReadTgaColor(source, header.depth, isGrayscale, useAlphaBit, target);
+			return true;
+		}
+		const uint32_t index = source[0] - header.colorMapFirst;
+		if (source[0] < header.colorMapFirst || index >= header.colorMapLength)
+		{
+			return false;
+		}
+		memcpy(target, colorMap.data() + index * 4, 4);
+		return true;
+	};
+
+	const bool isTopDown = (header.descriptor & kTgaTopOrigin) != 0;
+	const bool isRightToLeft = (header.descriptor & kTgaRightOrigin) != 0;
+	const auto targetPixel = [&](size_t index)
+	{
+		const uint32_t y = static_cast<uint32_t>(index / header.width);
+		const uint32_t x = static_cast<uint32_t>(index % header.width);
+		return destination + (isTopDown ? y : header.height - 1 - y) * rowPitch + (isRightToLeft ? header.width - 1 - x : x) * 4;
+	};
+
+	const size_t pixelCount = static_cast<size_t>(header.width) * header.height;
+	const uint8_t* p = data + header.pixelOffset;
+	const uint8_t* const end = data + size;
+	if (!isRle)
+	{
+		if (static_cast<size_t>(end - p) < pixelCount * bytesPerPixel)
+		{
+			return Fail(outError, "truncated TGA pixel data");
+		}
+		for (size_t i = 0; i < pixelCount; ++i, p += bytesPerPixel)
+		{
+			if (!convert(p, targetPixel(i)))
+			{
+				return Fail(outError, "TGA color index out of range");
+			}
+		}
+	}
+	else
+	{
+		// パケットは行をまたいでよい
+		size_t index = 0;
+		while (index < pixelCount)
+		{
+			if (p >= end)
+			{
+				return Fail(outError, "truncated TGA RLE data");
+			}
+			const uint8_t packet = *p++;
+			const size_t count = (packet & 0x7F) + 1u;
+			const bool isRun = (packet & 0x80) != 0;
+			if (static_cast<size_t>(end - p) < (isRun ? 1 : count) * bytesPerPixel || index + count > pixelCount)
+			{
+				return Fail(outError, "truncated TGA RLE data");
+			}
+			uint8_t color[4];
+			if (isRun && !convert(p, color))
+			{
+				return Fail(outError, "TGA color index out of range");
+			}
+			for (size_t i = 0; i < count; ++i, ++index)
+			{
+				if (isRun)
+				{
+					memcpy(targetPixel(index), color, 4);
+				}
+				else if (!convert(p + i * bytesPerPixel, targetPixel(index)))
+				{
+					return Fail(outError, "TGA color index out of range");
+				}
+			}
+			p += (isRun ? 1 : count) * bytesPerPixel;
+		}
+	}
+
+	const uint32_t colorDepth = baseType == kTgaColorMapped ? header.colorMapDepth : header.depth;
+	if (colorDepth == 32 && !isGrayscale)
+	{
+		FixZeroAlpha(destination, rowPitch, header.width, header.height);
+	}
+	return true;
+}
+
+///=====================================================================
+/// ImageDecoderRegistry
+///=====================================================================
+ImageDecoderRegistry& ImageDecoderRegistry::Get()
+{
+	static ImageDecoderRegistry instance;
+	return instance;
+}
+
+ImageDecoderRegistry::ImageDecoderRegistry()
+{
+	m_Decoders.push_back(std::make_unique<PngDecoder>());
+	m_Decoders.push_back(std::make_unique<BmpDecoder>());
+	// 識別子が無いので最後に試す
+	m_Decoders.push_back(std::make_unique<TgaDecoder>());
+}
+
+void ImageDecoderRegistry::Register(std::unique_ptr<IImageDecoder> decoder)
+{
+	if (decoder)
+	{
+		// TGA は常に最後に残す
+		m_Decoders.insert(m_Decoders.end() - 1, std::move(decoder));
+	}
+}
+
+const IImageDecoder* ImageDecoderRegistry::Find(const uint8_t* data, size_t size) const
+{
+	for (const std::unique_ptr<IImageDecoder>& decoder : m_Decoders)
+	{
+		if (decoder->CanDecode(data, size))
+		{
+			return decoder.get();
+		}
+	}
+	return nullptr;
+}
+
+ImageDecodeStatus ImageDecoderRegistry::Decode(const uint8_t* data, size_t size, const AllocateFunction& allocate, std::string* outError) const
+{
+	const IImageDecoder* decoder = Find(data, size);
+	if (decoder == nullptr)
+	{
+		Fail(outError, "no decoder for this format");
+		return ImageDecodeStatus::Unsupported;
+	}
+	ImageInfo info;
+	if (!decoder->ReadInfo(data, size, info, outError))
+	{
+		return ImageDecodeStatus::Failed;
+	}
+	size_t rowPitch = static_cast<size_t>(info.width) * 4;
+	uint8_t* destination = allocate(info, rowPitch);
+	if (destination == nullptr || rowPitch < static_cast<size_t>(info.width) * 4)
+	{
+		Fail(outError, "failed to allocate decode destination");
+		return ImageDecodeStatus::Failed;
+	}
+	return decoder->Decode(data, size, destination, rowPitch, outError) ? ImageDecodeStatus::Decoded : ImageDecodeStatus::Failed;
+}
+
+ImageDecodeStatus ImageDecoderRegistry::DecodeFile(const std::filesystem::path& path, const AllocateFunction& allocate, std::string* outError) const
+{
+	MappedFile file;
+	if (!file.Open(path) || file.GetSize() == 0)
+	{
+		Fail(outError, "failed to open file");
+		return ImageDecodeStatus::Failed;
+	}
+	return Decode(file.GetData(), file.GetSize(), allocate, outError);
+}
+
+ImageDecodeStatus ImageDecoderRegistry::DecodeFile(const std::filesystem::path& path, ImageInfo& outInfo, std::vector<uint8_t>& outPixels, std::string* outError) const
+{
+	const auto allocate = [&outInfo, &outPixels](const ImageInfo& info, size_t& outRowPitch) -> uint8_t*
+	{
+		outInfo = info;
+		outRowPitch = static_cast<size_t>(info.width) * 4;
+		outPixels.resize(outRowPitch * info.height);
+		return outPixels.data();
+	};
+	return DecodeFile(path, allocate, outError);
+}
@@ -0,0 +1,124 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+/// ヘッダーから分かる画像の情報
+struct ImageInfo
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	/// 不透明でない画素を含みうるか（アルファチャンネルや透過色がある）
+	bool hasAlpha = false;
+};
+
+///=======================================================================
+/// <summary>
+/// 画像ファイルのデコーダー。出力は常に RGBA8 で、呼び出し側が用意したメモリ
+/// （アップロードバッファや ScratchImage の画素など）へ直接書き込みます。
+/// Windows にも COM にも依存しないので、ツールやベンチマークからも使えます。
+/// </summary>
+///=======================================================================
+class IImageDecoder
+{
+public:
+	/// これより大きな画像は壊れているものとして扱う（D3D12 の 2D テクスチャーの上限）
+	static constexpr uint32_t kMaxDimension = 16384;
+
+	virtual ~IImageDecoder() = default;
+
+	/// ログに出す名前（"png" など）
+	virtual const char* GetName() const = 0;
+	/// 先頭のバイト列がこの形式か
+	virtual bool CanDecode(const uint8_t* data, size_t size) const = 0;
+	virtual bool ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError = nullptr) const = 0;
+
+	///====================================================================
+	/// <summary>
+	/// destination に RGBA8 で書き込みます。
+	/// </summary>
+	/// <param name="destination">ReadInfo の高さ × rowPitch バイトのメモリ</param>
+	/// <param name="rowPitch">行の間隔（width * 4 以上）</param>
+	///====================================================================
+	virtual bool Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError = nullptr) const = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// BMP（Windows / OS/2 のヘッダー、1/4/8 ビットのパレット、16/24/32 ビット、RLE4/RLE8、BITFIELDS）
+/// </summary>
+///=======================================================================
+class BmpDecoder final : public IImageDecoder
+{
+public:
+	const char* GetName() const override { return "bmp"; }
+	bool CanDecode(const uint8_t* data, size_t size) const override;
+	bool ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError = nullptr) const override;
+	bool Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError = nullptr) const override;
+};
+
+///=======================================================================
+/// <summary>
+/// TGA（カラーマップ・トゥルーカラー・グレースケールと、それぞれの RLE。8/15/16/24/32 ビット）。
+/// TGA には識別子が無いのでヘッダーの値の妥当性で判定します。他の形式の後に登録してください。
+/// </summary>
+///=======================================================================
+class TgaDecoder final : public IImageDecoder
+{
+public:
+	const char* GetName() const override { return "tga"; }
+	bool CanDecode(const uint8_t* data, size_t size) const override;
+	bool ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError = nullptr) const override;
+	bool Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError = nullptr) const override;
+};
+
+enum class ImageDecodeStatus
+{
+	Decoded,
+	/// 登録されたデコーダーが扱えない形式（JPEG など。呼び出し側で WIC などに任せる）
+	Unsupported,
+	/// 読めない、または壊れている
+	Failed,
+};
+
+///=======================================================================
+/// <summary>
+/// デコーダーの一覧。先頭のバイト列を見て、最初に CanDecode を返したデコーダーを使います。
+/// 組み込み（PNG / BMP / TGA）は Get の時点で登録済みです。
+/// </summary>
+///=======================================================================
+class ImageDecoderRegistry
+{
+public:
+	///====================================================================
+	/// <summary>
+	/// 画像の大きさが分かった時点で書き込み先を用意させるコールバック。
+	/// outRowPitch を設定してメモリを返します（nullptr なら中止）。
+	/// </summary>
+	///====================================================================
+	using AllocateFunction = std::function<uint8_t*(const ImageInfo& info, size_t& outRowPitch)>;
+
+	static ImageDecoderRegistry& Get();
+
+	ImageDecoderRegistry();
+	ImageDecoderRegistry(const ImageDecoderRegistry&) = delete;
+	ImageDecoderRegistry& operator=(const ImageDecoderRegistry&) = delete;
+
+	/// 組み込みの PNG / BMP の後、識別子の無い TGA の前に試します（起動時に登録してください）。
+	void Register(std::unique_ptr<IImageDecoder> decoder);
+	const IImageDecoder* Find(const uint8_t* data, size_t size) const;
+
+	ImageDecodeStatus Decode(const uint8_t* data, size_t size, const AllocateFunction& allocate, std::string* outError = nullptr) const;
+	/// ファイルをメモリマップしてデコードします。
+	ImageDecodeStatus DecodeFile(const std::filesystem::path& path, const AllocateFunction& allocate, std::string* outError = nullptr) const;
+	/// 行を詰めた RGBA8（rowPitch = width * 4）で outPixels にデコードします。
+	ImageDecodeStatus DecodeFile(const std::filesystem::path& path, ImageInfo& outInfo, std::vector<uint8_t>& outPixels, std::string* outError = nullptr) const;
+
+private:
+	std::vector<std::unique_ptr<IImageDecoder>> m_Decoders;
+};
@@ -0,0 +1,531 @@
+﻿#include "Inflate.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t kMaxCodeLength = 15;
+	constexpr uint32_t kLiteralLengthCodeCount = 288;
+	constexpr uint32_t kDistanceCodeCount = 32;
+	constexpr uint32_t kCodeLengthCodeCount = 19;
+	/// この長さまでの符号は 1 回の表引きで復号する
+	constexpr uint32_t kFastBits = 10;
+	constexpr uint32_t kEndOfBlock = 256;
+
+	constexpr uint16_t kLengthBase[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	constexpr uint8_t kLengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	constexpr uint16_t kDistanceBase[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	constexpr uint8_t kDistanceExtraBits[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	/// 符号長を表す符号の符号長が並ぶ順
+	constexpr uint8_t kCodeLengthOrder[kCodeLengthCodeCount] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	bool Fail(std::string* outError, const char* message)
+	{
+		if (outError != nullptr)
+		{
+			*outError = message;
+		}
+		return false;
+	}
+
+	///=================================================================
+	/// 下位ビットから順に読むビット列。64 ビットにまとめて読み込み、
+	/// 末尾を越えた分は 0 を詰めて、越えて使ったかを後で確かめます。
+	///=================================================================
+	class BitReader
+	{
+	public:
+		BitReader(const uint8_t* data, size_t size) : m_pData(data), m_Size(size) {}
+
+		/// 少なくとも 56 ビットを用意します。
+		void Refill()
+		{
+			if (m_Position + 8 <= m_Size)
+			{
+				// 読み込んだ 8 バイトのうち、まだ数えていない上位のビットも同じ内容なので重ねてよい
+				uint64_t word = 0;
+				memcpy(&word, m_pData + m_Position, sizeof(word));
+				m_Bits |= word << m_Count;
+				m_Position += (63 - m_Count) >> 3;
+				m_Count |= 56;
+				return;
+			}
+			while (m_Count <= 56)
+			{
+				if (m_Position < m_Size)
+				{
+					m_Bits |= static_cast<uint64_t>(m_pData[m_Position]) << m_Count;
+				}
+				++m_Position;
+				m_Count += 8;
+			}
+		}
+
+		uint32_t Peek(uint32_t count) const { return static_cast<uint32_t>(m_Bits & ((uint64_t(1) << count) - 1)); }
+		uint64_t PeekAll() const { return m_Bits; }
+		void Consume(uint32_t count)
+		{
+			m_Bits >>= count;
+			m_Count -= count;
+		}
+		uint32_t Read(uint32_t count)
+		{
+			if (m_Count < count)
+			{
+				Refill();
+			}
+			const uint32_t value = Peek(count);
+			Consume(count);
+			return value;
+		}
+
+		/// 次のバイト境界まで読み飛ばします。
+		void AlignToByte() { Consume(m_Count & 7); }
+
+		/// バイト境界から size バイトを output に写します（格納ブロック用）。
+		bool CopyBytes(uint8_t* output, size_t size)
+		{
+			// ビット列に読み込み済みのバイトから使う
+			while (size > 0 && m_Count >= 8)
+			{
+				*output++ = static_cast<uint8_t>(Read(8));
+				--size;
+			}
+			if (size == 0)
+			{
+				return !IsOverrun();
+			}
+			if (m_Position > m_Size || m_Size - m_Position < size)
+			{
+				return false;
+			}
+			memcpy(output, m_pData + m_Position, size);
+			m_Position += size;
+			m_Bits = 0;
+			m_Count = 0;
+			return true;
+		}
+
+		/// 末尾を越えて詰めた 0 を読んだか
+		bool IsOverrun() const { return m_Position * 8 - m_Count > m_Size * 8; }
+		/// 読み終えたバイト数（途中のバイトも 1 バイトと数える）
+		size_t GetConsumedBytes() const { return (m_Position * 8 - m_Count + 7) / 8; }
+
+	private:
+		const uint8_t* m_pData = nullptr;
+		size_t m_Size = 0;
+		size_t m_Position = 0;
+		uint64_t m_Bits = 0;
+		uint32_t m_Count = 0;
+	};
+
+	///=================================================================
+	/// 正準ハフマン符号の復号表。kFastBits 以下の符号は表引き 1 回、
+	/// それより長い符号は符号長ごとの個数から 1 ビットずつ求めます。
+	///=================================================================
+	class HuffmanTable
+	{
+	public:
+		/// 符号長から表を作ります。符号が多すぎる（過剰に割り当てられた）場合は false
+		bool Build(const uint8_t* lengths, uint32_t count)
+		{
+			memset(m_Counts, 0, sizeof(m_Counts));
+			for (uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				++m_Counts[lengths[symbol]];
+			}
+			m_Counts[0] = 0;
+
+			int left = 1;
+			for (uint32_t length = 1; length <= kMaxCodeLength; ++length)
+			{
+				left = (left << 1) - m_Counts[length];
+				if (left < 0)
+				{
+					return false;
+				}
+			}
+
+			uint16_t offsets[kMaxCodeLength + 2] = {};
+			for (uint32_t length = 1; length <= kMaxCodeLength; ++length)
+			{
+				offsets[length + 1] = static_cast<uint16_t>(offsets[length] + m_Counts[length]);
+			}
+			for (uint32_t symbol = 0; symbol < count; ++symbol)
+			{
+				if (lengths[symbol] != 0)
+				{
+					m_Symbols[offsets[lengths[symbol]]++] = static_cast<uint16_t>(symbol);
+				}
+			}
+
+			// 符号はビット列の上位から詰められているので、下位から読む表では反転して置く
+			memset(m_Fast, 0, sizeof(m_Fast));
+			uint32_t code = 0;
+			uint32_t index = 0;
+			for (uint32_t length = 1; length <= kFastBits; ++length)
+			{
+				for (uint32_t i = 0; i < m_Counts[length]; ++i, ++code, ++index)
+				{
+					uint32_t reversed = 0;
+					for (uint32_t bit = 0; bit < length; ++bit)
+					{
+						reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+					}
+					const uint16_t entry = static_cast<uint16_t>((length << 9) | m_Symbols[index]);
+					for (uint32_t slot = reversed; slot < (1u << kFastBits); slot += 1u << length)
+					{
+						m_Fast[slot] = entry;
+					}
+				}
+				code <<= 1;
+			}
+			return true;
+		}
+
+		/// シンボルを 1 つ復号します（呼び出し前に Refill しておくこと）。使われていない符号なら -1
+		int Decode(BitReader& reader) const
+		{
+			const uint16_t entry = m_Fast[reader.Peek(kFastBits)];
+			if (entry != 0)
+			{
+				reader.Consume(entry >> 9);
+				return entry & 0x1FF;
+			}
+			return DecodeSlow(reader);
+		}
+
+	private:
+		int DecodeSlow(BitReader& reader) const
+		{
+			const uint64_t bits = reader.PeekAll();
+			int code = 0;
+			int first = 0;
+			int index = 0;
+			for (uint32_t length = 1; length <= kMaxCodeLength; ++length)
+			{
+				code |= static_cast<int>((bits >> (length - 1)) & 1);
+				const int count = m_Counts[length];
+				if (code - count < first)
+				{
+					reader.Consume(length);
+					return m_Symbols[index + (code - first)];
+				}
+				index += count;
+				first = (first + count) << 1;
+				code <<= 1;
+			}
+			return -1;
+		}
+
+		/// (符号長 << 9) | シンボル。0 は表に無い（長い）符号
+		uint16_t m_Fast[1u << kFastBits] = {};
+		uint16_t m_Counts[kMaxCodeLength + 1] = {};
+		uint16_t m_Symbols[kLiteralLengthCodeCount] = {};
+	};
+
+	struct FixedTables
+	{
+		HuffmanTable literals;
+		HuffmanTable distances;
+
+		FixedTables()
+		{
+			uint8_t lengths[kLiteralLengthCodeCount];
+			memset(lengths, 8, 144);
+			memset(lengths + 144, 9, 112);
+			memset(lengths + 256, 7, 24);
+			memset(lengths + 280, 8, 8);
+			literals.Build(lengths, kLiteralLengthCodeCount);
+			memset(lengths, 5, kDistanceCodeCount);
+			distances.Build(lengths, kDistanceCodeCount);
+		}
+	};
+
+	bool ReadDynamicTables(BitReader& reader, HuffmanTable& literals, HuffmanTable& distances, std::string* outError)
+	{
+		const uint32_t literalCount = reader.Read(5) + 257;
+		const uint32_t distanceCount = reader.Read(5) + 1;
+		const uint32_t codeLengthCount = reader.Read(4) + 4;
+		if (literalCount > 286 || distanceCount > 30)
+		{
+			return Fail(outError, "too many length or distance codes");
+		}
+
+		uint8_t codeLengthLengths[kCodeLengthCodeCount] = {};
+		for (uint32_t i = 0; i < codeLengthCount; ++i)
+		{
+			codeLengthLengths[kCodeLengthOrder[i]] = static_cast<uint8_t>(reader.Read(3));
+		}
+		HuffmanTable codeLengths;
+		if (!codeLengths.Build(codeLengthLengths, kCodeLengthCodeCount))
+		{
+			return Fail(outError, "invalid code length code");
+		}
+
+		// 長さ符号と距離符号の符号長は続けて並び、繰り返しは両方をまたいでよい
+		uint8_t lengths[286 + 30] = {};
+		uint32_t index = 0;
+		while (index < literalCount + distanceCount)
+		{
+			reader.Refill();
+			const int symbol = codeLengths.Decode(reader);
+			if (symbol < 0)
+			{
+				return Fail(outError, "invalid code length");
+			}
+			if (symbol < 16)
+			{
+				lengths[index++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+
+			uint8_t value = 0;
+			uint32_t repeat = 0;
+			if (symbol == 16)
+			{
+				if (index == 0)
+				{
+					return Fail(outError, "repeat with no previous length");
+				}
+				value = lengths[index - 1];
+				repeat = 3 + reader.Read(2);
+			}
+			else if (symbol == 17)
+			{
+				repeat = 3 + reader.Read(3);
+			}
+			else
+			{
+				repeat = 11 + reader.Read(7);
+			}
+			if (index + repeat > literalCount + distanceCount)
+			{
+				return Fail(outError, "too many code lengths");
+			}
+			memset(lengths + index, value, repeat);
+			index += repeat;
+		}
+		if (lengths[kEndOfBlock] == 0)
+		{
+			return Fail(outError, "missing end-of-block code");
+		}
+		if (!literals.Build(lengths, literalCount) || !distances.Build(lengths + literalCount, distanceCount))
+		{
+			return Fail(outError, "over-subscribed literal or distance code");
+		}
+		return true;
+	}
+
+	/// 圧縮ブロックを 1 つ展開します。
+	bool InflateBlock(BitReader& reader, const HuffmanTable& literals, const HuffmanTable& distances,
+		uint8_t* output, size_t capacity, size_t& position, std::string* outError)
+	{
+		for (;;)
+		{
+			// 長さ（15 + 5）と距離（15 + 13）を合わせても 1 回の読み込みに収まる
+			reader.Refill();
+			const int symbol = literals.Decode(reader);
+			if (symbol < static_cast<int>(kEndOfBlock))
+			{
+				if (symbol < 0)
+				{
+					return Fail(outError, "invalid literal/length code");
+				}
+				if (position >= capacity)
+				{
+					return Fail(outError, "output overflow");
+				}
+				output[position++] = static_cast<uint8_t>(symbol);
+				continue;
+			}
+			if (symbol == static_cast<int>(kEndOfBlock))
+			{
+				return true;
+			}
+
+			const uint32_t lengthCode = static_cast<uint32_t>(symbol) - 257;
+			if (lengthCode >= 29)
+			{
+				return Fail(outError, "invalid length code");
+			}
+			const size_t length = kLengthBase[lengthCode] + reader.Read(kLengthExtraBits[lengthCode]);
+			const int distanceCode = distances.Decode(reader);
+			if (distanceCode < 0 || distanceCode >= 30)
+			{
+				return Fail(outError, "invalid distance code");
+			}
+			const size_t distance = kDistanceBase[distanceCode] + reader.Read(kDistanceExtraBits[distanceCode]);
+			if (distance > position)
+			{
+				return Fail(outError, "distance too far back");
+			}
+			if (length > capacity - position)
+			{
+				return Fail(outError, "output overflow");
+			}
+
+			uint8_t* destination = output + position;
+			const uint8_t* source = destination - distance;
+			position += length;
+			if (distance >= 8 && capacity - position >= 8)
+			{
+				// 8 バイトずつ写す（末尾は最大 7 バイト書き過ぎるが、後の出力で上書きされる）
+				uint8_t* const end = destination + length;
+				do
+				{
+					memcpy(destination, source, 8);
+					destination += 8;
+					source += 8;
+				} while (destination < end);
+			}
+			else if (distance == 1)
+			{
+				memset(destination, *source, length);
+			}
+			else
+			{
+				for (size_t i = 0; i < length; ++i)
+				{
+					destination[i] = source[i];
+				}
+			}
+		}
+	}
+
+	bool InflateStream(BitReader& reader, uint8_t* output, size_t capacity, size_t& outWritten, std::string* outError)
+	{
+		static const FixedTables fixedTables;
+		size_t position = 0;
+		HuffmanTable literals;
+		HuffmanTable distances;
+		bool isFinal = false;
+		while (!isFinal)
+		{
+			isFinal = reader.Read(1) != 0;
+			const uint32_t type = reader.Read(2);
+			if (type == 0)
+			{
+				reader.AlignToByte();
+				const uint32_t length = reader.Read(16);
+				const uint32_t inverted = reader.Read(16);
+				if ((length ^ 0xFFFF) != inverted)
+				{
+					return Fail(outError, "stored block length mismatch");
+				}
+				if (length > capacity - position)
+				{
+					return Fail(outError, "output overflow");
+				}
+				if (!reader.CopyBytes(output + position, length))
+				{
+					return Fail(outError, "truncated stored block");
+				}
+				position += length;
+				continue;
+			}
+
+			bool isDecoded = false;
+			if (type == 1)
+			{
+				isDecoded = InflateBlock(reader, fixedTables.literals, fixedTables.distances, output, capacity, position, outError);
+			}
+			else if (type == 2)
+			{
+				isDecoded = ReadDynamicTables(reader, literals, distances, outError) &&
+					InflateBlock(reader, literals, distances, output, capacity, position, outError);
+			}
+			else
+			{
+				return Fail(outError, "invalid block type");
+			}
+			if (!isDecoded)
+			{
+				return false;
+			}
+			if (reader.IsOverrun())
+			{
+				return Fail(outError, "truncated deflate stream");
+			}
+		}
+		outWritten = position;
+		return true;
+	}
+
+	uint32_t ComputeAdler32(const uint8_t* data, size_t size)
+	{
+		// 5552 バイトまでは剰余を取らなくても 32 ビットに収まる
+		constexpr uint32_t kModulus = 65521;
+		constexpr size_t kBlockSize = 5552;
+		uint32_t a = 1;
+		uint32_t b = 0;
+		while (size > 0)
+		{
+			const size_t blockSize = size < kBlockSize ? size : kBlockSize;
+			for (size_t i = 0; i < blockSize; ++i)
+			{
+				a += data[i];
+				b += a;
+			}
+			a %= kModulus;
+			b %= kModulus;
+			data += blockSize;
+			size -= blockSize;
+		}
+		return (b << 16) | a;
+	}
+}
+
+bool Inflate::DecompressRaw(const uint8_t* data, size_t size, uint8_t* output, size_t outputCapacity, size_t& outWritten,
+	std::string* outError)
+{
+	outWritten = 0;
+	BitReader reader(data, size);
+	return InflateStream(reader, output, outputCapacity, outWritten, outError);
+}
+
+bool Inflate::DecompressZlib(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize, std::string* outError)
+{
+	if (data == nullptr || size < 6)
+	{
+		return Fail(outError, "zlib stream too short");
+	}
+	const uint32_t method = data[0] & 0x0F;
+	const uint32_t windowBits = (data[0] >> 4) + 8;
+	if (method != 8 || windowBits > 15 || ((static_cast<uint32_t>(data[0]) << 8) | data[1]) % 31 != 0)
+	{
+		return Fail(outError, "invalid zlib header");
+	}
+	if ((data[1] & 0x20) != 0)
+	{
+		return Fail(outError, "zlib preset dictionaries are not supported");
+	}
+
+	BitReader reader(data + 2, size - 2);
+	size_t written = 0;
+	if (!InflateStream(reader, output, outputSize, written, outError))
+	{
+		return false;
+	}
+	if (written != outputSize)
+	{
+		return Fail(outError, "decompressed size mismatch");
+	}
+
+	const size_t trailer = 2 + reader.GetConsumedBytes();
+	if (trailer + 4 > size)
+	{
+		return Fail(outError, "missing Adler-32 checksum");
+	}
+	const uint32_t expected = (static_cast<uint32_t>(data[trailer]) << 24) | (static_cast<uint32_t>(data[trailer + 1]) << 16) |
+		(static_cast<uint32_t>(data[trailer + 2]) << 8) | data[trailer + 3];
+	if (ComputeAdler32(output, outputSize) != expected)
+	{
+		return Fail(outError, "Adler-32 checksum mismatch");
+	}
+	return true;
+}
@@ -0,0 +1,34 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+///=======================================================================
+/// <summary>
+/// Deflate（RFC 1951）の展開。PNG の IDAT のように出力の大きさが先に分かるデータ向けで、
+/// 呼び出し側が用意したバッファに直接書き込みます（途中のバッファや再確保はありません）。
+/// ハフマン符号は短いものを 1 回の表引きで、長いもの（まれ）だけを 1 ビットずつ復号します。
+/// </summary>
+///=======================================================================
+namespace Inflate
+{
+	///====================================================================
+	/// <summary>
+	/// ヘッダーなしの Deflate データを展開します。
+	/// </summary>
+	/// <param name="output">展開先（outputCapacity バイト）</param>
+	/// <param name="outWritten">書き込んだバイト数</param>
+	/// <returns>データが壊れている、または出力に収まらない場合は false</returns>
+	///====================================================================
+	bool DecompressRaw(const uint8_t* data, size_t size, uint8_t* output, size_t outputCapacity, size_t& outWritten,
+		std::string* outError = nullptr);
+
+	///====================================================================
+	/// <summary>
+	/// zlib 形式（RFC 1950）のデータを展開し、末尾の Adler-32 を確かめます。
+	/// </summary>
+	/// <returns>壊れている場合や、展開した大きさがちょうど outputSize でない場合は false</returns>
+	///====================================================================
+	bool DecompressZlib(const uint8_t* data, size_t size, uint8_t* output, size_t outputSize, std::string* outError = nullptr);
+}
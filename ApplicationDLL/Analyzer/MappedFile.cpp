@@ -0,0 +1,176 @@
+﻿#include "MappedFile.h"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+	Close();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept
+{
+	MoveFrom(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if (this != &other)
+	{
+		Close();
+		MoveFrom(other);
+	}
+	return *this;
+}
+
+void MappedFile::MoveFrom(MappedFile& other) noexcept
+{
+	m_pData = other.m_pData;
+	m_Size = other.m_Size;
+	m_IsOpen = other.m_IsOpen;
+	other.m_pData = nullptr;
+	other.m_Size = 0;
+	other.m_IsOpen = false;
+#ifdef _WIN32
+	m_FileHandle = other.m_FileHandle;
+	m_MappingHandle = other.m_MappingHandle;
+	other.m_FileHandle = nullptr;
+	other.m_MappingHandle = nullptr;
+#endif
+}
+
+///====================================================================
+/// <summary>
+/// ファイルを読み取り専用でマップします。
+/// サイズ 0 のファイルはマップせずに開いた状態として扱います。
+/// </summary>
+/// <param name="filePath">マップするファイルのパス</param>
+/// <returns>成功した場合は true</returns>
+///====================================================================
+bool MappedFile::Open(const std::filesystem::path& filePath)
+{
+	Close();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileW(
+		filePath.c_str(),
+		GENERIC_READ,
+		FILE_SHARE_READ,
+		nullptr,
+		OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+		nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER fileSize = {};
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < 0)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	m_FileHandle = file;
+	m_Size = static_cast<size_t>(fileSize.QuadPart);
+	m_IsOpen = true;
+	if (m_Size == 0)
+	{
+		return true;
+	}
+
+	HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_MappingHandle = mapping;
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		Close();
+		return false;
+	}
+	m_pData = static_cast<const uint8_t*>(view);
+#else
+	const int fd = ::open(filePath.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat fileStat = {};
+	if (::fstat(fd, &fileStat) != 0 || fileStat.st_size < 0)
+	{
+		::close(fd);
+		return false;
+	}
+
+	m_Size = static_cast<size_t>(fileStat.st_size);
+	m_IsOpen = true;
+	if (m_Size == 0)
+	{
+		::close(fd);
+		return true;
+	}
+
+	void* view = ::mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// マップ後はファイルディスクリプタを閉じてもマッピングは維持されます。
+	::close(fd);
+	if (view == MAP_FAILED)
+	{
+		m_Size = 0;
+		m_IsOpen = false;
+		return false;
+	}
+	m_pData = static_cast<const uint8_t*>(view);
+#endif
+
+	return true;
+}
+
+///====================================================================
+/// <summary>
+/// マッピングを解除してファイルを閉じます。
+/// </summary>
+///====================================================================
+void MappedFile::Close()
+{
+#ifdef _WIN32
+	if (m_pData != nullptr)
+	{
+		UnmapViewOfFile(m_pData);
+	}
+	if (m_MappingHandle != nullptr)
+	{
+		CloseHandle(static_cast<HANDLE>(m_MappingHandle));
+		m_MappingHandle = nullptr;
+	}
+	if (m_FileHandle != nullptr)
+	{
+		CloseHandle(static_cast<HANDLE>(m_FileHandle));
+		m_FileHandle = nullptr;
+	}
+#else
+	if (m_pData != nullptr)
+	{
+		::munmap(const_cast<uint8_t*>(m_pData), m_Size);
+	}
+#endif
+
+	m_pData = nullptr;
+	m_Size = 0;
+	m_IsOpen = false;
+}
@@ -0,0 +1,45 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+
+///=======================================================================
+/// <summary>
+/// 読み取り専用でファイルをメモリマップする RAII クラス。
+/// Windows ではファイルマッピング、それ以外では mmap を使用します。
+/// マップしたバイト列はクローズするまで有効です。
+/// </summary>
+///=======================================================================
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	// コピー禁止
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	bool Open(const std::filesystem::path& filePath);
+	void Close();
+
+	bool IsOpen() const { return m_IsOpen; }
+	const uint8_t* GetData() const { return m_pData; }
+	size_t GetSize() const { return m_Size; }
+
+private:
+	void MoveFrom(MappedFile& other) noexcept;
+
+	const uint8_t* m_pData = nullptr;
+	size_t m_Size = 0;
+	bool m_IsOpen = false;
+
+#ifdef _WIN32
+	void* m_FileHandle = nullptr;
+	void* m_MappingHandle = nullptr;
+#endif
+};
@@ -0,0 +1,292 @@
+﻿#include "MeshCooker.h"
+#include "PMDModelData.h"
+#include "PMDMappedReader.h"
+#include "../System/ContentHash.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <system_error>
+
+namespace
+{
+	size_t AlignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	float SignNotZero(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	int16_t ToSnorm16(float value)
+	{
+		const float clamped = std::min(std::max(value, -1.0f), 1.0f);
+		return static_cast<int16_t>(std::lround(clamped * 32767.0f));
+	}
+
+	bool SetError(std::string* outError, const char* message)
+	{
+		if (outError != nullptr)
+		{
+			*outError = message;
+		}
+		return false;
+	}
+}
+
+namespace MeshCooker
+{
+	void EncodeOctahedralNormal(float x, float y, float z, int16_t outEncoded[2])
+	{
+		const float length = std::sqrt(x * x + y * y + z * z);
+		if (length <= 0.0f)
+		{
+			// 不正な法線は +Z として扱う
+			outEncoded[0] = 0;
+			outEncoded[1] = 0;
+			return;
+		}
+		x /= length;
+		y /= length;
+		z /= length;
+
+		const float invL1 = 1.0f / (std::fabs(x) + std::fabs(y) + std::fabs(z));
+		float u = x * invL1;
+		float v = y * invL1;
+		if (z < 0.0f)
+		{
+			const float foldedU = (1.0f - std::fabs(v)) * SignNotZero(u);
+			const float foldedV = (1.0f - std::fabs(u)) * SignNotZero(v);
+			u = foldedU;
+			v = foldedV;
+		}
+		outEncoded[0] = ToSnorm16(u);
+		outEncoded[1] = ToSnorm16(v);
+	}
+
+	void DecodeOctahedralNormal(const int16_t encoded[2], float outNormal[3])
+	{
+		const float u = std::max(encoded[0] / 32767.0f, -1.0f);
+		const float v = std::max(encoded[1] / 32767.0f, -1.0f);
+		float x = u;
+		float y = v;
+		const float z = 1.0f - std::fabs(u) - std::fabs(v);
+		if (z < 0.0f)
+		{
+			x = (1.0f - std::fabs(v)) * SignNotZero(u);
+			y = (1.0f - std::fabs(u)) * SignNotZero(v);
+		}
+		const float length = std::sqrt(x * x + y * y + z * z);
+		outNormal[0] = x / length;
+		outNormal[1] = y / length;
+		outNormal[2] = z / length;
+	}
+
+	uint16_t FloatToHalf(float value)
+	{
+		uint32_t bits = 0;
+		std::memcpy(&bits, &value, sizeof(bits));
+
+		const uint32_t sign = (bits >> 16) & 0x8000u;
+		const uint32_t exponent = (bits >> 23) & 0xFFu;
+		uint32_t mantissa = bits & 0x7FFFFFu;
+
+		if (exponent == 0xFFu)
+		{
+			// Inf / NaN
+			return static_cast<uint16_t>(sign | 0x7C00u | (mantissa != 0 ? 0x200u : 0u));
+		}
+
+		const int32_t halfExponent = static_cast<int32_t>(exponent) - 127 + 15;
+		if (halfExponent >= 0x1F)
+		{
+			return static_cast<uint16_t>(sign | 0x7C00u);
+		}
+		if (halfExponent <= 0)
+		{
+			// 非正規化数または 0
+			if (halfExponent < -10)
+			{
+				return static_cast<uint16_t>(sign);
+			}
+			mantissa |= 0x800000u;
+			const uint32_t shift = static_cast<uint32_t>(14 - halfExponent);
+			uint32_t halfMantissa = mantissa >> shift;
+			const uint32_t remainder = mantissa & ((1u << shift) - 1u);
+			const uint32_t halfway = 1u << (shift - 1);
+			if (remainder > halfway || (remainder == halfway && (halfMantissa & 1u) != 0))
+			{
+				++halfMantissa;
+			}
+			return static_cast<uint16_t>(sign | halfMantissa);
+		}
+
+		uint32_t half = sign | (static_cast<uint32_t>(halfExponent) << 10) | (mantissa >> 13);
+		const uint32_t remainder = mantissa & 0x1FFFu;
+		if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1u) != 0))
+		{
+			// 繰り上がりで指数部に溢れても正しく Inf になる
+			++half;
+		}
+		return static_cast<uint16_t>(half);
+	}
+
+	bool Cook(const PMDMappedReader& reader, std::vector<uint8_t>& outBlob, std::string* outError, CookStatistics* outStats)
+	{
+		outBlob.clear();
+		if (!reader.IsValid())
+		{
+			return SetError(outError, "reader is not open");
+		}
+
+		PMDModelData modelData;
+		if (!BuildPMDModelData(reader, modelData))
+		{
+			return SetError(outError, "material index ranges exceed index count");
+		}
+
+		const auto sourceVertices = reader.GetVertices();
+		const size_t vertexCount = sourceVertices.Size();
+		const size_t indexCount = modelData.indices.size();
+		const size_t subsetCount = modelData.materials.Size();
+		if (vertexCount > std::numeric_limits<uint32_t>::max() || indexCount % 3 != 0)
+		{
+			return SetError(outError, "unsupported vertex or index count");
+		}
+
+		// レイアウトを決定する
+		const size_t subsetOffset = AlignUp(sizeof(CookedMesh::CookedMeshHeader), CookedMesh::kSectionAlignment);
+		const size_t vertexOffset = AlignUp(subsetOffset + subsetCount * sizeof(CookedMesh::CookedSubset), CookedMesh::kSectionAlignment);
+		const size_t indexOffset = AlignUp(vertexOffset + vertexCount * sizeof(CookedMesh::CookedVertex), CookedMesh::kSectionAlignment);
+		const size_t fileSize = AlignUp(indexOffset + indexCount * sizeof(uint16_t), CookedMesh::kSectionAlignment);
+		outBlob.assign(fileSize, 0);
+
+		// マテリアルごとの範囲を保ったまま三角形を並べ替える
+		std::vector<uint16_t> indices = modelData.indices;
+		const float* positions = vertexCount > 0 ? &sourceVertices[0].pos.x : nullptr;
+		const MeshOptimizer::VertexCacheStatistics statsBefore = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+		auto* subsets = reinterpret_cast<CookedMesh::CookedSubset*>(outBlob.data() + subsetOffset);
+		for (size_t i = 0; i < subsetCount; ++i)
+		{
+			const uint32_t offset = modelData.materials.indexOffset[i];
+			const uint32_t count = modelData.materials.indexCount[i];
+			if (count % 3 != 0 ||
+				!MeshOptimizer::OptimizeTriangleOrder(indices.data() + offset, count, positions, vertexCount, sizeof(PMD::VertexRecord)))
+			{
+				outBlob.clear();
+				return SetError(outError, "invalid material index range");
+			}
+			subsets[i].indexOffset = offset;
+			subsets[i].indexCount = count;
+			subsets[i].materialIndex = static_cast<uint32_t>(i);
+		}
+
+		// 頂点を参照順に並べ直す
+		std::vector<uint32_t> remap;
+		if (!MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), vertexCount, remap))
+		{
+			outBlob.clear();
+			return SetError(outError, "index out of range");
+		}
+		if (!indices.empty())
+		{
+			std::memcpy(outBlob.data() + indexOffset, indices.data(), indices.size() * sizeof(uint16_t));
+		}
+
+		if (outStats != nullptr)
+		{
+			std::vector<MeshOptimizer::Meshlet> meshlets;
+			std::vector<uint32_t> meshletVertices;
+			std::vector<uint8_t> meshletTriangles;
+			MeshOptimizer::BuildMeshlets(indices.data(), indices.size(), vertexCount, kMeshletMaxVertices, kMeshletMaxTriangles,
+				meshlets, meshletVertices, meshletTriangles);
+			outStats->before = statsBefore;
+			outStats->after = MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), vertexCount);
+			outStats->meshletCount = meshlets.size();
+		}
+
+		// 頂点の量子化
+		auto* vertices = reinterpret_cast<CookedMesh::CookedVertex*>(outBlob.data() + vertexOffset);
+		float boundsMin[3] = { 0.0f, 0.0f, 0.0f };
+		float boundsMax[3] = { 0.0f, 0.0f, 0.0f };
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			const PMD::VertexRecord& src = sourceVertices[i];
+			CookedMesh::CookedVertex& dst = vertices[remap[i]];
+			dst.position[0] = src.pos.x;
+			dst.position[1] = src.pos.y;
+			dst.position[2] = src.pos.z;
+			EncodeOctahedralNormal(src.normal.x, src.normal.y, src.normal.z, dst.normal);
+			dst.uv[0] = FloatToHalf(src.uv.x);
+			dst.uv[1] = FloatToHalf(src.uv.y);
+			dst.boneIndex[0] = src.boneIndex[0];
+			dst.boneIndex[1] = src.boneIndex[1];
+			const uint32_t weight = std::min<uint32_t>(src.boneWeight, 100u);
+			dst.boneWeight = static_cast<uint8_t>((weight * 255u + 50u) / 100u);
+			dst.edgeFlag = src.edgeFlag != 0 ? 255 : 0;
+
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				if (i == 0 || dst.position[axis] < boundsMin[axis])
+				{
+					boundsMin[axis] = dst.position[axis];
+				}
+				if (i == 0 || dst.position[axis] > boundsMax[axis])
+				{
+					boundsMax[axis] = dst.position[axis];
+				}
+			}
+		}
+
+		auto* header = reinterpret_cast<CookedMesh::CookedMeshHeader*>(outBlob.data());
+		header->magic = CookedMesh::kMagic;
+		header->version = CookedMesh::kVersion;
+		header->headerSize = sizeof(CookedMesh::CookedMeshHeader);
+		header->vertexStride = sizeof(CookedMesh::CookedVertex);
+		header->sourceHash = ContentHash::Compute(reader.GetFileData(), reader.GetFileSize());
+		header->fileSize = fileSize;
+		header->subsetCount = static_cast<uint32_t>(subsetCount);
+		header->vertexCount = static_cast<uint32_t>(vertexCount);
+		header->indexCount = static_cast<uint32_t>(indexCount);
+		header->subsetOffset = subsetOffset;
+		header->vertexOffset = vertexOffset;
+		header->indexOffset = indexOffset;
+		std::memcpy(header->boundsMin, boundsMin, sizeof(boundsMin));
+		std::memcpy(header->boundsMax, boundsMax, sizeof(boundsMax));
+		header->payloadHash = ContentHash::Compute(outBlob.data() + sizeof(CookedMesh::CookedMeshHeader),
+			fileSize - sizeof(CookedMesh::CookedMeshHeader));
+		return true;
+	}
+
+	bool WriteFile(const std::filesystem::path& filePath, const std::vector<uint8_t>& blob)
+	{
+		// 書き込み途中のファイルを読ませないよう、一時ファイルに書いてから置き換える
+		std::filesystem::path tempPath = filePath;
+		tempPath += L".tmp";
+		{
+			std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+			if (!stream)
+			{
+				return false;
+			}
+			stream.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+			if (!stream)
+			{
+				return false;
+			}
+		}
+
+		std::error_code ec;
+		std::filesystem::rename(tempPath, filePath, ec);
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			return false;
+		}
+		return true;
+	}
+}
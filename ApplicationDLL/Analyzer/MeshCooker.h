@@ -0,0 +1,58 @@
+﻿#pragma once
+
+#include "CookedMeshFormat.h"
+#include "MeshOptimizer.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class PMDMappedReader;
+
+///=======================================================================
+/// <summary>
+/// PMD からクック済みメッシュ（.pmdc）を生成します。
+/// マテリアルごとに三角形を頂点キャッシュとオーバードロー向けに並べ替え、
+/// 頂点を参照順に並べ直して量子化したうえで、そのままマップして使える
+/// バイナリにまとめます。
+/// </summary>
+///=======================================================================
+namespace MeshCooker
+{
+	/// クック済みメッシュの既定の拡張子
+	constexpr const wchar_t* kCookedExtension = L".pmdc";
+	/// 統計用のメッシュレット分割サイズ（一般的なメッシュシェーダーの上限）
+	constexpr size_t kMeshletMaxVertices = 64;
+	constexpr size_t kMeshletMaxTriangles = 124;
+
+	/// 最適化前後の頂点キャッシュ統計
+	struct CookStatistics
+	{
+		MeshOptimizer::VertexCacheStatistics before;
+		MeshOptimizer::VertexCacheStatistics after;
+		size_t meshletCount = 0;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// 検証済みの PMD からクック済みメッシュのバイト列を生成します。
+	/// </summary>
+	/// <param name="reader">Open に成功した PMDMappedReader</param>
+	/// <param name="outBlob">出力先</param>
+	/// <param name="outError">失敗時の理由（任意）</param>
+	/// <param name="outStats">最適化前後の統計（任意）</param>
+	/// <returns>成功した場合は true</returns>
+	///====================================================================
+	bool Cook(const PMDMappedReader& reader, std::vector<uint8_t>& outBlob, std::string* outError = nullptr, CookStatistics* outStats = nullptr);
+
+	/// バイト列を一時ファイル経由でファイルに書き出します。
+	bool WriteFile(const std::filesystem::path& filePath, const std::vector<uint8_t>& blob);
+
+	/// 単位ベクトルを八面体エンコードした snorm16 x2 に変換します。
+	void EncodeOctahedralNormal(float x, float y, float z, int16_t outEncoded[2]);
+	/// 八面体エンコードを単位ベクトルに戻します（検証用。描画時は MeshShaderHeader.hlsli の同名の関数が同じ手順で戻します）。
+	void DecodeOctahedralNormal(const int16_t encoded[2], float outNormal[3]);
+	/// float を IEEE 754 binary16 に丸めます（最近接偶数丸め）。
+	uint16_t FloatToHalf(float value);
+}
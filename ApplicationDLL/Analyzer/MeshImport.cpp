@@ -0,0 +1,134 @@
+﻿#include "MeshImport.h"
+#include "CookedMeshFile.h"
+#include "PMDMappedReader.h"
+
+#include <cctype>
+#include <cstring>
+
+namespace
+{
+	bool SetError(std::string* outError, const std::string& message)
+	{
+		if (outError != nullptr)
+		{
+			*outError = message;
+		}
+		return false;
+	}
+
+	bool ImportPMD(const std::filesystem::path& filePath, MeshImport::MeshData& outData, std::string* outError)
+	{
+		PMDMappedReader reader;
+		if (!reader.Open(filePath))
+		{
+			return SetError(outError, reader.GetLastError());
+		}
+
+		const auto sourceVertices = reader.GetVertices();
+		const auto sourceIndices = reader.GetIndices();
+		const auto materials = reader.GetMaterials();
+		if (sourceVertices.Empty() || sourceIndices.Empty())
+		{
+			return SetError(outError, "mesh has no triangles");
+		}
+
+		// ディスク上の 38 バイトを PMDVertex の間隔に詰め直す
+		const size_t vertexCount = sourceVertices.Size();
+		outData.vertexFormat = MeshImport::VertexFormat::PMD;
+		outData.vertexStride = MeshImport::kPMDVertexStride;
+		outData.vertexCount = static_cast<uint32_t>(vertexCount);
+		outData.vertices.assign(vertexCount * MeshImport::kPMDVertexStride, 0);
+		const uint8_t* src = sourceVertices.RawData();
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			std::memcpy(outData.vertices.data() + i * MeshImport::kPMDVertexStride, src + i * sizeof(PMD::VertexRecord), sizeof(PMD::VertexRecord));
+		}
+
+		outData.indices.resize(sourceIndices.Size());
+		std::memcpy(outData.indices.data(), sourceIndices.RawData(), sourceIndices.SizeInBytes());
+		for (uint16_t index : outData.indices)
+		{
+			if (index >= vertexCount)
+			{
+				return SetError(outError, "index out of range");
+			}
+		}
+
+		// マテリアルごとの範囲を保ったまま三角形を並べ替える
+		const float* positions = reinterpret_cast<const float*>(outData.vertices.data());
+		outData.statsBefore = MeshOptimizer::AnalyzeVertexCache(outData.indices.data(), outData.indices.size(), vertexCount);
+		outData.subsets.resize(materials.Size());
+		uint64_t indexOffset = 0;
+		for (size_t i = 0; i < materials.Size(); ++i)
+		{
+			const uint32_t indexCount = materials[i].indexCount;
+			if (indexOffset + indexCount > outData.indices.size())
+			{
+				return SetError(outError, "material index ranges exceed index count");
+			}
+			MeshOptimizer::OptimizeTriangleOrder(outData.indices.data() + indexOffset, indexCount,
+				positions, vertexCount, MeshImport::kPMDVertexStride);
+			outData.subsets[i].indexOffset = static_cast<uint32_t>(indexOffset);
+			outData.subsets[i].indexCount = indexCount;
+			indexOffset += indexCount;
+		}
+		outData.statsAfter = MeshOptimizer::AnalyzeVertexCache(outData.indices.data(), outData.indices.size(), vertexCount);
+		return true;
+	}
+
+	bool ImportCookedMesh(const std::filesystem::path& filePath, MeshImport::MeshData& outData, std::string* outError)
+	{
+		CookedMeshFile cooked;
+		if (!cooked.Open(filePath))
+		{
+			return SetError(outError, cooked.GetLastError());
+		}
+		if (cooked.GetVertexCount() == 0 || cooked.GetIndexCount() == 0)
+		{
+			return SetError(outError, "mesh has no triangles");
+		}
+
+		// マップはこの関数を抜けると解除されるため、転送まで保持する分だけコピーする
+		const size_t vertexBytes = sizeof(CookedMesh::CookedVertex) * cooked.GetVertexCount();
+		outData.vertexFormat = MeshImport::VertexFormat::Cooked;
+		outData.vertexStride = sizeof(CookedMesh::CookedVertex);
+		outData.vertexCount = cooked.GetVertexCount();
+		outData.vertices.resize(vertexBytes);
+		std::memcpy(outData.vertices.data(), cooked.GetVertices(), vertexBytes);
+		outData.indices.assign(cooked.GetIndices(), cooked.GetIndices() + cooked.GetIndexCount());
+
+		outData.subsets.resize(cooked.GetSubsetCount());
+		for (uint32_t i = 0; i < cooked.GetSubsetCount(); ++i)
+		{
+			outData.subsets[i].indexOffset = cooked.GetSubsets()[i].indexOffset;
+			outData.subsets[i].indexCount = cooked.GetSubsets()[i].indexCount;
+		}
+		return true;
+	}
+}
+
+namespace MeshImport
+{
+	bool Import(const std::filesystem::path& filePath, MeshData& outData, std::string* outError)
+	{
+		outData = MeshData();
+		const bool succeeded = IsCookedMeshPath(filePath)
+			? ImportCookedMesh(filePath, outData, outError)
+			: ImportPMD(filePath, outData, outError);
+		if (!succeeded)
+		{
+			outData = MeshData();
+		}
+		return succeeded;
+	}
+
+	bool IsCookedMeshPath(const std::filesystem::path& filePath)
+	{
+		std::string extension = filePath.extension().string();
+		for (char& c : extension)
+		{
+			c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+		}
+		return extension == ".pmdc";
+	}
+}
@@ -0,0 +1,66 @@
+﻿#pragma once
+
+#include "MeshOptimizer.h"
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// メッシュ読み込みのうち GPU を使わない段階（解析・最適化・パック）。
+/// D3D12 に依存しないため、ワーカースレッドから並列に呼び出せます。
+/// 結果の MeshData を MeshObject に渡すと GPU バッファが作成されます。
+/// </summary>
+///=======================================================================
+namespace MeshImport
+{
+	/// 頂点バッファの形式（入力レイアウトの選択に使用）
+	enum class VertexFormat : uint32_t
+	{
+		PMD,	// PMDVertex（40 バイト）
+		Cooked,	// CookedMesh::CookedVertex（28 バイト）
+	};
+
+	/// PMDVertex の間隔。ディスク上の 38 バイトに 4 バイト境界までのパディングを加えたもの
+	constexpr uint32_t kPMDVertexStride = 40;
+
+	/// マテリアル 1 つ分の描画範囲
+	struct Subset
+	{
+		uint32_t indexOffset = 0;
+		uint32_t indexCount = 0;
+	};
+
+	/// GPU へ転送する直前のメッシュ
+	struct MeshData
+	{
+		VertexFormat vertexFormat = VertexFormat::PMD;
+		uint32_t vertexStride = 0;
+		uint32_t vertexCount = 0;
+		std::vector<uint8_t> vertices;
+		std::vector<uint16_t> indices;
+		std::vector<Subset> subsets;
+
+		/// 三角形の並べ替え前後の統計（.pmdc はクック時に並べ替え済みのため 0）
+		MeshOptimizer::VertexCacheStatistics statsBefore;
+		MeshOptimizer::VertexCacheStatistics statsAfter;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// PMD またはクック済みメッシュ（.pmdc）を読み込み、転送用のデータを作成します。
+	/// PMD の場合はマテリアルごとに三角形を並べ替えます。
+	/// 頂点順は表情モーフの頂点番号と対応するため変更しません。
+	/// </summary>
+	/// <param name="filePath">読み込むファイル</param>
+	/// <param name="outData">出力先</param>
+	/// <param name="outError">失敗時の理由（任意）</param>
+	/// <returns>成功した場合は true</returns>
+	///====================================================================
+	bool Import(const std::filesystem::path& filePath, MeshData& outData, std::string* outError = nullptr);
+
+	/// 拡張子が .pmdc（大文字小文字を区別しない）かどうか
+	bool IsCookedMeshPath(const std::filesystem::path& filePath);
+}
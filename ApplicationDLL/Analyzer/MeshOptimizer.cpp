@@ -0,0 +1,657 @@
+﻿#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// Tom Forsyth, "Linear-Speed Vertex Cache Optimisation" の定数
+	constexpr float kCacheDecayPower = 1.5f;
+	constexpr float kLastTriangleScore = 0.75f;
+	constexpr float kValenceBoostScale = 2.0f;
+	constexpr float kValenceBoostPower = 0.5f;
+	constexpr uint32_t kMaxValence = 64;
+	constexpr int32_t kNotInCache = -1;
+
+	struct ScoreTable
+	{
+		float cache[MeshOptimizer::kVertexCacheSize + 3] = {};
+		float valence[kMaxValence + 1] = {};
+
+		ScoreTable()
+		{
+			for (size_t i = 0; i < MeshOptimizer::kVertexCacheSize + 3; ++i)
+			{
+				if (i < 3)
+				{
+					// 直前の三角形の頂点は並べ方に関わらず同じスコア
+					cache[i] = kLastTriangleScore;
+				}
+				else if (i < MeshOptimizer::kVertexCacheSize)
+				{
+					const float scaler = 1.0f / static_cast<float>(MeshOptimizer::kVertexCacheSize - 3);
+					cache[i] = std::pow(1.0f - static_cast<float>(i - 3) * scaler, kCacheDecayPower);
+				}
+			}
+			for (uint32_t i = 1; i <= kMaxValence; ++i)
+			{
+				valence[i] = kValenceBoostScale * std::pow(static_cast<float>(i), -kValenceBoostPower);
+			}
+		}
+	};
+
+	const ScoreTable& GetScoreTable()
+	{
+		static const ScoreTable table;
+		return table;
+	}
+
+	float VertexScore(int32_t cachePosition, uint32_t remainingValence)
+	{
+		if (remainingValence == 0)
+		{
+			// もう使われない頂点
+			return -1.0f;
+		}
+		const ScoreTable& table = GetScoreTable();
+		float score = cachePosition >= 0 ? table.cache[cachePosition] : 0.0f;
+		score += table.valence[remainingValence < kMaxValence ? remainingValence : kMaxValence];
+		return score;
+	}
+
+	template <typename TIndex>
+	bool OptimizeVertexCacheImpl(TIndex* indices, size_t indexCount, size_t vertexCount)
+	{
+		if (indices == nullptr || indexCount % 3 != 0)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			if (indices[i] >= vertexCount)
+			{
+				return false;
+			}
+		}
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+		{
+			return true;
+		}
+
+		// 頂点ごとの隣接三角形リスト（CSR 形式）
+		std::vector<uint32_t> valence(vertexCount, 0);
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			++valence[indices[i]];
+		}
+		std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+		}
+		std::vector<uint32_t> adjacency(indexCount);
+		{
+			std::vector<uint32_t> cursor(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+			for (size_t t = 0; t < triangleCount; ++t)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					adjacency[cursor[indices[t * 3 + k]]++] = static_cast<uint32_t>(t);
+				}
+			}
+		}
+
+		// remaining[v] は未出力の隣接三角形数。adjacency の先頭 remaining 個が未出力
+		std::vector<uint32_t> remaining = valence;
+		std::vector<float> vertexScore(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			vertexScore[v] = VertexScore(kNotInCache, remaining[v]);
+		}
+
+		std::vector<float> triangleScore(triangleCount);
+		std::vector<uint8_t> emitted(triangleCount, 0);
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+		}
+
+		std::vector<TIndex> output;
+		output.reserve(indexCount);
+
+		uint32_t cache[MeshOptimizer::kVertexCacheSize + 3];
+		size_t cacheCount = 0;
+		size_t scanCursor = 0;
+		int64_t bestTriangle = -1;
+
+		for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+		{
+			if (bestTriangle < 0)
+			{
+				// キャッシュ内に候補が無い場合は未出力の三角形から最良のものを探す
+				float bestScore = -1.0f;
+				for (size_t t = scanCursor; t < triangleCount; ++t)
+				{
+					if (!emitted[t] && triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						bestTriangle = static_cast<int64_t>(t);
+					}
+				}
+				while (scanCursor < triangleCount && emitted[scanCursor])
+				{
+					++scanCursor;
+				}
+			}
+
+			const size_t triangle = static_cast<size_t>(bestTriangle);
+			emitted[triangle] = 1;
+
+			// 三角形を出力して、隣接リストから取り除く
+			uint32_t triangleVertices[3];
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const uint32_t v = indices[triangle * 3 + k];
+				triangleVertices[k] = v;
+				output.push_back(static_cast<TIndex>(v));
+
+				uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+				uint32_t* end = begin + remaining[v];
+				for (uint32_t* it = begin; it != end; ++it)
+				{
+					if (*it == triangle)
+					{
+						*it = *(end - 1);
+						break;
+					}
+				}
+				--remaining[v];
+			}
+
+			// LRU キャッシュを更新（出力した 3 頂点を先頭へ）
+			uint32_t newCache[MeshOptimizer::kVertexCacheSize + 3];
+			size_t newCount = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				// 縮退三角形では同じ頂点を重複して積まない
+				if (k == 0 || (triangleVertices[k] != triangleVertices[0] && (k == 1 || triangleVertices[k] != triangleVertices[1])))
+				{
+					newCache[newCount++] = triangleVertices[k];
+				}
+			}
+			for (size_t i = 0; i < cacheCount; ++i)
+			{
+				const uint32_t v = cache[i];
+				if (v != triangleVertices[0] && v != triangleVertices[1] && v != triangleVertices[2])
+				{
+					newCache[newCount++] = v;
+				}
+			}
+			for (size_t i = 0; i < newCount; ++i)
+			{
+				cache[i] = newCache[i];
+			}
+			cacheCount = newCount;
+
+			// キャッシュ内の頂点スコアを更新し、その隣接三角形から次の候補を選ぶ
+			for (size_t i = 0; i < cacheCount; ++i)
+			{
+				const uint32_t v = cache[i];
+				const int32_t position = i < MeshOptimizer::kVertexCacheSize ? static_cast<int32_t>(i) : kNotInCache;
+				const float newScore = VertexScore(position, remaining[v]);
+				const float delta = newScore - vertexScore[v];
+				vertexScore[v] = newScore;
+
+				const uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+				for (uint32_t j = 0; j < remaining[v]; ++j)
+				{
+					triangleScore[begin[j]] += delta;
+				}
+			}
+			// キャッシュからあふれた頂点
+			if (cacheCount > MeshOptimizer::kVertexCacheSize)
+			{
+				cacheCount = MeshOptimizer::kVertexCacheSize;
+			}
+
+			bestTriangle = -1;
+			float bestScore = -1.0f;
+			for (size_t i = 0; i < cacheCount; ++i)
+			{
+				const uint32_t v = cache[i];
+				const uint32_t* begin = adjacency.data() + adjacencyOffset[v];
+				for (uint32_t j = 0; j < remaining[v]; ++j)
+				{
+					const uint32_t t = begin[j];
+					if (triangleScore[t] > bestScore)
+					{
+						bestScore = triangleScore[t];
+						bestTriangle = t;
+					}
+				}
+			}
+		}
+
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			indices[i] = output[i];
+		}
+		return true;
+	}
+
+	template <typename TIndex>
+	bool IsValidTriangleList(const TIndex* indices, size_t indexCount, size_t vertexCount)
+	{
+		if ((indices == nullptr && indexCount > 0) || indexCount % 3 != 0)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			if (indices[i] >= vertexCount)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	///=================================================================
+	/// FIFO の頂点キャッシュを模擬します。
+	/// 頂点ごとに最後に変換した時刻を記録し、cacheSize 回以上前なら追い出し済みとみなします。
+	///=================================================================
+	class FifoCacheSimulator
+	{
+	public:
+		FifoCacheSimulator(size_t vertexCount, size_t cacheSize)
+			: m_Timestamps(vertexCount, 0), m_CacheSize(static_cast<uint32_t>(cacheSize))
+		{
+		}
+
+		/// キャッシュを空にします（タイムスタンプを進めるだけで O(1)）
+		void Reset()
+		{
+			m_Time += m_CacheSize + 1;
+		}
+
+		/// ミスした場合は true を返し、頂点をキャッシュに入れます
+		bool Access(uint32_t vertex)
+		{
+			if (m_Timestamps[vertex] != 0 && m_Time - m_Timestamps[vertex] <= m_CacheSize)
+			{
+				return false;
+			}
+			m_Timestamps[vertex] = ++m_Time;
+			return true;
+		}
+
+	private:
+		std::vector<uint32_t> m_Timestamps;
+		uint32_t m_CacheSize = 0;
+		uint32_t m_Time = 0;
+	};
+
+	template <typename TIndex>
+	MeshOptimizer::VertexCacheStatistics AnalyzeVertexCacheImpl(const TIndex* indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+	{
+		MeshOptimizer::VertexCacheStatistics stats;
+		if (!IsValidTriangleList(indices, indexCount, vertexCount) || indexCount == 0 || cacheSize == 0)
+		{
+			return stats;
+		}
+
+		FifoCacheSimulator cache(vertexCount, cacheSize);
+		std::vector<uint8_t> referenced(vertexCount, 0);
+		size_t uniqueVertexCount = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			const uint32_t v = indices[i];
+			if (cache.Access(v))
+			{
+				++stats.vertexTransforms;
+			}
+			if (!referenced[v])
+			{
+				referenced[v] = 1;
+				++uniqueVertexCount;
+			}
+		}
+		stats.acmr = static_cast<float>(stats.vertexTransforms) / static_cast<float>(indexCount / 3);
+		stats.atvr = static_cast<float>(stats.vertexTransforms) / static_cast<float>(uniqueVertexCount);
+		return stats;
+	}
+
+	struct TriangleCluster
+	{
+		size_t firstTriangle = 0;
+		size_t triangleCount = 0;
+		float sortKey = 0.0f;
+	};
+
+	template <typename TIndex>
+	bool OptimizeOverdrawImpl(TIndex* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+	{
+		if (!IsValidTriangleList(indices, indexCount, vertexCount) || positions == nullptr || positionStride < sizeof(float) * 3)
+		{
+			return false;
+		}
+		const size_t triangleCount = indexCount / 3;
+		if (triangleCount < 2)
+		{
+			return true;
+		}
+
+		const uint8_t* positionBytes = reinterpret_cast<const uint8_t*>(positions);
+		auto readPosition = [&](uint32_t vertex, float out[3])
+		{
+			std::memcpy(out, positionBytes + vertex * positionStride, sizeof(float) * 3);
+		};
+
+		// 1. 3 頂点とも新規に変換される三角形でハードな区切りを入れる
+		std::vector<uint8_t> triangleMisses(triangleCount);
+		{
+			FifoCacheSimulator cache(vertexCount, MeshOptimizer::kDefaultFifoCacheSize);
+			for (size_t t = 0; t < triangleCount; ++t)
+			{
+				uint8_t misses = 0;
+				for (size_t k = 0; k < 3; ++k)
+				{
+					misses += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+				}
+				triangleMisses[t] = misses;
+			}
+		}
+		std::vector<size_t> hardBoundaries;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			if (t == 0 || triangleMisses[t] == 3)
+			{
+				hardBoundaries.push_back(t);
+			}
+		}
+		hardBoundaries.push_back(triangleCount);
+
+		// 2. 各ハードクラスタ内で、キャッシュを空にしてもACMRが threshold 倍に収まる位置で区切る
+		std::vector<TriangleCluster> clusters;
+		FifoCacheSimulator cache(vertexCount, MeshOptimizer::kDefaultFifoCacheSize);
+		for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+		{
+			const size_t begin = hardBoundaries[h];
+			const size_t end = hardBoundaries[h + 1];
+			size_t hardMisses = 0;
+			for (size_t t = begin; t < end; ++t)
+			{
+				hardMisses += triangleMisses[t];
+			}
+			const float limit = threshold * static_cast<float>(hardMisses) / static_cast<float>(end - begin);
+
+			cache.Reset();
+			size_t clusterBegin = begin;
+			size_t clusterMisses = 0;
+			for (size_t t = begin; t < end; ++t)
+			{
+				for (size_t k = 0; k < 3; ++k)
+				{
+					clusterMisses += cache.Access(indices[t * 3 + k]) ? 1 : 0;
+				}
+				const size_t clusterTriangles = t + 1 - clusterBegin;
+				if (t + 1 < end && static_cast<float>(clusterMisses) <= limit * static_cast<float>(clusterTriangles))
+				{
+					clusters.push_back({ clusterBegin, clusterTriangles, 0.0f });
+					clusterBegin = t + 1;
+					clusterMisses = 0;
+					cache.Reset();
+				}
+			}
+			clusters.push_back({ clusterBegin, end - clusterBegin, 0.0f });
+		}
+
+		// 3. 面積で重み付けした重心と法線から、メッシュ中心に対して外向きの度合いを求める
+		float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+		float meshArea = 0.0f;
+		std::vector<float> clusterData(clusters.size() * 7, 0.0f);	// centroid(3) normal(3) area
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			float* data = &clusterData[c * 7];
+			for (size_t t = clusters[c].firstTriangle; t < clusters[c].firstTriangle + clusters[c].triangleCount; ++t)
+			{
+				float p0[3], p1[3], p2[3];
+				readPosition(indices[t * 3], p0);
+				readPosition(indices[t * 3 + 1], p1);
+				readPosition(indices[t * 3 + 2], p2);
+				const float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+				const float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+				const float normal[3] = {
+					e1[1] * e2[2] - e1[2] * e2[1],
+					e1[2] * e2[0] - e1[0] * e2[2],
+					e1[0] * e2[1] - e1[1] * e2[0],
+				};
+				const float area = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float center = (p0[axis] + p1[axis] + p2[axis]) / 3.0f;
+					data[axis] += center * area;
+					data[3 + axis] += normal[axis];
+					meshCentroid[axis] += center * area;
+				}
+				data[6] += area;
+				meshArea += area;
+			}
+		}
+		if (meshArea > 0.0f)
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				meshCentroid[axis] /= meshArea;
+			}
+		}
+		for (size_t c = 0; c < clusters.size(); ++c)
+		{
+			const float* data = &clusterData[c * 7];
+			const float area = data[6];
+			const float normalLength = std::sqrt(data[3] * data[3] + data[4] * data[4] + data[5] * data[5]);
+			if (area <= 0.0f || normalLength <= 0.0f)
+			{
+				continue;
+			}
+			float key = 0.0f;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				key += (data[axis] / area - meshCentroid[axis]) * (data[3 + axis] / normalLength);
+			}
+			clusters[c].sortKey = key;
+		}
+
+		// 4. 外向きのクラスタを先に描く（同値は元の順序を保つ）
+		std::stable_sort(clusters.begin(), clusters.end(), [](const TriangleCluster& a, const TriangleCluster& b)
+		{
+			return a.sortKey > b.sortKey;
+		});
+
+		std::vector<TIndex> output;
+		output.reserve(indexCount);
+		for (const TriangleCluster& cluster : clusters)
+		{
+			output.insert(output.end(), indices + cluster.firstTriangle * 3, indices + (cluster.firstTriangle + cluster.triangleCount) * 3);
+		}
+		std::copy(output.begin(), output.end(), indices);
+		return true;
+	}
+
+	template <typename TIndex>
+	bool OptimizeVertexFetchImpl(TIndex* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap)
+	{
+		const uint32_t kUnassigned = 0xFFFFFFFFu;
+		if (indices == nullptr && indexCount > 0)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			if (indices[i] >= vertexCount)
+			{
+				return false;
+			}
+		}
+
+		outRemap.assign(vertexCount, kUnassigned);
+		uint32_t next = 0;
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			uint32_t& slot = outRemap[indices[i]];
+			if (slot == kUnassigned)
+			{
+				slot = next++;
+			}
+			indices[i] = static_cast<TIndex>(slot);
+		}
+		// 参照されない頂点は元の順序のまま末尾へ
+		for (uint32_t& slot : outRemap)
+		{
+			if (slot == kUnassigned)
+			{
+				slot = next++;
+			}
+		}
+		return true;
+	}
+
+	template <typename TIndex>
+	bool BuildMeshletsImpl(const TIndex* indices, size_t indexCount, size_t vertexCount, size_t maxVertices, size_t maxTriangles,
+		std::vector<MeshOptimizer::Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles)
+	{
+		outMeshlets.clear();
+		outMeshletVertices.clear();
+		outMeshletTriangles.clear();
+		if (!IsValidTriangleList(indices, indexCount, vertexCount) || maxVertices < 3 || maxVertices > 256 || maxTriangles == 0)
+		{
+			return false;
+		}
+
+		// 頂点 → 現在のメッシュレット内の局所番号。meshletId が一致する場合のみ有効
+		std::vector<uint32_t> localIndex(vertexCount, 0);
+		std::vector<uint32_t> localOwner(vertexCount, 0xFFFFFFFFu);
+
+		MeshOptimizer::Meshlet current;
+		for (size_t t = 0; t < indexCount / 3; ++t)
+		{
+			const uint32_t meshletId = static_cast<uint32_t>(outMeshlets.size());
+			uint32_t newVertices = 0;
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const uint32_t v = indices[t * 3 + k];
+				const bool alreadyCounted = (k >= 1 && indices[t * 3] == v) || (k == 2 && indices[t * 3 + 1] == v);
+				if (localOwner[v] != meshletId && !alreadyCounted)
+				{
+					++newVertices;
+				}
+			}
+			if (current.vertexCount + newVertices > maxVertices || current.triangleCount + 1 > maxTriangles)
+			{
+				outMeshlets.push_back(current);
+				current = MeshOptimizer::Meshlet();
+				current.vertexOffset = static_cast<uint32_t>(outMeshletVertices.size());
+				current.triangleOffset = static_cast<uint32_t>(outMeshletTriangles.size());
+			}
+
+			const uint32_t owner = static_cast<uint32_t>(outMeshlets.size());
+			for (size_t k = 0; k < 3; ++k)
+			{
+				const uint32_t v = indices[t * 3 + k];
+				if (localOwner[v] != owner)
+				{
+					localOwner[v] = owner;
+					localIndex[v] = current.vertexCount++;
+					outMeshletVertices.push_back(v);
+				}
+				outMeshletTriangles.push_back(static_cast<uint8_t>(localIndex[v]));
+			}
+			++current.triangleCount;
+		}
+		if (current.triangleCount > 0)
+		{
+			outMeshlets.push_back(current);
+		}
+		return true;
+	}
+}
+
+namespace MeshOptimizer
+{
+	bool OptimizeVertexCache(uint16_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		return OptimizeVertexCacheImpl(indices, indexCount, vertexCount);
+	}
+
+	bool OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+	{
+		return OptimizeVertexCacheImpl(indices, indexCount, vertexCount);
+	}
+
+	bool OptimizeOverdraw(uint16_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+	{
+		return OptimizeOverdrawImpl(indices, indexCount, positions, vertexCount, positionStride, threshold);
+	}
+
+	bool OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold)
+	{
+		return OptimizeOverdrawImpl(indices, indexCount, positions, vertexCount, positionStride, threshold);
+	}
+
+	bool OptimizeTriangleOrder(uint16_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+	{
+		return OptimizeVertexCache(indices, indexCount, vertexCount) &&
+			OptimizeOverdraw(indices, indexCount, positions, vertexCount, positionStride);
+	}
+
+	bool OptimizeTriangleOrder(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride)
+	{
+		return OptimizeVertexCache(indices, indexCount, vertexCount) &&
+			OptimizeOverdraw(indices, indexCount, positions, vertexCount, positionStride);
+	}
+
+	bool OptimizeVertexFetch(uint16_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap)
+	{
+		return OptimizeVertexFetchImpl(indices, indexCount, vertexCount, outRemap);
+	}
+
+	bool OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap)
+	{
+		return OptimizeVertexFetchImpl(indices, indexCount, vertexCount, outRemap);
+	}
+
+	void RemapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t vertexStride, const std::vector<uint32_t>& remap)
+	{
+		uint8_t* dstBytes = static_cast<uint8_t*>(dst);
+		const uint8_t* srcBytes = static_cast<const uint8_t*>(src);
+		for (size_t v = 0; v < vertexCount && v < remap.size(); ++v)
+		{
+			std::memcpy(dstBytes + remap[v] * vertexStride, srcBytes + v * vertexStride, vertexStride);
+		}
+	}
+
+	bool BuildMeshlets(const uint16_t* indices, size_t indexCount, size_t vertexCount, size_t maxVertices, size_t maxTriangles,
+		std::vector<Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles)
+	{
+		return BuildMeshletsImpl(indices, indexCount, vertexCount, maxVertices, maxTriangles, outMeshlets, outMeshletVertices, outMeshletTriangles);
+	}
+
+	bool BuildMeshlets(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t maxVertices, size_t maxTriangles,
+		std::vector<Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles)
+	{
+		return BuildMeshletsImpl(indices, indexCount, vertexCount, maxVertices, maxTriangles, outMeshlets, outMeshletVertices, outMeshletTriangles);
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const uint16_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+	{
+		return AnalyzeVertexCacheImpl(indices, indexCount, vertexCount, cacheSize);
+	}
+
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize)
+	{
+		return AnalyzeVertexCacheImpl(indices, indexCount, vertexCount, cacheSize);
+	}
+}
@@ -0,0 +1,108 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// インデックスバッファと頂点順序の最適化処理。
+/// 三角形リストを対象とした CPU のみの処理で、同じ入力には常に同じ結果を返します。
+/// </summary>
+///=======================================================================
+namespace MeshOptimizer
+{
+	/// Forsyth 法で想定する頂点キャッシュのサイズ
+	constexpr size_t kVertexCacheSize = 32;
+	/// 統計で使う FIFO キャッシュの既定サイズ（一般的な GPU の後段キャッシュ相当）
+	constexpr size_t kDefaultFifoCacheSize = 16;
+	/// オーバードロー最適化でクラスタを区切る ACMR の既定しきい値
+	constexpr float kDefaultOverdrawThreshold = 1.05f;
+
+	/// 頂点キャッシュの統計
+	struct VertexCacheStatistics
+	{
+		uint32_t vertexTransforms = 0;	// キャッシュミスした頂点数
+		float acmr = 0.0f;				// 三角形あたりの変換頂点数（0.5 が理想）
+		float atvr = 0.0f;				// 参照頂点あたりの変換頂点数（1.0 が理想）
+	};
+
+	/// メッシュレット 1 つ分の範囲
+	struct Meshlet
+	{
+		uint32_t vertexOffset = 0;		// meshletVertices 内の開始位置
+		uint32_t triangleOffset = 0;	// meshletTriangles 内の開始位置（3 の倍数）
+		uint32_t vertexCount = 0;
+		uint32_t triangleCount = 0;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// Forsyth 法で三角形の順序を並べ替え、頂点シェーダー後キャッシュの
+	/// ヒット率を上げます。三角形の向き（頂点の巡回順）は維持します。
+	/// </summary>
+	/// <param name="indices">並べ替えるインデックス（in/out）</param>
+	/// <param name="indexCount">インデックス数（3 の倍数）</param>
+	/// <param name="vertexCount">参照される頂点数</param>
+	/// <returns>入力が不正な場合は false（indices は変更されません）</returns>
+	///====================================================================
+	bool OptimizeVertexCache(uint16_t* indices, size_t indexCount, size_t vertexCount);
+	bool OptimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	///====================================================================
+	/// <summary>
+	/// 頂点キャッシュ最適化済みの三角形列をクラスタに分け、外向きのクラスタから
+	/// 描画されるよう並べ替えてオーバードローを減らします。
+	/// クラスタはキャッシュ効率が threshold 倍以上悪化しない位置で区切ります。
+	/// </summary>
+	/// <param name="indices">並べ替えるインデックス（in/out）</param>
+	/// <param name="indexCount">インデックス数（3 の倍数）</param>
+	/// <param name="positions">頂点位置の先頭（float x3）</param>
+	/// <param name="vertexCount">頂点数</param>
+	/// <param name="positionStride">頂点位置の間隔（バイト）</param>
+	/// <param name="threshold">許容する ACMR の悪化率</param>
+	/// <returns>入力が不正な場合は false</returns>
+	///====================================================================
+	bool OptimizeOverdraw(uint16_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold = kDefaultOverdrawThreshold);
+	bool OptimizeOverdraw(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride, float threshold = kDefaultOverdrawThreshold);
+
+	/// 頂点キャッシュ最適化に続けてオーバードロー最適化を行います（読み込み時の標準手順）。
+	bool OptimizeTriangleOrder(uint16_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+	bool OptimizeTriangleOrder(uint32_t* indices, size_t indexCount, const float* positions, size_t vertexCount, size_t positionStride);
+
+	///====================================================================
+	/// <summary>
+	/// 最初に参照された順に頂点を並べ直す再配置表を作り、インデックスを書き換えます。
+	/// 参照されない頂点も末尾に残すので、表は常に全頂点の置換になります
+	/// （表情モーフなど頂点番号を持つデータも outRemap で変換できます）。
+	/// </summary>
+	/// <param name="indices">書き換えるインデックス（in/out）</param>
+	/// <param name="indexCount">インデックス数</param>
+	/// <param name="vertexCount">頂点数</param>
+	/// <param name="outRemap">旧頂点番号 → 新頂点番号</param>
+	/// <returns>入力が不正な場合は false</returns>
+	///====================================================================
+	bool OptimizeVertexFetch(uint16_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap);
+	bool OptimizeVertexFetch(uint32_t* indices, size_t indexCount, size_t vertexCount, std::vector<uint32_t>& outRemap);
+
+	/// 再配置表に従って頂点バッファを並べ替えます（src と dst は別領域）。
+	void RemapVertexBuffer(void* dst, const void* src, size_t vertexCount, size_t vertexStride, const std::vector<uint32_t>& remap);
+
+	///====================================================================
+	/// <summary>
+	/// 三角形列を先頭から順にメッシュレットへ分割します。
+	/// 三角形は meshletVertices 内の局所番号（8bit）で格納します。
+	/// </summary>
+	/// <param name="maxVertices">メッシュレットあたりの最大頂点数（256 以下）</param>
+	/// <param name="maxTriangles">メッシュレットあたりの最大三角形数</param>
+	/// <returns>入力が不正な場合は false</returns>
+	///====================================================================
+	bool BuildMeshlets(const uint16_t* indices, size_t indexCount, size_t vertexCount, size_t maxVertices, size_t maxTriangles,
+		std::vector<Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles);
+	bool BuildMeshlets(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t maxVertices, size_t maxTriangles,
+		std::vector<Meshlet>& outMeshlets, std::vector<uint32_t>& outMeshletVertices, std::vector<uint8_t>& outMeshletTriangles);
+
+	/// FIFO キャッシュを模擬して ACMR/ATVR を求めます。
+	VertexCacheStatistics AnalyzeVertexCache(const uint16_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = kDefaultFifoCacheSize);
+	VertexCacheStatistics AnalyzeVertexCache(const uint32_t* indices, size_t indexCount, size_t vertexCount, size_t cacheSize = kDefaultFifoCacheSize);
+}
@@ -1,38 +1,57 @@
 ﻿
 #include "pch.h"
 #include "PMDAnalyzer.h"
-#include "Source/Dx12RenderDevice.h"
-#include <d3d12.h>
-#include <utility>
-#include "d3dx12.h" // ヘッダーをインクルード
+#include "PMDMappedReader.h"
+#include <cstddef>
+#include <cstring>
+
+// PMDVertex の先頭 38 バイトはディスク上の頂点レコードと同じ並びである必要があります。
+static_assert(offsetof(PMDVertex, pos) == offsetof(PMD::VertexRecord, pos), "PMDVertex layout mismatch");
+static_assert(offsetof(PMDVertex, normal) == offsetof(PMD::VertexRecord, normal), "PMDVertex layout mismatch");
+static_assert(offsetof(PMDVertex, uv) == offsetof(PMD::VertexRecord, uv), "PMDVertex layout mismatch");
+static_assert(offsetof(PMDVertex, boneIndex) == offsetof(PMD::VertexRecord, boneIndex), "PMDVertex layout mismatch");
+static_assert(offsetof(PMDVertex, boneWeight) == offsetof(PMD::VertexRecord, boneWeight), "PMDVertex layout mismatch");
+static_assert(offsetof(PMDVertex, edgeFlag) == offsetof(PMD::VertexRecord, edgeFlag), "PMDVertex layout mismatch");
 
 PMDAnalyzer::PMDAnalyzer(string fileName)
 {
-	PMDHeader header;
-	char signature[3];
-	FILE* fp;
-	auto err = fopen_s(&fp, fileName.c_str(), "rb");
-	if (err != 0) {
-		// エラー処理
+	static_assert(sizeof(PMD::HeaderRecord) == PMD_HEADER_SIZE, "PMD header size mismatch");
+	static_assert(sizeof(PMD::VertexRecord) == PMD_VERTEX_SIZE, "PMD vertex size mismatch");
+
+	PMDMappedReader reader;
+	if (!reader.Open(std::filesystem::path(fileName)))
+	{
+		LOG_DEBUG("PMDAnalyzer: %s (%s)\n", reader.GetLastError().c_str(), fileName.c_str());
 		return;
 	}
 
-	// headerの読み込み
-	fread(signature, sizeof(signature), 1, fp);
-	fread(&header, sizeof(header), 1, fp);
-
-	// データの読み込みや解析をここで行う
-	unsigned int vertexCount;
-	fread(&vertexCount, sizeof(vertexCount), 1, fp);
-
-	std::vector<PMDVertex> vertices(vertexCount);
+	// マップ済みの頂点セクションから一括で展開する
+	const auto sourceVertices = reader.GetVertices();
+	m_Vertices.resize(sourceVertices.Size());
+	const uint8_t* src = sourceVertices.RawData();
+	for (size_t i = 0; i < m_Vertices.size(); ++i)
+	{
+		std::memcpy(&m_Vertices[i], src + i * PMD_VERTEX_SIZE, PMD_VERTEX_SIZE);
+	}
 
-	for (unsigned int i = 0; i < vertexCount; i++)
+	if (!BuildPMDModelData(reader, m_ModelData))
 	{
-		fread(&vertices[i], PMD_VERTEX_SIZE, 1, fp);
+		LOG_DEBUG("PMDAnalyzer: material index ranges exceed index count (%s)\n", fileName.c_str());
+		m_Vertices.clear();
+		return;
 	}
 
-	m_Vertices = std::move(vertices);
+	// インデックスが頂点数を超えていないことを確認する
+	for (uint16_t index : m_ModelData.indices)
+	{
+		if (index >= m_Vertices.size())
+		{
+			LOG_DEBUG("PMDAnalyzer: index out of range (%s)\n", fileName.c_str());
+			m_Vertices.clear();
+			m_ModelData = PMDModelData();
+			return;
+		}
+	}
 
-	fclose(fp);
+	m_IsLoaded = true;
 }
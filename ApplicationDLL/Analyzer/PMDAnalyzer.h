@@ -4,6 +4,7 @@
 #include <cstdint>
 #include <vector>
 #include "../Math/MathUtil.h"
+#include "PMDModelData.h"
 
 using namespace std;
 using namespace WL;
@@ -27,15 +28,28 @@ struct PMDVertex
 	unsigned char edgeFlag; // エッジフラグ（0: 通常、1: エッジあり）
 }; // PMDファイルの頂点データ構造38バイト
 
+///=======================================================================
+/// <summary>
+/// PMD ファイルを解析して頂点配列とモデルデータを構築します。
+/// ファイルは PMDMappedReader でメモリマップし、検証済みの頂点セクションから
+/// 一度の走査で m_Vertices へ展開します。インデックス・マテリアル・ボーン・IK・
+/// 表情などは PMDModelData の SoA テーブルとして保持します。
+/// </summary>
+///=======================================================================
 class PMDAnalyzer
 {
 
 private:
-	static constexpr size_t			PMD_HEADER_SIZE = sizeof(PMDHeader);
+	static constexpr size_t			PMD_HEADER_SIZE = 283;
 	static constexpr unsigned int	PMD_VERTEX_SIZE = 38;//頂点1つあたりのサイズ
 	std::vector<PMDVertex>			m_Vertices;
+	PMDModelData					m_ModelData;
+	bool							m_IsLoaded = false;
 public:
 	PMDAnalyzer(string fileName);
 
+	bool IsLoaded() const { return m_IsLoaded; }
 	const std::vector<PMDVertex>& GetVertices() const { return m_Vertices; }
+	const std::vector<uint16_t>& GetIndices() const { return m_ModelData.indices; }
+	const PMDModelData& GetModelData() const { return m_ModelData; }
 };
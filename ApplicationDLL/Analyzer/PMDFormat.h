@@ -0,0 +1,151 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+///=======================================================================
+/// PMD ファイルのディスク上のレイアウトをそのまま表すレコード定義。
+/// すべて 1 バイトパックなので、マップしたバイト列の任意のオフセットに
+/// 直接重ねて参照できます（アラインメントの要求は 1）。
+///=======================================================================
+namespace PMD
+{
+#pragma pack(push, 1)
+
+	struct Float2
+	{
+		float x;
+		float y;
+	};
+
+	struct Float3
+	{
+		float x;
+		float y;
+		float z;
+	};
+
+	struct HeaderRecord
+	{
+		char signature[3];	// "Pmd"
+		float version;
+		char modelName[20];
+		char comment[256];
+	};
+
+	struct VertexRecord
+	{
+		Float3 pos;
+		Float3 normal;
+		Float2 uv;
+		uint16_t boneIndex[2];
+		uint8_t boneWeight;	// boneIndex[0] の影響度（0～100）
+		uint8_t edgeFlag;
+	};
+
+	struct IndexRecord
+	{
+		uint16_t index;
+	};
+
+	struct MaterialRecord
+	{
+		Float3 diffuse;
+		float alpha;
+		float specularity;
+		Float3 specular;
+		Float3 ambient;
+		uint8_t toonIndex;
+		uint8_t edgeFlag;
+		uint32_t indexCount;
+		char textureFileName[20];	// "tex.bmp*sphere.sph" 形式
+	};
+
+	struct BoneRecord
+	{
+		char name[20];
+		uint16_t parentIndex;	// 0xFFFF は親なし
+		uint16_t tailIndex;
+		uint8_t type;
+		uint16_t ikBoneIndex;
+		Float3 headPos;
+	};
+
+	// IK レコードの固定長部分。直後に chainLength 個のボーンインデックスが続きます。
+	struct IKRecord
+	{
+		uint16_t boneIndex;
+		uint16_t targetBoneIndex;
+		uint8_t chainLength;
+		uint16_t iterations;
+		float limitAngle;
+	};
+
+	struct BoneIndexRecord
+	{
+		uint16_t boneIndex;
+	};
+
+	// 表情（スキン）レコードの固定長部分。直後に vertexCount 個の SkinVertexRecord が続きます。
+	struct SkinRecord
+	{
+		char name[20];
+		uint32_t vertexCount;
+		uint8_t type;	// 0: base, 1: まゆ, 2: 目, 3: リップ, 4: その他
+	};
+
+	struct SkinVertexRecord
+	{
+		uint32_t vertexIndex;	// base では頂点番号、それ以外では base 内の番号
+		Float3 offset;			// base では絶対座標、それ以外では base からの差分
+	};
+
+	struct SkinIndexRecord
+	{
+		uint16_t skinIndex;
+	};
+
+	struct BoneDisplayNameRecord
+	{
+		char name[50];
+	};
+
+	struct BoneDisplayRecord
+	{
+		uint16_t boneIndex;
+		uint8_t frameIndex;
+	};
+
+	struct EnglishHeaderRecord
+	{
+		char modelName[20];
+		char comment[256];
+	};
+
+	struct NameRecord
+	{
+		char name[20];
+	};
+
+	struct ToonTextureRecord
+	{
+		char fileName[100];
+	};
+
+#pragma pack(pop)
+
+	constexpr uint16_t kNoBone = 0xFFFF;
+	constexpr size_t kToonTextureCount = 10;
+
+	static_assert(sizeof(HeaderRecord) == 283, "PMD header must be 283 bytes");
+	static_assert(sizeof(VertexRecord) == 38, "PMD vertex must be 38 bytes");
+	static_assert(sizeof(IndexRecord) == 2, "PMD index must be 2 bytes");
+	static_assert(sizeof(MaterialRecord) == 70, "PMD material must be 70 bytes");
+	static_assert(sizeof(BoneRecord) == 39, "PMD bone must be 39 bytes");
+	static_assert(sizeof(IKRecord) == 11, "PMD IK header must be 11 bytes");
+	static_assert(sizeof(SkinRecord) == 25, "PMD skin header must be 25 bytes");
+	static_assert(sizeof(SkinVertexRecord) == 16, "PMD skin vertex must be 16 bytes");
+	static_assert(sizeof(BoneDisplayRecord) == 3, "PMD bone display must be 3 bytes");
+	static_assert(sizeof(EnglishHeaderRecord) == 276, "PMD english header must be 276 bytes");
+	static_assert(sizeof(ToonTextureRecord) == 100, "PMD toon texture name must be 100 bytes");
+}
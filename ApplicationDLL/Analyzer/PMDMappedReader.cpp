@@ -0,0 +1,230 @@
+﻿#include "PMDMappedReader.h"
+
+#include <cstring>
+
+namespace
+{
+	///=================================================================
+	/// マップ領域を先頭から順に切り出すカーソル。
+	/// 境界外の読み取りは常に失敗として扱います。
+	///=================================================================
+	class SectionCursor
+	{
+	public:
+		SectionCursor(const uint8_t* data, size_t size)
+			: m_pData(data), m_Size(size)
+		{
+		}
+
+		template <typename T>
+		bool ReadValue(T& outValue)
+		{
+			if (m_Size - m_Offset < sizeof(T))
+			{
+				return false;
+			}
+			std::memcpy(&outValue, m_pData + m_Offset, sizeof(T));
+			m_Offset += sizeof(T);
+			return true;
+		}
+
+		bool Take(uint64_t count, size_t stride, const uint8_t** outData)
+		{
+			const uint64_t bytes = count * static_cast<uint64_t>(stride);
+			if (bytes > static_cast<uint64_t>(m_Size - m_Offset))
+			{
+				return false;
+			}
+			*outData = m_pData + m_Offset;
+			m_Offset += static_cast<size_t>(bytes);
+			return true;
+		}
+
+		template <typename TRecord>
+		bool TakeRecord(const TRecord** outRecord)
+		{
+			const uint8_t* data = nullptr;
+			if (!Take(1, sizeof(TRecord), &data))
+			{
+				return false;
+			}
+			*outRecord = reinterpret_cast<const TRecord*>(data);
+			return true;
+		}
+
+		template <typename TRecord>
+		bool TakeArray(uint64_t count, PMDRecordView<TRecord>& outView)
+		{
+			const uint8_t* data = nullptr;
+			if (!Take(count, sizeof(TRecord), &data))
+			{
+				return false;
+			}
+			outView = PMDRecordView<TRecord>(data, static_cast<size_t>(count));
+			return true;
+		}
+
+		template <typename TRecord, typename TCount>
+		bool TakeSection(PMDRecordView<TRecord>& outView)
+		{
+			TCount count = 0;
+			return ReadValue(count) && TakeArray(count, outView);
+		}
+
+		bool AtEnd() const { return m_Offset == m_Size; }
+
+	private:
+		const uint8_t* m_pData = nullptr;
+		size_t m_Size = 0;
+		size_t m_Offset = 0;
+	};
+}
+
+///====================================================================
+/// <summary>
+/// PMD ファイルをマップし、ヘッダーから各セクションの範囲を検証します。
+/// 英名とトゥーンテクスチャ名のセクションは古いファイルでは存在しないため、
+/// ファイル末尾で終わっている場合は省略されたものとして扱います。
+/// </summary>
+/// <param name="filePath">PMD ファイルのパス</param>
+/// <returns>検証まで成功した場合は true</returns>
+///====================================================================
+bool PMDMappedReader::Open(const std::filesystem::path& filePath)
+{
+	Close();
+
+	if (!m_File.Open(filePath))
+	{
+		return Fail("failed to map file");
+	}
+
+	SectionCursor cursor(m_File.GetData(), m_File.GetSize());
+	const uint8_t* headerData = nullptr;
+	if (!cursor.Take(1, sizeof(PMD::HeaderRecord), &headerData))
+	{
+		return Fail("file is too small for PMD header");
+	}
+	if (std::memcmp(GetHeader().signature, "Pmd", 3) != 0)
+	{
+		return Fail("invalid PMD signature");
+	}
+
+	if (!cursor.TakeSection<PMD::VertexRecord, uint32_t>(m_Vertices))
+	{
+		return Fail("vertex section is truncated");
+	}
+	if (!cursor.TakeSection<PMD::IndexRecord, uint32_t>(m_Indices))
+	{
+		return Fail("index section is truncated");
+	}
+	if (!cursor.TakeSection<PMD::MaterialRecord, uint32_t>(m_Materials))
+	{
+		return Fail("material section is truncated");
+	}
+	if (!cursor.TakeSection<PMD::BoneRecord, uint16_t>(m_Bones))
+	{
+		return Fail("bone section is truncated");
+	}
+
+	uint16_t ikCount = 0;
+	if (!cursor.ReadValue(ikCount))
+	{
+		return Fail("IK section is truncated");
+	}
+	m_IKs.resize(ikCount);
+	for (PMDIKView& ik : m_IKs)
+	{
+		if (!cursor.TakeRecord(&ik.record) || !cursor.TakeArray(ik.record->chainLength, ik.chain))
+		{
+			return Fail("IK section is truncated");
+		}
+	}
+
+	uint16_t skinCount = 0;
+	if (!cursor.ReadValue(skinCount))
+	{
+		return Fail("skin section is truncated");
+	}
+	m_Skins.resize(skinCount);
+	for (PMDSkinView& skin : m_Skins)
+	{
+		if (!cursor.TakeRecord(&skin.record) || !cursor.TakeArray(skin.record->vertexCount, skin.vertices))
+		{
+			return Fail("skin section is truncated");
+		}
+	}
+
+	if (!cursor.TakeSection<PMD::SkinIndexRecord, uint8_t>(m_SkinDisplays))
+	{
+		return Fail("skin display section is truncated");
+	}
+	if (!cursor.TakeSection<PMD::BoneDisplayNameRecord, uint8_t>(m_BoneDisplayNames))
+	{
+		return Fail("bone display name section is truncated");
+	}
+	if (!cursor.TakeSection<PMD::BoneDisplayRecord, uint32_t>(m_BoneDisplays))
+	{
+		return Fail("bone display section is truncated");
+	}
+
+	// ここから先は拡張セクション
+	if (!cursor.AtEnd())
+	{
+		uint8_t hasEnglish = 0;
+		if (!cursor.ReadValue(hasEnglish))
+		{
+			return Fail("english section is truncated");
+		}
+		if (hasEnglish != 0)
+		{
+			const size_t englishSkinCount = skinCount > 0 ? skinCount - 1u : 0u;
+			if (!cursor.TakeRecord(&m_pEnglishHeader) ||
+				!cursor.TakeArray(m_Bones.Size(), m_EnglishBoneNames) ||
+				!cursor.TakeArray(englishSkinCount, m_EnglishSkinNames) ||
+				!cursor.TakeArray(m_BoneDisplayNames.Size(), m_EnglishBoneDisplayNames))
+			{
+				return Fail("english section is truncated");
+			}
+		}
+	}
+	if (!cursor.AtEnd())
+	{
+		if (!cursor.TakeArray(PMD::kToonTextureCount, m_ToonTextures))
+		{
+			return Fail("toon texture section is truncated");
+		}
+	}
+	// 以降の剛体・ジョイントは物理演算用のため読み込みません。
+
+	m_IsValid = true;
+	return true;
+}
+
+void PMDMappedReader::Close()
+{
+	m_File.Close();
+	m_IsValid = false;
+	m_LastError.clear();
+	m_Vertices = {};
+	m_Indices = {};
+	m_Materials = {};
+	m_Bones = {};
+	m_IKs.clear();
+	m_Skins.clear();
+	m_SkinDisplays = {};
+	m_BoneDisplayNames = {};
+	m_BoneDisplays = {};
+	m_pEnglishHeader = nullptr;
+	m_EnglishBoneNames = {};
+	m_EnglishSkinNames = {};
+	m_EnglishBoneDisplayNames = {};
+	m_ToonTextures = {};
+}
+
+bool PMDMappedReader::Fail(const char* message)
+{
+	// 途中まで設定したビューも含めて破棄する
+	Close();
+	m_LastError = message;
+	return false;
+}
@@ -0,0 +1,137 @@
+﻿#pragma once
+
+#include "MappedFile.h"
+#include "PMDFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// マップ済みバイト列に重ねたレコード配列のビュー。
+/// 要素はコピーせずにマップ領域を直接参照します。
+/// 範囲はリーダーの Open 時に検証済みで、At() は添字も検査します。
+/// </summary>
+///=======================================================================
+template <typename TRecord>
+class PMDRecordView
+{
+public:
+	static_assert(alignof(TRecord) == 1, "PMD records must be packed");
+
+	PMDRecordView() = default;
+	PMDRecordView(const uint8_t* data, size_t count)
+		: m_pData(data), m_Count(count)
+	{
+	}
+
+	size_t Size() const { return m_Count; }
+	bool Empty() const { return m_Count == 0; }
+	size_t SizeInBytes() const { return m_Count * sizeof(TRecord); }
+	const uint8_t* RawData() const { return m_pData; }
+
+	const TRecord& operator[](size_t index) const
+	{
+		return *reinterpret_cast<const TRecord*>(m_pData + index * sizeof(TRecord));
+	}
+
+	const TRecord& At(size_t index) const
+	{
+		if (index >= m_Count)
+		{
+			throw std::out_of_range("PMDRecordView index out of range");
+		}
+		return (*this)[index];
+	}
+
+	const TRecord* begin() const { return reinterpret_cast<const TRecord*>(m_pData); }
+	const TRecord* end() const { return begin() + m_Count; }
+
+private:
+	const uint8_t* m_pData = nullptr;
+	size_t m_Count = 0;
+};
+
+/// IK レコード 1 件分のビュー（固定長部分とチェーンのボーン列）
+struct PMDIKView
+{
+	const PMD::IKRecord* record = nullptr;
+	PMDRecordView<PMD::BoneIndexRecord> chain;
+};
+
+/// 表情レコード 1 件分のビュー（固定長部分と頂点オフセット列）
+struct PMDSkinView
+{
+	const PMD::SkinRecord* record = nullptr;
+	PMDRecordView<PMD::SkinVertexRecord> vertices;
+};
+
+///=======================================================================
+/// <summary>
+/// PMD ファイルをメモリマップして読み込むリーダー。
+/// Open 時にヘッダーからトゥーンテクスチャ名までの全セクションの範囲を一度だけ検証し、
+/// 以降は要素ごとの読み込みやコピーなしで型付きビューを返します。
+/// </summary>
+///=======================================================================
+class PMDMappedReader
+{
+public:
+	bool Open(const std::filesystem::path& filePath);
+	void Close();
+
+	bool IsValid() const { return m_IsValid; }
+	const std::string& GetLastError() const { return m_LastError; }
+
+	const PMD::HeaderRecord& GetHeader() const { return *reinterpret_cast<const PMD::HeaderRecord*>(m_File.GetData()); }
+	PMDRecordView<PMD::VertexRecord> GetVertices() const { return m_Vertices; }
+	PMDRecordView<PMD::IndexRecord> GetIndices() const { return m_Indices; }
+	PMDRecordView<PMD::MaterialRecord> GetMaterials() const { return m_Materials; }
+	PMDRecordView<PMD::BoneRecord> GetBones() const { return m_Bones; }
+	const std::vector<PMDIKView>& GetIKs() const { return m_IKs; }
+	const std::vector<PMDSkinView>& GetSkins() const { return m_Skins; }
+	PMDRecordView<PMD::SkinIndexRecord> GetSkinDisplays() const { return m_SkinDisplays; }
+	PMDRecordView<PMD::BoneDisplayNameRecord> GetBoneDisplayNames() const { return m_BoneDisplayNames; }
+	PMDRecordView<PMD::BoneDisplayRecord> GetBoneDisplays() const { return m_BoneDisplays; }
+
+	/// 英名セクションを持つ場合のみ非 null
+	const PMD::EnglishHeaderRecord* GetEnglishHeader() const { return m_pEnglishHeader; }
+	PMDRecordView<PMD::NameRecord> GetEnglishBoneNames() const { return m_EnglishBoneNames; }
+	/// base を除いた表情の英名（GetSkins()[1] 以降に対応）
+	PMDRecordView<PMD::NameRecord> GetEnglishSkinNames() const { return m_EnglishSkinNames; }
+	PMDRecordView<PMD::BoneDisplayNameRecord> GetEnglishBoneDisplayNames() const { return m_EnglishBoneDisplayNames; }
+
+	/// トゥーンテクスチャ名。セクションが無い古いファイルでは空
+	PMDRecordView<PMD::ToonTextureRecord> GetToonTextures() const { return m_ToonTextures; }
+
+	/// マップ済みファイル全体のバイト列
+	const uint8_t* GetFileData() const { return m_File.GetData(); }
+	size_t GetFileSize() const { return m_File.GetSize(); }
+
+private:
+	bool Fail(const char* message);
+
+	MappedFile m_File;
+	bool m_IsValid = false;
+	std::string m_LastError;
+
+	PMDRecordView<PMD::VertexRecord> m_Vertices;
+	PMDRecordView<PMD::IndexRecord> m_Indices;
+	PMDRecordView<PMD::MaterialRecord> m_Materials;
+	PMDRecordView<PMD::BoneRecord> m_Bones;
+	std::vector<PMDIKView> m_IKs;
+	std::vector<PMDSkinView> m_Skins;
+	PMDRecordView<PMD::SkinIndexRecord> m_SkinDisplays;
+	PMDRecordView<PMD::BoneDisplayNameRecord> m_BoneDisplayNames;
+	PMDRecordView<PMD::BoneDisplayRecord> m_BoneDisplays;
+
+	const PMD::EnglishHeaderRecord* m_pEnglishHeader = nullptr;
+	PMDRecordView<PMD::NameRecord> m_EnglishBoneNames;
+	PMDRecordView<PMD::NameRecord> m_EnglishSkinNames;
+	PMDRecordView<PMD::BoneDisplayNameRecord> m_EnglishBoneDisplayNames;
+
+	PMDRecordView<PMD::ToonTextureRecord> m_ToonTextures;
+};
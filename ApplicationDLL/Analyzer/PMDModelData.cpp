@@ -0,0 +1,290 @@
+﻿#include "PMDModelData.h"
+#include "PMDMappedReader.h"
+
+#include <cstring>
+
+namespace
+{
+	/// NUL 終端または固定長で終わる名前を文字列にします。
+	template <size_t N>
+	std::string ToString(const char (&text)[N])
+	{
+		const void* terminator = std::memchr(text, '\0', N);
+		const size_t length = terminator != nullptr
+			? static_cast<size_t>(static_cast<const char*>(terminator) - text)
+			: N;
+		return std::string(text, length);
+	}
+
+	bool EndsWithNoCase(const std::string& text, const char* suffix)
+	{
+		const size_t suffixLength = std::strlen(suffix);
+		if (text.size() < suffixLength)
+		{
+			return false;
+		}
+		for (size_t i = 0; i < suffixLength; ++i)
+		{
+			char c = text[text.size() - suffixLength + i];
+			if (c >= 'A' && c <= 'Z')
+			{
+				c = static_cast<char>(c - 'A' + 'a');
+			}
+			if (c != suffix[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	///=================================================================
+	/// "tex.bmp*sphere.sph" 形式のテクスチャ名をテクスチャとスフィアに分けます。
+	/// '*' が無く拡張子が .sph/.spa の場合はスフィアのみとみなします。
+	///=================================================================
+	void SplitTextureFileName(const std::string& fileName, std::string& outTexture, std::string& outSphere, PMDSphereMode& outMode)
+	{
+		outTexture.clear();
+		outSphere.clear();
+
+		const size_t separator = fileName.find('*');
+		if (separator != std::string::npos)
+		{
+			outTexture = fileName.substr(0, separator);
+			outSphere = fileName.substr(separator + 1);
+		}
+		else if (EndsWithNoCase(fileName, ".sph") || EndsWithNoCase(fileName, ".spa"))
+		{
+			outSphere = fileName;
+		}
+		else
+		{
+			outTexture = fileName;
+		}
+
+		if (outSphere.empty())
+		{
+			outMode = PMDSphereMode::None;
+		}
+		else
+		{
+			outMode = EndsWithNoCase(outSphere, ".spa") ? PMDSphereMode::Add : PMDSphereMode::Multiply;
+		}
+	}
+
+	/// マテリアルの描画範囲がインデックス数を超える場合は false を返します。
+	bool BuildMaterials(const PMDMappedReader& reader, PMDMaterialTable& table)
+	{
+		const uint64_t totalIndexCount = reader.GetIndices().Size();
+		const auto records = reader.GetMaterials();
+		const size_t count = records.Size();
+		table.diffuse.resize(count);
+		table.alpha.resize(count);
+		table.specularity.resize(count);
+		table.specular.resize(count);
+		table.ambient.resize(count);
+		table.toonIndex.resize(count);
+		table.edgeFlag.resize(count);
+		table.indexOffset.resize(count);
+		table.indexCount.resize(count);
+		table.textureFileName.resize(count);
+		table.sphereFileName.resize(count);
+		table.sphereMode.resize(count);
+
+		uint64_t indexOffset = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const PMD::MaterialRecord& record = records[i];
+			if (indexOffset + record.indexCount > totalIndexCount)
+			{
+				return false;
+			}
+			table.diffuse[i] = record.diffuse;
+			table.alpha[i] = record.alpha;
+			table.specularity[i] = record.specularity;
+			table.specular[i] = record.specular;
+			table.ambient[i] = record.ambient;
+			table.toonIndex[i] = record.toonIndex;
+			table.edgeFlag[i] = record.edgeFlag;
+			table.indexOffset[i] = static_cast<uint32_t>(indexOffset);
+			table.indexCount[i] = record.indexCount;
+			SplitTextureFileName(ToString(record.textureFileName),
+				table.textureFileName[i], table.sphereFileName[i], table.sphereMode[i]);
+			indexOffset += record.indexCount;
+		}
+		return true;
+	}
+
+	void BuildBones(const PMDMappedReader& reader, PMDBoneTable& table)
+	{
+		const auto records = reader.GetBones();
+		const auto englishNames = reader.GetEnglishBoneNames();
+		const size_t count = records.Size();
+		table.name.resize(count);
+		table.englishName.resize(count);
+		table.parentIndex.resize(count);
+		table.tailIndex.resize(count);
+		table.type.resize(count);
+		table.ikBoneIndex.resize(count);
+		table.headPos.resize(count);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const PMD::BoneRecord& record = records[i];
+			table.name[i] = ToString(record.name);
+			if (i < englishNames.Size())
+			{
+				table.englishName[i] = ToString(englishNames[i].name);
+			}
+			table.parentIndex[i] = record.parentIndex;
+			table.tailIndex[i] = record.tailIndex;
+			table.type[i] = record.type;
+			table.ikBoneIndex[i] = record.ikBoneIndex;
+			table.headPos[i] = record.headPos;
+		}
+	}
+
+	void BuildIKs(const PMDMappedReader& reader, PMDIKTable& table)
+	{
+		const auto& iks = reader.GetIKs();
+		const size_t count = iks.size();
+		table.boneIndex.resize(count);
+		table.targetBoneIndex.resize(count);
+		table.iterations.resize(count);
+		table.limitAngle.resize(count);
+		table.chainOffset.resize(count);
+		table.chainLength.resize(count);
+		table.chainBoneIndex.clear();
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const PMD::IKRecord& record = *iks[i].record;
+			table.boneIndex[i] = record.boneIndex;
+			table.targetBoneIndex[i] = record.targetBoneIndex;
+			table.iterations[i] = record.iterations;
+			table.limitAngle[i] = record.limitAngle;
+			table.chainOffset[i] = static_cast<uint32_t>(table.chainBoneIndex.size());
+			table.chainLength[i] = record.chainLength;
+			for (const PMD::BoneIndexRecord& chainBone : iks[i].chain)
+			{
+				// push_back は参照で受け取るので、パックされたメンバーを直接渡さず値に写してから渡す
+				const uint16_t boneIndex = chainBone.boneIndex;
+				table.chainBoneIndex.push_back(boneIndex);
+			}
+		}
+	}
+
+	void BuildMorphs(const PMDMappedReader& reader, PMDMorphTable& table)
+	{
+		const auto& skins = reader.GetSkins();
+		const auto englishNames = reader.GetEnglishSkinNames();
+		const size_t count = skins.size();
+		table.name.resize(count);
+		table.englishName.resize(count);
+		table.type.resize(count);
+		table.vertexOffset.resize(count);
+		table.vertexCount.resize(count);
+
+		size_t totalVertexCount = 0;
+		for (const PMDSkinView& skin : skins)
+		{
+			totalVertexCount += skin.vertices.Size();
+		}
+		table.vertexIndex.resize(totalVertexCount);
+		table.positionOffset.resize(totalVertexCount);
+
+		uint32_t vertexOffset = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const PMD::SkinRecord& record = *skins[i].record;
+			table.name[i] = ToString(record.name);
+			// 英名は base を除いた表情に対して格納されている
+			if (i > 0 && i - 1 < englishNames.Size())
+			{
+				table.englishName[i] = ToString(englishNames[i - 1].name);
+			}
+			table.type[i] = record.type;
+			table.vertexOffset[i] = vertexOffset;
+			table.vertexCount[i] = record.vertexCount;
+			for (const PMD::SkinVertexRecord& vertex : skins[i].vertices)
+			{
+				table.vertexIndex[vertexOffset] = vertex.vertexIndex;
+				table.positionOffset[vertexOffset] = vertex.offset;
+				++vertexOffset;
+			}
+		}
+	}
+
+	void BuildDisplay(const PMDMappedReader& reader, PMDDisplayTable& table)
+	{
+		table.skinIndex.clear();
+		for (const PMD::SkinIndexRecord& record : reader.GetSkinDisplays())
+		{
+			const uint16_t skinIndex = record.skinIndex;
+			table.skinIndex.push_back(skinIndex);
+		}
+
+		const auto frameNames = reader.GetBoneDisplayNames();
+		const auto englishFrameNames = reader.GetEnglishBoneDisplayNames();
+		table.boneFrameName.resize(frameNames.Size());
+		table.boneFrameEnglishName.resize(frameNames.Size());
+		for (size_t i = 0; i < frameNames.Size(); ++i)
+		{
+			table.boneFrameName[i] = ToString(frameNames[i].name);
+			if (i < englishFrameNames.Size())
+			{
+				table.boneFrameEnglishName[i] = ToString(englishFrameNames[i].name);
+			}
+		}
+
+		const auto displays = reader.GetBoneDisplays();
+		table.boneIndex.resize(displays.Size());
+		table.boneFrameIndex.resize(displays.Size());
+		for (size_t i = 0; i < displays.Size(); ++i)
+		{
+			table.boneIndex[i] = displays[i].boneIndex;
+			table.boneFrameIndex[i] = displays[i].frameIndex;
+		}
+	}
+}
+
+bool BuildPMDModelData(const PMDMappedReader& reader, PMDModelData& outData)
+{
+	outData = PMDModelData();
+	if (!reader.IsValid())
+	{
+		return false;
+	}
+
+	const PMD::HeaderRecord& header = reader.GetHeader();
+	outData.version = header.version;
+	outData.modelName = ToString(header.modelName);
+	outData.comment = ToString(header.comment);
+	if (const PMD::EnglishHeaderRecord* englishHeader = reader.GetEnglishHeader())
+	{
+		outData.englishModelName = ToString(englishHeader->modelName);
+		outData.englishComment = ToString(englishHeader->comment);
+	}
+
+	const auto indices = reader.GetIndices();
+	outData.indices.resize(indices.Size());
+	if (!indices.Empty())
+	{
+		std::memcpy(outData.indices.data(), indices.RawData(), indices.SizeInBytes());
+	}
+
+	if (!BuildMaterials(reader, outData.materials))
+	{
+		return false;
+	}
+	BuildBones(reader, outData.bones);
+	BuildIKs(reader, outData.iks);
+	BuildMorphs(reader, outData.morphs);
+	BuildDisplay(reader, outData.display);
+
+	for (const PMD::ToonTextureRecord& toon : reader.GetToonTextures())
+	{
+		outData.toonTextureFileNames.push_back(ToString(toon.fileName));
+	}
+	return true;
+}
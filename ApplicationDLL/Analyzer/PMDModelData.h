@@ -0,0 +1,117 @@
+﻿#pragma once
+
+#include "PMDFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class PMDMappedReader;
+
+///=======================================================================
+/// PMD モデルの頂点以外のデータを、種類ごとの構造体配列（SoA）で保持します。
+/// 各テーブルは同じ添字で列をそろえて参照します。
+/// 名前は PMD に格納された Shift_JIS のバイト列のまま保持します。
+///=======================================================================
+
+/// スフィアマップの合成方法
+enum class PMDSphereMode : uint8_t
+{
+	None,
+	Multiply,	// .sph
+	Add,		// .spa
+};
+
+struct PMDMaterialTable
+{
+	std::vector<PMD::Float3> diffuse;
+	std::vector<float> alpha;
+	std::vector<float> specularity;
+	std::vector<PMD::Float3> specular;
+	std::vector<PMD::Float3> ambient;
+	std::vector<uint8_t> toonIndex;		// 0xFF はトゥーンなし
+	std::vector<uint8_t> edgeFlag;
+	std::vector<uint32_t> indexOffset;	// インデックス配列内の開始位置
+	std::vector<uint32_t> indexCount;
+	std::vector<std::string> textureFileName;
+	std::vector<std::string> sphereFileName;
+	std::vector<PMDSphereMode> sphereMode;
+
+	size_t Size() const { return indexCount.size(); }
+};
+
+struct PMDBoneTable
+{
+	std::vector<std::string> name;
+	std::vector<std::string> englishName;
+	std::vector<uint16_t> parentIndex;	// PMD::kNoBone は親なし
+	std::vector<uint16_t> tailIndex;
+	std::vector<uint8_t> type;
+	std::vector<uint16_t> ikBoneIndex;
+	std::vector<PMD::Float3> headPos;
+
+	size_t Size() const { return parentIndex.size(); }
+};
+
+struct PMDIKTable
+{
+	std::vector<uint16_t> boneIndex;
+	std::vector<uint16_t> targetBoneIndex;
+	std::vector<uint16_t> iterations;
+	std::vector<float> limitAngle;
+	std::vector<uint32_t> chainOffset;	// chainBoneIndex 内の開始位置
+	std::vector<uint8_t> chainLength;
+	std::vector<uint16_t> chainBoneIndex;
+
+	size_t Size() const { return boneIndex.size(); }
+};
+
+struct PMDMorphTable
+{
+	std::vector<std::string> name;
+	std::vector<std::string> englishName;
+	std::vector<uint8_t> type;			// 0 は base
+	std::vector<uint32_t> vertexOffset;	// vertexIndex/positionOffset 内の開始位置
+	std::vector<uint32_t> vertexCount;
+	std::vector<uint32_t> vertexIndex;
+	std::vector<PMD::Float3> positionOffset;
+
+	size_t Size() const { return type.size(); }
+};
+
+struct PMDDisplayTable
+{
+	std::vector<uint16_t> skinIndex;			// 表情枠に表示する表情
+	std::vector<std::string> boneFrameName;
+	std::vector<std::string> boneFrameEnglishName;
+	std::vector<uint16_t> boneIndex;			// 表示枠に表示するボーン
+	std::vector<uint8_t> boneFrameIndex;
+};
+
+struct PMDModelData
+{
+	float version = 0.0f;
+	std::string modelName;
+	std::string comment;
+	std::string englishModelName;
+	std::string englishComment;
+
+	std::vector<uint16_t> indices;
+	PMDMaterialTable materials;
+	PMDBoneTable bones;
+	PMDIKTable iks;
+	PMDMorphTable morphs;
+	PMDDisplayTable display;
+	std::vector<std::string> toonTextureFileNames;	// 空または PMD::kToonTextureCount 個
+};
+
+///====================================================================
+/// <summary>
+/// 検証済みのリーダーから PMDModelData を構築します。
+/// </summary>
+/// <param name="reader">Open に成功した PMDMappedReader</param>
+/// <param name="outData">出力先</param>
+/// <returns>マテリアルのインデックス範囲がインデックス数に収まらない場合は false</returns>
+///====================================================================
+bool BuildPMDModelData(const PMDMappedReader& reader, PMDModelData& outData);
@@ -0,0 +1,670 @@
+﻿#include "PngDecoder.h"
+
+#include "Inflate.h"
+
+#include <cstring>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define PNG_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define PNG_HAS_SSE2 0
+#endif
+
+namespace
+{
+	constexpr uint8_t kSignature[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	constexpr uint32_t kIhdrSize = 13;
+
+	constexpr uint8_t kColorGray = 0;
+	constexpr uint8_t kColorRgb = 2;
+	constexpr uint8_t kColorPalette = 3;
+	constexpr uint8_t kColorGrayAlpha = 4;
+	constexpr uint8_t kColorRgba = 6;
+
+	enum Filter : uint8_t
+	{
+		FilterNone = 0,
+		FilterSub,
+		FilterUp,
+		FilterAverage,
+		FilterPaeth,
+	};
+
+	/// Adam7 の各パスの開始位置と間隔
+	constexpr uint32_t kAdam7StartX[7] = { 0, 4, 0, 2, 0, 1, 0 };
+	constexpr uint32_t kAdam7StartY[7] = { 0, 0, 4, 0, 2, 0, 1 };
+	constexpr uint32_t kAdam7StepX[7] = { 8, 8, 4, 4, 2, 2, 1 };
+	constexpr uint32_t kAdam7StepY[7] = { 8, 8, 8, 4, 4, 2, 2 };
+
+	bool Fail(std::string* outError, const char* message)
+	{
+		if (outError != nullptr)
+		{
+			*outError = message;
+		}
+		return false;
+	}
+
+	uint32_t ReadBE32(const uint8_t* p)
+	{
+		return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+	}
+	uint16_t ReadBE16(const uint8_t* p) { return static_cast<uint16_t>((p[0] << 8) | p[1]); }
+
+	struct PngImage
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint8_t bitDepth = 0;
+		uint8_t colorType = 0;
+		bool isInterlaced = false;
+
+		/// RGBA（PLTE に無い色は不透明の黒、アルファは tRNS）
+		uint8_t palette[256][4] = {};
+		bool hasPalette = false;
+		/// tRNS の透過色（グレーは [0] のみ）
+		bool hasTransparentColor = false;
+		bool hasPaletteAlpha = false;
+		uint16_t transparentColor[3] = {};
+
+		/// IDAT の範囲（ファイル内を指す）
+		std::vector<std::pair<const uint8_t*, size_t>> dataChunks;
+		size_t dataSize = 0;
+
+		uint32_t GetChannelCount() const
+		{
+			switch (colorType)
+			{
+			case kColorRgb: return 3;
+			case kColorGrayAlpha: return 2;
+			case kColorRgba: return 4;
+			default: return 1;
+			}
+		}
+		uint32_t GetBitsPerPixel() const { return GetChannelCount() * bitDepth; }
+		size_t GetRowBytes(uint32_t pixelCount) const { return (static_cast<size_t>(pixelCount) * GetBitsPerPixel() + 7) / 8; }
+		/// フィルターが参照する左隣までのバイト数
+		uint32_t GetFilterStride() const { return GetBitsPerPixel() >= 8 ? GetBitsPerPixel() / 8 : 1; }
+		bool HasAlpha() const { return colorType == kColorGrayAlpha || colorType == kColorRgba || hasTransparentColor || hasPaletteAlpha; }
+	};
+
+	bool IsValidDepth(uint8_t colorType, uint8_t bitDepth)
+	{
+		switch (colorType)
+		{
+		case kColorGray:
+			return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8 || bitDepth == 16;
+		case kColorPalette:
+			return bitDepth == 1 || bitDepth == 2 || bitDepth == 4 || bitDepth == 8;
+		case kColorRgb:
+		case kColorGrayAlpha:
+		case kColorRgba:
+			return bitDepth == 8 || bitDepth == 16;
+		default:
+			return false;
+		}
+	}
+
+	/// チャンクを読み、ヘッダー・パレット・透過色・IDAT の位置を集めます。
+	bool ParsePng(const uint8_t* data, size_t size, PngImage& outImage, std::string* outError)
+	{
+		if (size < sizeof(kSignature) || memcmp(data, kSignature, sizeof(kSignature)) != 0)
+		{
+			return Fail(outError, "not a PNG file");
+		}
+		PngImage& image = outImage;
+		for (uint32_t i = 0; i < 256; ++i)
+		{
+			image.palette[i][3] = 0xFF;
+		}
+
+		bool hasHeader = false;
+		size_t position = sizeof(kSignature);
+		for (;;)
+		{
+			if (size - position < 12)
+			{
+				return Fail(outError, "truncated PNG chunk");
+			}
+			const uint32_t length = ReadBE32(data + position);
+			const uint8_t* type = data + position + 4;
+			const uint8_t* body = data + position + 8;
+			if (length > size - position - 12)
+			{
+				return Fail(outError, "truncated PNG chunk");
+			}
+			position += 12 + static_cast<size_t>(length);
+
+			if (memcmp(type, "IHDR", 4) == 0)
+			{
+				if (hasHeader || length != kIhdrSize)
+				{
+					return Fail(outError, "invalid IHDR");
+				}
+				image.width = ReadBE32(body);
+				image.height = ReadBE32(body + 4);
+				image.bitDepth = body[8];
+				image.colorType = body[9];
+				image.isInterlaced = body[12] == 1;
+				if (image.width == 0 || image.height == 0 || image.width > IImageDecoder::kMaxDimension || image.height > IImageDecoder::kMaxDimension)
+				{
+					return Fail(outError, "invalid PNG dimensions");
+				}
+				if (!IsValidDepth(image.colorType, image.bitDepth) || body[10] != 0 || body[11] != 0 || body[12] > 1)
+				{
+					return Fail(outError, "unsupported PNG format");
+				}
+				hasHeader = true;
+				continue;
+			}
+			if (!hasHeader)
+			{
+				return Fail(outError, "IHDR must be the first chunk");
+			}
+
+			if (memcmp(type, "IDAT", 4) == 0)
+			{
+				if (length > 0)
+				{
+					image.dataChunks.emplace_back(body, length);
+					image.dataSize += length;
+				}
+			}
+			else if (memcmp(type, "PLTE", 4) == 0)
+			{
+				if (length % 3 != 0 || length / 3 > 256)
+				{
+					return Fail(outError, "invalid PLTE");
+				}
+				for (uint32_t i = 0; i < length / 3; ++i)
+				{
+					image.palette[i][0] = body[i * 3];
+					image.palette[i][1] = body[i * 3 + 1];
+					image.palette[i][2] = body[i * 3 + 2];
+				}
+				image.hasPalette = true;
+			}
+			else if (memcmp(type, "tRNS", 4) == 0)
+			{
+				if (image.colorType == kColorPalette)
+				{
+					for (uint32_t i = 0; i < length && i < 256; ++i)
+					{
+						image.palette[i][3] = body[i];
+					}
+					image.hasPaletteAlpha = length > 0;
+				}
+				else if (image.colorType == kColorGray && length >= 2)
+				{
+					image.transparentColor[0] = ReadBE16(body);
+					image.hasTransparentColor = true;
+				}
+				else if (image.colorType == kColorRgb && length >= 6)
+				{
+					image.transparentColor[0] = ReadBE16(body);
+					image.transparentColor[1] = ReadBE16(body + 2);
+					image.transparentColor[2] = ReadBE16(body + 4);
+					image.hasTransparentColor = true;
+				}
+			}
+			else if (memcmp(type, "IEND", 4) == 0)
+			{
+				break;
+			}
+			else if ((type[0] & 0x20) == 0)
+			{
+				// 知らない必須チャンク（Apple の CgBI など）
+				return Fail(outError, "unknown critical PNG chunk");
+			}
+		}
+
+		if (image.colorType == kColorPalette && !image.hasPalette)
+		{
+			return Fail(outError, "missing PLTE");
+		}
+		if (image.dataChunks.empty())
+		{
+			return Fail(outError, "missing IDAT");
+		}
+		return true;
+	}
+
+	///=================================================================
+	/// フィルターの復元（row は先頭のフィルター種別を除いた 1 行、prior は復元済みの前の行）
+	///=================================================================
+
+	uint8_t PaethPredictor(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = p > a ? p - a : a - p;
+		const int pb = p > b ? p - b : b - p;
+		const int pc = p > c ? p - c : c - p;
+		if (pa <= pb && pa <= pc)
+		{
+			return static_cast<uint8_t>(a);
+		}
+		return static_cast<uint8_t>(pb <= pc ? b : c);
+	}
+
+	void UnfilterRowScalar(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t length, uint32_t stride)
+	{
+		switch (filter)
+		{
+		case FilterSub:
+			for (size_t i = stride; i < length; ++i)
+			{
+				row[i] = static_cast<uint8_t>(row[i] + row[i - stride]);
+			}
+			break;
+		case FilterUp:
+			for (size_t i = 0; i < length; ++i)
+			{
+				row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+			}
+			break;
+		case FilterAverage:
+			for (size_t i = 0; i < stride; ++i)
+			{
+				row[i] = static_cast<uint8_t>(row[i] + (prior[i] >> 1));
+			}
+			for (size_t i = stride; i < length; ++i)
+			{
+				row[i] = static_cast<uint8_t>(row[i] + ((row[i - stride] + prior[i]) >> 1));
+			}
+			break;
+		case FilterPaeth:
+			for (size_t i = 0; i < stride; ++i)
+			{
+				row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+			}
+			for (size_t i = stride; i < length; ++i)
+			{
+				row[i] = static_cast<uint8_t>(row[i] + PaethPredictor(row[i - stride], prior[i], prior[i - stride]));
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+#if PNG_HAS_SSE2
+	// 左隣に依存するフィルター（Sub / Average / Paeth）は画素単位で順に進めるしかないので、
+	// 1 画素（3 / 4 バイト）を 1 レジスターに載せて全チャンネルを同時に計算します（libpng の filter_sse2 と同じ方針）。
+	template <uint32_t Stride>
+	__m128i LoadPixel(const uint8_t* p)
+	{
+		int32_t value = 0;
+		memcpy(&value, p, Stride);
+		return _mm_cvtsi32_si128(value);
+	}
+
+	template <uint32_t Stride>
+	void StorePixel(uint8_t* p, __m128i value)
+	{
+		const int32_t bits = _mm_cvtsi128_si32(value);
+		memcpy(p, &bits, Stride);
+	}
+
+	// 3 バイト画素も行の最後の画素以外は 4 バイトで読み書きします（3 バイトの memcpy は 2 回に分かれて遅い）。
+	// 4 バイト目に足す値を GetPixelMask で 0 にしておけば、次の画素の先頭バイトは元のまま書き戻ります。
+	__m128i LoadPixel4(const uint8_t* p)
+	{
+		return LoadPixel<4>(p);
+	}
+
+	void StorePixel4(uint8_t* p, __m128i value)
+	{
+		StorePixel<4>(p, value);
+	}
+
+	template <uint32_t Stride>
+	__m128i GetPixelMask()
+	{
+		return _mm_cvtsi32_si128(Stride == 4 ? -1 : 0x00FFFFFF);
+	}
+
+	void UnfilterUpSse2(uint8_t* row, const uint8_t* prior, size_t length)
+	{
+		size_t i = 0;
+		for (; i + 16 <= length; i += 16)
+		{
+			const __m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)),
+				_mm_loadu_si128(reinterpret_cast<const __m128i*>(prior + i)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), sum);
+		}
+		for (; i < length; ++i)
+		{
+			row[i] = static_cast<uint8_t>(row[i] + prior[i]);
+		}
+	}
+
+	template <uint32_t Stride>
+	void UnfilterSubSse2(uint8_t* row, size_t length)
+	{
+		const __m128i mask = GetPixelMask<Stride>();
+		__m128i a = _mm_setzero_si128();
+		size_t i = 0;
+		for (; i + 4 <= length; i += Stride)
+		{
+			a = _mm_add_epi8(LoadPixel4(row + i), a);
+			StorePixel4(row + i, a);
+			a = _mm_and_si128(a, mask);
+		}
+		for (; i < length; i += Stride)
+		{
+			a = _mm_add_epi8(LoadPixel<Stride>(row + i), a);
+			StorePixel<Stride>(row + i, a);
+		}
+	}
+
+	template <uint32_t Stride>
+	void UnfilterAverageSse2(uint8_t* row, const uint8_t* prior, size_t length)
+	{
+		const __m128i mask = GetPixelMask<Stride>();
+		const __m128i one = _mm_set1_epi8(1);
+		__m128i a = _mm_setzero_si128();
+		// avg_epu8 は切り上げるので、(a ^ b) の最下位ビットを引いて切り捨てにする
+		const auto average = [one](__m128i left, __m128i up)
+		{
+			return _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), one));
+		};
+		size_t i = 0;
+		for (; i + 4 <= length; i += Stride)
+		{
+			a = _mm_add_epi8(LoadPixel4(row + i), _mm_and_si128(average(a, LoadPixel4(prior + i)), mask));
+			StorePixel4(row + i, a);
+		}
+		for (; i < length; i += Stride)
+		{
+			a = _mm_add_epi8(LoadPixel<Stride>(row + i), average(a, LoadPixel<Stride>(prior + i)));
+			StorePixel<Stride>(row + i, a);
+		}
+	}
+
+	__m128i AbsEpi16(__m128i value)
+	{
+		return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+	}
+
+	__m128i Select(__m128i mask, __m128i ifTrue, __m128i ifFalse)
+	{
+		return _mm_or_si128(_mm_and_si128(mask, ifTrue), _mm_andnot_si128(mask, ifFalse));
+	}
+
+	/// a・b・c（16 ビットに広げた値）から Paeth の予測値を求める
+	__m128i PaethPredictorSse2(__m128i a, __m128i b, __m128i c)
+	{
+		// p - a = b - c、p - b = a - c、p - c = (b - c) + (a - c)
+		__m128i pa = _mm_sub_epi16(b, c);
+		__m128i pb = _mm_sub_epi16(a, c);
+		__m128i pc = _mm_add_epi16(pa, pb);
+		pa = AbsEpi16(pa);
+		pb = AbsEpi16(pb);
+		pc = AbsEpi16(pc);
+		const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+
+		// 同点なら a、b、c の順に選ぶ
+		return Select(_mm_cmpeq_epi16(smallest, pa), a, Select(_mm_cmpeq_epi16(smallest, pb), b, c));
+	}
+
+	template <uint32_t Stride>
+	void UnfilterPaethSse2(uint8_t* row, const uint8_t* prior, size_t length)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i mask = _mm_unpacklo_epi8(GetPixelMask<Stride>(), zero);
+		__m128i a = zero;
+		__m128i c = zero;
+		size_t i = 0;
+		for (; i + 4 <= length; i += Stride)
+		{
+			const __m128i b = _mm_unpacklo_epi8(LoadPixel4(prior + i), zero);
+			a = _mm_add_epi8(_mm_unpacklo_epi8(LoadPixel4(row + i), zero), _mm_and_si128(PaethPredictorSse2(a, b, c), mask));
+			StorePixel4(row + i, _mm_packus_epi16(a, a));
+			c = b;
+		}
+		for (; i < length; i += Stride)
+		{
+			const __m128i b = _mm_unpacklo_epi8(LoadPixel<Stride>(prior + i), zero);
+			a = _mm_add_epi8(_mm_unpacklo_epi8(LoadPixel<Stride>(row + i), zero), PaethPredictorSse2(a, b, c));
+			StorePixel<Stride>(row + i, _mm_packus_epi16(a, a));
+			c = b;
+		}
+	}
+
+	/// Sub / Average / Paeth を SSE2 で戻します。それ以外のフィルターなら false
+	template <uint32_t Stride>
+	bool UnfilterPixelsSse2(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t length)
+	{
+		switch (filter)
+		{
+		case FilterSub:
+			UnfilterSubSse2<Stride>(row, length);
+			return true;
+		case FilterAverage:
+			UnfilterAverageSse2<Stride>(row, prior, length);
+			return true;
+		case FilterPaeth:
+			UnfilterPaethSse2<Stride>(row, prior, length);
+			return true;
+		default:
+			return false;
+		}
+	}
+#endif
+
+	void UnfilterRow(uint8_t filter, uint8_t* row, const uint8_t* prior, size_t length, uint32_t stride, bool useSimd)
+	{
+#if PNG_HAS_SSE2
+		if (useSimd)
+		{
+			if (filter == FilterUp)
+			{
+				UnfilterUpSse2(row, prior, length);
+				return;
+			}
+			if ((stride == 4 && UnfilterPixelsSse2<4>(filter, row, prior, length)) ||
+				(stride == 3 && UnfilterPixelsSse2<3>(filter, row, prior, length)))
+			{
+				return;
+			}
+		}
+#else
+		(void)useSimd;
+#endif
+		UnfilterRowScalar(filter, row, prior, length, stride);
+	}
+
+	/// 8 ビット未満の x 番目のサンプル
+	uint32_t ReadSample(const uint8_t* row, uint32_t x, uint32_t bitDepth)
+	{
+		if (bitDepth == 8)
+		{
+			return row[x];
+		}
+		const uint32_t bitOffset = x * bitDepth;
+		return (row[bitOffset / 8] >> (8 - bitDepth - bitOffset % 8)) & ((1u << bitDepth) - 1);
+	}
+
+	/// フィルターを戻した 1 行を RGBA8 にします。
+	void ExpandRow(const PngImage& image, const uint8_t* row, uint32_t width, uint8_t* destination)
+	{
+		const bool is16Bit = image.bitDepth == 16;
+		switch (image.colorType)
+		{
+		case kColorRgba:
+			if (!is16Bit)
+			{
+				memcpy(destination, row, static_cast<size_t>(width) * 4);
+				break;
+			}
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				for (uint32_t channel = 0; channel < 4; ++channel)
+				{
+					destination[x * 4 + channel] = row[x * 8 + channel * 2];
+				}
+			}
+			break;
+		case kColorRgb:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				uint8_t* target = destination + x * 4;
+				uint16_t color[3];
+				for (uint32_t channel = 0; channel < 3; ++channel)
+				{
+					color[channel] = is16Bit ? ReadBE16(row + x * 6 + channel * 2) : row[x * 3 + channel];
+					target[channel] = static_cast<uint8_t>(is16Bit ? color[channel] >> 8 : color[channel]);
+				}
+				const bool isTransparent = image.hasTransparentColor && color[0] == image.transparentColor[0] &&
+					color[1] == image.transparentColor[1] && color[2] == image.transparentColor[2];
+				target[3] = isTransparent ? 0 : 0xFF;
+			}
+			break;
+		case kColorGrayAlpha:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint8_t gray = is16Bit ? row[x * 4] : row[x * 2];
+				const uint8_t alpha = is16Bit ? row[x * 4 + 2] : row[x * 2 + 1];
+				destination[x * 4] = gray;
+				destination[x * 4 + 1] = gray;
+				destination[x * 4 + 2] = gray;
+				destination[x * 4 + 3] = alpha;
+			}
+			break;
+		case kColorPalette:
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				memcpy(destination + x * 4, image.palette[ReadSample(row, x, image.bitDepth)], 4);
+			}
+			break;
+		default:
+		{
+			// 1/2/4 ビットは 0..255 に広げる（1 → 255、2 → 85、4 → 17 倍）
+			const uint32_t scale = is16Bit ? 1 : 255 / ((1u << image.bitDepth) - 1);
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				const uint32_t sample = is16Bit ? ReadBE16(row + x * 2) : ReadSample(row, x, image.bitDepth);
+				const uint8_t gray = static_cast<uint8_t>(is16Bit ? sample >> 8 : sample * scale);
+				destination[x * 4] = gray;
+				destination[x * 4 + 1] = gray;
+				destination[x * 4 + 2] = gray;
+				destination[x * 4 + 3] = image.hasTransparentColor && sample == image.transparentColor[0] ? 0 : 0xFF;
+			}
+			break;
+		}
+		}
+	}
+
+	/// パスの画素数（Adam7 でなければ画像全体）
+	void GetPassSize(const PngImage& image, uint32_t pass, uint32_t& outWidth, uint32_t& outHeight)
+	{
+		if (!image.isInterlaced)
+		{
+			outWidth = image.width;
+			outHeight = image.height;
+			return;
+		}
+		outWidth = image.width > kAdam7StartX[pass] ? (image.width - kAdam7StartX[pass] + kAdam7StepX[pass] - 1) / kAdam7StepX[pass] : 0;
+		outHeight = image.height > kAdam7StartY[pass] ? (image.height - kAdam7StartY[pass] + kAdam7StepY[pass] - 1) / kAdam7StepY[pass] : 0;
+	}
+}
+
+bool PngDecoder::CanDecode(const uint8_t* data, size_t size) const
+{
+	return size >= sizeof(kSignature) && memcmp(data, kSignature, sizeof(kSignature)) == 0;
+}
+
+bool PngDecoder::ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError) const
+{
+	PngImage image;
+	if (!ParsePng(data, size, image, outError))
+	{
+		return false;
+	}
+	outInfo.width = image.width;
+	outInfo.height = image.height;
+	outInfo.hasAlpha = image.HasAlpha();
+	return true;
+}
+
+bool PngDecoder::Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError) const
+{
+	PngImage image;
+	if (!ParsePng(data, size, image, outError))
+	{
+		return false;
+	}
+
+	const uint32_t passCount = image.isInterlaced ? 7 : 1;
+	size_t filteredSize = 0;
+	for (uint32_t pass = 0; pass < passCount; ++pass)
+	{
+		uint32_t passWidth = 0;
+		uint32_t passHeight = 0;
+		GetPassSize(image, pass, passWidth, passHeight);
+		if (passWidth > 0 && passHeight > 0)
+		{
+			filteredSize += (image.GetRowBytes(passWidth) + 1) * passHeight;
+		}
+	}
+
+	// IDAT が複数に分かれている場合だけつなげる（1 つならファイルから直接展開する）
+	std::vector<uint8_t> joined;
+	const uint8_t* compressed = image.dataChunks.front().first;
+	if (image.dataChunks.size() > 1)
+	{
+		joined.reserve(image.dataSize);
+		for (const auto& chunk : image.dataChunks)
+		{
+			joined.insert(joined.end(), chunk.first, chunk.first + chunk.second);
+		}
+		compressed = joined.data();
+	}
+	std::vector<uint8_t> filtered(filteredSize);
+	if (!Inflate::DecompressZlib(compressed, image.dataSize, filtered.data(), filtered.size(), outError))
+	{
+		return false;
+	}
+
+	const uint32_t stride = image.GetFilterStride();
+	const std::vector<uint8_t> zeroRow(image.GetRowBytes(image.width), 0);
+	std::vector<uint8_t> passPixels(image.isInterlaced ? static_cast<size_t>(image.width) * 4 : 0);
+	uint8_t* row = filtered.data();
+	for (uint32_t pass = 0; pass < passCount; ++pass)
+	{
+		uint32_t passWidth = 0;
+		uint32_t passHeight = 0;
+		GetPassSize(image, pass, passWidth, passHeight);
+		if (passWidth == 0 || passHeight == 0)
+		{
+			continue;
+		}
+		const size_t rowBytes = image.GetRowBytes(passWidth);
+		const uint8_t* prior = zeroRow.data();
+		for (uint32_t y = 0; y < passHeight; ++y, row += rowBytes + 1)
+		{
+			const uint8_t filter = row[0];
+			if (filter > FilterPaeth)
+			{
+				return Fail(outError, "invalid PNG filter type");
+			}
+			UnfilterRow(filter, row + 1, prior, rowBytes, stride, m_UseSimd);
+			prior = row + 1;
+
+			if (!image.isInterlaced)
+			{
+				ExpandRow(image, row + 1, passWidth, destination + y * rowPitch);
+				continue;
+			}
+			ExpandRow(image, row + 1, passWidth, passPixels.data());
+			uint8_t* target = destination + (kAdam7StartY[pass] + y * kAdam7StepY[pass]) * rowPitch + kAdam7StartX[pass] * 4;
+			for (uint32_t x = 0; x < passWidth; ++x, target += kAdam7StepX[pass] * 4)
+			{
+				memcpy(target, passPixels.data() + x * 4, 4);
+			}
+		}
+	}
+	return true;
+}
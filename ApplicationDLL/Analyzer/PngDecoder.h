@@ -0,0 +1,25 @@
+﻿#pragma once
+
+#include "ImageDecoder.h"
+
+///=======================================================================
+/// <summary>
+/// PNG（全カラータイプ、1/2/4/8/16 ビット、Adam7、tRNS）のデコーダー。
+/// IDAT は Inflate で展開し、フィルターの復元は 3 / 4 バイト画素と Up を SSE2 で行います。
+/// 16 ビットのチャンネルは上位 8 ビットに丸めます。チャンクの CRC は確かめません（zlib の Adler-32 で壊れは分かります）。
+/// </summary>
+///=======================================================================
+class PngDecoder final : public IImageDecoder
+{
+public:
+	/// useSimd が false ならフィルターの復元をスカラーで行います（比較用）。
+	explicit PngDecoder(bool useSimd = true) : m_UseSimd(useSimd) {}
+
+	const char* GetName() const override { return "png"; }
+	bool CanDecode(const uint8_t* data, size_t size) const override;
+	bool ReadInfo(const uint8_t* data, size_t size, ImageInfo& outInfo, std::string* outError = nullptr) const override;
+	bool Decode(const uint8_t* data, size_t size, uint8_t* destination, size_t rowPitch, std::string* outError = nullptr) const override;
+
+private:
+	bool m_UseSimd = true;
+};
@@ -0,0 +1,450 @@
+﻿#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	constexpr uint32_t kManifestVersion = 1;
+
+	uint32_t AlignUp(uint32_t value, uint32_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	uint32_t NextPowerOfTwo(uint32_t value)
+	{
+		uint32_t result = 1;
+		while (result < value)
+		{
+			result <<= 1;
+		}
+		return result;
+	}
+
+	bool Intersects(const TextureAtlas::Rect& a, const TextureAtlas::Rect& b)
+	{
+		return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+	}
+
+	bool Contains(const TextureAtlas::Rect& outer, const TextureAtlas::Rect& inner)
+	{
+		return inner.x >= outer.x && inner.y >= outer.y &&
+			inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+	}
+
+	/// 行の残り（先頭の空白を除く）を取り出します。名前に空白を含められるよう最後に置く
+	std::string ReadRest(std::istringstream& stream)
+	{
+		std::string rest;
+		std::getline(stream, rest);
+		const size_t first = rest.find_first_not_of(" \t");
+		return first == std::string::npos ? std::string() : rest.substr(first);
+	}
+}
+
+namespace TextureAtlas
+{
+	void MaxRectsPacker::Reset(uint32_t width, uint32_t height)
+	{
+		m_FreeRects.clear();
+		m_FreeRects.push_back({ 0, 0, width, height });
+		m_UsedWidth = 0;
+		m_UsedHeight = 0;
+	}
+
+	bool MaxRectsPacker::Insert(uint32_t width, uint32_t height, Rect& outRect)
+	{
+		// 短辺の余りが最小（同じなら長辺の余りが最小）の空き矩形の左上に置く
+		uint32_t bestShortSide = UINT32_MAX;
+		uint32_t bestLongSide = UINT32_MAX;
+		const Rect* best = nullptr;
+		for (const Rect& freeRect : m_FreeRects)
+		{
+			if (freeRect.width < width || freeRect.height < height)
+			{
+				continue;
+			}
+			const uint32_t leftoverX = freeRect.width - width;
+			const uint32_t leftoverY = freeRect.height - height;
+			const uint32_t shortSide = (std::min)(leftoverX, leftoverY);
+			const uint32_t longSide = (std::max)(leftoverX, leftoverY);
+			if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+			{
+				bestShortSide = shortSide;
+				bestLongSide = longSide;
+				best = &freeRect;
+			}
+		}
+		if (best == nullptr)
+		{
+			return false;
+		}
+
+		outRect = { best->x, best->y, width, height };
+		SplitFreeRects(outRect);
+		PruneFreeRects();
+		m_UsedWidth = (std::max)(m_UsedWidth, outRect.x + width);
+		m_UsedHeight = (std::max)(m_UsedHeight, outRect.y + height);
+		return true;
+	}
+
+	/// 配置した矩形と重なる空き矩形を、重ならない最大 4 つの矩形に置き換えます。
+	void MaxRectsPacker::SplitFreeRects(const Rect& placed)
+	{
+		std::vector<Rect> next;
+		next.reserve(m_FreeRects.size() + 4);
+		for (const Rect& freeRect : m_FreeRects)
+		{
+			if (!Intersects(freeRect, placed))
+			{
+				next.push_back(freeRect);
+				continue;
+			}
+			const uint32_t freeRight = freeRect.x + freeRect.width;
+			const uint32_t freeBottom = freeRect.y + freeRect.height;
+			const uint32_t placedRight = placed.x + placed.width;
+			const uint32_t placedBottom = placed.y + placed.height;
+			if (placed.x > freeRect.x)
+			{
+				next.push_back({ freeRect.x, freeRect.y, placed.x - freeRect.x, freeRect.height });
+			}
+			if (placedRight < freeRight)
+			{
+				next.push_back({ placedRight, freeRect.y, freeRight - placedRight, freeRect.height });
+			}
+			if (placed.y > freeRect.y)
+			{
+				next.push_back({ freeRect.x, freeRect.y, freeRect.width, placed.y - freeRect.y });
+			}
+			if (placedBottom < freeBottom)
+			{
+				next.push_back({ freeRect.x, placedBottom, freeRect.width, freeBottom - placedBottom });
+			}
+		}
+		m_FreeRects.swap(next);
+	}
+
+	/// 他の空き矩形に含まれるものを取り除きます。
+	void MaxRectsPacker::PruneFreeRects()
+	{
+		for (size_t i = 0; i < m_FreeRects.size(); ++i)
+		{
+			for (size_t j = i + 1; j < m_FreeRects.size(); )
+			{
+				if (Contains(m_FreeRects[i], m_FreeRects[j]))
+				{
+					m_FreeRects.erase(m_FreeRects.begin() + j);
+					continue;
+				}
+				if (Contains(m_FreeRects[j], m_FreeRects[i]))
+				{
+					m_FreeRects.erase(m_FreeRects.begin() + i);
+					--i;
+					break;
+				}
+				++j;
+			}
+		}
+	}
+
+	uint32_t GetSafeMipCount(uint32_t padding, uint32_t blockSize)
+	{
+		// ミップ L のガターは padding / 2^L テクセルで、配置も同じ境界にそろっている。
+		// ガターがブロック 1 つ分（非圧縮なら 1 テクセル）残る段までを使う
+		blockSize = (std::max)(blockSize, 1u);
+		uint32_t count = 1;
+		while ((padding >> count) >= blockSize)
+		{
+			++count;
+		}
+		return count;
+	}
+
+	Atlas Build(const std::vector<std::string>& names, const std::vector<const Image*>& images, const Settings& settings)
+	{
+		Atlas atlas;
+		const uint32_t padding = (std::max)(settings.padding, 1u);
+		// ページは 2 の累乗にするので、pageSize を超えない最大の 2 の累乗が上限
+		uint32_t maxPageSize = 1;
+		while (maxPageSize * 2 <= settings.pageSize)
+		{
+			maxPageSize *= 2;
+		}
+
+		struct Item
+		{
+			size_t index;
+			uint32_t width;		// ガターと境界合わせを含むサイズ
+			uint32_t height;
+		};
+		std::vector<Item> items;
+		for (size_t i = 0; i < images.size() && i < names.size(); ++i)
+		{
+			const Image* image = images[i];
+			if (image == nullptr || image->width == 0 || image->height == 0 ||
+				image->pixels.size() < static_cast<size_t>(image->width) * image->height * 4 ||
+				image->width > settings.maxSpriteSize || image->height > settings.maxSpriteSize)
+			{
+				atlas.rejected.push_back(names[i]);
+				continue;
+			}
+			const Item item = { i, AlignUp(image->width + padding * 2, padding), AlignUp(image->height + padding * 2, padding) };
+			if (item.width > maxPageSize || item.height > maxPageSize)
+			{
+				atlas.rejected.push_back(names[i]);
+				continue;
+			}
+			items.push_back(item);
+		}
+
+		// 長辺の大きいものから詰めると隙間が少ない
+		std::stable_sort(items.begin(), items.end(), [](const Item& a, const Item& b)
+		{
+			const uint32_t longA = (std::max)(a.width, a.height);
+			const uint32_t longB = (std::max)(b.width, b.height);
+			if (longA != longB)
+			{
+				return longA > longB;
+			}
+			return static_cast<uint64_t>(a.width) * a.height > static_cast<uint64_t>(b.width) * b.height;
+		});
+
+		struct Packed
+		{
+			size_t index;
+			uint32_t page;
+			Rect padded;
+		};
+		// ページごとに、残りがすべて収まる最小の 2 の累乗のサイズを探す。
+		// どのサイズにも収まらなければ最大サイズのページに入るだけ入れ、残りを次のページへ回す
+		std::vector<std::pair<uint32_t, uint32_t>> pageSizes;
+		for (uint32_t width = 1; width <= maxPageSize; width <<= 1)
+		{
+			for (uint32_t height = 1; height <= maxPageSize; height <<= 1)
+			{
+				pageSizes.emplace_back(width, height);
+			}
+		}
+		std::sort(pageSizes.begin(), pageSizes.end(), [](const auto& a, const auto& b)
+		{
+			const uint64_t areaA = static_cast<uint64_t>(a.first) * a.second;
+			const uint64_t areaB = static_cast<uint64_t>(b.first) * b.second;
+			if (areaA != areaB)
+			{
+				return areaA < areaB;
+			}
+			// 同じ面積なら正方形に近いもの
+			return (std::max)(a.first, a.second) < (std::max)(b.first, b.second);
+		});
+
+		std::vector<Packed> packed;
+		std::vector<Item> remaining = std::move(items);
+		while (!remaining.empty())
+		{
+			const uint32_t page = static_cast<uint32_t>(atlas.pages.size());
+			uint64_t remainingArea = 0;
+			for (const Item& item : remaining)
+			{
+				remainingArea += static_cast<uint64_t>(item.width) * item.height;
+			}
+
+			MaxRectsPacker packer;
+			std::vector<Packed> pagePacked;
+			std::vector<Item> leftover;
+			for (const auto& size : pageSizes)
+			{
+				// 残りの面積がどのサイズよりも大きい場合も、最大サイズのページには入るだけ入れる
+				const bool isLargest = &size == &pageSizes.back();
+				if (!isLargest && static_cast<uint64_t>(size.first) * size.second < remainingArea)
+				{
+					continue;
+				}
+				packer.Reset(size.first, size.second);
+				pagePacked.clear();
+				leftover.clear();
+				for (const Item& item : remaining)
+				{
+					Rect rect;
+					if (packer.Insert(item.width, item.height, rect))
+					{
+						pagePacked.push_back({ item.index, page, rect });
+					}
+					else if (isLargest)
+					{
+						leftover.push_back(item);
+					}
+					else
+					{
+						break;
+					}
+				}
+				if (isLargest || pagePacked.size() == remaining.size())
+				{
+					break;
+				}
+			}
+
+			// ページは使った範囲を覆う 2 の累乗まで縮める（ミップの各段で縦横が割り切れるように）
+			Image image;
+			image.width = NextPowerOfTwo(packer.GetUsedWidth());
+			image.height = NextPowerOfTwo(packer.GetUsedHeight());
+			image.pixels.assign(static_cast<size_t>(image.width) * image.height * 4, 0);
+			atlas.statistics.pageTexels += static_cast<uint64_t>(image.width) * image.height;
+			atlas.pages.push_back(std::move(image));
+			packed.insert(packed.end(), pagePacked.begin(), pagePacked.end());
+			remaining.swap(leftover);
+		}
+		std::sort(packed.begin(), packed.end(), [](const Packed& a, const Packed& b) { return a.index < b.index; });
+
+		for (const Packed& item : packed)
+		{
+			const Image& source = *images[item.index];
+			Image& page = atlas.pages[item.page];
+
+			// ガターを含む範囲すべてを、本体の最も近いテクセルで埋める
+			for (uint32_t y = 0; y < item.padded.height; ++y)
+			{
+				const int64_t sourceY = std::clamp<int64_t>(static_cast<int64_t>(y) - padding, 0, source.height - 1);
+				const uint8_t* sourceRow = &source.pixels[static_cast<size_t>(sourceY) * source.width * 4];
+				uint8_t* targetRow = &page.pixels[(static_cast<size_t>(item.padded.y + y) * page.width + item.padded.x) * 4];
+				for (uint32_t x = 0; x < item.padded.width; ++x)
+				{
+					const int64_t sourceX = std::clamp<int64_t>(static_cast<int64_t>(x) - padding, 0, source.width - 1);
+					std::copy_n(sourceRow + sourceX * 4, 4, targetRow + static_cast<size_t>(x) * 4);
+				}
+			}
+
+			Placement placement;
+			placement.name = names[item.index];
+			placement.page = item.page;
+			placement.rect = { item.padded.x + padding, item.padded.y + padding, source.width, source.height };
+			atlas.placements.push_back(std::move(placement));
+			atlas.statistics.spriteTexels += static_cast<uint64_t>(source.width) * source.height;
+		}
+		atlas.statistics.spriteCount = atlas.placements.size();
+		atlas.statistics.rejectedCount = atlas.rejected.size();
+		// 入力のスプライトは、どれかのページに置かれるか rejected に入る
+		assert(atlas.placements.size() + atlas.rejected.size() == (std::min)(images.size(), names.size()));
+		return atlas;
+	}
+
+	void GetUvRect(const Placement& placement, uint32_t pageWidth, uint32_t pageHeight, float outUv[4])
+	{
+		const float width = static_cast<float>((std::max)(pageWidth, 1u));
+		const float height = static_cast<float>((std::max)(pageHeight, 1u));
+		outUv[0] = static_cast<float>(placement.rect.x) / width;
+		outUv[1] = static_cast<float>(placement.rect.y) / height;
+		outUv[2] = static_cast<float>(placement.rect.x + placement.rect.width) / width;
+		outUv[3] = static_cast<float>(placement.rect.y + placement.rect.height) / height;
+	}
+
+	///====================================================================
+	/// <summary>
+	/// 定義ファイルを書き出します。1 行 1 項目のテキストで、名前は行末に置きます。
+	///   atlas 1
+	///   page  幅 高さ ファイル名
+	///   sprite ページ x y 幅 高さ 名前
+	/// </summary>
+	///====================================================================
+	bool SaveManifest(const std::filesystem::path& path, const Manifest& manifest)
+	{
+		std::ofstream stream(path, std::ios::trunc);
+		if (!stream)
+		{
+			return false;
+		}
+		stream << "atlas " << kManifestVersion << "\n";
+		for (const Manifest::Page& page : manifest.pages)
+		{
+			stream << "page " << page.width << " " << page.height << " " << page.fileName << "\n";
+		}
+		for (const Placement& placement : manifest.placements)
+		{
+			stream << "sprite " << placement.page << " " << placement.rect.x << " " << placement.rect.y << " "
+				<< placement.rect.width << " " << placement.rect.height << " " << placement.name << "\n";
+		}
+		return static_cast<bool>(stream);
+	}
+
+	bool LoadManifest(const std::filesystem::path& path, Manifest& outManifest)
+	{
+		outManifest = Manifest();
+		std::ifstream stream(path);
+		if (!stream)
+		{
+			return false;
+		}
+
+		std::string line;
+		bool hasHeader = false;
+		while (std::getline(stream, line))
+		{
+			std::istringstream fields(line);
+			std::string kind;
+			if (!(fields >> kind))
+			{
+				continue;
+			}
+			if (kind == "atlas")
+			{
+				uint32_t version = 0;
+				if (!(fields >> version) || version != kManifestVersion)
+				{
+					return false;
+				}
+				hasHeader = true;
+			}
+			else if (kind == "page")
+			{
+				Manifest::Page page;
+				if (!(fields >> page.width >> page.height))
+				{
+					return false;
+				}
+				page.fileName = ReadRest(fields);
+				outManifest.pages.push_back(std::move(page));
+			}
+			else if (kind == "sprite")
+			{
+				Placement placement;
+				if (!(fields >> placement.page >> placement.rect.x >> placement.rect.y >> placement.rect.width >> placement.rect.height))
+				{
+					return false;
+				}
+				placement.name = ReadRest(fields);
+				outManifest.placements.push_back(std::move(placement));
+			}
+		}
+
+		if (!hasHeader)
+		{
+			return false;
+		}
+		// ページ外を指すものは壊れた定義として扱う
+		for (const Placement& placement : outManifest.placements)
+		{
+			if (placement.page >= outManifest.pages.size() ||
+				placement.rect.x + placement.rect.width > outManifest.pages[placement.page].width ||
+				placement.rect.y + placement.rect.height > outManifest.pages[placement.page].height)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string GetSpriteKey(const std::string& path)
+	{
+		const size_t separator = path.find_last_of("/\\");
+		std::string key = separator == std::string::npos ? path : path.substr(separator + 1);
+		// Windows のパスは大文字と小文字を区別しない
+		std::transform(key.begin(), key.end(), key.begin(), [](char c)
+		{
+			return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+		});
+		return key;
+	}
+}
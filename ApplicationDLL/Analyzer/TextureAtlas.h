@@ -0,0 +1,141 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// 小さなテクスチャーを共有のページ（アトラス）に詰めるパッカー。
+/// 配置は MaxRects（短辺の余りが最小の空き矩形を選ぶ）で、各スプライトの周りには
+/// 縁のテクセルを引き伸ばしたガターを置きます。位置とサイズをガターの幅にそろえるため、
+/// ガターが 1 テクセル以上残るミップの段までは隣へにじみません（GetSafeMipCount）。
+/// 実行時（TextureAssetManager::AcquireAtlas）とオフライン（TextureCooker --atlas）で共用します。
+/// </summary>
+///=======================================================================
+namespace TextureAtlas
+{
+	/// オフラインで作ったアトラスの定義ファイルの拡張子
+	constexpr const char* kManifestExtension = ".atlas";
+
+	/// RGBA8 を詰めて格納した画像（rowPitch = width * 4）
+	struct Image
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;
+	};
+
+	struct Rect
+	{
+		uint32_t x = 0;
+		uint32_t y = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	struct Settings
+	{
+		/// ページの最大サイズ（各ページは中身が収まる最小の 2 の累乗のサイズにします）
+		uint32_t pageSize = 2048;
+		/// ガターの幅（2 の累乗）。配置もこの境界にそろえる
+		uint32_t padding = 8;
+		/// これより大きいテクスチャーはアトラスに入れず単独で読み込む
+		uint32_t maxSpriteSize = 512;
+	};
+
+	/// スプライト 1 つの配置（rect はガターを含まない本体の範囲）
+	struct Placement
+	{
+		std::string name;
+		uint32_t page = 0;
+		Rect rect;
+	};
+
+	struct Statistics
+	{
+		size_t spriteCount = 0;
+		/// 大きすぎる・空などの理由で詰めなかった数
+		size_t rejectedCount = 0;
+		uint64_t spriteTexels = 0;	// スプライト本体の合計
+		uint64_t pageTexels = 0;	// ページの合計
+
+		/// ページのうちスプライト本体が占める割合
+		double GetOccupancy() const { return pageTexels > 0 ? static_cast<double>(spriteTexels) / static_cast<double>(pageTexels) : 0.0; }
+	};
+
+	struct Atlas
+	{
+		std::vector<Image> pages;
+		std::vector<Placement> placements;
+		/// 詰めなかったもの（入力の名前）
+		std::vector<std::string> rejected;
+		Statistics statistics;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// MaxRects による矩形の配置。配置したものは動かしません。
+	/// </summary>
+	///====================================================================
+	class MaxRectsPacker
+	{
+	public:
+		void Reset(uint32_t width, uint32_t height);
+		/// 収まる場所が無ければ false
+		bool Insert(uint32_t width, uint32_t height, Rect& outRect);
+		/// これまでに配置した矩形が覆う範囲の右端と下端
+		uint32_t GetUsedWidth() const { return m_UsedWidth; }
+		uint32_t GetUsedHeight() const { return m_UsedHeight; }
+
+	private:
+		void SplitFreeRects(const Rect& placed);
+		void PruneFreeRects();
+
+		std::vector<Rect> m_FreeRects;
+		uint32_t m_UsedWidth = 0;
+		uint32_t m_UsedHeight = 0;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// ガターの幅から、隣のスプライトがにじまないミップの段数を求めます。
+	/// ブロック圧縮する場合は、ブロックが 2 つのスプライトにまたがらない段までにします。
+	/// </summary>
+	/// <param name="blockSize">圧縮ブロックの幅（非圧縮は 1、BC は 4）</param>
+	///====================================================================
+	uint32_t GetSafeMipCount(uint32_t padding, uint32_t blockSize = 1);
+
+	///====================================================================
+	/// <summary>
+	/// 画像をページに詰め、ページの画素を作ります。大きいものから順に入れ、
+	/// 最大サイズのページに収まらなかったものは次のページへ回します。
+	/// </summary>
+	/// <param name="names">画像ごとの名前（Placement::name になる）</param>
+	/// <param name="images">names と同じ順の画像（null は詰めない）</param>
+	///====================================================================
+	Atlas Build(const std::vector<std::string>& names, const std::vector<const Image*>& images, const Settings& settings);
+
+	/// 配置からページ内の UV（u0, v0, u1, v1）を求めます。
+	void GetUvRect(const Placement& placement, uint32_t pageWidth, uint32_t pageHeight, float outUv[4]);
+
+	/// 定義ファイルの内容（ページの画像ファイルは定義ファイルからの相対パス）
+	struct Manifest
+	{
+		struct Page
+		{
+			std::string fileName;
+			uint32_t width = 0;
+			uint32_t height = 0;
+		};
+		std::vector<Page> pages;
+		std::vector<Placement> placements;
+	};
+
+	bool SaveManifest(const std::filesystem::path& path, const Manifest& manifest);
+	bool LoadManifest(const std::filesystem::path& path, Manifest& outManifest);
+	/// 名前の比較に使うキー（ディレクトリを除いたファイル名）
+	std::string GetSpriteKey(const std::string& path);
+}
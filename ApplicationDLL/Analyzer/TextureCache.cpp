@@ -0,0 +1,465 @@
+﻿#include "TextureCache.h"
+#include "../System/ContentHash.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kKeyDigits = 16;
+
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	/// "<16 桁の 16 進数>" 形式のファイル名をキーに戻します。
+	bool ParseKey(const std::wstring& stem, uint64_t& outKey)
+	{
+		if (stem.size() != kKeyDigits)
+		{
+			return false;
+		}
+		uint64_t key = 0;
+		for (wchar_t c : stem)
+		{
+			uint64_t digit = 0;
+			if (c >= L'0' && c <= L'9')
+			{
+				digit = static_cast<uint64_t>(c - L'0');
+			}
+			else if (c >= L'a' && c <= L'f')
+			{
+				digit = static_cast<uint64_t>(c - L'a' + 10);
+			}
+			else
+			{
+				return false;
+			}
+			key = (key << 4) | digit;
+		}
+		outKey = key;
+		return true;
+	}
+
+	double ToMegabytes(uint64_t bytes)
+	{
+		return static_cast<double>(bytes) / (1024.0 * 1024.0);
+	}
+}
+
+///====================================================================
+/// <summary>
+/// キャッシュエントリーをマップし、ヘッダーと各ミップの範囲を検証します。
+/// ペイロードのハッシュ照合は全体を読むため、ここでは行いません。
+/// </summary>
+/// <param name="filePath">.texc ファイルのパス</param>
+/// <returns>成功した場合は true</returns>
+///====================================================================
+bool CachedTextureFile::Open(const std::filesystem::path& filePath)
+{
+	Close();
+
+	if (!m_File.Open(filePath))
+	{
+		return Fail("failed to map file");
+	}
+	if (m_File.GetSize() < sizeof(TextureCacheFormat::CachedTextureHeader))
+	{
+		return Fail("file is too small for cached texture header");
+	}
+
+	const auto* header = reinterpret_cast<const TextureCacheFormat::CachedTextureHeader*>(m_File.GetData());
+	if (header->magic != TextureCacheFormat::kMagic)
+	{
+		return Fail("invalid cached texture signature");
+	}
+	if (header->version != TextureCacheFormat::kVersion ||
+		header->headerSize != sizeof(TextureCacheFormat::CachedTextureHeader) ||
+		header->mipStride != sizeof(TextureCacheFormat::CachedMip))
+	{
+		return Fail("cached texture version mismatch");
+	}
+	if (header->fileSize != m_File.GetSize())
+	{
+		return Fail("cached texture size mismatch");
+	}
+
+	const uint64_t fileSize = m_File.GetSize();
+	const uint64_t tableSize = static_cast<uint64_t>(header->mipCount) * sizeof(TextureCacheFormat::CachedMip);
+	if (header->mipCount == 0 || tableSize > fileSize - header->headerSize)
+	{
+		return Fail("cached texture mip table is out of range");
+	}
+
+	const auto* mips = reinterpret_cast<const TextureCacheFormat::CachedMip*>(m_File.GetData() + header->headerSize);
+	for (uint32_t i = 0; i < header->mipCount; ++i)
+	{
+		if (mips[i].offset % TextureCacheFormat::kPayloadAlignment != 0 || mips[i].offset > fileSize ||
+			mips[i].slicePitch > fileSize - mips[i].offset)
+		{
+			return Fail("cached texture mip is out of range");
+		}
+	}
+
+	m_pHeader = header;
+	m_pMips = mips;
+	m_IsValid = true;
+	return true;
+}
+
+void CachedTextureFile::Close()
+{
+	m_File.Close();
+	m_IsValid = false;
+	m_LastError.clear();
+	m_pHeader = nullptr;
+	m_pMips = nullptr;
+}
+
+bool CachedTextureFile::VerifyPayloadHash() const
+{
+	if (!m_IsValid)
+	{
+		return false;
+	}
+	const size_t headerSize = sizeof(TextureCacheFormat::CachedTextureHeader);
+	return ContentHash::Compute(m_File.GetData() + headerSize, m_File.GetSize() - headerSize) == m_pHeader->payloadHash;
+}
+
+bool CachedTextureFile::Fail(const char* message)
+{
+	Close();
+	m_LastError = message;
+	return false;
+}
+
+TextureCache& TextureCache::Get()
+{
+	static TextureCache instance;
+	return instance;
+}
+
+bool TextureCache::Open(const std::filesystem::path& directory, uint64_t maxBytes)
+{
+	Close();
+
+	std::error_code ec;
+	std::filesystem::create_directories(directory, ec);
+	if (!std::filesystem::is_directory(directory, ec))
+	{
+		return false;
+	}
+
+	struct FoundEntry
+	{
+		uint64_t key;
+		uint64_t bytes;
+		std::filesystem::file_time_type lastWrite;
+	};
+	std::vector<FoundEntry> found;
+	for (const auto& item : std::filesystem::directory_iterator(directory, ec))
+	{
+		if (!item.is_regular_file(ec))
+		{
+			continue;
+		}
+		const std::filesystem::path& path = item.path();
+		if (path.extension() == L".tmp")
+		{
+			// 前回の書き込み途中で終了したもの
+			std::filesystem::remove(path, ec);
+			continue;
+		}
+		uint64_t key = 0;
+		if (path.extension() != kEntryExtension || !ParseKey(path.stem().wstring(), key))
+		{
+			continue;
+		}
+		FoundEntry entry = { key, static_cast<uint64_t>(item.file_size(ec)), item.last_write_time(ec) };
+		found.push_back(entry);
+	}
+
+	// 更新日時（= 最後に使った時刻）の古い順に使用順を振り直す
+	std::sort(found.begin(), found.end(), [](const FoundEntry& a, const FoundEntry& b)
+	{
+		return a.lastWrite < b.lastWrite;
+	});
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Directory = directory;
+	m_MaxBytes = maxBytes;
+	for (const FoundEntry& item : found)
+	{
+		Entry& entry = m_Entries[item.key];
+		entry.bytes = item.bytes;
+		entry.lastUse = ++m_UseCounter;
+		m_TotalBytes += item.bytes;
+	}
+	m_IsOpen = true;
+	EvictLocked(0);
+	return true;
+}
+
+void TextureCache::Close()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_IsOpen = false;
+	m_Directory.clear();
+	m_Entries.clear();
+	m_TotalBytes = 0;
+	m_UseCounter = 0;
+}
+
+bool TextureCache::IsOpen() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_IsOpen;
+}
+
+uint64_t TextureCache::ComputeKey(const void* sourceData, size_t sourceSize, uint64_t settingsHash)
+{
+	// レイアウトが変わったら別のキーになるようバージョンも混ぜる
+	uint64_t hash = ContentHash::Compute(&TextureCacheFormat::kVersion, sizeof(TextureCacheFormat::kVersion));
+	hash = ContentHash::Compute(&settingsHash, sizeof(settingsHash), hash);
+	return ContentHash::Compute(sourceData, sourceSize, hash);
+}
+
+bool TextureCache::Lookup(uint64_t key, CachedTextureFile& outFile)
+{
+	outFile.Close();
+
+	std::filesystem::path path;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_IsOpen)
+		{
+			return false;
+		}
+		if (m_Entries.find(key) == m_Entries.end())
+		{
+			++m_Statistics.misses;
+			return false;
+		}
+		path = GetEntryPath(key);
+	}
+
+	// 使用順を次回の起動に残す（他のスレッドがマップ中で失敗しても構わない）
+	std::error_code ec;
+	std::filesystem::last_write_time(path, std::filesystem::file_time_type::clock::now(), ec);
+
+	const bool isValid = outFile.Open(path) && outFile.GetHeader().key == key;
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const auto it = m_Entries.find(key);
+	if (!isValid)
+	{
+		// 壊れている、または外部で消されたエントリーは登録から外して作り直させる
+		outFile.Close();
+		if (it != m_Entries.end())
+		{
+			m_TotalBytes -= it->second.bytes;
+			m_Entries.erase(it);
+		}
+		std::filesystem::remove(path, ec);
+		++m_Statistics.misses;
+		return false;
+	}
+
+	if (it != m_Entries.end())
+	{
+		it->second.lastUse = ++m_UseCounter;
+	}
+	++m_Statistics.hits;
+	m_Statistics.hitBytes += outFile.GetFileSize();
+	return true;
+}
+
+bool TextureCache::Store(uint64_t key, uint32_t format, uint32_t width, uint32_t height, const MipData* mips, uint32_t mipCount)
+{
+	if (mips == nullptr || mipCount == 0)
+	{
+		return false;
+	}
+
+	// ヘッダー・ミップ表・各ミップ（境界にそろえる）の順に 1 つのバッファへ並べる
+	const size_t headerSize = sizeof(TextureCacheFormat::CachedTextureHeader);
+	uint64_t fileSize = headerSize + static_cast<uint64_t>(mipCount) * sizeof(TextureCacheFormat::CachedMip);
+	std::vector<TextureCacheFormat::CachedMip> table(mipCount);
+	for (uint32_t i = 0; i < mipCount; ++i)
+	{
+		if (mips[i].pixels == nullptr)
+		{
+			return false;
+		}
+		fileSize = AlignUp(fileSize, TextureCacheFormat::kPayloadAlignment);
+		table[i].offset = fileSize;
+		table[i].slicePitch = mips[i].slicePitch;
+		table[i].rowPitch = static_cast<uint32_t>(mips[i].rowPitch);
+		table[i].width = mips[i].width;
+		table[i].height = mips[i].height;
+		table[i].reserved = 0;
+		fileSize += mips[i].slicePitch;
+	}
+
+	std::vector<uint8_t> blob(static_cast<size_t>(fileSize), 0);
+	std::memcpy(blob.data() + headerSize, table.data(), table.size() * sizeof(TextureCacheFormat::CachedMip));
+	for (uint32_t i = 0; i < mipCount; ++i)
+	{
+		std::memcpy(blob.data() + table[i].offset, mips[i].pixels, mips[i].slicePitch);
+	}
+
+	auto* header = reinterpret_cast<TextureCacheFormat::CachedTextureHeader*>(blob.data());
+	header->magic = TextureCacheFormat::kMagic;
+	header->version = TextureCacheFormat::kVersion;
+	header->headerSize = static_cast<uint32_t>(headerSize);
+	header->mipStride = sizeof(TextureCacheFormat::CachedMip);
+	header->key = key;
+	header->payloadHash = ContentHash::Compute(blob.data() + headerSize, blob.size() - headerSize);
+	header->fileSize = fileSize;
+	header->format = format;
+	header->width = width;
+	header->height = height;
+	header->mipCount = mipCount;
+
+	std::filesystem::path entryPath;
+	std::filesystem::path tempPath;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_IsOpen)
+		{
+			return false;
+		}
+		entryPath = GetEntryPath(key);
+		// 同じ内容のテクスチャーを別のワーカーが同時に保存しても衝突しないよう番号を付ける
+		tempPath = entryPath;
+		tempPath += L"." + std::to_wstring(++m_TempCounter) + L".tmp";
+	}
+
+	{
+		std::ofstream stream(tempPath, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(blob.data()), static_cast<std::streamsize>(blob.size()));
+		if (!stream)
+		{
+			stream.close();
+			std::error_code ec;
+			std::filesystem::remove(tempPath, ec);
+			return false;
+		}
+	}
+
+	std::error_code ec;
+	std::filesystem::rename(tempPath, entryPath, ec);
+	if (ec)
+	{
+		// 既存のエントリーがマップ中で置き換えられない場合など。中身は同じなのでそのまま使う
+		std::filesystem::remove(tempPath, ec);
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (!m_IsOpen)
+	{
+		return false;
+	}
+	Entry& entry = m_Entries[key];
+	m_TotalBytes -= entry.bytes;
+	entry.bytes = fileSize;
+	entry.lastUse = ++m_UseCounter;
+	m_TotalBytes += fileSize;
+	++m_Statistics.stores;
+	EvictLocked(key);
+	return true;
+}
+
+void TextureCache::SetMaxBytes(uint64_t maxBytes)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_MaxBytes = maxBytes;
+	if (m_IsOpen)
+	{
+		EvictLocked(0);
+	}
+}
+
+TextureCache::Statistics TextureCache::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Statistics statistics = m_Statistics;
+	statistics.entryCount = m_Entries.size();
+	statistics.totalBytes = m_TotalBytes;
+	statistics.maxBytes = m_MaxBytes;
+	return statistics;
+}
+
+void TextureCache::ResetStatistics()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Statistics = Statistics();
+}
+
+std::string TextureCache::FormatReport() const
+{
+	const Statistics statistics = GetStatistics();
+	const uint64_t lookups = statistics.hits + statistics.misses;
+	const double hitRate = lookups > 0 ? 100.0 * static_cast<double>(statistics.hits) / static_cast<double>(lookups) : 0.0;
+
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer),
+		"texture cache: %llu hits / %llu misses (%.1f%%, %.1f MB read), %llu stored, %llu evicted, %zu entries %.1f / %.1f MB",
+		static_cast<unsigned long long>(statistics.hits), static_cast<unsigned long long>(statistics.misses), hitRate,
+		ToMegabytes(statistics.hitBytes), static_cast<unsigned long long>(statistics.stores),
+		static_cast<unsigned long long>(statistics.evictions), statistics.entryCount,
+		ToMegabytes(statistics.totalBytes), ToMegabytes(statistics.maxBytes));
+	return buffer;
+}
+
+std::filesystem::path TextureCache::GetEntryPath(uint64_t key) const
+{
+	char name[kKeyDigits + 1];
+	std::snprintf(name, sizeof(name), "%016llx", static_cast<unsigned long long>(key));
+	std::filesystem::path path = m_Directory / name;
+	path += kEntryExtension;
+	return path;
+}
+
+void TextureCache::EvictLocked(uint64_t keepKey)
+{
+	if (m_TotalBytes <= m_MaxBytes)
+	{
+		return;
+	}
+
+	std::vector<std::pair<uint64_t, uint64_t>> candidates;	// (lastUse, key)
+	candidates.reserve(m_Entries.size());
+	for (const auto& [key, entry] : m_Entries)
+	{
+		if (key != keepKey)
+		{
+			candidates.emplace_back(entry.lastUse, key);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end());
+
+	for (const auto& [lastUse, key] : candidates)
+	{
+		if (m_TotalBytes <= m_MaxBytes)
+		{
+			break;
+		}
+		// マップ中のエントリー（Windows）は消せないので次に回す
+		std::error_code ec;
+		if (!std::filesystem::remove(GetEntryPath(key), ec) && ec)
+		{
+			continue;
+		}
+		const auto it = m_Entries.find(key);
+		m_TotalBytes -= it->second.bytes;
+		m_Entries.erase(it);
+		++m_Statistics.evictions;
+	}
+}
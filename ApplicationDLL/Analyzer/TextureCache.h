@@ -0,0 +1,157 @@
+﻿#pragma once
+
+#include "MappedFile.h"
+#include "TextureCacheFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+///=======================================================================
+/// <summary>
+/// キャッシュエントリー（.texc）をメモリマップして参照します。
+/// Open 時にヘッダーとミップの範囲を検証するだけで、ピクセルは
+/// コピーせずにマップ領域をそのまま GPU への転送元として使えます。
+/// </summary>
+///=======================================================================
+class CachedTextureFile
+{
+public:
+	bool Open(const std::filesystem::path& filePath);
+	void Close();
+
+	bool IsValid() const { return m_IsValid; }
+	const std::string& GetLastError() const { return m_LastError; }
+
+	/// ペイロード全体を読み直してハッシュを照合します（ツール用）。
+	bool VerifyPayloadHash() const;
+
+	const TextureCacheFormat::CachedTextureHeader& GetHeader() const { return *m_pHeader; }
+	const TextureCacheFormat::CachedMip& GetMip(uint32_t mip) const { return m_pMips[mip]; }
+	const uint8_t* GetMipPixels(uint32_t mip) const { return m_File.GetData() + m_pMips[mip].offset; }
+	uint32_t GetMipCount() const { return m_IsValid ? m_pHeader->mipCount : 0; }
+	/// マップしているファイル全体のバイト数
+	size_t GetFileSize() const { return m_File.GetSize(); }
+
+private:
+	bool Fail(const char* message);
+
+	MappedFile m_File;
+	bool m_IsValid = false;
+	std::string m_LastError;
+
+	const TextureCacheFormat::CachedTextureHeader* m_pHeader = nullptr;
+	const TextureCacheFormat::CachedMip* m_pMips = nullptr;
+};
+
+///=======================================================================
+/// <summary>
+/// 元データの内容とインポート設定のハッシュをキーにした、ディスク上のテクスチャキャッシュ。
+/// 1 エントリー 1 ファイル（"<キー 16 桁>.texc"）で、合計サイズが上限を超えると
+/// 最後に使ってから最も長いエントリーから削除します。使用順はファイルの更新日時に
+/// 残すため、再起動後も引き継がれます。ワーカースレッドから同時に呼び出せます。
+/// </summary>
+///=======================================================================
+class TextureCache
+{
+public:
+	static constexpr const wchar_t* kEntryExtension = L".texc";
+	static constexpr uint64_t kDefaultMaxBytes = 512ull * 1024 * 1024;
+
+	/// Store に渡すミップ 1 段分のピクセル
+	struct MipData
+	{
+		const void* pixels = nullptr;
+		size_t rowPitch = 0;
+		size_t slicePitch = 0;
+		uint32_t width = 0;
+		uint32_t height = 0;
+	};
+
+	struct Statistics
+	{
+		uint64_t hits = 0;
+		uint64_t misses = 0;
+		uint64_t stores = 0;
+		uint64_t evictions = 0;
+		/// ヒットしたエントリーのバイト数の合計
+		uint64_t hitBytes = 0;
+		/// 現在キャッシュにあるエントリーの数と合計バイト数
+		size_t entryCount = 0;
+		uint64_t totalBytes = 0;
+		uint64_t maxBytes = 0;
+	};
+
+	static TextureCache& Get();
+
+	TextureCache(const TextureCache&) = delete;
+	TextureCache& operator=(const TextureCache&) = delete;
+
+	///====================================================================
+	/// <summary>
+	/// キャッシュディレクトリを開き（なければ作成）、既存のエントリーを登録します。
+	/// 書きかけの一時ファイルは削除し、上限を超えていれば古いものから追い出します。
+	/// </summary>
+	/// <param name="directory">キャッシュディレクトリ</param>
+	/// <param name="maxBytes">エントリーの合計サイズの上限</param>
+	///====================================================================
+	bool Open(const std::filesystem::path& directory, uint64_t maxBytes = kDefaultMaxBytes);
+	void Close();
+	bool IsOpen() const;
+
+	/// 元データのバイト列とインポート設定のハッシュからキーを作ります。
+	static uint64_t ComputeKey(const void* sourceData, size_t sourceSize, uint64_t settingsHash);
+
+	///====================================================================
+	/// <summary>
+	/// キーに対応するエントリーをマップします。ヒット・ミスを統計に数え、
+	/// ヒットしたエントリーは最近使ったものとして扱います。
+	/// </summary>
+	/// <returns>ヒットして outFile が有効になった場合は true</returns>
+	///====================================================================
+	bool Lookup(uint64_t key, CachedTextureFile& outFile);
+
+	///====================================================================
+	/// <summary>
+	/// GPU に転送できる形のピクセルを保存します。一時ファイルに書いてから置き換えるため、
+	/// 書き込み中のエントリーが Lookup で見えることはありません。
+	/// </summary>
+	/// <param name="format">DXGI_FORMAT の値</param>
+	/// <param name="mips">ミップ 0 から順に mipCount 段</param>
+	///====================================================================
+	bool Store(uint64_t key, uint32_t format, uint32_t width, uint32_t height, const MipData* mips, uint32_t mipCount);
+
+	/// 上限を変え、超えていればすぐに追い出します。
+	void SetMaxBytes(uint64_t maxBytes);
+
+	Statistics GetStatistics() const;
+	void ResetStatistics();
+	/// ヒット率などを 1 行にまとめたもの（ログ用）
+	std::string FormatReport() const;
+
+private:
+	TextureCache() = default;
+
+	struct Entry
+	{
+		uint64_t bytes = 0;
+		uint64_t lastUse = 0;
+	};
+
+	std::filesystem::path GetEntryPath(uint64_t key) const;
+	/// 合計が上限以下になるまで、使用順の古いものから削除します（keepKey は残す。0 ならすべてが対象）。
+	void EvictLocked(uint64_t keepKey);
+
+	mutable std::mutex m_Mutex;
+	std::filesystem::path m_Directory;
+	bool m_IsOpen = false;
+	uint64_t m_MaxBytes = kDefaultMaxBytes;
+	uint64_t m_TotalBytes = 0;
+	uint64_t m_UseCounter = 0;
+	uint64_t m_TempCounter = 0;
+	std::unordered_map<uint64_t, Entry> m_Entries;
+	Statistics m_Statistics;
+};
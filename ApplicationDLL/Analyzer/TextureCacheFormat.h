@@ -0,0 +1,55 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+///=======================================================================
+/// TextureCache が保存するキャッシュエントリー（.texc）のディスクレイアウト。
+/// ピクセルは GPU に転送できる形（ミップ生成・圧縮済み）で格納し、
+/// ファイルをマップしたまま各ミップを転送元として使えるようにします。
+///
+///   [CachedTextureHeader]
+///   [CachedMip × mipCount]
+///   [ミップ 0 のピクセル]  ← 各ミップは kPayloadAlignment 境界から
+///   [ミップ 1 のピクセル]
+///   ...
+///=======================================================================
+namespace TextureCacheFormat
+{
+	constexpr uint32_t kMagic = 0x43584554;	// "TEXC"
+	constexpr uint32_t kVersion = 1;
+	/// D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT と同じ。アップロードバッファへそのまま写せる
+	constexpr size_t kPayloadAlignment = 512;
+
+	/// ミップ 1 段分の配置
+	struct CachedMip
+	{
+		uint64_t offset;		// ファイル先頭からの位置
+		uint64_t slicePitch;	// ミップ全体のバイト数
+		uint32_t rowPitch;		// 1 行（ブロック圧縮ならブロック 1 行）のバイト数
+		uint32_t width;
+		uint32_t height;
+		uint32_t reserved;
+	};
+
+	struct CachedTextureHeader
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t headerSize;
+		uint32_t mipStride;
+
+		uint64_t key;			// 元データとインポート設定のハッシュ（ファイル名と同じ）
+		uint64_t payloadHash;	// ヘッダー以降のデータのハッシュ
+		uint64_t fileSize;
+
+		uint32_t format;		// DXGI_FORMAT の値
+		uint32_t width;
+		uint32_t height;
+		uint32_t mipCount;
+		uint64_t reserved;
+	};
+
+	static_assert(sizeof(CachedMip) == 32, "CachedMip must be 32 bytes");
+	static_assert(sizeof(CachedTextureHeader) % 16 == 0, "CachedTextureHeader must keep the mip table aligned");
+}
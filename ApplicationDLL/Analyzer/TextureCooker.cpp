@@ -0,0 +1,344 @@
+﻿#include "TextureCooker.h"
+#include "../System/ContentHash.h"
+
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+namespace
+{
+	/// クックに使った設定の記録。.dds の DDS_HEADER::reserved1（DWORD 11 個、ファイルの先頭から 32 バイト目）に置く。
+	/// DirectXTex は読み込みでこの領域を見ない（reserved1[9] の NVTT の印だけは避ける）
+	struct CookRecord
+	{
+		uint32_t tag;
+		uint32_t compression;
+		uint32_t mipFilter;
+		uint32_t isSrgb;
+		uint32_t highQuality;
+		uint32_t maxMipCount;
+		/// ComputeSettingsHash の下位 32 ビットと上位 32 ビット
+		uint32_t settingsHash[2];
+	};
+	static_assert(sizeof(CookRecord) <= 9 * sizeof(uint32_t), "CookRecord must stay in front of reserved1[9]");
+
+	constexpr uint32_t kCookRecordTag = 0x4B435854u;	// "TXCK"
+	constexpr size_t kDdsHeaderSizeOffset = 4;
+	constexpr uint32_t kDdsHeaderSize = 124;
+	constexpr size_t kCookRecordOffset = 32;
+
+	bool SetError(std::string* outError, const char* message)
+	{
+		if (outError != nullptr)
+		{
+			*outError = message;
+		}
+		return false;
+	}
+
+	double MillisecondsSince(std::chrono::steady_clock::time_point begin)
+	{
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	bool HasTranslucentTexel(const DirectX::Image& image)
+	{
+		for (size_t y = 0; y < image.height; ++y)
+		{
+			const uint8_t* row = image.pixels + y * image.rowPitch;
+			for (size_t x = 0; x < image.width; ++x)
+			{
+				if (row[x * 4 + 3] != 0xFF)
+				{
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	DXGI_FORMAT SelectFormat(const TextureCooker::Settings& settings, bool hasAlpha)
+	{
+		switch (settings.compression)
+		{
+		case TextureCooker::Compression::None:	return DXGI_FORMAT_R8G8B8A8_UNORM;
+		case TextureCooker::Compression::BC1:	return DXGI_FORMAT_BC1_UNORM;
+		case TextureCooker::Compression::BC3:	return DXGI_FORMAT_BC3_UNORM;
+		case TextureCooker::Compression::BC4:	return DXGI_FORMAT_BC4_UNORM;
+		case TextureCooker::Compression::BC5:	return DXGI_FORMAT_BC5_UNORM;
+		case TextureCooker::Compression::BC7:	return DXGI_FORMAT_BC7_UNORM;
+		case TextureCooker::Compression::Auto:
+		default:
+			if (!hasAlpha)
+			{
+				return DXGI_FORMAT_BC1_UNORM;
+			}
+			return settings.highQuality ? DXGI_FORMAT_BC7_UNORM : DXGI_FORMAT_BC3_UNORM;
+		}
+	}
+
+	bool IsCookedNewer(const std::filesystem::path& sourcePath)
+	{
+		std::error_code ec;
+		const auto cookedTime = std::filesystem::last_write_time(TextureCooker::GetCookedPath(sourcePath), ec);
+		if (ec)
+		{
+			return false;
+		}
+		const auto sourceTime = std::filesystem::last_write_time(sourcePath, ec);
+		return !ec && cookedTime >= sourceTime;
+	}
+
+	/// 記録のない .dds（他のツールで作ったもの、記録を入れる前のもの）は false
+	bool ReadCookRecord(const std::filesystem::path& cookedPath, TextureCooker::Settings& outSettings, uint64_t& outSettingsHash)
+	{
+		uint8_t header[kCookRecordOffset + sizeof(CookRecord)];
+		std::ifstream file(cookedPath, std::ios::binary);
+		if (!file.read(reinterpret_cast<char*>(header), sizeof(header)))
+		{
+			return false;
+		}
+		uint32_t headerSize = 0;
+		std::memcpy(&headerSize, header + kDdsHeaderSizeOffset, sizeof(headerSize));
+		CookRecord record;
+		std::memcpy(&record, header + kCookRecordOffset, sizeof(record));
+		if (std::memcmp(header, "DDS ", 4) != 0 || headerSize != kDdsHeaderSize || record.tag != kCookRecordTag)
+		{
+			return false;
+		}
+
+		outSettings.compression = static_cast<TextureCooker::Compression>(record.compression);
+		outSettings.mipFilter = static_cast<TextureMips::Filter>(record.mipFilter);
+		outSettings.isSrgb = record.isSrgb != 0;
+		outSettings.highQuality = record.highQuality != 0;
+		outSettings.maxMipCount = record.maxMipCount;
+		outSettingsHash = (static_cast<uint64_t>(record.settingsHash[1]) << 32) | record.settingsHash[0];
+		return true;
+	}
+}
+
+namespace TextureCooker
+{
+	std::filesystem::path GetCookedPath(const std::filesystem::path& sourcePath)
+	{
+		std::filesystem::path cookedPath = sourcePath;
+		cookedPath += kCookedExtension;
+		return cookedPath;
+	}
+
+	bool IsCookedUpToDate(const std::filesystem::path& sourcePath)
+	{
+		// 記録した設定を今のコードでハッシュし直し、Kaiser の係数などが変わっていれば古いとみなす
+		Settings recordedSettings;
+		uint64_t recordedHash = 0;
+		return IsCookedNewer(sourcePath) && ReadCookRecord(GetCookedPath(sourcePath), recordedSettings, recordedHash) &&
+			recordedHash == ComputeSettingsHash(recordedSettings);
+	}
+
+	bool IsCookedUpToDate(const std::filesystem::path& sourcePath, const Settings& settings)
+	{
+		Settings recordedSettings;
+		uint64_t recordedHash = 0;
+		return IsCookedNewer(sourcePath) && ReadCookRecord(GetCookedPath(sourcePath), recordedSettings, recordedHash) &&
+			recordedHash == ComputeSettingsHash(settings);
+	}
+
+	uint64_t ComputeSettingsHash(const Settings& settings)
+	{
+		// 構造体のパディングを含めないよう、値を 1 つずつ並べてからハッシュする。
+		// Kaiser フィルタの係数を変えた場合も作り直されるよう定数も含める
+		uint32_t values[7] = {
+			static_cast<uint32_t>(settings.compression),
+			static_cast<uint32_t>(settings.mipFilter),
+			settings.isSrgb ? 1u : 0u,
+			settings.highQuality ? 1u : 0u,
+			settings.maxMipCount,
+		};
+		std::memcpy(&values[5], &TextureMips::kKaiserWidth, sizeof(float));
+		std::memcpy(&values[6], &TextureMips::kKaiserAlpha, sizeof(float));
+		return ContentHash::Compute(values, sizeof(values));
+	}
+
+	double GetBytesPerTexel(DXGI_FORMAT format)
+	{
+		return static_cast<double>(DirectX::BitsPerPixel(format)) / 8.0;
+	}
+
+	bool Cook(const DirectX::ScratchImage& source, const Settings& settings, DirectX::ScratchImage& outCooked,
+		CookStatistics* outStats, std::string* outError)
+	{
+		const DirectX::Image* sourceImage = source.GetImage(0, 0, 0);
+		if (sourceImage == nullptr)
+		{
+			return SetError(outError, "source image is empty");
+		}
+
+		// フィルタは RGBA8 で行うので、それ以外のフォーマットは先に変換する
+		DirectX::ScratchImage converted;
+		if (DirectX::IsCompressed(sourceImage->format))
+		{
+			if (FAILED(DirectX::Decompress(*sourceImage, DXGI_FORMAT_R8G8B8A8_UNORM, converted)))
+			{
+				return SetError(outError, "failed to decompress source image");
+			}
+			sourceImage = converted.GetImage(0, 0, 0);
+		}
+		else if (sourceImage->format != DXGI_FORMAT_R8G8B8A8_UNORM)
+		{
+			if (FAILED(DirectX::Convert(*sourceImage, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted)))
+			{
+				return SetError(outError, "failed to convert source image to RGBA8");
+			}
+			sourceImage = converted.GetImage(0, 0, 0);
+		}
+
+		const uint32_t width = static_cast<uint32_t>(sourceImage->width);
+		const uint32_t height = static_cast<uint32_t>(sourceImage->height);
+		DXGI_FORMAT format = SelectFormat(settings, HasTranslucentTexel(*sourceImage));
+		if (DirectX::IsCompressed(format) && (width % 4 != 0 || height % 4 != 0))
+		{
+			format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		}
+		// BC4/BC5 はデータとして扱い、ミップも線形のままフィルタする
+		const bool isSrgb = settings.isSrgb && format != DXGI_FORMAT_BC4_UNORM && format != DXGI_FORMAT_BC5_UNORM;
+
+		const auto mipBegin = std::chrono::steady_clock::now();
+		std::vector<TextureMips::Level> levels = TextureMips::Generate(sourceImage->pixels, width, height, sourceImage->rowPitch, settings.mipFilter, isSrgb);
+		if (settings.maxMipCount > 0 && levels.size() > settings.maxMipCount)
+		{
+			levels.resize(settings.maxMipCount);
+		}
+		DirectX::ScratchImage mipmapped;
+		if (levels.empty() || FAILED(mipmapped.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, levels.size())))
+		{
+			return SetError(outError, "failed to allocate mip chain");
+		}
+		for (size_t mip = 0; mip < levels.size(); ++mip)
+		{
+			const DirectX::Image* target = mipmapped.GetImage(mip, 0, 0);
+			const size_t packedPitch = static_cast<size_t>(levels[mip].width) * 4;
+			for (uint32_t y = 0; y < levels[mip].height; ++y)
+			{
+				std::memcpy(target->pixels + y * target->rowPitch, &levels[mip].pixels[y * packedPitch], packedPitch);
+			}
+		}
+		const double mipMilliseconds = MillisecondsSince(mipBegin);
+
+		const auto encodeBegin = std::chrono::steady_clock::now();
+		if (DirectX::IsCompressed(format))
+		{
+			const HRESULT hr = DirectX::Compress(mipmapped.GetImages(), mipmapped.GetImageCount(), mipmapped.GetMetadata(),
+				format, DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, outCooked);
+			if (FAILED(hr))
+			{
+				return SetError(outError, "block compression failed");
+			}
+		}
+		else
+		{
+			outCooked = std::move(mipmapped);
+		}
+		const double encodeMilliseconds = MillisecondsSince(encodeBegin);
+
+		if (outStats != nullptr)
+		{
+			outStats->format = format;
+			outStats->width = width;
+			outStats->height = height;
+			outStats->mipCount = static_cast<uint32_t>(levels.size());
+			outStats->uncompressedBytes = static_cast<size_t>(width) * height * 4;
+			outStats->cookedBytes = outCooked.GetPixelsSize();
+			outStats->mipMilliseconds = mipMilliseconds;
+			outStats->encodeMilliseconds = encodeMilliseconds;
+		}
+		return true;
+	}
+
+	ImageDecodeStatus DecodeSourceImage(const std::filesystem::path& sourcePath, DirectX::ScratchImage& outImage, std::string* outError)
+	{
+		// 大きさが分かった時点で ScratchImage を確保し、デコーダーにその画素へ書かせる
+		const auto allocate = [&outImage](const ImageInfo& info, size_t& outRowPitch) -> uint8_t*
+		{
+			if (FAILED(outImage.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, info.width, info.height, 1, 1)))
+			{
+				return nullptr;
+			}
+			const DirectX::Image* image = outImage.GetImage(0, 0, 0);
+			outRowPitch = image->rowPitch;
+			return image->pixels;
+		};
+		return ImageDecoderRegistry::Get().DecodeFile(sourcePath, allocate, outError);
+	}
+
+	bool LoadSourceImage(const std::filesystem::path& sourcePath, DirectX::ScratchImage& outImage, std::string* outError)
+	{
+		if (DecodeSourceImage(sourcePath, outImage, nullptr) == ImageDecodeStatus::Decoded)
+		{
+			return true;
+		}
+		outImage.Release();
+		if (FAILED(DirectX::LoadFromWICFile(sourcePath.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, outImage)))
+		{
+			return SetError(outError, "failed to decode source image");
+		}
+		return true;
+	}
+
+	bool CookFile(const std::filesystem::path& sourcePath, const Settings& settings, CookStatistics* outStats, std::string* outError)
+	{
+		DirectX::ScratchImage source;
+		if (!LoadSourceImage(sourcePath, source, outError))
+		{
+			return false;
+		}
+
+		DirectX::ScratchImage cooked;
+		if (!Cook(source, settings, cooked, outStats, outError))
+		{
+			return false;
+		}
+		return SaveCookedFile(cooked, settings, GetCookedPath(sourcePath), outError);
+	}
+
+	bool SaveCookedFile(const DirectX::ScratchImage& cooked, const Settings& settings, const std::filesystem::path& cookedPath, std::string* outError)
+	{
+		DirectX::Blob blob;
+		if (FAILED(DirectX::SaveToDDSMemory(cooked.GetImages(), cooked.GetImageCount(), cooked.GetMetadata(), DirectX::DDS_FLAGS_NONE, blob)) ||
+			blob.GetBufferSize() < kCookRecordOffset + sizeof(CookRecord))
+		{
+			return SetError(outError, "failed to encode cooked texture");
+		}
+
+		const uint64_t settingsHash = ComputeSettingsHash(settings);
+		CookRecord record = {};
+		record.tag = kCookRecordTag;
+		record.compression = static_cast<uint32_t>(settings.compression);
+		record.mipFilter = static_cast<uint32_t>(settings.mipFilter);
+		record.isSrgb = settings.isSrgb ? 1u : 0u;
+		record.highQuality = settings.highQuality ? 1u : 0u;
+		record.maxMipCount = settings.maxMipCount;
+		record.settingsHash[0] = static_cast<uint32_t>(settingsHash);
+		record.settingsHash[1] = static_cast<uint32_t>(settingsHash >> 32);
+		std::memcpy(blob.GetBufferPointer() + kCookRecordOffset, &record, sizeof(record));
+
+		// 書き込み途中のファイルを読ませないよう、一時ファイルに書いてから置き換える
+		std::filesystem::path tempPath = cookedPath;
+		tempPath += L".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.write(reinterpret_cast<const char*>(blob.GetConstBufferPointer()), static_cast<std::streamsize>(blob.GetBufferSize())))
+			{
+				return SetError(outError, "failed to write cooked texture");
+			}
+		}
+		std::error_code ec;
+		std::filesystem::rename(tempPath, cookedPath, ec);
+		if (ec)
+		{
+			std::filesystem::remove(tempPath, ec);
+			return SetError(outError, "failed to replace cooked texture");
+		}
+		return true;
+	}
+}
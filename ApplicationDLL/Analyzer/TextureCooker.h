@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include "ImageDecoder.h"
+#include "TextureMips.h"
+
+#include <DirectXTex.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+///=======================================================================
+/// <summary>
+/// テクスチャのクック（ミップ生成 + ブロック圧縮）。
+/// 結果は元ファイルの隣に「元のファイル名 + .dds」で保存し、実行時は
+/// TextureManager が元ファイルより新しい .dds を優先して読み込みます。
+/// .dds のヘッダーの予約領域にクックの設定とそのハッシュを記録し、設定が変わった .dds は古いとみなします。
+/// 圧縮は DirectXTex の CPU エンコーダーを使います。
+/// </summary>
+///=======================================================================
+namespace TextureCooker
+{
+	/// クック済みテクスチャの拡張子（元の拡張子の後ろに付けます）
+	constexpr const wchar_t* kCookedExtension = L".dds";
+
+	enum class Compression
+	{
+		Auto,		// アルファがなければ BC1、あれば BC3（highQuality の場合は BC7）
+		None,		// RGBA8 のまま（ミップのみ）
+		BC1,
+		BC3,
+		BC4,		// 1 チャンネルのデータ（R）
+		BC5,		// 2 チャンネルのデータ（RG、法線など）
+		BC7,
+	};
+
+	struct Settings
+	{
+		Compression compression = Compression::Auto;
+		TextureMips::Filter mipFilter = TextureMips::Filter::Kaiser;
+		/// 色として sRGB 空間で扱うか（BC4/BC5 のデータは常に線形）
+		bool isSrgb = true;
+		/// Auto でアルファがある場合に BC3 ではなく BC7 を使う
+		bool highQuality = false;
+		/// ミップの段数の上限（0 なら 1x1 まで）。アトラスのページはガターが残る段までにする
+		uint32_t maxMipCount = 0;
+	};
+
+	struct CookStatistics
+	{
+		DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+		uint32_t width = 0;
+		uint32_t height = 0;
+		uint32_t mipCount = 0;
+		/// 元画像を RGBA8・ミップなしで置いた場合のバイト数
+		size_t uncompressedBytes = 0;
+		/// クック後のピクセルデータのバイト数（全ミップ）
+		size_t cookedBytes = 0;
+		double mipMilliseconds = 0.0;
+		double encodeMilliseconds = 0.0;
+	};
+
+	/// クック済みファイルのパス（"a.png" → "a.png.dds"）
+	std::filesystem::path GetCookedPath(const std::filesystem::path& sourcePath);
+	/// クック済みファイルがあり、元ファイルより新しく、記録した設定のハッシュが今のコードで計算し直した値と同じか
+	/// （設定は問わない。実行時はツールで選んだフォーマットのまま使う）
+	bool IsCookedUpToDate(const std::filesystem::path& sourcePath);
+	/// 上に加えて、settings でクックしたものか（ツールが作り直すかどうかの判定）
+	bool IsCookedUpToDate(const std::filesystem::path& sourcePath, const Settings& settings);
+
+	/// 設定のハッシュ（TextureCache のキーに混ぜ、設定を変えたら別エントリーにする）
+	uint64_t ComputeSettingsHash(const Settings& settings);
+
+	/// 1 テクセルあたりのバイト数（ブロック圧縮は 4x4 ブロックを均した値）
+	double GetBytesPerTexel(DXGI_FORMAT format);
+
+	///====================================================================
+	/// <summary>
+	/// デコード済みの画像からミップを生成して圧縮します。
+	/// ブロック圧縮は最上位のサイズが 4 の倍数である必要があるため、
+	/// そうでない画像は RGBA8 のミップチェーンにします。
+	/// </summary>
+	/// <param name="source">元画像（どのフォーマットでも可、最初のイメージのみ使用）</param>
+	/// <param name="outCooked">出力先</param>
+	/// <param name="outStats">サイズと処理時間（任意）</param>
+	/// <param name="outError">失敗時の理由（任意）</param>
+	///====================================================================
+	bool Cook(const DirectX::ScratchImage& source, const Settings& settings, DirectX::ScratchImage& outCooked,
+		CookStatistics* outStats = nullptr, std::string* outError = nullptr);
+
+	///====================================================================
+	/// <summary>
+	/// 組み込みのデコーダー（PNG / BMP / TGA）で、RGBA8 で確保した outImage のメモリへ直接デコードします。
+	/// WIC も COM も使わないので、どのスレッドからでも呼べます。
+	/// </summary>
+	/// <returns>組み込みのデコーダーが扱えない形式（JPEG など）なら Unsupported</returns>
+	///====================================================================
+	ImageDecodeStatus DecodeSourceImage(const std::filesystem::path& sourcePath, DirectX::ScratchImage& outImage, std::string* outError = nullptr);
+
+	/// DecodeSourceImage で読めなければ WIC で読み込みます（COM は呼び出し側で初期化すること）。
+	bool LoadSourceImage(const std::filesystem::path& sourcePath, DirectX::ScratchImage& outImage, std::string* outError = nullptr);
+
+	/// LoadSourceImage で読み込んでクックし、GetCookedPath に保存します（COM は呼び出し側で初期化すること）。
+	bool CookFile(const std::filesystem::path& sourcePath, const Settings& settings,
+		CookStatistics* outStats = nullptr, std::string* outError = nullptr);
+
+	/// クックした画像を、settings の記録を付けて cookedPath に保存します（一時ファイルに書いてから置き換えます）。
+	bool SaveCookedFile(const DirectX::ScratchImage& cooked, const Settings& settings, const std::filesystem::path& cookedPath,
+		std::string* outError = nullptr);
+}
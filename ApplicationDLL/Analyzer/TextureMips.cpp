@@ -0,0 +1,263 @@
+﻿#include "TextureMips.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	constexpr float kPi = 3.14159265358979f;
+
+	/// RGBA（色はアルファを乗算済み、線形）の float 画像
+	struct FloatImage
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<float> texels;
+	};
+
+	/// 1 つの出力ピクセルが参照する入力の範囲と重み
+	struct FilterTaps
+	{
+		std::vector<uint32_t> first;	// 出力ピクセルごとの先頭の入力位置（端で詰めたもの）
+		std::vector<uint32_t> count;
+		std::vector<uint32_t> offset;	// weights / sources 内の開始位置
+		std::vector<uint32_t> sources;
+		std::vector<float> weights;
+	};
+
+	float SrgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	float LinearToSrgb(float value)
+	{
+		return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+	}
+
+	/// 第 1 種変形ベッセル関数 I0（級数展開）
+	float BesselI0(float x)
+	{
+		const float quarterSq = 0.25f * x * x;
+		float sum = 1.0f;
+		float term = 1.0f;
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= quarterSq / static_cast<float>(k * k);
+			sum += term;
+			if (term < sum * 1.0e-7f)
+			{
+				break;
+			}
+		}
+		return sum;
+	}
+
+	float Sinc(float x)
+	{
+		if (std::fabs(x) < 1.0e-6f)
+		{
+			return 1.0f;
+		}
+		return std::sin(kPi * x) / (kPi * x);
+	}
+
+	float KaiserWeight(float x)
+	{
+		const float ratio = x / TextureMips::kKaiserWidth;
+		if (ratio <= -1.0f || ratio >= 1.0f)
+		{
+			return 0.0f;
+		}
+		return Sinc(x) * BesselI0(TextureMips::kKaiserAlpha * std::sqrt(1.0f - ratio * ratio)) / BesselI0(TextureMips::kKaiserAlpha);
+	}
+
+	///====================================================================
+	/// <summary>
+	/// 1 軸分の縮小フィルタを作ります。端は外側の値を複製した扱い（クランプ）にします。
+	/// </summary>
+	///====================================================================
+	FilterTaps BuildTaps(uint32_t sourceSize, uint32_t targetSize, TextureMips::Filter filter)
+	{
+		FilterTaps taps;
+		taps.first.resize(targetSize);
+		taps.count.resize(targetSize);
+		taps.offset.resize(targetSize);
+		const float scale = static_cast<float>(sourceSize) / static_cast<float>(targetSize);
+		for (uint32_t target = 0; target < targetSize; ++target)
+		{
+			taps.offset[target] = static_cast<uint32_t>(taps.weights.size());
+			if (filter == TextureMips::Filter::Box)
+			{
+				// 出力ピクセルが覆う入力の範囲を等しい重みで平均する
+				const uint32_t begin = static_cast<uint32_t>(std::floor(target * scale));
+				const uint32_t end = (std::max)(begin + 1, (std::min)(sourceSize, static_cast<uint32_t>(std::ceil((target + 1) * scale))));
+				for (uint32_t source = begin; source < end; ++source)
+				{
+					taps.sources.push_back(source);
+					taps.weights.push_back(1.0f / static_cast<float>(end - begin));
+				}
+			}
+			else
+			{
+				// 出力ピクセル中心からの距離（出力ピクセル単位）で重みを決める
+				const float center = (static_cast<float>(target) + 0.5f) * scale;
+				const int begin = static_cast<int>(std::floor(center - TextureMips::kKaiserWidth * scale));
+				const int end = static_cast<int>(std::ceil(center + TextureMips::kKaiserWidth * scale));
+				float sum = 0.0f;
+				for (int source = begin; source < end; ++source)
+				{
+					const float weight = KaiserWeight((static_cast<float>(source) + 0.5f - center) / scale);
+					if (weight == 0.0f)
+					{
+						continue;
+					}
+					taps.sources.push_back(static_cast<uint32_t>(std::clamp(source, 0, static_cast<int>(sourceSize) - 1)));
+					taps.weights.push_back(weight);
+					sum += weight;
+				}
+				for (size_t i = taps.offset[target]; i < taps.weights.size(); ++i)
+				{
+					taps.weights[i] /= sum;
+				}
+			}
+			taps.count[target] = static_cast<uint32_t>(taps.weights.size()) - taps.offset[target];
+		}
+		return taps;
+	}
+
+	/// 横、縦の順に縮小します（フィルタは分離可能なので 2 回の 1 次元処理で済む）。
+	FloatImage Downsample(const FloatImage& source, uint32_t width, uint32_t height, TextureMips::Filter filter)
+	{
+		const FilterTaps horizontal = BuildTaps(source.width, width, filter);
+		const FilterTaps vertical = BuildTaps(source.height, height, filter);
+
+		std::vector<float> rows(static_cast<size_t>(width) * source.height * 4);
+		for (uint32_t y = 0; y < source.height; ++y)
+		{
+			const float* sourceRow = &source.texels[static_cast<size_t>(y) * source.width * 4];
+			float* targetRow = &rows[static_cast<size_t>(y) * width * 4];
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				float sum[4] = {};
+				for (uint32_t i = horizontal.offset[x]; i < horizontal.offset[x] + horizontal.count[x]; ++i)
+				{
+					const float* texel = &sourceRow[static_cast<size_t>(horizontal.sources[i]) * 4];
+					const float weight = horizontal.weights[i];
+					sum[0] += texel[0] * weight;
+					sum[1] += texel[1] * weight;
+					sum[2] += texel[2] * weight;
+					sum[3] += texel[3] * weight;
+				}
+				std::copy(sum, sum + 4, &targetRow[static_cast<size_t>(x) * 4]);
+			}
+		}
+
+		FloatImage target;
+		target.width = width;
+		target.height = height;
+		target.texels.assign(static_cast<size_t>(width) * height * 4, 0.0f);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			float* targetRow = &target.texels[static_cast<size_t>(y) * width * 4];
+			for (uint32_t i = vertical.offset[y]; i < vertical.offset[y] + vertical.count[y]; ++i)
+			{
+				const float* sourceRow = &rows[static_cast<size_t>(vertical.sources[i]) * width * 4];
+				const float weight = vertical.weights[i];
+				for (size_t j = 0; j < static_cast<size_t>(width) * 4; ++j)
+				{
+					targetRow[j] += sourceRow[j] * weight;
+				}
+			}
+		}
+		return target;
+	}
+
+	uint8_t ToUnorm8(float value)
+	{
+		return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+	}
+
+	TextureMips::Level Quantize(const FloatImage& image, bool isSrgb)
+	{
+		TextureMips::Level level;
+		level.width = image.width;
+		level.height = image.height;
+		level.pixels.resize(static_cast<size_t>(image.width) * image.height * 4);
+		for (size_t i = 0; i < level.pixels.size(); i += 4)
+		{
+			// 負のローブでアルファが 0 以下になった場合は色も捨てる
+			const float alpha = std::clamp(image.texels[i + 3], 0.0f, 1.0f);
+			const float inverseAlpha = alpha > 0.0f ? 1.0f / alpha : 0.0f;
+			for (size_t c = 0; c < 3; ++c)
+			{
+				const float linear = std::clamp(image.texels[i + c] * inverseAlpha, 0.0f, 1.0f);
+				level.pixels[i + c] = ToUnorm8(isSrgb ? LinearToSrgb(linear) : linear);
+			}
+			level.pixels[i + 3] = ToUnorm8(alpha);
+		}
+		return level;
+	}
+}
+
+namespace TextureMips
+{
+	uint32_t GetMipCount(uint32_t width, uint32_t height)
+	{
+		uint32_t count = 1;
+		while (width > 1 || height > 1)
+		{
+			width = (std::max)(width / 2, 1u);
+			height = (std::max)(height / 2, 1u);
+			++count;
+		}
+		return count;
+	}
+
+	std::vector<Level> Generate(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, Filter filter, bool isSrgb)
+	{
+		std::vector<Level> levels;
+		if (pixels == nullptr || width == 0 || height == 0)
+		{
+			return levels;
+		}
+		levels.reserve(GetMipCount(width, height));
+
+		Level base;
+		base.width = width;
+		base.height = height;
+		base.pixels.resize(static_cast<size_t>(width) * height * 4);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			std::copy_n(pixels + y * rowPitch, static_cast<size_t>(width) * 4, &base.pixels[static_cast<size_t>(y) * width * 4]);
+		}
+
+		// 線形・アルファ乗算済みの float に変換する
+		float toLinear[256];
+		for (int i = 0; i < 256; ++i)
+		{
+			const float value = static_cast<float>(i) / 255.0f;
+			toLinear[i] = isSrgb ? SrgbToLinear(value) : value;
+		}
+		FloatImage current;
+		current.width = width;
+		current.height = height;
+		current.texels.resize(base.pixels.size());
+		for (size_t i = 0; i < base.pixels.size(); i += 4)
+		{
+			const float alpha = static_cast<float>(base.pixels[i + 3]) / 255.0f;
+			current.texels[i + 0] = toLinear[base.pixels[i + 0]] * alpha;
+			current.texels[i + 1] = toLinear[base.pixels[i + 1]] * alpha;
+			current.texels[i + 2] = toLinear[base.pixels[i + 2]] * alpha;
+			current.texels[i + 3] = alpha;
+		}
+		levels.push_back(std::move(base));
+
+		while (current.width > 1 || current.height > 1)
+		{
+			current = Downsample(current, (std::max)(current.width / 2, 1u), (std::max)(current.height / 2, 1u), filter);
+			levels.push_back(Quantize(current, isSrgb));
+		}
+		return levels;
+	}
+}
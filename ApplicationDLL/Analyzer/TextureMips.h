@@ -0,0 +1,46 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// RGBA8 画像のミップチェーン生成。
+/// 各レベルは 1 つ上のレベルから作り、途中の値は float のまま引き継ぐため
+/// 量子化誤差は積み重なりません。色は sRGB を線形に戻してからフィルタし、
+/// アルファで重み付けして半透明の縁に背景色がにじまないようにします。
+/// </summary>
+///=======================================================================
+namespace TextureMips
+{
+	enum class Filter
+	{
+		Box,		// 2x2 平均（奇数サイズは端を複製）
+		Kaiser,		// Kaiser 窓付き sinc。ボックスよりぼけとエイリアスが少ない
+	};
+
+	/// Kaiser フィルタの半径（縮小後のピクセル単位）と形状パラメータ
+	constexpr float kKaiserWidth = 3.0f;
+	constexpr float kKaiserAlpha = 4.0f;
+
+	struct Level
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint8_t> pixels;	// RGBA8、詰めて格納（rowPitch = width * 4）
+	};
+
+	/// 1x1 までのレベル数（D3D と同じく各辺は切り捨てで半分にします）
+	uint32_t GetMipCount(uint32_t width, uint32_t height);
+
+	///====================================================================
+	/// <summary>
+	/// レベル 0（元画像の写し）を含むミップチェーンを生成します。
+	/// </summary>
+	/// <param name="pixels">RGBA8 の元画像</param>
+	/// <param name="rowPitch">元画像の 1 行のバイト数</param>
+	/// <param name="isSrgb">色を sRGB として扱うか（法線・マスクなどのデータは false）</param>
+	///====================================================================
+	std::vector<Level> Generate(const uint8_t* pixels, uint32_t width, uint32_t height, size_t rowPitch, Filter filter, bool isSrgb);
+}
@@ -0,0 +1,57 @@
+﻿#pragma once
+
+#include "PMDFormat.h"
+
+#include <cstddef>
+#include <cstdint>
+
+///=======================================================================
+/// VMD（モーション）ファイルのディスク上のレイアウトを表すレコード定義。
+/// PMD と同じく 1 バイトパックで、マップしたバイト列に直接重ねて参照します。
+/// ボーン・表情キー以外（カメラ・照明など）は読み込みません。
+///=======================================================================
+namespace VMD
+{
+#pragma pack(push, 1)
+
+	struct Float4
+	{
+		float x;
+		float y;
+		float z;
+		float w;
+	};
+
+	struct HeaderRecord
+	{
+		char signature[30];	// "Vocaloid Motion Data 0002"
+		char modelName[20];
+	};
+
+	struct BoneKeyRecord
+	{
+		char boneName[15];
+		uint32_t frame;
+		PMD::Float3 position;	// 初期姿勢からの移動量
+		Float4 rotation;		// 四元数
+		// 補間曲線（ベジェの制御点、0～127）。先頭 16 バイトに
+		// X, Y, Z, 回転 の順で x1[4], y1[4], x2[4], y2[4] が並び、残りはその写し
+		uint8_t interpolation[64];
+	};
+
+	struct MorphKeyRecord
+	{
+		char morphName[15];
+		uint32_t frame;
+		float weight;
+	};
+
+#pragma pack(pop)
+
+	constexpr size_t kNameLength = 15;
+	constexpr uint8_t kMaxBezierControl = 127;
+
+	static_assert(sizeof(HeaderRecord) == 50, "VMD header must be 50 bytes");
+	static_assert(sizeof(BoneKeyRecord) == 111, "VMD bone key must be 111 bytes");
+	static_assert(sizeof(MorphKeyRecord) == 23, "VMD morph key must be 23 bytes");
+}
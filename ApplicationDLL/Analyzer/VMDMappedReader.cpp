@@ -0,0 +1,97 @@
+﻿#include "VMDMappedReader.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr char kSignature[] = "Vocaloid Motion Data 0002";
+
+	bool ReadCount(const uint8_t* data, size_t size, size_t& offset, uint32_t& outCount)
+	{
+		if (size - offset < sizeof(uint32_t))
+		{
+			return false;
+		}
+		std::memcpy(&outCount, data + offset, sizeof(uint32_t));
+		offset += sizeof(uint32_t);
+		return true;
+	}
+
+	template <typename TRecord>
+	bool TakeArray(const uint8_t* data, size_t size, size_t& offset, uint32_t count, PMDRecordView<TRecord>& outView)
+	{
+		const uint64_t bytes = static_cast<uint64_t>(count) * sizeof(TRecord);
+		if (bytes > static_cast<uint64_t>(size - offset))
+		{
+			return false;
+		}
+		outView = PMDRecordView<TRecord>(data + offset, count);
+		offset += static_cast<size_t>(bytes);
+		return true;
+	}
+}
+
+///====================================================================
+/// <summary>
+/// VMD ファイルをマップし、ボーンキーと表情キーの範囲を検証します。
+/// 表情キーのセクションはボーンキーの直後でファイルが終わっている場合は省略扱いです。
+/// </summary>
+/// <param name="filePath">VMD ファイルのパス</param>
+/// <returns>検証まで成功した場合は true</returns>
+///====================================================================
+bool VMDMappedReader::Open(const std::filesystem::path& filePath)
+{
+	Close();
+
+	if (!m_File.Open(filePath))
+	{
+		return Fail("failed to map file");
+	}
+
+	const uint8_t* data = m_File.GetData();
+	const size_t size = m_File.GetSize();
+	if (size < sizeof(VMD::HeaderRecord))
+	{
+		return Fail("file is too small for VMD header");
+	}
+	if (std::memcmp(GetHeader().signature, kSignature, sizeof(kSignature) - 1) != 0)
+	{
+		return Fail("invalid VMD signature");
+	}
+
+	size_t offset = sizeof(VMD::HeaderRecord);
+	uint32_t boneKeyCount = 0;
+	if (!ReadCount(data, size, offset, boneKeyCount) || !TakeArray(data, size, offset, boneKeyCount, m_BoneKeys))
+	{
+		return Fail("bone key section is truncated");
+	}
+
+	if (offset != size)
+	{
+		uint32_t morphKeyCount = 0;
+		if (!ReadCount(data, size, offset, morphKeyCount) || !TakeArray(data, size, offset, morphKeyCount, m_MorphKeys))
+		{
+			return Fail("morph key section is truncated");
+		}
+	}
+	// 以降のカメラ・照明・セルフ影・表示/IK のキーはモデルの再生に使わないため読み込みません。
+
+	m_IsValid = true;
+	return true;
+}
+
+void VMDMappedReader::Close()
+{
+	m_File.Close();
+	m_IsValid = false;
+	m_LastError.clear();
+	m_BoneKeys = {};
+	m_MorphKeys = {};
+}
+
+bool VMDMappedReader::Fail(const char* message)
+{
+	Close();
+	m_LastError = message;
+	return false;
+}
@@ -0,0 +1,40 @@
+﻿#pragma once
+
+#include "MappedFile.h"
+#include "PMDMappedReader.h"
+#include "VMDFormat.h"
+
+#include <filesystem>
+#include <string>
+
+///=======================================================================
+/// <summary>
+/// VMD ファイルをメモリマップして読み込むリーダー。
+/// Open 時にヘッダーとボーン・表情キーのセクションの範囲を検証し、
+/// キーはコピーせずに PMDRecordView で参照します（ファイル内の並びのまま）。
+/// </summary>
+///=======================================================================
+class VMDMappedReader
+{
+public:
+	bool Open(const std::filesystem::path& filePath);
+	void Close();
+
+	bool IsValid() const { return m_IsValid; }
+	const std::string& GetLastError() const { return m_LastError; }
+
+	const VMD::HeaderRecord& GetHeader() const { return *reinterpret_cast<const VMD::HeaderRecord*>(m_File.GetData()); }
+	PMDRecordView<VMD::BoneKeyRecord> GetBoneKeys() const { return m_BoneKeys; }
+	/// 表情キー。セクションが無い古いファイルでは空
+	PMDRecordView<VMD::MorphKeyRecord> GetMorphKeys() const { return m_MorphKeys; }
+
+private:
+	bool Fail(const char* message);
+
+	MappedFile m_File;
+	bool m_IsValid = false;
+	std::string m_LastError;
+
+	PMDRecordView<VMD::BoneKeyRecord> m_BoneKeys;
+	PMDRecordView<VMD::MorphKeyRecord> m_MorphKeys;
+};
@@ -0,0 +1,274 @@
+﻿#include "MorphBlender.h"
+#include "Skinning.h"
+#include "../Analyzer/PMDModelData.h"
+
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(__SSE2__)
+#define MORPH_HAS_SSE2 1
+#include <emmintrin.h>
+#else
+#define MORPH_HAS_SSE2 0
+#endif
+
+namespace
+{
+	/// これより小さい重みの表情は合成しない
+	constexpr float kMinMorphWeight = 1.0e-6f;
+
+	size_t AlignTargetCount(size_t count)
+	{
+		return (count + Skinning::kVertexAlignment - 1) / Skinning::kVertexAlignment * Skinning::kVertexAlignment;
+	}
+
+	///=================================================================
+	/// 位置 = 初期位置 + 累積差分 を求め、前回と異なる対象頂点に印を付けます。
+	/// 変わった頂点の数を返します。
+	///=================================================================
+	size_t ResolvePositions(const MorphTargetSet& targets, const float* deltaX, const float* deltaY, const float* deltaZ,
+		float* currentX, float* currentY, float* currentZ, uint8_t* isChanged)
+	{
+		const float* baseX = targets.GetBasePositionX().data();
+		const float* baseY = targets.GetBasePositionY().data();
+		const float* baseZ = targets.GetBasePositionZ().data();
+		const size_t count = targets.GetTargetCount();
+		size_t changedCount = 0;
+		size_t i = 0;
+#if MORPH_HAS_SSE2
+		// 配列は kVertexAlignment の倍数に確保済みなので 4 要素ずつ末尾まで読める
+		for (; i < count; i += 4)
+		{
+			const __m128 x = _mm_add_ps(_mm_loadu_ps(baseX + i), _mm_loadu_ps(deltaX + i));
+			const __m128 y = _mm_add_ps(_mm_loadu_ps(baseY + i), _mm_loadu_ps(deltaY + i));
+			const __m128 z = _mm_add_ps(_mm_loadu_ps(baseZ + i), _mm_loadu_ps(deltaZ + i));
+			const __m128 changed = _mm_or_ps(_mm_or_ps(
+				_mm_cmpneq_ps(x, _mm_loadu_ps(currentX + i)),
+				_mm_cmpneq_ps(y, _mm_loadu_ps(currentY + i))),
+				_mm_cmpneq_ps(z, _mm_loadu_ps(currentZ + i)));
+			_mm_storeu_ps(currentX + i, x);
+			_mm_storeu_ps(currentY + i, y);
+			_mm_storeu_ps(currentZ + i, z);
+
+			const int mask = _mm_movemask_ps(changed);
+			for (size_t lane = 0; lane < 4 && i + lane < count; ++lane)
+			{
+				isChanged[i + lane] = static_cast<uint8_t>((mask >> lane) & 1);
+				changedCount += isChanged[i + lane];
+			}
+		}
+#else
+		for (; i < count; ++i)
+		{
+			const float x = baseX[i] + deltaX[i];
+			const float y = baseY[i] + deltaY[i];
+			const float z = baseZ[i] + deltaZ[i];
+			isChanged[i] = static_cast<uint8_t>(x != currentX[i] || y != currentY[i] || z != currentZ[i]);
+			changedCount += isChanged[i];
+			currentX[i] = x;
+			currentY[i] = y;
+			currentZ[i] = z;
+		}
+#endif
+		return changedCount;
+	}
+}
+
+///====================================================================
+/// <summary>
+/// base の頂点を頂点番号順に並べ替えて対象頂点とし、
+/// 各表情の base 内の番号を対象頂点のスロットに変換します。
+/// </summary>
+///====================================================================
+bool MorphTargetSet::BuildFromPMD(const PMDMorphTable& morphs, size_t vertexCount)
+{
+	*this = MorphTargetSet();
+
+	const size_t morphCount = morphs.Size();
+	if (morphCount == 0)
+	{
+		return true;
+	}
+	// 表情を持つモデルでは先頭が base
+	if (morphs.type[0] != 0)
+	{
+		return false;
+	}
+
+	const uint32_t baseOffset = morphs.vertexOffset[0];
+	const uint32_t baseCount = morphs.vertexCount[0];
+	std::vector<uint32_t> order(baseCount);
+	std::iota(order.begin(), order.end(), 0u);
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return morphs.vertexIndex[baseOffset + a] < morphs.vertexIndex[baseOffset + b];
+	});
+
+	const size_t alignedCount = AlignTargetCount(baseCount);
+	std::vector<uint32_t> slotOfBase(baseCount);
+	m_TargetVertices.resize(baseCount);
+	m_BaseX.assign(alignedCount, 0.0f);
+	m_BaseY.assign(alignedCount, 0.0f);
+	m_BaseZ.assign(alignedCount, 0.0f);
+	for (uint32_t slot = 0; slot < baseCount; ++slot)
+	{
+		const uint32_t entry = baseOffset + order[slot];
+		if (morphs.vertexIndex[entry] >= vertexCount || (slot > 0 && morphs.vertexIndex[entry] == m_TargetVertices[slot - 1]))
+		{
+			*this = MorphTargetSet();
+			return false;
+		}
+		slotOfBase[order[slot]] = slot;
+		m_TargetVertices[slot] = morphs.vertexIndex[entry];
+		// base の差分は絶対座標
+		m_BaseX[slot] = morphs.positionOffset[entry].x;
+		m_BaseY[slot] = morphs.positionOffset[entry].y;
+		m_BaseZ[slot] = morphs.positionOffset[entry].z;
+	}
+
+	// base 自身は差分を持たない
+	m_EntryOffsets.assign(2, 0);
+	m_Names.push_back(morphs.name[0]);
+	std::vector<std::pair<uint32_t, uint32_t>> entries;
+	for (size_t morph = 1; morph < morphCount; ++morph)
+	{
+		entries.clear();
+		for (uint32_t i = 0; i < morphs.vertexCount[morph]; ++i)
+		{
+			const uint32_t entry = morphs.vertexOffset[morph] + i;
+			if (morphs.vertexIndex[entry] >= baseCount)
+			{
+				*this = MorphTargetSet();
+				return false;
+			}
+			entries.emplace_back(slotOfBase[morphs.vertexIndex[entry]], entry);
+		}
+		// スロット順に並べると累積バッファへの書き込みが前方向に連続する
+		std::sort(entries.begin(), entries.end());
+		for (const auto& slotEntry : entries)
+		{
+			m_EntrySlots.push_back(slotEntry.first);
+			m_EntryX.push_back(morphs.positionOffset[slotEntry.second].x);
+			m_EntryY.push_back(morphs.positionOffset[slotEntry.second].y);
+			m_EntryZ.push_back(morphs.positionOffset[slotEntry.second].z);
+		}
+		m_EntryOffsets.push_back(static_cast<uint32_t>(m_EntrySlots.size()));
+		m_Names.push_back(morphs.name[morph]);
+	}
+	return true;
+}
+
+int MorphTargetSet::FindMorph(const std::string& name) const
+{
+	const auto it = std::find(m_Names.begin(), m_Names.end(), name);
+	return it != m_Names.end() ? static_cast<int>(it - m_Names.begin()) : -1;
+}
+
+void MorphBlender::Initialize(const MorphTargetSet& targets)
+{
+	m_pTargets = &targets;
+	m_Weights.assign(targets.GetMorphCount(), 0.0f);
+	m_IsWeightChanged = false;
+
+	// 前回の位置は初期位置とし、最初の Apply では動いた頂点だけを書き込む
+	const size_t alignedCount = targets.GetBasePositionX().size();
+	m_DeltaX.assign(alignedCount, 0.0f);
+	m_DeltaY.assign(alignedCount, 0.0f);
+	m_DeltaZ.assign(alignedCount, 0.0f);
+	m_CurrentX = targets.GetBasePositionX();
+	m_CurrentY = targets.GetBasePositionY();
+	m_CurrentZ = targets.GetBasePositionZ();
+	m_IsChanged.assign(alignedCount, 0);
+	m_DirtyRanges.clear();
+	m_ChangedCount = 0;
+}
+
+void MorphBlender::SetWeight(size_t morph, float weight)
+{
+	if (morph == 0 || morph >= m_Weights.size() || m_Weights[morph] == weight)
+	{
+		return;
+	}
+	m_Weights[morph] = weight;
+	m_IsWeightChanged = true;
+}
+
+void MorphBlender::SetWeights(const float* weights, size_t count)
+{
+	const size_t clamped = (std::min)(count, m_Weights.size());
+	for (size_t morph = 1; morph < clamped; ++morph)
+	{
+		SetWeight(morph, weights[morph]);
+	}
+}
+
+const std::vector<MorphDirtyRange>& MorphBlender::Apply(uint8_t* vertices, size_t vertexStride)
+{
+	m_DirtyRanges.clear();
+	m_ChangedCount = 0;
+	if (m_pTargets == nullptr || !m_IsWeightChanged)
+	{
+		return m_DirtyRanges;
+	}
+	m_IsWeightChanged = false;
+
+	const MorphTargetSet& targets = *m_pTargets;
+	std::fill(m_DeltaX.begin(), m_DeltaX.end(), 0.0f);
+	std::fill(m_DeltaY.begin(), m_DeltaY.end(), 0.0f);
+	std::fill(m_DeltaZ.begin(), m_DeltaZ.end(), 0.0f);
+
+	// 有効な表情の差分だけを加える（表情内のスロットは重複しない）
+	const uint32_t* slots = targets.GetEntrySlots().data();
+	const float* offsetX = targets.GetEntryOffsetX().data();
+	const float* offsetY = targets.GetEntryOffsetY().data();
+	const float* offsetZ = targets.GetEntryOffsetZ().data();
+	for (size_t morph = 1; morph < m_Weights.size(); ++morph)
+	{
+		const float weight = m_Weights[morph];
+		if (weight > -kMinMorphWeight && weight < kMinMorphWeight)
+		{
+			continue;
+		}
+		const uint32_t end = targets.GetEntryOffset(morph + 1);
+		for (uint32_t entry = targets.GetEntryOffset(morph); entry < end; ++entry)
+		{
+			const uint32_t slot = slots[entry];
+			m_DeltaX[slot] += offsetX[entry] * weight;
+			m_DeltaY[slot] += offsetY[entry] * weight;
+			m_DeltaZ[slot] += offsetZ[entry] * weight;
+		}
+	}
+
+	m_ChangedCount = ResolvePositions(targets, m_DeltaX.data(), m_DeltaY.data(), m_DeltaZ.data(),
+		m_CurrentX.data(), m_CurrentY.data(), m_CurrentZ.data(), m_IsChanged.data());
+	if (m_ChangedCount == 0)
+	{
+		return m_DirtyRanges;
+	}
+
+	// 変わった頂点を書き込み、頂点番号の近いもの同士を範囲にまとめる
+	const uint32_t* targetVertices = targets.GetTargetVertices().data();
+	for (size_t slot = 0; slot < targets.GetTargetCount(); ++slot)
+	{
+		if (m_IsChanged[slot] == 0)
+		{
+			continue;
+		}
+		const uint32_t vertex = targetVertices[slot];
+		const float position[3] = { m_CurrentX[slot], m_CurrentY[slot], m_CurrentZ[slot] };
+		std::memcpy(vertices + vertex * vertexStride, position, sizeof(position));
+
+		if (!m_DirtyRanges.empty())
+		{
+			MorphDirtyRange& last = m_DirtyRanges.back();
+			if (vertex - (last.firstVertex + last.vertexCount) <= kRangeMergeGap)
+			{
+				last.vertexCount = vertex - last.firstVertex + 1;
+				continue;
+			}
+		}
+		m_DirtyRanges.push_back({ vertex, 1 });
+	}
+	return m_DirtyRanges;
+}
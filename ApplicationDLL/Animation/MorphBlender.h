@@ -0,0 +1,115 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct PMDMorphTable;
+
+/// 書き換えた頂点の連続範囲（頂点番号）
+struct MorphDirtyRange
+{
+	uint32_t firstVertex = 0;
+	uint32_t vertexCount = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// PMD の表情（頂点モーフ）の共有データ。キャラクター間で共通・変更しません。
+/// 表情が動かす頂点（base の頂点）だけを頂点番号順に並べた「対象頂点」とし、
+/// 各表情はその中の位置（スロット）と差分を、スロット順に整列した疎な配列で持ちます。
+/// </summary>
+///=======================================================================
+class MorphTargetSet
+{
+public:
+	///====================================================================
+	/// <summary>
+	/// PMD の表情から構築します。
+	/// </summary>
+	/// <param name="morphs">BuildPMDModelData の結果</param>
+	/// <param name="vertexCount">モデルの頂点数（範囲の検証に使います）</param>
+	/// <returns>base が無い・番号が範囲外など、表情として不正な場合は false</returns>
+	///====================================================================
+	bool BuildFromPMD(const PMDMorphTable& morphs, size_t vertexCount);
+
+	/// PMD の表情数（base を含む）
+	size_t GetMorphCount() const { return m_EntryOffsets.empty() ? 0 : m_EntryOffsets.size() - 1; }
+	/// 対象頂点の数
+	size_t GetTargetCount() const { return m_TargetVertices.size(); }
+	/// 対象頂点の頂点番号（昇順）
+	const std::vector<uint32_t>& GetTargetVertices() const { return m_TargetVertices; }
+	/// 対象頂点の初期位置（SoA、要素数は Skinning::kVertexAlignment の倍数）
+	const std::vector<float>& GetBasePositionX() const { return m_BaseX; }
+	const std::vector<float>& GetBasePositionY() const { return m_BaseY; }
+	const std::vector<float>& GetBasePositionZ() const { return m_BaseZ; }
+
+	/// 表情ごとの差分（[GetEntryOffset(morph), GetEntryOffset(morph + 1)) の範囲）
+	uint32_t GetEntryOffset(size_t morph) const { return m_EntryOffsets[morph]; }
+	const std::vector<uint32_t>& GetEntrySlots() const { return m_EntrySlots; }
+	const std::vector<float>& GetEntryOffsetX() const { return m_EntryX; }
+	const std::vector<float>& GetEntryOffsetY() const { return m_EntryY; }
+	const std::vector<float>& GetEntryOffsetZ() const { return m_EntryZ; }
+
+	/// 名前（Shift_JIS）から PMD の表情番号を探します。見つからない場合は -1
+	int FindMorph(const std::string& name) const;
+
+private:
+	std::vector<uint32_t>		m_TargetVertices;
+	std::vector<float>			m_BaseX, m_BaseY, m_BaseZ;
+	std::vector<uint32_t>		m_EntryOffsets;		// 表情数 + 1
+	std::vector<uint32_t>		m_EntrySlots;
+	std::vector<float>			m_EntryX, m_EntryY, m_EntryZ;
+	std::vector<std::string>	m_Names;
+};
+
+///=======================================================================
+/// <summary>
+/// キャラクター 1 体分の表情の合成。
+/// 重みが 0 でない表情の差分を対象頂点の累積バッファに加え、
+/// 対象頂点だけを 1 回走査して最終位置を求めます。前回から位置が変わった頂点は
+/// 近いもの同士をまとめた範囲（MorphDirtyRange）として返すため、
+/// 頂点バッファはその範囲だけを転送すれば済みます。
+/// </summary>
+///=======================================================================
+class MorphBlender
+{
+public:
+	/// 間の頂点がこの数以下の範囲は 1 つにまとめる（転送回数を減らすため）
+	static constexpr uint32_t kRangeMergeGap = 16;
+
+	/// 表情の共有データを設定し、重みを 0 に戻します。
+	void Initialize(const MorphTargetSet& targets);
+
+	/// PMD の表情番号で重みを設定します（base は無視します）。
+	void SetWeight(size_t morph, float weight);
+	/// 表情数分の重みをまとめて設定します（MotionSampler::SampleMorphs の出力と同じ並び）。
+	void SetWeights(const float* weights, size_t count);
+	float GetWeight(size_t morph) const { return m_Weights[morph]; }
+
+	///====================================================================
+	/// <summary>
+	/// 表情を合成し、位置が変わった頂点だけを頂点配列に書き込みます。
+	/// 重みが前回から変わっていない場合は何もしません。
+	/// </summary>
+	/// <param name="vertices">モデルの頂点配列（CPU 側の写し）。位置は各頂点の先頭に float3 で置かれていること</param>
+	/// <param name="vertexStride">頂点 1 つ分のバイト数</param>
+	/// <returns>書き込んだ範囲（頂点番号順）。次の Apply まで有効</returns>
+	///====================================================================
+	const std::vector<MorphDirtyRange>& Apply(uint8_t* vertices, size_t vertexStride);
+
+	/// 最後の Apply で書き込んだ頂点の数
+	size_t GetChangedVertexCount() const { return m_ChangedCount; }
+
+private:
+	const MorphTargetSet* m_pTargets = nullptr;
+	std::vector<float> m_Weights;
+	bool m_IsWeightChanged = false;
+
+	std::vector<float> m_DeltaX, m_DeltaY, m_DeltaZ;			// 累積バッファ
+	std::vector<float> m_CurrentX, m_CurrentY, m_CurrentZ;		// 前回書き込んだ位置
+	std::vector<uint8_t> m_IsChanged;
+	std::vector<MorphDirtyRange> m_DirtyRanges;
+	size_t m_ChangedCount = 0;
+};
@@ -0,0 +1,224 @@
+﻿#include "MotionClip.h"
+
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+namespace
+{
+	std::string ToName(const char (&text)[VMD::kNameLength])
+	{
+		size_t length = 0;
+		while (length < VMD::kNameLength && text[length] != '\0')
+		{
+			++length;
+		}
+		return std::string(text, length);
+	}
+
+	const char (&GetKeyName(const VMD::BoneKeyRecord& record))[VMD::kNameLength] { return record.boneName; }
+	const char (&GetKeyName(const VMD::MorphKeyRecord& record))[VMD::kNameLength] { return record.morphName; }
+
+	///=================================================================
+	/// キーを名前ごとにまとめ、チャンネル内をフレーム順に並べた索引を作ります。
+	/// チャンネルの並びは名前がファイル内に最初に現れた順です。
+	///=================================================================
+	template <typename TRecord>
+	void BuildKeyIndex(PMDRecordView<TRecord> keys, MotionKeyIndex& outIndex)
+	{
+		outIndex = MotionKeyIndex();
+
+		std::unordered_map<std::string, uint32_t> channelByName;
+		std::vector<std::vector<std::pair<uint32_t, uint32_t>>> channelKeys;
+		for (size_t i = 0; i < keys.Size(); ++i)
+		{
+			const auto inserted = channelByName.emplace(ToName(GetKeyName(keys[i])), static_cast<uint32_t>(channelKeys.size()));
+			if (inserted.second)
+			{
+				outIndex.names.push_back(inserted.first->first);
+				channelKeys.emplace_back();
+			}
+			channelKeys[inserted.first->second].emplace_back(keys[i].frame, static_cast<uint32_t>(i));
+		}
+
+		outIndex.offsets.reserve(channelKeys.size() + 1);
+		outIndex.frames.reserve(keys.Size());
+		outIndex.records.reserve(keys.Size());
+		for (auto& channel : channelKeys)
+		{
+			outIndex.offsets.push_back(static_cast<uint32_t>(outIndex.frames.size()));
+			std::stable_sort(channel.begin(), channel.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			for (size_t i = 0; i < channel.size(); ++i)
+			{
+				// 同じフレームのキーは後にあるものだけ残す
+				if (i + 1 < channel.size() && channel[i + 1].first == channel[i].first)
+				{
+					continue;
+				}
+				outIndex.frames.push_back(channel[i].first);
+				outIndex.records.push_back(channel[i].second);
+			}
+		}
+		outIndex.offsets.push_back(static_cast<uint32_t>(outIndex.frames.size()));
+	}
+
+	/// [beginFrame, endFrame) の補間に必要なキーの範囲（前後のキーを含む）
+	std::pair<uint32_t, uint32_t> SelectKeyRange(const MotionKeyIndex& index, size_t channel, uint32_t beginFrame, uint32_t endFrame)
+	{
+		const uint32_t* first = index.frames.data() + index.offsets[channel];
+		const uint32_t* last = index.frames.data() + index.offsets[channel + 1];
+		const uint32_t* begin = std::upper_bound(first, last, beginFrame);
+		if (begin != first)
+		{
+			--begin;
+		}
+		const uint32_t* end = std::lower_bound(begin, last, endFrame);
+		if (end != last)
+		{
+			++end;
+		}
+		return { static_cast<uint32_t>(begin - index.frames.data()), static_cast<uint32_t>(end - index.frames.data()) };
+	}
+
+	uint32_t GetLastKeyFrame(const MotionKeyIndex& index)
+	{
+		uint32_t lastFrame = 0;
+		for (size_t channel = 0; channel < index.GetChannelCount(); ++channel)
+		{
+			if (index.offsets[channel + 1] > index.offsets[channel])
+			{
+				lastFrame = (std::max)(lastFrame, index.frames[index.offsets[channel + 1] - 1]);
+			}
+		}
+		return lastFrame;
+	}
+
+	MotionBezier ReadBezier(const uint8_t (&interpolation)[64], int curve)
+	{
+		MotionBezier bezier;
+		bezier.x1 = (std::min)(interpolation[curve], VMD::kMaxBezierControl);
+		bezier.y1 = (std::min)(interpolation[curve + 4], VMD::kMaxBezierControl);
+		bezier.x2 = (std::min)(interpolation[curve + 8], VMD::kMaxBezierControl);
+		bezier.y2 = (std::min)(interpolation[curve + 12], VMD::kMaxBezierControl);
+		return bezier;
+	}
+}
+
+void MotionClip::BuildFromVMD(const VMDMappedReader& reader)
+{
+	MotionKeyIndex boneIndex;
+	MotionKeyIndex morphIndex;
+	BuildKeyIndex(reader.GetBoneKeys(), boneIndex);
+	BuildKeyIndex(reader.GetMorphKeys(), morphIndex);
+	Decode(reader, boneIndex, morphIndex, 0, (std::numeric_limits<uint32_t>::max)());
+}
+
+void MotionClip::Clear()
+{
+	*this = MotionClip();
+}
+
+void MotionClip::Decode(const VMDMappedReader& reader, const MotionKeyIndex& boneIndex, const MotionKeyIndex& morphIndex,
+	uint32_t beginFrame, uint32_t endFrame)
+{
+	// 窓を作り直すたびに呼ばれるので、確保済みの領域は再利用する
+	m_BoneChannels.resize(boneIndex.GetChannelCount());
+	m_BoneKeyFrames.clear();
+	m_BoneKeyTranslations.clear();
+	m_BoneKeyRotations.clear();
+	m_BoneKeyCurves.clear();
+	const auto boneKeys = reader.GetBoneKeys();
+	for (size_t channel = 0; channel < boneIndex.GetChannelCount(); ++channel)
+	{
+		const auto range = SelectKeyRange(boneIndex, channel, beginFrame, endFrame);
+		Channel& out = m_BoneChannels[channel];
+		out.name = boneIndex.names[channel];
+		out.keyOffset = static_cast<uint32_t>(m_BoneKeyFrames.size());
+		out.keyCount = range.second - range.first;
+		for (uint32_t key = range.first; key < range.second; ++key)
+		{
+			const VMD::BoneKeyRecord& record = boneKeys[boneIndex.records[key]];
+			m_BoneKeyFrames.push_back(record.frame);
+			m_BoneKeyTranslations.emplace_back(record.position.x, record.position.y, record.position.z);
+			m_BoneKeyRotations.emplace_back(record.rotation.x, record.rotation.y, record.rotation.z, record.rotation.w);
+			BoneKeyCurves curves;
+			for (int curve = 0; curve < kBoneCurveCount; ++curve)
+			{
+				curves.curves[curve] = ReadBezier(record.interpolation, curve);
+			}
+			m_BoneKeyCurves.push_back(curves);
+		}
+	}
+
+	m_MorphChannels.resize(morphIndex.GetChannelCount());
+	m_MorphKeyFrames.clear();
+	m_MorphKeyWeights.clear();
+	const auto morphKeys = reader.GetMorphKeys();
+	for (size_t channel = 0; channel < morphIndex.GetChannelCount(); ++channel)
+	{
+		const auto range = SelectKeyRange(morphIndex, channel, beginFrame, endFrame);
+		Channel& out = m_MorphChannels[channel];
+		out.name = morphIndex.names[channel];
+		out.keyOffset = static_cast<uint32_t>(m_MorphKeyFrames.size());
+		out.keyCount = range.second - range.first;
+		for (uint32_t key = range.first; key < range.second; ++key)
+		{
+			const VMD::MorphKeyRecord& record = morphKeys[morphIndex.records[key]];
+			m_MorphKeyFrames.push_back(record.frame);
+			m_MorphKeyWeights.push_back(record.weight);
+		}
+	}
+
+	m_LastFrame = (std::max)(GetLastKeyFrame(boneIndex), GetLastKeyFrame(morphIndex));
+}
+
+bool MotionStream::Open(const std::filesystem::path& filePath, uint32_t windowFrames)
+{
+	Close();
+	if (!m_Reader.Open(filePath))
+	{
+		return false;
+	}
+	BuildKeyIndex(m_Reader.GetBoneKeys(), m_BoneIndex);
+	BuildKeyIndex(m_Reader.GetMorphKeys(), m_MorphIndex);
+	m_WindowFrames = (std::max)(windowFrames, 1u);
+	LoadWindow(0, m_WindowFrames);
+	return true;
+}
+
+void MotionStream::Close()
+{
+	m_Reader.Close();
+	m_BoneIndex = MotionKeyIndex();
+	m_MorphIndex = MotionKeyIndex();
+	m_Window.Clear();
+	m_WindowBegin = 0;
+	m_WindowEnd = 0;
+	m_HasWindow = false;
+	m_WindowLoadCount = 0;
+}
+
+const MotionClip& MotionStream::Update(float frame)
+{
+	if (!m_HasWindow)
+	{
+		return m_Window;
+	}
+	const float clamped = std::clamp(frame, 0.0f, static_cast<float>(m_Window.GetLastFrame()));
+	if (clamped < static_cast<float>(m_WindowBegin) || clamped >= static_cast<float>(m_WindowEnd))
+	{
+		const uint32_t begin = static_cast<uint32_t>(clamped) / m_WindowFrames * m_WindowFrames;
+		LoadWindow(begin, begin + m_WindowFrames);
+	}
+	return m_Window;
+}
+
+void MotionStream::LoadWindow(uint32_t begin, uint32_t end)
+{
+	m_Window.Decode(m_Reader, m_BoneIndex, m_MorphIndex, begin, end);
+	m_WindowBegin = begin;
+	m_WindowEnd = end;
+	m_HasWindow = true;
+	++m_WindowLoadCount;
+}
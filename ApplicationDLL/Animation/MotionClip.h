@@ -0,0 +1,160 @@
+﻿#pragma once
+
+#include "../Analyzer/VMDMappedReader.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+/// VMD の補間曲線 1 本分。制御点 (x1, y1), (x2, y2) は 0～127
+struct MotionBezier
+{
+	uint8_t x1 = 20;
+	uint8_t y1 = 20;
+	uint8_t x2 = 107;
+	uint8_t y2 = 107;
+
+	bool IsLinear() const { return x1 == y1 && x2 == y2; }
+};
+
+/// チャンネルごとにフレーム順に並べたキーの索引（VMD のレコード番号を指します）
+struct MotionKeyIndex
+{
+	std::vector<std::string> names;
+	std::vector<uint32_t> offsets;		// チャンネル数 + 1
+	std::vector<uint32_t> frames;
+	std::vector<uint32_t> records;		// ファイル内のキー番号
+
+	size_t GetChannelCount() const { return names.size(); }
+};
+
+///=======================================================================
+/// <summary>
+/// チャンネル（ボーン名・表情名）ごとにフレーム順に整列したキー列。
+/// キーは全チャンネル共通の配列に種類別（フレーム・移動・回転・補間曲線）に格納し、
+/// 各チャンネルは [keyOffset, keyOffset + keyCount) の連続した範囲を参照します。
+/// 同じフレームに複数のキーがある場合はファイル内で後にあるものを採用します。
+/// </summary>
+///=======================================================================
+class MotionClip
+{
+public:
+	enum BoneCurve
+	{
+		BoneCurveX,
+		BoneCurveY,
+		BoneCurveZ,
+		BoneCurveRotation,
+		kBoneCurveCount
+	};
+
+	struct Channel
+	{
+		std::string name;		// Shift_JIS（VMD の 15 バイトで切り詰められたもの）
+		uint32_t keyOffset = 0;
+		uint32_t keyCount = 0;
+	};
+
+	/// キー 1 件分の補間曲線。直前のキーからこのキーまでの区間に使います
+	struct BoneKeyCurves
+	{
+		MotionBezier curves[kBoneCurveCount];
+	};
+
+	///====================================================================
+	/// <summary>
+	/// VMD の全キーを読み込みます。
+	/// </summary>
+	/// <param name="reader">Open に成功した VMDMappedReader</param>
+	///====================================================================
+	void BuildFromVMD(const VMDMappedReader& reader);
+	void Clear();
+
+	const std::vector<Channel>& GetBoneChannels() const { return m_BoneChannels; }
+	const std::vector<Channel>& GetMorphChannels() const { return m_MorphChannels; }
+
+	const std::vector<uint32_t>& GetBoneKeyFrames() const { return m_BoneKeyFrames; }
+	const std::vector<DirectX::XMFLOAT3>& GetBoneKeyTranslations() const { return m_BoneKeyTranslations; }
+	const std::vector<DirectX::XMFLOAT4>& GetBoneKeyRotations() const { return m_BoneKeyRotations; }
+	const std::vector<BoneKeyCurves>& GetBoneKeyCurves() const { return m_BoneKeyCurves; }
+
+	const std::vector<uint32_t>& GetMorphKeyFrames() const { return m_MorphKeyFrames; }
+	const std::vector<float>& GetMorphKeyWeights() const { return m_MorphKeyWeights; }
+
+	/// 最後のキーのフレーム番号（全体の長さ）
+	uint32_t GetLastFrame() const { return m_LastFrame; }
+	/// 保持しているキーの総数（ボーン + 表情）
+	size_t GetKeyCount() const { return m_BoneKeyFrames.size() + m_MorphKeyFrames.size(); }
+
+private:
+	friend class MotionStream;
+
+	/// 各チャンネルについて [beginFrame, endFrame) とその前後のキーを 1 つずつ展開します。
+	void Decode(const VMDMappedReader& reader, const MotionKeyIndex& boneIndex, const MotionKeyIndex& morphIndex,
+		uint32_t beginFrame, uint32_t endFrame);
+
+	std::vector<Channel>				m_BoneChannels;
+	std::vector<Channel>				m_MorphChannels;
+
+	std::vector<uint32_t>				m_BoneKeyFrames;
+	std::vector<DirectX::XMFLOAT3>		m_BoneKeyTranslations;
+	std::vector<DirectX::XMFLOAT4>		m_BoneKeyRotations;
+	std::vector<BoneKeyCurves>			m_BoneKeyCurves;
+
+	std::vector<uint32_t>				m_MorphKeyFrames;
+	std::vector<float>					m_MorphKeyWeights;
+
+	uint32_t m_LastFrame = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// 長いモーション向けのストリーミング再生。
+/// VMD はマップしたまま、チャンネルごとの「フレーム・レコード番号」の索引だけを常駐させ、
+/// 再生位置を含む一定フレーム幅の窓の分だけキーを MotionClip に展開します。
+/// 窓の MotionClip はチャンネルの並びが常に同じなので、MotionBinding は作り直さずに使えます。
+/// </summary>
+///=======================================================================
+class MotionStream
+{
+public:
+	static constexpr uint32_t kDefaultWindowFrames = 300;	// 30fps で 10 秒
+
+	bool Open(const std::filesystem::path& filePath, uint32_t windowFrames = kDefaultWindowFrames);
+	void Close();
+
+	bool IsOpen() const { return m_Reader.IsValid(); }
+	const std::string& GetLastError() const { return m_Reader.GetLastError(); }
+
+	///====================================================================
+	/// <summary>
+	/// frame を含む窓を展開済みにして返します。窓の中であれば何もしません。
+	/// </summary>
+	/// <returns>窓の前後のキーを 1 つずつ含むので、窓内のフレームは補間できます</returns>
+	///====================================================================
+	const MotionClip& Update(float frame);
+	const MotionClip& GetClip() const { return m_Window; }
+
+	uint32_t GetLastFrame() const { return m_Window.GetLastFrame(); }
+	/// 常駐している索引のキー数
+	size_t GetIndexedKeyCount() const { return m_BoneIndex.frames.size() + m_MorphIndex.frames.size(); }
+	/// 窓を作り直した回数
+	size_t GetWindowLoadCount() const { return m_WindowLoadCount; }
+
+private:
+	void LoadWindow(uint32_t begin, uint32_t end);
+
+	VMDMappedReader m_Reader;
+	MotionKeyIndex m_BoneIndex;
+	MotionKeyIndex m_MorphIndex;
+	MotionClip m_Window;
+	uint32_t m_WindowFrames = kDefaultWindowFrames;
+	uint32_t m_WindowBegin = 0;
+	uint32_t m_WindowEnd = 0;
+	bool m_HasWindow = false;
+	size_t m_WindowLoadCount = 0;
+};
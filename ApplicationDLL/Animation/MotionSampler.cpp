@@ -0,0 +1,255 @@
+﻿#include "MotionSampler.h"
+#include "../Analyzer/PMDModelData.h"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <unordered_map>
+
+using namespace DirectX;
+
+namespace
+{
+	/// 無効なカーソル（次の探索は二分探索になる）
+	constexpr uint32_t kInvalidCursor = 0xFFFFFFFFu;
+
+	/// 補間曲線の媒介変数を求める反復の設定
+	constexpr int kBezierNewtonIterations = 8;
+	constexpr int kBezierBisectionIterations = 15;	// 誤差 2^-15 程度
+	constexpr float kBezierTolerance = 1.0e-5f;
+	constexpr float kBezierMinSlope = 1.0e-4f;
+
+	float BezierComponent(float p1, float p2, float s)
+	{
+		const float inverse = 1.0f - s;
+		return 3.0f * inverse * inverse * s * p1 + 3.0f * inverse * s * s * p2 + s * s * s;
+	}
+
+	float BezierDerivative(float p1, float p2, float s)
+	{
+		const float inverse = 1.0f - s;
+		return 3.0f * inverse * inverse * p1 + 6.0f * inverse * s * (p2 - p1) + 3.0f * s * s * (1.0f - p2);
+	}
+
+	///=================================================================
+	/// frame 以下で最後のキーの位置を返します（先頭より前なら 0）。
+	/// カーソルが frame 以下を指していれば数キー先まで順に進め、
+	/// 見つからなければ二分探索します。
+	///=================================================================
+	uint32_t SeekKey(const uint32_t* frames, uint32_t keyCount, float frame, uint32_t& cursor)
+	{
+		if (cursor < keyCount && static_cast<float>(frames[cursor]) <= frame)
+		{
+			for (uint32_t step = 0; step < MotionSampler::kMaxForwardSteps; ++step)
+			{
+				if (cursor + 1 >= keyCount || static_cast<float>(frames[cursor + 1]) > frame)
+				{
+					return cursor;
+				}
+				++cursor;
+			}
+		}
+
+		const uint32_t* next = std::upper_bound(frames, frames + keyCount, frame,
+			[](float value, uint32_t keyFrame) { return value < static_cast<float>(keyFrame); });
+		cursor = next == frames ? 0 : static_cast<uint32_t>(next - frames - 1);
+		return cursor;
+	}
+
+	/// 区間 [key, key + 1] 内の経過割合。区間の外では 0（キーの値をそのまま使う）
+	float GetSegmentRatio(const uint32_t* frames, uint32_t keyCount, uint32_t key, float frame)
+	{
+		if (key + 1 >= keyCount || frame <= static_cast<float>(frames[key]))
+		{
+			return 0.0f;
+		}
+		const float begin = static_cast<float>(frames[key]);
+		const float end = static_cast<float>(frames[key + 1]);
+		return (std::min)((frame - begin) / (end - begin), 1.0f);
+	}
+
+	/// VMD に合わせて名前を 15 バイトで切り詰める
+	std::string ToMotionName(const std::string& name)
+	{
+		return name.size() > VMD::kNameLength ? name.substr(0, VMD::kNameLength) : name;
+	}
+
+	void ResizeCursors(std::vector<uint32_t>& cursors, size_t channelCount)
+	{
+		if (cursors.size() != channelCount)
+		{
+			cursors.assign(channelCount, kInvalidCursor);
+		}
+	}
+}
+
+float EvaluateMotionBezier(const MotionBezier& curve, float t)
+{
+	if (curve.IsLinear() || t <= 0.0f || t >= 1.0f)
+	{
+		return std::clamp(t, 0.0f, 1.0f);
+	}
+
+	// x(s) = t となる s をニュートン法で求めてから y(s) を返す（x は s について単調増加）。
+	// 傾きが 0 に近い曲線で収束しない場合だけ二分法に切り替える
+	const float scale = 1.0f / VMD::kMaxBezierControl;
+	const float x1 = curve.x1 * scale;
+	const float x2 = curve.x2 * scale;
+	float s = t;
+	bool isConverged = false;
+	for (int i = 0; i < kBezierNewtonIterations && !isConverged; ++i)
+	{
+		const float error = BezierComponent(x1, x2, s) - t;
+		const float slope = BezierDerivative(x1, x2, s);
+		if (std::fabs(error) < kBezierTolerance)
+		{
+			isConverged = true;
+		}
+		else if (slope < kBezierMinSlope)
+		{
+			break;
+		}
+		else
+		{
+			s = std::clamp(s - error / slope, 0.0f, 1.0f);
+		}
+	}
+	if (!isConverged)
+	{
+		float low = 0.0f;
+		float high = 1.0f;
+		s = t;
+		for (int i = 0; i < kBezierBisectionIterations; ++i)
+		{
+			if (BezierComponent(x1, x2, s) < t)
+			{
+				low = s;
+			}
+			else
+			{
+				high = s;
+			}
+			s = (low + high) * 0.5f;
+		}
+	}
+	return BezierComponent(curve.y1 * scale, curve.y2 * scale, s);
+}
+
+void MotionBinding::Bind(const MotionClip& clip, const Skeleton& skeleton, const PMDMorphTable* morphs)
+{
+	// 切り詰めて同じ名前になる場合は先に見つかった方を使う
+	std::unordered_map<std::string, uint32_t> boneByName;
+	for (uint32_t bone = 0; bone < skeleton.GetBoneCount(); ++bone)
+	{
+		boneByName.emplace(ToMotionName(skeleton.GetBoneName(bone)), bone);
+	}
+
+	m_BoundBoneCount = 0;
+	m_BoneTargets.assign(clip.GetBoneChannels().size(), kUnbound);
+	for (size_t channel = 0; channel < m_BoneTargets.size(); ++channel)
+	{
+		const auto it = boneByName.find(clip.GetBoneChannels()[channel].name);
+		if (it != boneByName.end())
+		{
+			m_BoneTargets[channel] = it->second;
+			++m_BoundBoneCount;
+		}
+	}
+
+	m_MorphTargets.assign(clip.GetMorphChannels().size(), kUnbound);
+	if (morphs == nullptr)
+	{
+		return;
+	}
+	std::unordered_map<std::string, uint32_t> morphByName;
+	for (size_t morph = 0; morph < morphs->Size(); ++morph)
+	{
+		// base は差分の基準なのでモーションの対象にしない
+		if (morphs->type[morph] != 0)
+		{
+			morphByName.emplace(ToMotionName(morphs->name[morph]), static_cast<uint32_t>(morph));
+		}
+	}
+	for (size_t channel = 0; channel < m_MorphTargets.size(); ++channel)
+	{
+		const auto it = morphByName.find(clip.GetMorphChannels()[channel].name);
+		if (it != morphByName.end())
+		{
+			m_MorphTargets[channel] = it->second;
+		}
+	}
+}
+
+void MotionSampler::Reset()
+{
+	std::fill(m_BoneCursors.begin(), m_BoneCursors.end(), kInvalidCursor);
+	std::fill(m_MorphCursors.begin(), m_MorphCursors.end(), kInvalidCursor);
+}
+
+void MotionSampler::SampleBones(const MotionClip& clip, const MotionBinding& binding, float frame,
+	XMFLOAT4* rotations, XMFLOAT3* translations)
+{
+	const auto& channels = clip.GetBoneChannels();
+	const auto& targets = binding.GetBoneTargets();
+	ResizeCursors(m_BoneCursors, channels.size());
+
+	const uint32_t* keyFrames = clip.GetBoneKeyFrames().data();
+	const XMFLOAT3* keyTranslations = clip.GetBoneKeyTranslations().data();
+	const XMFLOAT4* keyRotations = clip.GetBoneKeyRotations().data();
+	const MotionClip::BoneKeyCurves* keyCurves = clip.GetBoneKeyCurves().data();
+	for (size_t channel = 0; channel < channels.size(); ++channel)
+	{
+		const uint32_t bone = targets[channel];
+		const uint32_t keyCount = channels[channel].keyCount;
+		if (bone == MotionBinding::kUnbound || keyCount == 0)
+		{
+			continue;
+		}
+
+		const uint32_t offset = channels[channel].keyOffset;
+		const uint32_t key = offset + SeekKey(keyFrames + offset, keyCount, frame, m_BoneCursors[channel]);
+		const float ratio = GetSegmentRatio(keyFrames + offset, keyCount, key - offset, frame);
+		if (ratio <= 0.0f)
+		{
+			rotations[bone] = keyRotations[key];
+			translations[bone] = keyTranslations[key];
+			continue;
+		}
+
+		// 区間の補間曲線は終わり側のキーが持つ
+		const MotionBezier* curves = keyCurves[key + 1].curves;
+		const XMFLOAT3& t0 = keyTranslations[key];
+		const XMFLOAT3& t1 = keyTranslations[key + 1];
+		translations[bone] = XMFLOAT3(
+			t0.x + (t1.x - t0.x) * EvaluateMotionBezier(curves[MotionClip::BoneCurveX], ratio),
+			t0.y + (t1.y - t0.y) * EvaluateMotionBezier(curves[MotionClip::BoneCurveY], ratio),
+			t0.z + (t1.z - t0.z) * EvaluateMotionBezier(curves[MotionClip::BoneCurveZ], ratio));
+		const float rotationRatio = EvaluateMotionBezier(curves[MotionClip::BoneCurveRotation], ratio);
+		XMStoreFloat4(&rotations[bone], XMQuaternionSlerp(XMLoadFloat4(&keyRotations[key]), XMLoadFloat4(&keyRotations[key + 1]), rotationRatio));
+	}
+}
+
+void MotionSampler::SampleMorphs(const MotionClip& clip, const MotionBinding& binding, float frame, float* weights)
+{
+	const auto& channels = clip.GetMorphChannels();
+	const auto& targets = binding.GetMorphTargets();
+	ResizeCursors(m_MorphCursors, channels.size());
+
+	const uint32_t* keyFrames = clip.GetMorphKeyFrames().data();
+	const float* keyWeights = clip.GetMorphKeyWeights().data();
+	for (size_t channel = 0; channel < channels.size(); ++channel)
+	{
+		const uint32_t morph = targets[channel];
+		const uint32_t keyCount = channels[channel].keyCount;
+		if (morph == MotionBinding::kUnbound || keyCount == 0)
+		{
+			continue;
+		}
+
+		// 表情キーは線形補間
+		const uint32_t offset = channels[channel].keyOffset;
+		const uint32_t key = offset + SeekKey(keyFrames + offset, keyCount, frame, m_MorphCursors[channel]);
+		const float ratio = GetSegmentRatio(keyFrames + offset, keyCount, key - offset, frame);
+		weights[morph] = ratio <= 0.0f ? keyWeights[key] : keyWeights[key] + (keyWeights[key + 1] - keyWeights[key]) * ratio;
+	}
+}
@@ -0,0 +1,90 @@
+﻿#pragma once
+
+#include "MotionClip.h"
+#include "Skeleton.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct PMDMorphTable;
+
+///====================================================================
+/// <summary>
+/// VMD の補間曲線を評価します。
+/// </summary>
+/// <param name="t">区間内の経過割合（0～1）</param>
+/// <returns>補間の重み（0～1）</returns>
+///====================================================================
+float EvaluateMotionBezier(const MotionBezier& curve, float t);
+
+///=======================================================================
+/// <summary>
+/// MotionClip のチャンネルとモデルのボーン・表情の対応表。
+/// 名前は VMD に合わせて 15 バイトで切り詰めて比較します。
+/// クリップとモデルの組ごとに一度だけ作り、インスタンス間で共有します。
+/// </summary>
+///=======================================================================
+class MotionBinding
+{
+public:
+	static constexpr uint32_t kUnbound = 0xFFFFFFFFu;
+
+	///====================================================================
+	/// <summary>
+	/// チャンネル名からボーン（並べ替え後の番号）と表情（PMD の番号）を探します。
+	/// </summary>
+	/// <param name="morphs">null の場合は表情を対応付けません</param>
+	///====================================================================
+	void Bind(const MotionClip& clip, const Skeleton& skeleton, const PMDMorphTable* morphs = nullptr);
+
+	/// ボーンチャンネルごとの対象ボーン。見つからない場合は kUnbound
+	const std::vector<uint32_t>& GetBoneTargets() const { return m_BoneTargets; }
+	/// 表情チャンネルごとの対象の表情。見つからない場合は kUnbound
+	const std::vector<uint32_t>& GetMorphTargets() const { return m_MorphTargets; }
+	size_t GetBoundBoneCount() const { return m_BoundBoneCount; }
+
+private:
+	std::vector<uint32_t> m_BoneTargets;
+	std::vector<uint32_t> m_MorphTargets;
+	size_t m_BoundBoneCount = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// インスタンスごとのキー探索位置（カーソル）を持つサンプラー。
+/// 前回の位置から数キー先までを順に調べるため、順方向の再生ではチャンネルあたり
+/// 償却 O(1) で済みます。シークや逆再生、窓の入れ替えでカーソルが合わない場合は
+/// 二分探索に切り替えます。
+/// </summary>
+///=======================================================================
+class MotionSampler
+{
+public:
+	/// カーソルから順に調べるキー数の上限
+	static constexpr uint32_t kMaxForwardSteps = 4;
+
+	/// カーソルを無効にします（次の評価は二分探索から始めます）。
+	void Reset();
+
+	///====================================================================
+	/// <summary>
+	/// 対応付けたボーンの回転と移動（初期姿勢からの量）を書き込みます。
+	/// 対応の無いボーンには書き込みません。
+	/// </summary>
+	/// <param name="frame">フレーム位置（30fps、小数可）</param>
+	/// <param name="rotations">PoseBatch::GetLocalRotations の領域</param>
+	/// <param name="translations">PoseBatch::GetLocalTranslations の領域</param>
+	///====================================================================
+	void SampleBones(const MotionClip& clip, const MotionBinding& binding, float frame,
+		DirectX::XMFLOAT4* rotations, DirectX::XMFLOAT3* translations);
+
+	/// 対応付けた表情の重みを書き込みます（添字は PMD の表情番号）。
+	void SampleMorphs(const MotionClip& clip, const MotionBinding& binding, float frame, float* weights);
+
+private:
+	std::vector<uint32_t> m_BoneCursors;
+	std::vector<uint32_t> m_MorphCursors;
+};
@@ -0,0 +1,154 @@
+﻿#include "PoseEvaluator.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	/// これより小さい回転は行わない（ラジアン）
+	constexpr float kMinIKAngle = 1.0e-4f;
+	/// エフェクタと目標がこの距離まで近づいたら反復を打ち切る
+	constexpr float kIKConvergenceDistanceSq = 1.0e-8f;
+
+	XMMATRIX ComputeLocalMatrix(const Skeleton& skeleton, const XMFLOAT4* rotations, const XMFLOAT3* translations, uint32_t bone)
+	{
+		const XMFLOAT3& bind = skeleton.GetBindTranslations()[bone];
+		XMMATRIX local = XMMatrixRotationQuaternion(XMLoadFloat4(&rotations[bone]));
+		local.r[3] = XMVectorSet(bind.x + translations[bone].x, bind.y + translations[bone].y, bind.z + translations[bone].z, 1.0f);
+		return local;
+	}
+
+	/// [begin, end) のワールド行列を再計算します（親は begin より前か範囲内で計算済みであること）。
+	void UpdateWorldMatrices(const Skeleton& skeleton, const XMFLOAT4* rotations, const XMFLOAT3* translations, XMMATRIX* world,
+		uint32_t begin, uint32_t end)
+	{
+		const uint32_t* parents = skeleton.GetParents().data();
+		for (uint32_t bone = begin; bone < end; ++bone)
+		{
+			const XMMATRIX local = ComputeLocalMatrix(skeleton, rotations, translations, bone);
+			const uint32_t parent = parents[bone];
+			world[bone] = parent == Skeleton::kNoParent ? local : XMMatrixMultiply(local, world[parent]);
+		}
+	}
+
+	/// ひざ: X 軸回転のみ許し、曲がる向きの範囲に収める
+	XMFLOAT4 RotateKnee(const XMFLOAT4& current, float angle, float axisX)
+	{
+		const float currentAngle = 2.0f * std::atan2(current.x, current.w);
+		const float nextAngle = std::clamp(currentAngle + (axisX >= 0.0f ? angle : -angle), Skeleton::kKneeMinAngle, Skeleton::kKneeMaxAngle);
+		return XMFLOAT4(std::sin(nextAngle * 0.5f), 0.0f, 0.0f, std::cos(nextAngle * 0.5f));
+	}
+}
+
+void PoseBatch::Resize(const Skeleton& skeleton, size_t instanceCount)
+{
+	m_InstanceCount = instanceCount;
+	m_BoneCount = skeleton.GetBoneCount();
+	m_LocalRotations.assign(m_InstanceCount * m_BoneCount, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+	m_LocalTranslations.assign(m_InstanceCount * m_BoneCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+	m_WorldMatrices.assign(m_InstanceCount * m_BoneCount, XMMatrixIdentity());
+}
+
+void PoseBatch::ResetInstance(size_t instance)
+{
+	std::fill_n(GetLocalRotations(instance), m_BoneCount, XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f));
+	std::fill_n(GetLocalTranslations(instance), m_BoneCount, XMFLOAT3(0.0f, 0.0f, 0.0f));
+}
+
+namespace PoseEvaluator
+{
+	void ComputeWorldMatrices(const Skeleton& skeleton, const XMFLOAT4* rotations, const XMFLOAT3* translations, XMMATRIX* outWorld)
+	{
+		UpdateWorldMatrices(skeleton, rotations, translations, outWorld, 0, static_cast<uint32_t>(skeleton.GetBoneCount()));
+	}
+
+	void SolveIK(const Skeleton& skeleton, XMFLOAT4* rotations, const XMFLOAT3* translations, XMMATRIX* world)
+	{
+		const uint32_t* links = skeleton.GetIKLinks().data();
+		const uint8_t* isKnee = skeleton.GetIKLinkIsKnee().data();
+		for (const Skeleton::IKChain& chain : skeleton.GetIKChains())
+		{
+			const XMVECTOR goal = world[chain.ikBone].r[3];
+			for (uint32_t iteration = 0; iteration < chain.iterations; ++iteration)
+			{
+				if (XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(world[chain.effectorBone].r[3], goal))) < kIKConvergenceDistanceSq)
+				{
+					break;
+				}
+
+				for (uint32_t i = chain.linkOffset; i < chain.linkOffset + chain.linkCount; ++i)
+				{
+					const uint32_t link = links[i];
+
+					// リンク自身の空間でエフェクタと目標の向きを比べる
+					const XMMATRIX inverseLink = XMMatrixInverse(nullptr, world[link]);
+					const XMVECTOR localEffector = XMVector3Normalize(XMVector3TransformCoord(world[chain.effectorBone].r[3], inverseLink));
+					const XMVECTOR localGoal = XMVector3Normalize(XMVector3TransformCoord(goal, inverseLink));
+					const float cosAngle = std::clamp(XMVectorGetX(XMVector3Dot(localEffector, localGoal)), -1.0f, 1.0f);
+					float angle = std::acos(cosAngle);
+					if (angle < kMinIKAngle)
+					{
+						continue;
+					}
+					angle = (std::min)(angle, chain.limitAngle);
+
+					const XMVECTOR axis = XMVector3Cross(localEffector, localGoal);
+					if (isKnee[i] != 0)
+					{
+						rotations[link] = RotateKnee(rotations[link], angle, XMVectorGetX(axis));
+					}
+					else
+					{
+						if (XMVectorGetX(XMVector3LengthSq(axis)) < 1.0e-12f)
+						{
+							continue;
+						}
+						const XMVECTOR delta = XMQuaternionRotationNormal(XMVector3Normalize(axis), angle);
+						const XMVECTOR rotated = XMQuaternionNormalize(XMQuaternionMultiply(delta, XMLoadFloat4(&rotations[link])));
+						XMStoreFloat4(&rotations[link], rotated);
+					}
+
+					UpdateWorldMatrices(skeleton, rotations, translations, world, link, skeleton.GetSubtreeEnd(link));
+				}
+			}
+		}
+	}
+
+	void Evaluate(const Skeleton& skeleton, PoseBatch& poses, size_t firstInstance, size_t instanceCount)
+	{
+		const bool hasIK = !skeleton.GetIKChains().empty();
+		for (size_t instance = firstInstance; instance < firstInstance + instanceCount; ++instance)
+		{
+			XMFLOAT4* rotations = poses.GetLocalRotations(instance);
+			const XMFLOAT3* translations = poses.GetLocalTranslations(instance);
+			XMMATRIX* world = poses.GetWorldMatrices(instance);
+			ComputeWorldMatrices(skeleton, rotations, translations, world);
+			if (hasIK)
+			{
+				SolveIK(skeleton, rotations, translations, world);
+			}
+		}
+	}
+
+	void BuildSkinningPalette(const Skeleton& skeleton, const XMMATRIX* world, Skinning::BoneMatrix* outPalette)
+	{
+		const auto& bindPositions = skeleton.GetBindPositions();
+		for (uint32_t bone = 0; bone < skeleton.GetBoneCount(); ++bone)
+		{
+			// 初期姿勢の逆行列（平行移動のみ）を掛けてから、列ベクトル規約の 3x4 に転置する
+			XMFLOAT4X4 m;
+			XMStoreFloat4x4(&m, world[bone]);
+			const XMFLOAT3& bind = bindPositions[bone];
+			Skinning::BoneMatrix& out = outPalette[skeleton.ToSourceIndex(bone)];
+			for (int row = 0; row < 3; ++row)
+			{
+				out.m[row][0] = m.m[0][row];
+				out.m[row][1] = m.m[1][row];
+				out.m[row][2] = m.m[2][row];
+				out.m[row][3] = m.m[3][row] - (bind.x * m.m[0][row] + bind.y * m.m[1][row] + bind.z * m.m[2][row]);
+			}
+		}
+	}
+}
@@ -0,0 +1,81 @@
+﻿#pragma once
+
+#include "Skeleton.h"
+#include "Skinning.h"
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// 複数インスタンス分の姿勢。インスタンスごとにボーン数ぶんの連続した領域を持ち、
+/// 回転・移動・ワールド行列をそれぞれ別の配列（インスタンス順）で保持します。
+/// ボーンの並びは Skeleton の並べ替え後の順です。
+/// </summary>
+///=======================================================================
+class PoseBatch
+{
+public:
+	/// インスタンス数を変更し、すべての姿勢を初期姿勢に戻します。
+	void Resize(const Skeleton& skeleton, size_t instanceCount);
+	/// 指定インスタンスの回転と移動を初期姿勢に戻します。
+	void ResetInstance(size_t instance);
+
+	size_t GetInstanceCount() const { return m_InstanceCount; }
+	size_t GetBoneCount() const { return m_BoneCount; }
+
+	/// ボーンの回転（親空間、四元数）
+	DirectX::XMFLOAT4* GetLocalRotations(size_t instance) { return &m_LocalRotations[instance * m_BoneCount]; }
+	const DirectX::XMFLOAT4* GetLocalRotations(size_t instance) const { return &m_LocalRotations[instance * m_BoneCount]; }
+	/// 初期姿勢からの移動量（親空間）
+	DirectX::XMFLOAT3* GetLocalTranslations(size_t instance) { return &m_LocalTranslations[instance * m_BoneCount]; }
+	const DirectX::XMFLOAT3* GetLocalTranslations(size_t instance) const { return &m_LocalTranslations[instance * m_BoneCount]; }
+	/// モデル空間のワールド行列（PoseEvaluator が書き込みます）
+	DirectX::XMMATRIX* GetWorldMatrices(size_t instance) { return &m_WorldMatrices[instance * m_BoneCount]; }
+	const DirectX::XMMATRIX* GetWorldMatrices(size_t instance) const { return &m_WorldMatrices[instance * m_BoneCount]; }
+
+private:
+	size_t m_InstanceCount = 0;
+	size_t m_BoneCount = 0;
+	std::vector<DirectX::XMFLOAT4>	m_LocalRotations;
+	std::vector<DirectX::XMFLOAT3>	m_LocalTranslations;
+	std::vector<DirectX::XMMATRIX>	m_WorldMatrices;
+};
+
+///=======================================================================
+/// <summary>
+/// 姿勢の評価（ワールド行列の計算と CCD IK）。
+/// 行列は DirectXMath の行ベクトル規約で、ボーンの行列は 回転 * 平行移動 * 親 です。
+/// インスタンス単位で独立しているため、範囲を分けて別スレッドから呼び出せます。
+/// </summary>
+///=======================================================================
+namespace PoseEvaluator
+{
+	/// ボーンを先頭から 1 回走査してワールド行列を求めます。
+	void ComputeWorldMatrices(const Skeleton& skeleton, const DirectX::XMFLOAT4* rotations, const DirectX::XMFLOAT3* translations,
+		DirectX::XMMATRIX* outWorld);
+
+	///====================================================================
+	/// <summary>
+	/// CCD 法で IK チェーンを解き、リンクの回転とワールド行列を更新します。
+	/// チェーンは PMD の格納順に解き、リンクを回すたびにその子孫のワールド行列を再計算します。
+	/// </summary>
+	/// <param name="rotations">リンクの回転を書き換えます</param>
+	/// <param name="world">ComputeWorldMatrices 済みの行列（in/out）</param>
+	///====================================================================
+	void SolveIK(const Skeleton& skeleton, DirectX::XMFLOAT4* rotations, const DirectX::XMFLOAT3* translations, DirectX::XMMATRIX* world);
+
+	/// [firstInstance, firstInstance + instanceCount) の姿勢を評価します（ワールド行列 + IK）。
+	void Evaluate(const Skeleton& skeleton, PoseBatch& poses, size_t firstInstance, size_t instanceCount);
+
+	///====================================================================
+	/// <summary>
+	/// ワールド行列からスキニング用の行列パレットを作ります。
+	/// パレットは頂点が参照する PMD のボーン番号順に並べます。
+	/// </summary>
+	/// <param name="outPalette">ボーン数分の領域</param>
+	///====================================================================
+	void BuildSkinningPalette(const Skeleton& skeleton, const DirectX::XMMATRIX* world, Skinning::BoneMatrix* outPalette);
+}
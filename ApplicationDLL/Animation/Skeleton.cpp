@@ -0,0 +1,165 @@
+﻿#include "Skeleton.h"
+#include "../Analyzer/PMDModelData.h"
+
+#include <algorithm>
+
+namespace
+{
+	// PMD の IK の制限角は 4 ラジアン単位（PMX の「単位角」と同じ換算）
+	constexpr float kPMDLimitAngleScale = 4.0f;
+
+	// Shift_JIS の「左ひざ」「右ひざ」
+	const std::string kLeftKneeName = "\x8d\xb6\x82\xd0\x82\xb4";
+	const std::string kRightKneeName = "\x89\x45\x82\xd0\x82\xb4";
+
+	bool IsAncestorOf(const std::vector<uint32_t>& parents, uint32_t ancestor, uint32_t bone)
+	{
+		for (uint32_t current = parents[bone]; current != Skeleton::kNoParent; current = parents[current])
+		{
+			if (current == ancestor)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+}
+
+///====================================================================
+/// <summary>
+/// 親のない順に深さ優先で並べ替え、初期姿勢と IK チェーンを構築します。
+/// 親子関係を満たさない IK チェーン（リンクがエフェクタの祖先でないもの）は無視します。
+/// </summary>
+///====================================================================
+bool Skeleton::BuildFromPMD(const PMDModelData& model)
+{
+	*this = Skeleton();
+
+	const PMDBoneTable& bones = model.bones;
+	const size_t boneCount = bones.Size();
+	std::vector<std::vector<uint32_t>> children(boneCount);
+	std::vector<uint32_t> roots;
+	for (size_t i = 0; i < boneCount; ++i)
+	{
+		const uint16_t parent = bones.parentIndex[i];
+		if (parent == PMD::kNoBone)
+		{
+			roots.push_back(static_cast<uint32_t>(i));
+		}
+		else if (parent < boneCount && parent != i)
+		{
+			children[parent].push_back(static_cast<uint32_t>(i));
+		}
+		else
+		{
+			return false;
+		}
+	}
+
+	// 深さ優先（先行順）。循環しているボーンはどの根からも辿れないので数が合わなくなる
+	m_SortedToSource.reserve(boneCount);
+	std::vector<uint32_t> stack(roots.rbegin(), roots.rend());
+	while (!stack.empty())
+	{
+		const uint32_t bone = stack.back();
+		stack.pop_back();
+		m_SortedToSource.push_back(bone);
+		stack.insert(stack.end(), children[bone].rbegin(), children[bone].rend());
+	}
+	if (m_SortedToSource.size() != boneCount)
+	{
+		*this = Skeleton();
+		return false;
+	}
+
+	m_SourceToSorted.resize(boneCount);
+	for (size_t sorted = 0; sorted < boneCount; ++sorted)
+	{
+		m_SourceToSorted[m_SortedToSource[sorted]] = static_cast<uint32_t>(sorted);
+	}
+
+	m_Parents.resize(boneCount);
+	m_BindTranslations.resize(boneCount);
+	m_BindPositions.resize(boneCount);
+	m_Names.resize(boneCount);
+	for (size_t sorted = 0; sorted < boneCount; ++sorted)
+	{
+		const uint32_t source = m_SortedToSource[sorted];
+		const uint16_t sourceParent = bones.parentIndex[source];
+		const PMD::Float3& head = bones.headPos[source];
+		m_BindPositions[sorted] = DirectX::XMFLOAT3(head.x, head.y, head.z);
+		m_Names[sorted] = bones.name[source];
+		m_BoneIndexByName.emplace(m_Names[sorted], static_cast<uint32_t>(sorted));
+		if (sourceParent == PMD::kNoBone)
+		{
+			m_Parents[sorted] = kNoParent;
+			m_BindTranslations[sorted] = m_BindPositions[sorted];
+		}
+		else
+		{
+			const PMD::Float3& parentHead = bones.headPos[sourceParent];
+			m_Parents[sorted] = m_SourceToSorted[sourceParent];
+			m_BindTranslations[sorted] = DirectX::XMFLOAT3(head.x - parentHead.x, head.y - parentHead.y, head.z - parentHead.z);
+		}
+	}
+
+	// 先行順なので、子孫の範囲は後ろから親へ伝えるだけで求まる
+	m_SubtreeEnds.resize(boneCount);
+	for (size_t sorted = 0; sorted < boneCount; ++sorted)
+	{
+		m_SubtreeEnds[sorted] = static_cast<uint32_t>(sorted + 1);
+	}
+	for (size_t sorted = boneCount; sorted-- > 0;)
+	{
+		const uint32_t parent = m_Parents[sorted];
+		if (parent != kNoParent)
+		{
+			m_SubtreeEnds[parent] = (std::max)(m_SubtreeEnds[parent], m_SubtreeEnds[sorted]);
+		}
+	}
+
+	const PMDIKTable& iks = model.iks;
+	for (size_t i = 0; i < iks.Size(); ++i)
+	{
+		if (iks.boneIndex[i] >= boneCount || iks.targetBoneIndex[i] >= boneCount || iks.chainLength[i] == 0)
+		{
+			continue;
+		}
+
+		IKChain chain;
+		chain.ikBone = m_SourceToSorted[iks.boneIndex[i]];
+		chain.effectorBone = m_SourceToSorted[iks.targetBoneIndex[i]];
+		chain.iterations = iks.iterations[i];
+		chain.limitAngle = iks.limitAngle[i] * kPMDLimitAngleScale;
+		chain.linkOffset = static_cast<uint32_t>(m_IKLinks.size());
+
+		bool isValid = true;
+		for (uint32_t j = 0; j < iks.chainLength[i]; ++j)
+		{
+			const uint16_t sourceLink = iks.chainBoneIndex[iks.chainOffset[i] + j];
+			if (sourceLink >= boneCount || !IsAncestorOf(m_Parents, m_SourceToSorted[sourceLink], chain.effectorBone))
+			{
+				isValid = false;
+				break;
+			}
+			const uint32_t link = m_SourceToSorted[sourceLink];
+			m_IKLinks.push_back(link);
+			m_IKLinkIsKnee.push_back(m_Names[link] == kLeftKneeName || m_Names[link] == kRightKneeName ? 1 : 0);
+		}
+		if (!isValid)
+		{
+			m_IKLinks.resize(chain.linkOffset);
+			m_IKLinkIsKnee.resize(chain.linkOffset);
+			continue;
+		}
+		chain.linkCount = static_cast<uint32_t>(m_IKLinks.size()) - chain.linkOffset;
+		m_IKChains.push_back(chain);
+	}
+	return true;
+}
+
+uint32_t Skeleton::FindBone(const std::string& name) const
+{
+	const auto it = m_BoneIndexByName.find(name);
+	return it != m_BoneIndexByName.end() ? it->second : kNoParent;
+}
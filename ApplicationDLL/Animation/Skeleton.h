@@ -0,0 +1,84 @@
+﻿#pragma once
+
+#include <DirectXMath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct PMDModelData;
+
+///=======================================================================
+/// <summary>
+/// ボーン階層の共有データ（インスタンス間で共通・変更しない部分）。
+/// ボーンは親が必ず子より前に来る深さ優先順に並べ替えて保持するため、
+/// ワールド行列は先頭から 1 回走査するだけで求まり、各ボーンの子孫は
+/// [index, GetSubtreeEnd(index)) の連続した範囲になります。
+/// 外部（PMD の頂点・VMD）から参照する番号は ToSortedIndex で変換します。
+/// </summary>
+///=======================================================================
+class Skeleton
+{
+public:
+	static constexpr uint32_t kNoParent = 0xFFFFFFFFu;
+	/// ひざの回転範囲（X 軸のみ、ラジアン）
+	static constexpr float kKneeMinAngle = -DirectX::XM_PI;
+	static constexpr float kKneeMaxAngle = -0.002f;
+
+	/// IK チェーン 1 本分。ボーン番号はすべて並べ替え後のもの
+	struct IKChain
+	{
+		uint32_t ikBone = 0;			// 目標位置を表すボーン
+		uint32_t effectorBone = 0;		// 目標位置に近づけるボーン
+		uint32_t iterations = 0;
+		float limitAngle = 0.0f;		// 1 回の回転の上限（ラジアン）
+		uint32_t linkOffset = 0;		// GetIKLinks 内の開始位置（エフェクタに近い順）
+		uint32_t linkCount = 0;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// PMD のボーンと IK から階層を構築します。
+	/// </summary>
+	/// <param name="model">BuildPMDModelData の結果</param>
+	/// <returns>親の参照が循環しているなど、階層として不正な場合は false</returns>
+	///====================================================================
+	bool BuildFromPMD(const PMDModelData& model);
+
+	size_t GetBoneCount() const { return m_Parents.size(); }
+	const std::vector<uint32_t>& GetParents() const { return m_Parents; }
+	/// 親からの相対位置（初期姿勢）
+	const std::vector<DirectX::XMFLOAT3>& GetBindTranslations() const { return m_BindTranslations; }
+	/// モデル空間での位置（初期姿勢）
+	const std::vector<DirectX::XMFLOAT3>& GetBindPositions() const { return m_BindPositions; }
+	uint32_t GetSubtreeEnd(uint32_t bone) const { return m_SubtreeEnds[bone]; }
+
+	const std::vector<IKChain>& GetIKChains() const { return m_IKChains; }
+	const std::vector<uint32_t>& GetIKLinks() const { return m_IKLinks; }
+	/// ひざとして X 軸回転のみに制限するリンクか（GetIKLinks と同じ添字）
+	const std::vector<uint8_t>& GetIKLinkIsKnee() const { return m_IKLinkIsKnee; }
+
+	uint32_t ToSortedIndex(uint32_t sourceIndex) const { return m_SourceToSorted[sourceIndex]; }
+	uint32_t ToSourceIndex(uint32_t sortedIndex) const { return m_SortedToSource[sortedIndex]; }
+
+	/// 並べ替え後の番号で名前（Shift_JIS）を返します。
+	const std::string& GetBoneName(uint32_t bone) const { return m_Names[bone]; }
+	/// 名前からボーンを探します。見つからない場合は kNoParent
+	uint32_t FindBone(const std::string& name) const;
+
+private:
+	std::vector<uint32_t>				m_Parents;
+	std::vector<uint32_t>				m_SubtreeEnds;
+	std::vector<DirectX::XMFLOAT3>		m_BindTranslations;
+	std::vector<DirectX::XMFLOAT3>		m_BindPositions;
+	std::vector<uint32_t>				m_SourceToSorted;
+	std::vector<uint32_t>				m_SortedToSource;
+	std::vector<std::string>			m_Names;
+	std::unordered_map<std::string, uint32_t>	m_BoneIndexByName;
+
+	std::vector<IKChain>				m_IKChains;
+	std::vector<uint32_t>				m_IKLinks;
+	std::vector<uint8_t>				m_IKLinkIsKnee;
+};
@@ -0,0 +1,373 @@
+﻿#include "Skinning.h"
+
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SKINNING_HAS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+// MSVC は関数単位の指定なしで AVX の組み込み関数を使用できる
+#define SKINNING_TARGET_AVX
+#else
+#define SKINNING_TARGET_AVX __attribute__((target("avx")))
+#endif
+#else
+#define SKINNING_HAS_X86_SIMD 0
+#endif
+
+// FMA を持つ命令セット（-march=haswell や /arch:AVX2）で乗算と加算が縮約されないよう、このファイルでは縮約を禁止する。
+// GCC は STDC FP_CONTRACT を無視するため optimize で指定する（-ffp-contract=off と同じ）。
+#if defined(_MSC_VER) && !defined(__clang__)
+#pragma fp_contract(off)
+#elif defined(__clang__)
+#pragma STDC FP_CONTRACT OFF
+#elif defined(__GNUC__)
+#pragma GCC optimize("fp-contract=off")
+#endif
+
+// 各実装は次の演算順を守ること（ビット単位の一致のため。FMA への縮約も不可）。
+//   M = M0 * w + M1 * (1 - w)
+//   p' = ((M[r][0] * x + M[r][1] * y) + M[r][2] * z) + M[r][3]
+//   n' = (M[r][0] * nx + M[r][1] * ny) + M[r][2] * nz
+//   n' /= sqrt((n'x * n'x + n'y * n'y) + n'z * n'z)（長さ 0 の場合はそのまま）
+namespace
+{
+	constexpr size_t kMatrixElementCount = 12;
+
+	size_t AlignVertexCount(size_t count)
+	{
+		return (count + Skinning::kVertexAlignment - 1) / Skinning::kVertexAlignment * Skinning::kVertexAlignment;
+	}
+
+	void SkinScalar(const Skinning::SourceVertices& source, const Skinning::BoneMatrix* palette, Skinning::SkinnedVertices& out, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float* m0 = &palette[source.boneIndex0[i]].m[0][0];
+			const float* m1 = &palette[source.boneIndex1[i]].m[0][0];
+			const float w = source.weight0[i];
+			const float iw = 1.0f - w;
+			float m[kMatrixElementCount];
+			for (size_t e = 0; e < kMatrixElementCount; ++e)
+			{
+				m[e] = m0[e] * w + m1[e] * iw;
+			}
+
+			const float x = source.positionX[i];
+			const float y = source.positionY[i];
+			const float z = source.positionZ[i];
+			out.positionX[i] = ((m[0] * x + m[1] * y) + m[2] * z) + m[3];
+			out.positionY[i] = ((m[4] * x + m[5] * y) + m[6] * z) + m[7];
+			out.positionZ[i] = ((m[8] * x + m[9] * y) + m[10] * z) + m[11];
+
+			const float nx = source.normalX[i];
+			const float ny = source.normalY[i];
+			const float nz = source.normalZ[i];
+			float tx = (m[0] * nx + m[1] * ny) + m[2] * nz;
+			float ty = (m[4] * nx + m[5] * ny) + m[6] * nz;
+			float tz = (m[8] * nx + m[9] * ny) + m[10] * nz;
+			const float length = std::sqrt((tx * tx + ty * ty) + tz * tz);
+			if (length > 0.0f)
+			{
+				tx = tx / length;
+				ty = ty / length;
+				tz = tz / length;
+			}
+			out.normalX[i] = tx;
+			out.normalY[i] = ty;
+			out.normalZ[i] = tz;
+		}
+	}
+
+#if SKINNING_HAS_X86_SIMD
+	/// 4 頂点分のボーン行列を読み、要素ごとのベクトル（outElements[e] の各レーンが頂点）に並べ替える
+	void LoadPaletteSSE2(const Skinning::BoneMatrix* palette, const uint32_t* boneIndices, __m128 outElements[kMatrixElementCount])
+	{
+		for (int row = 0; row < 3; ++row)
+		{
+			__m128 r0 = _mm_loadu_ps(palette[boneIndices[0]].m[row]);
+			__m128 r1 = _mm_loadu_ps(palette[boneIndices[1]].m[row]);
+			__m128 r2 = _mm_loadu_ps(palette[boneIndices[2]].m[row]);
+			__m128 r3 = _mm_loadu_ps(palette[boneIndices[3]].m[row]);
+			_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+			outElements[row * 4 + 0] = r0;
+			outElements[row * 4 + 1] = r1;
+			outElements[row * 4 + 2] = r2;
+			outElements[row * 4 + 3] = r3;
+		}
+	}
+
+	void SkinSSE2(const Skinning::SourceVertices& source, const Skinning::BoneMatrix* palette, Skinning::SkinnedVertices& out, size_t count)
+	{
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 zero = _mm_setzero_ps();
+		for (size_t i = 0; i < count; i += 4)
+		{
+			__m128 m0[kMatrixElementCount];
+			__m128 m1[kMatrixElementCount];
+			LoadPaletteSSE2(palette, &source.boneIndex0[i], m0);
+			LoadPaletteSSE2(palette, &source.boneIndex1[i], m1);
+			const __m128 w = _mm_loadu_ps(&source.weight0[i]);
+			const __m128 iw = _mm_sub_ps(one, w);
+			__m128 m[kMatrixElementCount];
+			for (size_t e = 0; e < kMatrixElementCount; ++e)
+			{
+				m[e] = _mm_add_ps(_mm_mul_ps(m0[e], w), _mm_mul_ps(m1[e], iw));
+			}
+
+			const __m128 x = _mm_loadu_ps(&source.positionX[i]);
+			const __m128 y = _mm_loadu_ps(&source.positionY[i]);
+			const __m128 z = _mm_loadu_ps(&source.positionZ[i]);
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m128* r = &m[row * 4];
+				const __m128 p = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], x), _mm_mul_ps(r[1], y)), _mm_mul_ps(r[2], z)), r[3]);
+				float* dst = row == 0 ? &out.positionX[i] : (row == 1 ? &out.positionY[i] : &out.positionZ[i]);
+				_mm_storeu_ps(dst, p);
+			}
+
+			const __m128 nx = _mm_loadu_ps(&source.normalX[i]);
+			const __m128 ny = _mm_loadu_ps(&source.normalY[i]);
+			const __m128 nz = _mm_loadu_ps(&source.normalZ[i]);
+			__m128 t[3];
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m128* r = &m[row * 4];
+				t[row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r[0], nx), _mm_mul_ps(r[1], ny)), _mm_mul_ps(r[2], nz));
+			}
+			const __m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(t[0], t[0]), _mm_mul_ps(t[1], t[1])), _mm_mul_ps(t[2], t[2])));
+			const __m128 isNonZero = _mm_cmpgt_ps(length, zero);
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m128 normalized = _mm_div_ps(t[row], length);
+				t[row] = _mm_or_ps(_mm_and_ps(isNonZero, normalized), _mm_andnot_ps(isNonZero, t[row]));
+			}
+			_mm_storeu_ps(&out.normalX[i], t[0]);
+			_mm_storeu_ps(&out.normalY[i], t[1]);
+			_mm_storeu_ps(&out.normalZ[i], t[2]);
+		}
+	}
+
+	/// 8 頂点分のボーン行列を読み、要素ごとのベクトルに並べ替える（下位 128bit が頂点 0～3、上位が 4～7）
+	SKINNING_TARGET_AVX
+	void LoadPaletteAVX(const Skinning::BoneMatrix* palette, const uint32_t* boneIndices, __m256 outElements[kMatrixElementCount])
+	{
+		for (int row = 0; row < 3; ++row)
+		{
+			__m256 r[4];
+			for (int lane = 0; lane < 4; ++lane)
+			{
+				r[lane] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(palette[boneIndices[lane]].m[row])),
+					_mm_loadu_ps(palette[boneIndices[lane + 4]].m[row]), 1);
+			}
+			// 128bit レーンごとの 4x4 転置
+			const __m256 t0 = _mm256_unpacklo_ps(r[0], r[1]);
+			const __m256 t1 = _mm256_unpackhi_ps(r[0], r[1]);
+			const __m256 t2 = _mm256_unpacklo_ps(r[2], r[3]);
+			const __m256 t3 = _mm256_unpackhi_ps(r[2], r[3]);
+			outElements[row * 4 + 0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+			outElements[row * 4 + 1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+			outElements[row * 4 + 2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+			outElements[row * 4 + 3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+	}
+
+	SKINNING_TARGET_AVX
+	void SkinAVX(const Skinning::SourceVertices& source, const Skinning::BoneMatrix* palette, Skinning::SkinnedVertices& out, size_t count)
+	{
+		const __m256 one = _mm256_set1_ps(1.0f);
+		const __m256 zero = _mm256_setzero_ps();
+		for (size_t i = 0; i < count; i += 8)
+		{
+			__m256 m0[kMatrixElementCount];
+			__m256 m1[kMatrixElementCount];
+			LoadPaletteAVX(palette, &source.boneIndex0[i], m0);
+			LoadPaletteAVX(palette, &source.boneIndex1[i], m1);
+			const __m256 w = _mm256_loadu_ps(&source.weight0[i]);
+			const __m256 iw = _mm256_sub_ps(one, w);
+			__m256 m[kMatrixElementCount];
+			for (size_t e = 0; e < kMatrixElementCount; ++e)
+			{
+				m[e] = _mm256_add_ps(_mm256_mul_ps(m0[e], w), _mm256_mul_ps(m1[e], iw));
+			}
+
+			const __m256 x = _mm256_loadu_ps(&source.positionX[i]);
+			const __m256 y = _mm256_loadu_ps(&source.positionY[i]);
+			const __m256 z = _mm256_loadu_ps(&source.positionZ[i]);
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m256* r = &m[row * 4];
+				const __m256 p = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[0], x), _mm256_mul_ps(r[1], y)), _mm256_mul_ps(r[2], z)), r[3]);
+				float* dst = row == 0 ? &out.positionX[i] : (row == 1 ? &out.positionY[i] : &out.positionZ[i]);
+				_mm256_storeu_ps(dst, p);
+			}
+
+			const __m256 nx = _mm256_loadu_ps(&source.normalX[i]);
+			const __m256 ny = _mm256_loadu_ps(&source.normalY[i]);
+			const __m256 nz = _mm256_loadu_ps(&source.normalZ[i]);
+			__m256 t[3];
+			for (int row = 0; row < 3; ++row)
+			{
+				const __m256* r = &m[row * 4];
+				t[row] = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(r[0], nx), _mm256_mul_ps(r[1], ny)), _mm256_mul_ps(r[2], nz));
+			}
+			const __m256 length = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(t[0], t[0]), _mm256_mul_ps(t[1], t[1])), _mm256_mul_ps(t[2], t[2])));
+			const __m256 isNonZero = _mm256_cmp_ps(length, zero, _CMP_GT_OQ);
+			for (int row = 0; row < 3; ++row)
+			{
+				t[row] = _mm256_blendv_ps(t[row], _mm256_div_ps(t[row], length), isNonZero);
+			}
+			_mm256_storeu_ps(&out.normalX[i], t[0]);
+			_mm256_storeu_ps(&out.normalY[i], t[1]);
+			_mm256_storeu_ps(&out.normalZ[i], t[2]);
+		}
+	}
+
+	bool DetectAVX()
+	{
+#if defined(_MSC_VER)
+		int info[4] = {};
+		__cpuid(info, 1);
+		const bool hasOsxsave = (info[2] & (1 << 27)) != 0;
+		const bool hasAvx = (info[2] & (1 << 28)) != 0;
+		if (!hasOsxsave || !hasAvx)
+		{
+			return false;
+		}
+		// OS が YMM レジスタを保存するか
+		return (_xgetbv(0) & 0x6) == 0x6;
+#else
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx") != 0;
+#endif
+	}
+#endif
+}
+
+namespace Skinning
+{
+	void BuildSourceVertices(const PMDRecordView<PMD::VertexRecord>& vertices, SourceVertices& outVertices)
+	{
+		const size_t count = vertices.Size();
+		const size_t alignedCount = AlignVertexCount(count);
+		outVertices.vertexCount = count;
+		outVertices.maxBoneIndex = 0;
+		for (auto* channel : { &outVertices.positionX, &outVertices.positionY, &outVertices.positionZ,
+			&outVertices.normalX, &outVertices.normalY, &outVertices.normalZ, &outVertices.weight0 })
+		{
+			channel->assign(alignedCount, 0.0f);
+		}
+		outVertices.boneIndex0.assign(alignedCount, 0);
+		outVertices.boneIndex1.assign(alignedCount, 0);
+
+		for (size_t i = 0; i < count; ++i)
+		{
+			const PMD::VertexRecord& vertex = vertices[i];
+			outVertices.positionX[i] = vertex.pos.x;
+			outVertices.positionY[i] = vertex.pos.y;
+			outVertices.positionZ[i] = vertex.pos.z;
+			outVertices.normalX[i] = vertex.normal.x;
+			outVertices.normalY[i] = vertex.normal.y;
+			outVertices.normalZ[i] = vertex.normal.z;
+			outVertices.boneIndex0[i] = vertex.boneIndex[0];
+			outVertices.boneIndex1[i] = vertex.boneIndex[1];
+			outVertices.weight0[i] = static_cast<float>(vertex.boneWeight > 100 ? 100 : vertex.boneWeight) / 100.0f;
+			if (vertex.boneIndex[0] > outVertices.maxBoneIndex)
+			{
+				outVertices.maxBoneIndex = vertex.boneIndex[0];
+			}
+			if (vertex.boneIndex[1] > outVertices.maxBoneIndex)
+			{
+				outVertices.maxBoneIndex = vertex.boneIndex[1];
+			}
+		}
+	}
+
+	IsaLevel GetBestIsaLevel()
+	{
+		if (IsIsaLevelSupported(IsaLevel::AVX))
+		{
+			return IsaLevel::AVX;
+		}
+		if (IsIsaLevelSupported(IsaLevel::SSE2))
+		{
+			return IsaLevel::SSE2;
+		}
+		return IsaLevel::Scalar;
+	}
+
+	bool IsIsaLevelSupported(IsaLevel isa)
+	{
+		switch (isa)
+		{
+		case IsaLevel::Scalar:
+			return true;
+#if SKINNING_HAS_X86_SIMD
+		case IsaLevel::SSE2:
+			// x64 と /arch:SSE2（Win32 の既定）では常に使用できる
+			return true;
+		case IsaLevel::AVX:
+		{
+			static const bool hasAvx = DetectAVX();
+			return hasAvx;
+		}
+#endif
+		default:
+			return false;
+		}
+	}
+
+	const char* GetIsaLevelName(IsaLevel isa)
+	{
+		switch (isa)
+		{
+		case IsaLevel::Scalar:	return "Scalar";
+		case IsaLevel::SSE2:	return "SSE2";
+		case IsaLevel::AVX:	return "AVX";
+		default:				return "Unknown";
+		}
+	}
+
+	bool SkinVertices(const SourceVertices& source, const BoneMatrix* palette, size_t boneCount, SkinnedVertices& outVertices, IsaLevel isa)
+	{
+		if (!IsIsaLevelSupported(isa))
+		{
+			return false;
+		}
+		// 末尾の埋め草もボーン 0 を参照するため、頂点が無くても 1 本は必要
+		if (palette == nullptr || boneCount == 0 || source.maxBoneIndex >= boneCount)
+		{
+			return false;
+		}
+
+		const size_t alignedCount = source.positionX.size();
+		outVertices.vertexCount = source.vertexCount;
+		for (auto* channel : { &outVertices.positionX, &outVertices.positionY, &outVertices.positionZ,
+			&outVertices.normalX, &outVertices.normalY, &outVertices.normalZ })
+		{
+			channel->resize(alignedCount);
+		}
+
+		switch (isa)
+		{
+#if SKINNING_HAS_X86_SIMD
+		case IsaLevel::AVX:
+			SkinAVX(source, palette, outVertices, alignedCount);
+			break;
+		case IsaLevel::SSE2:
+			SkinSSE2(source, palette, outVertices, alignedCount);
+			break;
+#endif
+		default:
+			SkinScalar(source, palette, outVertices, alignedCount);
+			break;
+		}
+		return true;
+	}
+
+	bool SkinVertices(const SourceVertices& source, const BoneMatrix* palette, size_t boneCount, SkinnedVertices& outVertices)
+	{
+		return SkinVertices(source, palette, boneCount, outVertices, GetBestIsaLevel());
+	}
+}
@@ -0,0 +1,83 @@
+﻿#pragma once
+
+#include "../Analyzer/PMDMappedReader.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// PMD の 2 ボーン線形ブレンドスキニング（CPU 実装）。
+/// 頂点を SoA に展開し、SSE2 / AVX で 4 / 8 頂点ずつ処理します。
+/// どの命令セットでも演算順をスカラー版と揃えているため結果はビット単位で一致し、
+/// スカラー版は将来の GPU スキニングの基準実装を兼ねます。
+/// GPU スキニングを持たないバックエンド（OpenGL / Vulkan のフォールバック）でも使用します。
+/// </summary>
+///=======================================================================
+namespace Skinning
+{
+	/// SoA 配列の要素数はこの倍数に切り上げます（AVX の 1 回分）
+	constexpr size_t kVertexAlignment = 8;
+
+	/// 使用する命令セット
+	enum class IsaLevel : uint32_t
+	{
+		Scalar,
+		SSE2,
+		AVX,
+	};
+
+	///====================================================================
+	/// <summary>
+	/// ボーン 1 本分のスキニング行列（3x4、行優先）。
+	/// 列ベクトル規約で out = M * (x, y, z, 1) とし、平行移動は m[r][3] に入ります。
+	/// DirectXMath（行ベクトル規約）の行列は転置した上 3 行に当たります。
+	/// </summary>
+	///====================================================================
+	struct BoneMatrix
+	{
+		float m[3][4];
+	};
+
+	/// スキニング前の頂点（SoA）
+	struct SourceVertices
+	{
+		size_t vertexCount = 0;
+		uint32_t maxBoneIndex = 0;
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> normalX, normalY, normalZ;
+		std::vector<uint32_t> boneIndex0, boneIndex1;
+		std::vector<float> weight0;		// boneIndex0 の影響度（0～1）。boneIndex1 は 1 - weight0
+	};
+
+	/// スキニング後の頂点（SoA）。法線は正規化済み
+	struct SkinnedVertices
+	{
+		size_t vertexCount = 0;
+		std::vector<float> positionX, positionY, positionZ;
+		std::vector<float> normalX, normalY, normalZ;
+	};
+
+	/// PMD の頂点を SoA に展開します。末尾はボーン 0・影響度 0 の頂点で埋めます。
+	void BuildSourceVertices(const PMDRecordView<PMD::VertexRecord>& vertices, SourceVertices& outVertices);
+
+	/// 実行中の CPU と OS で使用できる最上位の命令セット
+	IsaLevel GetBestIsaLevel();
+	bool IsIsaLevelSupported(IsaLevel isa);
+	const char* GetIsaLevelName(IsaLevel isa);
+
+	///====================================================================
+	/// <summary>
+	/// ボーン行列のパレットで頂点をスキニングします。
+	/// </summary>
+	/// <param name="source">BuildSourceVertices で作成した頂点</param>
+	/// <param name="palette">ボーン行列の配列</param>
+	/// <param name="boneCount">palette の要素数</param>
+	/// <param name="outVertices">出力先（必要に応じて確保します）</param>
+	/// <param name="isa">使用する命令セット（未対応の場合は false）</param>
+	/// <returns>パレットが頂点の参照するボーンを含まない場合は false</returns>
+	///====================================================================
+	bool SkinVertices(const SourceVertices& source, const BoneMatrix* palette, size_t boneCount, SkinnedVertices& outVertices, IsaLevel isa);
+	bool SkinVertices(const SourceVertices& source, const BoneMatrix* palette, size_t boneCount, SkinnedVertices& outVertices);
+}
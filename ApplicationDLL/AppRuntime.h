@@ -76,6 +76,7 @@ struct RuntimeState
     std::unique_ptr<IRenderDevice> g_renderDevice;
     bool g_imguiInitialized = false;
     bool g_editorUiEnabled = true;
+    bool g_textureHotReloadEnabled = false;
     PieTickCallback g_pieTickCallback = nullptr;
     bool g_isStandaloneMode = false;
     HMODULE g_pieGameModule = nullptr;
@@ -113,6 +114,7 @@ struct RuntimeState
     std::vector<RuntimeActor> g_runtimeActors;
     std::wstring g_windowClassName;
     bool g_isShuttingDown = false;
+    std::string g_resourceMemoryReport;
 };
 
 class AppRuntime
@@ -163,8 +165,15 @@ public:
     void MessageLoopIteration();
     void SetEditorUiEnabled(BOOL enabled);
     BOOL IsEditorUiEnabled() const;
+    /// テクスチャのホットリロード（監視スレッドとミップのハッシュ計算）を切り替える。既定は無効で、エディターだけが有効にする
+    void SetTextureHotReloadEnabled(BOOL enabled);
+    BOOL IsTextureHotReloadEnabled() const;
     const char* GetRuntimeStatusText() const;
     const char* GetRuntimeLastErrorText() const;
+    /// 最後のフレームの GPU メモリの集計（JSON、UTF-8）。次の呼び出しまで有効
+    const char* GetResourceMemoryReport();
+    /// 以降のフレームの集計を書き出すファイル（.json なら JSON、それ以外は CSV）。null か空文字なら止める
+    BOOL SetResourceMemoryTracePath(const char* tracePath);
 
     LRESULT HandleWndProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -196,6 +205,7 @@ extern "C" __declspec(dllexport) void StartPie();
 extern "C" __declspec(dllexport) void StopPie();
 extern "C" __declspec(dllexport) void SetEditorUiEnabled(BOOL enabled);
 extern "C" __declspec(dllexport) BOOL IsEditorUiEnabled();
+extern "C" __declspec(dllexport) void SetTextureHotReloadEnabled(BOOL enabled);
 extern "C" __declspec(dllexport) void SetGameClearColor(float r, float g, float b, float a);
 extern "C" __declspec(dllexport) uint32_t CreateSpriteRenderer();
 extern "C" __declspec(dllexport) void DestroySpriteRenderer(uint32_t handle);
@@ -220,3 +230,5 @@ extern "C" __declspec(dllexport) void DestroyGameNativeWindow();
 extern "C" __declspec(dllexport) HWND GetGameNativeWindowHandle();
 extern "C" __declspec(dllexport) const char* GetRuntimeStatusText();
 extern "C" __declspec(dllexport) const char* GetRuntimeLastErrorText();
+extern "C" __declspec(dllexport) const char* GetResourceMemoryReport();
+extern "C" __declspec(dllexport) BOOL SetResourceMemoryTracePath(const char* tracePath);
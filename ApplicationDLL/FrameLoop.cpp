@@ -6,6 +6,9 @@
 #include "PieAutoPublish.h"
 #include "PieLoader.h"
 #include "RHI/TextureAssetManager.h"
+#include "Renderer/MeshImporter.h"
+#include "SpriteRenderers/SpriteRendererBackendFactory.h"
+#include "System/ResourceAccounting.h"
 #include "WinHandleRAII.h"
 
 #include "SceneManager.h"
@@ -88,6 +91,7 @@ namespace
 
 ///===================================================================
 /// @brief スプライトレンダラーの描画
+/// まとめて描くバックエンド（DirectX12）は、全てのスプライトを集めてから最後に描く
 /// @param viewportMode 
 ///===================================================================
 void RenderSpriteRenderers(ViewportRenderMode viewportMode)
@@ -100,6 +104,10 @@ void RenderSpriteRenderers(ViewportRenderMode viewportMode)
             spriteRendererEntry.second->Render(state.g_renderDevice.get(), viewportMode);
         }
     }
+    if (state.g_renderDevice != nullptr)
+    {
+        FlushSpriteRendererBackend(state.g_renderDevice->Backend());
+    }
 }
 
 void DestroyAllSpriteRenderers()
@@ -255,6 +263,13 @@ void AppRuntime::MessageLoopIteration()
         ? RuntimeStateRef().g_renderDevice->Backend()
         : RuntimeStateRef().g_displayRendererBackend;
 
+    // ワーカーで読み込みが終わったメッシュとテクスチャの GPU リソースを作成する
+    if (activeRenderBackend == RendererBackend::DirectX12 && RuntimeStateRef().g_renderDevice != nullptr)
+    {
+        MeshImporter::Get().ProcessPendingUploads();
+        TextureAssetManager::Get().ProcessPendingTextures();
+    }
+
 	m_PlayInEditor.UpdatePie();
 
     constexpr float kFixedDeltaTime = 1.0f / 60.0f;
@@ -394,6 +409,9 @@ void AppRuntime::MessageLoopIteration()
         nonDxProgressCounter = 0;
     }
 
+    // このフレームの GPU メモリの集計を残す（トレース中なら書き出す）
+    ResourceAccounting::Get().CaptureFrame();
+
     ++frameCounter;
     if ((frameCounter % 240) == 0)
     {
@@ -449,6 +467,21 @@ BOOL AppRuntime::IsEditorUiEnabled() const
     return RuntimeStateRef().g_editorUiEnabled ? TRUE : FALSE;
 }
 
+void AppRuntime::SetTextureHotReloadEnabled(BOOL enabled)
+{
+    RuntimeStateRef().g_textureHotReloadEnabled = (enabled != FALSE);
+    // デバイスが無い間は覚えておくだけにして、作ったときに InitializeRendererAndUi が反映する
+    if (RuntimeStateRef().g_renderDevice != nullptr)
+    {
+        TextureAssetManager::Get().SetHotReloadEnabled(RuntimeStateRef().g_textureHotReloadEnabled);
+    }
+}
+
+BOOL AppRuntime::IsTextureHotReloadEnabled() const
+{
+    return RuntimeStateRef().g_textureHotReloadEnabled ? TRUE : FALSE;
+}
+
 const char* AppRuntime::GetRuntimeStatusText() const
 {
     return RuntimeStateRef().g_pieGameStatus.c_str();
@@ -458,3 +491,24 @@ const char* AppRuntime::GetRuntimeLastErrorText() const
 {
     return RuntimeStateRef().g_pieGameLastLoadError.c_str();
 }
+
+const char* AppRuntime::GetResourceMemoryReport()
+{
+    RuntimeStateRef().g_resourceMemoryReport = ResourceAccounting::FormatJson(ResourceAccounting::Get().GetLatestFrame());
+    return RuntimeStateRef().g_resourceMemoryReport.c_str();
+}
+
+BOOL AppRuntime::SetResourceMemoryTracePath(const char* tracePath)
+{
+    if (tracePath == nullptr || tracePath[0] == '\0')
+    {
+        ResourceAccounting::Get().StopTrace();
+        return TRUE;
+    }
+    if (!ResourceAccounting::Get().StartTrace(std::filesystem::u8path(tracePath)))
+    {
+        LOG_DEBUG("SetResourceMemoryTracePath: failed to open %s", tracePath);
+        return FALSE;
+    }
+    return TRUE;
+}
@@ -1,23 +1,28 @@
 ﻿#pragma once
 
 #include "..\Math\MathUtil.h"
-#include <wrl/client.h>
 #include <d3d12.h>
 
+///=======================================================================
+/// <summary>
+/// オブジェクトごとの行列の定数バッファ。自分のリソースは持たず、Update のたびに
+/// FrameConstantsManager から今のフレームの領域を切り出して書き込みます。
+/// アドレスはフレームごとに変わるので、Update の後で GetGPUVirtualAddress を取り直します。
+/// </summary>
+///=======================================================================
 class DX12FrameConstantBuffer
 {
 private:
-	UINT m_DescriptorIndex = UINT_MAX;
-	Microsoft::WRL::ComPtr<ID3D12Resource> m_pConstantBuffer;
-	WL::Matrix* m_pMappedMatrix = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS m_GpuVirtualAddress = 0;
 
 	void ResetParam();
 	
 public:
 
-	UINT GetDescriptorIndex() const { return m_DescriptorIndex; }
-	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const { return m_pConstantBuffer ? m_pConstantBuffer->GetGPUVirtualAddress() : 0; }
+	/// 最後に Update で書き込んだ行列のアドレス（そのフレームの間だけ有効）
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const { return m_GpuVirtualAddress; }
 
+	/// 単位行列を書き込みます。
 	bool Initialize();
 	void Update(const WL::Matrix& matrix);
 	bool IsValid() const;
@@ -1,11 +1,28 @@
 ﻿#include "pch.h"
 #include "DX12Texture.h"
 #include "RHI/TextureManager.h"
+#include "DescriptorHeapManager.h"
+#include "DX12UploadBackend.h"
+#include "Dx12RenderDevice.h"
 
 DX12Texture::DX12Texture()
 {
 }
 
+DX12Texture::~DX12Texture()
+{
+	// GPU が読むのはフレームごとに集めた写しなので、ステージングのディスクリプタはすぐに使い回してよい
+	if (stagingDescriptorIndex != UINT_MAX)
+	{
+		DescriptorHeapManager::Get().FreeStagingDescriptor(stagingDescriptorIndex);
+	}
+	// バインドレスの写しは記録済みのフレームが読むかもしれないので、GPU の処理が終わってから使い回される
+	if (bindlessDescriptorIndex != UINT_MAX)
+	{
+		DescriptorHeapManager::Get().FreeGlobalTextureDescriptor(bindlessDescriptorIndex);
+	}
+}
+
 bool DX12Texture::LoadFromFile(const wchar_t* filePath)
 {
 	if (filePath == nullptr)
@@ -14,16 +31,41 @@ bool DX12Texture::LoadFromFile(const wchar_t* filePath)
 	}
 
 	const UINT newDescriptorIndex = TextureManager::Get().CreateTextureResource(m_pTextureBuffer, filePath, &m_Metadata);
+	return OnCreated(newDescriptorIndex);
+}
+
+bool DX12Texture::LoadFromFile(const std::wstring& filePath)
+{
+	return LoadFromFile(filePath.c_str());
+}
+
+bool DX12Texture::CreateFromPayload(const TexturePayload& payload, uint32_t firstMip)
+{
+	const UINT newDescriptorIndex = TextureManager::Get().CreateTextureResource(m_pTextureBuffer, payload, &m_Metadata, firstMip);
+	return OnCreated(newDescriptorIndex);
+}
+
+bool DX12Texture::UpdateFromPayload(const TexturePayload& payload, const std::vector<uint32_t>& mips)
+{
+	return TextureManager::Get().UpdateTextureResource(m_pTextureBuffer.Get(), m_Metadata, payload, mips);
+}
+
+bool DX12Texture::CreateFromImage(const DirectX::ScratchImage& image)
+{
+	const UINT newDescriptorIndex = TextureManager::Get().CreateTextureResource(m_pTextureBuffer, image, &m_Metadata);
+	return OnCreated(newDescriptorIndex);
+}
+
+bool DX12Texture::OnCreated(UINT newDescriptorIndex)
+{
 	if (newDescriptorIndex == static_cast<UINT>(-1))
 	{
 		return false;
 	}
 
-	descriptorIndex = newDescriptorIndex;
+	stagingDescriptorIndex = newDescriptorIndex;
+	// 対応していない場合は UINT_MAX のまま（ディスクリプタテーブルの描画だけに使う）
+	bindlessDescriptorIndex = DescriptorHeapManager::Get().CreateBindlessDescriptor(stagingDescriptorIndex);
+	m_Allocation = TrackD3D12Resource(Dx12RenderDevice::GetDevice(), m_pTextureBuffer.Get(), ResourceCategory::Texture, "DX12Texture");
 	return true;
 }
-
-bool DX12Texture::LoadFromFile(const std::wstring& filePath)
-{
-	return LoadFromFile(filePath.c_str());
-}
@@ -3,30 +3,51 @@
 #include <d3d12.h>
 #include <memory>
 #include <string>
+#include <vector>
 #include <wrl/client.h>
 
+#include "../System/ResourceAccounting.h"
+
 using Microsoft::WRL::ComPtr;
 
+struct TexturePayload;
+
 class DX12Texture : public RHITexture
 {
 public:
 	DX12Texture();
-	~DX12Texture() override = default;
+	/// SRV のディスクリプタをステージングヒープとバインドレスの領域に返します。
+	~DX12Texture() override;
 
 	bool LoadFromFile(const wchar_t* filePath);
 	bool LoadFromFile(const std::wstring& filePath);
+	/// デコード済みの画像から作成します（描画スレッドで呼び出します）。
+	bool CreateFromImage(const DirectX::ScratchImage& image);
+	/// TextureManager::LoadTexturePayload で読み込んだものから作成します（描画スレッドで呼び出します）。
+	/// firstMip を指定すると、そのミップより細かいものを持たない小さなテクスチャーになります。
+	bool CreateFromPayload(const TexturePayload& payload, uint32_t firstMip = 0);
+	/// 作成済みのリソースの mips だけを書き換えます（SRV とディスクリプタはそのまま）。
+	/// 大きさや形式が違う場合は false
+	bool UpdateFromPayload(const TexturePayload& payload, const std::vector<uint32_t>& mips);
 
 	void* GetTextureBuffer() const override { return m_pTextureBuffer.Get(); }
 	DirectX::TexMetadata GetMetadata() const { return m_Metadata; }
-	UINT GetDescriptorIndex() const { return descriptorIndex; }
+	/// SRV を作ったステージングヒープのインデックス（描画には DescriptorHeapManager::GatherFrameDescriptors で集めて使う）
+	UINT GetStagingDescriptorIndex() const { return stagingDescriptorIndex; }
+	/// シェーダーから見えるヒープでの SRV のインデックス（バインドレスの描画用）。使えない場合は UINT_MAX
+	UINT GetBindlessDescriptorIndex() const { return bindlessDescriptorIndex; }
 private:
+	/// 作成に成功したリソースを記録し、ResourceAccounting に報告します。
+	bool OnCreated(UINT newDescriptorIndex);
 
 	/// <summary>
 	/// Direct3D 12 のテクスチャリソースを参照する ComPtr<ID3D12Resource> 型のメンバ変数。
 	/// </summary>
 	ComPtr<ID3D12Resource>		m_pTextureBuffer;
 
-	UINT descriptorIndex = -1;
+	UINT stagingDescriptorIndex = -1;
+	UINT bindlessDescriptorIndex = -1;
+	ResourceAccounting::TrackedAllocation m_Allocation;
 
 	DirectX::TexMetadata m_Metadata = {};
 };
@@ -0,0 +1,238 @@
+﻿#include "pch.h"
+#include "DX12TextureLoader.h"
+#include "DX12Texture.h"
+#include "TextureManager.h"
+#include "Source/Dx12RenderDevice.h"
+#include "../Analyzer/TextureCooker.h"
+#include "../System/ContentHash.h"
+
+namespace
+{
+	/// プレースホルダーの色（RGBA8）
+	constexpr uint32_t kPlaceholderColor = 0xFF808080u;
+	/// BC 圧縮のブロックの幅。アトラスのページはブロックがスプライトをまたがない段までにする
+	constexpr uint32_t kBlockSize = 4;
+
+	/// アトラスのページのクック設定。Box フィルタは 2x2 の平均なので、境界にそろえた
+	/// ガターの外の色を混ぜない（Kaiser は裾が隣のスプライトに届く）
+	TextureCooker::Settings GetAtlasPageSettings(uint32_t padding)
+	{
+		TextureCooker::Settings settings;
+		settings.mipFilter = TextureMips::Filter::Box;
+		settings.maxMipCount = TextureAtlas::GetSafeMipCount(padding, kBlockSize);
+		return settings;
+	}
+
+	struct DX12DecodedTexture final : DecodedTexture
+	{
+		TexturePayload payload;
+	};
+}
+
+bool DX12TextureLoader::IsAvailable() const
+{
+	return Dx12RenderDevice::GetDevice() != nullptr;
+}
+
+std::unique_ptr<DecodedTexture> DX12TextureLoader::Decode(const std::string& path)
+{
+	auto decoded = std::make_unique<DX12DecodedTexture>();
+	if (!TextureManager::Get().LoadTexturePayload(std::wstring(path.begin(), path.end()).c_str(), decoded->payload))
+	{
+		return nullptr;
+	}
+	return decoded;
+}
+
+std::shared_ptr<RHITexture> DX12TextureLoader::CreateTexture(const DecodedTexture& decoded)
+{
+	auto texture = std::make_shared<DX12Texture>();
+	if (!texture->CreateFromPayload(static_cast<const DX12DecodedTexture&>(decoded).payload))
+	{
+		return nullptr;
+	}
+	return texture;
+}
+
+std::shared_ptr<RHITexture> DX12TextureLoader::CreateTextureMips(const DecodedTexture& decoded, uint32_t firstMip)
+{
+	auto texture = std::make_shared<DX12Texture>();
+	if (!texture->CreateFromPayload(static_cast<const DX12DecodedTexture&>(decoded).payload, firstMip))
+	{
+		return nullptr;
+	}
+	return texture;
+}
+
+bool DX12TextureLoader::GetMipLayout(const DecodedTexture& decoded, uint32_t& outWidth, uint32_t& outHeight, std::vector<uint64_t>& outMipBytes)
+{
+	const TexturePayload& payload = static_cast<const DX12DecodedTexture&>(decoded).payload;
+	outMipBytes.clear();
+	if (payload.cached.IsValid())
+	{
+		const TextureCacheFormat::CachedTextureHeader& header = payload.cached.GetHeader();
+		outWidth = header.width;
+		outHeight = header.height;
+		for (uint32_t mip = 0; mip < header.mipCount; ++mip)
+		{
+			outMipBytes.push_back(payload.cached.GetMip(mip).slicePitch);
+		}
+		return !outMipBytes.empty();
+	}
+
+	const DirectX::TexMetadata& metadata = payload.image.GetMetadata();
+	if (payload.image.GetImage(0, 0, 0) == nullptr)
+	{
+		return false;
+	}
+	outWidth = static_cast<uint32_t>(metadata.width);
+	outHeight = static_cast<uint32_t>(metadata.height);
+	for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+	{
+		outMipBytes.push_back(payload.image.GetImage(mip, 0, 0)->slicePitch);
+	}
+	return true;
+}
+
+std::filesystem::path DX12TextureLoader::GetSourcePath(const std::string& path)
+{
+	// クック済みの .dds ではなく、アーティストが編集する元の画像を監視する
+	return TextureManager::Get().ResolveTexturePath(std::wstring(path.begin(), path.end()).c_str());
+}
+
+bool DX12TextureLoader::GetMipHashes(const DecodedTexture& decoded, std::vector<uint64_t>& outHashes)
+{
+	const TexturePayload& payload = static_cast<const DX12DecodedTexture&>(decoded).payload;
+	outHashes.clear();
+	if (payload.cached.IsValid())
+	{
+		for (uint32_t mip = 0; mip < payload.cached.GetMipCount(); ++mip)
+		{
+			outHashes.push_back(ContentHash::Compute(payload.cached.GetMipPixels(mip), static_cast<size_t>(payload.cached.GetMip(mip).slicePitch)));
+		}
+		return !outHashes.empty();
+	}
+
+	for (size_t mip = 0; mip < payload.image.GetMetadata().mipLevels; ++mip)
+	{
+		const DirectX::Image* image = payload.image.GetImage(mip, 0, 0);
+		if (image == nullptr)
+		{
+			outHashes.clear();
+			return false;
+		}
+		outHashes.push_back(ContentHash::Compute(image->pixels, image->slicePitch));
+	}
+	return !outHashes.empty();
+}
+
+bool DX12TextureLoader::UpdateTextureMips(RHITexture& texture, const DecodedTexture& decoded, const std::vector<uint32_t>& mips)
+{
+	return static_cast<DX12Texture&>(texture).UpdateFromPayload(static_cast<const DX12DecodedTexture&>(decoded).payload, mips);
+}
+
+std::shared_ptr<RHITexture> DX12TextureLoader::CreatePlaceholderTexture()
+{
+	DirectX::ScratchImage image;
+	if (FAILED(image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1, 1, 1, 1)))
+	{
+		return nullptr;
+	}
+	memcpy(image.GetPixels(), &kPlaceholderColor, sizeof(kPlaceholderColor));
+
+	auto texture = std::make_shared<DX12Texture>();
+	if (!texture->CreateFromImage(image))
+	{
+		LOG_DEBUG("DX12TextureLoader: failed to create placeholder texture");
+		return nullptr;
+	}
+	return texture;
+}
+
+bool DX12TextureLoader::DecodePixels(const std::string& path, TextureAtlas::Image& outImage)
+{
+	// 組み込みのデコーダーで扱える形式は、元画像から outImage へ直接デコードする
+	// （クック済みの .dds はブロック圧縮を戻す分だけ遅く、画質も落ちる）
+	const std::filesystem::path resolvedPath = TextureManager::Get().ResolveTexturePath(std::wstring(path.begin(), path.end()).c_str());
+	if (!resolvedPath.empty())
+	{
+		ImageInfo info;
+		if (ImageDecoderRegistry::Get().DecodeFile(resolvedPath, info, outImage.pixels) == ImageDecodeStatus::Decoded)
+		{
+			outImage.width = info.width;
+			outImage.height = info.height;
+			return true;
+		}
+	}
+
+	DirectX::ScratchImage image;
+	if (!TextureManager::Get().DecodeTextureFile(std::wstring(path.begin(), path.end()).c_str(), image))
+	{
+		return false;
+	}
+
+	// クック済みの .dds は圧縮されているので、詰める前に RGBA8 に戻す
+	const DirectX::Image* source = image.GetImage(0, 0, 0);
+	DirectX::ScratchImage converted;
+	if (DirectX::IsCompressed(source->format))
+	{
+		if (FAILED(DirectX::Decompress(*source, DXGI_FORMAT_R8G8B8A8_UNORM, converted)))
+		{
+			return false;
+		}
+		source = converted.GetImage(0, 0, 0);
+	}
+	else if (source->format != DXGI_FORMAT_R8G8B8A8_UNORM)
+	{
+		if (FAILED(DirectX::Convert(*source, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted)))
+		{
+			return false;
+		}
+		source = converted.GetImage(0, 0, 0);
+	}
+
+	outImage.width = static_cast<uint32_t>(source->width);
+	outImage.height = static_cast<uint32_t>(source->height);
+	outImage.pixels.resize(static_cast<size_t>(outImage.width) * outImage.height * 4);
+	const size_t packedPitch = static_cast<size_t>(outImage.width) * 4;
+	for (uint32_t y = 0; y < outImage.height; ++y)
+	{
+		memcpy(&outImage.pixels[y * packedPitch], source->pixels + y * source->rowPitch, packedPitch);
+	}
+	return true;
+}
+
+std::unique_ptr<DecodedTexture> DX12TextureLoader::DecodeAtlasPage(const TextureAtlas::Image& page, uint32_t padding)
+{
+	DirectX::ScratchImage source;
+	if (FAILED(source.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM, page.width, page.height, 1, 1)))
+	{
+		return nullptr;
+	}
+	const DirectX::Image* target = source.GetImage(0, 0, 0);
+	const size_t packedPitch = static_cast<size_t>(page.width) * 4;
+	for (uint32_t y = 0; y < page.height; ++y)
+	{
+		memcpy(target->pixels + y * target->rowPitch, &page.pixels[y * packedPitch], packedPitch);
+	}
+
+	auto decoded = std::make_unique<DX12DecodedTexture>();
+	std::string error;
+	if (!TextureCooker::Cook(source, GetAtlasPageSettings(padding), decoded->payload.image, nullptr, &error))
+	{
+		LOG_DEBUG("DX12TextureLoader: failed to cook atlas page (%s)", error.c_str());
+		return nullptr;
+	}
+	return decoded;
+}
+
+bool DX12TextureLoader::LoadAtlasManifest(const std::string& path, TextureAtlas::Manifest& outManifest)
+{
+	const std::filesystem::path resolvedPath = TextureManager::Get().ResolveTexturePath(std::wstring(path.begin(), path.end()).c_str());
+	if (resolvedPath.empty() || !ITextureLoader::LoadAtlasManifest(resolvedPath.string(), outManifest))
+	{
+		LOG_DEBUG("DX12TextureLoader: failed to load atlas manifest %s", path.c_str());
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,30 @@
+﻿#pragma once
+
+#include "TextureAssetManager.h"
+
+///=======================================================================
+/// <summary>
+/// TextureAssetManager の DX12 用ローダー。
+/// TextureCache の参照と WIC でのデコードはワーカーで行い、リソースと SRV の作成は描画スレッドで
+/// TextureManager に任せます。プレースホルダーは 1x1 の灰色です。
+/// アトラスのページは Box フィルタでミップを作り、ガターが残る段までで止めます。
+/// 常駐するミップを減らすときは、細かいミップを除いた小さなリソースを作り直します（タイルリソースは使いません）。
+/// ホットリロードでは、同じ大きさと形式のテクスチャは今のリソースの変わったミップだけを書き換えます。
+/// </summary>
+///=======================================================================
+class DX12TextureLoader final : public ITextureLoader
+{
+public:
+	bool IsAvailable() const override;
+	std::unique_ptr<DecodedTexture> Decode(const std::string& path) override;
+	std::shared_ptr<RHITexture> CreateTexture(const DecodedTexture& decoded) override;
+	std::shared_ptr<RHITexture> CreatePlaceholderTexture() override;
+	bool DecodePixels(const std::string& path, TextureAtlas::Image& outImage) override;
+	std::unique_ptr<DecodedTexture> DecodeAtlasPage(const TextureAtlas::Image& page, uint32_t padding) override;
+	bool LoadAtlasManifest(const std::string& path, TextureAtlas::Manifest& outManifest) override;
+	bool GetMipLayout(const DecodedTexture& decoded, uint32_t& outWidth, uint32_t& outHeight, std::vector<uint64_t>& outMipBytes) override;
+	std::shared_ptr<RHITexture> CreateTextureMips(const DecodedTexture& decoded, uint32_t firstMip) override;
+	std::filesystem::path GetSourcePath(const std::string& path) override;
+	bool GetMipHashes(const DecodedTexture& decoded, std::vector<uint64_t>& outHashes) override;
+	bool UpdateTextureMips(RHITexture& texture, const DecodedTexture& decoded, const std::vector<uint32_t>& mips) override;
+};
@@ -0,0 +1,283 @@
+﻿#include "pch.h"
+#include "DX12UploadBackend.h"
+
+namespace
+{
+	/// 同時に実行中にできる提出の数
+	constexpr size_t kAllocatorCount = 3;
+	/// WaitForFence の上限（ミリ秒）。デバイス消失時に戻れるようにする
+	constexpr DWORD kFenceWaitTimeoutMs = 5000;
+}
+
+DX12UploadBackend::~DX12UploadBackend()
+{
+	Shutdown();
+}
+
+///====================================================================
+/// <summary>
+/// コピーキュー・フェンス・ステージングバッファを作成します。
+/// </summary>
+/// <param name="stagingSize">ステージングバッファのバイト数</param>
+///====================================================================
+bool DX12UploadBackend::Initialize(ID3D12Device* device, UINT64 stagingSize)
+{
+	Shutdown();
+	if (device == nullptr || stagingSize == 0)
+	{
+		return false;
+	}
+	m_pDevice = device;
+
+	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
+	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
+	if (FAILED(device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&m_pQueue))))
+	{
+		LOG_DEBUG("DX12UploadBackend: failed to create copy queue");
+		Shutdown();
+		return false;
+	}
+
+	m_Allocators.resize(kAllocatorCount);
+	for (AllocatorEntry& entry : m_Allocators)
+	{
+		if (FAILED(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&entry.allocator))))
+		{
+			LOG_DEBUG("DX12UploadBackend: failed to create command allocator");
+			Shutdown();
+			return false;
+		}
+	}
+	if (FAILED(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, m_Allocators[0].allocator.Get(), nullptr, IID_PPV_ARGS(&m_pCommandList))))
+	{
+		LOG_DEBUG("DX12UploadBackend: failed to create command list");
+		Shutdown();
+		return false;
+	}
+	// 記録は最初のコピーで開始する
+	m_pCommandList->Close();
+
+	if (FAILED(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_pFence))))
+	{
+		LOG_DEBUG("DX12UploadBackend: failed to create fence");
+		Shutdown();
+		return false;
+	}
+	m_FenceEvent = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (m_FenceEvent == nullptr)
+	{
+		Shutdown();
+		return false;
+	}
+
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(stagingSize);
+	if (FAILED(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&m_pStagingBuffer))))
+	{
+		LOG_DEBUG("DX12UploadBackend: failed to create staging buffer");
+		Shutdown();
+		return false;
+	}
+	// UPLOAD ヒープは破棄までマップしたままでよい
+	const D3D12_RANGE readRange = { 0, 0 };
+	if (FAILED(m_pStagingBuffer->Map(0, &readRange, reinterpret_cast<void**>(&m_pStagingData))))
+	{
+		LOG_DEBUG("DX12UploadBackend: failed to map staging buffer");
+		Shutdown();
+		return false;
+	}
+	m_StagingSize = stagingSize;
+	m_StagingAllocation = TrackD3D12Resource(device, m_pStagingBuffer.Get(), ResourceCategory::UploadBuffer, "DX12UploadBackend");
+	return true;
+}
+
+void DX12UploadBackend::Shutdown()
+{
+	if (m_pFence != nullptr && m_NextFenceValue > 1)
+	{
+		WaitForFence(m_NextFenceValue - 1);
+	}
+	if (m_pStagingBuffer != nullptr && m_pStagingData != nullptr)
+	{
+		m_pStagingBuffer->Unmap(0, nullptr);
+	}
+	m_pStagingData = nullptr;
+	m_pStagingBuffer.Reset();
+	m_StagingAllocation.Reset();
+	m_StagingSize = 0;
+	if (m_FenceEvent != nullptr)
+	{
+		CloseHandle(m_FenceEvent);
+		m_FenceEvent = nullptr;
+	}
+	m_pFence.Reset();
+	m_NextFenceValue = 1;
+	m_pCommandList.Reset();
+	m_Allocators.clear();
+	m_CurrentAllocator = 0;
+	m_IsRecording = false;
+	m_pQueue.Reset();
+	m_pDevice.Reset();
+}
+
+void DX12UploadBackend::RecordBufferCopy(void* destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size)
+{
+	if (!m_IsRecording && !BeginRecording())
+	{
+		return;
+	}
+	m_pCommandList->CopyBufferRegion(static_cast<ID3D12Resource*>(destination), destinationOffset,
+		m_pStagingBuffer.Get(), stagingOffset, size);
+}
+
+void DX12UploadBackend::RecordTextureCopy(void* destination, uint32_t subresource, uint32_t destinationY, uint64_t stagingOffset, const TextureFootprint& footprint)
+{
+	if (!m_IsRecording && !BeginRecording())
+	{
+		return;
+	}
+	D3D12_TEXTURE_COPY_LOCATION source = {};
+	source.pResource = m_pStagingBuffer.Get();
+	source.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+	source.PlacedFootprint.Offset = stagingOffset;
+	source.PlacedFootprint.Footprint.Format = static_cast<DXGI_FORMAT>(footprint.format);
+	source.PlacedFootprint.Footprint.Width = footprint.width;
+	source.PlacedFootprint.Footprint.Height = footprint.height;
+	source.PlacedFootprint.Footprint.Depth = 1;
+	source.PlacedFootprint.Footprint.RowPitch = footprint.rowPitch;
+
+	D3D12_TEXTURE_COPY_LOCATION target = {};
+	target.pResource = static_cast<ID3D12Resource*>(destination);
+	target.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+	target.SubresourceIndex = subresource;
+	m_pCommandList->CopyTextureRegion(&target, 0, destinationY, 0, &source, nullptr);
+}
+
+uint64_t DX12UploadBackend::Submit()
+{
+	const UINT64 fenceValue = m_NextFenceValue++;
+	if (m_IsRecording)
+	{
+		m_pCommandList->Close();
+		ID3D12CommandList* commandLists[] = { m_pCommandList.Get() };
+		m_pQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
+		m_Allocators[m_CurrentAllocator].fenceValue = fenceValue;
+		m_CurrentAllocator = (m_CurrentAllocator + 1) % m_Allocators.size();
+		m_IsRecording = false;
+	}
+	m_pQueue->Signal(m_pFence.Get(), fenceValue);
+	return fenceValue;
+}
+
+uint64_t DX12UploadBackend::GetCompletedFenceValue()
+{
+	return m_pFence != nullptr ? m_pFence->GetCompletedValue() : 0;
+}
+
+void DX12UploadBackend::WaitForFence(uint64_t fenceValue)
+{
+	if (m_pFence == nullptr || m_pFence->GetCompletedValue() >= fenceValue)
+	{
+		return;
+	}
+	if (SUCCEEDED(m_pFence->SetEventOnCompletion(fenceValue, m_FenceEvent)))
+	{
+		WaitForSingleObject(m_FenceEvent, kFenceWaitTimeoutMs);
+	}
+}
+
+bool DX12UploadBackend::BeginRecording()
+{
+	AllocatorEntry& entry = m_Allocators[m_CurrentAllocator];
+	WaitForFence(entry.fenceValue);
+	if (FAILED(entry.allocator->Reset()) || FAILED(m_pCommandList->Reset(entry.allocator.Get(), nullptr)))
+	{
+		LOG_DEBUG("DX12UploadBackend: failed to reset command list");
+		return false;
+	}
+	m_IsRecording = true;
+	return true;
+}
+
+HRESULT CreateStaticBuffer(ID3D12Device* device, GpuUploadQueue* uploadQueue, const void* data, UINT64 size,
+	Microsoft::WRL::ComPtr<ID3D12Resource>& outBuffer, bool* outIsDefaultHeap)
+{
+	if (outIsDefaultHeap != nullptr)
+	{
+		*outIsDefaultHeap = false;
+	}
+	if (device == nullptr || data == nullptr || size == 0)
+	{
+		return E_INVALIDARG;
+	}
+
+	CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(size);
+	if (uploadQueue != nullptr)
+	{
+		CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_DEFAULT);
+		HRESULT hr = device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+			D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&outBuffer));
+		if (FAILED(hr))
+		{
+			return hr;
+		}
+		if (!uploadQueue->UploadBuffer(outBuffer.Get(), 0, data, size))
+		{
+			outBuffer.Reset();
+			return E_FAIL;
+		}
+		if (outIsDefaultHeap != nullptr)
+		{
+			*outIsDefaultHeap = true;
+		}
+		return S_OK;
+	}
+
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+	HRESULT hr = device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE, &resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&outBuffer));
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+	unsigned char* mapped = nullptr;
+	const D3D12_RANGE readRange = { 0, 0 };
+	hr = outBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped));
+	if (FAILED(hr))
+	{
+		outBuffer.Reset();
+		return hr;
+	}
+	memcpy(mapped, data, static_cast<size_t>(size));
+	const D3D12_RANGE writtenRange = { 0, static_cast<SIZE_T>(size) };
+	outBuffer->Unmap(0, &writtenRange);
+	return S_OK;
+}
+
+ResourceAccounting::TrackedAllocation TrackD3D12Resource(ID3D12Device* device, ID3D12Resource* resource,
+	ResourceCategory category, const char* owner, UINT64 requestedBytes)
+{
+	if (device == nullptr || resource == nullptr)
+	{
+		return {};
+	}
+
+	const D3D12_RESOURCE_DESC desc = resource->GetDesc();
+	if (requestedBytes == 0)
+	{
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			requestedBytes = desc.Width;
+		}
+		else
+		{
+			const UINT subresourceCount = desc.MipLevels *
+				(desc.Dimension == D3D12_RESOURCE_DIMENSION_TEXTURE3D ? 1u : desc.DepthOrArraySize);
+			device->GetCopyableFootprints(&desc, 0, subresourceCount, 0, nullptr, nullptr, nullptr, &requestedBytes);
+		}
+	}
+	const D3D12_RESOURCE_ALLOCATION_INFO allocationInfo = device->GetResourceAllocationInfo(0, 1, &desc);
+	return ResourceAccounting::Get().TrackScoped(category, "DirectX12", owner, requestedBytes, allocationInfo.SizeInBytes);
+}
@@ -0,0 +1,95 @@
+﻿#pragma once
+
+#include "GpuUploadQueue.h"
+#include "../System/ResourceAccounting.h"
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// GpuUploadQueue の DX12 実装。
+/// 専用のコピーコマンドキューとフェンス、常にマップした UPLOAD ヒープの
+/// ステージングバッファを持ちます。コマンドアロケーターは提出ごとに切り替え、
+/// フェンスの完了を確認してから再利用します。
+/// コピー先のバッファ・テクスチャーは COMMON 状態で作成すること（コピーキューでの暗黙の状態遷移を使うため）。
+/// </summary>
+///=======================================================================
+class DX12UploadBackend final : public IGpuUploadBackend
+{
+public:
+	/// ステージングバッファの既定サイズ
+	static constexpr UINT64 kDefaultStagingSize = 16ull * 1024 * 1024;
+
+	DX12UploadBackend() = default;
+	~DX12UploadBackend() override;
+
+	// コピー禁止
+	DX12UploadBackend(const DX12UploadBackend&) = delete;
+	DX12UploadBackend& operator=(const DX12UploadBackend&) = delete;
+
+	bool Initialize(ID3D12Device* device, UINT64 stagingSize = kDefaultStagingSize);
+	void Shutdown();
+
+	/// グラフィックスキューから待つためのフェンス
+	ID3D12Fence* GetFence() const { return m_pFence.Get(); }
+
+	uint8_t* GetStagingData() override { return m_pStagingData; }
+	uint64_t GetStagingSize() const override { return m_StagingSize; }
+	void RecordBufferCopy(void* destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size) override;
+	void RecordTextureCopy(void* destination, uint32_t subresource, uint32_t destinationY, uint64_t stagingOffset, const TextureFootprint& footprint) override;
+	uint64_t Submit() override;
+	uint64_t GetCompletedFenceValue() override;
+	void WaitForFence(uint64_t fenceValue) override;
+
+private:
+	struct AllocatorEntry
+	{
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		UINT64 fenceValue = 0;		// この値の完了後に再利用できる
+	};
+
+	/// 完了済みのアロケーターでコマンドリストを開きます。
+	bool BeginRecording();
+
+	Microsoft::WRL::ComPtr<ID3D12Device>				m_pDevice;
+	Microsoft::WRL::ComPtr<ID3D12CommandQueue>			m_pQueue;
+	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>	m_pCommandList;
+	std::vector<AllocatorEntry>							m_Allocators;
+	size_t												m_CurrentAllocator = 0;
+	bool												m_IsRecording = false;
+
+	Microsoft::WRL::ComPtr<ID3D12Fence>	m_pFence;
+	UINT64								m_NextFenceValue = 1;
+	HANDLE								m_FenceEvent = nullptr;
+
+	Microsoft::WRL::ComPtr<ID3D12Resource>	m_pStagingBuffer;
+	uint8_t*								m_pStagingData = nullptr;
+	UINT64									m_StagingSize = 0;
+	ResourceAccounting::TrackedAllocation	m_StagingAllocation;
+};
+
+///====================================================================
+/// <summary>
+/// 内容を書き換えないバッファを作成して data を書き込みます。
+/// 転送キューがあれば DEFAULT ヒープ（COMMON 状態）に作成してコピーを予約し、
+/// 無ければ UPLOAD ヒープに作成して直接書き込みます。
+/// </summary>
+/// <param name="uploadQueue">Dx12RenderDevice::GetUploadQueue()（null 可）</param>
+/// <param name="outIsDefaultHeap">DEFAULT ヒープに作成した場合は true（null 可）</param>
+///====================================================================
+HRESULT CreateStaticBuffer(ID3D12Device* device, GpuUploadQueue* uploadQueue, const void* data, UINT64 size,
+	Microsoft::WRL::ComPtr<ID3D12Resource>& outBuffer, bool* outIsDefaultHeap = nullptr);
+
+///====================================================================
+/// <summary>
+/// 作成したリソースを ResourceAccounting に DirectX12 のものとして報告します。
+/// 確保量は GetResourceAllocationInfo の値（コミット済みのバッファは 64KB 単位）です。
+/// </summary>
+/// <param name="requestedBytes">データとして必要なバイト数。0 ならバッファは幅、テクスチャーは全ミップのコピーに要るバイト数</param>
+/// <returns>リソースと同じだけ持っておく報告（device か resource が null なら空）</returns>
+///====================================================================
+ResourceAccounting::TrackedAllocation TrackD3D12Resource(ID3D12Device* device, ID3D12Resource* resource,
+	ResourceCategory category, const char* owner, UINT64 requestedBytes = 0);
@@ -0,0 +1,261 @@
+﻿#include "DescriptorAllocator.h"
+
+#include "../System/ContentHash.h"
+
+#include <algorithm>
+#include <iterator>
+
+void DescriptorAllocator::Reset(const DescriptorAllocatorDesc& desc)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Desc = desc;
+	m_Desc.maxPageCount = std::max(m_Desc.maxPageCount, 1u);
+	m_Desc.initialPageCount = std::min(std::max(m_Desc.initialPageCount, 1u), m_Desc.maxPageCount);
+	m_PersistentLimit = m_Desc.pageSize * m_Desc.maxPageCount;
+	m_PageCount = 0;
+	m_FreeRanges.clear();
+	m_FreeCount = 0;
+	m_PendingFrees.clear();
+	m_PendingFreeCount = 0;
+	m_PeakUsedCount = 0;
+	m_FailedAllocationCount = 0;
+	m_FrameFenceValue = 0;
+	m_CompletedFenceValue = 0;
+	m_FrameIndex = 0;
+	m_FrameBase = m_PersistentLimit;
+	m_FrameCursor.store(0, std::memory_order_relaxed);
+	m_FramePeakCount = 0;
+	m_FrameOverflowCount.store(0, std::memory_order_relaxed);
+	if (m_Desc.pageSize == 0)
+	{
+		return;
+	}
+	while (m_PageCount < m_Desc.initialPageCount)
+	{
+		GrowLocked();
+	}
+}
+
+void DescriptorAllocator::Reset()
+{
+	Reset(DescriptorAllocatorDesc{ 0, 0, 0, 0, 0 });
+}
+
+///====================================================================
+/// <summary>
+/// 収まる空きのうち最も小さいものの先頭から切り出します。ディスクリプタは 1 個ずつの確保が
+/// ほとんどなので、大きな空きを残しておくと後から来る連続した確保が収まりやすくなります。
+/// </summary>
+///====================================================================
+uint32_t DescriptorAllocator::Allocate(uint32_t count)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (count == 0 || count > m_Desc.pageSize)
+	{
+		++m_FailedAllocationCount;
+		return kInvalidIndex;
+	}
+
+	for (;;)
+	{
+		auto best = m_FreeRanges.end();
+		for (auto it = m_FreeRanges.begin(); it != m_FreeRanges.end(); ++it)
+		{
+			if (it->second >= count && (best == m_FreeRanges.end() || it->second < best->second))
+			{
+				best = it;
+				if (best->second == count)
+				{
+					break;
+				}
+			}
+		}
+
+		if (best != m_FreeRanges.end())
+		{
+			const uint32_t first = best->first;
+			const uint32_t remaining = best->second - count;
+			m_FreeRanges.erase(best);
+			if (remaining > 0)
+			{
+				m_FreeRanges.emplace(first + count, remaining);
+			}
+			m_FreeCount -= count;
+			const uint32_t usedCount = m_PageCount * m_Desc.pageSize - m_FreeCount - m_PendingFreeCount;
+			m_PeakUsedCount = std::max(m_PeakUsedCount, usedCount);
+			return first;
+		}
+
+		if (!GrowLocked())
+		{
+			++m_FailedAllocationCount;
+			return kInvalidIndex;
+		}
+	}
+}
+
+void DescriptorAllocator::Free(uint32_t first, uint32_t count)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const uint32_t capacity = m_PageCount * m_Desc.pageSize;
+	if (count == 0 || first >= capacity || count > capacity - first)
+	{
+		return;
+	}
+
+	if (m_FrameFenceValue <= m_CompletedFenceValue)
+	{
+		// まだフレームを始めていない（GPU に渡したことがない）
+		ReleaseRangeLocked(first, count);
+		return;
+	}
+	m_PendingFrees.push_back({ first, count, m_FrameFenceValue });
+	m_PendingFreeCount += count;
+}
+
+uint32_t DescriptorAllocator::AllocateFrame(uint32_t count)
+{
+	if (count == 0 || count > m_Desc.frameDescriptorCount)
+	{
+		m_FrameOverflowCount.fetch_add(1, std::memory_order_relaxed);
+		return kInvalidIndex;
+	}
+
+	const uint32_t offset = m_FrameCursor.fetch_add(count, std::memory_order_relaxed);
+	if (offset > m_Desc.frameDescriptorCount - count)
+	{
+		// 溢れた分は戻さない（他のスレッドが後ろで確保しているかもしれない）。BeginFrame で戻る
+		m_FrameOverflowCount.fetch_add(1, std::memory_order_relaxed);
+		return kInvalidIndex;
+	}
+	return m_FrameBase + offset;
+}
+
+void DescriptorAllocator::BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_CompletedFenceValue = std::max(m_CompletedFenceValue, completedFenceValue);
+	m_FrameFenceValue = std::max(m_FrameFenceValue, frameFenceValue);
+	ReleaseCompletedLocked(m_CompletedFenceValue);
+
+	if (m_Desc.frameCount == 0)
+	{
+		return;
+	}
+	const uint32_t usedCount = std::min(m_FrameCursor.load(std::memory_order_relaxed), m_Desc.frameDescriptorCount);
+	m_FramePeakCount = std::max(m_FramePeakCount, usedCount);
+	m_FrameIndex = (m_FrameIndex + 1) % m_Desc.frameCount;
+	m_FrameBase = m_PersistentLimit + m_FrameIndex * m_Desc.frameDescriptorCount;
+	m_FrameCursor.store(0, std::memory_order_relaxed);
+}
+
+DescriptorAllocatorStatistics DescriptorAllocator::GetStatistics() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	DescriptorAllocatorStatistics statistics;
+	statistics.pageSize = m_Desc.pageSize;
+	statistics.pageCount = m_PageCount;
+	statistics.maxPageCount = m_Desc.maxPageCount;
+	statistics.capacity = m_PageCount * m_Desc.pageSize;
+	statistics.freeCount = m_FreeCount;
+	statistics.pendingFreeCount = m_PendingFreeCount;
+	statistics.usedCount = statistics.capacity - m_FreeCount - m_PendingFreeCount;
+	statistics.peakUsedCount = m_PeakUsedCount;
+	statistics.freeRangeCount = static_cast<uint32_t>(m_FreeRanges.size());
+	for (const auto& range : m_FreeRanges)
+	{
+		statistics.largestFreeRange = std::max(statistics.largestFreeRange, range.second);
+	}
+	if (m_FreeCount > 0)
+	{
+		const uint32_t reachable = std::min(m_FreeCount, m_Desc.pageSize);
+		statistics.fragmentation = 1.0f - static_cast<float>(statistics.largestFreeRange) / static_cast<float>(reachable);
+	}
+	statistics.failedAllocationCount = m_FailedAllocationCount;
+
+	statistics.frameDescriptorCount = m_Desc.frameDescriptorCount;
+	statistics.frameUsedCount = std::min(m_FrameCursor.load(std::memory_order_relaxed), m_Desc.frameDescriptorCount);
+	statistics.framePeakCount = std::max(m_FramePeakCount, statistics.frameUsedCount);
+	statistics.frameOverflowCount = m_FrameOverflowCount.load(std::memory_order_relaxed);
+	return statistics;
+}
+
+void DescriptorAllocator::ReleaseRangeLocked(uint32_t first, uint32_t count)
+{
+	m_FreeCount += count;
+	const uint32_t page = first / m_Desc.pageSize;
+	auto next = m_FreeRanges.lower_bound(first);
+	if (next != m_FreeRanges.begin())
+	{
+		const auto previous = std::prev(next);
+		if (previous->first + previous->second == first && previous->first / m_Desc.pageSize == page)
+		{
+			first = previous->first;
+			count += previous->second;
+			m_FreeRanges.erase(previous);
+		}
+	}
+	if (next != m_FreeRanges.end() && first + count == next->first && next->first / m_Desc.pageSize == page)
+	{
+		count += next->second;
+		next = m_FreeRanges.erase(next);
+	}
+	m_FreeRanges.emplace_hint(next, first, count);
+}
+
+void DescriptorAllocator::ReleaseCompletedLocked(uint64_t completedFenceValue)
+{
+	while (!m_PendingFrees.empty() && m_PendingFrees.front().fenceValue <= completedFenceValue)
+	{
+		const PendingFree pending = m_PendingFrees.front();
+		m_PendingFrees.pop_front();
+		m_PendingFreeCount -= pending.count;
+		ReleaseRangeLocked(pending.first, pending.count);
+	}
+}
+
+bool DescriptorAllocator::GrowLocked()
+{
+	if (m_Desc.pageSize == 0 || m_PageCount >= m_Desc.maxPageCount)
+	{
+		return false;
+	}
+	ReleaseRangeLocked(m_PageCount * m_Desc.pageSize, m_Desc.pageSize);
+	++m_PageCount;
+	return true;
+}
+
+uint32_t DescriptorTableCache::Find(const uint32_t* indices, uint32_t count) const
+{
+	const auto range = m_Tables.equal_range(ComputeKey(indices, count));
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		const Table& table = it->second;
+		if (table.count == count && std::equal(indices, indices + count, m_Indices.begin() + table.offset))
+		{
+			return table.tableIndex;
+		}
+	}
+	return DescriptorAllocator::kInvalidIndex;
+}
+
+void DescriptorTableCache::Insert(const uint32_t* indices, uint32_t count, uint32_t tableIndex)
+{
+	Table table;
+	table.offset = static_cast<uint32_t>(m_Indices.size());
+	table.count = count;
+	table.tableIndex = tableIndex;
+	m_Indices.insert(m_Indices.end(), indices, indices + count);
+	m_Tables.emplace(ComputeKey(indices, count), table);
+}
+
+void DescriptorTableCache::Clear()
+{
+	m_Tables.clear();
+	m_Indices.clear();
+}
+
+uint64_t DescriptorTableCache::ComputeKey(const uint32_t* indices, uint32_t count)
+{
+	return ContentHash::Compute(indices, sizeof(uint32_t) * count);
+}
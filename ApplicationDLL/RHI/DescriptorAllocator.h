@@ -0,0 +1,185 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// DescriptorAllocator の区切り方。インデックスは永続領域（ページ × 最大ページ数）の後ろに
+/// フレームごとの領域を frameCount 個並べます。ヒープはこの合計の大きさで作ります。
+/// </summary>
+///=======================================================================
+struct DescriptorAllocatorDesc
+{
+	/// 連続した確保はページをまたがないので、一度に確保できる最大数でもある
+	uint32_t pageSize = 1024;
+	uint32_t initialPageCount = 1;
+	uint32_t maxPageCount = 16;
+	/// フレームごとの領域の数（GPU が同時に扱うフレーム数以上）
+	uint32_t frameCount = 2;
+	uint32_t frameDescriptorCount = 1024;
+};
+
+struct DescriptorAllocatorStatistics
+{
+	uint32_t pageSize = 0;
+	uint32_t pageCount = 0;
+	uint32_t maxPageCount = 0;
+	/// 使い始めたページの合計
+	uint32_t capacity = 0;
+	uint32_t usedCount = 0;
+	uint32_t peakUsedCount = 0;
+	uint32_t freeCount = 0;
+	/// 解放されたが、フェンスの完了を待っている数
+	uint32_t pendingFreeCount = 0;
+	uint32_t freeRangeCount = 0;
+	uint32_t largestFreeRange = 0;
+	/// 1 - 最大の空き / min(空きの合計, ページ)。範囲はページをまたがないので、
+	/// 空きがページいっぱいまでまとまっていれば 0
+	float fragmentation = 0.0f;
+
+	uint32_t frameDescriptorCount = 0;
+	/// 今のフレームで確保した数と、これまでのフレームの最大（溢れたフレームは領域の大きさ）
+	uint32_t frameUsedCount = 0;
+	uint32_t framePeakCount = 0;
+	/// フレームの領域に収まらなかった確保の回数
+	uint64_t frameOverflowCount = 0;
+	/// 永続領域が最大ページ数まで埋まって失敗した確保の回数
+	uint64_t failedAllocationCount = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// シェーダーから見えるディスクリプタヒープのインデックスを割り当てるアロケーター。
+/// 永続領域はページ単位で伸び、連続した N 個を最も小さく収まる空きから切り出します。
+/// 解放は今のフレームのフェンスと結び付け、BeginFrame にその完了が渡されるまで再利用しません
+/// （記録済みのコマンドリストがまだ参照しているかもしれないため）。
+/// フレームの領域はフレームの間だけ使うディスクリプタ用で、ロックを取らずに先頭から切り出し、
+/// 同じ領域を次に使うフレームの BeginFrame でまとめて捨てます。
+/// GPU の API には依存しないため、単体で動作を確認できます。
+/// </summary>
+///=======================================================================
+class DescriptorAllocator
+{
+public:
+	static constexpr uint32_t kInvalidIndex = UINT32_MAX;
+
+	DescriptorAllocator() = default;
+	explicit DescriptorAllocator(const DescriptorAllocatorDesc& desc) { Reset(desc); }
+
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+	/// 区切り方を設定し、確保をすべて破棄します。
+	void Reset(const DescriptorAllocatorDesc& desc);
+	/// 何も確保できない状態に戻します（以降の Free は無視されます）。
+	void Reset();
+
+	///====================================================================
+	/// <summary>
+	/// 永続領域から連続した count 個を確保します。収まる空きが無ければページを足します。
+	/// </summary>
+	/// <returns>先頭のインデックス。count が 0 かページより大きい場合、最大ページ数まで埋まっている場合は kInvalidIndex</returns>
+	///====================================================================
+	uint32_t Allocate(uint32_t count = 1);
+
+	/// Allocate で確保した範囲を、今のフレームのフェンスが完了したら再利用できるようにします。
+	void Free(uint32_t first, uint32_t count = 1);
+
+	///====================================================================
+	/// <summary>
+	/// 今のフレームの領域から連続した count 個を確保します。ロックを取らないので
+	/// 複数のスレッドから同時に呼べますが、BeginFrame と同時に呼んではいけません。
+	/// </summary>
+	/// <returns>先頭のインデックス。領域に収まらなければ kInvalidIndex</returns>
+	///====================================================================
+	uint32_t AllocateFrame(uint32_t count = 1);
+
+	///====================================================================
+	/// <summary>
+	/// 新しいフレームを始めます。completedFenceValue までに完了したフレームで解放された範囲を
+	/// 空きに戻し、次のフレームの領域を空にします。次の領域を最後に使ったフレームは
+	/// 完了している必要があります（frameCount 以上前のフレームのフェンスを待ってから呼ぶこと）。
+	/// </summary>
+	/// <param name="frameFenceValue">これから記録するフレームの終わりに Signal するフェンス値</param>
+	/// <param name="completedFenceValue">完了したフェンス値</param>
+	///====================================================================
+	void BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue);
+
+	/// ヒープに必要なディスクリプタの数（永続領域の最大 + フレームの領域すべて）
+	uint32_t GetTotalDescriptorCount() const { return m_PersistentLimit + m_Desc.frameCount * m_Desc.frameDescriptorCount; }
+	const DescriptorAllocatorDesc& GetDesc() const { return m_Desc; }
+	DescriptorAllocatorStatistics GetStatistics() const;
+
+private:
+	struct PendingFree
+	{
+		uint32_t first = 0;
+		uint32_t count = 0;
+		uint64_t fenceValue = 0;
+	};
+
+	/// 空きに戻し、同じページの隣の空きとつなげる。m_Mutex を持って呼ぶ
+	void ReleaseRangeLocked(uint32_t first, uint32_t count);
+	void ReleaseCompletedLocked(uint64_t completedFenceValue);
+	bool GrowLocked();
+
+	mutable std::mutex m_Mutex;
+	DescriptorAllocatorDesc m_Desc = { 0, 0, 0, 0, 0 };
+	/// 永続領域の最大（pageSize × maxPageCount）
+	uint32_t m_PersistentLimit = 0;
+	uint32_t m_PageCount = 0;
+	/// 先頭 -> 個数。ページをまたいではつなげない
+	std::map<uint32_t, uint32_t> m_FreeRanges;
+	uint32_t m_FreeCount = 0;
+	/// フェンス値の順に並ぶ
+	std::deque<PendingFree> m_PendingFrees;
+	uint32_t m_PendingFreeCount = 0;
+	uint32_t m_PeakUsedCount = 0;
+	uint64_t m_FailedAllocationCount = 0;
+	uint64_t m_FrameFenceValue = 0;
+	uint64_t m_CompletedFenceValue = 0;
+
+	uint32_t m_FrameIndex = 0;
+	uint32_t m_FrameBase = 0;
+	std::atomic<uint32_t> m_FrameCursor{ 0 };
+	uint32_t m_FramePeakCount = 0;
+	std::atomic<uint64_t> m_FrameOverflowCount{ 0 };
+};
+
+///=======================================================================
+/// <summary>
+/// フレームの領域へ集めたディスクリプタテーブルを、元のインデックスの並びで引けるようにします。
+/// 同じテクスチャーを使う描画（アトラスのスプライトなど）が 1 つのテーブルを共有し、
+/// コピーが組み合わせごとに 1 回で済みます。フレームが変わったら Clear します。
+/// </summary>
+///=======================================================================
+class DescriptorTableCache
+{
+public:
+	/// 見つからなければ DescriptorAllocator::kInvalidIndex
+	uint32_t Find(const uint32_t* indices, uint32_t count) const;
+	void Insert(const uint32_t* indices, uint32_t count, uint32_t tableIndex);
+	void Clear();
+	size_t GetTableCount() const { return m_Tables.size(); }
+
+private:
+	struct Table
+	{
+		/// 並びは m_Indices の [offset, offset + count)
+		uint32_t offset = 0;
+		uint32_t count = 0;
+		uint32_t tableIndex = 0;
+	};
+
+	static uint64_t ComputeKey(const uint32_t* indices, uint32_t count);
+
+	/// 並びのハッシュごと
+	std::unordered_multimap<uint64_t, Table> m_Tables;
+	std::vector<uint32_t> m_Indices;
+};
@@ -1,7 +1,11 @@
 ﻿#include "DescriptorHeapManager.h"
 
+#include <cstdio>
+
 DescriptorHeapManager& DescriptorHeapManager::Get()
 {
+    // ヒープの報告を持つので、ResourceAccounting より先に破棄されるよう先に作っておく
+    ResourceAccounting::Get();
     static DescriptorHeapManager instance;
     return instance;
 }
@@ -9,21 +13,31 @@ DescriptorHeapManager& DescriptorHeapManager::Get()
 /// <summary>
 /// CBV/SRV/UAV タイプのシェーダー可視なグローバルテクスチャ用記述子ヒープを作成して初期化します。
 /// 作成されたヒープは m_pGlobalTextureHeap メンバに格納されます。
+/// シェーダーから見えるヒープは同時に 1 つしか設定できず、コピー元にもできないので、
+/// 永続領域が最大ページ数まで伸びた大きさで最初に作ります。
 /// </summary>
 /// <param name="device">ID3D12Device へのポインタ。記述子ヒープの作成に使用されます。</param>
-/// <param name="numDescriptors">作成する記述子の総数。ヒープに含めるデスクリプタ数を指定します。</param>
 /// <returns>初期化に成功した場合は true、CreateDescriptorHeap の呼び出しに失敗した場合は false を返します。</returns>
 bool DescriptorHeapManager::InitializeGlobalTextureHeap(ID3D12Device* device)
 {
+	DescriptorAllocatorDesc allocatorDesc;
+	allocatorDesc.pageSize = GlobalTextureDescriptorPageSize;
+	allocatorDesc.initialPageCount = 1;
+	allocatorDesc.maxPageCount = MaxGlobalTextureDescriptorPages;
+	allocatorDesc.frameCount = FrameDescriptorRegionCount;
+	allocatorDesc.frameDescriptorCount = FrameDescriptorCount;
+	m_Allocator.Reset(allocatorDesc);
+
 	D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
 	heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-	heapDesc.NumDescriptors = MaxGlobalTextureDescriptors;
+	heapDesc.NumDescriptors = m_Allocator.GetTotalDescriptorCount();
 	heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	heapDesc.NodeMask = 0;
 	HRESULT hr = device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(m_pGlobalTextureHeap.ReleaseAndGetAddressOf()));
 	if (FAILED(hr))
 	{
 		//("Failed to create global texture descriptor heap.");
+		m_Allocator.Reset();
 		return false;
 	}
 
@@ -31,39 +45,234 @@ bool DescriptorHeapManager::InitializeGlobalTextureHeap(ID3D12Device* device)
 	m_CpuStart = m_pGlobalTextureHeap->GetCPUDescriptorHandleForHeapStart();
 	m_GpuStart = m_pGlobalTextureHeap->GetGPUDescriptorHandleForHeapStart();
 
-	return true;
+	// Tier 1 はステージあたりの SRV が 128 個までなので、ヒープ全体を 1 つのテーブルにできない
+	D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+	m_IsBindlessSupported = SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options))) &&
+		options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
+
+	m_HeapAllocation = ResourceAccounting::Get().TrackScoped(ResourceCategory::Descriptor, "DirectX12", "GlobalTextureHeap",
+		0, static_cast<uint64_t>(heapDesc.NumDescriptors) * m_DescriptorSize);
+	ReportUsage();
+
+	DescriptorAllocatorDesc stagingDesc;
+	stagingDesc.pageSize = StagingDescriptorPageSize;
+	stagingDesc.initialPageCount = 1;
+	stagingDesc.maxPageCount = MaxStagingDescriptorPages;
+	stagingDesc.frameCount = 0;
+	stagingDesc.frameDescriptorCount = 0;
+	std::lock_guard<std::mutex> lock(m_StagingMutex);
+	m_pDevice = device;
+	m_StagingAllocator.Reset(stagingDesc);
+	m_StagingHeaps.assign(MaxStagingDescriptorPages, nullptr);
+	m_StagingStarts.assign(MaxStagingDescriptorPages, D3D12_CPU_DESCRIPTOR_HANDLE{});
+	m_StagingAllocations.clear();
+	m_StagingAllocations.resize(MaxStagingDescriptorPages);
+	return CreateStagingPagesLocked(0);
+}
+
+void DescriptorHeapManager::ResetGlobalTextureHeap()
+{
+	m_pGlobalTextureHeap.Reset();
+	m_HeapAllocation.Reset();
+	m_Allocator.Reset();
+	m_IsBindlessSupported = false;
+
+	std::lock_guard<std::mutex> lock(m_StagingMutex);
+	m_StagingAllocator.Reset();
+	m_StagingHeaps.clear();
+	m_StagingStarts.clear();
+	m_StagingAllocations.clear();
+	m_pDevice.Reset();
+	m_GatheredTables.Clear();
 }
 
 ///====================================================================
 /// <summary>
-/// ディスクリプタヒープからグローバルテクスチャ用の記述子を割り当てます。
-/// 割り当てられた記述子のインデックスが返されます。
+/// ディスクリプタヒープからグローバルテクスチャ用の連続した記述子を割り当てます。
+/// 先頭の記述子のインデックスが返されます。
+/// </summary>
+/// <returns>空きが無い場合は UINT_MAX</returns>
+///====================================================================
+UINT DescriptorHeapManager::AllocateGlobalTextureDescriptors(UINT count)
+{
+	const uint32_t index = m_Allocator.Allocate(count);
+	if (index == DescriptorAllocator::kInvalidIndex)
+	{
+		return UINT_MAX; // 失敗
+	}
+	ReportUsage();
+	return index;
+}
+
+///====================================================================
+/// <summary>
+/// 記述子を解放します。記録済みのコマンドリストが参照しているかもしれないので、
+/// 今のフレームの GPU の処理が終わってから再利用されます。
+/// </summary>
+///====================================================================
+void DescriptorHeapManager::FreeGlobalTextureDescriptors(UINT firstIndex, UINT count)
+{
+	m_Allocator.Free(firstIndex, count);
+	ReportUsage();
+}
+
+UINT DescriptorHeapManager::AllocateFrameDescriptors(UINT count)
+{
+	const uint32_t index = m_Allocator.AllocateFrame(count);
+	return (index == DescriptorAllocator::kInvalidIndex) ? UINT_MAX : index;
+}
+
+void DescriptorHeapManager::BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue)
+{
+	m_Allocator.BeginFrame(frameFenceValue, completedFenceValue);
+	m_GatheredTables.Clear();
+	ReportUsage();
+}
+
+UINT DescriptorHeapManager::AllocateStagingDescriptor()
+{
+	const uint32_t index = m_StagingAllocator.Allocate();
+	if (index == DescriptorAllocator::kInvalidIndex)
+	{
+		return UINT_MAX;
+	}
+
+	// アロケーターがページを足した場合は、そのページのヒープを作る
+	std::lock_guard<std::mutex> lock(m_StagingMutex);
+	if (!CreateStagingPagesLocked(index / StagingDescriptorPageSize))
+	{
+		m_StagingAllocator.Free(index);
+		return UINT_MAX;
+	}
+	return index;
+}
+
+void DescriptorHeapManager::FreeStagingDescriptor(UINT stagingIndex)
+{
+	m_StagingAllocator.Free(stagingIndex);
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorHeapManager::GetStagingCPUHandle(UINT stagingIndex) const
+{
+	D3D12_CPU_DESCRIPTOR_HANDLE handle = m_StagingStarts[stagingIndex / StagingDescriptorPageSize];
+	handle.ptr += static_cast<SIZE_T>(stagingIndex % StagingDescriptorPageSize) * m_DescriptorSize;
+	return handle;
+}
+
+///====================================================================
+/// <summary>
+/// ステージングヒープは CPU からだけ見えるので、ページごとに別のヒープにできます
+/// （シェーダーから見えるヒープと違い、1 つにまとめて設定する必要がない）。
 /// </summary>
-/// <returns></returns>
 ///====================================================================
-UINT DescriptorHeapManager::AllocateGlobalTextureDescriptor()
+bool DescriptorHeapManager::CreateStagingPagesLocked(UINT page)
 {
-	if (!m_TextureDescriptorFreeList.empty())
+	if (m_pDevice == nullptr || page >= m_StagingHeaps.size())
 	{
-		UINT freeIndex = m_TextureDescriptorFreeList.back();
-		m_TextureDescriptorFreeList.pop_back();
-		return freeIndex;
+		return false;
 	}
 
-	if (m_TextureFreeIndex < MaxGlobalTextureDescriptors)
+	for (UINT i = 0; i <= page; ++i)
+	{
+		if (m_StagingHeaps[i] != nullptr)
+		{
+			continue;
+		}
+		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+		heapDesc.NumDescriptors = StagingDescriptorPageSize;
+		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+		heapDesc.NodeMask = 0;
+		HRESULT hr = m_pDevice->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(m_StagingHeaps[i].ReleaseAndGetAddressOf()));
+		if (FAILED(hr))
+		{
+			//("Failed to create staging descriptor heap.");
+			return false;
+		}
+		m_StagingAllocations[i] = ResourceAccounting::Get().TrackScoped(ResourceCategory::Descriptor, "DirectX12", "StagingDescriptorHeap",
+			0, static_cast<uint64_t>(StagingDescriptorPageSize) * m_DescriptorSize);
+		m_StagingStarts[i] = m_StagingHeaps[i]->GetCPUDescriptorHandleForHeapStart();
+	}
+	return true;
+}
+
+UINT DescriptorHeapManager::CreateBindlessDescriptor(UINT stagingIndex)
+{
+	if (!m_IsBindlessSupported || m_pDevice == nullptr || stagingIndex == UINT_MAX)
 	{
-		return m_TextureFreeIndex++;
+		return UINT_MAX;
 	}
 
-	return UINT_MAX; // 失敗
+	const UINT descriptorIndex = AllocateGlobalTextureDescriptor();
+	if (descriptorIndex == UINT_MAX)
+	{
+		return UINT_MAX;
+	}
+	m_pDevice->CopyDescriptorsSimple(1, GetCPUHandle(descriptorIndex), GetStagingCPUHandle(stagingIndex), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	return descriptorIndex;
 }
 
-void DescriptorHeapManager::FreeGlobalTextureDescriptor(UINT descriptorIndex)
+UINT DescriptorHeapManager::GatherFrameDescriptors(const UINT* stagingIndices, UINT count)
 {
-	if (descriptorIndex < MaxGlobalTextureDescriptors)
+	if (stagingIndices == nullptr || count == 0 || m_pDevice == nullptr)
+	{
+		return UINT_MAX;
+	}
+
+	// 同じテクスチャーを使うマテリアル（アトラスのスプライトなど）は 1 つのテーブルを共有する
+	const uint32_t gatheredIndex = m_GatheredTables.Find(stagingIndices, count);
+	if (gatheredIndex != DescriptorAllocator::kInvalidIndex)
+	{
+		++m_GatherStatistics.reusedTableCount;
+		return gatheredIndex;
+	}
+
+	const UINT tableIndex = AllocateFrameDescriptors(count);
+	if (tableIndex == UINT_MAX)
+	{
+		++m_GatherStatistics.failedCount;
+		return UINT_MAX;
+	}
+
+	m_GatherSources.clear();
+	for (UINT i = 0; i < count; ++i)
 	{
-		m_TextureDescriptorFreeList.push_back(descriptorIndex);
+		m_GatherSources.push_back(GetStagingCPUHandle(stagingIndices[i]));
 	}
+	const D3D12_CPU_DESCRIPTOR_HANDLE destination = GetCPUHandle(tableIndex);
+	m_pDevice->CopyDescriptors(1, &destination, &count, count, m_GatherSources.data(), nullptr, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+	m_GatheredTables.Insert(stagingIndices, count, tableIndex);
+	++m_GatherStatistics.tableCount;
+	m_GatherStatistics.copiedDescriptorCount += count;
+	return tableIndex;
+}
+
+void DescriptorHeapManager::ReportUsage()
+{
+	// 解放待ちもまだヒープを塞いでいる
+	const DescriptorAllocatorStatistics statistics = m_Allocator.GetStatistics();
+	const uint64_t usedCount = static_cast<uint64_t>(statistics.usedCount) + statistics.pendingFreeCount;
+	m_HeapAllocation.SetRequestedBytes(usedCount * m_DescriptorSize);
+}
+
+std::string DescriptorHeapManager::FormatReport() const
+{
+	const DescriptorAllocatorStatistics statistics = m_Allocator.GetStatistics();
+	const DescriptorAllocatorStatistics staging = m_StagingAllocator.GetStatistics();
+	char buffer[512];
+	std::snprintf(buffer, sizeof(buffer),
+		"descriptor heap: %u / %u used (peak %u, %u pending free) in %u / %u pages, %u free ranges (largest %u, fragmentation %.2f), "
+		"%llu failed; per frame peak %u / %u, %llu overflowed; staging %u / %u used in %u pages; "
+		"gathered %llu tables (%llu descriptors copied, %llu reused, %llu failed)",
+		statistics.usedCount, statistics.capacity, statistics.peakUsedCount, statistics.pendingFreeCount,
+		statistics.pageCount, statistics.maxPageCount, statistics.freeRangeCount, statistics.largestFreeRange,
+		statistics.fragmentation, static_cast<unsigned long long>(statistics.failedAllocationCount),
+		statistics.framePeakCount, statistics.frameDescriptorCount, static_cast<unsigned long long>(statistics.frameOverflowCount),
+		staging.usedCount, staging.capacity, staging.pageCount,
+		static_cast<unsigned long long>(m_GatherStatistics.tableCount), static_cast<unsigned long long>(m_GatherStatistics.copiedDescriptorCount),
+		static_cast<unsigned long long>(m_GatherStatistics.reusedTableCount), static_cast<unsigned long long>(m_GatherStatistics.failedCount));
+	return buffer;
 }
 
 ///====================================================================
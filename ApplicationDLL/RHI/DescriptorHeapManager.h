@@ -2,12 +2,23 @@
 
 #include <d3d12.h>
 #include <wrl/client.h>
+#include <mutex>
+#include <string>
 #include <vector>
 
+#include "DescriptorAllocator.h"
+#include "../System/ResourceAccounting.h"
+
 
 ///=======================================================================
 /// <summary>
 /// ディスクリプタヒープを管理するクラス。
+/// インデックスの割り当ては DescriptorAllocator に任せ、解放したインデックスは
+/// そのフレームの GPU の処理が終わるまで再利用しません。
+/// ビューは CPU からだけ見えるステージングヒープに一度だけ作り、描画に使うものを
+/// フレームごとにシェーダーから見えるヒープの連続したテーブルへ集めます（GatherFrameDescriptors）。
+/// バインドレスの描画では、ビューをシェーダーから見えるヒープの決まった場所にも写し
+/// （CreateBindlessDescriptor）、シェーダーはヒープ全体を配列としてそのインデックスで読みます。
 /// </summary>
 ///=======================================================================
 class DescriptorHeapManager
@@ -17,12 +28,17 @@ public:
 
 	DescriptorHeapManager(const DescriptorHeapManager&) = delete;
 
-	void ResetGlobalTextureHeap()
+	struct GatherStatistics
 	{
-		m_pGlobalTextureHeap.Reset();
-		m_TextureDescriptorFreeList.clear();
-		m_TextureFreeIndex = 0;
-	}
+		/// 作ったテーブルと、同じフレームで同じ並びを集め直さずに使い回したテーブル
+		uint64_t tableCount = 0;
+		uint64_t reusedTableCount = 0;
+		uint64_t copiedDescriptorCount = 0;
+		/// フレームの領域が足りずに集められなかった回数
+		uint64_t failedCount = 0;
+	};
+
+	void ResetGlobalTextureHeap();
 
 	ID3D12DescriptorHeap* GetGlobalTextureHeap() const
 	{
@@ -34,11 +50,59 @@ public:
 		return m_pGlobalTextureHeap.GetAddressOf();
 	}
 
+	/// シェーダーから見えるヒープと、ステージングヒープの最初のページを作ります。
 	bool InitializeGlobalTextureHeap(ID3D12Device* device);
 
-	// TODO: Allcate
-	UINT AllocateGlobalTextureDescriptor();
-	void FreeGlobalTextureDescriptor(UINT descriptorIndex);
+	/// 失敗した場合は UINT_MAX
+	UINT AllocateGlobalTextureDescriptor() { return AllocateGlobalTextureDescriptors(1); }
+	void FreeGlobalTextureDescriptor(UINT descriptorIndex) { FreeGlobalTextureDescriptors(descriptorIndex, 1); }
+	/// 連続した count 個（ディスクリプタテーブル用）。失敗した場合は UINT_MAX
+	UINT AllocateGlobalTextureDescriptors(UINT count);
+	void FreeGlobalTextureDescriptors(UINT firstIndex, UINT count);
+	/// このフレームの間だけ使う連続した count 個。失敗した場合は UINT_MAX
+	UINT AllocateFrameDescriptors(UINT count);
+
+	/// ビューを作る場所（CPU からだけ見える）。足りなければページを足す。失敗した場合は UINT_MAX
+	UINT AllocateStagingDescriptor();
+	/// GPU はステージングヒープを読まないので、すぐに使い回されます。
+	void FreeStagingDescriptor(UINT stagingIndex);
+	D3D12_CPU_DESCRIPTOR_HANDLE GetStagingCPUHandle(UINT stagingIndex) const;
+
+	///====================================================================
+	/// <summary>
+	/// ステージングヒープのディスクリプタを並びの順にフレームの領域へ 1 回の CopyDescriptors で写し、
+	/// テーブルの先頭（GetGPUHandle に渡すインデックス）を返します。同じフレームで同じ並びを
+	/// 集めた場合は写さずに前のテーブルを返します。描画スレッドから呼び出します。
+	/// </summary>
+	/// <returns>フレームの領域が足りない場合は UINT_MAX</returns>
+	///====================================================================
+	UINT GatherFrameDescriptors(const UINT* stagingIndices, UINT count);
+
+	///====================================================================
+	/// <summary>
+	/// ステージングヒープのディスクリプタをシェーダーから見えるヒープの永続領域へ写し、
+	/// そのインデックスを返します。インデックスはテクスチャーが破棄されるまで変わらないので、
+	/// ルート定数でシェーダーに渡せます。FreeGlobalTextureDescriptor で解放します。
+	/// </summary>
+	/// <returns>バインドレスに対応していないか、空きが無い場合は UINT_MAX</returns>
+	///====================================================================
+	UINT CreateBindlessDescriptor(UINT stagingIndex);
+	/// 範囲の大きさを決めないテーブル（リソースバインディング Tier 2 以上）を使えるか
+	bool IsBindlessSupported() const { return m_IsBindlessSupported; }
+
+	///====================================================================
+	/// <summary>
+	/// フレームの記録を始める前に呼びます。completedFenceValue までのフレームで解放された
+	/// ディスクリプタを再利用できるようにし、以降の解放を frameFenceValue に結び付けます。
+	/// </summary>
+	///====================================================================
+	void BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue);
+
+	DescriptorAllocatorStatistics GetStatistics() const { return m_Allocator.GetStatistics(); }
+	DescriptorAllocatorStatistics GetStagingStatistics() const { return m_StagingAllocator.GetStatistics(); }
+	GatherStatistics GetGatherStatistics() const { return m_GatherStatistics; }
+	std::string FormatReport() const;
+
 	// GetCPUHandle
 	D3D12_CPU_DESCRIPTOR_HANDLE GetCPUHandle(uint32_t index) const;
 
@@ -47,19 +111,48 @@ public:
 
 private:
 
-	constexpr static UINT MaxGlobalTextureDescriptors = 1000;
-
+	/// 連続した確保の上限でもある
+	constexpr static UINT GlobalTextureDescriptorPageSize = 1024;
+	constexpr static UINT MaxGlobalTextureDescriptorPages = 16;
+	/// CPU が GPU の 1 フレーム先まで記録するので 2 フレーム分
+	constexpr static UINT FrameDescriptorRegionCount = 2;
+	constexpr static UINT FrameDescriptorCount = 4096;
+	/// ステージングヒープはページごとに別のヒープなので、最初から大きく作らなくてよい
+	constexpr static UINT StagingDescriptorPageSize = 1024;
+	constexpr static UINT MaxStagingDescriptorPages = 64;
 
 	DescriptorHeapManager() = default;
 
+	/// 使用中のディスクリプタ数を ResourceAccounting に知らせる
+	void ReportUsage();
+	/// page までのステージングヒープを作る。m_StagingMutex を持って呼ぶ
+	bool CreateStagingPagesLocked(UINT page);
+
 	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> m_pGlobalTextureHeap;
 
-	UINT m_TextureFreeIndex = 0;
 	UINT m_DescriptorSize = 0;
+	bool m_IsBindlessSupported = false;
 
-	std::vector<UINT> m_TextureDescriptorFreeList;
+	DescriptorAllocator m_Allocator;
+
+	/// ヒープ全体を確保量、使用中のディスクリプタを要求量として報告する
+	ResourceAccounting::TrackedAllocation m_HeapAllocation;
 
 	D3D12_CPU_DESCRIPTOR_HANDLE m_CpuStart = {};
 	D3D12_GPU_DESCRIPTOR_HANDLE m_GpuStart = {};
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_pDevice;
+	DescriptorAllocator m_StagingAllocator;
+	/// ページを作る間だけ持つ。ページの先頭は作った後は変わらないので、読むときはロックしない
+	std::mutex m_StagingMutex;
+	/// MaxStagingDescriptorPages 個。作っていないページは null
+	std::vector<Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>> m_StagingHeaps;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_StagingStarts;
+	std::vector<ResourceAccounting::TrackedAllocation> m_StagingAllocations;
+
+	/// このフレームで集めたテーブル
+	DescriptorTableCache m_GatheredTables;
+	std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> m_GatherSources;
+	GatherStatistics m_GatherStatistics;
 };
 
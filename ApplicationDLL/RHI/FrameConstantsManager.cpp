@@ -1,3 +1,55 @@
 ﻿
 #include "pch.h"
-#include "FrameConstantsManager.h"
\ No newline at end of file
+#include "FrameConstantsManager.h"
+
+#include <cstdio>
+
+FrameConstantsManager& FrameConstantsManager::Get()
+{
+	static FrameConstantsManager instance;
+	return instance;
+}
+
+bool FrameConstantsManager::Initialize(ID3D12Device* device)
+{
+	FrameLinearAllocatorDesc desc;
+	desc.pageSize = PageSize;
+	desc.maxPagesPerFrame = MaxPagesPerFrame;
+	desc.frameCount = FrameCount;
+	desc.alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+	return m_PagePool.Initialize(device, desc, ResourceCategory::ConstantBuffer, "FrameConstantsManager");
+}
+
+void FrameConstantsManager::Reset()
+{
+	m_PagePool.Reset();
+}
+
+void FrameConstantsManager::BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue)
+{
+	m_PagePool.BeginFrame(frameFenceValue, completedFenceValue);
+}
+
+FrameConstantsManager::Allocation FrameConstantsManager::Allocate(size_t size)
+{
+	FrameUploadAllocation allocation;
+	if (!m_PagePool.Allocate(size, allocation))
+	{
+		return {};
+	}
+	return { allocation.cpuAddress, allocation.gpuAddress };
+}
+
+std::string FrameConstantsManager::FormatReport() const
+{
+	const FrameLinearAllocatorStatistics statistics = m_PagePool.GetStatistics();
+	char buffer[256];
+	std::snprintf(buffer, sizeof(buffer),
+		"frame constants: %u / %u pages of %llu KB, per frame peak %llu KB (%u allocations, %llu KB wasted in the last frame), "
+		"%llu failed, %llu reused in flight",
+		statistics.pageCount, statistics.maxPageCount, static_cast<unsigned long long>(statistics.pageSize / 1024),
+		static_cast<unsigned long long>(statistics.framePeakBytes / 1024), statistics.frameAllocationCount,
+		static_cast<unsigned long long>(statistics.frameWastedBytes / 1024),
+		static_cast<unsigned long long>(statistics.failedAllocationCount), static_cast<unsigned long long>(statistics.inFlightReuseCount));
+	return buffer;
+}
@@ -1,6 +1,69 @@
-﻿
+﻿#pragma once
 
+#include <d3d12.h>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#include "FrameUploadPagePool.h"
+
+///=======================================================================
+/// <summary>
+/// フレームの間だけ使う定数バッファを管理するクラス。
+/// GPU が同時に扱うフレームごとに大きなアップロード用のページを持ち、描画ごとの定数を
+/// 256 バイトの境界で切り出して、書き込み先と GPU の仮想アドレスを返します
+/// （SetGraphicsRootConstantBufferView にそのまま渡せるので、ディスクリプタは使いません）。
+/// フレームごとに別の場所へ書くので、GPU が前のフレームの値を読んでいる間に上書きしません。
+/// 描画スレッドから呼び出します。
+/// </summary>
+///=======================================================================
 class FrameConstantsManager
 {
+public:
+	static FrameConstantsManager& Get();
+
+	FrameConstantsManager(const FrameConstantsManager&) = delete;
+
+	struct Allocation
+	{
+		void* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+	};
+
+	/// 最初のページを作ります。それ以降のページは足りなくなったときに作ります。
+	bool Initialize(ID3D12Device* device);
+	/// ページをすべて破棄します（GPU の処理が終わってから呼ぶこと）。
+	void Reset();
+
+	/// DescriptorHeapManager::BeginFrame と同じく、フレームの記録を始める前に呼びます。
+	void BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue);
+
+	/// 今のフレームの間だけ有効な size バイト。失敗した場合は cpuAddress が nullptr、gpuAddress が 0
+	Allocation Allocate(size_t size);
+
+	/// value を今のフレームの定数として書き込み、その GPU の仮想アドレスを返します。失敗した場合は 0
+	template <class T>
+	D3D12_GPU_VIRTUAL_ADDRESS Push(const T& value)
+	{
+		const Allocation allocation = Allocate(sizeof(T));
+		if (allocation.cpuAddress != nullptr)
+		{
+			std::memcpy(allocation.cpuAddress, &value, sizeof(T));
+		}
+		return allocation.gpuAddress;
+	}
+
+	FrameLinearAllocatorStatistics GetStatistics() const { return m_PagePool.GetStatistics(); }
+	std::string FormatReport() const;
+
+private:
+	/// 行列だけなら 1 ページに 1024 個
+	constexpr static UINT64 PageSize = 256 * 1024;
+	constexpr static UINT MaxPagesPerFrame = 16;
+	/// CPU が GPU の 1 フレーム先まで記録するので 2 フレーム分
+	constexpr static UINT FrameCount = 2;
+
+	FrameConstantsManager() = default;
 
+	FrameUploadPagePool m_PagePool;
 };
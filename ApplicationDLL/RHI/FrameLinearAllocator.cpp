@@ -0,0 +1,106 @@
+﻿#include "FrameLinearAllocator.h"
+
+#include <algorithm>
+
+void FrameLinearAllocator::Reset(const FrameLinearAllocatorDesc& desc)
+{
+	m_Desc = desc;
+	// 境界は 2 の累乗にそろえる（0 は 1 とみなす）
+	uint64_t alignment = 1;
+	while (alignment < m_Desc.alignment)
+	{
+		alignment <<= 1;
+	}
+	m_Desc.alignment = alignment;
+	m_FrameIndex = 0;
+	m_CurrentPage = 0;
+	m_PageInFrame = 0;
+	m_Cursor = 0;
+	m_FrameFenceValues.assign(m_Desc.frameCount, 0);
+	m_IsPageUsed.assign(GetPageCount(), false);
+	m_FrameAllocationCount = 0;
+	m_FrameWastedBytes = 0;
+	m_FramePeakBytes = 0;
+	m_FailedAllocationCount = 0;
+	m_InFlightReuseCount = 0;
+	if (GetPageCount() > 0)
+	{
+		m_IsPageUsed[0] = true;
+	}
+	else
+	{
+		// 何も切り出せないよう、今のページを埋まっていることにする
+		m_Cursor = m_Desc.pageSize;
+	}
+}
+
+void FrameLinearAllocator::Reset()
+{
+	Reset(FrameLinearAllocatorDesc{ 0, 0, 0, 1 });
+}
+
+bool FrameLinearAllocator::AllocateFromNextPage(uint64_t size, FrameLinearAllocation& outAllocation)
+{
+	if (size == 0 || size > m_Desc.pageSize || m_PageInFrame + 1 >= m_Desc.maxPagesPerFrame)
+	{
+		++m_FailedAllocationCount;
+		return false;
+	}
+
+	m_FrameWastedBytes += m_Desc.pageSize - std::min(m_Cursor, m_Desc.pageSize);
+	++m_PageInFrame;
+	++m_CurrentPage;
+	m_IsPageUsed[m_CurrentPage] = true;
+	m_Cursor = size;
+	++m_FrameAllocationCount;
+	outAllocation.page = m_CurrentPage;
+	outAllocation.offset = 0;
+	return true;
+}
+
+void FrameLinearAllocator::BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue)
+{
+	if (m_Desc.frameCount == 0 || GetPageCount() == 0)
+	{
+		return;
+	}
+
+	m_FramePeakBytes = std::max(m_FramePeakBytes, GetFrameUsedBytes());
+	m_FrameIndex = (m_FrameIndex + 1) % m_Desc.frameCount;
+	// 組の中身は前にその組を使ったフレームの GPU がまだ読んでいるかもしれない
+	if (m_FrameFenceValues[m_FrameIndex] > completedFenceValue)
+	{
+		++m_InFlightReuseCount;
+	}
+	m_FrameFenceValues[m_FrameIndex] = frameFenceValue;
+	m_PageInFrame = 0;
+	m_CurrentPage = m_FrameIndex * m_Desc.maxPagesPerFrame;
+	m_IsPageUsed[m_CurrentPage] = true;
+	m_Cursor = 0;
+	m_FrameAllocationCount = 0;
+	m_FrameWastedBytes = 0;
+}
+
+uint64_t FrameLinearAllocator::GetFrameUsedBytes() const
+{
+	if (GetPageCount() == 0)
+	{
+		return 0;
+	}
+	return static_cast<uint64_t>(m_PageInFrame) * m_Desc.pageSize + std::min(m_Cursor, m_Desc.pageSize);
+}
+
+FrameLinearAllocatorStatistics FrameLinearAllocator::GetStatistics() const
+{
+	FrameLinearAllocatorStatistics statistics;
+	statistics.pageSize = m_Desc.pageSize;
+	statistics.pageCount = static_cast<uint32_t>(std::count(m_IsPageUsed.begin(), m_IsPageUsed.end(), true));
+	statistics.maxPageCount = GetPageCount();
+	statistics.frameUsedBytes = GetFrameUsedBytes();
+	statistics.framePeakBytes = std::max(m_FramePeakBytes, statistics.frameUsedBytes);
+	statistics.frameAllocationCount = m_FrameAllocationCount;
+	statistics.frameWastedBytes = m_FrameWastedBytes;
+	statistics.failedAllocationCount = m_FailedAllocationCount;
+	statistics.inFlightReuseCount = m_InFlightReuseCount;
+	return statistics;
+}
@@ -0,0 +1,126 @@
+﻿#pragma once
+
+#include <cstdint>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// FrameLinearAllocator の区切り方。ページは frameCount 個の組に分かれ、
+/// 組ごとに最大 maxPagesPerFrame 枚まで、必要になった順に使い始めます。
+/// </summary>
+///=======================================================================
+struct FrameLinearAllocatorDesc
+{
+	/// 1 回の確保の上限でもある
+	uint64_t pageSize = 256 * 1024;
+	uint32_t maxPagesPerFrame = 8;
+	/// フレームごとの組の数（GPU が同時に扱うフレーム数以上）
+	uint32_t frameCount = 2;
+	/// 定数バッファビューの境界（D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT）。2 の累乗
+	uint64_t alignment = 256;
+};
+
+struct FrameLinearAllocation
+{
+	/// GetPageCount 個のページの通し番号と、その中の位置
+	uint32_t page = UINT32_MAX;
+	uint64_t offset = 0;
+};
+
+struct FrameLinearAllocatorStatistics
+{
+	uint64_t pageSize = 0;
+	/// 使い始めたページ（呼び出し側がバッファを作ったページ）
+	uint32_t pageCount = 0;
+	uint32_t maxPageCount = 0;
+	/// 今のフレームで切り出したバイト数（境界までの詰め物を含む）と、これまでのフレームの最大
+	uint64_t frameUsedBytes = 0;
+	uint64_t framePeakBytes = 0;
+	uint32_t frameAllocationCount = 0;
+	/// ページの末尾に収まらずに捨てた分（今のフレーム）
+	uint64_t frameWastedBytes = 0;
+	/// ページが足りない・大きすぎるなどで失敗した確保の回数
+	uint64_t failedAllocationCount = 0;
+	/// 組を使い回すときに、前にその組を使ったフレームがまだ完了していなかった回数
+	uint64_t inFlightReuseCount = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// フレームの間だけ使う定数などを、大きなページから先頭へ順に切り出すアロケーター。
+/// 確保はポインターを進めるだけで、解放はありません。BeginFrame で次の組に移り、
+/// その組のページを最初から使い直します（組を最後に使ったフレームの GPU の処理は終わっている前提）。
+/// 描画スレッドから呼び出します。GPU の API には依存しないため、単体で動作を確認できます。
+/// </summary>
+///=======================================================================
+class FrameLinearAllocator
+{
+public:
+	FrameLinearAllocator() = default;
+	explicit FrameLinearAllocator(const FrameLinearAllocatorDesc& desc) { Reset(desc); }
+
+	FrameLinearAllocator(const FrameLinearAllocator&) = delete;
+	FrameLinearAllocator& operator=(const FrameLinearAllocator&) = delete;
+
+	/// 区切り方を設定し、確保をすべて破棄します。
+	void Reset(const FrameLinearAllocatorDesc& desc);
+	/// 何も確保できない状態に戻します。
+	void Reset();
+
+	///====================================================================
+	/// <summary>
+	/// 今のフレームの組から size バイトを alignment の境界で切り出します。
+	/// 今のページに収まらなければ、残りを捨てて組の次のページに移ります。
+	/// </summary>
+	/// <returns>size が 0 かページより大きい場合、組のページを使い切った場合は false</returns>
+	///====================================================================
+	bool Allocate(uint64_t size, FrameLinearAllocation& outAllocation)
+	{
+		const uint64_t offset = (m_Cursor + m_Desc.alignment - 1) & ~(m_Desc.alignment - 1);
+		if (size != 0 && offset + size <= m_Desc.pageSize)
+		{
+			m_Cursor = offset + size;
+			++m_FrameAllocationCount;
+			outAllocation.page = m_CurrentPage;
+			outAllocation.offset = offset;
+			return true;
+		}
+		return AllocateFromNextPage(size, outAllocation);
+	}
+
+	///====================================================================
+	/// <summary>
+	/// 新しいフレームを始め、次の組を空にします。
+	/// </summary>
+	/// <param name="frameFenceValue">これから記録するフレームの終わりに Signal するフェンス値</param>
+	/// <param name="completedFenceValue">完了したフェンス値</param>
+	///====================================================================
+	void BeginFrame(uint64_t frameFenceValue, uint64_t completedFenceValue);
+
+	/// 確保が返しうるページの数（maxPagesPerFrame × frameCount）
+	uint32_t GetPageCount() const { return m_Desc.maxPagesPerFrame * m_Desc.frameCount; }
+	const FrameLinearAllocatorDesc& GetDesc() const { return m_Desc; }
+	FrameLinearAllocatorStatistics GetStatistics() const;
+
+private:
+	/// 組の次のページへ移って確保する（ページの切り替わりとエラーだけの遅い経路）
+	bool AllocateFromNextPage(uint64_t size, FrameLinearAllocation& outAllocation);
+	uint64_t GetFrameUsedBytes() const;
+
+	FrameLinearAllocatorDesc m_Desc = { 0, 0, 0, 1 };
+	uint32_t m_FrameIndex = 0;
+	/// 今のフレームの組で使っているページ（通し番号）と、組の中で何枚目か
+	uint32_t m_CurrentPage = 0;
+	uint32_t m_PageInFrame = 0;
+	uint64_t m_Cursor = 0;
+	/// 組ごとに、最後に使ったフレームのフェンス値
+	std::vector<uint64_t> m_FrameFenceValues;
+	/// 一度でも使ったページ
+	std::vector<bool> m_IsPageUsed;
+
+	uint32_t m_FrameAllocationCount = 0;
+	uint64_t m_FrameWastedBytes = 0;
+	uint64_t m_FramePeakBytes = 0;
+	uint64_t m_FailedAllocationCount = 0;
+	uint64_t m_InFlightReuseCount = 0;
+};
@@ -0,0 +1,102 @@
+﻿
+#include "pch.h"
+#include "FrameUploadPagePool.h"
+#include "DX12UploadBackend.h"
+
+FrameUploadPagePool::FrameUploadPagePool()
+{
+	// ページの報告を持つので、ResourceAccounting より先に破棄されるよう先に作っておく。
+	// 持ち主のシングルトン（とその他のメンバーの報告）も、これで ResourceAccounting より先に破棄される
+	ResourceAccounting::Get();
+}
+
+bool FrameUploadPagePool::Initialize(ID3D12Device* device, const FrameLinearAllocatorDesc& desc, ResourceCategory category, const char* owner)
+{
+	if (device == nullptr)
+	{
+		return false;
+	}
+
+	m_Allocator.Reset(desc);
+	m_pDevice = device;
+	m_Category = category;
+	m_pOwner = owner;
+	m_Pages.clear();
+	m_Pages.resize(m_Allocator.GetPageCount());
+	if (!CreatePage(0))
+	{
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+void FrameUploadPagePool::Reset()
+{
+	m_Allocator.Reset();
+	m_Pages.clear();
+	m_pDevice.Reset();
+}
+
+///====================================================================
+/// <summary>
+/// 切り出しはポインターを進めるだけです。ページを作るのは、そのページを初めて使うときだけです。
+/// </summary>
+///====================================================================
+bool FrameUploadPagePool::Allocate(uint64_t size, FrameUploadAllocation& outAllocation)
+{
+	outAllocation = {};
+	FrameLinearAllocation allocation;
+	if (!m_Allocator.Allocate(size, allocation))
+	{
+		return false;
+	}
+
+	Page& page = m_Pages[allocation.page];
+	if (page.cpuAddress == nullptr && !CreatePage(allocation.page))
+	{
+		return false;
+	}
+	outAllocation.cpuAddress = page.cpuAddress + allocation.offset;
+	outAllocation.gpuAddress = page.gpuAddress + allocation.offset;
+	return true;
+}
+
+bool FrameUploadPagePool::CreatePage(UINT pageIndex)
+{
+	if (m_pDevice == nullptr || pageIndex >= m_Pages.size())
+	{
+		return false;
+	}
+
+	Page& page = m_Pages[pageIndex];
+	CD3DX12_HEAP_PROPERTIES heapProps(D3D12_HEAP_TYPE_UPLOAD);
+	CD3DX12_RESOURCE_DESC resourceDesc = CD3DX12_RESOURCE_DESC::Buffer(m_Allocator.GetDesc().pageSize);
+	HRESULT hr = m_pDevice->CreateCommittedResource(
+		&heapProps,
+		D3D12_HEAP_FLAG_NONE,
+		&resourceDesc,
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(page.resource.ReleaseAndGetAddressOf()));
+	if (FAILED(hr))
+	{
+		LOG_DEBUG("%s: failed to create page %u. hr=0x%08X", m_pOwner, pageIndex, static_cast<unsigned int>(hr));
+		page.resource.Reset();
+		return false;
+	}
+
+	// CPU は書くだけなので、読み取る範囲は空にする
+	D3D12_RANGE readRange = { 0, 0 };
+	hr = page.resource->Map(0, &readRange, reinterpret_cast<void**>(&page.cpuAddress));
+	if (FAILED(hr))
+	{
+		LOG_DEBUG("%s: failed to map page %u. hr=0x%08X", m_pOwner, pageIndex, static_cast<unsigned int>(hr));
+		page.resource.Reset();
+		page.cpuAddress = nullptr;
+		return false;
+	}
+	page.gpuAddress = page.resource->GetGPUVirtualAddress();
+	page.allocation = TrackD3D12Resource(m_pDevice.Get(), page.resource.Get(), m_Category, m_pOwner);
+	return true;
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+
+#include <d3d12.h>
+#include <wrl/client.h>
+#include <cstdint>
+#include <vector>
+
+#include "FrameLinearAllocator.h"
+#include "../System/ResourceAccounting.h"
+
+/// FrameUploadPagePool から切り出した領域。失敗した場合は cpuAddress が nullptr、gpuAddress が 0
+struct FrameUploadAllocation
+{
+	uint8_t* cpuAddress = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// FrameLinearAllocator のページを、マップしたままのアップロード用のバッファとして持つクラス。
+/// フレームの間だけ使う定数やインスタンスを切り出して、書き込み先と GPU の仮想アドレスを返します。
+/// ページはそのページを初めて使うときに作り、ResourceAccounting に報告します。
+/// 描画スレッドから呼び出します。
+/// </summary>
+///=======================================================================
+class FrameUploadPagePool
+{
+public:
+	FrameUploadPagePool();
+
+	FrameUploadPagePool(const FrameUploadPagePool&) = delete;
+	FrameUploadPagePool& operator=(const FrameUploadPagePool&) = delete;
+
+	/// 区切り方を設定して最初のページを作ります。category と owner はページの報告に使います（owner は文字列リテラル）。
+	bool Initialize(ID3D12Device* device, const FrameLinearAllocatorDesc& desc, ResourceCategory category, const char* owner);
+	/// ページをすべて破棄します（GPU の処理が終わってから呼ぶこと）。
+	void Reset();
+
+	/// フレームの記録を始める前に呼びます。
+	void BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue) { m_Allocator.BeginFrame(frameFenceValue, completedFenceValue); }
+
+	/// 今のフレームの間だけ有効な size バイト。ページを使い切った場合と、ページを作れなかった場合は false
+	bool Allocate(uint64_t size, FrameUploadAllocation& outAllocation);
+
+	FrameLinearAllocatorStatistics GetStatistics() const { return m_Allocator.GetStatistics(); }
+
+private:
+	struct Page
+	{
+		Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+		uint8_t* cpuAddress = nullptr;
+		D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+		ResourceAccounting::TrackedAllocation allocation;
+	};
+
+	/// アップロードヒープにページを作り、破棄するまでマップしたままにする
+	bool CreatePage(UINT pageIndex);
+
+	Microsoft::WRL::ComPtr<ID3D12Device> m_pDevice;
+	FrameLinearAllocator m_Allocator;
+	/// FrameLinearAllocator::GetPageCount 個。作っていないページは resource が null
+	std::vector<Page> m_Pages;
+	ResourceCategory m_Category = ResourceCategory::UploadBuffer;
+	const char* m_pOwner = "FrameUploadPagePool";
+};
@@ -0,0 +1,148 @@
+﻿#include "GpuUploadQueue.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	uint64_t AlignUp(uint64_t value, uint64_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+}
+
+GpuUploadQueue::GpuUploadQueue(IGpuUploadBackend& backend)
+	: m_Backend(backend)
+{
+	m_Ring.Reset(m_Backend.GetStagingSize());
+}
+
+GpuUploadQueue::~GpuUploadQueue()
+{
+	WaitIdle();
+}
+
+bool GpuUploadQueue::UploadBuffer(void* destination, uint64_t destinationOffset, const void* data, uint64_t size)
+{
+	if (destination == nullptr || data == nullptr || size == 0 || m_Ring.GetCapacity() == 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// 1 回のコピーはステージングの半分までにして、前のコピーの実行中も書き込めるようにする
+	const uint64_t maxChunk = (std::max)(m_Ring.GetCapacity() / 2, kStagingAlignment);
+	const uint8_t* source = static_cast<const uint8_t*>(data);
+	uint64_t copied = 0;
+	while (copied < size)
+	{
+		const uint64_t chunk = (std::min)(size - copied, maxChunk);
+		uint64_t stagingOffset = 0;
+		if (!AllocateStagingLocked(chunk, kStagingAlignment, stagingOffset))
+		{
+			return false;
+		}
+		std::memcpy(m_Backend.GetStagingData() + stagingOffset, source + copied, static_cast<size_t>(chunk));
+		m_Backend.RecordBufferCopy(destination, destinationOffset + copied, stagingOffset, chunk);
+		copied += chunk;
+	}
+	m_UploadedBytes += size;
+	return true;
+}
+
+bool GpuUploadQueue::UploadTexture(void* destination, uint32_t subresource, uint32_t format, const TextureSubresource& source)
+{
+	if (destination == nullptr || source.pixels == nullptr || source.rowPitch == 0 || source.rowCount == 0 ||
+		source.rowHeight == 0 || m_Ring.GetCapacity() == 0)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+
+	// UploadBuffer と同じく 1 回のコピーはステージングの半分まで。1 行も収まらなければ転送できない
+	const uint64_t stagingRowPitch = AlignUp(source.rowPitch, kTextureRowPitchAlignment);
+	const uint64_t maxChunk = m_Ring.GetCapacity() / 2;
+	const uint32_t rowsPerChunk = static_cast<uint32_t>((std::min)(maxChunk / stagingRowPitch, static_cast<uint64_t>(source.rowCount)));
+	if (rowsPerChunk == 0)
+	{
+		return false;
+	}
+
+	IGpuUploadBackend::TextureFootprint footprint;
+	footprint.format = format;
+	footprint.width = static_cast<uint32_t>(AlignUp(source.width, source.rowHeight));
+	footprint.rowPitch = static_cast<uint32_t>(stagingRowPitch);
+
+	const uint8_t* pixels = static_cast<const uint8_t*>(source.pixels);
+	for (uint32_t row = 0; row < source.rowCount; row += rowsPerChunk)
+	{
+		const uint32_t rows = (std::min)(rowsPerChunk, source.rowCount - row);
+		uint64_t stagingOffset = 0;
+		if (!AllocateStagingLocked(stagingRowPitch * rows, kTexturePlacementAlignment, stagingOffset))
+		{
+			return false;
+		}
+		uint8_t* staging = m_Backend.GetStagingData() + stagingOffset;
+		for (uint32_t i = 0; i < rows; ++i)
+		{
+			std::memcpy(staging + stagingRowPitch * i, pixels + source.rowPitch * (row + i), static_cast<size_t>(source.rowPitch));
+		}
+		footprint.height = rows * source.rowHeight;
+		m_Backend.RecordTextureCopy(destination, subresource, row * source.rowHeight, stagingOffset, footprint);
+	}
+	m_UploadedBytes += source.rowPitch * source.rowCount;
+	return true;
+}
+
+uint64_t GpuUploadQueue::Flush()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (m_Ring.HasOpenAllocations())
+	{
+		SubmitLocked();
+	}
+	m_Ring.Reclaim(m_Backend.GetCompletedFenceValue());
+	return m_LastSubmittedFence;
+}
+
+void GpuUploadQueue::WaitIdle()
+{
+	const uint64_t fenceValue = Flush();
+	if (fenceValue != 0)
+	{
+		m_Backend.WaitForFence(fenceValue);
+	}
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Ring.Reclaim(m_Backend.GetCompletedFenceValue());
+}
+
+uint64_t GpuUploadQueue::SubmitLocked()
+{
+	m_LastSubmittedFence = m_Backend.Submit();
+	++m_SubmitCount;
+	m_Ring.CloseSubmission(m_LastSubmittedFence);
+	return m_LastSubmittedFence;
+}
+
+bool GpuUploadQueue::AllocateStagingLocked(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+{
+	m_Ring.Reclaim(m_Backend.GetCompletedFenceValue());
+	while (!m_Ring.Allocate(size, alignment, outOffset))
+	{
+		// 記録中のコピーを先に実行しないと、その領域は解放されない
+		if (m_Ring.HasOpenAllocations())
+		{
+			SubmitLocked();
+		}
+		const uint64_t oldestFence = m_Ring.GetOldestPendingFence();
+		if (oldestFence == 0)
+		{
+			return false;
+		}
+		m_Backend.WaitForFence(oldestFence);
+		m_Ring.Reclaim(m_Backend.GetCompletedFenceValue());
+	}
+	return true;
+}
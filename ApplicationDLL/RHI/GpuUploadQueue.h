@@ -0,0 +1,124 @@
+﻿#pragma once
+
+#include "UploadRing.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+///=======================================================================
+/// <summary>
+/// GpuUploadQueue が使うコピー処理の抽象。
+/// DX12 ではコピー用コマンドキューとフェンス（DX12UploadBackend）、
+/// 検証用には GPU を持たない偽の実装に差し替えられます。
+/// コピー先は API ごとのリソース（DX12 では ID3D12Resource*）を void* で受け取ります。
+/// </summary>
+///=======================================================================
+class IGpuUploadBackend
+{
+public:
+	/// ステージング上に置いたテクスチャーの 1 区画（行の帯）
+	struct TextureFootprint
+	{
+		uint32_t format = 0;		// API のフォーマット値（DX12 では DXGI_FORMAT）
+		uint32_t width = 0;			// テクセル数（ブロック圧縮はブロック境界に切り上げ）
+		uint32_t height = 0;
+		uint32_t rowPitch = 0;		// ステージング上の 1 行のバイト数
+	};
+
+	virtual ~IGpuUploadBackend() = default;
+
+	/// CPU から書き込めるステージング領域（常にマップ済み）
+	virtual uint8_t* GetStagingData() = 0;
+	virtual uint64_t GetStagingSize() const = 0;
+
+	/// ステージング領域からバッファへのコピーを記録します。
+	virtual void RecordBufferCopy(void* destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size) = 0;
+	/// ステージング領域からテクスチャーのサブリソースの destinationY 行目以降へのコピーを記録します。
+	virtual void RecordTextureCopy(void* destination, uint32_t subresource, uint32_t destinationY, uint64_t stagingOffset, const TextureFootprint& footprint) = 0;
+	/// 記録したコピーを実行し、完了を示すフェンス値を返します（1 以上で単調増加）。
+	virtual uint64_t Submit() = 0;
+	virtual uint64_t GetCompletedFenceValue() = 0;
+	/// CPU 側で fenceValue の完了を待ちます。
+	virtual void WaitForFence(uint64_t fenceValue) = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// 静的なジオメトリやテクスチャーを GPU 専用メモリ（DEFAULT ヒープ）へ転送するキュー。
+/// データはリング状のステージング領域に書き込んでコピーを記録し、Flush でまとめて実行します。
+/// 1 フレームの間に予約したコピーは 1 つのコマンドリストと 1 回のフェンスにまとまります。
+/// 描画側は GetLastSubmittedFence の値をグラフィックスキューで待ってから描画すること。
+/// ステージングが埋まった場合は記録済みのコピーを実行し、古いコピーの完了を待って再利用します。
+/// </summary>
+///=======================================================================
+class GpuUploadQueue
+{
+public:
+	/// ステージング領域内の確保の境界
+	static constexpr uint64_t kStagingAlignment = 16;
+	/// テクスチャーの転送元の境界（D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT / PITCH_ALIGNMENT と同じ）
+	static constexpr uint64_t kTexturePlacementAlignment = 512;
+	static constexpr uint64_t kTextureRowPitchAlignment = 256;
+
+	/// テクスチャーのサブリソース 1 つ分の元データ
+	struct TextureSubresource
+	{
+		const void* pixels = nullptr;
+		uint64_t rowPitch = 0;		// 元データの 1 行（ブロック圧縮はブロック 1 行）のバイト数
+		uint32_t rowCount = 0;		// 行数（ブロック圧縮はブロックの行数）
+		uint32_t rowHeight = 1;		// 1 行が覆うテクセルの行数（ブロック圧縮は 4）
+		uint32_t width = 0;			// テクセル数
+		uint32_t height = 0;
+	};
+
+	explicit GpuUploadQueue(IGpuUploadBackend& backend);
+	~GpuUploadQueue();
+
+	// コピー禁止
+	GpuUploadQueue(const GpuUploadQueue&) = delete;
+	GpuUploadQueue& operator=(const GpuUploadQueue&) = delete;
+
+	///====================================================================
+	/// <summary>
+	/// バッファへの書き込みを予約します。ステージングより大きいデータは分割して転送します。
+	/// data は呼び出し中にステージングへ写すため、戻った後は破棄してかまいません。
+	/// </summary>
+	/// <param name="destination">コピー先（COMMON 状態のバッファ）</param>
+	/// <returns>size が 0 の場合や、コピー先が無い場合は false</returns>
+	///====================================================================
+	bool UploadBuffer(void* destination, uint64_t destinationOffset, const void* data, uint64_t size);
+
+	///====================================================================
+	/// <summary>
+	/// テクスチャーのサブリソースへの書き込みを予約します。行ピッチを揃えてステージングへ写し、
+	/// ステージングの半分に収まらない場合は行の帯に分けて転送します。
+	/// </summary>
+	/// <param name="destination">コピー先（COMMON 状態のテクスチャー）</param>
+	/// <param name="format">API のフォーマット値（DX12 では DXGI_FORMAT）</param>
+	///====================================================================
+	bool UploadTexture(void* destination, uint32_t subresource, uint32_t format, const TextureSubresource& source);
+
+	/// 予約済みのコピーを実行し、最後に実行したコピーのフェンス値を返します（一度も無ければ 0）。
+	uint64_t Flush();
+	/// すべてのコピーの完了を待ちます。
+	void WaitIdle();
+
+	uint64_t GetLastSubmittedFence() const { return m_LastSubmittedFence; }
+	/// これまでに転送したバイト数
+	uint64_t GetUploadedBytes() const { return m_UploadedBytes; }
+	/// これまでに実行した提出（コマンドリスト + フェンス）の数
+	uint64_t GetSubmitCount() const { return m_SubmitCount; }
+
+private:
+	uint64_t SubmitLocked();
+	/// ステージングから確保します。空きが無ければ実行・完了待ちをして空ける
+	bool AllocateStagingLocked(uint64_t size, uint64_t alignment, uint64_t& outOffset);
+
+	IGpuUploadBackend& m_Backend;
+	UploadRing m_Ring;
+	std::mutex m_Mutex;
+	uint64_t m_LastSubmittedFence = 0;
+	uint64_t m_UploadedBytes = 0;
+	uint64_t m_SubmitCount = 0;
+};
@@ -1,5 +1,33 @@
-﻿#include "pch.h"
-#include "TextureAssetManager.h"
+﻿#include "TextureAssetManager.h"
+#include "../System/JobSystem.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+
+namespace
+{
+    bool IsAtlasManifestPath(const std::string& path)
+    {
+        const size_t extensionLength = std::char_traits<char>::length(TextureAtlas::kManifestExtension);
+        return path.size() > extensionLength &&
+            path.compare(path.size() - extensionLength, extensionLength, TextureAtlas::kManifestExtension) == 0;
+    }
+}
+
+bool ITextureLoader::LoadAtlasManifest(const std::string& path, TextureAtlas::Manifest& outManifest)
+{
+    if (!TextureAtlas::LoadManifest(path, outManifest))
+    {
+        return false;
+    }
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    for (TextureAtlas::Manifest::Page& page : outManifest.pages)
+    {
+        page.fileName = (directory / page.fileName).string();
+    }
+    return true;
+}
 
 TextureAssetManager& TextureAssetManager::Get()
 {
@@ -7,11 +35,21 @@ TextureAssetManager& TextureAssetManager::Get()
     return instance;
 }
 
+void TextureAssetManager::SetLoader(std::shared_ptr<ITextureLoader> loader)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    loader_ = std::move(loader);
+    // プレースホルダーは前のデバイスのリソースなので作り直す
+    placeholder_.reset();
+    PublishPlaceholderLocked();
+}
+
 ///==========================================================
 /// <summary>
 /// テクスチャーの取得と参照カウントの管理を行います。
 /// 既に同じパスのテクスチャーが存在する場合はそのハンドルを返し、
-/// 存在しない場合は新たにテクスチャーを読み込んでハンドルを生成します。
+/// 存在しない場合は新たにハンドルを生成してワーカーでデコードを開始します。
+/// ファイルの読み込みを待たずに戻ります。
 /// </summary>
 /// <param name="texturePath"></param>
 /// <returns></returns>
@@ -23,39 +61,310 @@ TextureHandle TextureAssetManager::AcquireTexture(const char* texturePath)
         return 0;
     }
 
-    std::lock_guard<std::mutex> lock(mutex_);
     const std::string path(texturePath);
+    if (IsAtlasManifestPath(path))
+    {
+        return AcquireAtlasManifest(path);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    TextureHandle existing = 0;
     const auto it = handlesByPath_.find(path);
+    if (it != handlesByPath_.end())
+    {
+        existing = it->second;
+    }
+    else
+    {
+        // 同じパスがなければ、アトラスに同じファイル名のテクスチャーが入っていないか探します。
+        const auto spriteIt = atlasSpritesByKey_.find(TextureAtlas::GetSpriteKey(path));
+        if (spriteIt != atlasSpritesByKey_.end())
+        {
+            existing = spriteIt->second;
+        }
+    }
 
 	// 既に同じパスのテクスチャーが存在する場合は、そのハンドルを返し、参照カウントを増やします。
-    if (it != handlesByPath_.end())
+    if (existing != 0)
     {
-        auto textureIt = texturesByHandle_.find(it->second);
+        auto textureIt = texturesByHandle_.find(existing);
         if (textureIt != texturesByHandle_.end())
         {
             ++textureIt->second.refCount;
         }
-        return it->second;
+        return existing;
     }
 
-	// 同じパスのテクスチャーが存在しない場合は、新たにテクスチャーを読み込んでハンドルを生成します。
-    auto texture = std::make_shared<DX12Texture>();
-    if (!texture->LoadFromFile(std::wstring(path.begin(), path.end())))
+    if (loader_ == nullptr || !loader_->IsAvailable())
     {
         return 0;
     }
 
-	// 新しいテクスチャーエントリーを作成してマップに追加します。
-    const TextureHandle handle = m_NextHandle++;
-    handlesByPath_.emplace(path, handle);
+	// 新しいテクスチャーエントリーを読み込み中として追加します。
     TextureEntry entry = {};
     entry.path = path;
-    entry.texture = std::move(texture);
     entry.refCount = 1;
+    const TextureHandle handle = AddEntryLocked(std::move(entry));
+    if (handle == 0)
+    {
+        return 0;
+    }
+    handlesByPath_.emplace(path, handle);
+
+	// デコードはワーカーで行い、結果は ProcessPendingTextures で公開します。
+    StartDecodeLocked(handle, path);
+    return handle;
+}
+
+///==========================================================
+/// <summary>
+/// 実行時にアトラスを作ります。デコード・パッキング・ページのミップ生成は
+/// 1 つのジョブで行い、ページの公開とテクスチャーの UV の設定は描画スレッドで行います。
+/// </summary>
+///==========================================================
+TextureHandle TextureAssetManager::AcquireAtlas(const std::vector<std::string>& texturePaths, const TextureAtlas::Settings& settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (loader_ == nullptr || !loader_->IsAvailable())
+    {
+        return 0;
+    }
+
+    const TextureHandle handle = RegisterAtlasLocked(std::string(), texturePaths);
+    if (handle == 0)
+    {
+        return 0;
+    }
+    std::vector<std::string> spritePaths;
+    for (const auto& sprite : atlasesByHandle_[handle].spritesByPath)
+    {
+        spritePaths.push_back(sprite.first);
+    }
+
+    std::shared_ptr<ITextureLoader> loader = loader_;
+    SubmitDecodeLocked(handle, [loader, spritePaths, settings](DecodeResult& result)
+    {
+        std::unordered_map<std::string, std::filesystem::path> sourcePaths;
+        std::vector<TextureAtlas::Image> images(spritePaths.size());
+        std::vector<const TextureAtlas::Image*> sources(spritePaths.size(), nullptr);
+        for (size_t i = 0; i < spritePaths.size(); ++i)
+        {
+            if (loader->DecodePixels(spritePaths[i], images[i]))
+            {
+                sources[i] = &images[i];
+            }
+            sourcePaths.emplace(spritePaths[i], loader->GetSourcePath(spritePaths[i]));
+        }
+
+        TextureAtlas::Atlas packed = TextureAtlas::Build(spritePaths, sources, settings);
+        auto atlas = std::make_unique<DecodedAtlas>();
+        for (const TextureAtlas::Image& page : packed.pages)
+        {
+            atlas->pageSizes.push_back({ std::string(), page.width, page.height });
+            atlas->pages.push_back(loader->DecodeAtlasPage(page, settings.padding));
+        }
+        atlas->placements = std::move(packed.placements);
+        atlas->statistics = packed.statistics;
+        atlas->sourcePaths = std::move(sourcePaths);
+        result.atlas = std::move(atlas);
+    });
+    return handle;
+}
+
+///==========================================================
+/// <summary>
+/// オフラインで作ったアトラスを読み込みます。定義ファイルは小さいのでその場で読み、
+/// 中のテクスチャーをすぐに登録して、ページのデコードだけをワーカーで行います。
+/// </summary>
+///==========================================================
+TextureHandle TextureAssetManager::AcquireAtlasManifest(const std::string& path)
+{
+    std::shared_ptr<ITextureLoader> loader;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = handlesByPath_.find(path);
+        if (it != handlesByPath_.end())
+        {
+            ++texturesByHandle_[it->second].refCount;
+            return it->second;
+        }
+        if (loader_ == nullptr || !loader_->IsAvailable())
+        {
+            return 0;
+        }
+        loader = loader_;
+    }
+
+    TextureAtlas::Manifest manifest;
+    if (!loader->LoadAtlasManifest(path, manifest))
+    {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    // 読んでいる間に他のスレッドが登録した場合はそちらを使う
+    const auto it = handlesByPath_.find(path);
+    if (it != handlesByPath_.end())
+    {
+        ++texturesByHandle_[it->second].refCount;
+        return it->second;
+    }
+    if (loader_ != loader)
+    {
+        return 0;
+    }
+
+    std::vector<std::string> spritePaths;
+    for (const TextureAtlas::Placement& placement : manifest.placements)
+    {
+        spritePaths.push_back(placement.name);
+    }
+    const TextureHandle handle = RegisterAtlasLocked(path, spritePaths);
+    if (handle == 0)
+    {
+        return 0;
+    }
+
+    SubmitDecodeLocked(handle, [loader, manifest](DecodeResult& result)
+    {
+        auto atlas = std::make_unique<DecodedAtlas>();
+        atlas->pageSizes = manifest.pages;
+        for (const TextureAtlas::Manifest::Page& page : manifest.pages)
+        {
+            atlas->pages.push_back(loader->Decode(page.fileName));
+            atlas->statistics.pageTexels += static_cast<uint64_t>(page.width) * page.height;
+        }
+        atlas->placements = manifest.placements;
+        for (const TextureAtlas::Placement& placement : manifest.placements)
+        {
+            atlas->statistics.spriteTexels += static_cast<uint64_t>(placement.rect.width) * placement.rect.height;
+        }
+        atlas->statistics.spriteCount = manifest.placements.size();
+        result.atlas = std::move(atlas);
+    });
+    return handle;
+}
+
+TextureHandle TextureAssetManager::RegisterAtlasLocked(const std::string& path, const std::vector<std::string>& spritePaths)
+{
+    TextureEntry atlasEntry = {};
+    atlasEntry.path = path;
+    atlasEntry.refCount = 1;
+    const TextureHandle atlasHandle = AddEntryLocked(std::move(atlasEntry));
+    if (atlasHandle == 0)
+    {
+        return 0;
+    }
+    if (!path.empty())
+    {
+        handlesByPath_.emplace(path, atlasHandle);
+    }
+
+    // 既に読み込んでいるもの（単独や別のアトラス）はそのまま使うので入れない
+    AtlasEntry atlas;
+    for (const std::string& spritePath : spritePaths)
+    {
+        if (spritePath.empty() || handlesByPath_.count(spritePath) != 0)
+        {
+            continue;
+        }
+        TextureEntry entry = {};
+        entry.path = spritePath;
+        entry.refCount = 1;
+        const TextureHandle spriteHandle = AddEntryLocked(std::move(entry));
+        if (spriteHandle == 0)
+        {
+            continue;
+        }
+        handlesByPath_.emplace(spritePath, spriteHandle);
+        atlasSpritesByKey_[TextureAtlas::GetSpriteKey(spritePath)] = spriteHandle;
+        atlas.spritesByPath.emplace(spritePath, spriteHandle);
+    }
+    atlasesByHandle_.emplace(atlasHandle, std::move(atlas));
+    return atlasHandle;
+}
+
+TextureHandle TextureAssetManager::AddEntryLocked(TextureEntry entry)
+{
+    const TextureHandle handle = snapshots_.Allocate();
+    if (handle == 0)
+    {
+        return 0;
+    }
     texturesByHandle_.emplace(handle, std::move(entry));
+    PublishLocked(handle);
     return handle;
 }
 
+void TextureAssetManager::PublishLocked(TextureHandle handle)
+{
+    const auto it = texturesByHandle_.find(handle);
+    if (it == texturesByHandle_.end())
+    {
+        return;
+    }
+    auto snapshot = std::make_unique<TextureSnapshot>();
+    snapshot->texture = it->second.texture;
+    snapshot->state = it->second.state;
+    snapshot->region = it->second.region;
+    snapshots_.Publish(handle, std::move(snapshot));
+}
+
+void TextureAssetManager::PublishPlaceholderLocked()
+{
+    TextureHandle handle = placeholderHandle_.load(std::memory_order_relaxed);
+    if (handle == 0)
+    {
+        handle = snapshots_.Allocate();
+        placeholderHandle_.store(handle, std::memory_order_release);
+    }
+    auto snapshot = std::make_unique<TextureSnapshot>();
+    snapshot->texture = placeholder_;
+    snapshot->state = TextureState::Ready;
+    snapshots_.Publish(handle, std::move(snapshot));
+}
+
+void TextureAssetManager::StartDecodeLocked(TextureHandle handle, const std::string& path)
+{
+    std::shared_ptr<ITextureLoader> loader = loader_;
+    const bool computeHashes = isHotReloadEnabled_;
+    SubmitDecodeLocked(handle, [loader, path, computeHashes](DecodeResult& result)
+    {
+        result.decoded = loader->Decode(path);
+        // 失敗しても監視する（直したファイルを保存すると読み込み直す）
+        result.sourcePath = loader->GetSourcePath(path);
+        if (computeHashes && result.decoded != nullptr)
+        {
+            loader->GetMipHashes(*result.decoded, result.mipHashes);
+        }
+    });
+}
+
+void TextureAssetManager::SubmitDecodeLocked(TextureHandle handle, std::function<void(DecodeResult&)> decode)
+{
+    ++inFlightCount_;
+    const uint64_t generation = generation_;
+    JobSystem::Get().Submit([this, handle, generation, decode = std::move(decode)]()
+    {
+        DecodeResult result;
+        result.handle = handle;
+        result.generation = generation;
+        try
+        {
+            decode(result);
+        }
+        catch (const std::exception&)
+        {
+            result.decoded.reset();
+            result.atlas.reset();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        --inFlightCount_;
+        decodedTextures_.push_back(std::move(result));
+    });
+}
+
 void TextureAssetManager::ReleaseTexture(TextureHandle handle)
 {
     if (handle == 0)
@@ -64,6 +373,11 @@ void TextureAssetManager::ReleaseTexture(TextureHandle handle)
     }
 
     std::lock_guard<std::mutex> lock(mutex_);
+    ReleaseLocked(handle);
+}
+
+void TextureAssetManager::ReleaseLocked(TextureHandle handle)
+{
     const auto it = texturesByHandle_.find(handle);
     if (it == texturesByHandle_.end())
     {
@@ -76,31 +390,721 @@ void TextureAssetManager::ReleaseTexture(TextureHandle handle)
         return;
     }
 
-    handlesByPath_.erase(it->second.path);
+    // デコード中であれば、結果は ProcessPendingTextures で捨てられます。
+    UnwatchSourceLocked(handle);
+    const std::string path = std::move(it->second.path);
     texturesByHandle_.erase(it);
+    snapshots_.Free(handle);
+    residency_.Unregister(handle);
+    const auto pathIt = handlesByPath_.find(path);
+    if (pathIt != handlesByPath_.end() && pathIt->second == handle)
+    {
+        handlesByPath_.erase(pathIt);
+    }
+    const auto keyIt = atlasSpritesByKey_.find(TextureAtlas::GetSpriteKey(path));
+    if (keyIt != atlasSpritesByKey_.end() && keyIt->second == handle)
+    {
+        atlasSpritesByKey_.erase(keyIt);
+    }
+
+    // アトラスであれば中のテクスチャーの参照を外します（他で使われているものは残ります）。
+    const auto atlasIt = atlasesByHandle_.find(handle);
+    if (atlasIt != atlasesByHandle_.end())
+    {
+        const AtlasEntry atlas = std::move(atlasIt->second);
+        atlasesByHandle_.erase(atlasIt);
+        for (const auto& sprite : atlas.spritesByPath)
+        {
+            ReleaseLocked(sprite.second);
+        }
+    }
 }
 
-std::shared_ptr<DX12Texture> TextureAssetManager::GetTexture(TextureHandle handle) const
+std::shared_ptr<RHITexture> TextureAssetManager::GetTexture(TextureHandle handle, TextureState* outState, TextureRegion* outRegion) const
 {
-    if (handle == 0)
+    const TextureSnapshot* snapshot = FindSnapshot(handle, outState, outRegion);
+    return snapshot != nullptr ? snapshot->texture : nullptr;
+}
+
+const RHITexture* TextureAssetManager::PeekTexture(TextureHandle handle, TextureState* outState, TextureRegion* outRegion) const
+{
+    const TextureSnapshot* snapshot = FindSnapshot(handle, outState, outRegion);
+    return snapshot != nullptr ? snapshot->texture.get() : nullptr;
+}
+
+///==========================================================
+/// <summary>
+/// ロックを取らずに公開済みの内容を引きます。読み込み中や失敗したものは
+/// プレースホルダーの内容を返します。
+/// </summary>
+///==========================================================
+const TextureAssetManager::TextureSnapshot* TextureAssetManager::FindSnapshot(TextureHandle handle, TextureState* outState, TextureRegion* outRegion) const
+{
+    if (outState != nullptr)
+    {
+        *outState = TextureState::Failed;
+    }
+    if (outRegion != nullptr)
+    {
+        *outRegion = TextureRegion();
+    }
+
+    const TextureSnapshot* snapshot = snapshots_.Find(handle);
+    if (snapshot == nullptr)
     {
         return nullptr;
     }
+    if (outState != nullptr)
+    {
+        *outState = snapshot->state;
+    }
+    if (snapshot->state != TextureState::Ready)
+    {
+        return snapshots_.Find(placeholderHandle_.load(std::memory_order_acquire));
+    }
+    if (outRegion != nullptr)
+    {
+        *outRegion = snapshot->region;
+    }
+    return snapshot;
+}
+
+size_t TextureAssetManager::ProcessPendingTextures(size_t maxPublishes)
+{
+    std::shared_ptr<ITextureLoader> loader;
+    bool needsPlaceholder = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // フレームの区切り。2 フレーム前までに置き換えた内容はもう読まれていない
+        snapshots_.Reclaim();
+        loader = loader_;
+        needsPlaceholder = placeholder_ == nullptr;
+    }
+    if (loader == nullptr)
+    {
+        return 0;
+    }
+    if (needsPlaceholder)
+    {
+        std::shared_ptr<RHITexture> placeholder = loader->CreatePlaceholderTexture();
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loader_ == loader)
+        {
+            placeholder_ = std::move(placeholder);
+            PublishPlaceholderLocked();
+        }
+    }
+
+    // 前のフレームの報告から、ミップの読み込みと追い出しを決める
+    {
+        std::vector<TextureResidency::Transition> streams;
+        std::vector<TextureResidency::Transition> evictions;
+        std::lock_guard<std::mutex> lock(mutex_);
+        residency_.Update(streams, evictions);
+        ApplyResidencyLocked(streams, evictions);
+    }
+
+    // 監視のスレッドが見つけた元ファイルの変更
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (isHotReloadEnabled_)
+        {
+            StartHotReloadsLocked(fileWatcher_.TakeChangedFiles());
+        }
+    }
+
+    size_t processedCount = 0;
+    while (maxPublishes == 0 || processedCount < maxPublishes)
+    {
+        DecodeResult result;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (decodedTextures_.empty())
+            {
+                break;
+            }
+            result = std::move(decodedTextures_.front());
+            decodedTextures_.pop_front();
+
+            // 読み込み中に解放されたもの、Clear 以前に開始したものは捨てる
+            if (result.generation != generation_ || texturesByHandle_.find(result.handle) == texturesByHandle_.end())
+            {
+                continue;
+            }
+        }
 
+        // GPU リソースの作成はロックの外で行う
+        if (result.atlas != nullptr)
+        {
+            std::vector<std::shared_ptr<RHITexture>> pages;
+            for (const std::unique_ptr<DecodedTexture>& page : result.atlas->pages)
+            {
+                pages.push_back(page != nullptr ? loader->CreateTexture(*page) : nullptr);
+            }
+
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (result.generation == generation_ && atlasesByHandle_.count(result.handle) != 0)
+            {
+                PublishAtlasLocked(result.handle, *result.atlas, pages);
+            }
+            // ページごとに 1 枚のテクスチャを作るので、その数だけ数える
+            processedCount += (std::max)(pages.size(), static_cast<size_t>(1));
+            continue;
+        }
+
+        if (result.isReload)
+        {
+            PublishReload(*loader, result);
+            ++processedCount;
+            continue;
+        }
+
+        std::shared_ptr<RHITexture> texture;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint64_t> mipBytes;
+        bool hasMipLayout = false;
+        if (result.decoded != nullptr)
+        {
+            texture = result.isResidency
+                ? loader->CreateTextureMips(*result.decoded, result.firstMip)
+                : loader->CreateTexture(*result.decoded);
+            hasMipLayout = !result.isResidency && texture != nullptr &&
+                loader->GetMipLayout(*result.decoded, width, height, mipBytes);
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = texturesByHandle_.find(result.handle);
+        if (result.generation == generation_ && it != texturesByHandle_.end())
+        {
+            if (result.isResidency)
+            {
+                // 失敗した場合は今のテクスチャ（追い出し済みならプレースホルダー）のまま
+                const bool isCreated = texture != nullptr;
+                if (isCreated)
+                {
+                    // 読み直した内容は前のハッシュと違うかもしれないので、次のホットリロードでは全ミップを書く
+                    it->second.texture = std::move(texture);
+                    it->second.state = TextureState::Ready;
+                    it->second.mipHashes.clear();
+                    PublishLocked(result.handle);
+                }
+                residency_.CompleteTransition(result.handle, result.firstMip, isCreated);
+            }
+            else
+            {
+                it->second.texture = std::move(texture);
+                it->second.state = it->second.texture != nullptr ? TextureState::Ready : TextureState::Failed;
+                it->second.region = TextureRegion();
+                it->second.isInAtlasPage = false;
+                it->second.mipHashes = std::move(result.mipHashes);
+                PublishLocked(result.handle);
+                WatchSourceLocked(result.handle, result.sourcePath);
+                // 報告が来るまでは全ミップを常駐させたまま予算に数える
+                if (hasMipLayout)
+                {
+                    residency_.Register(result.handle, width, height, mipBytes);
+                }
+            }
+        }
+        ++processedCount;
+    }
+    return processedCount;
+}
+
+///==========================================================
+/// <summary>
+/// ミップを減らすものと増やすものは、ワーカーでデコードし直して描画スレッドで作り直します。
+/// すべて追い出すものはその場でテクスチャーを手放します（前のフレームの GPU の処理は
+/// フレームの終わりで待ち終わっているため、ここで解放しても描画中のものはありません）。
+/// </summary>
+///==========================================================
+void TextureAssetManager::ApplyResidencyLocked(const std::vector<TextureResidency::Transition>& streams, const std::vector<TextureResidency::Transition>& evictions)
+{
+    std::vector<TextureResidency::Transition> rebuilds = streams;
+    for (const TextureResidency::Transition& eviction : evictions)
+    {
+        const auto it = texturesByHandle_.find(eviction.id);
+        if (it == texturesByHandle_.end())
+        {
+            continue;
+        }
+        if (eviction.firstMip >= residency_.GetMipCount(eviction.id))
+        {
+            it->second.texture.reset();
+            it->second.state = TextureState::Evicted;
+            PublishLocked(eviction.id);
+            continue;
+        }
+        rebuilds.push_back(eviction);
+    }
+
+    for (const TextureResidency::Transition& rebuild : rebuilds)
+    {
+        const auto it = texturesByHandle_.find(rebuild.id);
+        if (it == texturesByHandle_.end() || loader_ == nullptr)
+        {
+            residency_.CompleteTransition(rebuild.id, rebuild.firstMip, false);
+            continue;
+        }
+        std::shared_ptr<ITextureLoader> loader = loader_;
+        const std::string path = it->second.path;
+        const uint32_t firstMip = rebuild.firstMip;
+        SubmitDecodeLocked(rebuild.id, [loader, path, firstMip](DecodeResult& result)
+        {
+            result.isResidency = true;
+            result.firstMip = firstMip;
+            result.decoded = loader->Decode(path);
+        });
+    }
+}
+
+void TextureAssetManager::ReportTextureUsage(TextureHandle handle, float screenWidth, float screenHeight)
+{
     std::lock_guard<std::mutex> lock(mutex_);
-    const auto it = texturesByHandle_.find(handle);
-    if (it == texturesByHandle_.end())
+    residency_.RequestScreenSize(handle, screenWidth, screenHeight);
+}
+
+void TextureAssetManager::SetResidencySettings(const TextureResidency::Settings& settings)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    residency_.SetSettings(settings);
+}
+
+TextureResidency::Statistics TextureAssetManager::GetResidencyStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return residency_.GetStatistics();
+}
+
+std::string TextureAssetManager::FormatResidencyReport() const
+{
+    const TextureResidency::Statistics statistics = GetResidencyStatistics();
+    const double megabyte = 1024.0 * 1024.0;
+
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+        "texture residency: %zu textures (%zu pinned), resident %.1f MB / budget %.1f MB (peak %.1f MB), "
+        "streamed %.1f MB in %llu, evicted %.1f MB in %llu, starved %llu",
+        statistics.textureCount, statistics.pinnedCount, statistics.residentBytes / megabyte,
+        statistics.budgetBytes / megabyte, statistics.peakResidentBytes / megabyte,
+        statistics.streamedBytes / megabyte, static_cast<unsigned long long>(statistics.streamCount),
+        statistics.evictedBytes / megabyte, static_cast<unsigned long long>(statistics.evictionCount),
+        static_cast<unsigned long long>(statistics.starvedCount));
+    return buffer;
+}
+
+///==========================================================
+/// <summary>
+/// 詰めたテクスチャーにページと UV の範囲を設定します。
+/// 詰められなかったもの（大きすぎる、デコードやページの作成に失敗した）は単独で読み込み直します。
+/// </summary>
+///==========================================================
+void TextureAssetManager::PublishAtlasLocked(TextureHandle atlasHandle, const DecodedAtlas& decoded, const std::vector<std::shared_ptr<RHITexture>>& pages)
+{
+    TextureEntry& atlasEntry = texturesByHandle_[atlasHandle];
+    atlasEntry.texture = pages.empty() ? nullptr : pages.front();
+    atlasEntry.state = atlasEntry.texture != nullptr ? TextureState::Ready : TextureState::Failed;
+    PublishLocked(atlasHandle);
+
+    const AtlasEntry& atlas = atlasesByHandle_[atlasHandle];
+    size_t placedCount = 0;
+    for (const TextureAtlas::Placement& placement : decoded.placements)
     {
-        return nullptr;
+        const auto spriteIt = atlas.spritesByPath.find(placement.name);
+        if (spriteIt == atlas.spritesByPath.end() || placement.page >= pages.size() || pages[placement.page] == nullptr)
+        {
+            continue;
+        }
+        const auto entryIt = texturesByHandle_.find(spriteIt->second);
+        if (entryIt == texturesByHandle_.end())
+        {
+            continue;
+        }
+
+        float uv[4];
+        const TextureAtlas::Manifest::Page& page = decoded.pageSizes[placement.page];
+        TextureAtlas::GetUvRect(placement, page.width, page.height, uv);
+        entryIt->second.texture = pages[placement.page];
+        entryIt->second.region = { uv[0], uv[1], uv[2], uv[3] };
+        entryIt->second.state = TextureState::Ready;
+        entryIt->second.isInAtlasPage = true;
+        PublishLocked(spriteIt->second);
+        const auto sourceIt = decoded.sourcePaths.find(placement.name);
+        if (sourceIt != decoded.sourcePaths.end())
+        {
+            WatchSourceLocked(spriteIt->second, sourceIt->second);
+        }
+        ++placedCount;
     }
 
-    return it->second.texture;
+    size_t standaloneCount = 0;
+    for (const auto& sprite : atlas.spritesByPath)
+    {
+        const auto entryIt = texturesByHandle_.find(sprite.second);
+        if (entryIt == texturesByHandle_.end() || entryIt->second.state != TextureState::Pending)
+        {
+            continue;
+        }
+        if (loader_ == nullptr)
+        {
+            entryIt->second.state = TextureState::Failed;
+            PublishLocked(sprite.second);
+            continue;
+        }
+        StartDecodeLocked(sprite.second, sprite.first);
+        ++standaloneCount;
+    }
+
+    size_t pageCount = 0;
+    for (const std::shared_ptr<RHITexture>& page : pages)
+    {
+        pageCount += page != nullptr ? 1 : 0;
+    }
+    ++atlasStatistics_.atlasCount;
+    atlasStatistics_.spriteCount += placedCount;
+    atlasStatistics_.pageCount += pageCount;
+    atlasStatistics_.standaloneCount += standaloneCount;
+    atlasStatistics_.spriteTexels += decoded.statistics.spriteTexels;
+    atlasStatistics_.pageTexels += decoded.statistics.pageTexels;
+}
+
+size_t TextureAssetManager::GetPendingCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return inFlightCount_ + decodedTextures_.size();
+}
+
+TextureAssetManager::AtlasStatistics TextureAssetManager::GetAtlasStatistics() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return atlasStatistics_;
+}
+
+std::string TextureAssetManager::FormatAtlasReport() const
+{
+    const AtlasStatistics statistics = GetAtlasStatistics();
+    const double occupancy = statistics.pageTexels > 0
+        ? 100.0 * static_cast<double>(statistics.spriteTexels) / static_cast<double>(statistics.pageTexels) : 0.0;
+
+    // アトラスに入ったテクスチャは、同じページを使う描画でテクスチャを切り替えずに済む
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+        "texture atlas: %zu atlases, %zu textures in %zu pages (occupancy %.1f%%, textures to bind %zu -> %zu), %zu standalone",
+        statistics.atlasCount, statistics.spriteCount, statistics.pageCount, occupancy,
+        statistics.spriteCount, statistics.pageCount, statistics.standaloneCount);
+    return buffer;
 }
 
 void TextureAssetManager::Clear()
 {
     std::lock_guard<std::mutex> lock(mutex_);
+    // ハンドルの世代を進めるので、Clear 以前のハンドルは以後見つからない
+    for (const auto& entry : texturesByHandle_)
+    {
+        snapshots_.Free(entry.first);
+    }
     handlesByPath_.clear();
     texturesByHandle_.clear();
-    m_NextHandle = 1;
+    atlasesByHandle_.clear();
+    atlasSpritesByKey_.clear();
+    residency_.Clear();
+    decodedTextures_.clear();
+    handlesBySourcePath_.clear();
+    fileWatcher_.Clear();
+    ++generation_;
+}
+
+void TextureAssetManager::WatchSourceLocked(TextureHandle handle, const std::filesystem::path& sourcePath)
+{
+    const auto it = texturesByHandle_.find(handle);
+    if (it == texturesByHandle_.end() || it->second.sourcePath == sourcePath)
+    {
+        return;
+    }
+    UnwatchSourceLocked(handle);
+    if (sourcePath.empty())
+    {
+        return;
+    }
+    it->second.sourcePath = sourcePath;
+    handlesBySourcePath_[FileWatcher::GetKey(sourcePath)].push_back(handle);
+    if (isHotReloadEnabled_)
+    {
+        fileWatcher_.Watch(sourcePath);
+    }
+}
+
+void TextureAssetManager::UnwatchSourceLocked(TextureHandle handle)
+{
+    const auto it = texturesByHandle_.find(handle);
+    if (it == texturesByHandle_.end() || it->second.sourcePath.empty())
+    {
+        return;
+    }
+    const std::filesystem::path sourcePath = std::move(it->second.sourcePath);
+    it->second.sourcePath.clear();
+    const auto handlesIt = handlesBySourcePath_.find(FileWatcher::GetKey(sourcePath));
+    if (handlesIt != handlesBySourcePath_.end())
+    {
+        std::vector<TextureHandle>& handles = handlesIt->second;
+        handles.erase(std::remove(handles.begin(), handles.end(), handle), handles.end());
+        if (handles.empty())
+        {
+            handlesBySourcePath_.erase(handlesIt);
+        }
+    }
+    if (isHotReloadEnabled_)
+    {
+        fileWatcher_.Unwatch(sourcePath);
+    }
+}
+
+void TextureAssetManager::SetHotReloadEnabled(bool enabled, std::chrono::milliseconds interval)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (enabled == isHotReloadEnabled_)
+    {
+        if (enabled)
+        {
+            fileWatcher_.Start(interval);
+        }
+        return;
+    }
+
+    isHotReloadEnabled_ = enabled;
+    if (!enabled)
+    {
+        // 監視のスレッドはロックを取らないので、ここで止めて待ってもよい
+        fileWatcher_.Stop();
+        fileWatcher_.Clear();
+        return;
+    }
+
+    // 既に読み込んでいるテクスチャを、使っているハンドルの数だけ登録する
+    for (const auto& source : handlesBySourcePath_)
+    {
+        for (TextureHandle handle : source.second)
+        {
+            fileWatcher_.Watch(texturesByHandle_[handle].sourcePath);
+        }
+    }
+    fileWatcher_.Start(interval);
+}
+
+bool TextureAssetManager::IsHotReloadEnabled() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return isHotReloadEnabled_;
+}
+
+void TextureAssetManager::PollHotReload()
+{
+    // FileWatcher は自分のロックだけで動くので、マネージャーのロックは要らない
+    fileWatcher_.Poll();
+}
+
+///==========================================================
+/// <summary>
+/// 書き換わったファイルを使っているテクスチャーを、ワーカーでデコードし直します。
+/// 読み込み中のもの（これから新しい内容を読む）と、追い出し中のもの（使われたときに読み直す）は除きます。
+/// 前のホットリロードがまだ終わっていなければ、後から始めたものの結果だけを反映します。
+/// </summary>
+///==========================================================
+void TextureAssetManager::StartHotReloadsLocked(const std::vector<std::filesystem::path>& changedFiles)
+{
+    if (changedFiles.empty() || loader_ == nullptr)
+    {
+        return;
+    }
+
+    const auto detectedTime = std::chrono::steady_clock::now();
+    for (const std::filesystem::path& changedFile : changedFiles)
+    {
+        const auto handlesIt = handlesBySourcePath_.find(FileWatcher::GetKey(changedFile));
+        if (handlesIt == handlesBySourcePath_.end())
+        {
+            continue;
+        }
+        for (TextureHandle handle : handlesIt->second)
+        {
+            TextureEntry& entry = texturesByHandle_[handle];
+            if (entry.state == TextureState::Pending || entry.state == TextureState::Evicted)
+            {
+                continue;
+            }
+
+            std::shared_ptr<ITextureLoader> loader = loader_;
+            const std::string path = entry.path;
+            const uint64_t reloadSerial = ++entry.reloadSerial;
+            SubmitDecodeLocked(handle, [loader, path, reloadSerial, detectedTime](DecodeResult& result)
+            {
+                result.isReload = true;
+                result.reloadSerial = reloadSerial;
+                result.detectedTime = detectedTime;
+                result.decoded = loader->Decode(path);
+                if (result.decoded != nullptr)
+                {
+                    loader->GetMipHashes(*result.decoded, result.mipHashes);
+                }
+            });
+        }
+    }
+}
+
+///==========================================================
+/// <summary>
+/// デコードし直したテクスチャーを反映します。
+/// 単独で全ミップが常駐しているテクスチャーは、ハッシュの変わったミップだけを今のリソースに
+/// 書き込みます（ハッシュが無ければ全ミップ）。書き込めない場合（大きさや形式の変更、アトラスの
+/// ページ、一部のミップだけ常駐）は新しいリソースを作って差し替えます。
+/// 差し替えた古いリソースは、以前の公開内容と一緒に 2 フレーム後に消えます。
+/// </summary>
+///==========================================================
+void TextureAssetManager::PublishReload(ITextureLoader& loader, DecodeResult& result)
+{
+    std::shared_ptr<RHITexture> current;
+    std::vector<uint64_t> previousHashes;
+    bool isInAtlasPage = false;
+    uint32_t residentMip = 0;
+    uint32_t residentMipCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto it = texturesByHandle_.find(result.handle);
+        if (result.generation != generation_ || it == texturesByHandle_.end() || it->second.reloadSerial != result.reloadSerial)
+        {
+            return;
+        }
+        if (result.decoded == nullptr)
+        {
+            // 保存の途中のファイルなどは読めないことがあるので、前のテクスチャのままにする
+            ++hotReloadStatistics_.failedCount;
+            return;
+        }
+        if (it->second.state == TextureState::Ready)
+        {
+            current = it->second.texture;
+        }
+        previousHashes = it->second.mipHashes;
+        isInAtlasPage = it->second.isInAtlasPage;
+        if (residency_.IsRegistered(result.handle))
+        {
+            residentMip = residency_.GetResidentMip(result.handle);
+            residentMipCount = residency_.GetMipCount(result.handle);
+        }
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint64_t> mipBytes;
+    const bool hasMipLayout = loader.GetMipLayout(*result.decoded, width, height, mipBytes);
+    const size_t mipCount = !result.mipHashes.empty() ? result.mipHashes.size() : mipBytes.size();
+
+    // 書き換えるミップ。ハッシュを比べられなければ全ミップ
+    std::vector<uint32_t> changedMips;
+    for (uint32_t mip = 0; mip < mipCount; ++mip)
+    {
+        if (result.mipHashes.empty() || previousHashes.size() != result.mipHashes.size() || previousHashes[mip] != result.mipHashes[mip])
+        {
+            changedMips.push_back(mip);
+        }
+    }
+
+    std::shared_ptr<RHITexture> texture;
+    bool isUnchanged = false;
+    bool isUpdatedInPlace = false;
+    if (current != nullptr && !isInAtlasPage && residentMip == 0 && mipCount > 0)
+    {
+        isUnchanged = changedMips.empty();
+        isUpdatedInPlace = !isUnchanged && loader.UpdateTextureMips(*current, *result.decoded, changedMips);
+    }
+    const bool isResidentMipKept = residentMip > 0 && hasMipLayout && residentMipCount == mipBytes.size();
+    if (!isUnchanged && !isUpdatedInPlace)
+    {
+        texture = isResidentMipKept ? loader.CreateTextureMips(*result.decoded, residentMip) : loader.CreateTexture(*result.decoded);
+        if (texture == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++hotReloadStatistics_.failedCount;
+            return;
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto it = texturesByHandle_.find(result.handle);
+    if (result.generation != generation_ || it == texturesByHandle_.end() || it->second.reloadSerial != result.reloadSerial)
+    {
+        return;
+    }
+    it->second.mipHashes = std::move(result.mipHashes);
+
+    HotReloadStatistics& statistics = hotReloadStatistics_;
+    ++statistics.reloadCount;
+    if (isUnchanged)
+    {
+        ++statistics.unchangedCount;
+    }
+    else if (isUpdatedInPlace)
+    {
+        ++statistics.inPlaceCount;
+        statistics.uploadedMipCount += changedMips.size();
+        for (uint32_t mip : changedMips)
+        {
+            statistics.uploadedBytes += mip < mipBytes.size() ? mipBytes[mip] : 0;
+        }
+    }
+    else
+    {
+        ++statistics.swappedCount;
+        const uint32_t firstMip = isResidentMipKept ? residentMip : 0;
+        for (size_t mip = firstMip; mip < mipBytes.size(); ++mip)
+        {
+            ++statistics.uploadedMipCount;
+            statistics.uploadedBytes += mipBytes[mip];
+        }
+
+        it->second.texture = std::move(texture);
+        it->second.state = TextureState::Ready;
+        it->second.region = TextureRegion();
+        it->second.isInAtlasPage = false;
+        PublishLocked(result.handle);
+
+        // 大きさが変わった場合は常駐の管理を新しいミップの並びで登録し直す
+        if (!isResidentMipKept)
+        {
+            residency_.Unregister(result.handle);
+            if (hasMipLayout)
+            {
+                residency_.Register(result.handle, width, height, mipBytes);
+            }
+        }
+    }
+    statistics.lastLatencyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - result.detectedTime).count();
+    statistics.maxLatencyMs = (std::max)(statistics.maxLatencyMs, statistics.lastLatencyMs);
+}
+
+TextureAssetManager::HotReloadStatistics TextureAssetManager::GetHotReloadStatistics() const
+{
+    HotReloadStatistics statistics;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        statistics = hotReloadStatistics_;
+    }
+    statistics.watchedFileCount = fileWatcher_.GetWatchedCount();
+    return statistics;
+}
+
+std::string TextureAssetManager::FormatHotReloadReport() const
+{
+    const HotReloadStatistics statistics = GetHotReloadStatistics();
+    const double megabyte = 1024.0 * 1024.0;
+
+    char buffer[256];
+    std::snprintf(buffer, sizeof(buffer),
+        "texture hot reload: %zu files watched, %zu reloads (%zu in place, %zu swapped, %zu unchanged, %zu failed), "
+        "uploaded %.1f MB in %llu mips, latency last %.1f ms / max %.1f ms",
+        statistics.watchedFileCount, statistics.reloadCount, statistics.inPlaceCount, statistics.swappedCount,
+        statistics.unchangedCount, statistics.failedCount, statistics.uploadedBytes / megabyte,
+        static_cast<unsigned long long>(statistics.uploadedMipCount), statistics.lastLatencyMs, statistics.maxLatencyMs);
+    return buffer;
 }
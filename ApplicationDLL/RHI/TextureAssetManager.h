@@ -1,23 +1,194 @@
 #pragma once
 
-#include "DX12Texture.h"
+#include "RHITexture.h"
+#include "TextureResidency.h"
+#include "../Analyzer/TextureAtlas.h"
+#include "../System/FileWatcher.h"
+#include "../System/HandleTable.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <functional>
 #include <memory>
 #include <mutex>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 using TextureHandle = uint32_t;
 
+///=======================================================================
+/// <summary>
+/// ワーカーでデコードした画像。中身はローダーごとに派生して持ちます。
+/// </summary>
+///=======================================================================
+struct DecodedTexture
+{
+    virtual ~DecodedTexture() = default;
+};
+
+///=======================================================================
+/// <summary>
+/// テクスチャのデコードと GPU リソースの作成。
+/// TextureAssetManager から差し替えられるよう、デバイスに依存する処理をここに分けています。
+/// </summary>
+///=======================================================================
+class ITextureLoader
+{
+public:
+    virtual ~ITextureLoader() = default;
+
+    /// 読み込める状態か（デバイスがあるか）。AcquireTexture から呼ばれます。
+    virtual bool IsAvailable() const = 0;
+    /// ファイルを CPU 上の画像にデコードします。ワーカースレッドから呼ばれます。失敗した場合は nullptr
+    virtual std::unique_ptr<DecodedTexture> Decode(const std::string& path) = 0;
+    /// デコード済みの画像から GPU テクスチャを作成します。描画スレッドから呼ばれます。
+    virtual std::shared_ptr<RHITexture> CreateTexture(const DecodedTexture& decoded) = 0;
+    /// 読み込みが終わるまで代わりに使うテクスチャを作成します。描画スレッドから呼ばれます。
+    virtual std::shared_ptr<RHITexture> CreatePlaceholderTexture() = 0;
+
+    /// アトラスに詰めるため RGBA8 にデコードします。ワーカースレッドから呼ばれます。
+    /// 対応しないローダーは false（アトラスを使わず 1 枚ずつ読み込みます）
+    virtual bool DecodePixels(const std::string& path, TextureAtlas::Image& outImage) { (void)path; (void)outImage; return false; }
+    /// 詰め終わったページからミップ付きの画像を作ります。ミップはガターの幅で決まる段数までにします。
+    virtual std::unique_ptr<DecodedTexture> DecodeAtlasPage(const TextureAtlas::Image& page, uint32_t padding) { (void)page; (void)padding; return nullptr; }
+    /// オフラインで作ったアトラスの定義ファイルを読み込みます。ページのファイル名は読み込める
+    /// パスにして返します（既定は定義ファイルと同じディレクトリ）。
+    virtual bool LoadAtlasManifest(const std::string& path, TextureAtlas::Manifest& outManifest);
+
+    /// ミップごとのバイト数を返します（常駐の管理に使います）。対応しないローダーは false（常に全ミップを常駐させます）
+    virtual bool GetMipLayout(const DecodedTexture& decoded, uint32_t& outWidth, uint32_t& outHeight, std::vector<uint64_t>& outMipBytes)
+    {
+        (void)decoded; (void)outWidth; (void)outHeight; (void)outMipBytes; return false;
+    }
+    /// firstMip 以降のミップだけで GPU テクスチャを作成します。描画スレッドから呼ばれます。
+    virtual std::shared_ptr<RHITexture> CreateTextureMips(const DecodedTexture& decoded, uint32_t firstMip)
+    {
+        return firstMip == 0 ? CreateTexture(decoded) : nullptr;
+    }
+
+    /// ホットリロードで監視するファイル。ワーカースレッドから呼ばれます。見つからなければ空（既定は path のまま）
+    virtual std::filesystem::path GetSourcePath(const std::string& path) { return path; }
+    /// ミップごとの内容のハッシュ。ワーカースレッドから呼ばれます。
+    /// 対応しないローダーは false（ホットリロードで変わったミップを見分けず、全ミップを転送します）
+    virtual bool GetMipHashes(const DecodedTexture& decoded, std::vector<uint64_t>& outHashes) { (void)decoded; (void)outHashes; return false; }
+    ///====================================================================
+    /// <summary>
+    /// 作成済みのテクスチャの mips だけを decoded の内容で書き換えます。描画スレッドから呼ばれ、
+    /// 前のフレームの GPU の処理は終わっています。大きさや形式が違うなど書き換えられない場合は
+    /// false（新しいテクスチャを作って差し替えます）
+    /// </summary>
+    ///====================================================================
+    virtual bool UpdateTextureMips(RHITexture& texture, const DecodedTexture& decoded, const std::vector<uint32_t>& mips)
+    {
+        (void)texture; (void)decoded; (void)mips; return false;
+    }
+};
+
+/// テクスチャ内の UV の範囲。アトラスに入っていれば一部、そうでなければ全体
+struct TextureRegion
+{
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 1.0f;
+    float v1 = 1.0f;
+};
+
+///=======================================================================
+/// <summary>
+/// パスごとにテクスチャを共有し、参照カウントで管理します。
+/// AcquireTexture はすぐにハンドルを返し、デコードは JobSystem のワーカーで行います。
+/// GPU リソースの作成と公開は描画スレッドで ProcessPendingTextures を呼んだときに行い、
+/// それまで GetTexture は代わりのテクスチャ（プレースホルダー）を返します。
+///
+/// 小さなテクスチャはアトラス（AcquireAtlas、または .atlas の定義ファイル）にまとめられます。
+/// アトラスに入ったテクスチャのハンドルはページのテクスチャと UV の範囲を返すため、
+/// 同じページを使う描画はテクスチャを切り替えずに続けられます。
+///
+/// 単独のテクスチャは ReportTextureUsage で画面上の大きさが報告されると、TextureResidency の
+/// 予算に従ってミップ単位で常駐を管理します。使われていない細かいミップから追い出し、
+/// 再び必要になったらワーカーで読み込み直します（報告の無いものは全ミップ常駐のまま）。
+///
+/// ハンドルは HandleTable のスロット番号と世代で、GetTexture / PeekTexture はロックを取らずに
+/// 公開済みの内容を読みます。登録や状態の変更はロックの中で新しい内容に置き換え、古い内容は
+/// ProcessPendingTextures を 2 回呼んだ後（2 フレーム後）に消します。
+///
+/// SetHotReloadEnabled を有効にすると、読み込んだテクスチャの元ファイルを FileWatcher で監視し、
+/// 書き換わったものだけをワーカーでデコードし直します。大きさと形式が同じなら今の GPU リソースの
+/// 内容が変わったミップだけを書き換え、違えば新しいリソースに差し替えます。どちらの場合も
+/// ハンドルは変わらないので、マネージドコードが持っているハンドルはそのまま使えます。
+/// 実行時のアトラスに入っていたテクスチャは、書き換わると単独のテクスチャとして読み込み直します
+/// （.atlas の定義ファイルのアトラスは監視しません）。
+/// </summary>
+///=======================================================================
 class TextureAssetManager
 {
 public:
+    /// 1 フレームで公開するテクスチャ数の既定の上限。
+    /// 転送はステージングへの書き込みだけで、1 フレーム分が 1 回の提出にまとまる
+    static constexpr size_t kDefaultPublishesPerFrame = 16;
+
+    enum class TextureState
+    {
+        Pending,    // デコード中または公開待ち
+        Ready,
+        Failed,     // 読み込みに失敗（プレースホルダーのまま）
+        Evicted,    // 常駐の予算のためすべて追い出した（使われると読み込み直す）
+    };
+
     struct TextureEntry
     {
         std::string path;
-        std::shared_ptr<DX12Texture> texture;
+        std::shared_ptr<RHITexture> texture;    // アトラスに入っていればページ
         uint32_t refCount = 0;
+        TextureState state = TextureState::Pending;
+        /// texture 内の範囲（アトラスに入っていなければ全体）
+        TextureRegion region;
+        /// texture はアトラスのページ（他のテクスチャと共有している）
+        bool isInAtlasPage = false;
+        /// ホットリロードで監視する元ファイル（空なら監視しない）
+        std::filesystem::path sourcePath;
+        /// 今の texture のミップごとの内容のハッシュ（ホットリロードが有効なときだけ）
+        std::vector<uint64_t> mipHashes;
+        /// 最後に開始したホットリロード（古い結果を捨てる）
+        uint64_t reloadSerial = 0;
+    };
+
+    /// これまでに公開したアトラスの合計
+    struct AtlasStatistics
+    {
+        size_t atlasCount = 0;
+        size_t spriteCount = 0;
+        size_t pageCount = 0;
+        /// 大きすぎるなどでアトラスに入らず単独で読み込んだ数
+        size_t standaloneCount = 0;
+        uint64_t spriteTexels = 0;
+        uint64_t pageTexels = 0;
+    };
+
+    /// これまでのホットリロードの合計
+    struct HotReloadStatistics
+    {
+        size_t watchedFileCount = 0;
+        /// デコードし直して反映した数
+        size_t reloadCount = 0;
+        /// 今の GPU リソースのミップだけを書き換えた数
+        size_t inPlaceCount = 0;
+        /// 新しい GPU リソースに差し替えた数
+        size_t swappedCount = 0;
+        /// 書き換わっていたがミップの内容が同じだった数
+        size_t unchangedCount = 0;
+        /// デコードに失敗して前のテクスチャのままにした数
+        size_t failedCount = 0;
+        uint64_t uploadedMipCount = 0;
+        uint64_t uploadedBytes = 0;
+        /// 変更を見つけてから反映するまで
+        double lastLatencyMs = 0.0;
+        double maxLatencyMs = 0.0;
     };
 
     static TextureAssetManager& Get();
@@ -25,17 +196,188 @@ public:
     TextureAssetManager(const TextureAssetManager&) = delete;
     TextureAssetManager& operator=(const TextureAssetManager&) = delete;
 
+    /// ローダーを設定します。デバイスの作成時に設定し、破棄時に nullptr を渡します。
+    void SetLoader(std::shared_ptr<ITextureLoader> loader);
+
+    ///====================================================================
+    /// <summary>
+    /// ハンドルを返し、初回であれば読み込みを開始します。ローダーが使えない場合は 0
+    /// 同じパスがなければ、読み込み済みのアトラスに同じファイル名のものがないか探します。
+    /// .atlas の定義ファイルを渡すとアトラスのハンドルを返し、中のテクスチャを登録します。
+    /// </summary>
+    ///====================================================================
     TextureHandle AcquireTexture(const char* texturePath);
+
+    ///====================================================================
+    /// <summary>
+    /// 複数のテクスチャを実行時に 1 つのアトラスへ詰めます。ワーカーでデコードして詰め、
+    /// ページを ProcessPendingTextures で公開します。各テクスチャはこの後の AcquireTexture で
+    /// 同じパスを渡すと取得できます。既に読み込んでいるものと大きすぎるものは単独のままです。
+    /// </summary>
+    /// <returns>アトラスのハンドル。解放するまで中のテクスチャを保持します</returns>
+    ///====================================================================
+    TextureHandle AcquireAtlas(const std::vector<std::string>& texturePaths, const TextureAtlas::Settings& settings = {});
+
     void ReleaseTexture(TextureHandle handle);
-    std::shared_ptr<DX12Texture> GetTexture(TextureHandle handle) const;
+
+    ///====================================================================
+    /// <summary>
+    /// テクスチャを取得します。読み込み中や失敗した場合はプレースホルダーを返します
+    /// （最初の ProcessPendingTextures までは nullptr）。ロックは取りません。
+    /// </summary>
+    /// <param name="outState">状態（null 可）。Pending の間は毎フレーム取得し直します</param>
+    /// <param name="outRegion">返したテクスチャ内の UV の範囲（null 可）</param>
+    ///====================================================================
+    std::shared_ptr<RHITexture> GetTexture(TextureHandle handle, TextureState* outState = nullptr, TextureRegion* outRegion = nullptr) const;
+
+    ///====================================================================
+    /// <summary>
+    /// GetTexture と同じものを参照カウントを増やさずに返します（毎フレームの描画で使います）。
+    /// 返したポインタは次の ProcessPendingTextures までしか使えないので、持ち続ける場合は
+    /// 変わったときだけ GetTexture で取得し直してください。
+    /// </summary>
+    ///====================================================================
+    const RHITexture* PeekTexture(TextureHandle handle, TextureState* outState = nullptr, TextureRegion* outRegion = nullptr) const;
+
+    ///====================================================================
+    /// <summary>
+    /// デコードが終わったテクスチャの GPU リソースを作成して公開します。
+    /// 描画スレッドから毎フレーム呼び出します。
+    /// </summary>
+    /// <param name="maxPublishes">このフレームで公開する上限（0 の場合は無制限）</param>
+    /// <returns>公開（または失敗として確定）した数</returns>
+    ///====================================================================
+    size_t ProcessPendingTextures(size_t maxPublishes = kDefaultPublishesPerFrame);
+
+    ///====================================================================
+    /// <summary>
+    /// このフレームでテクスチャが画面上に描かれる大きさ（ピクセル）を報告します。
+    /// 次の ProcessPendingTextures で、必要なミップの読み込みと使われていないミップの追い出しを決めます。
+    /// アトラスに入ったテクスチャはページごと常駐させるので何もしません。
+    /// </summary>
+    ///====================================================================
+    void ReportTextureUsage(TextureHandle handle, float screenWidth, float screenHeight);
+
+    void SetResidencySettings(const TextureResidency::Settings& settings);
+    TextureResidency::Statistics GetResidencyStatistics() const;
+    /// 常駐しているバイト数と読み込み・追い出しの量を 1 行にまとめたもの（ログ用）
+    std::string FormatResidencyReport() const;
+
+    /// デコード中または公開待ちの数
+    size_t GetPendingCount() const;
+
+    AtlasStatistics GetAtlasStatistics() const;
+    /// 充填率とテクスチャ数の減り方を 1 行にまとめたもの（ログ用）
+    std::string FormatAtlasReport() const;
+
+    ///====================================================================
+    /// <summary>
+    /// 元ファイルの監視とホットリロードを切り替えます。有効にすると、既に読み込んでいる
+    /// テクスチャも監視します（ミップのハッシュが無いので、最初の反映では全ミップを書き込みます）。
+    /// 変更は ProcessPendingTextures で拾います。
+    /// </summary>
+    /// <param name="interval">ファイルを調べる間隔</param>
+    ///====================================================================
+    void SetHotReloadEnabled(bool enabled, std::chrono::milliseconds interval = FileWatcher::kDefaultInterval);
+    bool IsHotReloadEnabled() const;
+    /// 監視の間隔を待たずにファイルを調べます（ツールや検証用）。
+    void PollHotReload();
+    HotReloadStatistics GetHotReloadStatistics() const;
+    /// 反映した数と転送量、反映までの時間を 1 行にまとめたもの（ログ用）
+    std::string FormatHotReloadReport() const;
+
     void Clear();
 
 private:
     TextureAssetManager() = default;
 
+    /// ワーカーで詰めたアトラス（placements の name はテクスチャのパス）
+    struct DecodedAtlas
+    {
+        std::vector<std::unique_ptr<DecodedTexture>> pages;     // 失敗したページは nullptr
+        std::vector<TextureAtlas::Manifest::Page> pageSizes;
+        std::vector<TextureAtlas::Placement> placements;
+        TextureAtlas::Statistics statistics;
+        /// 中のテクスチャの元ファイル（パスごと。実行時のアトラスのみ）
+        std::unordered_map<std::string, std::filesystem::path> sourcePaths;
+    };
+
+    struct DecodeResult
+    {
+        TextureHandle handle = 0;
+        uint64_t generation = 0;
+        std::unique_ptr<DecodedTexture> decoded;    // 失敗した場合は nullptr
+        std::unique_ptr<DecodedAtlas> atlas;        // アトラスの場合
+        bool isResidency = false;                   // 常駐するミップを変えるための作り直し
+        uint32_t firstMip = 0;
+        bool isReload = false;                      // 元ファイルが書き換わったための読み込み直し
+        uint64_t reloadSerial = 0;
+        std::chrono::steady_clock::time_point detectedTime;
+        std::filesystem::path sourcePath;
+        std::vector<uint64_t> mipHashes;            // ホットリロードが有効なときだけ
+    };
+
+    /// ロックを取らずに読む、公開済みのテクスチャの内容（変更のたびに作り直す）
+    struct TextureSnapshot
+    {
+        std::shared_ptr<RHITexture> texture;
+        TextureState state = TextureState::Pending;
+        TextureRegion region;
+    };
+
+    struct AtlasEntry
+    {
+        /// 中のテクスチャ（パスごと）。アトラスがそれぞれの参照を 1 つ持つ
+        std::unordered_map<std::string, TextureHandle> spritesByPath;
+    };
+
+    TextureHandle AcquireAtlasManifest(const std::string& path);
+    /// ハンドルを確保してエントリーを登録します。ハンドルが足りない場合は 0
+    TextureHandle AddEntryLocked(TextureEntry entry);
+    /// エントリーの今の内容を読み取り側に公開します。
+    void PublishLocked(TextureHandle handle);
+    void PublishPlaceholderLocked();
+    /// ロックを取らずに内容を引き、公開されていなければ nullptr
+    const TextureSnapshot* FindSnapshot(TextureHandle handle, TextureState* outState, TextureRegion* outRegion) const;
+    /// 中のテクスチャのエントリーを登録してアトラスのハンドルを返します（既にあるパスは除きます）。
+    TextureHandle RegisterAtlasLocked(const std::string& path, const std::vector<std::string>& spritePaths);
+    void StartDecodeLocked(TextureHandle handle, const std::string& path);
+    /// TextureResidency の決めた読み込みと追い出しを始めます。
+    void ApplyResidencyLocked(const std::vector<TextureResidency::Transition>& streams, const std::vector<TextureResidency::Transition>& evictions);
+    /// decode をワーカーで実行し、結果を ProcessPendingTextures に渡します。
+    void SubmitDecodeLocked(TextureHandle handle, std::function<void(DecodeResult&)> decode);
+    void PublishAtlasLocked(TextureHandle atlasHandle, const DecodedAtlas& decoded, const std::vector<std::shared_ptr<RHITexture>>& pages);
+    void ReleaseLocked(TextureHandle handle);
+    /// エントリーの元ファイルを sourcePath に変えます（ホットリロードが有効なら監視も付け替えます）。
+    void WatchSourceLocked(TextureHandle handle, const std::filesystem::path& sourcePath);
+    void UnwatchSourceLocked(TextureHandle handle);
+    /// 書き換わったファイルを使っているテクスチャのデコードをワーカーで始めます。
+    void StartHotReloadsLocked(const std::vector<std::filesystem::path>& changedFiles);
+    /// デコードし直した結果を反映します（ロックは中で取ります）。
+    void PublishReload(ITextureLoader& loader, DecodeResult& result);
+
 private:
     mutable std::mutex mutex_;
+    std::shared_ptr<ITextureLoader> loader_;
+    std::shared_ptr<RHITexture> placeholder_;
     std::unordered_map<std::string, TextureHandle> handlesByPath_;
     std::unordered_map<TextureHandle, TextureEntry> texturesByHandle_;
-    TextureHandle m_NextHandle = 1;
+    /// 読み取り側に公開した内容（ハンドルごと）。プレースホルダーも 1 つのハンドルとして持つ
+    HandleTable<TextureSnapshot> snapshots_;
+    std::atomic<TextureHandle> placeholderHandle_{ 0 };
+    std::unordered_map<TextureHandle, AtlasEntry> atlasesByHandle_;
+    /// アトラスに入っているテクスチャ（ファイル名のキーごと）
+    std::unordered_map<std::string, TextureHandle> atlasSpritesByKey_;
+    AtlasStatistics atlasStatistics_;
+    /// 単独のテクスチャのミップの常駐（ハンドルごと）
+    TextureResidency residency_;
+    std::deque<DecodeResult> decodedTextures_;
+    size_t inFlightCount_ = 0;
+    /// Clear より前に開始したデコード結果を見分ける
+    uint64_t generation_ = 0;
+    /// 元ファイルを使っているテクスチャ（FileWatcher::GetKey ごと）。監視していなくても持つ
+    std::unordered_map<std::string, std::vector<TextureHandle>> handlesBySourcePath_;
+    FileWatcher fileWatcher_;
+    bool isHotReloadEnabled_ = false;
+    HotReloadStatistics hotReloadStatistics_;
 };
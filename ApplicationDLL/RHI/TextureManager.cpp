@@ -3,6 +3,14 @@
 #include "DX12Texture.h"
 #include "DescriptorHeapManager.h"
 #include "Source/Dx12RenderDevice.h"
+#include "GpuUploadQueue.h"
+#include "../Analyzer/TextureCooker.h"
+
+namespace
+{
+	/// 実行時に読み込むテクスチャーのインポート設定（TextureCooker の既定と同じ）
+	const TextureCooker::Settings kImportSettings = {};
+}
 
 /// シングルトンインスタンスの取得
 TextureManager& TextureManager::Get()
@@ -16,36 +24,297 @@ TextureManager& TextureManager::Get()
 /// </summary>
 UINT TextureManager::CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer, const wchar_t* filePath, DirectX::TexMetadata* outMetadata)
 {
-    ID3D12Device* device = Dx12RenderDevice::GetDevice();
-    if (device == nullptr)
-    {
-        LOG_DEBUG("LoadTexture: no active DirectX12 device for file: %ls", filePath != nullptr ? filePath : L"(null)");
-        return static_cast<UINT>(-1);
-    }
+	TexturePayload payload;
+	if (!LoadTexturePayload(filePath, payload))
+	{
+		return static_cast<UINT>(-1);
+	}
+	return CreateTextureResource(textureBuffer, payload, outMetadata);
+}
+
+/// <summary>
+/// キャッシュを引き、外れた場合はデコード・クックしてキャッシュに保存
+/// </summary>
+bool TextureManager::LoadTexturePayload(const wchar_t* filePath, TexturePayload& outPayload) const
+{
+	const std::filesystem::path resolvedPath = ResolveTexturePath(filePath);
+	if (resolvedPath.empty())
+	{
+		LOG_DEBUG("Failed to resolve texture path: %ls", filePath != nullptr ? filePath : L"(null)");
+		return false;
+	}
+
+	// キーは実際にデコードするファイル（新しいクック済み .dds があればそちら）の内容で作る
+	TextureCache& cache = TextureCache::Get();
+	uint64_t cacheKey = 0;
+	bool useCache = false;
+	if (cache.IsOpen())
+	{
+		const std::filesystem::path sourcePath = TextureCooker::IsCookedUpToDate(resolvedPath) ? TextureCooker::GetCookedPath(resolvedPath) : resolvedPath;
+		MappedFile source;
+		if (source.Open(sourcePath))
+		{
+			cacheKey = TextureCache::ComputeKey(source.GetData(), source.GetSize(), TextureCooker::ComputeSettingsHash(kImportSettings));
+			useCache = true;
+			if (cache.Lookup(cacheKey, outPayload.cached))
+			{
+				return true;
+			}
+		}
+	}
+
+	if (!DecodeTextureFile(filePath, outPayload.image))
+	{
+		return false;
+	}
+
+	// ミップのない画像はクックする（クック済みの .dds はそのまま使う）
+	const DirectX::TexMetadata& metadata = outPayload.image.GetMetadata();
+	if (metadata.mipLevels <= 1 && !DirectX::IsCompressed(metadata.format))
+	{
+		DirectX::ScratchImage cooked;
+		std::string error;
+		if (TextureCooker::Cook(outPayload.image, kImportSettings, cooked, nullptr, &error))
+		{
+			outPayload.image = std::move(cooked);
+		}
+		else
+		{
+			LOG_DEBUG("Failed to cook texture %ls: %s", resolvedPath.c_str(), error.c_str());
+		}
+	}
+
+	const DirectX::TexMetadata& cookedMetadata = outPayload.image.GetMetadata();
+	if (useCache && cookedMetadata.dimension == DirectX::TEX_DIMENSION_TEXTURE2D && cookedMetadata.arraySize == 1)
+	{
+		std::vector<TextureCache::MipData> mips(cookedMetadata.mipLevels);
+		for (size_t mip = 0; mip < mips.size(); ++mip)
+		{
+			const DirectX::Image* image = outPayload.image.GetImage(mip, 0, 0);
+			mips[mip].pixels = image->pixels;
+			mips[mip].rowPitch = image->rowPitch;
+			mips[mip].slicePitch = image->slicePitch;
+			mips[mip].width = static_cast<uint32_t>(image->width);
+			mips[mip].height = static_cast<uint32_t>(image->height);
+		}
+		cache.Store(cacheKey, static_cast<uint32_t>(cookedMetadata.format), static_cast<uint32_t>(cookedMetadata.width),
+			static_cast<uint32_t>(cookedMetadata.height), mips.data(), static_cast<uint32_t>(mips.size()));
+	}
+	return true;
+}
 
+/// <summary>
+/// ファイルを CPU 上の画像にデコード
+/// </summary>
+bool TextureManager::DecodeTextureFile(const wchar_t* filePath, DirectX::ScratchImage& outImage) const
+{
 	const std::filesystem::path resolvedPath = ResolveTexturePath(filePath);
 	if (resolvedPath.empty())
 	{
 		LOG_DEBUG("Failed to resolve texture path: %ls", filePath != nullptr ? filePath : L"(null)");
+		return false;
+	}
+
+	// Textureの読み込み処理（TextureCooker でクック済みの .dds が新しければそちらを使う）
+	DirectX::TexMetadata metadata = {};
+	HRESULT hr = E_FAIL;
+	if (TextureCooker::IsCookedUpToDate(resolvedPath))
+	{
+		hr = DirectX::LoadFromDDSFile(TextureCooker::GetCookedPath(resolvedPath).c_str(), DirectX::DDS_FLAGS_NONE, &metadata, outImage);
+	}
+	if (SUCCEEDED(hr))
+	{
+		return true;
+	}
+
+	// PNG / BMP / TGA は組み込みのデコーダーで ScratchImage に直接デコードする
+	std::string decodeError;
+	const ImageDecodeStatus status = TextureCooker::DecodeSourceImage(resolvedPath, outImage, &decodeError);
+	if (status == ImageDecodeStatus::Decoded)
+	{
+		return true;
+	}
+	if (status == ImageDecodeStatus::Failed)
+	{
+		LOG_DEBUG("Built-in decoder failed for %ls (%s). Falling back to WIC", resolvedPath.c_str(), decodeError.c_str());
+	}
+	outImage.Release();
+
+	// WIC はスレッドごとに COM の初期化が必要（ワーカースレッドから呼ばれるため）
+	const HRESULT comHr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+	hr = DirectX::LoadFromWICFile(resolvedPath.c_str(), DirectX::WIC_FLAGS_NONE, &metadata, outImage);
+	if (SUCCEEDED(comHr))
+	{
+		CoUninitialize();
+	}
+	if (FAILED(hr))
+	{
+		LOG_DEBUG("Failed to load texture from file: %ls. hr=0x%08X", resolvedPath.c_str(), static_cast<unsigned int>(hr));
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// デコード済みの画像からテクスチャーリソースを作成して初期化
+/// </summary>
+UINT TextureManager::CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer, const DirectX::ScratchImage& scratchImage, DirectX::TexMetadata* outMetadata, uint32_t firstMip)
+{
+	if (scratchImage.GetImage(0, 0, 0) == nullptr || firstMip >= scratchImage.GetMetadata().mipLevels)
+	{
 		return static_cast<UINT>(-1);
 	}
 
-	// Textureの読み込み処理
-	DirectX::ScratchImage scratchImage = {};
+	// ミップごとの画像を firstMip から順に渡す（配列やキューブは扱わない）
+	DirectX::TexMetadata metadata = scratchImage.GetMetadata();
+	metadata.mipLevels -= firstMip;
+	metadata.width = scratchImage.GetImage(firstMip, 0, 0)->width;
+	metadata.height = scratchImage.GetImage(firstMip, 0, 0)->height;
+	std::vector<DirectX::Image> images(metadata.mipLevels);
+	for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+	{
+		images[mip] = *scratchImage.GetImage(firstMip + mip, 0, 0);
+	}
+	return CreateTextureFromImages(textureBuffer, metadata, images.data(), outMetadata);
+}
+
+/// <summary>
+/// 読み込み済みのテクスチャーからリソースを作成して初期化
+/// </summary>
+UINT TextureManager::CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer, const TexturePayload& payload, DirectX::TexMetadata* outMetadata, uint32_t firstMip)
+{
+	if (!payload.cached.IsValid())
+	{
+		return CreateTextureResource(textureBuffer, payload.image, outMetadata, firstMip);
+	}
+
 	DirectX::TexMetadata metadata = {};
-	HRESULT hr = DirectX::LoadFromWICFile(resolvedPath.c_str(), DirectX::WIC_FLAGS_NONE, &metadata, scratchImage);
-    if (FAILED(hr))
+	std::vector<DirectX::Image> images;
+	if (!GetCachedImages(payload.cached, firstMip, metadata, images))
+	{
+		return static_cast<UINT>(-1);
+	}
+	return CreateTextureFromImages(textureBuffer, metadata, images.data(), outMetadata);
+}
+
+/// <summary>
+/// 作成済みのテクスチャーリソースの一部のミップだけを書き換え
+/// </summary>
+bool TextureManager::UpdateTextureResource(ID3D12Resource* textureBuffer, const DirectX::TexMetadata& metadata, const TexturePayload& payload, const std::vector<uint32_t>& mips)
+{
+	DirectX::TexMetadata payloadMetadata = {};
+	std::vector<DirectX::Image> images;
+	if (payload.cached.IsValid())
+	{
+		if (!GetCachedImages(payload.cached, 0, payloadMetadata, images))
+		{
+			return false;
+		}
+	}
+	else
+	{
+		if (payload.image.GetImage(0, 0, 0) == nullptr)
+		{
+			return false;
+		}
+		payloadMetadata = payload.image.GetMetadata();
+		for (size_t mip = 0; mip < payloadMetadata.mipLevels; ++mip)
+		{
+			images.push_back(*payload.image.GetImage(mip, 0, 0));
+		}
+	}
+
+	// 同じ並びのリソースでなければ書き込めない（作り直すのは呼び出し側）
+	if (textureBuffer == nullptr || payloadMetadata.format != metadata.format || payloadMetadata.width != metadata.width ||
+		payloadMetadata.height != metadata.height || payloadMetadata.mipLevels != metadata.mipLevels ||
+		payloadMetadata.arraySize != 1 || payloadMetadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D)
+	{
+		return false;
+	}
+
+	// 前のフレームの GPU の処理は終わっているので、そのまま上書きしてよい
+	GpuUploadQueue* uploadQueue = Dx12RenderDevice::GetUploadQueue();
+	for (uint32_t mip : mips)
+	{
+		if (mip >= metadata.mipLevels || !UploadSubresource(uploadQueue, textureBuffer, metadata.format, mip, images[mip]))
+		{
+			LOG_DEBUG("UpdateTexture: failed to upload mip %u", mip);
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// キャッシュのエントリーのミップを firstMip から並べる
+/// </summary>
+bool TextureManager::GetCachedImages(const CachedTextureFile& cached, uint32_t firstMip, DirectX::TexMetadata& outMetadata, std::vector<DirectX::Image>& outImages)
+{
+	// キャッシュのエントリーはマップした領域をそのまま転送元にする
+	const TextureCacheFormat::CachedTextureHeader& header = cached.GetHeader();
+	if (firstMip >= header.mipCount)
+	{
+		return false;
+	}
+	DirectX::TexMetadata& metadata = outMetadata;
+	metadata = {};
+	metadata.width = cached.GetMip(firstMip).width;
+	metadata.height = cached.GetMip(firstMip).height;
+	metadata.depth = 1;
+	metadata.arraySize = 1;
+	metadata.mipLevels = header.mipCount - firstMip;
+	metadata.format = static_cast<DXGI_FORMAT>(header.format);
+	metadata.dimension = DirectX::TEX_DIMENSION_TEXTURE2D;
+
+	outImages.assign(metadata.mipLevels, DirectX::Image());
+	for (uint32_t mip = 0; mip < metadata.mipLevels; ++mip)
+	{
+		const TextureCacheFormat::CachedMip& cachedMip = cached.GetMip(firstMip + mip);
+		outImages[mip].width = cachedMip.width;
+		outImages[mip].height = cachedMip.height;
+		outImages[mip].format = metadata.format;
+		outImages[mip].rowPitch = cachedMip.rowPitch;
+		outImages[mip].slicePitch = static_cast<size_t>(cachedMip.slicePitch);
+		outImages[mip].pixels = const_cast<uint8_t*>(cached.GetMipPixels(firstMip + mip));
+	}
+	return true;
+}
+
+/// <summary>
+/// ミップごとの画像からテクスチャーリソースと SRV を作成
+/// </summary>
+UINT TextureManager::CreateTextureFromImages(ComPtr<ID3D12Resource>& textureBuffer, const DirectX::TexMetadata& metadata, const DirectX::Image* images, DirectX::TexMetadata* outMetadata)
+{
+    ID3D12Device* device = Dx12RenderDevice::GetDevice();
+    if (device == nullptr)
     {
-        LOG_DEBUG("Failed to load texture from file: %ls. hr=0x%08X", resolvedPath.c_str(), static_cast<unsigned int>(hr));
+        LOG_DEBUG("LoadTexture: no active DirectX12 device");
         return static_cast<UINT>(-1);
+    }
+
+	// SRV は CPU からだけ見えるステージングヒープに作り、描画のたびに Material がテーブルへ集める。
+	// ヒープが一杯ならリソースを作る前にやめる（返したインデックスは DX12Texture の破棄で戻る）
+	const UINT handleIndex = DescriptorHeapManager::Get().AllocateStagingDescriptor();
+	if (handleIndex == UINT_MAX)
+	{
+		LOG_DEBUG("LoadTexture: staging descriptor heap is full");
+		return static_cast<UINT>(-1);
 	}
-	auto image = scratchImage.GetImage(0, 0, 0);//生データ抽出
 
-	// ここでm_pImageTextureBufferにテクスチャデータを転送する処理を実装
+	// 転送キューがあれば GPU 専用メモリ（DEFAULT ヒープ）に作ってコピーキューで転送する。
+	// 無ければ CPU から書き込める L0 のメモリに作って直接書き込む
+	GpuUploadQueue* uploadQueue = Dx12RenderDevice::GetUploadQueue();
 	D3D12_HEAP_PROPERTIES texHeapProps = {};
-	texHeapProps.Type = D3D12_HEAP_TYPE_CUSTOM;
-	texHeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK; //ライトバックで
-	texHeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_L0; //L0プール
+	if (uploadQueue != nullptr)
+	{
+		texHeapProps.Type = D3D12_HEAP_TYPE_DEFAULT;
+	}
+	else
+	{
+		texHeapProps.Type = D3D12_HEAP_TYPE_CUSTOM;
+		texHeapProps.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_WRITE_BACK; //ライトバックで
+		texHeapProps.MemoryPoolPreference = D3D12_MEMORY_POOL_L0; //L0プール
+	}
 	texHeapProps.CreationNodeMask = 0;
 	texHeapProps.VisibleNodeMask = 0;
 
@@ -61,35 +330,38 @@ UINT TextureManager::CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer
 	texResourceDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 	texResourceDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
 
-	hr = device->CreateCommittedResource(
+	HRESULT hr = device->CreateCommittedResource(
 		&texHeapProps,
 		D3D12_HEAP_FLAG_NONE,
 		&texResourceDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
+		uploadQueue != nullptr ? D3D12_RESOURCE_STATE_COMMON : D3D12_RESOURCE_STATE_GENERIC_READ,
 		nullptr,
 		IID_PPV_ARGS(&textureBuffer)
 	);
 	if (!SUCCEEDED(hr)) {
 		LOG_DEBUG("LoadTexture: CreateCommittedResource failed. hr=0x%08X", static_cast<unsigned int>(hr));
+		DescriptorHeapManager::Get().FreeStagingDescriptor(handleIndex);
 		return static_cast<UINT>(-1);
 	}
 
-	// テクスチャデータの転送
-	hr = textureBuffer->WriteToSubresource(
-		0, // DstSubresource
-		nullptr, // pDstBox
-		image->pixels, // pSrcData
-		static_cast<UINT>(image->rowPitch), // SrcRowPitch
-		static_cast<UINT>(image->slicePitch) // SrcDepthPitch
-	);
-	if (!SUCCEEDED(hr)) {
-		LOG_DEBUG("LoadTexture: WriteToSubresource failed. hr=0x%08X", static_cast<unsigned int>(hr));
-		return static_cast<UINT>(-1);
+	// テクスチャデータの転送（ミップごと）
+	for (size_t mip = 0; mip < metadata.mipLevels; ++mip)
+	{
+		if (!UploadSubresource(uploadQueue, textureBuffer.Get(), metadata.format, static_cast<uint32_t>(mip), images[mip]))
+		{
+			LOG_DEBUG("LoadTexture: failed to upload mip %zu", mip);
+			if (uploadQueue != nullptr)
+			{
+				// 記録済みのミップのコピーが終わるまでリソースを破棄しない
+				uploadQueue->WaitIdle();
+			}
+			textureBuffer.Reset();
+			DescriptorHeapManager::Get().FreeStagingDescriptor(handleIndex);
+			return static_cast<UINT>(-1);
+		}
 	}
 
-	
 	// テクスチャリソースの作成と初期化
-	UINT handleIndex = DescriptorHeapManager::Get().AllocateGlobalTextureDescriptor();
 	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
 	srvDesc.Format = metadata.format;
 	srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
@@ -99,7 +371,7 @@ UINT TextureManager::CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer
 	device->CreateShaderResourceView(
 		textureBuffer.Get(),
 		&srvDesc,
-		DescriptorHeapManager::Get().GetCPUHandle(handleIndex));
+		DescriptorHeapManager::Get().GetStagingCPUHandle(handleIndex));
 
 	if (outMetadata != nullptr)
 	{
@@ -109,6 +381,38 @@ UINT TextureManager::CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer
 	return handleIndex;
 }
 
+/// <summary>
+/// 1 つのミップを転送（ブロック圧縮の rowPitch はブロック 1 行分）
+/// </summary>
+bool TextureManager::UploadSubresource(GpuUploadQueue* uploadQueue, ID3D12Resource* textureBuffer, DXGI_FORMAT format, uint32_t mip, const DirectX::Image& image)
+{
+	if (uploadQueue != nullptr)
+	{
+		// コピーはフレームの描画前にまとめて実行され、描画はその完了を待つ
+		GpuUploadQueue::TextureSubresource subresource;
+		subresource.pixels = image.pixels;
+		subresource.rowPitch = image.rowPitch;
+		subresource.rowCount = static_cast<uint32_t>(image.slicePitch / image.rowPitch);
+		subresource.rowHeight = DirectX::IsCompressed(format) ? 4 : 1;
+		subresource.width = static_cast<uint32_t>(image.width);
+		subresource.height = static_cast<uint32_t>(image.height);
+		return uploadQueue->UploadTexture(textureBuffer, mip, static_cast<uint32_t>(format), subresource);
+	}
+
+	const HRESULT hr = textureBuffer->WriteToSubresource(
+		static_cast<UINT>(mip), // DstSubresource
+		nullptr, // pDstBox
+		image.pixels, // pSrcData
+		static_cast<UINT>(image.rowPitch), // SrcRowPitch
+		static_cast<UINT>(image.slicePitch) // SrcDepthPitch
+	);
+	if (!SUCCEEDED(hr)) {
+		LOG_DEBUG("LoadTexture: WriteToSubresource failed. mip=%u hr=0x%08X", mip, static_cast<unsigned int>(hr));
+		return false;
+	}
+	return true;
+}
+
 std::filesystem::path TextureManager::ResolveTexturePath(const wchar_t* filePath) const
 {
 	if (filePath == nullptr || filePath[0] == L'\0')
@@ -1,11 +1,25 @@
 ﻿#pragma once
 
 #include "DX12Texture.h"
+#include "../Analyzer/TextureCache.h"
 
 #include <filesystem>
+#include <vector>
+
+class GpuUploadQueue;
 
 using Microsoft::WRL::ComPtr;
 
+/// <summary>
+/// GPU へ転送する前のテクスチャー。TextureCache に当たった場合はマップしたエントリーを、
+/// 外れた場合はデコードしてミップ生成・圧縮した画像を持ちます。
+/// </summary>
+struct TexturePayload
+{
+	CachedTextureFile cached;
+	DirectX::ScratchImage image;
+};
+
 class TextureManager
 {
 public:
@@ -18,12 +32,46 @@ public:
 	/// </summary>
 	UINT CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer, const wchar_t* filePath, DirectX::TexMetadata* outMetadata = nullptr);
 
+	/// <summary>
+	/// デコード済みの画像からテクスチャーリソースと SRV を作成します（描画スレッドで呼び出します）。
+	/// firstMip を指定すると、そのミップを最上位にした小さなテクスチャーを作ります。
+	/// </summary>
+	UINT CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer, const DirectX::ScratchImage& image, DirectX::TexMetadata* outMetadata = nullptr, uint32_t firstMip = 0);
+
+	/// <summary>
+	/// 読み込み済みのテクスチャーからリソースと SRV を作成します（描画スレッドで呼び出します）。
+	/// キャッシュのエントリーはマップした領域から直接転送します。
+	/// </summary>
+	UINT CreateTextureResource(ComPtr<ID3D12Resource>& textureBuffer, const TexturePayload& payload, DirectX::TexMetadata* outMetadata = nullptr, uint32_t firstMip = 0);
+
+	/// <summary>
+	/// 作成済みのリソースの mips だけを payload の内容で書き換えます（描画スレッドで、前のフレームの
+	/// GPU の処理が終わった後に呼び出します）。大きさ・形式・ミップ数が metadata と違えば false
+	/// </summary>
+	bool UpdateTextureResource(ID3D12Resource* textureBuffer, const DirectX::TexMetadata& metadata, const TexturePayload& payload, const std::vector<uint32_t>& mips);
+
+	/// <summary>
+	/// TextureCache を引き、外れた場合はデコードとクックをしてキャッシュに保存します。
+	/// デバイスを使わないのでワーカースレッドから呼び出せます。
+	/// </summary>
+	bool LoadTexturePayload(const wchar_t* filePath, TexturePayload& outPayload) const;
+
+	/// <summary>
+	/// ファイルを CPU 上の画像にデコードします。デバイスを使わないのでワーカースレッドから呼び出せます。
+	/// </summary>
+	bool DecodeTextureFile(const wchar_t* filePath, DirectX::ScratchImage& outImage) const;
+
 	std::filesystem::path ResolveTexturePath(const wchar_t* filePath) const;
 
 	UINT CreateShaderResoureView();
 
 private:
 	TextureManager() = default;
+
+	UINT CreateTextureFromImages(ComPtr<ID3D12Resource>& textureBuffer, const DirectX::TexMetadata& metadata, const DirectX::Image* images, DirectX::TexMetadata* outMetadata);
+	static bool GetCachedImages(const CachedTextureFile& cached, uint32_t firstMip, DirectX::TexMetadata& outMetadata, std::vector<DirectX::Image>& outImages);
+	/// 転送キューがあればコピーを記録し、無ければ CPU から直接書き込みます。
+	static bool UploadSubresource(GpuUploadQueue* uploadQueue, ID3D12Resource* textureBuffer, DXGI_FORMAT format, uint32_t mip, const DirectX::Image& image);
 	
 };
 
@@ -0,0 +1,347 @@
+﻿#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cmath>
+
+void TextureResidency::Register(TextureId id, uint32_t width, uint32_t height, const std::vector<uint64_t>& mipBytes)
+{
+	Unregister(id);
+	if (mipBytes.empty())
+	{
+		return;
+	}
+
+	Texture texture;
+	texture.width = width;
+	texture.height = height;
+	texture.mipBytes = mipBytes;
+	texture.tailMip = texture.GetMipCount() - 1;
+	for (uint32_t mip = 0; mip < texture.GetMipCount(); ++mip)
+	{
+		if (mipBytes[mip] <= m_Settings.tailMipBytes)
+		{
+			texture.tailMip = mip;
+			break;
+		}
+	}
+	texture.requestedMip = kNoRequest;
+	texture.lastUsedFrames.assign(texture.GetMipCount(), m_FrameIndex);
+
+	m_ResidentBytes += GetBytes(texture, 0, texture.GetMipCount());
+	m_Statistics.peakResidentBytes = (std::max)(m_Statistics.peakResidentBytes, m_ResidentBytes);
+	m_Textures.emplace(id, std::move(texture));
+}
+
+void TextureResidency::Unregister(TextureId id)
+{
+	const auto it = m_Textures.find(id);
+	if (it == m_Textures.end())
+	{
+		return;
+	}
+	m_ResidentBytes -= GetBytes(it->second, it->second.residentMip, it->second.GetMipCount());
+	m_Textures.erase(it);
+}
+
+void TextureResidency::Clear()
+{
+	m_Textures.clear();
+	m_ResidentBytes = 0;
+}
+
+void TextureResidency::RequestMip(TextureId id, uint32_t mip)
+{
+	const auto it = m_Textures.find(id);
+	if (it == m_Textures.end())
+	{
+		return;
+	}
+	// tail はまとめて読むので、それより粗いミップの要求は tail の先頭として扱う
+	Texture& texture = it->second;
+	texture.isPinned = false;
+	texture.requestedMip = (std::min)(texture.requestedMip, (std::min)(mip, texture.tailMip));
+}
+
+void TextureResidency::RequestScreenSize(TextureId id, float screenWidth, float screenHeight)
+{
+	const auto it = m_Textures.find(id);
+	if (it == m_Textures.end())
+	{
+		return;
+	}
+	const Texture& texture = it->second;
+	RequestMip(id, ComputeDesiredMip(texture.width, texture.height, screenWidth, screenHeight, texture.GetMipCount()));
+}
+
+uint32_t TextureResidency::ComputeDesiredMip(uint32_t width, uint32_t height, float screenWidth, float screenHeight, uint32_t mipCount)
+{
+	if (mipCount == 0)
+	{
+		return 0;
+	}
+	// 画面に出ていないものは最も粗いミップで足りる
+	if (screenWidth <= 0.0f || screenHeight <= 0.0f)
+	{
+		return mipCount - 1;
+	}
+	const float ratio = (std::max)(static_cast<float>(width) / screenWidth, static_cast<float>(height) / screenHeight);
+	if (ratio <= 1.0f)
+	{
+		return 0;
+	}
+	const uint32_t mip = static_cast<uint32_t>(std::floor(std::log2(ratio)));
+	return (std::min)(mip, mipCount - 1);
+}
+
+///==========================================================
+/// <summary>
+/// 報告されたミップを記録し、足りないものを予算の範囲で読み込みます。
+/// 予算を超える分は、このフレームで使われていないミップを古い順に追い出して空け、
+/// それでも足りなければ要求より粗いミップで済ませます。
+/// </summary>
+///==========================================================
+void TextureResidency::Update(std::vector<Transition>& outStreams, std::vector<Transition>& outEvictions)
+{
+	outStreams.clear();
+	outEvictions.clear();
+	++m_FrameIndex;
+
+	// 要求されたミップより粗いミップはすべて必要
+	std::vector<TextureId> candidates;
+	for (auto& entry : m_Textures)
+	{
+		Texture& texture = entry.second;
+		if (texture.requestedMip == kNoRequest)
+		{
+			continue;
+		}
+		for (uint32_t mip = texture.requestedMip; mip < texture.GetMipCount(); ++mip)
+		{
+			texture.lastUsedFrames[mip] = m_FrameIndex;
+		}
+		if (!texture.isInTransition && texture.requestedMip < texture.residentMip)
+		{
+			candidates.push_back(entry.first);
+		}
+	}
+
+	// 何も常駐していないもの、足りないミップの段数が多いものから
+	std::sort(candidates.begin(), candidates.end(), [this](TextureId a, TextureId b)
+	{
+		const Texture& textureA = m_Textures.at(a);
+		const Texture& textureB = m_Textures.at(b);
+		const bool isEmptyA = textureA.residentMip == textureA.GetMipCount();
+		const bool isEmptyB = textureB.residentMip == textureB.GetMipCount();
+		if (isEmptyA != isEmptyB)
+		{
+			return isEmptyA;
+		}
+		const uint32_t deficitA = textureA.residentMip - textureA.requestedMip;
+		const uint32_t deficitB = textureB.residentMip - textureB.requestedMip;
+		return deficitA != deficitB ? deficitA > deficitB : a < b;
+	});
+
+	CandidateQueue queue;
+	bool isQueueBuilt = false;
+	uint64_t evictableBytes = 0;
+	std::unordered_map<TextureId, uint32_t> evictedMips;
+	uint64_t streamedBytes = 0;
+	for (TextureId id : candidates)
+	{
+		if (streamedBytes >= m_Settings.streamBytesPerFrame && !outStreams.empty())
+		{
+			break;
+		}
+
+		Texture& texture = m_Textures.at(id);
+		uint32_t firstMip = texture.requestedMip;
+		while (firstMip < texture.residentMip &&
+			!EvictFor(GetBytes(texture, firstMip, texture.residentMip), queue, isQueueBuilt, evictableBytes, evictedMips))
+		{
+			// tail はまとめて扱うので、tail が入らなければ何も読み込めない
+			firstMip = firstMip < texture.tailMip ? firstMip + 1 : texture.residentMip;
+		}
+		if (firstMip > texture.requestedMip)
+		{
+			++m_Statistics.starvedCount;
+		}
+		if (firstMip >= texture.residentMip)
+		{
+			continue;
+		}
+
+		const uint64_t bytes = GetBytes(texture, firstMip, texture.residentMip);
+		m_ResidentBytes += bytes;
+		texture.residentMip = firstMip;
+		texture.isInTransition = true;
+		outStreams.push_back({ id, firstMip });
+		streamedBytes += bytes;
+		m_Statistics.streamedBytes += bytes;
+		++m_Statistics.streamCount;
+	}
+
+	// 予算を下げた、固定のテクスチャが増えたなどで超えている場合は追い出せるだけ追い出す
+	EvictFor(0, queue, isQueueBuilt, evictableBytes, evictedMips);
+
+	for (const auto& evicted : evictedMips)
+	{
+		Texture& texture = m_Textures.at(evicted.first);
+		// すべて解放する場合は作り直しが要らない
+		if (evicted.second == texture.GetMipCount())
+		{
+			texture.loadedMip = evicted.second;
+		}
+		else
+		{
+			texture.isInTransition = true;
+		}
+		outEvictions.push_back({ evicted.first, evicted.second });
+	}
+	std::sort(outEvictions.begin(), outEvictions.end(), [](const Transition& a, const Transition& b) { return a.id < b.id; });
+
+	for (auto& entry : m_Textures)
+	{
+		entry.second.requestedMip = kNoRequest;
+	}
+	m_Statistics.peakResidentBytes = (std::max)(m_Statistics.peakResidentBytes, m_ResidentBytes);
+}
+
+void TextureResidency::CompleteTransition(TextureId id, uint32_t firstMip, bool succeeded)
+{
+	const auto it = m_Textures.find(id);
+	if (it == m_Textures.end())
+	{
+		return;
+	}
+	Texture& texture = it->second;
+	texture.isInTransition = false;
+	if (succeeded)
+	{
+		texture.loadedMip = firstMip;
+		return;
+	}
+
+	// 失敗した場合は GPU に残っているミップに合わせる
+	m_ResidentBytes -= GetBytes(texture, texture.residentMip, texture.GetMipCount());
+	m_ResidentBytes += GetBytes(texture, texture.loadedMip, texture.GetMipCount());
+	texture.residentMip = texture.loadedMip;
+}
+
+uint32_t TextureResidency::GetResidentMip(TextureId id) const
+{
+	const auto it = m_Textures.find(id);
+	return it != m_Textures.end() ? it->second.residentMip : 0;
+}
+
+uint32_t TextureResidency::GetMipCount(TextureId id) const
+{
+	const auto it = m_Textures.find(id);
+	return it != m_Textures.end() ? it->second.GetMipCount() : 0;
+}
+
+TextureResidency::Statistics TextureResidency::GetStatistics() const
+{
+	Statistics statistics = m_Statistics;
+	statistics.textureCount = m_Textures.size();
+	for (const auto& entry : m_Textures)
+	{
+		statistics.pinnedCount += entry.second.isPinned ? 1 : 0;
+	}
+	statistics.residentBytes = m_ResidentBytes;
+	statistics.budgetBytes = m_Settings.budgetBytes;
+	return statistics;
+}
+
+uint64_t TextureResidency::GetBytes(const Texture& texture, uint32_t firstMip, uint32_t lastMip)
+{
+	uint64_t bytes = 0;
+	for (uint32_t mip = firstMip; mip < lastMip && mip < texture.GetMipCount(); ++mip)
+	{
+		bytes += texture.mipBytes[mip];
+	}
+	return bytes;
+}
+
+uint32_t TextureResidency::GetNextEvictedMip(const Texture& texture)
+{
+	return texture.residentMip < texture.tailMip ? texture.residentMip + 1 : texture.GetMipCount();
+}
+
+bool TextureResidency::IsEvictable(const Texture& texture) const
+{
+	return !texture.isPinned && !texture.isInTransition && texture.residentMip < texture.GetMipCount() &&
+		texture.lastUsedFrames[texture.residentMip] < m_FrameIndex;
+}
+
+uint64_t TextureResidency::GetEvictableBytes(const Texture& texture) const
+{
+	if (texture.isPinned || texture.isInTransition)
+	{
+		return 0;
+	}
+	uint64_t bytes = 0;
+	for (uint32_t mip = texture.residentMip; mip < texture.GetMipCount() && texture.lastUsedFrames[mip] < m_FrameIndex; ++mip)
+	{
+		if (mip >= texture.tailMip)
+		{
+			return bytes + GetBytes(texture, texture.tailMip, texture.GetMipCount());
+		}
+		bytes += texture.mipBytes[mip];
+	}
+	return bytes;
+}
+
+void TextureResidency::PushCandidate(CandidateQueue& queue, TextureId id, const Texture& texture) const
+{
+	if (IsEvictable(texture))
+	{
+		queue.push({ texture.lastUsedFrames[texture.residentMip], texture.residentMip, id });
+	}
+}
+
+bool TextureResidency::EvictFor(uint64_t additionalBytes, CandidateQueue& queue, bool& isQueueBuilt, uint64_t& evictableBytes,
+	std::unordered_map<TextureId, uint32_t>& evictedMips)
+{
+	const uint64_t budget = m_Settings.budgetBytes;
+	if (m_ResidentBytes + additionalBytes <= budget)
+	{
+		return true;
+	}
+	if (!isQueueBuilt)
+	{
+		for (const auto& entry : m_Textures)
+		{
+			PushCandidate(queue, entry.first, entry.second);
+			evictableBytes += GetEvictableBytes(entry.second);
+		}
+		isQueueBuilt = true;
+	}
+	// 追い出しても足りない場合は、要求を粗くして試し直せるよう何も追い出さない
+	// （additionalBytes が 0 なら追い出せるだけ追い出す）
+	if (additionalBytes > 0 && m_ResidentBytes + additionalBytes > budget + evictableBytes)
+	{
+		return false;
+	}
+
+	while (m_ResidentBytes + additionalBytes > budget && !queue.empty())
+	{
+		const EvictionCandidate candidate = queue.top();
+		queue.pop();
+		Texture& texture = m_Textures.at(candidate.id);
+		if (!IsEvictable(texture) || texture.residentMip != candidate.mip || texture.lastUsedFrames[texture.residentMip] != candidate.lastUsedFrame)
+		{
+			continue;
+		}
+
+		const uint32_t nextMip = GetNextEvictedMip(texture);
+		const uint64_t freedBytes = GetBytes(texture, texture.residentMip, nextMip);
+		texture.residentMip = nextMip;
+		m_ResidentBytes -= freedBytes;
+		evictableBytes -= (std::min)(evictableBytes, freedBytes);
+		evictedMips[candidate.id] = nextMip;
+		m_Statistics.evictedBytes += freedBytes;
+		++m_Statistics.evictionCount;
+		PushCandidate(queue, candidate.id, texture);
+	}
+	return m_ResidentBytes + additionalBytes <= budget;
+}
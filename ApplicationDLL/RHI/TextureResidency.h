@@ -0,0 +1,160 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// テクスチャのミップ単位の常駐ポリシー。GPU には触れず、何を読み込み何を追い出すかだけを決めます。
+/// 描画側は毎フレーム必要なミップを RequestMip で報告し、Update がメモリの予算に収まるよう
+/// 読み込み（より細かいミップ）と追い出しを決めます。追い出しは最後に必要とされてから最も長い
+/// ミップから順に行い（LRU）、小さなミップの末尾（tail）はまとめて最後に扱います。
+/// 実際の読み込みと作り直しは呼び出し側で行い、終わったら CompleteTransition で知らせます。
+/// 使われ方の報告が一度も無いテクスチャは固定（全ミップ常駐、追い出さない）として予算にだけ数えます。
+/// </summary>
+///=======================================================================
+class TextureResidency
+{
+public:
+	using TextureId = uint32_t;
+
+	struct Settings
+	{
+		/// 常駐するミップの合計バイト数の上限
+		uint64_t budgetBytes = 256ull * 1024 * 1024;
+		/// 1 フレームで読み込みを始めるバイト数の目安（1 件は必ず始める）
+		uint64_t streamBytesPerFrame = 16ull * 1024 * 1024;
+		/// これ以下の大きさのミップは tail としてまとめて常駐させる
+		uint64_t tailMipBytes = 64ull * 1024;
+	};
+
+	/// テクスチャを firstMip 以降のミップだけで作り直す指示（firstMip がミップ数なら解放）
+	struct Transition
+	{
+		TextureId id = 0;
+		uint32_t firstMip = 0;
+	};
+
+	struct Statistics
+	{
+		size_t textureCount = 0;
+		/// 固定のもの（使われ方の報告が無い）
+		size_t pinnedCount = 0;
+		/// 常駐している（読み込み中を含む）ミップの合計
+		uint64_t residentBytes = 0;
+		uint64_t peakResidentBytes = 0;
+		uint64_t budgetBytes = 0;
+		uint64_t streamedBytes = 0;
+		uint64_t evictedBytes = 0;
+		uint64_t streamCount = 0;
+		uint64_t evictionCount = 0;
+		/// 予算が足りず、要求より粗いミップで済ませた（または読み込めなかった）回数
+		uint64_t starvedCount = 0;
+	};
+
+	void SetSettings(const Settings& settings) { m_Settings = settings; }
+	const Settings& GetSettings() const { return m_Settings; }
+
+	///====================================================================
+	/// <summary>
+	/// 全ミップが常駐した状態のテクスチャを固定として登録します。
+	/// </summary>
+	/// <param name="mipBytes">ミップ 0 から順の各ミップのバイト数</param>
+	///====================================================================
+	void Register(TextureId id, uint32_t width, uint32_t height, const std::vector<uint64_t>& mipBytes);
+	void Unregister(TextureId id);
+	bool IsRegistered(TextureId id) const { return m_Textures.count(id) != 0; }
+	void Clear();
+
+	/// 今フレームで必要なミップを報告します（同じフレームで複数回呼ばれたら最も細かいもの）。
+	void RequestMip(TextureId id, uint32_t mip);
+	/// 画面上の大きさ（ピクセル）から必要なミップを求めて報告します。
+	void RequestScreenSize(TextureId id, float screenWidth, float screenHeight);
+	/// テクセルとピクセルがほぼ 1:1 になるミップ
+	static uint32_t ComputeDesiredMip(uint32_t width, uint32_t height, float screenWidth, float screenHeight, uint32_t mipCount);
+
+	///====================================================================
+	/// <summary>
+	/// フレームの初めに 1 度呼び、このフレームの報告から読み込みと追い出しを決めます。
+	/// 決めた時点で予算に数えるため、読み込み中のミップも常駐として扱います。
+	/// </summary>
+	/// <param name="outStreams">より細かいミップを読み込むもの</param>
+	/// <param name="outEvictions">ミップを減らすもの（firstMip がミップ数なら全て解放）</param>
+	///====================================================================
+	void Update(std::vector<Transition>& outStreams, std::vector<Transition>& outEvictions);
+
+	/// 作り直しが終わった（失敗した場合は元のミップのまま）ことを知らせます。
+	void CompleteTransition(TextureId id, uint32_t firstMip, bool succeeded);
+
+	/// 常駐している最も細かいミップ（読み込み中なら読み込み後の値、未登録なら 0）
+	uint32_t GetResidentMip(TextureId id) const;
+	/// 登録したミップ数（未登録なら 0）
+	uint32_t GetMipCount(TextureId id) const;
+	uint64_t GetFrameIndex() const { return m_FrameIndex; }
+	Statistics GetStatistics() const;
+
+private:
+	struct Texture
+	{
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint64_t> mipBytes;
+		/// ここから最後のミップまでを tail としてまとめて扱う
+		uint32_t tailMip = 0;
+		/// 常駐させる最も細かいミップ（ミップ数なら常駐なし）
+		uint32_t residentMip = 0;
+		/// GPU に実際にある最も細かいミップ（作り直し中は residentMip と異なる）
+		uint32_t loadedMip = 0;
+		bool isPinned = true;
+		bool isInTransition = false;
+		/// このフレームで要求されたミップ（kNoRequest なら要求なし）
+		uint32_t requestedMip = 0;
+		/// ミップごとの最後に必要とされたフレーム
+		std::vector<uint64_t> lastUsedFrames;
+
+		uint32_t GetMipCount() const { return static_cast<uint32_t>(mipBytes.size()); }
+	};
+
+	/// 追い出しの候補（テクスチャの最も細かい常駐ミップ、または tail 全体）。
+	/// 同じ古さなら細かいミップ（大きい単位）から追い出す
+	struct EvictionCandidate
+	{
+		uint64_t lastUsedFrame = 0;
+		uint32_t mip = 0;
+		TextureId id = 0;
+		bool operator>(const EvictionCandidate& other) const
+		{
+			if (lastUsedFrame != other.lastUsedFrame)
+			{
+				return lastUsedFrame > other.lastUsedFrame;
+			}
+			return mip != other.mip ? mip > other.mip : id > other.id;
+		}
+	};
+	using CandidateQueue = std::priority_queue<EvictionCandidate, std::vector<EvictionCandidate>, std::greater<EvictionCandidate>>;
+
+	static constexpr uint32_t kNoRequest = UINT32_MAX;
+
+	/// [firstMip, lastMip) のバイト数
+	static uint64_t GetBytes(const Texture& texture, uint32_t firstMip, uint32_t lastMip);
+	/// 次に追い出す単位の次の常駐ミップ（tail ならミップ数）
+	static uint32_t GetNextEvictedMip(const Texture& texture);
+	/// このフレームで使われていない、追い出せる単位か
+	bool IsEvictable(const Texture& texture) const;
+	/// 追い出せる単位の合計バイト数（このフレームで使われていないミップ）
+	uint64_t GetEvictableBytes(const Texture& texture) const;
+	void PushCandidate(CandidateQueue& queue, TextureId id, const Texture& texture) const;
+	/// additionalBytes を加えても予算に収まるまで追い出します。収まらない場合は何もせず false
+	bool EvictFor(uint64_t additionalBytes, CandidateQueue& queue, bool& isQueueBuilt, uint64_t& evictableBytes,
+		std::unordered_map<TextureId, uint32_t>& evictedMips);
+
+	Settings m_Settings;
+	std::unordered_map<TextureId, Texture> m_Textures;
+	uint64_t m_FrameIndex = 0;
+	uint64_t m_ResidentBytes = 0;
+	Statistics m_Statistics;
+};
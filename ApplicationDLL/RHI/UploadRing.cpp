@@ -0,0 +1,53 @@
+﻿#include "UploadRing.h"
+
+void UploadRing::Reset(uint64_t capacity)
+{
+	m_Capacity = capacity;
+	m_Head = 0;
+	m_Tail = 0;
+	m_ClosedHead = 0;
+	m_Submissions.clear();
+}
+
+bool UploadRing::Allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset)
+{
+	if (size == 0 || size > m_Capacity)
+	{
+		return false;
+	}
+
+	const uint64_t physical = m_Head % m_Capacity;
+	uint64_t padding = ((physical + alignment - 1) & ~(alignment - 1)) - physical;
+	if (physical + padding + size > m_Capacity)
+	{
+		// 末尾の残りを捨てて先頭（どの境界にも揃っている）から確保する
+		padding = m_Capacity - physical;
+	}
+	if (m_Head + padding + size - m_Tail > m_Capacity)
+	{
+		return false;
+	}
+
+	outOffset = (m_Head + padding) % m_Capacity;
+	m_Head += padding + size;
+	return true;
+}
+
+void UploadRing::CloseSubmission(uint64_t fenceValue)
+{
+	if (!HasOpenAllocations())
+	{
+		return;
+	}
+	m_Submissions.push_back({ fenceValue, m_Head });
+	m_ClosedHead = m_Head;
+}
+
+void UploadRing::Reclaim(uint64_t completedFenceValue)
+{
+	while (!m_Submissions.empty() && m_Submissions.front().fenceValue <= completedFenceValue)
+	{
+		m_Tail = m_Submissions.front().end;
+		m_Submissions.pop_front();
+	}
+}
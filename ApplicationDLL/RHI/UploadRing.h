@@ -0,0 +1,60 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+///=======================================================================
+/// <summary>
+/// アップロード用バッファを先頭から順に切り出すリングアロケーター。
+/// 確保した領域は CloseSubmission でフェンス値と結び付け、
+/// Reclaim にそのフェンスの完了が渡されるまで再利用しません。
+/// GPU の API には依存しないため、単体で動作を確認できます。
+/// </summary>
+///=======================================================================
+class UploadRing
+{
+public:
+	UploadRing() = default;
+	explicit UploadRing(uint64_t capacity) { Reset(capacity); }
+
+	/// 容量を設定し、使用中の領域をすべて破棄します。
+	void Reset(uint64_t capacity);
+
+	///====================================================================
+	/// <summary>
+	/// 領域を確保します。末尾に収まらない場合は先頭に折り返します。
+	/// </summary>
+	/// <param name="alignment">2 の累乗</param>
+	/// <param name="outOffset">バッファ先頭からのオフセット</param>
+	/// <returns>空きが足りない場合は false（Reclaim 後に再試行すること）</returns>
+	///====================================================================
+	bool Allocate(uint64_t size, uint64_t alignment, uint64_t& outOffset);
+
+	/// 前回からこれまでに確保した領域を fenceValue の完了で解放されるものとします。
+	void CloseSubmission(uint64_t fenceValue);
+	/// completedFenceValue までに完了した領域を解放します。
+	void Reclaim(uint64_t completedFenceValue);
+
+	uint64_t GetCapacity() const { return m_Capacity; }
+	/// 使用中（未解放）のバイト数。折り返しで飛ばした領域も含みます
+	uint64_t GetUsedSize() const { return m_Head - m_Tail; }
+	/// まだ CloseSubmission していない確保があるか
+	bool HasOpenAllocations() const { return m_Head != m_ClosedHead; }
+	/// 解放待ちの最も古いフェンス値（無ければ 0）
+	uint64_t GetOldestPendingFence() const { return m_Submissions.empty() ? 0 : m_Submissions.front().fenceValue; }
+
+private:
+	struct Submission
+	{
+		uint64_t fenceValue = 0;
+		uint64_t end = 0;		// この提出までに確保した領域の終端
+	};
+
+	// 位置は単調増加させ、容量で割った余りを実際のオフセットとする
+	uint64_t m_Capacity = 0;
+	uint64_t m_Head = 0;
+	uint64_t m_Tail = 0;
+	uint64_t m_ClosedHead = 0;
+	std::deque<Submission> m_Submissions;
+};
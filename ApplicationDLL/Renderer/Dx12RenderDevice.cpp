@@ -1,6 +1,11 @@
 ﻿#include "pch.h"
 #include "Dx12RenderDevice.h"
 #include "DescriptorHeapManager.h"
+#include "FrameConstantsManager.h"
+#include "../SpriteRenderers/Dx12SpriteBatchRenderer.h"
+#include "DX12TextureLoader.h"
+#include "../Analyzer/TextureCache.h"
+#include "../System/ResourceAccounting.h"
 
 #include <Windows.h>
 #include <cstring>
@@ -37,6 +42,11 @@ ID3D12GraphicsCommandList* Dx12RenderDevice::GetCommandList()
     return (s_activeInstance_ != nullptr) ? s_activeInstance_->commandList_.Get() : nullptr;
 }
 
+GpuUploadQueue* Dx12RenderDevice::GetUploadQueue()
+{
+    return (s_activeInstance_ != nullptr) ? s_activeInstance_->uploadQueue_.get() : nullptr;
+}
+
 HRESULT Dx12RenderDevice::GetDeviceRemovedReason()
 {
     if (s_activeInstance_ == nullptr || s_activeInstance_->device_ == nullptr)
@@ -120,6 +130,27 @@ void Dx12RenderDevice::Shutdown()
 
     WaitForPreviousFrame();
 
+    // 以降のテクスチャ読み込みを止め、このデバイスのプレースホルダーを破棄する
+    TextureAssetManager::Get().SetLoader(nullptr);
+    TextureAssetManager::Get().SetHotReloadEnabled(false);
+    LOG_DEBUG("%s", TextureAssetManager::Get().FormatAtlasReport().c_str());
+    LOG_DEBUG("%s", TextureAssetManager::Get().FormatResidencyReport().c_str());
+    LOG_DEBUG("%s", TextureAssetManager::Get().FormatHotReloadReport().c_str());
+    LOG_DEBUG("%s", TextureCache::Get().FormatReport().c_str());
+    LOG_DEBUG("%s", DescriptorHeapManager::Get().FormatReport().c_str());
+    LOG_DEBUG("%s", FrameConstantsManager::Get().FormatReport().c_str());
+    LOG_DEBUG("%s", Dx12SpriteBatchRenderer::Get().FormatReport().c_str());
+    LOG_DEBUG("%s", ResourceAccounting::Get().FormatReport().c_str());
+    TextureCache::Get().Close();
+    // GPU の処理は待ったので、定数とスプライトのインスタンスのページはここで破棄してよい
+    FrameConstantsManager::Get().Reset();
+    Dx12SpriteBatchRenderer::Get().Reset();
+
+    // 転送の完了を待ってからコピーキューを破棄する
+    uploadQueue_.reset();
+    uploadBackend_.reset();
+    waitedUploadFenceValue_ = 0;
+
     renderTargets_.clear();
     primaryHwnd_ = nullptr;
     commandList_.Reset();
@@ -239,11 +270,29 @@ bool Dx12RenderDevice::Initialize(HWND hwnd, UINT width, UINT height)
     if (!CreateRenderTargetView(primaryTarget)) return false;
     renderTargets_[hwnd] = std::move(primaryTarget);
     if (!CreateFence()) return false;
+    if (!CreateUploadQueue())
+    {
+        // 転送キューが無くてもメッシュは UPLOAD ヒープで作成できる
+        LOG_DEBUG("Dx12RenderDevice: copy queue is unavailable, geometry stays in upload heaps");
+    }
 
 	if (!DescriptorHeapManager::Get().InitializeGlobalTextureHeap(device_.Get()))
     {
         return false;
     }
+    DescriptorHeapManager::Get().BeginFrame(fenceValue_ + 1, fence_->GetCompletedValue());
+    if (!FrameConstantsManager::Get().Initialize(device_.Get()))
+    {
+        return false;
+    }
+    FrameConstantsManager::Get().BeginFrame(fenceValue_ + 1, fence_->GetCompletedValue());
+    Dx12SpriteBatchRenderer::Get().BeginFrame(fenceValue_ + 1, fence_->GetCompletedValue());
+    // 2 回目以降の起動ではデコードとクックを省く
+    if (!TextureCache::Get().Open(std::filesystem::current_path() / L"Cache" / L"Texture"))
+    {
+        LOG_DEBUG("Failed to open texture cache directory");
+    }
+    TextureAssetManager::Get().SetLoader(std::make_shared<DX12TextureLoader>());
     return true;
 }
 
@@ -518,6 +567,34 @@ bool Dx12RenderDevice::CreateFence()
     return SUCCEEDED(device_->CreateFence(fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_)));
 }
 
+bool Dx12RenderDevice::CreateUploadQueue()
+{
+    auto backend = std::make_unique<DX12UploadBackend>();
+    if (!backend->Initialize(device_.Get()))
+    {
+        return false;
+    }
+    uploadBackend_ = std::move(backend);
+    uploadQueue_ = std::make_unique<GpuUploadQueue>(*uploadBackend_);
+    return true;
+}
+
+void Dx12RenderDevice::WaitForUploads()
+{
+    if (uploadQueue_ == nullptr)
+    {
+        return;
+    }
+
+    // コピーの完了を GPU 側で待つ（CPU は止めない）
+    const UINT64 uploadFenceValue = uploadQueue_->Flush();
+    if (uploadFenceValue > waitedUploadFenceValue_)
+    {
+        commandQueue_->Wait(uploadBackend_->GetFence(), uploadFenceValue);
+        waitedUploadFenceValue_ = uploadFenceValue;
+    }
+}
+
 void Dx12RenderDevice::PreRender(const float clearColor[4])
 {
     PreRenderTarget(primaryHwnd_, clearColor);
@@ -589,6 +666,7 @@ void Dx12RenderDevice::RenderTarget(SwapChainRenderTarget& target)
 
     commandList_->Close();
 
+    WaitForUploads();
     ID3D12CommandList* commandLists[] = { commandList_.Get() };
     commandQueue_->ExecuteCommandLists(_countof(commandLists), commandLists);
 
@@ -602,6 +680,10 @@ void Dx12RenderDevice::RenderTarget(SwapChainRenderTarget& target)
 #endif
 
     WaitForPreviousFrame();
+    // 待った分までに解放されたディスクリプタを戻し、次のフレームの領域を空ける
+    DescriptorHeapManager::Get().BeginFrame(fenceValue_ + 1, fence_->GetCompletedValue());
+    FrameConstantsManager::Get().BeginFrame(fenceValue_ + 1, fence_->GetCompletedValue());
+    Dx12SpriteBatchRenderer::Get().BeginFrame(fenceValue_ + 1, fence_->GetCompletedValue());
 
     commandAllocator_->Reset();
     commandList_->Reset(commandAllocator_.Get(), nullptr);
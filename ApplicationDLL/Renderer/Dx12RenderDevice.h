@@ -1,10 +1,12 @@
 #pragma once
 
 #include "IRenderDevice.h"
+#include "../RHI/DX12UploadBackend.h"
 
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl/client.h>
+#include <memory>
 #include <unordered_map>
 #include <vector>
 
@@ -33,6 +35,8 @@ public:
     static Microsoft::WRL::ComPtr<ID3D12Device> GetDeviceComPtr();
     static ID3D12GraphicsCommandList* GetCommandList();
     static HRESULT GetDeviceRemovedReason();
+    /// DEFAULT ヒープへの転送キュー（コピーキューを作れなかった場合は null）
+    static GpuUploadQueue* GetUploadQueue();
 
 private:
     struct SwapChainRenderTarget
@@ -56,6 +60,9 @@ private:
     void PreRenderTarget(SwapChainRenderTarget& target, const float clearColor[4]);
     void RenderTarget(SwapChainRenderTarget& target);
     bool CreateFence();
+    bool CreateUploadQueue();
+    /// 転送中のコピーの完了をグラフィックスキューで待ちます。
+    void WaitForUploads();
     void WaitForPreviousFrame();
     void EnableDebugLayer();
 
@@ -78,5 +85,9 @@ private:
     Microsoft::WRL::ComPtr<IDXGIAdapter> adapter_;
 
     UINT64 fenceValue_ = 0;
+
+    std::unique_ptr<DX12UploadBackend> uploadBackend_;
+    std::unique_ptr<GpuUploadQueue> uploadQueue_;
+    UINT64 waitedUploadFenceValue_ = 0;
     bool isShutdown_ = false;
 };
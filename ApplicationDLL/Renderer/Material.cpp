@@ -3,6 +3,8 @@
 #include "Material.h"
 #include "DX12Texture.h"
 
+#include <algorithm>
+
 /// <summary>
 /// ディスクリプタテーブルを使用して単純なテクスチャ付きクアッドを描画するための組み込みマテリアルの説明を作成します。
 /// </summary>
@@ -76,6 +78,104 @@ Material::MaterialDesc Material::CreateBuiltInTexturedQuadDesc()
     return desc;
 }
 
+///=====================================================
+/// <summary>
+/// バインドレスのシェーダーで単純なテクスチャ付きクアッドを描画するための組み込みマテリアルの説明を作成します。
+/// テクスチャーはヒープ全体を見る SRV テーブル（t0, space1 から始まる配列）から、
+/// ルート定数（b1）で渡したインデックスで読みます。頂点シェーダーはテクスチャーを読まないので共通です。
+/// </summary>
+/// <returns></returns>
+///=====================================================
+Material::MaterialDesc Material::CreateBuiltInBindlessTexturedQuadDesc()
+{
+    MaterialDesc desc = CreateBuiltInTexturedQuadDesc();
+    desc.pipelineDesc.pixelShader.m_ShaderFile = L"BindlessPixelShader.hlsl";
+    desc.pipelineDesc.pixelShader.m_EntryPoint = "BindlessPS";
+    // 大きさを決めないリソースの配列は 5.1 から
+    desc.pipelineDesc.pixelShader.m_ShaderModel = "ps_5_1";
+    desc.pipelineDesc.pixelShader.m_CompileFlags = D3DCOMPILE_ENABLE_UNBOUNDED_DESCRIPTOR_TABLES;
+    desc.pipelineDesc.rootSignatureDesc.rootSignatureParameters = {
+        /// テクスチャーのインデックスを渡すルート定数を追加します。
+        {
+            RootSignatureCache::RootParameterType::Constants,
+            D3D12_SHADER_VISIBILITY_PIXEL,
+            0,
+            0,
+            0,
+            1,  // b1 に置きます（b0 は頂点シェーダーの定数バッファ）。
+            0,
+            1   // テクスチャー 1 枚分のインデックス
+        },
+        /// 定数バッファビューのルートパラメータを追加します。SetConstantBuffer が使う 1 番のままにします。
+        {
+            RootSignatureCache::RootParameterType::ConstantBufferView,
+            D3D12_SHADER_VISIBILITY_VERTEX,
+            0,
+            0,
+            0,
+            0,
+            0
+        },
+        /// ヒープ全体を見る SRV テーブルを追加します。
+        {
+            RootSignatureCache::RootParameterType::DescriptorTableSrv,
+            D3D12_SHADER_VISIBILITY_PIXEL,
+            RootSignatureCache::UnboundedDescriptorCount,
+            0,
+            1,  // 他の SRV のレジスタと重ならないよう space1 に置きます。
+            0,
+            0
+        }
+    };
+    desc.parameterBlock.bindless.isEnabled = true;
+    desc.parameterBlock.bindless.textureIndexRootParameterIndex = 0;
+    desc.parameterBlock.bindless.textureIndexCount = 1;
+    desc.parameterBlock.bindless.heapTableRootParameterIndex = 2;
+    return desc;
+}
+
+///=====================================================
+/// <summary>
+/// スプライトのバッチを描くための組み込みマテリアルの説明を作成します。
+/// スロット 0 は単位四角形の頂点、スロット 1 は SpriteInstance（48 バイト）をインスタンスごとに読みます。
+/// 位置は頂点シェーダーで NDC に置くだけなので、定数バッファはありません。
+/// </summary>
+/// <returns></returns>
+///=====================================================
+Material::MaterialDesc Material::CreateBuiltInSpriteBatchDesc()
+{
+    MaterialDesc desc = CreateBuiltInBindlessTexturedQuadDesc();
+    desc.pipelineDesc.vertexShader.m_ShaderFile = L"SpriteBatchVertexShader.hlsl";
+    desc.pipelineDesc.vertexShader.m_EntryPoint = "SpriteBatchVS";
+    desc.pipelineDesc.pixelShader.m_ShaderFile = L"SpriteBatchPixelShader.hlsl";
+    desc.pipelineDesc.pixelShader.m_EntryPoint = "SpriteBatchPS";
+    desc.pipelineDesc.inputElements = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+        /// 中心と大きさ、UV の範囲、テクスチャーのインデックス、色（SpriteInstance の並び）
+        { "SPRITE_RECT", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "SPRITE_UV", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "SPRITE_TEXTURE", 0, DXGI_FORMAT_R32_UINT, 1, 32, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM, 1, 36, D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA, 1 }
+    };
+    desc.pipelineDesc.rootSignatureDesc.rootSignatureParameters = {
+        /// ヒープ全体を見る SRV テーブルだけを置きます。
+        {
+            RootSignatureCache::RootParameterType::DescriptorTableSrv,
+            D3D12_SHADER_VISIBILITY_PIXEL,
+            RootSignatureCache::UnboundedDescriptorCount,
+            0,
+            1,
+            0,
+            0
+        }
+    };
+    desc.parameterBlock.bindless.isEnabled = true;
+    desc.parameterBlock.bindless.heapTableRootParameterIndex = 0;
+    desc.parameterBlock.bindless.textureIndexRootParameterIndex = 0;
+    desc.parameterBlock.bindless.textureIndexCount = 0;
+    return desc;
+}
+
 ///=====================================================
 /// <summary>
 /// 初期化します。
@@ -108,6 +208,7 @@ HRESULT Material::Initialize(ID3D12Device* device, PipelineLibrary& pipelineLibr
 /// マテリアルを指定したコマンドリストにバインドします。
 /// commandList および内部の pipeline_ が有効な場合に、パイプラインステートとルートシグネチャを設定し、
 /// グローバルなテクスチャ用ディスクリプタヒープと SRV ディスクリプタテーブルをコマンドリストにセットします。
+/// バインドレスのマテリアルでは、テーブルを集める代わりにテクスチャーのインデックスをルート定数で渡します。
 /// commandList または pipeline_ が nullptr の場合は何もしません。
 /// </summary>
 /// <param name="commandList">レンダリングコマンドを記録するための
@@ -128,6 +229,33 @@ void Material::Bind(ID3D12GraphicsCommandList* commandList) const
 	// ルートシグネチャをコマンドリストにセットします。
     commandList->SetGraphicsRootSignature(m_pPipeline->rootSignature.Get());
 
+    if (m_ParameterBlock.bindless.isEnabled)
+    {
+        BindBindlessTextures(commandList);
+    }
+    else
+    {
+        BindDescriptorTables(commandList);
+    }
+
+	// 各定数バッファバインディングに対して、定数バッファビューをコマンドリストにセットします。
+    for (const auto& binding : m_ParameterBlock.constantBufferBindings)
+    {
+        if (binding.gpuVirtualAddress == 0)
+        {
+            continue;
+        }
+        commandList->SetGraphicsRootConstantBufferView(binding.rootParameterIndex, binding.gpuVirtualAddress);
+    }
+}
+
+///=====================================================
+/// <summary>
+/// テーブルはルートパラメーターごとに、ステージングヒープの SRV をフレームの領域へ集めて作ります。
+/// </summary>
+///=====================================================
+void Material::BindDescriptorTables(ID3D12GraphicsCommandList* commandList) const
+{
 	// テクスチャバインディングが存在するかどうかを確認します。
     bool hasTextureBinding = false;
     for (const auto& binding : m_ParameterBlock.textureBindings)
@@ -146,27 +274,95 @@ void Material::Bind(ID3D12GraphicsCommandList* commandList) const
         commandList->SetDescriptorHeaps(1, textureHeap);
     }
 
-	// 各テクスチャバインディングに対して、SRV ディスクリプタテーブルをコマンドリストにセットします。
-    for (const auto& binding : m_ParameterBlock.textureBindings)
+	// ルートパラメーターごとに、SRV を連続したテーブルに集めてコマンドリストにセットします。
+	// 同じ並びは同じフレームのうちは使い回されるので、コピーはテクスチャーの組み合わせごとに 1 回です。
+    const auto& textureBindings = m_ParameterBlock.textureBindings;
+    UINT stagingIndices[D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    for (size_t first = 0; first < textureBindings.size(); ++first)
     {
-        if (binding.textureResource == nullptr)
+        const UINT rootParameterIndex = textureBindings[first].rootParameterIndex;
+        bool isFirstOfTable = true;
+        for (size_t previous = 0; previous < first; ++previous)
+        {
+            isFirstOfTable = isFirstOfTable && textureBindings[previous].rootParameterIndex != rootParameterIndex;
+        }
+        if (!isFirstOfTable)
+        {
+            continue;
+        }
+
+        // 1 つでも欠けていると後ろのレジスターがずれるので、そのテーブルはセットしない
+        UINT stagingCount = 0;
+        bool isComplete = true;
+        for (size_t i = first; i < textureBindings.size(); ++i)
+        {
+            if (textureBindings[i].rootParameterIndex != rootParameterIndex)
+            {
+                continue;
+            }
+            isComplete = isComplete && textureBindings[i].textureResource != nullptr && stagingCount < _countof(stagingIndices);
+            if (isComplete)
+            {
+                stagingIndices[stagingCount++] = static_cast<DX12Texture*>(textureBindings[i].textureResource)->GetStagingDescriptorIndex();
+            }
+        }
+        if (!isComplete)
+        {
+            continue;
+        }
+
+        const UINT tableIndex = DescriptorHeapManager::Get().GatherFrameDescriptors(stagingIndices, stagingCount);
+        if (tableIndex == UINT_MAX)
         {
             continue;
         }
-        auto gpuHandleIndex = static_cast<DX12Texture*>(binding.textureResource)->GetDescriptorIndex();
-        auto handle = DescriptorHeapManager::Get().GetGPUHandle(gpuHandleIndex);
-        commandList->SetGraphicsRootDescriptorTable(binding.rootParameterIndex, handle);
+        commandList->SetGraphicsRootDescriptorTable(rootParameterIndex, DescriptorHeapManager::Get().GetGPUHandle(tableIndex));
     }
+}
 
-	// 各定数バッファバインディングに対して、定数バッファビューをコマンドリストにセットします。
-    for (const auto& binding : m_ParameterBlock.constantBufferBindings)
+///=====================================================
+/// <summary>
+/// テクスチャーはシェーダーから見えるヒープの決まった場所にあるので、ディスクリプタのコピーも
+/// テーブルの検索も要りません。描画ごとに変わるのはルート定数だけです。
+/// 1 つでも欠けている（まだバインドレスのインデックスが無い）場合は何もセットしません。
+/// </summary>
+///=====================================================
+void Material::BindBindlessTextures(ID3D12GraphicsCommandList* commandList) const
+{
+    const auto& layout = m_ParameterBlock.bindless;
+    DescriptorHeapManager& heapManager = DescriptorHeapManager::Get();
+    if (layout.textureIndexCount == 0)
     {
-        if (binding.gpuVirtualAddress == 0)
+        // インデックスはインスタンスごとに頂点バッファで渡されるので、ヒープだけを設定する
+        commandList->SetDescriptorHeaps(1, heapManager.GetGlobalTextureHeapAddress());
+        commandList->SetGraphicsRootDescriptorTable(layout.heapTableRootParameterIndex, heapManager.GetGPUHandle(0));
+        return;
+    }
+
+    const auto& textureBindings = m_ParameterBlock.textureBindings;
+    UINT textureIndices[D3D12_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT];
+    const UINT textureCount = static_cast<UINT>((std::min)(textureBindings.size(), static_cast<size_t>(layout.textureIndexCount)));
+    if (textureCount == 0 || textureCount > _countof(textureIndices))
+    {
+        return;
+    }
+
+    for (UINT i = 0; i < textureCount; ++i)
+    {
+        if (textureBindings[i].textureResource == nullptr)
         {
-            continue;
+            return;
+        }
+        textureIndices[i] = static_cast<DX12Texture*>(textureBindings[i].textureResource)->GetBindlessDescriptorIndex();
+        if (textureIndices[i] == UINT_MAX)
+        {
+            return;
         }
-        commandList->SetGraphicsRootConstantBufferView(binding.rootParameterIndex, binding.gpuVirtualAddress);
     }
+
+    commandList->SetDescriptorHeaps(1, heapManager.GetGlobalTextureHeapAddress());
+    commandList->SetGraphicsRootDescriptorTable(layout.heapTableRootParameterIndex, heapManager.GetGPUHandle(0));
+    commandList->SetGraphicsRoot32BitConstants(layout.textureIndexRootParameterIndex, textureCount, textureIndices, 0);
 }
 
 ///=====================================================
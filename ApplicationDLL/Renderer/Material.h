@@ -17,6 +17,7 @@ public:
     /// </summary>
     struct MaterialParameterBlock
     {
+        /// 同じ rootParameterIndex のバインディングは、並びの順に 1 つのテーブル（t0, t1, ...）にまとめます。
         struct TextureBinding
         {
             UINT rootParameterIndex = 0;
@@ -29,8 +30,21 @@ public:
             D3D12_GPU_VIRTUAL_ADDRESS gpuVirtualAddress = 0;
         };
 
+        /// バインドレスのマテリアルでは、テクスチャーをテーブルに集めずに、textureBindings の並びの順に
+        /// シェーダーから見えるヒープでのインデックスをルート定数で渡します（rootParameterIndex は使いません）。
+        struct BindlessLayout
+        {
+            bool isEnabled = false;
+            /// 範囲の大きさを決めない SRV テーブル。ヒープの先頭を設定します。
+            UINT heapTableRootParameterIndex = 0;
+            /// テクスチャーのインデックスを受け取るルート定数と、その数（0 ならインデックスは頂点バッファなどで渡す）
+            UINT textureIndexRootParameterIndex = 0;
+            UINT textureIndexCount = 0;
+        };
+
         std::vector<TextureBinding> textureBindings;
         std::vector<ConstantBufferBinding> constantBufferBindings;
+        BindlessLayout bindless;
     };
 
     struct MaterialDesc
@@ -40,6 +54,12 @@ public:
     };
 
     static MaterialDesc CreateBuiltInTexturedQuadDesc();
+    /// CreateBuiltInTexturedQuadDesc と同じ見た目を、バインドレスのシェーダーで描きます。
+    /// DescriptorHeapManager::IsBindlessSupported が true の場合だけ使えます。
+    static MaterialDesc CreateBuiltInBindlessTexturedQuadDesc();
+    /// スプライトのバッチ（Dx12SpriteBatchRenderer）用。共通の単位四角形をスプライトの数だけインスタンス描画し、
+    /// テクスチャーのインデックスはインスタンスごとに頂点バッファで渡します（バインドレスの場合だけ使えます）。
+    static MaterialDesc CreateBuiltInSpriteBatchDesc();
 
     HRESULT Initialize(ID3D12Device* device, PipelineLibrary& pipelineLibrary, const MaterialDesc& desc);
 
@@ -55,6 +75,11 @@ public:
     void SetConstantBuffer(D3D12_GPU_VIRTUAL_ADDRESS address);
 
 private:
+    /// ルートパラメーターごとに、ステージングヒープの SRV をフレームの領域へ集めてテーブルをセットします。
+    void BindDescriptorTables(ID3D12GraphicsCommandList* commandList) const;
+    /// ヒープ全体のテーブルと、テクスチャーのインデックスのルート定数をセットします。
+    void BindBindlessTextures(ID3D12GraphicsCommandList* commandList) const;
+
     std::shared_ptr<const PipelineLibrary::GraphicsPipeline> m_pPipeline;
     MaterialParameterBlock m_ParameterBlock;
 };
@@ -0,0 +1,125 @@
+﻿#include "pch.h"
+#include "MeshImporter.h"
+#include "../System/JobSystem.h"
+#include <chrono>
+#include <filesystem>
+
+MeshImporter& MeshImporter::Get()
+{
+	static MeshImporter instance;
+	return instance;
+}
+
+///====================================================================
+/// <summary>
+/// ワーカーで MeshImport::Import を実行し、結果を転送待ちキューに積みます。
+/// </summary>
+/// <param name="fileName">.pmd または .pmdc のパス</param>
+/// <returns>ProcessPendingUploads で完了するハンドル</returns>
+///====================================================================
+MeshImportHandle MeshImporter::ImportAsync(const string& fileName)
+{
+	auto promise = std::make_shared<std::promise<std::shared_ptr<MeshObject>>>();
+	MeshImportHandle handle = promise->get_future().share();
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		++m_InFlightCount;
+	}
+
+	JobSystem::Get().Submit([this, fileName, promise]()
+	{
+		PendingUpload upload;
+		upload.fileName = fileName;
+		upload.promise = promise;
+		try
+		{
+			auto data = std::make_unique<MeshImport::MeshData>();
+			std::string error;
+			if (MeshImport::Import(std::filesystem::path(fileName), *data, &error))
+			{
+				upload.data = std::move(data);
+			}
+			else
+			{
+				LOG_DEBUG("MeshImporter: %s (%s)\n", error.c_str(), fileName.c_str());
+			}
+		}
+		catch (const std::exception& ex)
+		{
+			LOG_DEBUG("MeshImporter: %s (%s)\n", ex.what(), fileName.c_str());
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		--m_InFlightCount;
+		m_ReadyUploads.push_back(std::move(upload));
+	});
+	return handle;
+}
+
+std::vector<MeshImportHandle> MeshImporter::ImportAsync(const std::vector<string>& fileNames)
+{
+	std::vector<MeshImportHandle> handles;
+	handles.reserve(fileNames.size());
+	for (const string& fileName : fileNames)
+	{
+		handles.push_back(ImportAsync(fileName));
+	}
+	return handles;
+}
+
+size_t MeshImporter::ProcessPendingUploads(size_t maxUploads)
+{
+	size_t processedCount = 0;
+	while (maxUploads == 0 || processedCount < maxUploads)
+	{
+		PendingUpload upload;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (m_ReadyUploads.empty())
+			{
+				break;
+			}
+			upload = std::move(m_ReadyUploads.front());
+			m_ReadyUploads.pop_front();
+		}
+
+		// GPU リソースの作成はロックの外で行う
+		std::shared_ptr<MeshObject> mesh;
+		if (upload.data != nullptr)
+		{
+			mesh = std::make_shared<MeshObject>(*upload.data);
+			if (!mesh->IsValid())
+			{
+				LOG_DEBUG("MeshImporter: failed to create buffers (%s)\n", upload.fileName.c_str());
+				mesh.reset();
+			}
+		}
+		upload.promise->set_value(std::move(mesh));
+		++processedCount;
+	}
+	return processedCount;
+}
+
+size_t MeshImporter::GetPendingCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_InFlightCount + m_ReadyUploads.size();
+}
+
+void MeshImporter::Clear()
+{
+	std::deque<PendingUpload> uploads;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		uploads.swap(m_ReadyUploads);
+	}
+	for (PendingUpload& upload : uploads)
+	{
+		upload.promise->set_value(nullptr);
+	}
+}
+
+bool MeshImporter::IsReady(const MeshImportHandle& handle)
+{
+	return handle.valid() && handle.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
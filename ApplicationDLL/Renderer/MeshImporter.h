@@ -0,0 +1,71 @@
+﻿#pragma once
+#include "pch.h"
+#include "MeshObject.h"
+#include <cstddef>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// 非同期読み込みの結果。失敗した場合は nullptr になります。
+using MeshImportHandle = std::shared_future<std::shared_ptr<MeshObject>>;
+
+///=======================================================================
+/// <summary>
+/// 複数のメッシュを JobSystem のワーカーで並列に読み込みます。
+/// 解析・三角形の並べ替え・パックはワーカーで行い、GPU バッファの作成は
+/// 描画スレッドで ProcessPendingUploads を呼んだときに行います。
+/// ハンドルは ProcessPendingUploads の中で完了するため、描画スレッドで
+/// get() を呼んで待たないでください（IsReady で確認します）。
+/// </summary>
+///=======================================================================
+class MeshImporter
+{
+public:
+	/// 1 フレームで作成する GPU バッファ数の既定の上限
+	static constexpr size_t kDefaultUploadsPerFrame = 4;
+
+	static MeshImporter& Get();
+
+	MeshImporter(const MeshImporter&) = delete;
+	MeshImporter& operator=(const MeshImporter&) = delete;
+
+	/// 読み込みを開始します。どのスレッドからでも呼び出せます。
+	MeshImportHandle ImportAsync(const string& fileName);
+	/// 複数のファイルの読み込みをまとめて開始します。
+	std::vector<MeshImportHandle> ImportAsync(const std::vector<string>& fileNames);
+
+	///====================================================================
+	/// <summary>
+	/// CPU 側の処理が終わったメッシュの GPU バッファを作成し、ハンドルを完了させます。
+	/// 描画スレッドから毎フレーム呼び出します。
+	/// </summary>
+	/// <param name="maxUploads">このフレームで作成する上限（0 の場合は無制限）</param>
+	/// <returns>完了させたハンドルの数</returns>
+	///====================================================================
+	size_t ProcessPendingUploads(size_t maxUploads = kDefaultUploadsPerFrame);
+
+	/// ワーカーで処理中または転送待ちの数
+	size_t GetPendingCount() const;
+
+	/// 転送待ちのメッシュを破棄し、ハンドルを nullptr で完了させます（デバイス破棄前に呼び出します）。
+	void Clear();
+
+	static bool IsReady(const MeshImportHandle& handle);
+
+private:
+	MeshImporter() = default;
+
+	struct PendingUpload
+	{
+		string fileName;
+		std::unique_ptr<MeshImport::MeshData> data;	// 失敗した場合は nullptr
+		std::shared_ptr<std::promise<std::shared_ptr<MeshObject>>> promise;
+	};
+
+	mutable std::mutex			m_Mutex;
+	std::deque<PendingUpload>	m_ReadyUploads;
+	size_t						m_InFlightCount = 0;
+};
@@ -2,67 +2,159 @@
 #include "pch.h"
 #include "MeshObject.h"
 #include "../Analyzer/PMDAnalyzer.h"
+#include "../Analyzer/CookedMeshFormat.h"
 #include "Source/Dx12RenderDevice.h"
+#include "../RHI/DX12UploadBackend.h"
 #include <cstring>
+#include <filesystem>
 #include <d3d12.h>
 #include "d3dx12.h" // ヘッダーをインクルード
 
+namespace
+{
+	// PMD の頂点（PMDVertex）をそのまま転送する場合のレイアウト
+	const D3D12_INPUT_ELEMENT_DESC kPMDInputElements[] =
+	{
+		{ "POSITION",	0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",		0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD",	0, DXGI_FORMAT_R32G32_FLOAT,	0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "BONE_NO",	0, DXGI_FORMAT_R16G16_UINT,		0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "WEIGHT",		0, DXGI_FORMAT_R8_UINT,			0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "EDGE_FLAG",	0, DXGI_FORMAT_R8_UINT,			0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+
+	// クック済みメッシュ（CookedMesh::CookedVertex）のレイアウト
+	// NORMAL は八面体エンコードのため、MeshVertexShader.hlsl の CookedVS でデコードします。
+	const D3D12_INPUT_ELEMENT_DESC kCookedInputElements[] =
+	{
+		{ "POSITION",	0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0,	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL",		0, DXGI_FORMAT_R16G16_SNORM,	0, 12,	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD",	0, DXGI_FORMAT_R16G16_FLOAT,	0, 16,	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "BONE_NO",	0, DXGI_FORMAT_R16G16_UINT,		0, 20,	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "WEIGHT",		0, DXGI_FORMAT_R8G8_UNORM,		0, 24,	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+	};
+}
+
+static_assert(sizeof(PMDVertex) == MeshImport::kPMDVertexStride, "PMDVertex stride mismatch");
+
 MeshObject::MeshObject(string fileName)
 {
-	// PMDAnalyzerを使用して頂点バッファを作成
-	PMDAnalyzer analyzer(fileName);
-	const auto& vertices = analyzer.GetVertices();
-	if (vertices.empty())
+	MeshImport::MeshData data;
+	std::string error;
+	if (!MeshImport::Import(std::filesystem::path(fileName), data, &error))
 	{
+		LOG_DEBUG("MeshObject: %s (%s)\n", error.c_str(), fileName.c_str());
 		return;
 	}
+	if (data.vertexFormat == MeshImport::VertexFormat::PMD)
+	{
+		LOG_DEBUG("MeshObject: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f (%s)\n",
+			data.statsBefore.acmr, data.statsAfter.acmr, data.statsBefore.atvr, data.statsAfter.atvr, fileName.c_str());
+	}
+	CreateFromData(data);
+}
 
-	const auto vertexBufferSize = static_cast<UINT>(sizeof(PMDVertex) * vertices.size());
+MeshObject::MeshObject(const MeshImport::MeshData& data)
+{
+	CreateFromData(data);
+}
 
-	// 頂点バッファの作成
-	auto heapProp = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-	auto resDesc = CD3DX12_RESOURCE_DESC::Buffer(vertexBufferSize);
-	HRESULT hr = Dx12RenderDevice::GetDevice()->CreateCommittedResource(
-		&heapProp,
-		D3D12_HEAP_FLAG_NONE,
-		&resDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&m_pVertexBuffer)
-	);
+///====================================================================
+/// <summary>
+/// 読み込み済みのデータから頂点バッファとインデックスバッファを作成し、
+/// 形式に応じた入力レイアウトを選択します。
+/// </summary>
+///====================================================================
+void MeshObject::CreateFromData(const MeshImport::MeshData& data)
+{
+	if (data.vertices.empty() || data.indices.empty())
+	{
+		return;
+	}
 
-	if (FAILED(hr))
+	const auto vertexBufferSize = static_cast<UINT>(data.vertices.size());
+	const auto indexBufferSize = static_cast<UINT>(sizeof(uint16_t) * data.indices.size());
+	if (!CreateBuffers(data.vertices.data(), vertexBufferSize, data.vertexStride, data.indices.data(), indexBufferSize))
 	{
-		// エラー処理
 		return;
 	}
 
-	// 頂点データをGPUに転送
-	unsigned char* vertexMap = nullptr;
-	hr = m_pVertexBuffer->Map(0, nullptr, reinterpret_cast<void**>(&vertexMap));
-	if (SUCCEEDED(hr))
+	if (data.vertexFormat == MeshImport::VertexFormat::Cooked)
 	{
-		memcpy(vertexMap, vertices.data(), vertexBufferSize);
-		D3D12_RANGE writtenRange = { 0, vertexBufferSize };
-		m_pVertexBuffer->Unmap(0, &writtenRange);
+		m_pInputElements = kCookedInputElements;
+		m_InputElementCount = _countof(kCookedInputElements);
+		m_pVertexShaderEntryPoint = "CookedVS";
 	}
 	else
 	{
-		return;
+		m_pInputElements = kPMDInputElements;
+		m_InputElementCount = _countof(kPMDInputElements);
+		m_pVertexShaderEntryPoint = "PMDVS";
 	}
 
-	// 頂点バッファビューの設定
-	D3D12_INPUT_ELEMENT_DESC inputElementDescs[] =
+	// マテリアルごとの描画範囲
+	m_Subsets.resize(data.subsets.size());
+	for (size_t i = 0; i < data.subsets.size(); ++i)
 	{
-		{ "POSITION",	0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "NORMAL",		0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD",	0, DXGI_FORMAT_R32G32_FLOAT,	0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "BONE_NO",	0, DXGI_FORMAT_R16G16_UINT,		0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "WEIGHT",		0, DXGI_FORMAT_R8_UINT,			0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "EDGE_FLAG",	0, DXGI_FORMAT_R8_UINT,			0, D3D12_APPEND_ALIGNED_ELEMENT, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
+		m_Subsets[i].indexOffset = data.subsets[i].indexOffset;
+		m_Subsets[i].indexCount = data.subsets[i].indexCount;
+	}
+}
+
+bool MeshObject::CreateBuffers(const void* vertexData, UINT vertexBufferSize, UINT vertexStride, const void* indexData, UINT indexBufferSize)
+{
+	// 頂点データとインデックスデータを GPU に転送（転送キューがあれば DEFAULT ヒープに置く）
+	ID3D12Device* device = Dx12RenderDevice::GetDevice();
+	GpuUploadQueue* uploadQueue = Dx12RenderDevice::GetUploadQueue();
+	if (FAILED(CreateStaticBuffer(device, uploadQueue, vertexData, vertexBufferSize, m_pVertexBuffer, &m_IsDefaultHeap)))
+	{
+		return false;
+	}
+	if (FAILED(CreateStaticBuffer(device, uploadQueue, indexData, indexBufferSize, m_pIndexBuffer)))
+	{
+		m_pVertexBuffer.Reset();
+		return false;
+	}
+	m_VertexAllocation = TrackD3D12Resource(device, m_pVertexBuffer.Get(), ResourceCategory::VertexBuffer, "MeshObject");
+	m_IndexAllocation = TrackD3D12Resource(device, m_pIndexBuffer.Get(), ResourceCategory::IndexBuffer, "MeshObject");
 
 	m_VertexBufferView.BufferLocation = m_pVertexBuffer->GetGPUVirtualAddress();
 	m_VertexBufferView.SizeInBytes = vertexBufferSize;
-	m_VertexBufferView.StrideInBytes = sizeof(PMDVertex);
+	m_VertexBufferView.StrideInBytes = vertexStride;
+
+	m_IndexBufferView.BufferLocation = m_pIndexBuffer->GetGPUVirtualAddress();
+	m_IndexBufferView.SizeInBytes = indexBufferSize;
+	m_IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
+	return true;
+}
+
+bool MeshObject::UpdateVertices(const void* vertexData, UINT firstVertex, UINT vertexCount)
+{
+	const UINT stride = m_VertexBufferView.StrideInBytes;
+	if (m_pVertexBuffer == nullptr || vertexCount == 0 ||
+		static_cast<UINT64>(firstVertex) + vertexCount > m_VertexBufferView.SizeInBytes / stride)
+	{
+		return false;
+	}
+
+	const SIZE_T begin = static_cast<SIZE_T>(firstVertex) * stride;
+	const SIZE_T size = static_cast<SIZE_T>(vertexCount) * stride;
+	if (m_IsDefaultHeap)
+	{
+		// コピーキューで転送する（描画前にグラフィックスキューが完了を待つ）
+		GpuUploadQueue* uploadQueue = Dx12RenderDevice::GetUploadQueue();
+		return uploadQueue != nullptr && uploadQueue->UploadBuffer(m_pVertexBuffer.Get(), begin, vertexData, size);
+	}
+
+	// UPLOAD ヒープなので CPU から直接書き換え、書き込んだ範囲だけを通知する
+	unsigned char* mapped = nullptr;
+	const D3D12_RANGE readRange = { 0, 0 };
+	if (FAILED(m_pVertexBuffer->Map(0, &readRange, reinterpret_cast<void**>(&mapped))))
+	{
+		return false;
+	}
+	memcpy(mapped + begin, vertexData, size);
+	const D3D12_RANGE writtenRange = { begin, begin + size };
+	m_pVertexBuffer->Unmap(0, &writtenRange);
+	return true;
 }
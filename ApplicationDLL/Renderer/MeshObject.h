@@ -2,20 +2,80 @@
 #include "pch.h"
 #include <string>
 #include <cstdint>
+#include <vector>
 #include "../Math/MathUtil.h"
+#include "../Analyzer/MeshImport.h"
+#include "../System/ResourceAccounting.h"
 
 using namespace std;
 using namespace WL;
 using Microsoft::WRL::ComPtr;
 
+/// マテリアル 1 つ分の描画範囲
+struct MeshSubset
+{
+	UINT indexOffset = 0;
+	UINT indexCount = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// PMD またはクック済みメッシュ（.pmdc）から作成するメッシュ。
+/// 拡張子が .pmdc の場合はマップしたファイルから直接バッファを作成します。
+/// 頂点レイアウトは読み込んだ形式によって異なるため GetInputElements で取得し、
+/// 頂点シェーダーは kVertexShaderFile の GetVertexShaderEntryPoint を組み合わせます。
+/// 読み込みを待ちたくない場合は MeshImporter で非同期に作成します。
+/// バッファは転送キュー経由で DEFAULT ヒープ（VRAM）に置きます。
+/// </summary>
+///=======================================================================
 class MeshObject
 {
 public:
+	/// 両方の頂点形式の入口を持つ頂点シェーダー
+	static constexpr const wchar_t* kVertexShaderFile = L"MeshVertexShader.hlsl";
+
+	/// ファイルを同期的に読み込んでバッファを作成します。
 	MeshObject(string fileName);
+	/// 読み込み済みのデータからバッファを作成します（描画スレッドから呼び出すこと）。
+	explicit MeshObject(const MeshImport::MeshData& data);
+
+	/// バッファの作成に成功しているか
+	bool IsValid() const { return m_pVertexBuffer != nullptr; }
+
+	const D3D12_INPUT_ELEMENT_DESC* GetInputElements() const { return m_pInputElements; }
+	UINT GetInputElementCount() const { return m_InputElementCount; }
+	/// 入力レイアウトに合う入口（クック済みは法線の八面体エンコードを戻す CookedVS）
+	const char* GetVertexShaderEntryPoint() const { return m_pVertexShaderEntryPoint; }
+
+	const D3D12_VERTEX_BUFFER_VIEW& GetVertexBufferView() const { return m_VertexBufferView; }
+	const D3D12_INDEX_BUFFER_VIEW& GetIndexBufferView() const { return m_IndexBufferView; }
+	const std::vector<MeshSubset>& GetSubsets() const { return m_Subsets; }
+
+	///====================================================================
+	/// <summary>
+	/// 頂点バッファの一部だけを書き換えます（表情の合成結果など）。
+	/// GPU の読み取りが終わった後（Render の後、次の描画の記録前）に呼び出すこと。
+	/// </summary>
+	/// <param name="vertexData">firstVertex 番目の頂点から vertexCount 個分のデータ</param>
+	/// <returns>範囲外の場合や Map に失敗した場合は false</returns>
+	///====================================================================
+	bool UpdateVertices(const void* vertexData, UINT firstVertex, UINT vertexCount);
 
 private:
+	void CreateFromData(const MeshImport::MeshData& data);
+	bool CreateBuffers(const void* vertexData, UINT vertexBufferSize, UINT vertexStride, const void* indexData, UINT indexBufferSize);
+
 	ComPtr<ID3D12Resource>	m_pVertexBuffer;
+	ComPtr<ID3D12Resource>	m_pIndexBuffer;
+	bool					m_IsDefaultHeap = false;	// 頂点バッファが DEFAULT ヒープにあるか
+	ResourceAccounting::TrackedAllocation	m_VertexAllocation;
+	ResourceAccounting::TrackedAllocation	m_IndexAllocation;
 
 	D3D12_VERTEX_BUFFER_VIEW	m_VertexBufferView = {};
+	D3D12_INDEX_BUFFER_VIEW		m_IndexBufferView = {};
+	std::vector<MeshSubset>		m_Subsets;
+	const D3D12_INPUT_ELEMENT_DESC*	m_pInputElements = nullptr;
+	UINT							m_InputElementCount = 0;
+	const char*						m_pVertexShaderEntryPoint = nullptr;
 };
 
@@ -85,6 +85,7 @@ size_t PipelineLibrary::PipelineDescHasher::operator()(const GraphicsPipelineDes
             HashCombine(seed, std::hash<UINT>{}(param.registerSpace));
             HashCombine(seed, std::hash<UINT>{}(param.cbvShaderRegister));
             HashCombine(seed, std::hash<UINT>{}(param.cbvRegisterSpace));
+            HashCombine(seed, std::hash<UINT>{}(param.num32BitValues));
         }
         for (const auto& sampler : root.staticSamplers)
         {
@@ -3,9 +3,13 @@
 #include "AppRuntime.h"
 #include "Source/Dx12RenderDevice.h"
 #include <algorithm>
+#include <cmath>
 #include <sstream>
 #include <string>
 #include "../RHI/DX12FrameConstantBuffer.h"
+#include "../RHI/FrameConstantsManager.h"
+#include "../RHI/DescriptorHeapManager.h"
+#include "../RHI/DX12UploadBackend.h"
 
 namespace
 {
@@ -90,17 +94,38 @@ void QuadRenderObject::SetTransform(float centerX, float centerY, float width, f
 ///=========================================================================================
 /// <summary>
 /// テクスチャハンドルを受け取り、テクスチャアセットマネージャーからテクスチャリソースを取得して、マテリアルに設定します。
+/// 読み込み中の場合はプレースホルダーを設定し、読み込みが終わったら Render で差し替えます。
 /// </summary>
 /// <param name="textureHandle"></param>
 ///=========================================================================================
 void QuadRenderObject::SetTextureHandle(TextureHandle textureHandle)
 {
-	textureAsset_ = TextureAssetManager::Get().GetTexture(textureHandle);
-	if (textureAsset_ == nullptr)
+	textureHandle_ = textureHandle;
+	RefreshTexture();
+}
+
+///=========================================================================================
+/// <summary>
+/// 現在のハンドルのテクスチャ（読み込み中はプレースホルダー）をマテリアルに設定します。
+/// アトラスに入っている場合はページが返るので、UV の範囲も合わせて取得します。
+/// </summary>
+///=========================================================================================
+void QuadRenderObject::RefreshTexture()
+{
+	// 毎フレーム呼ばれるので、参照カウントを増やさずに確かめ、変わったときだけ取得し直す
+	TextureAssetManager& manager = TextureAssetManager::Get();
+	const RHITexture* current = manager.PeekTexture(textureHandle_, nullptr, &textureRegion_);
+	if (current == nullptr || current == textureAsset_.get())
 	{
 		return;
 	}
 
+	std::shared_ptr<RHITexture> texture = manager.GetTexture(textureHandle_, nullptr, &textureRegion_);
+	if (texture == nullptr)
+	{
+		return;
+	}
+	textureAsset_ = std::move(texture);
 	m_material.SetTexture(textureAsset_.get());
 }
 
@@ -127,6 +152,7 @@ void QuadRenderObject::SetMaterialName(const std::string& materialName)
 ///=========================================================================================
 /// <summary>
 /// m_quadTransformの中心座標と幅・高さに基づいて、四角形の4頂点の位置とUV座標をm_Verticesに設定するメンバ関数。
+/// UV はテクスチャの範囲（アトラスならページ内のスプライトの範囲）に合わせます。
 /// </summary>
 ///=========================================================================================
 void QuadRenderObject::ApplyQuadTransform(ViewportRenderMode viewportMode)
@@ -153,10 +179,11 @@ void QuadRenderObject::ApplyQuadTransform(ViewportRenderMode viewportMode)
 	const float bottom = transformedCenterY - halfHeight;
 	const float top = transformedCenterY + halfHeight;
 
-	m_Vertices[0] = { { left, bottom, 0.0f }, { 0.0f, 1.0f } };
-	m_Vertices[1] = { { left, top, 0.0f }, { 0.0f, 0.0f } };
-	m_Vertices[2] = { { right, bottom, 0.0f }, { 1.0f, 1.0f } };
-	m_Vertices[3] = { { right, top, 0.0f }, { 1.0f, 0.0f } };
+	const TextureRegion& uv = textureRegion_;
+	m_Vertices[0] = { { left, bottom, 0.0f }, { uv.u0, uv.v1 } };
+	m_Vertices[1] = { { left, top, 0.0f }, { uv.u0, uv.v0 } };
+	m_Vertices[2] = { { right, bottom, 0.0f }, { uv.u1, uv.v1 } };
+	m_Vertices[3] = { { right, top, 0.0f }, { uv.u1, uv.v0 } };
 }
 
 void QuadRenderObject::UploadVertexBufferData()
@@ -206,6 +233,7 @@ HRESULT QuadRenderObject::CreateVertexBuffer(const D3D12_HEAP_PROPERTIES& heapPr
 			static_cast<unsigned int>(removedReason));
 		return hr;
 	}
+	m_VertexAllocation = TrackD3D12Resource(device, m_pVertexBuffer.Get(), ResourceCategory::VertexBuffer, "QuadRenderObject", sizeof(m_Vertices));
 
 	Vertex* vertexMap = nullptr;
 	hr = m_pVertexBuffer->Map(0, nullptr, reinterpret_cast<void**>(&vertexMap));
@@ -228,13 +256,12 @@ HRESULT QuadRenderObject::CreateVertexBuffer(const D3D12_HEAP_PROPERTIES& heapPr
 
 ///==========================================================================================
 /// <summary>
-/// インデックスバッファ用のコミット済みGPUリソースを作成し、クラス内のインデックスデータを転送してインデックスバッファビューを設定します。
+/// インデックスバッファを作成し、クラス内のインデックスデータを転送してインデックスバッファビューを設定します。
+/// 内容は変わらないため、転送キューがあれば DEFAULT ヒープに置きます。
 /// </summary>
-/// <param name="heapProps"></param>
-/// <param name="resourceDesc"></param>
 /// <returns></returns>
 ///==========================================================================================
-HRESULT QuadRenderObject::CreateIndexBuffer(const D3D12_HEAP_PROPERTIES& heapProps, const D3D12_RESOURCE_DESC& resourceDesc)
+HRESULT QuadRenderObject::CreateIndexBuffer()
 {
 	ID3D12Device* device = Dx12RenderDevice::GetDevice();
 	if (device == nullptr)
@@ -242,23 +269,6 @@ HRESULT QuadRenderObject::CreateIndexBuffer(const D3D12_HEAP_PROPERTIES& heapPro
 		return E_POINTER;
 	}
 
-	HRESULT hr = device->CreateCommittedResource(
-		&heapProps,
-		D3D12_HEAP_FLAG_NONE,
-		&resourceDesc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr,
-		IID_PPV_ARGS(&m_pIndexBuffer)
-	);
-
-	if (!SUCCEEDED(hr)) {
-		const HRESULT removedReason = Dx12RenderDevice::GetDeviceRemovedReason();
-		LOG_DEBUG("CreateIndexBuffer: CreateCommittedResource failed. hr=0x%08X removed=0x%08X",
-			static_cast<unsigned int>(hr),
-			static_cast<unsigned int>(removedReason));
-		return hr;
-	}
-
 	unsigned short indices[] = {
 	0, 1, 2,
 	2, 1, 3
@@ -266,15 +276,17 @@ HRESULT QuadRenderObject::CreateIndexBuffer(const D3D12_HEAP_PROPERTIES& heapPro
 
 	m_Indices = std::vector<short>(std::begin(indices), std::end(indices));
 
-	unsigned short* indexMap = nullptr;
-	hr = m_pIndexBuffer->Map(0, nullptr, reinterpret_cast<void**>(&indexMap));
+	const HRESULT hr = CreateStaticBuffer(device, Dx12RenderDevice::GetUploadQueue(),
+		m_Indices.data(), sizeof(m_Indices[0]) * m_Indices.size(), m_pIndexBuffer);
 	if (!SUCCEEDED(hr)) {
-		LOG_DEBUG("CreateIndexBuffer: Map failed. hr=0x%08X", static_cast<unsigned int>(hr));
+		const HRESULT removedReason = Dx12RenderDevice::GetDeviceRemovedReason();
+		LOG_DEBUG("CreateIndexBuffer: CreateStaticBuffer failed. hr=0x%08X removed=0x%08X",
+			static_cast<unsigned int>(hr),
+			static_cast<unsigned int>(removedReason));
 		return hr;
 	}
 
-	std::copy(std::begin(m_Indices), std::end(m_Indices), indexMap);
-	m_pIndexBuffer->Unmap(0, nullptr);
+	m_IndexAllocation = TrackD3D12Resource(device, m_pIndexBuffer.Get(), ResourceCategory::IndexBuffer, "QuadRenderObject");
 
 	m_IndexBufferView.BufferLocation = m_pIndexBuffer->GetGPUVirtualAddress();
 	m_IndexBufferView.Format = DXGI_FORMAT_R16_UINT;
@@ -316,7 +328,7 @@ HRESULT QuadRenderObject::CreateMeshResources()
 		return vertexHr;
 	}
 
-	const HRESULT indexHr = CreateIndexBuffer(heapProps, resourceDesc);
+	const HRESULT indexHr = CreateIndexBuffer();
 	if (FAILED(indexHr))
 	{
 		return indexHr;
@@ -333,11 +345,22 @@ HRESULT QuadRenderObject::CreateMeshResources()
 //=========================================================================================
 /// <summary>
 /// マテリアルの初期化を行います。
+/// 対応していればバインドレスのマテリアルを使い、描画ごとのテーブルの収集を省きます。
 /// </summary>
 /// <returns></returns>
 //=========================================================================================
 HRESULT QuadRenderObject::InitializeMaterial()
 {
+	if (DescriptorHeapManager::Get().IsBindlessSupported())
+	{
+		const HRESULT bindlessHr = m_material.Initialize(Dx12RenderDevice::GetDevice(), GetPipelineLibrary(), Material::CreateBuiltInBindlessTexturedQuadDesc());
+		if (SUCCEEDED(bindlessHr))
+		{
+			return bindlessHr;
+		}
+		LOG_DEBUG("InitializeMaterial: bindless material failed, falling back to descriptor tables. hr=0x%08X", static_cast<unsigned int>(bindlessHr));
+	}
+
 	Material::MaterialDesc materialDesc = Material::CreateBuiltInTexturedQuadDesc();
 	auto hr = m_material.Initialize(Dx12RenderDevice::GetDevice(),GetPipelineLibrary(),	materialDesc);
 	if (FAILED(hr))
@@ -357,10 +380,20 @@ void QuadRenderObject::Render(ViewportRenderMode viewportMode)
 {
 	m_Angle += 0.1f;
 	m_WorldMatrix = DirectX::XMMatrixRotationY(m_Angle);
+	// 行列はフレームごとに別の場所へ書かれるので、アドレスを取り直す
 	m_FrameConstantBuffer.Update(m_WorldMatrix * m_ViewMatrix * m_ProjectionMatrix);
+	m_material.SetConstantBuffer(m_FrameConstantBuffer.GetGPUVirtualAddress());
 
 
+	// 読み込みの完了や常駐するミップの変更でテクスチャが差し替わるので、毎フレーム取得し直す
+	RefreshTexture();
+
 	ApplyQuadTransform(viewportMode);
+
+	// 画面上の大きさ（ピクセル）を報告し、それに見合うミップだけを常駐させる
+	const float screenWidth = (m_Vertices[2].pos.x - m_Vertices[0].pos.x) * 0.5f * static_cast<float>(Application::GetWindowWidth());
+	const float screenHeight = (m_Vertices[1].pos.y - m_Vertices[0].pos.y) * 0.5f * static_cast<float>(Application::GetWindowHeight());
+	TextureAssetManager::Get().ReportTextureUsage(textureHandle_, std::abs(screenWidth), std::abs(screenHeight));
 	UploadVertexBufferData();
 	m_isVertexDirty = false;
 
@@ -370,6 +403,18 @@ void QuadRenderObject::Render(ViewportRenderMode viewportMode)
 		return;
 	}
 
+	// 定数の領域が取れなければ（ページを使い切った、初期化前）、ルートの CBV が空のまま描くことになるので描かない
+	if (!m_FrameConstantBuffer.IsValid())
+	{
+		if (!m_IsConstantsFailureLogged)
+		{
+			LOG_DEBUG("QuadRenderObject::Render: no frame constants available, skipping the draw. %s",
+				FrameConstantsManager::Get().FormatReport().c_str());
+			m_IsConstantsFailureLogged = true;
+		}
+		return;
+	}
+
 	// マテリアルをコマンドリストにバインドして、描画コマンドを発行します。
 	m_material.Bind(commandList);
 
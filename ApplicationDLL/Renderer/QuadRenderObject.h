@@ -5,6 +5,7 @@
 #include "Source/PipelineLibrary.h"
 #include "DX12Texture.h"
 #include "../RHI/DX12FrameConstantBuffer.h"
+#include "../System/ResourceAccounting.h"
 #include <d3d12.h>
 
 #include <memory>
@@ -52,12 +53,13 @@ public:
 private:
 
 	HRESULT CreateVertexBuffer(const D3D12_HEAP_PROPERTIES& heapProps, const D3D12_RESOURCE_DESC& resourceDesc);
-	HRESULT CreateIndexBuffer(const D3D12_HEAP_PROPERTIES& heapProps, const D3D12_RESOURCE_DESC& resourceDesc);
+	HRESULT CreateIndexBuffer();
 	HRESULT CreateMeshResources();
 	HRESULT InitializeMaterial();
 
 	void ApplyQuadTransform(ViewportRenderMode viewportMode);
 	void UploadVertexBufferData();
+	void RefreshTexture();
 
 
 	struct QuadTransform
@@ -80,8 +82,12 @@ private:
 	ComPtr<ID3D12Resource>		m_pImageTextureBuffer;
 	D3D12_VERTEX_BUFFER_VIEW	m_VertexBufferView = {};
 	D3D12_INDEX_BUFFER_VIEW		m_IndexBufferView = {};
+	ResourceAccounting::TrackedAllocation	m_VertexAllocation;
+	ResourceAccounting::TrackedAllocation	m_IndexAllocation;
 
 	DX12FrameConstantBuffer		m_FrameConstantBuffer;
+	/// 定数の領域が取れずに描画を飛ばしたことを報告したか（ログは 1 回だけ）
+	bool						m_IsConstantsFailureLogged = false;
 
 	Matrix m_WorldMatrix = DirectX::XMMatrixIdentity();
 	Matrix m_ViewMatrix = DirectX::XMMatrixIdentity();
@@ -90,7 +96,9 @@ private:
 
 	std::vector<short> m_Indices;
 
-	std::shared_ptr<DX12Texture> textureAsset_;
+	std::shared_ptr<RHITexture> textureAsset_;
+	TextureHandle textureHandle_ = 0;
+	TextureRegion textureRegion_;	// テクスチャ内の UV の範囲（アトラスのページなら一部）
 	std::string materialName_ = "BuiltInMaterials::UnlitTexture";
 };
 
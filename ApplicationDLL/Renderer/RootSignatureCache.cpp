@@ -31,7 +31,8 @@ bool RootSignatureCache::RootSignatureParameter::operator==(const RootSignatureP
         baseShaderRegister == other.baseShaderRegister &&
         registerSpace == other.registerSpace &&
         cbvShaderRegister == other.cbvShaderRegister &&
-        cbvRegisterSpace == other.cbvRegisterSpace;
+        cbvRegisterSpace == other.cbvRegisterSpace &&
+        num32BitValues == other.num32BitValues;
 }
 
 bool RootSignatureCache::StaticSamplerDesc::operator==(const RootSignatureCache::StaticSamplerDesc& other) const
@@ -72,6 +73,7 @@ size_t RootSignatureCache::RootSignatureDescHasher::operator()(const RootSignatu
         HashCombine(seed, std::hash<UINT>{}(root.registerSpace));
         HashCombine(seed, std::hash<UINT>{}(root.cbvShaderRegister));
         HashCombine(seed, std::hash<UINT>{}(root.cbvRegisterSpace));
+        HashCombine(seed, std::hash<UINT>{}(root.num32BitValues));
     }
 
     for (const auto& sampler : desc.staticSamplers)
@@ -123,6 +125,7 @@ bool RootSignatureCache::GetOrCreate(
     // ルートパラメータの構築。DescriptorTableSrv タイプのパラメータは D3D12_DESCRIPTOR_RANGE を使用して記述され、
     // RootParameter の DescriptorTable メンバに関連付けられます。
     // CBV タイプのパラメータは RootParameter の Descriptor メンバを直接使用して記述されます。
+    // Constants タイプのパラメータは RootParameter の Constants メンバに値の数とレジスタを記述します。
     std::vector<D3D12_DESCRIPTOR_RANGE> descriptorRanges;
     descriptorRanges.reserve(desc.rootSignatureParameters.size());
     std::vector<D3D12_ROOT_PARAMETER> rootParameters(desc.rootSignatureParameters.size());
@@ -137,6 +140,7 @@ bool RootSignatureCache::GetOrCreate(
         {
             D3D12_DESCRIPTOR_RANGE range = {};
             range.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+            // UnboundedDescriptorCount (UINT_MAX) はそのまま渡すと大きさを決めない範囲になる
             range.NumDescriptors = source.numDescriptors;
             range.BaseShaderRegister = source.baseShaderRegister;
             range.RegisterSpace = source.registerSpace;
@@ -147,6 +151,14 @@ bool RootSignatureCache::GetOrCreate(
             target.DescriptorTable.NumDescriptorRanges = 1;
             target.DescriptorTable.pDescriptorRanges = &descriptorRanges.back();
         }
+        else if (source.type == RootParameterType::Constants)
+        {
+            // ルート定数の設定
+            target.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+            target.Constants.ShaderRegister = source.cbvShaderRegister;
+            target.Constants.RegisterSpace = source.cbvRegisterSpace;
+            target.Constants.Num32BitValues = source.num32BitValues;
+        }
         else
         {
             // 定数バッファビューのディスクリプタ設定
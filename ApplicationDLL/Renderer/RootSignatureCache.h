@@ -9,9 +9,14 @@ public:
     enum class RootParameterType : unsigned int
     {
         DescriptorTableSrv,
-        ConstantBufferView
+        ConstantBufferView,
+        /// シェーダーからは cbuffer に見える 32 ビット値（バインドレスのインデックスなど）
+        Constants
     };
 
+    /// numDescriptors に渡すと範囲の大きさを決めないテーブルになります（ヒープ全体を配列として見る）。
+    constexpr static UINT UnboundedDescriptorCount = UINT_MAX;
+
     struct RootSignatureParameter
     {
         RootParameterType type = RootParameterType::DescriptorTableSrv;
@@ -23,6 +28,8 @@ public:
         // CBV parameters.
         UINT cbvShaderRegister = 0;
         UINT cbvRegisterSpace = 0;
+        // Root-constant parameters (registers come from cbvShaderRegister / cbvRegisterSpace).
+        UINT num32BitValues = 0;
 
         bool operator==(const RootSignatureParameter& other) const;
 	};
@@ -0,0 +1,18 @@
+#include "BasicShaderHeader.hlsli"
+
+// シェーダーから見えるヒープ全体を 1 つの配列として見る（要素の番号はヒープでのインデックス）
+Texture2D<float4> g_textures[] : register(t0, space1);
+SamplerState g_sampler0 : register(s0);
+
+// 描画ごとにルート定数で渡されるテクスチャーのインデックス
+cbuffer BindlessDrawConstants : register(b1)
+{
+    uint g_textureIndex0;
+};
+
+
+float4 BindlessPS(Output input) : SV_TARGET
+{
+    // インデックスは描画の中で変わらないので NonUniformResourceIndex は要らない
+    return g_textures[g_textureIndex0].Sample(g_sampler0, input.uv);
+}
@@ -0,0 +1,21 @@
+// メッシュの頂点シェーダーからピクセルシェーダーへ渡す値
+struct MeshOutput
+{
+    float4 svpos : SV_Position;
+    float2 uv : TEXCOORD;
+    float3 normal : NORMAL;
+};
+
+// MeshCooker::EncodeOctahedralNormal の逆変換（MeshCooker::DecodeOctahedralNormal と同じ手順）。
+// R16G16_SNORM は入力アセンブラーで [-1, 1] に戻る（-32768 も -1 になる）
+float3 DecodeOctahedralNormal(float2 encoded)
+{
+    float3 normal = float3(encoded, 1.0f - abs(encoded.x) - abs(encoded.y));
+    if (normal.z < 0.0f)
+    {
+        // 下半球は対角線で折り返してある。符号は 0 を正として扱う
+        const float2 signNotZero = (encoded >= 0.0f) ? 1.0f : -1.0f;
+        normal.xy = (1.0f - abs(encoded.yx)) * signNotZero;
+    }
+    return normalize(normal);
+}
@@ -0,0 +1,28 @@
+#include "MeshShaderHeader.hlsli"
+
+cbuffer MeshConstants : register(b0)
+{
+    matrix world;
+    matrix viewproj;
+};
+
+MeshOutput TransformVertex(float3 position, float3 normal, float2 uv)
+{
+    MeshOutput output;
+    output.svpos = mul(viewproj, mul(world, float4(position, 1.0f)));
+    output.uv = uv;
+    output.normal = normalize(mul((float3x3)world, normal));
+    return output;
+}
+
+// PMD の頂点をそのまま転送した場合（MeshObject の kPMDInputElements）
+MeshOutput PMDVS(float3 position : POSITION, float3 normal : NORMAL, float2 uv : TEXCOORD)
+{
+    return TransformVertex(position, normal, uv);
+}
+
+// クック済みメッシュ（kCookedInputElements）。NORMAL は八面体エンコード、TEXCOORD は half
+MeshOutput CookedVS(float3 position : POSITION, float2 encodedNormal : NORMAL, float2 uv : TEXCOORD)
+{
+    return TransformVertex(position, DecodeOctahedralNormal(encodedNormal), uv);
+}
@@ -0,0 +1,12 @@
+#include "SpriteBatchShaderHeader.hlsli"
+
+// シェーダーから見えるヒープ全体を 1 つの配列として見る（要素の番号はヒープでのインデックス）
+Texture2D<float4> g_textures[] : register(t0, space1);
+SamplerState g_sampler0 : register(s0);
+
+
+float4 SpriteBatchPS(SpriteOutput input) : SV_TARGET
+{
+    // 1 回の描画の中でスプライトごとにテクスチャーが変わるので NonUniformResourceIndex が要る
+    return g_textures[NonUniformResourceIndex(input.textureIndex)].Sample(g_sampler0, input.uv) * input.color;
+}
@@ -0,0 +1,9 @@
+// スプライトのバッチの頂点シェーダーからピクセルシェーダーへ渡す値
+struct SpriteOutput
+{
+    float4 svpos : SV_Position;
+    float2 uv : TEXCOORD;
+    float4 color : COLOR;
+    // シェーダーから見えるヒープでのインデックス
+    nointerpolation uint textureIndex : TEXTURE_INDEX;
+};
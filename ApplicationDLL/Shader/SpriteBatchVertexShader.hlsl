@@ -0,0 +1,20 @@
+#include "SpriteBatchShaderHeader.hlsli"
+
+// スロット 0 は共通の単位四角形（-0.5 から 0.5）、スロット 1 はスプライトごとの値（SpriteInstance）
+SpriteOutput SpriteBatchVS(
+    float2 corner : POSITION,
+    float4 rect : SPRITE_RECT,
+    float4 uvRect : SPRITE_UV,
+    uint textureIndex : SPRITE_TEXTURE,
+    float4 color : COLOR)
+{
+    SpriteOutput output;
+    // rect は NDC の中心と大きさ
+    output.svpos = float4(rect.xy + corner * rect.zw, 0.0f, 1.0f);
+    // uvRect は (u0, v0, u1, v1)。v0 が上端
+    const float2 t = corner + 0.5f;
+    output.uv = float2(lerp(uvRect.x, uvRect.z, t.x), lerp(uvRect.w, uvRect.y, t.y));
+    output.color = color;
+    output.textureIndex = textureIndex;
+    return output;
+}
@@ -0,0 +1,265 @@
+#include "pch.h"
+#include "Dx12SpriteBatchRenderer.h"
+
+#include "Source/Dx12RenderDevice.h"
+#include "../RHI/DescriptorHeapManager.h"
+#include "../RHI/DX12Texture.h"
+#include "../RHI/DX12UploadBackend.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+constexpr const char* kBuiltInSpriteMaterialName = "BuiltInMaterials::UnlitTexture";
+
+struct UnitQuadVertex
+{
+    float x;
+    float y;
+};
+}
+
+Dx12SpriteBatchRenderer& Dx12SpriteBatchRenderer::Get()
+{
+    static Dx12SpriteBatchRenderer instance;
+    return instance;
+}
+
+bool Dx12SpriteBatchRenderer::IsAvailable()
+{
+    if (!isInitialized_ && !isInitializeFailed_)
+    {
+        // デバイスが無い間（作成前や作り直しの途中）は失敗として覚えず、次の呼び出しでもう一度試す
+        if (Dx12RenderDevice::GetDevice() == nullptr)
+        {
+            return false;
+        }
+        isInitialized_ = Initialize();
+        isInitializeFailed_ = !isInitialized_;
+    }
+    return isInitialized_;
+}
+
+///=========================================================================================
+/// <summary>
+/// 単位四角形・マテリアル・最初のページを作ります。
+/// インスタンスごとにテクスチャーを変えるにはバインドレスが要るので、対応していなければ作りません。
+/// </summary>
+///=========================================================================================
+bool Dx12SpriteBatchRenderer::Initialize()
+{
+    ID3D12Device* device = Dx12RenderDevice::GetDevice();
+    if (device == nullptr || !DescriptorHeapManager::Get().IsBindlessSupported())
+    {
+        return false;
+    }
+
+    const HRESULT quadHr = CreateUnitQuad(device);
+    if (FAILED(quadHr))
+    {
+        LOG_DEBUG("Dx12SpriteBatchRenderer: failed to create the unit quad. hr=0x%08X", static_cast<unsigned int>(quadHr));
+        Reset();
+        return false;
+    }
+
+    MaterialEntry entry;
+    entry.name = kBuiltInSpriteMaterialName;
+    const HRESULT materialHr = entry.material.Initialize(device, pipelineLibrary_, Material::CreateBuiltInSpriteBatchDesc());
+    if (FAILED(materialHr))
+    {
+        LOG_DEBUG("Dx12SpriteBatchRenderer: failed to create the sprite material. hr=0x%08X", static_cast<unsigned int>(materialHr));
+        Reset();
+        return false;
+    }
+    materials_.push_back(std::move(entry));
+
+    FrameLinearAllocatorDesc desc;
+    desc.pageSize = PageSize;
+    desc.maxPagesPerFrame = MaxPagesPerFrame;
+    desc.frameCount = FrameCount;
+    // 頂点バッファビューの先頭は 4 バイトの境界でよいが、インスタンスの大きさに合わせて揃える
+    desc.alignment = 16;
+    if (!instancePages_.Initialize(device, desc, ResourceCategory::VertexBuffer, "Dx12SpriteBatchRenderer"))
+    {
+        Reset();
+        return false;
+    }
+    return true;
+}
+
+HRESULT Dx12SpriteBatchRenderer::CreateUnitQuad(ID3D12Device* device)
+{
+    // 並びは QuadRenderObject と同じ（左下、左上、右下、右上）
+    const UnitQuadVertex vertices[] = {
+        { -0.5f, -0.5f },
+        { -0.5f, 0.5f },
+        { 0.5f, -0.5f },
+        { 0.5f, 0.5f }
+    };
+    const uint16_t indices[] = {
+        0, 1, 2,
+        2, 1, 3
+    };
+
+    HRESULT hr = CreateStaticBuffer(device, Dx12RenderDevice::GetUploadQueue(), vertices, sizeof(vertices), vertexBuffer_);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    vertexAllocation_ = TrackD3D12Resource(device, vertexBuffer_.Get(), ResourceCategory::VertexBuffer, "Dx12SpriteBatchRenderer");
+    vertexBufferView_.BufferLocation = vertexBuffer_->GetGPUVirtualAddress();
+    vertexBufferView_.SizeInBytes = sizeof(vertices);
+    vertexBufferView_.StrideInBytes = sizeof(vertices[0]);
+
+    hr = CreateStaticBuffer(device, Dx12RenderDevice::GetUploadQueue(), indices, sizeof(indices), indexBuffer_);
+    if (FAILED(hr))
+    {
+        return hr;
+    }
+    indexAllocation_ = TrackD3D12Resource(device, indexBuffer_.Get(), ResourceCategory::IndexBuffer, "Dx12SpriteBatchRenderer");
+    indexBufferView_.BufferLocation = indexBuffer_->GetGPUVirtualAddress();
+    indexBufferView_.Format = DXGI_FORMAT_R16_UINT;
+    indexBufferView_.SizeInBytes = sizeof(indices);
+    return S_OK;
+}
+
+void Dx12SpriteBatchRenderer::Reset()
+{
+    batch_.Clear();
+    instancePages_.Reset();
+    materials_.clear();
+    pipelineLibrary_.Clear();
+    vertexBuffer_.Reset();
+    indexBuffer_.Reset();
+    vertexBufferView_ = {};
+    indexBufferView_ = {};
+    vertexAllocation_.Reset();
+    indexAllocation_.Reset();
+    // 次のデバイスでは作り直す
+    isInitialized_ = false;
+    isInitializeFailed_ = false;
+}
+
+void Dx12SpriteBatchRenderer::BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue)
+{
+    instancePages_.BeginFrame(frameFenceValue, completedFenceValue);
+}
+
+uint32_t Dx12SpriteBatchRenderer::FindMaterialId(const std::string& materialName) const
+{
+    for (size_t i = 0; i < materials_.size(); ++i)
+    {
+        if (materials_[i].name == materialName)
+        {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return UINT32_MAX;
+}
+
+void Dx12SpriteBatchRenderer::Submit(uint32_t materialId, const RHITexture* texture, SpriteInstance instance)
+{
+    if (!IsAvailable() || materialId >= materials_.size() || texture == nullptr)
+    {
+        return;
+    }
+
+    // 並べ替えのキーにもヒープでのインデックスを使う（同じテクスチャーが続くとキャッシュに乗りやすい）
+    const UINT textureIndex = static_cast<const DX12Texture*>(texture)->GetBindlessDescriptorIndex();
+    if (textureIndex == UINT_MAX)
+    {
+        ++droppedInstanceCount_;
+        return;
+    }
+    instance.textureIndex = textureIndex;
+    batch_.Add(materialId, textureIndex, instance);
+}
+
+///=========================================================================================
+/// <summary>
+/// 集めたスプライトを並べ替えて、バッチごとにインスタンスバッファへ書き、
+/// 共通の単位四角形を 1 回のインスタンス描画で描きます。
+/// ページに収まらない大きなバッチはページごとに分けて描きます。
+/// </summary>
+///=========================================================================================
+void Dx12SpriteBatchRenderer::Flush()
+{
+    ID3D12GraphicsCommandList* commandList = Dx12RenderDevice::GetCommandList();
+    if (!IsAvailable() || batch_.GetCount() == 0 || commandList == nullptr)
+    {
+        batch_.Clear();
+        return;
+    }
+
+    batch_.Build(true);
+    const std::vector<SpriteInstance>& instances = batch_.GetInstances();
+
+    D3D12_VIEWPORT viewport = {};
+    viewport.Width = static_cast<FLOAT>(Application::GetWindowWidth());
+    viewport.Height = static_cast<FLOAT>(Application::GetWindowHeight());
+    viewport.MinDepth = 0.0f;
+    viewport.MaxDepth = 1.0f;
+    const D3D12_RECT scissorRect = { 0, 0, static_cast<LONG>(viewport.Width), static_cast<LONG>(viewport.Height) };
+    commandList->RSSetViewports(1, &viewport);
+    commandList->RSSetScissorRects(1, &scissorRect);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->IASetVertexBuffers(0, 1, &vertexBufferView_);
+    commandList->IASetIndexBuffer(&indexBufferView_);
+
+    uint32_t drawCount = 0;
+    uint32_t boundMaterialId = UINT32_MAX;
+    for (const SpriteBatchRange& range : batch_.GetBatches())
+    {
+        if (range.materialId != boundMaterialId)
+        {
+            materials_[range.materialId].material.Bind(commandList);
+            boundMaterialId = range.materialId;
+        }
+
+        uint32_t first = range.firstInstance;
+        uint32_t remaining = range.instanceCount;
+        while (remaining > 0)
+        {
+            const uint32_t count = (std::min)(remaining, static_cast<uint32_t>(InstancesPerPage));
+            const size_t size = static_cast<size_t>(count) * sizeof(SpriteInstance);
+            FrameUploadAllocation allocation;
+            if (!instancePages_.Allocate(size, allocation))
+            {
+                break;
+            }
+            std::memcpy(allocation.cpuAddress, &instances[first], size);
+
+            D3D12_VERTEX_BUFFER_VIEW instanceView = {};
+            instanceView.BufferLocation = allocation.gpuAddress;
+            instanceView.SizeInBytes = static_cast<UINT>(size);
+            instanceView.StrideInBytes = sizeof(SpriteInstance);
+            commandList->IASetVertexBuffers(1, 1, &instanceView);
+            commandList->DrawIndexedInstanced(6, count, 0, 0, 0);
+            ++drawCount;
+            first += count;
+            remaining -= count;
+        }
+        droppedInstanceCount_ += remaining;
+    }
+
+    lastStatistics_ = batch_.GetStatistics();
+    lastDrawCount_ = drawCount;
+    peakInstanceCount_ = (std::max)(peakInstanceCount_, lastStatistics_.instanceCount);
+    batch_.Clear();
+}
+
+std::string Dx12SpriteBatchRenderer::FormatReport() const
+{
+    const FrameLinearAllocatorStatistics statistics = instancePages_.GetStatistics();
+    char buffer[320];
+    std::snprintf(buffer, sizeof(buffer),
+        "sprite batch: last flush %u sprites (%u culled) in %u draws / %u batches, peak %u sprites, %llu dropped, "
+        "%u / %u instance pages of %llu KB, %llu reused in flight",
+        lastStatistics_.instanceCount, lastStatistics_.culledCount, lastDrawCount_, lastStatistics_.batchCount,
+        peakInstanceCount_, static_cast<unsigned long long>(droppedInstanceCount_),
+        statistics.pageCount, statistics.maxPageCount, static_cast<unsigned long long>(statistics.pageSize / 1024),
+        static_cast<unsigned long long>(statistics.inFlightReuseCount));
+    return buffer;
+}
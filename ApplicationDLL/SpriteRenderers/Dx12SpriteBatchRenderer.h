@@ -0,0 +1,101 @@
+#pragma once
+
+#include "SpriteBatch.h"
+#include "RHI/FrameUploadPagePool.h"
+#include "Source/Material.h"
+#include "Source/PipelineLibrary.h"
+#include "System/ResourceAccounting.h"
+
+#include <d3d12.h>
+#include <wrl/client.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class RHITexture;
+
+///=======================================================================
+/// <summary>
+/// DirectX12 のスプライトをまとめて描くクラス。
+/// Dx12SpriteRendererBackend::Render は描かずに Submit でスプライトを渡し、RenderSpriteRenderers の最後の
+/// Flush で、集めたスプライトを SpriteBatch でマテリアル・テクスチャーの順に並べてフレームの
+/// インスタンスバッファに書き、共通の単位四角形をバッチごとに 1 回のインスタンス描画で描きます。
+/// テクスチャーはバインドレス（インスタンスごとのインデックス）で読むので、バッチを分けるのはマテリアルだけです。
+/// インスタンスバッファは FrameConstantsManager と同じく、FrameUploadPagePool のページから切り出します。
+/// 描画スレッドから呼び出します。
+/// </summary>
+///=======================================================================
+class Dx12SpriteBatchRenderer
+{
+public:
+    static Dx12SpriteBatchRenderer& Get();
+
+    Dx12SpriteBatchRenderer(const Dx12SpriteBatchRenderer&) = delete;
+
+    /// 初めて呼ばれたとき（Reset の後も）に単位四角形とパイプラインを作ります。
+    /// バインドレスに対応していない、または作成に失敗した場合は false（呼び出し側は 1 枚ずつ描きます）。
+    /// デバイスがまだ無い場合も false ですが、失敗は覚えずに次の呼び出しで作り直します。
+    bool IsAvailable();
+
+    /// マテリアル名の番号（並べ替えのキー）。扱えない名前は UINT32_MAX
+    uint32_t FindMaterialId(const std::string& materialName) const;
+
+    /// instance の位置と大きさはビューポートの NDC。texture は Flush までの間、呼び出し側が保持します。
+    void Submit(uint32_t materialId, const RHITexture* texture, SpriteInstance instance);
+
+    /// 集めたスプライトを今のコマンドリストに記録して、次の描画先のために空にします。
+    void Flush();
+
+    /// FrameConstantsManager::BeginFrame と同じく、フレームの記録を始める前に呼びます。
+    void BeginFrame(UINT64 frameFenceValue, UINT64 completedFenceValue);
+    /// GPU のリソースを破棄します（GPU の処理が終わってから呼ぶこと）。
+    void Reset();
+
+    std::string FormatReport() const;
+
+private:
+    /// 1 ページのインスタンス数。1 回の描画の上限でもあるので、大きなバッチは分けて描きます。
+    constexpr static UINT InstancesPerPage = 64 * 1024;
+    constexpr static UINT64 PageSize = InstancesPerPage * sizeof(SpriteInstance);
+    /// 1 フレーム（描画先ごとの Flush の合計）で 25 万枚まで
+    constexpr static UINT MaxPagesPerFrame = 4;
+    constexpr static UINT FrameCount = 2;
+
+    struct MaterialEntry
+    {
+        std::string name;
+        Material material;
+    };
+
+    Dx12SpriteBatchRenderer() = default;
+
+    bool Initialize();
+    /// 単位四角形の頂点とインデックス（全てのスプライトで共通）
+    HRESULT CreateUnitQuad(ID3D12Device* device);
+
+    bool isInitialized_ = false;
+    bool isInitializeFailed_ = false;
+
+    PipelineLibrary pipelineLibrary_;
+    /// 添字が FindMaterialId の番号
+    std::vector<MaterialEntry> materials_;
+
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexBuffer_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexBuffer_;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView_ = {};
+    D3D12_INDEX_BUFFER_VIEW indexBufferView_ = {};
+    ResourceAccounting::TrackedAllocation vertexAllocation_;
+    ResourceAccounting::TrackedAllocation indexAllocation_;
+
+    FrameUploadPagePool instancePages_;
+
+    SpriteBatch batch_;
+
+    /// 最後の Flush と、これまでの最大
+    SpriteBatchStatistics lastStatistics_;
+    uint32_t lastDrawCount_ = 0;
+    uint32_t peakInstanceCount_ = 0;
+    /// インスタンスバッファが足りずに描けなかったスプライトの数
+    uint64_t droppedInstanceCount_ = 0;
+};
@@ -1,23 +1,125 @@
 #include "pch.h"
 #include "Dx12SpriteRendererBackend.h"
 
+#include "Dx12SpriteBatchRenderer.h"
+#include "AppRuntime.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr const char* kDefaultMaterialName = "BuiltInMaterials::UnlitTexture";
+}
+
+Dx12SpriteRendererBackend::Dx12SpriteRendererBackend() = default;
+
 void Dx12SpriteRendererBackend::SetTransform(float centerX, float centerY, float width, float height)
 {
-    quad_.SetTransform(centerX, centerY, width, height);
+    centerX_ = centerX;
+    centerY_ = centerY;
+    width_ = (std::max)(width, 0.01f);
+    height_ = (std::max)(height, 0.01f);
+    if (fallbackQuad_ != nullptr)
+    {
+        fallbackQuad_->SetTransform(centerX, centerY, width, height);
+    }
 }
 
 void Dx12SpriteRendererBackend::SetTextureHandle(TextureHandle textureHandle)
 {
-    quad_.SetTextureHandle(textureHandle);
+    textureHandle_ = textureHandle;
+    RefreshTexture();
+    if (fallbackQuad_ != nullptr)
+    {
+        fallbackQuad_->SetTextureHandle(textureHandle);
+    }
 }
 
 void Dx12SpriteRendererBackend::SetMaterialName(const std::string& materialName)
 {
-    quad_.SetMaterialName(materialName);
+    // バッチが初期化される前にも呼ばれるので、名前は確かめずに覚えておく
+    materialName_ = materialName;
+    if (fallbackQuad_ != nullptr)
+    {
+        fallbackQuad_->SetMaterialName(materialName);
+    }
 }
 
+void Dx12SpriteRendererBackend::RefreshTexture()
+{
+    // 毎フレーム呼ばれるので、参照カウントを増やさずに確かめ、変わったときだけ取得し直す
+    TextureAssetManager& manager = TextureAssetManager::Get();
+    const RHITexture* current = manager.PeekTexture(textureHandle_, nullptr, &textureRegion_);
+    if (current == nullptr || current == texture_.get())
+    {
+        return;
+    }
+
+    std::shared_ptr<RHITexture> texture = manager.GetTexture(textureHandle_, nullptr, &textureRegion_);
+    if (texture != nullptr)
+    {
+        texture_ = std::move(texture);
+    }
+}
+
+///=========================================================================================
+/// <summary>
+/// ビューポートの NDC に変換したスプライトを Dx12SpriteBatchRenderer に渡します。
+/// 描画は RenderSpriteRenderers の最後の Flush でまとめて行います。
+/// </summary>
+///=========================================================================================
 void Dx12SpriteRendererBackend::Render(IRenderDevice* renderDevice, ViewportRenderMode viewportMode)
 {
     (void)renderDevice;
-    quad_.Render(viewportMode);
+    // デバイスを作り直すと使えるかどうかが変わるので、毎回確かめる
+    Dx12SpriteBatchRenderer& batchRenderer = Dx12SpriteBatchRenderer::Get();
+    if (!batchRenderer.IsAvailable())
+    {
+        RenderFallback(viewportMode);
+        return;
+    }
+
+    RefreshTexture();
+
+    SpriteInstance instance;
+    TransformWorldQuadToViewportNdc(
+        viewportMode,
+        centerX_,
+        centerY_,
+        width_,
+        height_,
+        instance.centerX,
+        instance.centerY,
+        instance.width,
+        instance.height);
+    instance.u0 = textureRegion_.u0;
+    instance.v0 = textureRegion_.v0;
+    instance.u1 = textureRegion_.u1;
+    instance.v1 = textureRegion_.v1;
+
+    // 画面上の大きさ（ピクセル）を報告し、それに見合うミップだけを常駐させる
+    const float screenWidth = instance.width * 0.5f * static_cast<float>(Application::GetWindowWidth());
+    const float screenHeight = instance.height * 0.5f * static_cast<float>(Application::GetWindowHeight());
+    TextureAssetManager::Get().ReportTextureUsage(textureHandle_, std::abs(screenWidth), std::abs(screenHeight));
+
+    // バッチのマテリアルに無い名前は既定のマテリアルで描く
+    uint32_t materialId = batchRenderer.FindMaterialId(materialName_);
+    if (materialId == UINT32_MAX)
+    {
+        materialId = batchRenderer.FindMaterialId(kDefaultMaterialName);
+    }
+    batchRenderer.Submit(materialId, texture_.get(), instance);
+}
+
+void Dx12SpriteRendererBackend::RenderFallback(ViewportRenderMode viewportMode)
+{
+    if (fallbackQuad_ == nullptr)
+    {
+        fallbackQuad_ = std::make_unique<QuadRenderObject>();
+        fallbackQuad_->SetTransform(centerX_, centerY_, width_, height_);
+        fallbackQuad_->SetTextureHandle(textureHandle_);
+        fallbackQuad_->SetMaterialName(materialName_);
+    }
+    fallbackQuad_->Render(viewportMode);
 }
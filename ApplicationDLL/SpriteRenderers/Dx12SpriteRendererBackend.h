@@ -3,14 +3,43 @@
 #include "ISpriteRendererBackend.h"
 #include "PolygonTest.h"
 
+#include <memory>
+#include <string>
+
+///=======================================================================
+/// <summary>
+/// DirectX12 のスプライト。描画は Dx12SpriteBatchRenderer に渡して、他のスプライトとまとめて描きます。
+/// バッチで描けない（バインドレスに対応していない）デバイスでは、これまでどおり QuadRenderObject で 1 枚ずつ描きます。
+/// どちらで描くかは Render のたびに決めるので、デバイスを作り直してもスプライトは描かれ続けます。
+/// </summary>
+///=======================================================================
 class Dx12SpriteRendererBackend final : public ISpriteRendererBackend
 {
 public:
+    Dx12SpriteRendererBackend();
+
     void SetTransform(float centerX, float centerY, float width, float height) override;
     void SetTextureHandle(TextureHandle textureHandle) override;
     void SetMaterialName(const std::string& materialName) override;
     void Render(IRenderDevice* renderDevice, ViewportRenderMode viewportMode) override;
 
 private:
-    QuadRenderObject quad_;
+    /// 読み込みの完了や常駐するミップの変更で差し替わったテクスチャーを取得し直します。
+    void RefreshTexture();
+    /// バッチで描けないときに、今の状態を写した QuadRenderObject で描きます。
+    void RenderFallback(ViewportRenderMode viewportMode);
+
+    float centerX_ = 0.0f;
+    float centerY_ = 0.0f;
+    float width_ = 0.8f;
+    float height_ = 1.4f;
+    TextureHandle textureHandle_ = 0;
+    /// 指定された名前。バッチのマテリアルに無い名前なら Render で既定のマテリアルを使う
+    std::string materialName_ = "BuiltInMaterials::UnlitTexture";
+    /// 描画を記録したフレームが終わるまで、テクスチャーを破棄させない
+    std::shared_ptr<RHITexture> texture_;
+    TextureRegion textureRegion_;
+
+    /// バッチで描けなかったときに初めて作り、以後は設定を写し続ける
+    std::unique_ptr<QuadRenderObject> fallbackQuad_;
 };
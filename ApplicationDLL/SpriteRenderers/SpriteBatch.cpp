@@ -0,0 +1,129 @@
+#include "SpriteBatch.h"
+
+#include <cmath>
+
+void SpriteBatch::Clear()
+{
+    instances_.clear();
+    entries_.clear();
+    sortedInstances_.clear();
+    batches_.clear();
+    keyAnd_ = ~0ull;
+    keyOr_ = 0;
+    statistics_ = {};
+}
+
+void SpriteBatch::Reserve(size_t spriteCount)
+{
+    instances_.reserve(spriteCount);
+    entries_.reserve(spriteCount);
+    scratch_.reserve(spriteCount);
+    sortedInstances_.reserve(spriteCount);
+}
+
+bool SpriteBatch::Add(uint32_t materialId, uint32_t textureId, const SpriteInstance& instance)
+{
+    ++statistics_.submittedCount;
+    const float halfWidth = std::fabs(instance.width) * 0.5f;
+    const float halfHeight = std::fabs(instance.height) * 0.5f;
+    if (instance.centerX + halfWidth < -1.0f || instance.centerX - halfWidth > 1.0f ||
+        instance.centerY + halfHeight < -1.0f || instance.centerY - halfHeight > 1.0f)
+    {
+        ++statistics_.culledCount;
+        return false;
+    }
+
+    SortEntry entry;
+    entry.key = (static_cast<uint64_t>(materialId) << 32) | textureId;
+    entry.index = static_cast<uint32_t>(instances_.size());
+    entries_.push_back(entry);
+    instances_.push_back(instance);
+    keyAnd_ &= entry.key;
+    keyOr_ |= entry.key;
+    return true;
+}
+
+///====================================================================
+/// <summary>
+/// 並べ替えた順にスプライトを詰め直し、キー（バインドレスならマテリアルだけ）が
+/// 変わるところでバッチを区切ります。
+/// </summary>
+///====================================================================
+void SpriteBatch::Build(bool isTexturePerInstance)
+{
+    SortEntries();
+
+    sortedInstances_.resize(entries_.size());
+    batches_.clear();
+    const uint64_t batchKeyMask = isTexturePerInstance ? 0xFFFFFFFF00000000ull : ~0ull;
+    for (size_t i = 0; i < entries_.size(); ++i)
+    {
+        const SortEntry& entry = entries_[i];
+        sortedInstances_[i] = instances_[entry.index];
+
+        const bool isNewBatch = i == 0 || ((entry.key ^ entries_[i - 1].key) & batchKeyMask) != 0;
+        if (isNewBatch)
+        {
+            SpriteBatchRange range;
+            range.materialId = static_cast<uint32_t>(entry.key >> 32);
+            range.textureId = static_cast<uint32_t>(entry.key);
+            range.firstInstance = static_cast<uint32_t>(i);
+            batches_.push_back(range);
+        }
+        ++batches_.back().instanceCount;
+    }
+
+    statistics_.instanceCount = static_cast<uint32_t>(sortedInstances_.size());
+    statistics_.batchCount = static_cast<uint32_t>(batches_.size());
+}
+
+///====================================================================
+/// <summary>
+/// 8 ビットずつの LSD 基数ソート。全てのキーで同じ値の桁（使っていないマテリアルの上位ビットなど）は
+/// Add で取っておいた AND と OR から分かるので、度数も数えずに飛ばします。
+/// 桁ごとの並べ替えは安定なので、同じキーの中では Add の順が残ります。
+/// </summary>
+///====================================================================
+void SpriteBatch::SortEntries()
+{
+    constexpr int DigitBits = 8;
+    constexpr int DigitCount = 64 / DigitBits;
+    constexpr uint64_t DigitMask = (uint64_t(1) << DigitBits) - 1;
+
+    statistics_.sortPassCount = 0;
+    if (entries_.size() < 2)
+    {
+        return;
+    }
+
+    const uint64_t varyingBits = keyAnd_ ^ keyOr_;
+    scratch_.resize(entries_.size());
+    for (int digit = 0; digit < DigitCount; ++digit)
+    {
+        const int shift = digit * DigitBits;
+        if (((varyingBits >> shift) & DigitMask) == 0)
+        {
+            continue;
+        }
+
+        uint32_t offsets[DigitMask + 1] = {};
+        for (const SortEntry& entry : entries_)
+        {
+            ++offsets[(entry.key >> shift) & DigitMask];
+        }
+        // 度数を書き込み位置に変える
+        uint32_t offset = 0;
+        for (uint32_t& bucket : offsets)
+        {
+            const uint32_t bucketCount = bucket;
+            bucket = offset;
+            offset += bucketCount;
+        }
+        for (const SortEntry& entry : entries_)
+        {
+            scratch_[offsets[(entry.key >> shift) & DigitMask]++] = entry;
+        }
+        entries_.swap(scratch_);
+        ++statistics_.sortPassCount;
+    }
+}
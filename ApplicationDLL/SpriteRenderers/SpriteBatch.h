@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// インスタンス描画で 1 枚のスプライトに渡す値（頂点バッファのスロット 1 にそのまま並べます）。
+/// 位置と大きさはビューポートの NDC です。
+/// </summary>
+///=======================================================================
+struct SpriteInstance
+{
+    float centerX = 0.0f;
+    float centerY = 0.0f;
+    float width = 0.0f;
+    float height = 0.0f;
+    /// テクスチャー内の範囲（アトラスのページなら一部）
+    float u0 = 0.0f;
+    float v0 = 0.0f;
+    float u1 = 1.0f;
+    float v1 = 1.0f;
+    /// シェーダーから見えるヒープでのインデックス（バインドレス）
+    uint32_t textureIndex = 0;
+    /// R8G8B8A8（R が最下位のバイト）。テクスチャーの色に掛けます
+    uint32_t color = 0xFFFFFFFFu;
+    /// 16 バイトの境界に揃える
+    uint32_t reserved[2] = {};
+};
+static_assert(sizeof(SpriteInstance) == 48, "SpriteInstance must match the instance input layout");
+
+///=======================================================================
+/// <summary>
+/// 1 回のインスタンス描画で描く範囲。GetInstances の [firstInstance, firstInstance + instanceCount)
+/// </summary>
+///=======================================================================
+struct SpriteBatchRange
+{
+    uint32_t materialId = 0;
+    /// テクスチャーごとにバッチを分けない場合は、バッチの最初のスプライトのもの
+    uint32_t textureId = 0;
+    uint32_t firstInstance = 0;
+    uint32_t instanceCount = 0;
+};
+
+struct SpriteBatchStatistics
+{
+    /// Add に渡された数と、そのうち画面の外で捨てた数
+    uint32_t submittedCount = 0;
+    uint32_t culledCount = 0;
+    uint32_t instanceCount = 0;
+    uint32_t batchCount = 0;
+    /// 基数ソートで実際に並べ替えた桁の数（全て同じ値の桁は飛ばします）
+    uint32_t sortPassCount = 0;
+};
+
+///=======================================================================
+/// <summary>
+/// 1 フレームのスプライトを集めて、マテリアル・テクスチャーの順に並べ、
+/// 同じ状態で描ける範囲（バッチ）に分けます。
+/// Add で集め、Build で並べ替えてから GetInstances / GetBatches を読み、Clear で次のフレームに移ります。
+/// 並べ替えはキー（マテリアル、テクスチャー）の基数ソートで、同じキーの中では Add の順を保ちます。
+/// 描画スレッドから呼び出します。GPU の API には依存しないため、単体で動作を確認できます。
+/// </summary>
+///=======================================================================
+class SpriteBatch
+{
+public:
+    /// 集めたスプライトを捨てます（確保した領域は次のフレームで使い回します）。
+    void Clear();
+    void Reserve(size_t spriteCount);
+
+    /// 画面（NDC の [-1, 1]）と重ならないスプライトは捨てて false を返します。
+    /// textureId は並べ替えのキーで、instance.textureIndex と同じである必要はありません。
+    bool Add(uint32_t materialId, uint32_t textureId, const SpriteInstance& instance);
+
+    /// 並べ替えてバッチに分けます。isTexturePerInstance が true の場合（バインドレス）は、
+    /// テクスチャーをインスタンスごとに読むので、マテリアルが変わるところでだけ分けます。
+    void Build(bool isTexturePerInstance);
+
+    /// Add で受け付けた（画面と重なる）スプライトの数
+    size_t GetCount() const { return entries_.size(); }
+    /// Build の後に、並べ替えたスプライト
+    const std::vector<SpriteInstance>& GetInstances() const { return sortedInstances_; }
+    const std::vector<SpriteBatchRange>& GetBatches() const { return batches_; }
+    SpriteBatchStatistics GetStatistics() const { return statistics_; }
+
+private:
+    struct SortEntry
+    {
+        /// 上位 32 ビットがマテリアル、下位がテクスチャー
+        uint64_t key = 0;
+        /// instances_ でのインデックス
+        uint32_t index = 0;
+    };
+
+    /// entries_ をキーの順に並べ替えます（安定）。
+    void SortEntries();
+
+    std::vector<SpriteInstance> instances_;
+    std::vector<SortEntry> entries_;
+    std::vector<SortEntry> scratch_;
+    /// 全てのキーの AND と OR。一致しない桁だけを並べ替える
+    uint64_t keyAnd_ = ~0ull;
+    uint64_t keyOr_ = 0;
+    std::vector<SpriteInstance> sortedInstances_;
+    std::vector<SpriteBatchRange> batches_;
+    SpriteBatchStatistics statistics_;
+};
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "SpriteRendererBackendFactory.h"
 
+#include "Dx12SpriteBatchRenderer.h"
 #include "Dx12SpriteRendererBackend.h"
 #include "OpenGlSpriteRendererBackend.h"
 #include "VulkanSpriteRendererBackend.h"
@@ -19,3 +20,11 @@ std::unique_ptr<ISpriteRendererBackend> CreateSpriteRendererBackend(RendererBack
         return nullptr;
     }
 }
+
+void FlushSpriteRendererBackend(RendererBackend backend)
+{
+    if (backend == RendererBackend::DirectX12)
+    {
+        Dx12SpriteBatchRenderer::Get().Flush();
+    }
+}
@@ -6,3 +6,6 @@
 #include <memory>
 
 std::unique_ptr<ISpriteRendererBackend> CreateSpriteRendererBackend(RendererBackend backend);
+
+/// 描画先ごとに、全てのスプライトの Render の後で呼びます。まとめて描くバックエンドはここで描きます。
+void FlushSpriteRendererBackend(RendererBackend backend);
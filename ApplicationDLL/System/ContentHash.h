@@ -0,0 +1,29 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+///=======================================================================
+/// <summary>
+/// バイト列の内容ハッシュ（64bit FNV-1a）。
+/// クックしたアセットの同一性確認に使用します。暗号学的な強度はありません。
+/// </summary>
+///=======================================================================
+namespace ContentHash
+{
+	constexpr uint64_t kOffsetBasis = 14695981039346656037ull;
+	constexpr uint64_t kPrime = 1099511628211ull;
+
+	/// 続きから計算する場合は直前の戻り値を seed に渡します。
+	inline uint64_t Compute(const void* data, size_t size, uint64_t seed = kOffsetBasis)
+	{
+		const uint8_t* bytes = static_cast<const uint8_t*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i)
+		{
+			hash ^= bytes[i];
+			hash *= kPrime;
+		}
+		return hash;
+	}
+}
@@ -0,0 +1,197 @@
+﻿#include "FileWatcher.h"
+
+FileWatcher::~FileWatcher()
+{
+	Stop();
+}
+
+void FileWatcher::Start(std::chrono::milliseconds interval)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Interval = interval;
+	if (m_Thread.joinable())
+	{
+		m_Wake.notify_all();
+		return;
+	}
+	m_IsStopping = false;
+	m_Thread = std::thread(&FileWatcher::ThreadMain, this);
+}
+
+void FileWatcher::Stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (!m_Thread.joinable())
+		{
+			return;
+		}
+		m_IsStopping = true;
+	}
+	m_Wake.notify_all();
+	m_Thread.join();
+}
+
+bool FileWatcher::IsRunning() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Thread.joinable() && !m_IsStopping;
+}
+
+void FileWatcher::Watch(const std::filesystem::path& path)
+{
+	if (path.empty())
+	{
+		return;
+	}
+
+	// 今の状態を基準にする（登録より前の変更は報告しない）。ファイルを調べる間はロックを持たない
+	FileState state;
+	state.path = path;
+	ReadState(path, state.exists, state.writeTime, state.size);
+
+	const std::string key = GetKey(path);
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	auto it = m_Files.find(key);
+	if (it == m_Files.end())
+	{
+		it = m_Files.emplace(key, std::move(state)).first;
+	}
+	++it->second.refCount;
+}
+
+void FileWatcher::Unwatch(const std::filesystem::path& path)
+{
+	const std::string key = GetKey(path);
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const auto it = m_Files.find(key);
+	if (it != m_Files.end() && --it->second.refCount == 0)
+	{
+		m_Files.erase(it);
+	}
+}
+
+void FileWatcher::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Files.clear();
+}
+
+size_t FileWatcher::GetWatchedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Files.size();
+}
+
+///====================================================================
+/// <summary>
+/// 登録されたファイルを調べます。ファイルシステムへの問い合わせはロックの外で行うので、
+/// 調べている間に外されたファイルの結果は捨てます。
+/// </summary>
+///====================================================================
+void FileWatcher::Poll()
+{
+	std::vector<std::pair<std::string, std::filesystem::path>> targets;
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		targets.reserve(m_Files.size());
+		for (const auto& file : m_Files)
+		{
+			targets.emplace_back(file.first, file.second.path);
+		}
+	}
+
+	struct Observation
+	{
+		bool exists = false;
+		std::filesystem::file_time_type writeTime = {};
+		uint64_t size = 0;
+	};
+	std::vector<Observation> observations(targets.size());
+	for (size_t i = 0; i < targets.size(); ++i)
+	{
+		ReadState(targets[i].second, observations[i].exists, observations[i].writeTime, observations[i].size);
+	}
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (size_t i = 0; i < targets.size(); ++i)
+	{
+		const auto it = m_Files.find(targets[i].first);
+		if (it == m_Files.end())
+		{
+			continue;
+		}
+		FileState& state = it->second;
+		const Observation& observed = observations[i];
+		const bool isSame = observed.exists == state.exists && observed.writeTime == state.writeTime && observed.size == state.size;
+		if (!isSame)
+		{
+			// 書き込みの途中かもしれないので、次の確認まで待つ
+			state.exists = observed.exists;
+			state.writeTime = observed.writeTime;
+			state.size = observed.size;
+			state.isSettling = true;
+			continue;
+		}
+		if (state.isSettling && state.exists)
+		{
+			state.isChanged = true;
+		}
+		state.isSettling = false;
+	}
+}
+
+std::vector<std::filesystem::path> FileWatcher::TakeChangedFiles()
+{
+	std::vector<std::filesystem::path> changed;
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	for (auto& file : m_Files)
+	{
+		if (file.second.isChanged)
+		{
+			file.second.isChanged = false;
+			changed.push_back(file.second.path);
+		}
+	}
+	return changed;
+}
+
+std::string FileWatcher::GetKey(const std::filesystem::path& path)
+{
+	std::error_code ec;
+	const std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+	return (ec ? path : absolute).lexically_normal().generic_string();
+}
+
+void FileWatcher::ReadState(const std::filesystem::path& path, bool& outExists, std::filesystem::file_time_type& outWriteTime, uint64_t& outSize)
+{
+	std::error_code ec;
+	outWriteTime = std::filesystem::last_write_time(path, ec);
+	outExists = !ec;
+	outSize = 0;
+	if (outExists)
+	{
+		const uintmax_t size = std::filesystem::file_size(path, ec);
+		outSize = ec ? 0 : static_cast<uint64_t>(size);
+	}
+	else
+	{
+		outWriteTime = {};
+	}
+}
+
+void FileWatcher::ThreadMain()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	while (!m_IsStopping)
+	{
+		m_Wake.wait_for(lock, m_Interval);
+		if (m_IsStopping)
+		{
+			break;
+		}
+		lock.unlock();
+		Poll();
+		lock.lock();
+	}
+}
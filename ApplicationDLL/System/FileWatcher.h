@@ -0,0 +1,79 @@
+﻿#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// 登録したファイルの更新日時と大きさをバックグラウンドのスレッドで定期的に調べ、
+/// 変わったファイルを TakeChangedFiles で返します。
+/// エディターは保存を何回かに分けて書き込むことがあるので、変化を見つけても
+/// 次の確認で同じ内容のまま（書き終わった）と分かるまでは報告しません。
+/// Start しなければスレッドは作らず、呼び出し側が Poll を呼んで進めます。
+/// </summary>
+///=======================================================================
+class FileWatcher
+{
+public:
+	static constexpr std::chrono::milliseconds kDefaultInterval{ 250 };
+
+	FileWatcher() = default;
+	~FileWatcher();
+
+	FileWatcher(const FileWatcher&) = delete;
+	FileWatcher& operator=(const FileWatcher&) = delete;
+
+	/// 監視のスレッドを開始します。既に開始していれば間隔だけ変えます。
+	void Start(std::chrono::milliseconds interval = kDefaultInterval);
+	void Stop();
+	bool IsRunning() const;
+
+	/// 同じファイルを何度登録しても構いません（Unwatch を同じ回数呼ぶと外れます）。
+	void Watch(const std::filesystem::path& path);
+	void Unwatch(const std::filesystem::path& path);
+	void Clear();
+	size_t GetWatchedCount() const;
+
+	/// 登録したファイルを 1 回調べます（スレッドからも呼ばれます）。
+	void Poll();
+
+	/// 前回の呼び出し以降に書き換わったファイル（同じファイルは 1 回だけ）
+	std::vector<std::filesystem::path> TakeChangedFiles();
+
+	/// 同じファイルを別の書き方（"a/../b.png" など）で渡しても同じになる文字列
+	static std::string GetKey(const std::filesystem::path& path);
+
+private:
+	struct FileState
+	{
+		std::filesystem::path path;
+		uint32_t refCount = 0;
+		bool exists = false;
+		std::filesystem::file_time_type writeTime = {};
+		uint64_t size = 0;
+		/// 変化を見つけて、書き終わるのを待っている
+		bool isSettling = false;
+		/// 変化を見つけたが、まだ TakeChangedFiles で返していない
+		bool isChanged = false;
+	};
+
+	/// ファイルの今の状態を読みます。消えている（保存の途中で一度消すエディターもある）場合は exists が false
+	static void ReadState(const std::filesystem::path& path, bool& outExists, std::filesystem::file_time_type& outWriteTime, uint64_t& outSize);
+	void ThreadMain();
+
+	mutable std::mutex m_Mutex;
+	std::condition_variable m_Wake;
+	std::thread m_Thread;
+	std::chrono::milliseconds m_Interval = kDefaultInterval;
+	bool m_IsStopping = false;
+	/// GetKey ごと
+	std::unordered_map<std::string, FileState> m_Files;
+};
@@ -0,0 +1,226 @@
+﻿#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <utility>
+
+///=======================================================================
+/// <summary>
+/// 世代付きのハンドル（スロット番号 + 世代を 32 ビットに詰めたもの）で値を引く表。
+/// 読み取り（Find）はロックも参照カウントの操作もしない wait-free で、どのスレッドからでも呼べます。
+/// 書き込み（Allocate / Publish / Free / Reclaim）は呼び出し側で 1 つずつに揃えてください。
+///
+/// 値は置き換えても解放してもすぐには消さず、Reclaim が kGracePeriod 回呼ばれてから消します
+/// （RCU と同じ考え方で、Reclaim を呼ぶ時点を読み取りの区切りにします）。
+/// Find で得たポインタは、次の Reclaim をまたいで持ち続けないでください。
+///
+/// 世代は 12 ビットしかないので、空いたスロットは最も古く空いたものから使い回し（FIFO）、
+/// 世代を使い切ったスロットは二度と使いません（古いハンドルが別の値に一致しないように）。
+/// </summary>
+///=======================================================================
+template <typename T>
+class HandleTable
+{
+public:
+	using Handle = uint32_t;
+
+	static constexpr uint32_t kIndexBits = 20;
+	static constexpr uint32_t kMaxSlotCount = 1u << kIndexBits;
+	static constexpr uint32_t kGenerationMask = (1u << (32 - kIndexBits)) - 1;
+	/// 置き換えた値を消すまでに待つ Reclaim の回数
+	static constexpr uint64_t kGracePeriod = 2;
+
+	HandleTable() = default;
+	HandleTable(const HandleTable&) = delete;
+	HandleTable& operator=(const HandleTable&) = delete;
+
+	~HandleTable()
+	{
+		for (std::atomic<Chunk*>& chunkPointer : m_Chunks)
+		{
+			Chunk* chunk = chunkPointer.load(std::memory_order_relaxed);
+			if (chunk == nullptr)
+			{
+				continue;
+			}
+			for (Slot& slot : chunk->slots)
+			{
+				delete slot.value.load(std::memory_order_relaxed);
+			}
+			delete chunk;
+		}
+	}
+
+	///====================================================================
+	/// <summary>
+	/// 空きスロットを確保してハンドルを返します。値は Publish まで空です。
+	/// </summary>
+	/// <returns>ハンドル（0 にはなりません）。スロットが足りない場合は 0</returns>
+	///====================================================================
+	Handle Allocate()
+	{
+		uint32_t index = 0;
+		if (!m_FreeIndices.empty())
+		{
+			index = m_FreeIndices.front();
+			m_FreeIndices.pop_front();
+		}
+		else
+		{
+			if (m_SlotCount >= kMaxSlotCount)
+			{
+				return 0;
+			}
+			index = m_SlotCount++;
+			std::atomic<Chunk*>& chunk = m_Chunks[index / kChunkSize];
+			if (chunk.load(std::memory_order_relaxed) == nullptr)
+			{
+				// 読み取り側が途中までの初期化を見ないよう、作り終えてから公開する
+				chunk.store(new Chunk(), std::memory_order_release);
+			}
+		}
+		++m_LiveCount;
+		return MakeHandle(index, GetSlot(index).generation.load(std::memory_order_relaxed));
+	}
+
+	/// 値を置き換えます。前の値は猶予の後に消します。古いハンドルなら何もせず false
+	bool Publish(Handle handle, std::unique_ptr<T> value)
+	{
+		Slot* slot = FindSlot(handle);
+		if (slot == nullptr)
+		{
+			return false;
+		}
+		Retire(slot->value.exchange(value.release(), std::memory_order_acq_rel));
+		return true;
+	}
+
+	/// スロットを空けます。世代を進めるので、このハンドルは以後 Find で見つかりません。
+	bool Free(Handle handle)
+	{
+		Slot* slot = FindSlot(handle);
+		if (slot == nullptr)
+		{
+			return false;
+		}
+		// 世代を先に進める（Find は値を読んだ後に世代を確かめ直す）。
+		// 一周して 1 に戻ると古いハンドルと一致するので、使い切ったスロットは 0（どのハンドルとも一致しない）にして空きに戻さない
+		const uint32_t generation = slot->generation.load(std::memory_order_relaxed);
+		const bool isExhausted = generation == kGenerationMask;
+		slot->generation.store(isExhausted ? 0 : generation + 1, std::memory_order_release);
+		Retire(slot->value.exchange(nullptr, std::memory_order_acq_rel));
+		if (isExhausted)
+		{
+			++m_ExhaustedSlotCount;
+		}
+		else
+		{
+			m_FreeIndices.push_back(GetIndex(handle));
+		}
+		--m_LiveCount;
+		return true;
+	}
+
+	/// 読み取りの区切り（フレームの初めなど）で呼び、猶予の過ぎた値を消します。
+	void Reclaim()
+	{
+		++m_Epoch;
+		while (!m_Retired.empty() && m_Retired.front().first + kGracePeriod <= m_Epoch)
+		{
+			m_Retired.pop_front();
+		}
+	}
+
+	///====================================================================
+	/// <summary>
+	/// ハンドルの値を返します（wait-free）。解放済み・世代の違うハンドルや値が未設定なら nullptr
+	/// </summary>
+	///====================================================================
+	const T* Find(Handle handle) const
+	{
+		const uint32_t generation = GetGeneration(handle);
+		const uint32_t index = GetIndex(handle);
+		if (generation == 0)
+		{
+			return nullptr;
+		}
+		const Chunk* chunk = m_Chunks[index / kChunkSize].load(std::memory_order_acquire);
+		if (chunk == nullptr)
+		{
+			return nullptr;
+		}
+		const Slot& slot = chunk->slots[index % kChunkSize];
+		if (slot.generation.load(std::memory_order_acquire) != generation)
+		{
+			return nullptr;
+		}
+		const T* value = slot.value.load(std::memory_order_acquire);
+		// 読んでいる間に解放されて別のハンドルに使い回された場合は見なかったことにする
+		if (slot.generation.load(std::memory_order_acquire) != generation)
+		{
+			return nullptr;
+		}
+		return value;
+	}
+
+	size_t GetLiveCount() const { return m_LiveCount; }
+	/// 消すのを待っている値の数
+	size_t GetRetiredCount() const { return m_Retired.size(); }
+	/// 世代を使い切って使わなくなったスロットの数
+	size_t GetExhaustedSlotCount() const { return m_ExhaustedSlotCount; }
+
+	static uint32_t GetIndex(Handle handle) { return handle & (kMaxSlotCount - 1); }
+	static uint32_t GetGeneration(Handle handle) { return handle >> kIndexBits; }
+
+private:
+	static constexpr uint32_t kChunkSize = 1024;
+
+	struct Slot
+	{
+		/// 0 は使わない（ハンドルが 0 にならないように）
+		std::atomic<uint32_t> generation{ 1 };
+		std::atomic<const T*> value{ nullptr };
+	};
+
+	/// スロットはチャンク単位で確保し、移動しない（読み取り側がロック無しで触れるように）
+	struct Chunk
+	{
+		Slot slots[kChunkSize];
+	};
+
+	static Handle MakeHandle(uint32_t index, uint32_t generation) { return (generation << kIndexBits) | index; }
+
+	Slot& GetSlot(uint32_t index) { return m_Chunks[index / kChunkSize].load(std::memory_order_relaxed)->slots[index % kChunkSize]; }
+
+	/// 書き込み側で、今も有効なハンドルのスロットを返します。
+	Slot* FindSlot(Handle handle)
+	{
+		const uint32_t index = GetIndex(handle);
+		if (GetGeneration(handle) == 0 || index >= m_SlotCount)
+		{
+			return nullptr;
+		}
+		Slot& slot = GetSlot(index);
+		return slot.generation.load(std::memory_order_relaxed) == GetGeneration(handle) ? &slot : nullptr;
+	}
+
+	void Retire(const T* value)
+	{
+		if (value != nullptr)
+		{
+			m_Retired.emplace_back(m_Epoch, std::unique_ptr<const T>(value));
+		}
+	}
+
+	std::atomic<Chunk*> m_Chunks[kMaxSlotCount / kChunkSize] = {};
+	uint32_t m_SlotCount = 0;
+	size_t m_LiveCount = 0;
+	size_t m_ExhaustedSlotCount = 0;
+	/// 最も古く空いたスロットから使い回す
+	std::deque<uint32_t> m_FreeIndices;
+	uint64_t m_Epoch = 0;
+	std::deque<std::pair<uint64_t, std::unique_ptr<const T>>> m_Retired;
+};
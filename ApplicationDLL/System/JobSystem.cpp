@@ -0,0 +1,92 @@
+﻿#include "JobSystem.h"
+
+#include <algorithm>
+
+JobSystem& JobSystem::Get()
+{
+	static JobSystem instance;
+	return instance;
+}
+
+JobSystem::JobSystem(size_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		// 描画スレッドの分を 1 つ残す
+		const size_t hardwareThreads = std::thread::hardware_concurrency();
+		workerCount = (std::max)(static_cast<size_t>(1), hardwareThreads > 1 ? hardwareThreads - 1 : 1);
+	}
+
+	m_Workers.reserve(workerCount);
+	for (size_t i = 0; i < workerCount; ++i)
+	{
+		m_Workers.emplace_back(&JobSystem::WorkerMain, this);
+	}
+}
+
+///====================================================================
+/// <summary>
+/// キューに残っているジョブをすべて実行してからワーカーを終了します。
+/// </summary>
+///====================================================================
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_IsStopping = true;
+	}
+	m_JobAvailable.notify_all();
+	for (std::thread& worker : m_Workers)
+	{
+		if (worker.joinable())
+		{
+			worker.join();
+		}
+	}
+}
+
+void JobSystem::WaitIdle()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+	m_Idle.wait(lock, [this]() { return m_Jobs.empty() && m_ActiveJobCount == 0; });
+}
+
+void JobSystem::Enqueue(std::function<void()> job)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Jobs.push_back(std::move(job));
+	}
+	m_JobAvailable.notify_one();
+}
+
+void JobSystem::WorkerMain()
+{
+	for (;;)
+	{
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_JobAvailable.wait(lock, [this]() { return m_IsStopping || !m_Jobs.empty(); });
+			if (m_Jobs.empty())
+			{
+				return;
+			}
+			job = std::move(m_Jobs.front());
+			m_Jobs.pop_front();
+			++m_ActiveJobCount;
+		}
+
+		// 例外は packaged_task が future に格納する
+		job();
+
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			--m_ActiveJobCount;
+			if (m_Jobs.empty() && m_ActiveJobCount == 0)
+			{
+				m_Idle.notify_all();
+			}
+		}
+	}
+}
@@ -0,0 +1,69 @@
+﻿#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+///=======================================================================
+/// <summary>
+/// 固定数のワーカースレッドでジョブを実行するスレッドプール。
+/// Submit は std::future を返すので、結果の待機や例外の受け取りは呼び出し側で行います。
+/// ジョブから D3D12 のコマンドを発行しないでください（GPU 処理は描画スレッドで行います）。
+/// </summary>
+///=======================================================================
+class JobSystem
+{
+public:
+	/// アプリケーション全体で共有するインスタンス（初回呼び出し時にコア数 - 1 本で起動）
+	static JobSystem& Get();
+
+	/// workerCount が 0 の場合はハードウェアスレッド数 - 1（最低 1）
+	explicit JobSystem(size_t workerCount = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	///====================================================================
+	/// <summary>
+	/// ジョブをキューに追加します。
+	/// </summary>
+	/// <param name="function">ワーカースレッドで実行する関数</param>
+	/// <returns>戻り値（または送出された例外）を受け取る future</returns>
+	///====================================================================
+	template <class TFunction>
+	auto Submit(TFunction&& function) -> std::future<std::invoke_result_t<std::decay_t<TFunction>>>
+	{
+		using Result = std::invoke_result_t<std::decay_t<TFunction>>;
+		// std::function はコピー可能な関数しか持てないため shared_ptr で包む
+		auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<TFunction>(function));
+		std::future<Result> future = task->get_future();
+		Enqueue([task]() { (*task)(); });
+		return future;
+	}
+
+	/// キューが空になり、実行中のジョブがすべて終わるまで待機します。
+	void WaitIdle();
+
+	size_t GetWorkerCount() const { return m_Workers.size(); }
+
+private:
+	void Enqueue(std::function<void()> job);
+	void WorkerMain();
+
+	std::vector<std::thread>			m_Workers;
+	std::deque<std::function<void()>>	m_Jobs;
+	std::mutex							m_Mutex;
+	std::condition_variable				m_JobAvailable;
+	std::condition_variable				m_Idle;
+	size_t								m_ActiveJobCount = 0;
+	bool								m_IsStopping = false;
+};
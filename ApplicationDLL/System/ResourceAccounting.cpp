@@ -0,0 +1,457 @@
+﻿#include "ResourceAccounting.h"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstdio>
+
+namespace
+{
+	constexpr size_t kCategoryCount = static_cast<size_t>(ResourceCategory::Count);
+
+	/// CSV の列名に使う名前
+	const char* GetCategoryColumnName(ResourceCategory category)
+	{
+		switch (category)
+		{
+		case ResourceCategory::Texture:
+			return "texture";
+		case ResourceCategory::ConstantBuffer:
+			return "constant_buffer";
+		case ResourceCategory::VertexBuffer:
+			return "vertex_buffer";
+		case ResourceCategory::IndexBuffer:
+			return "index_buffer";
+		case ResourceCategory::UploadBuffer:
+			return "upload_buffer";
+		case ResourceCategory::Descriptor:
+			return "descriptor";
+		default:
+			return "unknown";
+		}
+	}
+
+	void AppendJsonString(std::string& out, const std::string& text)
+	{
+		out += '"';
+		for (const char c : text)
+		{
+			if (c == '"' || c == '\\')
+			{
+				out += '\\';
+				out += c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20)
+			{
+				char escaped[8];
+				std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned int>(c));
+				out += escaped;
+			}
+			else
+			{
+				out += c;
+			}
+		}
+		out += '"';
+	}
+
+	void AppendJsonUsage(std::string& out, const ResourceAccounting::Usage& usage)
+	{
+		char text[160];
+		std::snprintf(text, sizeof(text), "\"count\":%" PRIu64 ",\"requestedBytes\":%" PRIu64 ",\"allocatedBytes\":%" PRIu64,
+			usage.count, usage.requestedBytes, usage.allocatedBytes);
+		out += text;
+	}
+}
+
+const char* ResourceCategoryToString(ResourceCategory category)
+{
+	switch (category)
+	{
+	case ResourceCategory::Texture:
+		return "Texture";
+	case ResourceCategory::ConstantBuffer:
+		return "ConstantBuffer";
+	case ResourceCategory::VertexBuffer:
+		return "VertexBuffer";
+	case ResourceCategory::IndexBuffer:
+		return "IndexBuffer";
+	case ResourceCategory::UploadBuffer:
+		return "UploadBuffer";
+	case ResourceCategory::Descriptor:
+		return "Descriptor";
+	default:
+		return "Unknown";
+	}
+}
+
+ResourceAccounting& ResourceAccounting::Get()
+{
+	static ResourceAccounting instance;
+	return instance;
+}
+
+ResourceAccounting::~ResourceAccounting()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CloseTraceLocked();
+}
+
+ResourceAccounting::AllocationId ResourceAccounting::Track(ResourceCategory category, const char* backend, const char* owner,
+	uint64_t requestedBytes, uint64_t allocatedBytes)
+{
+	if (category >= ResourceCategory::Count)
+	{
+		return 0;
+	}
+
+	Allocation allocation;
+	allocation.category = category;
+	allocation.backend = backend != nullptr ? backend : "";
+	allocation.owner = owner != nullptr ? owner : "";
+	allocation.requestedBytes = requestedBytes;
+	// 確保量が分からない（0）場合は要求どおりとみなす
+	allocation.allocatedBytes = (std::max)(allocatedBytes, requestedBytes);
+
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const AllocationId id = m_NextId++;
+	Accumulate(m_Categories[ToIndex(category)], allocation, 1);
+	Accumulate(m_Owners[OwnerKey(category, allocation.backend, allocation.owner)], allocation, 1);
+	++m_CreatedCounts[ToIndex(category)];
+	m_Allocations.emplace(id, std::move(allocation));
+	return id;
+}
+
+void ResourceAccounting::SetRequestedBytes(AllocationId id, uint64_t requestedBytes)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const auto it = m_Allocations.find(id);
+	if (it == m_Allocations.end())
+	{
+		return;
+	}
+	Allocation& allocation = it->second;
+	Usage& categoryUsage = m_Categories[ToIndex(allocation.category)];
+	Usage& ownerUsage = m_Owners[OwnerKey(allocation.category, allocation.backend, allocation.owner)];
+	categoryUsage.requestedBytes = categoryUsage.requestedBytes - allocation.requestedBytes + requestedBytes;
+	ownerUsage.requestedBytes = ownerUsage.requestedBytes - allocation.requestedBytes + requestedBytes;
+	allocation.requestedBytes = requestedBytes;
+}
+
+void ResourceAccounting::Release(AllocationId id)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	const auto it = m_Allocations.find(id);
+	if (it == m_Allocations.end())
+	{
+		return;
+	}
+	const Allocation& allocation = it->second;
+	Accumulate(m_Categories[ToIndex(allocation.category)], allocation, -1);
+	const auto ownerIt = m_Owners.find(OwnerKey(allocation.category, allocation.backend, allocation.owner));
+	if (ownerIt != m_Owners.end())
+	{
+		Accumulate(ownerIt->second, allocation, -1);
+		if (ownerIt->second.count == 0)
+		{
+			m_Owners.erase(ownerIt);
+		}
+	}
+	++m_ReleasedCounts[ToIndex(allocation.category)];
+	m_Allocations.erase(it);
+}
+
+ResourceAccounting::Usage ResourceAccounting::GetUsage(ResourceCategory category, const char* backend, const char* owner) const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	if (category >= ResourceCategory::Count)
+	{
+		return {};
+	}
+	if (backend == nullptr && owner == nullptr)
+	{
+		return m_Categories[ToIndex(category)];
+	}
+
+	Usage usage;
+	for (const auto& entry : m_Owners)
+	{
+		if (std::get<0>(entry.first) != category ||
+			(backend != nullptr && std::get<1>(entry.first) != backend) ||
+			(owner != nullptr && std::get<2>(entry.first) != owner))
+		{
+			continue;
+		}
+		usage.count += entry.second.count;
+		usage.requestedBytes += entry.second.requestedBytes;
+		usage.allocatedBytes += entry.second.allocatedBytes;
+	}
+	return usage;
+}
+
+ResourceAccounting::Usage ResourceAccounting::GetTotalUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	Usage total;
+	for (const Usage& usage : m_Categories)
+	{
+		total.count += usage.count;
+		total.requestedBytes += usage.requestedBytes;
+		total.allocatedBytes += usage.allocatedBytes;
+	}
+	return total;
+}
+
+std::vector<ResourceAccounting::OwnerUsage> ResourceAccounting::GetOwnerUsage() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return GetOwnerUsageLocked();
+}
+
+ResourceAccounting::FrameSnapshot ResourceAccounting::CaptureFrame()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	++m_FrameIndex;
+	FrameSnapshot snapshot = MakeSnapshotLocked();
+	for (size_t index = 0; index < kCategoryCount; ++index)
+	{
+		m_CreatedCounts[index] = 0;
+		m_ReleasedCounts[index] = 0;
+	}
+
+	m_History.push_back(snapshot);
+	while (m_History.size() > kHistoryCapacity)
+	{
+		m_History.pop_front();
+	}
+	if (m_Trace.is_open())
+	{
+		WriteTraceLocked(snapshot);
+	}
+	return snapshot;
+}
+
+ResourceAccounting::FrameSnapshot ResourceAccounting::GetLatestFrame() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_History.empty() ? FrameSnapshot() : m_History.back();
+}
+
+std::vector<ResourceAccounting::FrameSnapshot> ResourceAccounting::GetHistory() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return std::vector<FrameSnapshot>(m_History.begin(), m_History.end());
+}
+
+bool ResourceAccounting::StartTrace(const std::filesystem::path& path)
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CloseTraceLocked();
+	m_Trace.open(path, std::ios::out | std::ios::trunc | std::ios::binary);
+	if (!m_Trace.is_open())
+	{
+		return false;
+	}
+	m_IsJsonTrace = path.extension() == ".json";
+	m_HasTraceRows = false;
+	m_Trace << (m_IsJsonTrace ? std::string("[\n") : FormatCsvHeader());
+	return true;
+}
+
+void ResourceAccounting::StopTrace()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	CloseTraceLocked();
+}
+
+bool ResourceAccounting::IsTracing() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	return m_Trace.is_open();
+}
+
+std::string ResourceAccounting::FormatCsvHeader()
+{
+	std::string header = "frame";
+	for (size_t index = 0; index < kCategoryCount; ++index)
+	{
+		const std::string name = GetCategoryColumnName(static_cast<ResourceCategory>(index));
+		header += "," + name + "_count," + name + "_requested_bytes," + name + "_allocated_bytes," +
+			name + "_created," + name + "_released";
+	}
+	header += ",total_count,total_requested_bytes,total_allocated_bytes\n";
+	return header;
+}
+
+std::string ResourceAccounting::FormatCsvRow(const FrameSnapshot& snapshot)
+{
+	char text[160];
+	std::snprintf(text, sizeof(text), "%" PRIu64, snapshot.frameIndex);
+	std::string row = text;
+	for (const CategoryFrame& category : snapshot.categories)
+	{
+		std::snprintf(text, sizeof(text), ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+			category.usage.count, category.usage.requestedBytes, category.usage.allocatedBytes,
+			category.createdCount, category.releasedCount);
+		row += text;
+	}
+	std::snprintf(text, sizeof(text), ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+		snapshot.total.count, snapshot.total.requestedBytes, snapshot.total.allocatedBytes);
+	row += text;
+	return row;
+}
+
+std::string ResourceAccounting::FormatJson(const FrameSnapshot& snapshot)
+{
+	char text[96];
+	std::snprintf(text, sizeof(text), "{\"frame\":%" PRIu64 ",\"total\":{", snapshot.frameIndex);
+	std::string json = text;
+	AppendJsonUsage(json, snapshot.total);
+	json += "},\"categories\":[";
+	for (size_t index = 0; index < kCategoryCount; ++index)
+	{
+		const CategoryFrame& category = snapshot.categories[index];
+		json += index == 0 ? "{\"name\":" : ",{\"name\":";
+		AppendJsonString(json, ResourceCategoryToString(static_cast<ResourceCategory>(index)));
+		json += ',';
+		AppendJsonUsage(json, category.usage);
+		std::snprintf(text, sizeof(text), ",\"created\":%" PRIu64 ",\"released\":%" PRIu64 "}",
+			category.createdCount, category.releasedCount);
+		json += text;
+	}
+	json += "],\"owners\":[";
+	for (size_t index = 0; index < snapshot.owners.size(); ++index)
+	{
+		const OwnerUsage& owner = snapshot.owners[index];
+		json += index == 0 ? "{\"category\":" : ",{\"category\":";
+		AppendJsonString(json, ResourceCategoryToString(owner.category));
+		json += ",\"backend\":";
+		AppendJsonString(json, owner.backend);
+		json += ",\"owner\":";
+		AppendJsonString(json, owner.owner);
+		json += ',';
+		AppendJsonUsage(json, owner.usage);
+		json += '}';
+	}
+	json += "]}";
+	return json;
+}
+
+std::string ResourceAccounting::FormatReport() const
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	std::string report = "ResourceAccounting:";
+	char line[256];
+	for (size_t index = 0; index < kCategoryCount; ++index)
+	{
+		const Usage& usage = m_Categories[index];
+		std::snprintf(line, sizeof(line), "\n  %-15s count=%" PRIu64 " requested=%.2fMB allocated=%.2fMB",
+			ResourceCategoryToString(static_cast<ResourceCategory>(index)), usage.count,
+			static_cast<double>(usage.requestedBytes) / (1024.0 * 1024.0),
+			static_cast<double>(usage.allocatedBytes) / (1024.0 * 1024.0));
+		report += line;
+	}
+	for (const OwnerUsage& owner : GetOwnerUsageLocked())
+	{
+		std::snprintf(line, sizeof(line), "\n  [%s/%s] %s count=%" PRIu64 " requested=%" PRIu64 " allocated=%" PRIu64,
+			owner.backend.c_str(), ResourceCategoryToString(owner.category), owner.owner.c_str(),
+			owner.usage.count, owner.usage.requestedBytes, owner.usage.allocatedBytes);
+		report += line;
+	}
+	return report;
+}
+
+void ResourceAccounting::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_Mutex);
+	m_Allocations.clear();
+	m_NextId = 1;
+	m_Owners.clear();
+	m_History.clear();
+	m_FrameIndex = 0;
+	for (size_t index = 0; index < kCategoryCount; ++index)
+	{
+		m_Categories[index] = Usage();
+		m_CreatedCounts[index] = 0;
+		m_ReleasedCounts[index] = 0;
+	}
+}
+
+void ResourceAccounting::Accumulate(Usage& usage, const Allocation& allocation, int sign)
+{
+	if (sign > 0)
+	{
+		++usage.count;
+		usage.requestedBytes += allocation.requestedBytes;
+		usage.allocatedBytes += allocation.allocatedBytes;
+		return;
+	}
+	--usage.count;
+	usage.requestedBytes -= allocation.requestedBytes;
+	usage.allocatedBytes -= allocation.allocatedBytes;
+}
+
+ResourceAccounting::FrameSnapshot ResourceAccounting::MakeSnapshotLocked() const
+{
+	FrameSnapshot snapshot;
+	snapshot.frameIndex = m_FrameIndex;
+	for (size_t index = 0; index < kCategoryCount; ++index)
+	{
+		CategoryFrame& category = snapshot.categories[index];
+		category.usage = m_Categories[index];
+		category.createdCount = m_CreatedCounts[index];
+		category.releasedCount = m_ReleasedCounts[index];
+		snapshot.total.count += category.usage.count;
+		snapshot.total.requestedBytes += category.usage.requestedBytes;
+		snapshot.total.allocatedBytes += category.usage.allocatedBytes;
+	}
+	snapshot.owners = GetOwnerUsageLocked();
+	return snapshot;
+}
+
+std::vector<ResourceAccounting::OwnerUsage> ResourceAccounting::GetOwnerUsageLocked() const
+{
+	std::vector<OwnerUsage> owners;
+	owners.reserve(m_Owners.size());
+	for (const auto& entry : m_Owners)
+	{
+		OwnerUsage owner;
+		owner.category = std::get<0>(entry.first);
+		owner.backend = std::get<1>(entry.first);
+		owner.owner = std::get<2>(entry.first);
+		owner.usage = entry.second;
+		owners.push_back(std::move(owner));
+	}
+	// 同じ量なら map の順（分類・バックエンド・持ち主）のまま
+	std::stable_sort(owners.begin(), owners.end(), [](const OwnerUsage& a, const OwnerUsage& b)
+	{
+		return a.usage.allocatedBytes > b.usage.allocatedBytes;
+	});
+	return owners;
+}
+
+void ResourceAccounting::WriteTraceLocked(const FrameSnapshot& snapshot)
+{
+	if (!m_IsJsonTrace)
+	{
+		m_Trace << FormatCsvRow(snapshot);
+	}
+	else
+	{
+		m_Trace << (m_HasTraceRows ? ",\n" : "") << FormatJson(snapshot);
+	}
+	m_HasTraceRows = true;
+	m_Trace.flush();
+}
+
+void ResourceAccounting::CloseTraceLocked()
+{
+	if (!m_Trace.is_open())
+	{
+		return;
+	}
+	if (m_IsJsonTrace)
+	{
+		m_Trace << (m_HasTraceRows ? "\n]\n" : "]\n");
+	}
+	m_Trace.close();
+}
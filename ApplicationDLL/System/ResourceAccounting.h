@@ -0,0 +1,239 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+/// メモリを数える分類
+enum class ResourceCategory : uint32_t
+{
+	Texture = 0,
+	ConstantBuffer,
+	VertexBuffer,
+	IndexBuffer,
+	/// 転送用のステージングバッファ
+	UploadBuffer,
+	Descriptor,
+	Count,
+};
+
+const char* ResourceCategoryToString(ResourceCategory category);
+
+///=======================================================================
+/// <summary>
+/// GPU リソースのメモリを分類・バックエンド・持ち主ごとに数えるサービス。
+/// リソースを作る箇所が Track で報告し、破棄するときに Release します（TrackedAllocation なら自動）。
+/// 要求したバイト数（データの大きさ）と実際に確保されたバイト数を別々に持つので、
+/// 小さなバッファを 1 つずつコミット済みリソースにしたときの無駄が差として見えます。
+/// CaptureFrame をフレームの終わりに呼ぶとその時点の集計を履歴に残し、トレースを開いていれば書き出します。
+/// GPU には触れないので、どのスレッドから呼んでも構いません。
+/// </summary>
+///=======================================================================
+class ResourceAccounting
+{
+public:
+	/// Track が返す番号（0 は無効）
+	using AllocationId = uint64_t;
+
+	/// 残しておくフレームの数
+	static constexpr size_t kHistoryCapacity = 600;
+
+	struct Usage
+	{
+		uint64_t count = 0;
+		uint64_t requestedBytes = 0;
+		uint64_t allocatedBytes = 0;
+	};
+
+	struct OwnerUsage
+	{
+		ResourceCategory category = ResourceCategory::Texture;
+		std::string backend;
+		std::string owner;
+		Usage usage;
+	};
+
+	struct CategoryFrame
+	{
+		Usage usage;
+		/// このフレームで作られた・破棄された数
+		uint64_t createdCount = 0;
+		uint64_t releasedCount = 0;
+	};
+
+	struct FrameSnapshot
+	{
+		uint64_t frameIndex = 0;
+		CategoryFrame categories[static_cast<size_t>(ResourceCategory::Count)];
+		Usage total;
+		/// 確保したバイト数の多い順
+		std::vector<OwnerUsage> owners;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// 破棄で自動的に Release する報告。リソースと同じクラスのメンバーに持たせます。
+	/// </summary>
+	///====================================================================
+	class TrackedAllocation
+	{
+	public:
+		TrackedAllocation() = default;
+		TrackedAllocation(ResourceAccounting* accounting, AllocationId id) : m_pAccounting(accounting), m_Id(id) {}
+		~TrackedAllocation() { Reset(); }
+
+		TrackedAllocation(const TrackedAllocation&) = delete;
+		TrackedAllocation& operator=(const TrackedAllocation&) = delete;
+		TrackedAllocation(TrackedAllocation&& other) noexcept : m_pAccounting(other.m_pAccounting), m_Id(other.m_Id)
+		{
+			other.m_pAccounting = nullptr;
+			other.m_Id = 0;
+		}
+		TrackedAllocation& operator=(TrackedAllocation&& other) noexcept
+		{
+			if (this != &other)
+			{
+				Reset();
+				m_pAccounting = other.m_pAccounting;
+				m_Id = other.m_Id;
+				other.m_pAccounting = nullptr;
+				other.m_Id = 0;
+			}
+			return *this;
+		}
+
+		void Reset()
+		{
+			if (m_pAccounting != nullptr && m_Id != 0)
+			{
+				m_pAccounting->Release(m_Id);
+			}
+			m_pAccounting = nullptr;
+			m_Id = 0;
+		}
+
+		/// 使っている量が変わる場合（ディスクリプタヒープの使用数など）
+		void SetRequestedBytes(uint64_t requestedBytes)
+		{
+			if (m_pAccounting != nullptr)
+			{
+				m_pAccounting->SetRequestedBytes(m_Id, requestedBytes);
+			}
+		}
+
+		bool IsValid() const { return m_Id != 0; }
+		AllocationId GetId() const { return m_Id; }
+
+	private:
+		ResourceAccounting* m_pAccounting = nullptr;
+		AllocationId m_Id = 0;
+	};
+
+	/// アプリケーション全体で共有するインスタンス
+	static ResourceAccounting& Get();
+
+	ResourceAccounting() = default;
+	~ResourceAccounting();
+
+	ResourceAccounting(const ResourceAccounting&) = delete;
+	ResourceAccounting& operator=(const ResourceAccounting&) = delete;
+
+	///====================================================================
+	/// <summary>
+	/// 作成したリソースを報告します。
+	/// </summary>
+	/// <param name="backend">RendererBackendToString の名前など</param>
+	/// <param name="owner">作成したクラスなど、集計の単位にする名前</param>
+	/// <param name="requestedBytes">データとして必要なバイト数</param>
+	/// <param name="allocatedBytes">アラインメントなどを含めて実際に確保されたバイト数</param>
+	/// <returns>Release に渡す番号</returns>
+	///====================================================================
+	AllocationId Track(ResourceCategory category, const char* backend, const char* owner, uint64_t requestedBytes, uint64_t allocatedBytes);
+	TrackedAllocation TrackScoped(ResourceCategory category, const char* backend, const char* owner, uint64_t requestedBytes, uint64_t allocatedBytes)
+	{
+		return TrackedAllocation(this, Track(category, backend, owner, requestedBytes, allocatedBytes));
+	}
+	void SetRequestedBytes(AllocationId id, uint64_t requestedBytes);
+	void Release(AllocationId id);
+
+	/// 分類ごとの現在の合計（backend / owner が null なら絞り込まない）
+	Usage GetUsage(ResourceCategory category, const char* backend = nullptr, const char* owner = nullptr) const;
+	Usage GetTotalUsage() const;
+	/// 持ち主ごとの現在の合計（確保したバイト数の多い順）
+	std::vector<OwnerUsage> GetOwnerUsage() const;
+
+	///====================================================================
+	/// <summary>
+	/// フレームの終わりに 1 度呼び、現在の集計を履歴に残します。トレースを開いていれば 1 フレーム分を書き出します。
+	/// </summary>
+	///====================================================================
+	FrameSnapshot CaptureFrame();
+	/// 最後に CaptureFrame した集計（まだ無ければ空）
+	FrameSnapshot GetLatestFrame() const;
+	/// 古い順（最大 kHistoryCapacity フレーム）
+	std::vector<FrameSnapshot> GetHistory() const;
+
+	///====================================================================
+	/// <summary>
+	/// 以降の CaptureFrame を path に書き出します。拡張子が .json なら JSON の配列、それ以外は CSV です。
+	/// </summary>
+	/// <returns>ファイルを開けなかった場合は false</returns>
+	///====================================================================
+	bool StartTrace(const std::filesystem::path& path);
+	void StopTrace();
+	bool IsTracing() const;
+
+	static std::string FormatCsvHeader();
+	/// FormatCsvHeader に対応する 1 フレーム分の行（改行付き）
+	static std::string FormatCsvRow(const FrameSnapshot& snapshot);
+	/// 1 フレーム分の JSON オブジェクト（改行なし）
+	static std::string FormatJson(const FrameSnapshot& snapshot);
+	/// ログに出すための現在の集計
+	std::string FormatReport() const;
+
+	/// 報告・履歴・フレーム番号をすべて捨てます（トレースは閉じません）。
+	void Clear();
+
+private:
+	struct Allocation
+	{
+		ResourceCategory category = ResourceCategory::Texture;
+		std::string backend;
+		std::string owner;
+		uint64_t requestedBytes = 0;
+		uint64_t allocatedBytes = 0;
+	};
+
+	using OwnerKey = std::tuple<ResourceCategory, std::string, std::string>;
+
+	static size_t ToIndex(ResourceCategory category) { return static_cast<size_t>(category); }
+	/// usage に allocation を足す（sign が -1 なら引く）
+	static void Accumulate(Usage& usage, const Allocation& allocation, int sign);
+	FrameSnapshot MakeSnapshotLocked() const;
+	std::vector<OwnerUsage> GetOwnerUsageLocked() const;
+	void WriteTraceLocked(const FrameSnapshot& snapshot);
+	void CloseTraceLocked();
+
+	mutable std::mutex m_Mutex;
+	std::unordered_map<AllocationId, Allocation> m_Allocations;
+	AllocationId m_NextId = 1;
+	Usage m_Categories[static_cast<size_t>(ResourceCategory::Count)];
+	std::map<OwnerKey, Usage> m_Owners;
+
+	uint64_t m_FrameIndex = 0;
+	uint64_t m_CreatedCounts[static_cast<size_t>(ResourceCategory::Count)] = {};
+	uint64_t m_ReleasedCounts[static_cast<size_t>(ResourceCategory::Count)] = {};
+	std::deque<FrameSnapshot> m_History;
+
+	std::ofstream m_Trace;
+	bool m_IsJsonTrace = false;
+	bool m_HasTraceRows = false;
+};
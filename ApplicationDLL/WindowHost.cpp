@@ -3,6 +3,8 @@
 #include "AppRuntime.h"
 #include "FrameLoop.h"
 
+#include "RHI/TextureAssetManager.h"
+#include "Renderer/MeshImporter.h"
 #include "SceneManager.h"
 #include "Source/Dx12RenderDevice.h"
 #include "Source/EditorUi.h"
@@ -47,6 +49,9 @@ namespace
         EditorUi::Shutdown();
         RuntimeStateRef().g_imguiInitialized = false;
 
+        // 転送待ちのメッシュはデバイスと一緒に破棄する
+        MeshImporter::Get().Clear();
+
         if (RuntimeStateRef().g_renderDevice != nullptr)
         {
             RuntimeStateRef().g_renderDevice->Shutdown();
@@ -78,6 +83,12 @@ namespace
             ConfigureD3D12DebugFilters();
         }
 
+        // デバイスを作り直すと Shutdown で止まるので、エディターが有効にしていればここで付け直す
+        if (RuntimeStateRef().g_textureHotReloadEnabled)
+        {
+            TextureAssetManager::Get().SetHotReloadEnabled(true);
+        }
+
         if (RuntimeStateRef().g_editorUiEnabled && RuntimeStateRef().g_renderDevice->SupportsEditorUi())
         {
             RuntimeStateRef().g_imguiInitialized = InitializeImGui();
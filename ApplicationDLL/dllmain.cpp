@@ -67,6 +67,11 @@ extern "C" __declspec(dllexport) BOOL IsEditorUiEnabled()
     return Runtime().IsEditorUiEnabled();
 }
 
+extern "C" __declspec(dllexport) void SetTextureHotReloadEnabled(BOOL enabled)
+{
+    Runtime().SetTextureHotReloadEnabled(enabled);
+}
+
 extern "C" __declspec(dllexport) void SetStandaloneMode(BOOL enabled)
 {
     Runtime().GetPlayInEditor().SetStandaloneMode(enabled);
@@ -196,3 +201,13 @@ extern "C" __declspec(dllexport) const char* GetRuntimeLastErrorText()
 {
     return Runtime().GetRuntimeLastErrorText();
 }
+
+extern "C" __declspec(dllexport) const char* GetResourceMemoryReport()
+{
+    return Runtime().GetResourceMemoryReport();
+}
+
+extern "C" __declspec(dllexport) BOOL SetResourceMemoryTracePath(const char* tracePath)
+{
+    return Runtime().SetResourceMemoryTracePath(tracePath);
+}
@@ -11,9 +11,11 @@
 #include <QDoubleSpinBox>
 #include <QDragEnterEvent>
 #include <QDropEvent>
+#include <QFileDialog>
 #include <QGroupBox>
 #include <QHideEvent>
 #include <QHBoxLayout>
+#include <QJsonDocument>
 #include <QLabel>
 #include <QMenu>
 #include <QMenuBar>
@@ -331,6 +333,12 @@ MainWindow::MainWindow(QWidget* parent)
         updateStatus();
     });
 
+    // GPU メモリの集計は JSON を作り直すので、毎フレームではなく 1 秒ごとに、パネルが見えているときだけ読む
+    memoryTimer_ = new QTimer(this);
+    memoryTimer_->setInterval(1000);
+    connect(memoryTimer_, &QTimer::timeout, this, &MainWindow::refreshMemoryReport);
+    memoryTimer_->start();
+
     populateWorkspace();
     updateStatus();
 }
@@ -359,6 +367,8 @@ bool MainWindow::initialize(RuntimeBridge* runtime, const QString& baseDir)
 
     sceneRuntime_->setStandaloneMode(false);
     sceneRuntime_->setEditorUiEnabled(false);
+    // エディターで Assets/Texture の画像を保存すると、PIE を止めずにテクスチャが差し替わる
+    sceneRuntime_->setTextureHotReloadEnabled(true);
     const bool sceneWindowCreated = embedNativeViewports_
         ? sceneRuntime_->createNativeWindowInParent(
             reinterpret_cast<HWND>(sceneViewportHost_->winId()),
@@ -409,6 +419,10 @@ void MainWindow::closeEvent(QCloseEvent* event)
     {
         tickTimer_->stop();
     }
+    if (memoryTimer_ != nullptr)
+    {
+        memoryTimer_->stop();
+    }
 
     if (dockManager_ != nullptr)
     {
@@ -565,6 +579,9 @@ void MainWindow::buildUi()
     contentList_ = new AssetBrowserListWidget(this);
     logView_ = new QPlainTextEdit(this);
     logView_->setReadOnly(true);
+    memoryView_ = new QPlainTextEdit(this);
+    memoryView_->setReadOnly(true);
+    memoryView_->setLineWrapMode(QPlainTextEdit::NoWrap);
 
     sceneViewportDock_ = createDockWidget(QStringLiteral("Scene"), QStringLiteral("SceneViewportDock"), sceneViewportHost_, QSize(900, 620));
     gameViewportDock_ = createDockWidget(QStringLiteral("Game"), QStringLiteral("GameViewportDock"), gameViewportHost_, QSize(900, 620));
@@ -573,6 +590,7 @@ void MainWindow::buildUi()
     detailsDock_ = createDockWidget(QStringLiteral("Details"), QStringLiteral("DetailsDock"), detailsPanel, QSize(360, 560));
     contentDock_ = createDockWidget(QStringLiteral("Content Browser"), QStringLiteral("ContentBrowserDock"), contentList_, QSize(520, 260));
     logDock_ = createDockWidget(QStringLiteral("Log"), QStringLiteral("LogDock"), logView_, QSize(520, 260));
+    memoryDock_ = createDockWidget(QStringLiteral("GPU Memory"), QStringLiteral("GpuMemoryDock"), memoryView_, QSize(520, 260));
 
     ads::CDockAreaWidget* viewportArea = dockManager_->addDockWidget(ads::CenterDockWidgetArea, sceneViewportDock_);
     dockManager_->addDockWidgetTabToArea(gameViewportDock_, viewportArea);
@@ -580,7 +598,8 @@ void MainWindow::buildUi()
     dockManager_->addDockWidget(ads::LeftDockWidgetArea, outlinerDock_, viewportArea);
     dockManager_->addDockWidget(ads::RightDockWidgetArea, detailsDock_, viewportArea);
     ads::CDockAreaWidget* contentArea = dockManager_->addDockWidget(ads::BottomDockWidgetArea, contentDock_, viewportArea);
-    dockManager_->addDockWidget(ads::BottomDockWidgetArea, logDock_, contentArea);
+    ads::CDockAreaWidget* logArea = dockManager_->addDockWidget(ads::BottomDockWidgetArea, logDock_, contentArea);
+    dockManager_->addDockWidgetTabToArea(memoryDock_, logArea);
 
     restoreLayout();
 }
@@ -597,6 +616,11 @@ void MainWindow::buildMenu()
     playAction_ = playMenu->addAction(QStringLiteral("Start PIE"));
     stopAction_ = playMenu->addAction(QStringLiteral("Stop PIE"));
 
+    QMenu* profileMenu = menuBar()->addMenu(QStringLiteral("P&rofile"));
+    startMemoryTraceAction_ = profileMenu->addAction(QStringLiteral("Start GPU Memory Trace..."), this, &MainWindow::startMemoryTrace);
+    stopMemoryTraceAction_ = profileMenu->addAction(QStringLiteral("Stop GPU Memory Trace"), this, &MainWindow::stopMemoryTrace);
+    stopMemoryTraceAction_->setEnabled(false);
+
     QMenu* windowMenu = menuBar()->addMenu(QStringLiteral("&Window"));
     windowMenu->addAction(toolsDock_->toggleViewAction());
     windowMenu->addAction(sceneViewportDock_->toggleViewAction());
@@ -605,6 +629,7 @@ void MainWindow::buildMenu()
     windowMenu->addAction(detailsDock_->toggleViewAction());
     windowMenu->addAction(contentDock_->toggleViewAction());
     windowMenu->addAction(logDock_->toggleViewAction());
+    windowMenu->addAction(memoryDock_->toggleViewAction());
 
     QMenu* autoHideMenu = menuBar()->addMenu(QStringLiteral("&Auto Hide"));
     auto addAutoHideAction = [this, autoHideMenu](const QString& title, ads::CDockWidget* dock, ads::SideBarLocation side)
@@ -633,6 +658,7 @@ void MainWindow::buildMenu()
     addAutoHideAction(QStringLiteral("Details"), detailsDock_, ads::SideBarRight);
     addAutoHideAction(QStringLiteral("Content Browser"), contentDock_, ads::SideBarBottom);
     addAutoHideAction(QStringLiteral("Log"), logDock_, ads::SideBarBottom);
+    addAutoHideAction(QStringLiteral("GPU Memory"), memoryDock_, ads::SideBarBottom);
 }
 
 void MainWindow::connectSignals()
@@ -1015,6 +1041,59 @@ void MainWindow::updateStatus()
         .arg(worldActors_.size()));
 }
 
+void MainWindow::refreshMemoryReport()
+{
+    if (sceneRuntime_ == nullptr || memoryView_ == nullptr || memoryDock_->isClosed() || !memoryView_->isVisible())
+    {
+        return;
+    }
+
+    // ランタイムの JSON は 1 行なので、読めるように整形して表示する
+    const QString report = sceneRuntime_->resourceMemoryReport();
+    const QJsonDocument document = QJsonDocument::fromJson(report.toUtf8());
+    const QString text = document.isNull() ? report : QString::fromUtf8(document.toJson(QJsonDocument::Indented));
+    if (memoryView_->toPlainText() != text)
+    {
+        memoryView_->setPlainText(text);
+    }
+}
+
+void MainWindow::startMemoryTrace()
+{
+    if (sceneRuntime_ == nullptr)
+    {
+        return;
+    }
+
+    const QString tracePath = QFileDialog::getSaveFileName(this, QStringLiteral("GPU Memory Trace"), QStringLiteral("ResourceMemory.csv"),
+        QStringLiteral("CSV (*.csv);;JSON (*.json)"));
+    if (tracePath.isEmpty())
+    {
+        return;
+    }
+    if (!sceneRuntime_->setResourceMemoryTracePath(tracePath))
+    {
+        appendLogMessage(QStringLiteral("Failed to open GPU memory trace: %1").arg(tracePath), true);
+        return;
+    }
+    startMemoryTraceAction_->setEnabled(false);
+    stopMemoryTraceAction_->setEnabled(true);
+    appendLogMessage(QStringLiteral("GPU memory trace started: %1").arg(tracePath));
+}
+
+void MainWindow::stopMemoryTrace()
+{
+    if (sceneRuntime_ == nullptr)
+    {
+        return;
+    }
+
+    sceneRuntime_->setResourceMemoryTracePath(QString());
+    startMemoryTraceAction_->setEnabled(true);
+    stopMemoryTraceAction_->setEnabled(false);
+    appendLogMessage(QStringLiteral("GPU memory trace stopped."));
+}
+
 void MainWindow::attachSceneViewport()
 {
     if (!embedNativeViewports_)
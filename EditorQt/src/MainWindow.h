@@ -114,6 +114,9 @@ private:
     int selectedActorIndex() const;
     QString makeSpawnActorName(const QString& assetPath);
     void updateStatus();
+    void refreshMemoryReport();
+    void startMemoryTrace();
+    void stopMemoryTrace();
     void attachSceneViewport();
     void detachSceneViewport();
     void attachGameViewport();
@@ -146,10 +149,12 @@ private:
     ads::CDockWidget* detailsDock_ = nullptr;
     ads::CDockWidget* contentDock_ = nullptr;
     ads::CDockWidget* logDock_ = nullptr;
+    ads::CDockWidget* memoryDock_ = nullptr;
 
     QListWidget* outlinerList_ = nullptr;
     AssetBrowserListWidget* contentList_ = nullptr;
     QPlainTextEdit* logView_ = nullptr;
+    QPlainTextEdit* memoryView_ = nullptr;
     QLabel* detailsHeaderLabel_ = nullptr;
     QLabel* detailsSourceLabel_ = nullptr;
     QDoubleSpinBox* locationSpin_[3] = {};
@@ -163,7 +168,10 @@ private:
     QPushButton* playButton_ = nullptr;
     QPushButton* stopButton_ = nullptr;
     QTimer* tickTimer_ = nullptr;
+    QTimer* memoryTimer_ = nullptr;
 
     QAction* playAction_ = nullptr;
     QAction* stopAction_ = nullptr;
+    QAction* startMemoryTraceAction_ = nullptr;
+    QAction* stopMemoryTraceAction_ = nullptr;
 };
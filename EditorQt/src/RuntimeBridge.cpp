@@ -99,6 +99,10 @@ bool RuntimeBridge::Load(const QString& baseDir, const QString& instanceTag)
     ok = resolve(createGameNativeChildWindow_, "CreateGameNativeChildWindow") && ok;
     ok = resolve(destroyGameNativeWindow_, "DestroyGameNativeWindow") && ok;
     ok = resolve(getGameNativeWindowHandle_, "GetGameNativeWindowHandle") && ok;
+    // GPU メモリの集計は古いランタイムには無いので、無くても読み込みは続ける
+    getResourceMemoryReport_ = reinterpret_cast<GetTextFn>(GetProcAddress(module_, "GetResourceMemoryReport"));
+    setResourceMemoryTracePath_ = reinterpret_cast<SetTextFn>(GetProcAddress(module_, "SetResourceMemoryTracePath"));
+    setTextureHotReloadEnabled_ = reinterpret_cast<SetBoolFn>(GetProcAddress(module_, "SetTextureHotReloadEnabled"));
 
     if (!ok)
     {
@@ -404,6 +408,18 @@ void RuntimeBridge::setEditorUiEnabled(bool enabled)
 #endif
 }
 
+void RuntimeBridge::setTextureHotReloadEnabled(bool enabled)
+{
+#ifdef _WIN32
+    if (setTextureHotReloadEnabled_ != nullptr)
+    {
+        setTextureHotReloadEnabled_(enabled ? TRUE : FALSE);
+    }
+#else
+    Q_UNUSED(enabled);
+#endif
+}
+
 bool RuntimeBridge::setRendererBackend(RendererBackend backend)
 {
 #ifdef _WIN32
@@ -445,6 +461,31 @@ QString RuntimeBridge::runtimeLastError() const
 #endif
 }
 
+QString RuntimeBridge::resourceMemoryReport() const
+{
+#ifdef _WIN32
+    return fromUtf8(getResourceMemoryReport_ != nullptr ? getResourceMemoryReport_() : "");
+#else
+    return QString();
+#endif
+}
+
+bool RuntimeBridge::setResourceMemoryTracePath(const QString& tracePath)
+{
+#ifdef _WIN32
+    if (setResourceMemoryTracePath_ == nullptr)
+    {
+        setLastError(QStringLiteral("Runtime does not export SetResourceMemoryTracePath."));
+        return false;
+    }
+    const QByteArray utf8Path = tracePath.toUtf8();
+    return setResourceMemoryTracePath_(utf8Path.constData()) != FALSE;
+#else
+    Q_UNUSED(tracePath);
+    return false;
+#endif
+}
+
 QString RuntimeBridge::lastBridgeError() const
 {
     return lastError_;
@@ -538,6 +579,9 @@ void RuntimeBridge::Unload()
     createGameNativeWindow_ = nullptr;
     destroyGameNativeWindow_ = nullptr;
     getGameNativeWindowHandle_ = nullptr;
+    getResourceMemoryReport_ = nullptr;
+    setResourceMemoryTracePath_ = nullptr;
+    setTextureHotReloadEnabled_ = nullptr;
 
     loadedModulePath_.clear();
     if (!copiedModulePath_.isEmpty())
@@ -53,11 +53,16 @@ public:
     void getGameViewportCamera(float& centerX, float& centerY, float& zoom) const;
 
     void setEditorUiEnabled(bool enabled);
+    // Assets/Texture の画像を保存したときの差し替え。ランタイムが対応していなければ何もしない
+    void setTextureHotReloadEnabled(bool enabled);
     bool setRendererBackend(RendererBackend backend);
     RendererBackend rendererBackend() const;
 
     QString runtimeStatus() const;
     QString runtimeLastError() const;
+    // 最後のフレームの GPU メモリの集計（JSON）。ランタイムが対応していなければ空
+    QString resourceMemoryReport() const;
+    bool setResourceMemoryTracePath(const QString& tracePath);
     QString lastBridgeError() const;
 
     HWND nativeWindowHandle() const;
@@ -88,6 +93,7 @@ private:
     using SetRendererBackendFn = BOOL(__cdecl*)(unsigned int);
     using GetRendererBackendFn = unsigned int(__cdecl*)();
     using GetTextFn = const char*(__cdecl*)();
+    using SetTextFn = BOOL(__cdecl*)(const char*);
     using GetHwndFn = HWND(__cdecl*)();
 
     HMODULE module_ = nullptr;
@@ -100,6 +106,7 @@ private:
     VoidFn startPie_ = nullptr;
     VoidFn stopPie_ = nullptr;
     SetBoolFn setEditorUiEnabled_ = nullptr;
+    SetBoolFn setTextureHotReloadEnabled_ = nullptr;
     SetBoolFn setStandaloneMode_ = nullptr;
     SetViewportCameraFn setSceneViewportCamera_ = nullptr;
     GetViewportCameraFn getSceneViewportCamera_ = nullptr;
@@ -117,6 +124,8 @@ private:
     CreateNativeChildWindowFn createGameNativeChildWindow_ = nullptr;
     VoidFn destroyGameNativeWindow_ = nullptr;
     GetHwndFn getGameNativeWindowHandle_ = nullptr;
+    GetTextFn getResourceMemoryReport_ = nullptr;
+    SetTextFn setResourceMemoryTracePath_ = nullptr;
 #endif
     QString lastError_;
     QString loadedModulePath_;
@@ -0,0 +1,360 @@
+﻿///=======================================================================
+/// MeshCooker
+///   PMD をクック済みメッシュ（.pmdc）に変換するコマンドラインツール。
+///
+///   MeshCooker [--bench] [--bench-import] [-o <出力ディレクトリ>] <入力 .pmd またはディレクトリ>...
+///
+///   --bench        : 変換後に生 PMD とクック済みメッシュの読み込み時間（ファイルキャッシュから追い出した
+///                    コールドと、キャッシュに載ったウォーム）とサイズを比較します。
+///   --bench-import : 変換は行わず、全入力の CPU 側読み込み（MeshImport）を
+///                    逐次実行した場合と JobSystem で並列実行した場合の時間を比較します。
+///   -o             : 出力先。省略時は入力ファイルと同じディレクトリに出力します。
+///=======================================================================
+#include "Analyzer/CookedMeshFile.h"
+#include "Analyzer/MeshCooker.h"
+#include "Analyzer/MeshImport.h"
+#include "Analyzer/PMDMappedReader.h"
+#include "System/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace
+{
+	struct Options
+	{
+		bool runBenchmark = false;
+		bool runImportBenchmark = false;
+		std::filesystem::path outputDirectory;
+		std::vector<std::filesystem::path> inputs;
+	};
+
+	constexpr int kBenchmarkIterations = 20;
+	/// コールドの計測は 1 回ごとにファイルを読み直すので回数を減らす
+	constexpr int kColdBenchmarkIterations = 5;
+
+	std::string ToDisplayString(const std::filesystem::path& path)
+	{
+		return path.u8string();
+	}
+
+	bool IsPmdFile(const std::filesystem::path& path)
+	{
+		std::wstring extension = path.extension().wstring();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c)
+		{
+			return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+		});
+		return extension == L".pmd";
+	}
+
+	bool ParseArguments(const std::vector<std::filesystem::path>& args, Options& outOptions)
+	{
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			const std::filesystem::path& arg = args[i];
+			if (arg == "--bench")
+			{
+				outOptions.runBenchmark = true;
+			}
+			else if (arg == "--bench-import")
+			{
+				outOptions.runImportBenchmark = true;
+			}
+			else if (arg == "-o")
+			{
+				if (i + 1 >= args.size())
+				{
+					return false;
+				}
+				outOptions.outputDirectory = args[++i];
+			}
+			else if (std::filesystem::is_directory(arg))
+			{
+				for (const auto& entry : std::filesystem::directory_iterator(arg))
+				{
+					if (entry.is_regular_file() && IsPmdFile(entry.path()))
+					{
+						outOptions.inputs.push_back(entry.path());
+					}
+				}
+			}
+			else
+			{
+				outOptions.inputs.push_back(arg);
+			}
+		}
+		std::sort(outOptions.inputs.begin(), outOptions.inputs.end());
+		return !outOptions.inputs.empty();
+	}
+
+	std::filesystem::path MakeOutputPath(const Options& options, const std::filesystem::path& input)
+	{
+		std::filesystem::path output = options.outputDirectory.empty()
+			? input.parent_path() / input.filename()
+			: options.outputDirectory / input.filename();
+		output.replace_extension(MeshCooker::kCookedExtension);
+		return output;
+	}
+
+	template <typename TFunc>
+	double MeasureAverageMilliseconds(TFunc&& func)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < kBenchmarkIterations; ++i)
+		{
+			func();
+		}
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - begin).count() / kBenchmarkIterations;
+	}
+
+	/// ファイルの内容を OS のファイルキャッシュから追い出し、次の読み込みをディスクからにします。
+	bool EvictFromFileCache(const std::filesystem::path& path)
+	{
+#ifdef _WIN32
+		// キャッシュを使わないハンドルを開くと、他に開いているハンドルがなければキャッシュが破棄される
+		const HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+			OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		CloseHandle(file);
+		return true;
+#else
+		// 書いたばかりのページは破棄されないので、先にディスクへ書き出す
+		const int file = open(path.c_str(), O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+		const bool isEvicted = fdatasync(file) == 0 && posix_fadvise(file, 0, 0, POSIX_FADV_DONTNEED) == 0;
+		close(file);
+		return isEvicted;
+#endif
+	}
+
+	/// 毎回ファイルキャッシュから追い出してから読み込みます。追い出せない環境では負の値
+	template <typename TFunc>
+	double MeasureColdMilliseconds(const std::filesystem::path& path, TFunc&& func)
+	{
+		double totalMs = 0.0;
+		for (int i = 0; i < kColdBenchmarkIterations; ++i)
+		{
+			if (!EvictFromFileCache(path))
+			{
+				return -1.0;
+			}
+			const auto begin = std::chrono::steady_clock::now();
+			func();
+			totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		}
+		return totalMs / kColdBenchmarkIterations;
+	}
+
+	///=================================================================
+	/// 生 PMD とクック済みメッシュを、実行時と同じ MeshImport::Import で読み込んで比較します。
+	/// どちらも GPU へ転送できる MeshData（頂点・インデックス・描画範囲）までを作ります。
+	///   生 PMD     : マップ + 全セクション検証 + 頂点の詰め直し + 三角形の並べ替え
+	///   クック済み : マップ + ヘッダー検証 + 頂点とインデックスのコピー
+	/// コールドは読み込みのたびにファイルキャッシュから追い出し、ウォームはキャッシュに載った状態です。
+	///=================================================================
+	void RunBenchmark(const std::filesystem::path& input, const std::filesystem::path& output)
+	{
+		volatile uint64_t sink = 0;
+		const auto importRaw = [&]()
+		{
+			MeshImport::MeshData data;
+			if (MeshImport::Import(input, data))
+			{
+				sink = sink + data.vertices.size() + data.indices.size();
+			}
+		};
+		const auto importCooked = [&]()
+		{
+			MeshImport::MeshData data;
+			if (MeshImport::Import(output, data))
+			{
+				sink = sink + data.vertices.size() + data.indices.size();
+			}
+		};
+
+		const double rawColdMs = MeasureColdMilliseconds(input, importRaw);
+		const double cookedColdMs = MeasureColdMilliseconds(output, importCooked);
+		const double rawWarmMs = MeasureAverageMilliseconds(importRaw);
+		const double cookedWarmMs = MeasureAverageMilliseconds(importCooked);
+
+		const auto rawSize = std::filesystem::file_size(input);
+		const auto cookedSize = std::filesystem::file_size(output);
+		if (rawColdMs >= 0.0 && cookedColdMs >= 0.0)
+		{
+			std::printf("  load cold: pmd %.3f ms, pmdc %.3f ms (x%.2f)\n",
+				rawColdMs, cookedColdMs, cookedColdMs > 0.0 ? rawColdMs / cookedColdMs : 0.0);
+		}
+		else
+		{
+			std::printf("  load cold: not measured (failed to evict the files from the file cache)\n");
+		}
+		std::printf("  load warm: pmd %.3f ms, pmdc %.3f ms (x%.2f)  size: pmd %llu bytes, pmdc %llu bytes (%.1f%%)\n",
+			rawWarmMs, cookedWarmMs, cookedWarmMs > 0.0 ? rawWarmMs / cookedWarmMs : 0.0,
+			static_cast<unsigned long long>(rawSize), static_cast<unsigned long long>(cookedSize),
+			rawSize > 0 ? 100.0 * static_cast<double>(cookedSize) / static_cast<double>(rawSize) : 0.0);
+	}
+
+	///=================================================================
+	/// 全入力の CPU 側読み込み（解析・三角形の並べ替え・パック）を
+	/// 逐次と並列で実行し、スループットを比較します。
+	///=================================================================
+	void RunImportBenchmark(const std::vector<std::filesystem::path>& inputs)
+	{
+		size_t totalIndices = 0;
+		for (const auto& input : inputs)
+		{
+			MeshImport::MeshData data;
+			std::string error;
+			if (!MeshImport::Import(input, data, &error))
+			{
+				// 三角形を持たないモデルも含めて比較するため、失敗は報告だけ行う
+				std::printf("  skip: %s: %s\n", ToDisplayString(input).c_str(), error.c_str());
+			}
+			totalIndices += data.indices.size();
+		}
+
+		const double sequentialMs = MeasureAverageMilliseconds([&]()
+		{
+			for (const auto& input : inputs)
+			{
+				MeshImport::MeshData data;
+				MeshImport::Import(input, data);
+			}
+		});
+
+		JobSystem& jobSystem = JobSystem::Get();
+		const double parallelMs = MeasureAverageMilliseconds([&]()
+		{
+			std::vector<std::future<bool>> futures;
+			futures.reserve(inputs.size());
+			for (const auto& input : inputs)
+			{
+				futures.push_back(jobSystem.Submit([input]()
+				{
+					MeshImport::MeshData data;
+					return MeshImport::Import(input, data);
+				}));
+			}
+			for (auto& future : futures)
+			{
+				future.get();
+			}
+		});
+
+		std::printf("import %zu models (%zu indices): sequential %.3f ms, parallel %.3f ms with %zu workers (x%.2f)\n",
+			inputs.size(), totalIndices, sequentialMs, parallelMs, jobSystem.GetWorkerCount(),
+			parallelMs > 0.0 ? sequentialMs / parallelMs : 0.0);
+	}
+
+	bool CookFile(const Options& options, const std::filesystem::path& input)
+	{
+		PMDMappedReader reader;
+		if (!reader.Open(input))
+		{
+			std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+			return false;
+		}
+
+		std::vector<uint8_t> blob;
+		std::string error;
+		MeshCooker::CookStatistics stats;
+		if (!MeshCooker::Cook(reader, blob, &error, &stats))
+		{
+			std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(input).c_str(), error.c_str());
+			return false;
+		}
+		reader.Close();
+
+		const std::filesystem::path output = MakeOutputPath(options, input);
+		if (!MeshCooker::WriteFile(output, blob))
+		{
+			std::fprintf(stderr, "error: failed to write %s\n", ToDisplayString(output).c_str());
+			return false;
+		}
+
+		CookedMeshFile cooked;
+		if (!cooked.Open(output) || !cooked.VerifyPayloadHash())
+		{
+			std::fprintf(stderr, "error: %s: verification failed %s\n", ToDisplayString(output).c_str(), cooked.GetLastError().c_str());
+			return false;
+		}
+		std::printf("%s -> %s (vertices %u, indices %u, subsets %u, hash %016llx)\n",
+			ToDisplayString(input).c_str(), ToDisplayString(output).c_str(),
+			cooked.GetVertexCount(), cooked.GetIndexCount(), cooked.GetSubsetCount(),
+			static_cast<unsigned long long>(cooked.GetHeader().sourceHash));
+		std::printf("  cache: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, meshlets %zu (%zu verts / %zu tris)\n",
+			stats.before.acmr, stats.after.acmr, stats.before.atvr, stats.after.atvr,
+			stats.meshletCount, MeshCooker::kMeshletMaxVertices, MeshCooker::kMeshletMaxTriangles);
+		cooked.Close();
+
+		if (options.runBenchmark)
+		{
+			RunBenchmark(input, output);
+		}
+		return true;
+	}
+
+	int Run(const std::vector<std::filesystem::path>& args)
+	{
+		Options options;
+		if (!ParseArguments(args, options))
+		{
+			std::fprintf(stderr, "usage: MeshCooker [--bench] [--bench-import] [-o <output dir>] <input.pmd | directory>...\n");
+			return 1;
+		}
+		if (options.runImportBenchmark)
+		{
+			RunImportBenchmark(options.inputs);
+			return 0;
+		}
+		if (!options.outputDirectory.empty())
+		{
+			std::error_code ec;
+			std::filesystem::create_directories(options.outputDirectory, ec);
+		}
+
+		int failedCount = 0;
+		for (const auto& input : options.inputs)
+		{
+			if (!CookFile(options, input))
+			{
+				++failedCount;
+			}
+		}
+		return failedCount == 0 ? 0 : 1;
+	}
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv)
+#else
+int main(int argc, char** argv)
+#endif
+{
+	std::vector<std::filesystem::path> args;
+	for (int i = 1; i < argc; ++i)
+	{
+		args.emplace_back(argv[i]);
+	}
+	return Run(args);
+}
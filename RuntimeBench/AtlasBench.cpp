@@ -0,0 +1,376 @@
+﻿#include "BenchCommon.h"
+#include "FakeTextureLoader.h"
+
+#include "Analyzer/TextureAtlas.h"
+#include "Analyzer/TextureMips.h"
+#include "RHI/TextureAssetManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kAtlasSpriteCount = 200;
+	/// 合成スプライトの辺の長さの範囲（UI のアイコンやパーティクルを想定）
+	constexpr uint32_t kAtlasMinSpriteSize = 8;
+	constexpr uint32_t kAtlasMaxSpriteSize = 128;
+	constexpr int kAtlasIterations = 20;
+	constexpr size_t kAtlasManagedSpriteCount = 40;
+	/// 最大サイズのページ 1 枚の面積を超える量（512x512 はガター込みで 1 ページに 9 枚）
+	constexpr size_t kAtlasLargeSpriteCount = 20;
+	constexpr uint32_t kAtlasLargeSpriteSize = 512;
+
+	/// 合成スプライト: R はスプライトの番号、G と B は位置（ガターの内容とにじみを見分けられる）
+	TextureAtlas::Image MakeAtlasSprite(size_t index, uint32_t width, uint32_t height)
+	{
+		TextureAtlas::Image image;
+		image.width = width;
+		image.height = height;
+		image.pixels.resize(static_cast<size_t>(width) * height * 4);
+		for (uint32_t y = 0; y < height; ++y)
+		{
+			for (uint32_t x = 0; x < width; ++x)
+			{
+				uint8_t* texel = &image.pixels[(static_cast<size_t>(y) * width + x) * 4];
+				texel[0] = static_cast<uint8_t>(index);
+				texel[1] = static_cast<uint8_t>(x);
+				texel[2] = static_cast<uint8_t>(y);
+				texel[3] = 0xFF;
+			}
+		}
+		return image;
+	}
+
+	/// ガターを含む範囲がページに収まり、同じページの中で重ならないか
+	bool IsLayoutValid(const TextureAtlas::Atlas& atlas, uint32_t padding)
+	{
+		for (size_t i = 0; i < atlas.placements.size(); ++i)
+		{
+			const TextureAtlas::Placement& a = atlas.placements[i];
+			if (a.page >= atlas.pages.size())
+			{
+				return false;
+			}
+			const TextureAtlas::Image& page = atlas.pages[a.page];
+			if (a.rect.x < padding || a.rect.y < padding ||
+				a.rect.x + a.rect.width + padding > page.width || a.rect.y + a.rect.height + padding > page.height)
+			{
+				return false;
+			}
+			for (size_t j = i + 1; j < atlas.placements.size(); ++j)
+			{
+				const TextureAtlas::Placement& b = atlas.placements[j];
+				if (a.page == b.page &&
+					a.rect.x < b.rect.x + b.rect.width + padding * 2 && b.rect.x < a.rect.x + a.rect.width + padding * 2 &&
+					a.rect.y < b.rect.y + b.rect.height + padding * 2 && b.rect.y < a.rect.y + a.rect.height + padding * 2)
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/// 描画順に並べたテクスチャのうち、直前と異なるものに切り替える回数（最初のバインドを含む）
+	size_t CountTextureSwitches(const std::vector<uint32_t>& textures)
+	{
+		size_t switches = 0;
+		for (size_t i = 0; i < textures.size(); ++i)
+		{
+			switches += (i == 0 || textures[i] != textures[i - 1]) ? 1 : 0;
+		}
+		return switches;
+	}
+}
+
+int RunAtlasBenchmark()
+{
+	CheckResults check;
+
+	// 大きさの異なるスプライトと、大きすぎて詰めないものを 2 つ
+	const TextureAtlas::Settings settings;
+	std::vector<TextureAtlas::Image> sprites;
+	std::vector<std::string> names;
+	uint32_t random = 12345;
+	for (size_t i = 0; i < kAtlasSpriteCount; ++i)
+	{
+		random = random * 1664525u + 1013904223u;
+		const uint32_t width = kAtlasMinSpriteSize + (random >> 8) % (kAtlasMaxSpriteSize - kAtlasMinSpriteSize + 1);
+		random = random * 1664525u + 1013904223u;
+		const uint32_t height = kAtlasMinSpriteSize + (random >> 8) % (kAtlasMaxSpriteSize - kAtlasMinSpriteSize + 1);
+		sprites.push_back(MakeAtlasSprite(i, width, height));
+		names.push_back("sprite_" + std::to_string(i) + ".png");
+	}
+	sprites.push_back(MakeAtlasSprite(kAtlasSpriteCount, settings.maxSpriteSize + 1, 16));
+	names.push_back("too_wide.png");
+	sprites.push_back(MakeAtlasSprite(kAtlasSpriteCount + 1, 16, settings.maxSpriteSize + 1));
+	names.push_back("too_tall.png");
+	std::vector<const TextureAtlas::Image*> sources;
+	for (const TextureAtlas::Image& sprite : sprites)
+	{
+		sources.push_back(&sprite);
+	}
+
+	TextureAtlas::Atlas atlas;
+	const auto buildBegin = std::chrono::steady_clock::now();
+	for (int iteration = 0; iteration < kAtlasIterations; ++iteration)
+	{
+		atlas = TextureAtlas::Build(names, sources, settings);
+	}
+	const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildBegin).count() / kAtlasIterations;
+
+	check(atlas.placements.size() == kAtlasSpriteCount && atlas.rejected.size() == 2, "oversized sprites are rejected, the rest are packed");
+
+	// ガターを含む範囲が重ならず、ページに収まっていること
+	const uint32_t padding = settings.padding;
+	bool isInside = true;
+	bool isDisjoint = true;
+	for (size_t i = 0; i < atlas.placements.size(); ++i)
+	{
+		const TextureAtlas::Placement& a = atlas.placements[i];
+		const TextureAtlas::Image& page = atlas.pages[a.page];
+		isInside = isInside && a.rect.x >= padding && a.rect.y >= padding &&
+			a.rect.x + a.rect.width + padding <= page.width && a.rect.y + a.rect.height + padding <= page.height;
+		for (size_t j = i + 1; j < atlas.placements.size(); ++j)
+		{
+			const TextureAtlas::Placement& b = atlas.placements[j];
+			if (a.page == b.page &&
+				a.rect.x < b.rect.x + b.rect.width + padding * 2 && b.rect.x < a.rect.x + a.rect.width + padding * 2 &&
+				a.rect.y < b.rect.y + b.rect.height + padding * 2 && b.rect.y < a.rect.y + a.rect.height + padding * 2)
+			{
+				isDisjoint = false;
+			}
+		}
+	}
+	check(isInside, "sprites and gutters stay inside their page");
+	check(isDisjoint, "sprites and gutters do not overlap");
+
+	// 本体は元画像のまま、ガターは最も近い縁のテクセルの複製
+	bool isGutterValid = true;
+	for (size_t i = 0; i < atlas.placements.size(); ++i)
+	{
+		const TextureAtlas::Placement& placement = atlas.placements[i];
+		const TextureAtlas::Image& page = atlas.pages[placement.page];
+		const TextureAtlas::Image& source = sprites[i];
+		for (uint32_t y = placement.rect.y - padding; y < placement.rect.y + placement.rect.height + padding; ++y)
+		{
+			for (uint32_t x = placement.rect.x - padding; x < placement.rect.x + placement.rect.width + padding; ++x)
+			{
+				const uint32_t sourceX = std::clamp<int64_t>(static_cast<int64_t>(x) - placement.rect.x, 0, source.width - 1);
+				const uint32_t sourceY = std::clamp<int64_t>(static_cast<int64_t>(y) - placement.rect.y, 0, source.height - 1);
+				isGutterValid = isGutterValid && std::memcmp(&page.pixels[(static_cast<size_t>(y) * page.width + x) * 4],
+					&source.pixels[(static_cast<size_t>(sourceY) * source.width + sourceX) * 4], 4) == 0;
+			}
+		}
+	}
+	check(isGutterValid, "sprite texels are copied and gutters repeat the nearest edge");
+
+	// Box フィルタのミップで、安全な段まではスプライトの範囲の 1 テクセル外まで自分の色だけ
+	const uint32_t safeMipCount = TextureAtlas::GetSafeMipCount(padding);
+	bool isMipSafe = true;
+	for (size_t pageIndex = 0; pageIndex < atlas.pages.size(); ++pageIndex)
+	{
+		const TextureAtlas::Image& page = atlas.pages[pageIndex];
+		const std::vector<TextureMips::Level> levels = TextureMips::Generate(page.pixels.data(), page.width, page.height,
+			static_cast<size_t>(page.width) * 4, TextureMips::Filter::Box, false);
+		for (size_t i = 0; i < atlas.placements.size(); ++i)
+		{
+			const TextureAtlas::Placement& placement = atlas.placements[i];
+			if (placement.page != pageIndex)
+			{
+				continue;
+			}
+			for (uint32_t mip = 1; mip < safeMipCount && mip < levels.size(); ++mip)
+			{
+				const TextureMips::Level& level = levels[mip];
+				const uint32_t left = (placement.rect.x >> mip) - 1;
+				const uint32_t top = (placement.rect.y >> mip) - 1;
+				const uint32_t right = ((placement.rect.x + placement.rect.width + (1u << mip) - 1) >> mip) + 1;
+				const uint32_t bottom = ((placement.rect.y + placement.rect.height + (1u << mip) - 1) >> mip) + 1;
+				for (uint32_t y = top; y < bottom; ++y)
+				{
+					for (uint32_t x = left; x < right; ++x)
+					{
+						isMipSafe = isMipSafe && level.pixels[(static_cast<size_t>(y) * level.width + x) * 4] == static_cast<uint8_t>(i);
+					}
+				}
+			}
+		}
+	}
+	check(safeMipCount == 4, "8 texel gutters keep 4 mip levels");
+	check(TextureAtlas::GetSafeMipCount(padding, 4) == 2, "block compressed pages keep fewer mip levels");
+	check(isMipSafe, "neighbouring sprites do not bleed into the safe mip levels");
+
+	// 合計が最大サイズのページより大きい場合は、最大サイズのページを複数使って全て詰める
+	std::vector<TextureAtlas::Image> largeSprites;
+	std::vector<std::string> largeNames;
+	for (size_t i = 0; i < kAtlasLargeSpriteCount; ++i)
+	{
+		largeSprites.push_back(MakeAtlasSprite(i, kAtlasLargeSpriteSize, kAtlasLargeSpriteSize));
+		largeNames.push_back("large_" + std::to_string(i) + ".png");
+	}
+	std::vector<const TextureAtlas::Image*> largeSources;
+	for (const TextureAtlas::Image& sprite : largeSprites)
+	{
+		largeSources.push_back(&sprite);
+	}
+	const TextureAtlas::Atlas largeAtlas = TextureAtlas::Build(largeNames, largeSources, settings);
+	bool isPageSizeValid = largeAtlas.pages.size() > 1;
+	for (const TextureAtlas::Image& page : largeAtlas.pages)
+	{
+		isPageSizeValid = isPageSizeValid && page.width <= settings.pageSize && page.height <= settings.pageSize;
+	}
+	check(largeAtlas.placements.size() == kAtlasLargeSpriteCount && largeAtlas.rejected.empty(),
+		"sprites larger than one page in total are all placed");
+	check(isPageSizeValid, "overflowing sprites spill onto more pages of at most the page size");
+	check(IsLayoutValid(largeAtlas, padding), "sprites spread over several pages stay inside and do not overlap");
+
+	// 定義ファイルの往復
+	const std::filesystem::path manifestDirectory = std::filesystem::temp_directory_path() / "RuntimeBenchAtlas";
+	std::error_code ec;
+	std::filesystem::remove_all(manifestDirectory, ec);
+	std::filesystem::create_directories(manifestDirectory, ec);
+	TextureAtlas::Manifest manifest;
+	for (size_t page = 0; page < atlas.pages.size(); ++page)
+	{
+		manifest.pages.push_back({ "ui_" + std::to_string(page) + ".png", atlas.pages[page].width, atlas.pages[page].height });
+	}
+	manifest.placements = atlas.placements;
+	manifest.placements[0].name = "name with spaces.png";
+	TextureAtlas::Manifest loaded;
+	const std::filesystem::path manifestPath = manifestDirectory / "ui.atlas";
+	check(TextureAtlas::SaveManifest(manifestPath, manifest) && TextureAtlas::LoadManifest(manifestPath, loaded) &&
+		loaded.pages.size() == manifest.pages.size() && loaded.placements.size() == manifest.placements.size() &&
+		loaded.placements[0].name == "name with spaces.png" && loaded.placements.back().rect.x == manifest.placements.back().rect.x,
+		"manifest round trips");
+
+	// 描画 1 フレーム: 全スプライトをシーンの順（ばらばら）に描いたときのテクスチャの切り替え
+	std::vector<size_t> drawOrder(atlas.placements.size());
+	for (size_t i = 0; i < drawOrder.size(); ++i)
+	{
+		drawOrder[i] = i;
+	}
+	for (size_t i = drawOrder.size() - 1; i > 0; --i)
+	{
+		random = random * 1664525u + 1013904223u;
+		std::swap(drawOrder[i], drawOrder[(random >> 8) % (i + 1)]);
+	}
+	std::vector<uint32_t> standaloneBinds;
+	std::vector<uint32_t> atlasBinds;
+	for (size_t index : drawOrder)
+	{
+		standaloneBinds.push_back(static_cast<uint32_t>(index));
+		atlasBinds.push_back(atlas.placements[index].page);
+	}
+
+	// TextureAssetManager: 実行時のアトラスと定義ファイルのアトラス
+	TextureAssetManager& manager = TextureAssetManager::Get();
+	manager.SetLoader(std::make_shared<FakeTextureLoader>());
+	manager.ProcessPendingTextures();
+	const TextureHandle standalone = manager.AcquireTexture("ui/standalone.png");
+	std::vector<std::string> spritePaths;
+	for (size_t i = 0; i < kAtlasManagedSpriteCount; ++i)
+	{
+		spritePaths.push_back("ui/icon_" + std::to_string(i) + ".png");
+	}
+	spritePaths.push_back("ui/large.png");
+	spritePaths.push_back("ui/missing.png");
+	spritePaths.push_back("ui/standalone.png");
+	const TextureHandle runtimeAtlas = manager.AcquireAtlas(spritePaths);
+	std::vector<TextureHandle> icons;
+	for (size_t i = 0; i < kAtlasManagedSpriteCount; ++i)
+	{
+		icons.push_back(manager.AcquireTexture(spritePaths[i].c_str()));
+	}
+	const TextureHandle large = manager.AcquireTexture("ui/large.png");
+	const TextureHandle missing = manager.AcquireTexture("ui/missing.png");
+	check(manager.AcquireTexture("other/ICON_3.png") == icons[3], "a path with the same file name resolves to the atlas sprite");
+	check(manager.AcquireTexture("ui/standalone.png") == standalone, "textures loaded before the atlas stay standalone");
+
+	TextureAssetManager::TextureState state = TextureAssetManager::TextureState::Ready;
+	TextureRegion region;
+	check(GetFakeTexturePath(manager.GetTexture(icons[0], &state, &region)) == "placeholder" &&
+		state == TextureAssetManager::TextureState::Pending && region.u0 == 0.0f && region.u1 == 1.0f,
+		"atlas sprites show the full placeholder until the page is published");
+
+	TextureAtlas::Manifest offline;
+	offline.pages.push_back({ "hud_0.png", 256, 128 });
+	offline.placements.push_back({ "hero.png", 0, { 8, 8, 64, 64 } });
+	offline.placements.push_back({ "enemy.png", 0, { 88, 8, 32, 48 } });
+	const std::filesystem::path offlinePath = manifestDirectory / "hud.atlas";
+	TextureAtlas::SaveManifest(offlinePath, offline);
+	const TextureHandle offlineAtlas = manager.AcquireTexture(offlinePath.string().c_str());
+	const TextureHandle hero = manager.AcquireTexture("Assets/Texture/hero.png");
+
+	size_t frames = 0;
+	while (manager.GetPendingCount() > 0 && frames < kMaxTextureFrames)
+	{
+		manager.ProcessPendingTextures();
+		++frames;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	bool isSharedPage = true;
+	bool isRegionValid = true;
+	const std::string firstPage = GetFakeTexturePath(manager.GetTexture(icons[0]));
+	for (TextureHandle icon : icons)
+	{
+		const std::shared_ptr<RHITexture> texture = manager.GetTexture(icon, &state, &region);
+		isSharedPage = isSharedPage && state == TextureAssetManager::TextureState::Ready && GetFakeTexturePath(texture) == firstPage;
+		isRegionValid = isRegionValid && region.u0 > 0.0f && region.v0 > 0.0f && region.u1 < 1.0f && region.v1 < 1.0f &&
+			region.u1 > region.u0 && region.v1 > region.v0;
+	}
+	check(firstPage.rfind("atlas_page_", 0) == 0 && isSharedPage, "runtime atlas sprites share one page");
+	check(isRegionValid, "atlas sprites resolve to a sub rectangle of the page");
+	check(GetFakeTexturePath(manager.GetTexture(large, &state, &region)) == "ui/large.png" && state == TextureAssetManager::TextureState::Ready &&
+		region.u0 == 0.0f && region.v1 == 1.0f, "oversized textures fall back to standalone loading");
+	check(manager.GetTexture(missing, &state) != nullptr && state == TextureAssetManager::TextureState::Failed,
+		"undecodable atlas sprites fail like standalone textures");
+
+	float heroUv[4];
+	TextureAtlas::GetUvRect(offline.placements[0], 256, 128, heroUv);
+	const std::string heroPage = GetFakeTexturePath(manager.GetTexture(hero, &state, &region));
+	check(heroPage.find("hud_0.png") != std::string::npos && state == TextureAssetManager::TextureState::Ready &&
+		region.u0 == heroUv[0] && region.v1 == heroUv[3], "manifest sprites resolve by file name to the page region");
+	check(GetFakeTexturePath(manager.GetTexture(offlineAtlas)) == heroPage, "the atlas handle returns its first page");
+
+	// アトラスを解放しても、取得済みのスプライトはページを保持したまま使える
+	manager.ReleaseTexture(runtimeAtlas);
+	check(GetFakeTexturePath(manager.GetTexture(icons[1])) == firstPage, "sprites outlive the released atlas while referenced");
+	manager.ReleaseTexture(icons[1]);
+	check(manager.GetTexture(icons[1]) == nullptr, "sprites are dropped once the last reference is released");
+	const TextureAssetManager::AtlasStatistics managerStatistics = manager.GetAtlasStatistics();
+	check(managerStatistics.atlasCount == 2 && managerStatistics.spriteCount == kAtlasManagedSpriteCount + 2 &&
+		managerStatistics.standaloneCount == 2, "atlas statistics count packed and standalone textures");
+
+	std::printf("%zu sprites (%u-%u texels per side), padding %u, page %u\n", kAtlasSpriteCount,
+		kAtlasMinSpriteSize, kAtlasMaxSpriteSize, padding, settings.pageSize);
+	// ガターを含めた占有率（小さいスプライトほどガターの割合が大きい）
+	uint64_t paddedTexels = 0;
+	for (const TextureAtlas::Placement& placement : atlas.placements)
+	{
+		paddedTexels += static_cast<uint64_t>(placement.rect.width + padding * 2) * (placement.rect.height + padding * 2);
+	}
+	std::printf("  build    : %8.3f ms, %zu pages, occupancy %.1f%% (%.1f%% with gutters)\n", buildMs, atlas.pages.size(),
+		100.0 * atlas.statistics.GetOccupancy(), 100.0 * static_cast<double>(paddedTexels) / static_cast<double>(atlas.statistics.pageTexels));
+	for (size_t page = 0; page < atlas.pages.size(); ++page)
+	{
+		std::printf("    page %zu: %ux%u\n", page, atlas.pages[page].width, atlas.pages[page].height);
+	}
+	std::printf("  overflow : %zu sprites of %ux%u -> %zu pages\n", kAtlasLargeSpriteCount, kAtlasLargeSpriteSize,
+		kAtlasLargeSpriteSize, largeAtlas.pages.size());
+	std::printf("  per frame: %zu distinct textures -> %zu, texture switches %zu -> %zu\n",
+		kAtlasSpriteCount, atlas.pages.size(), CountTextureSwitches(standaloneBinds), CountTextureSwitches(atlasBinds));
+	std::printf("  manager  : %s\n", manager.FormatAtlasReport().c_str());
+
+	manager.Clear();
+	manager.SetLoader(nullptr);
+	std::filesystem::remove_all(manifestDirectory, ec);
+	return check.Report();
+}
@@ -0,0 +1,85 @@
+﻿#include "BenchCommon.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void CheckResults::operator()(bool condition, const char* message)
+{
+	if (!condition)
+	{
+		std::printf("  FAILED: %s\n", message);
+		++m_FailedCount;
+	}
+}
+
+int CheckResults::Report() const
+{
+	std::printf("  %s\n", m_FailedCount == 0 ? "all checks passed" : "CHECKS FAILED");
+	return m_FailedCount == 0 ? 0 : 1;
+}
+
+namespace
+{
+	bool IsPmdFile(const std::filesystem::path& path)
+	{
+		std::wstring extension = path.extension().wstring();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c)
+		{
+			return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+		});
+		return extension == L".pmd";
+	}
+}
+
+std::string ToDisplayString(const std::filesystem::path& path)
+{
+	return path.u8string();
+}
+
+std::vector<std::filesystem::path> CollectInputs(const std::vector<std::filesystem::path>& args, size_t first)
+{
+	std::vector<std::filesystem::path> inputs;
+	for (size_t i = first; i < args.size(); ++i)
+	{
+		if (std::filesystem::is_directory(args[i]))
+		{
+			for (const auto& entry : std::filesystem::directory_iterator(args[i]))
+			{
+				if (entry.is_regular_file() && IsPmdFile(entry.path()))
+				{
+					inputs.push_back(entry.path());
+				}
+			}
+		}
+		else
+		{
+			inputs.push_back(args[i]);
+		}
+	}
+	std::sort(inputs.begin(), inputs.end());
+	return inputs;
+}
+
+std::vector<std::filesystem::path> CollectFiles(const std::vector<std::filesystem::path>& args, size_t first)
+{
+	std::vector<std::filesystem::path> files;
+	for (size_t i = first; i < args.size(); ++i)
+	{
+		if (std::filesystem::is_directory(args[i]))
+		{
+			for (const auto& entry : std::filesystem::directory_iterator(args[i]))
+			{
+				if (entry.is_regular_file())
+				{
+					files.push_back(entry.path());
+				}
+			}
+		}
+		else
+		{
+			files.push_back(args[i]);
+		}
+	}
+	std::sort(files.begin(), files.end());
+	return files;
+}
@@ -0,0 +1,64 @@
+﻿#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+class Skeleton;
+struct PMDModelData;
+
+/// 読み込みの完了を待つフレーム数の上限（これを超えたら失敗として扱う）
+constexpr size_t kMaxTextureFrames = 10000;
+
+///=======================================================================
+/// <summary>
+/// 1 つのモードの確認の結果を数えます。check(condition, message) の形で呼び、
+/// 満たされなかった確認はその場で表示します。最後に Report で合否を表示します。
+/// </summary>
+///=======================================================================
+class CheckResults
+{
+public:
+	void operator()(bool condition, const char* message);
+
+	size_t GetFailedCount() const { return m_FailedCount; }
+	/// "all checks passed" または "CHECKS FAILED" を表示し、終了コード（失敗があれば 1）を返します。
+	int Report() const;
+
+private:
+	size_t m_FailedCount = 0;
+};
+
+std::string ToDisplayString(const std::filesystem::path& path);
+/// 引数のファイルとディレクトリ直下の .pmd を列挙します。
+std::vector<std::filesystem::path> CollectInputs(const std::vector<std::filesystem::path>& args, size_t first);
+/// 引数のファイルとディレクトリ直下のファイルを列挙します。
+std::vector<std::filesystem::path> CollectFiles(const std::vector<std::filesystem::path>& args, size_t first);
+/// PMD を読んでスケルトンを作ります（pose と vmd で共通）。失敗した場合はエラーを表示して false
+bool LoadSkeleton(const std::filesystem::path& input, PMDModelData& outModelData, Skeleton& outSkeleton);
+
+///=======================================================================
+/// 各モードの入口（引数と内容は main.cpp の先頭を参照）。戻り値はプロセスの終了コードです。
+/// モードごとに <モード名>Bench.cpp に分けています。
+///=======================================================================
+int RunModelBenchmark(const std::vector<std::filesystem::path>& inputs);
+int RunMappedReaderBenchmark(const std::vector<std::filesystem::path>& inputs);
+int RunMeshOptimizerBenchmark(const std::vector<std::filesystem::path>& inputs);
+int RunSkinningBenchmark(const std::vector<std::filesystem::path>& inputs);
+int RunPoseBenchmark(const std::filesystem::path& input);
+int RunMotionBenchmark(const std::filesystem::path& input, std::filesystem::path motionPath);
+int RunMorphBenchmark(const std::vector<std::filesystem::path>& inputs);
+int RunTextureBenchmark();
+int RunTextureCacheBenchmark();
+int RunUploadBenchmark();
+int RunAtlasBenchmark();
+int RunResidencyBenchmark();
+int RunHandleBenchmark();
+int RunMemoryBenchmark(const std::filesystem::path& tracePathArgument);
+int RunDecodeBenchmark(const std::vector<std::filesystem::path>& inputs);
+int RunHotReloadBenchmark();
+int RunDescriptorBenchmark();
+int RunConstantsBenchmark();
+int RunSpriteBatchBenchmark();
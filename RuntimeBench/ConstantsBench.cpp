@@ -0,0 +1,202 @@
+﻿#include "BenchCommon.h"
+
+#include "RHI/FrameLinearAllocator.h"
+
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+namespace
+{
+	/// 小さいページでページの切り替えを起こす。GPU は kConstantsFramesInFlight - 1 フレーム遅れて進む
+	constexpr uint64_t kConstantsPageSize = 128 * 1024;
+	constexpr uint32_t kConstantsMaxPagesPerFrame = 8;
+	constexpr uint32_t kConstantsFrameCount = 2;
+	constexpr uint64_t kConstantsFramesInFlight = 2;
+	constexpr size_t kConstantsFrames = 600;
+	/// 1 フレームの描画数の上限。行列（64 バイト）が 256 バイトずつ並ぶ
+	constexpr uint32_t kConstantsMaxDrawCount = 1500;
+	constexpr uint64_t kConstantsMatrixBytes = 64;
+	constexpr size_t kConstantsTimingIterations = 1000000;
+
+	/// 1 回の実行。framesInFlight が組の数より多いと、GPU が読んでいる組を使い回す
+	struct ConstantsRunResult
+	{
+		bool isAligned = true;
+		bool isIntactUntilComplete = true;
+		size_t allocationCount = 0;
+		size_t oversizedFailedCount = 0;
+		FrameLinearAllocatorStatistics statistics;
+	};
+
+	ConstantsRunResult SimulateFrameConstants(uint64_t framesInFlight)
+	{
+		FrameLinearAllocatorDesc desc;
+		desc.pageSize = kConstantsPageSize;
+		desc.maxPagesPerFrame = kConstantsMaxPagesPerFrame;
+		desc.frameCount = kConstantsFrameCount;
+		desc.alignment = 256;
+		FrameLinearAllocator allocator(desc);
+
+		// 256 バイトごとに最後に書いた確保の番号を持ち、GPU が読み終えたフレームの値が残っているか確かめる
+		const uint64_t blocksPerPage = kConstantsPageSize / desc.alignment;
+		std::vector<uint32_t> memory(static_cast<size_t>(blocksPerPage * allocator.GetPageCount()), UINT32_MAX);
+		struct Written
+		{
+			uint64_t fenceValue = 0;
+			uint32_t id = 0;
+			uint64_t firstBlock = 0;
+			uint64_t blockCount = 0;
+		};
+		std::deque<Written> inFlight;
+
+		ConstantsRunResult result;
+		uint32_t state = 777;
+		uint32_t nextId = 0;
+		for (uint64_t frame = 1; frame <= kConstantsFrames; ++frame)
+		{
+			const uint64_t completed = frame > framesInFlight ? frame - framesInFlight : 0;
+			allocator.BeginFrame(frame, completed);
+			while (!inFlight.empty() && inFlight.front().fenceValue <= completed)
+			{
+				const Written& written = inFlight.front();
+				for (uint64_t block = 0; block < written.blockCount; ++block)
+				{
+					result.isIntactUntilComplete = result.isIntactUntilComplete && memory[written.firstBlock + block] == written.id;
+				}
+				inFlight.pop_front();
+			}
+
+			state = state * 1664525u + 1013904223u;
+			const uint32_t drawCount = (state >> 8) % kConstantsMaxDrawCount + 1;
+			for (uint32_t draw = 0; draw < drawCount; ++draw)
+			{
+				state = state * 1664525u + 1013904223u;
+				// ほとんどは行列 1 つ。ときどき大きな定数（ボーンの行列など）と、ページに収まらないもの
+				const uint32_t kind = (state >> 8) % 64;
+				const uint64_t size = kind == 0 ? kConstantsPageSize + 1 : kind < 4 ? 4096 : kConstantsMatrixBytes;
+				FrameLinearAllocation allocation;
+				if (!allocator.Allocate(size, allocation))
+				{
+					result.oversizedFailedCount += size > kConstantsPageSize ? 1 : 0;
+					continue;
+				}
+				++result.allocationCount;
+				result.isAligned = result.isAligned && allocation.offset % desc.alignment == 0 &&
+					allocation.offset + size <= kConstantsPageSize && allocation.page < allocator.GetPageCount();
+
+				Written written;
+				written.fenceValue = frame;
+				written.id = nextId++;
+				written.firstBlock = allocation.page * blocksPerPage + allocation.offset / desc.alignment;
+				written.blockCount = (size + desc.alignment - 1) / desc.alignment;
+				for (uint64_t block = 0; block < written.blockCount; ++block)
+				{
+					memory[written.firstBlock + block] = written.id;
+				}
+				inFlight.push_back(written);
+			}
+		}
+		result.statistics = allocator.GetStatistics();
+		return result;
+	}
+}
+
+int RunConstantsBenchmark()
+{
+	CheckResults check;
+
+	const ConstantsRunResult run = SimulateFrameConstants(kConstantsFramesInFlight);
+	check(run.isAligned, "every block is 256-byte aligned and inside its page");
+	check(run.isIntactUntilComplete, "constants stay intact until the GPU finishes their frame");
+	check(run.statistics.inFlightReuseCount == 0, "no frame slot is reused while in flight");
+	check(run.statistics.failedAllocationCount == run.oversizedFailedCount && run.oversizedFailedCount > 0,
+		"only allocations larger than a page fail");
+	check(run.statistics.pageCount > kConstantsFrameCount && run.statistics.pageCount <= run.statistics.maxPageCount,
+		"busy frames move on to further pages");
+
+	const ConstantsRunResult overlapped = SimulateFrameConstants(kConstantsFrameCount + 1);
+	check(overlapped.statistics.inFlightReuseCount > 0 && !overlapped.isIntactUntilComplete,
+		"more frames in flight than slots is reported");
+
+	// 以前の DX12FrameConstantBuffer：オブジェクトごとの 1 つのバッファを毎フレーム上書きする
+	size_t overwrittenInFlightCount = 0;
+	{
+		std::vector<uint64_t> lastWrittenFrame(kConstantsMaxDrawCount, 0);
+		for (uint64_t frame = 1; frame <= kConstantsFrames; ++frame)
+		{
+			const uint64_t completed = frame > kConstantsFramesInFlight ? frame - kConstantsFramesInFlight : 0;
+			for (uint64_t& written : lastWrittenFrame)
+			{
+				overwrittenInFlightCount += written > completed ? 1 : 0;
+				written = frame;
+			}
+		}
+	}
+	check(overwrittenInFlightCount > 0, "per-object buffers overwrite constants the GPU is still reading");
+
+	{
+		FrameLinearAllocator empty;
+		FrameLinearAllocation allocation;
+		check(!empty.Allocate(kConstantsMatrixBytes, allocation), "an unset allocator hands out nothing");
+
+		FrameLinearAllocatorDesc desc;
+		desc.pageSize = 1024;
+		desc.maxPagesPerFrame = 2;
+		desc.frameCount = 2;
+		desc.alignment = 200;
+		FrameLinearAllocator small(desc);
+		FrameLinearAllocation first;
+		FrameLinearAllocation second;
+		FrameLinearAllocation third;
+		check(small.GetDesc().alignment == 256, "alignment is rounded up to a power of two");
+		check(small.Allocate(1, first) && small.Allocate(1, second) && second.offset == 256 && first.page == second.page,
+			"small allocations are bumped within the page");
+		check(small.Allocate(1024, third) && third.page == first.page + 1 && third.offset == 0, "a full page moves on to the next");
+		check(!small.Allocate(1, third), "the slot fails once all its pages are used");
+		small.BeginFrame(1, 0);
+		check(small.Allocate(1, third) && third.page == 2 && third.offset == 0, "the next frame starts its own slot");
+	}
+
+	double allocateNs = 0.0;
+	{
+		FrameLinearAllocatorDesc desc;
+		desc.pageSize = kConstantsPageSize;
+		desc.maxPagesPerFrame = kConstantsMaxPagesPerFrame;
+		desc.frameCount = kConstantsFrameCount;
+		FrameLinearAllocator allocator(desc);
+		const uint64_t perFrame = kConstantsPageSize / 256 * kConstantsMaxPagesPerFrame;
+		uint64_t sum = 0;
+		uint64_t frame = 0;
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < kConstantsTimingIterations; ++i)
+		{
+			if (i % perFrame == 0)
+			{
+				++frame;
+				allocator.BeginFrame(frame, frame - 1);
+			}
+			FrameLinearAllocation allocation;
+			allocator.Allocate(kConstantsMatrixBytes, allocation);
+			sum += allocation.offset + allocation.page;
+		}
+		allocateNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() /
+			static_cast<double>(kConstantsTimingIterations);
+		check(sum > 0, "timed allocations return offsets");
+	}
+
+	std::printf("%llu KB pages (max %u per frame x %u frames), GPU %llu frames behind, up to %u draws per frame\n",
+		static_cast<unsigned long long>(kConstantsPageSize / 1024), kConstantsMaxPagesPerFrame, kConstantsFrameCount,
+		static_cast<unsigned long long>(kConstantsFramesInFlight - 1), kConstantsMaxDrawCount);
+	std::printf("  ring              : %zu frames, %zu blocks, %u pages used, peak %llu KB per frame, %llu failed (larger than a page)\n",
+		kConstantsFrames, run.allocationCount, run.statistics.pageCount,
+		static_cast<unsigned long long>(run.statistics.framePeakBytes / 1024),
+		static_cast<unsigned long long>(run.statistics.failedAllocationCount));
+	std::printf("  in-flight writes  : per-object buffers %zu, frame ring %llu (with %llu frames in flight: %llu slot reuses)\n",
+		overwrittenInFlightCount, static_cast<unsigned long long>(run.statistics.inFlightReuseCount),
+		static_cast<unsigned long long>(kConstantsFrameCount + 1), static_cast<unsigned long long>(overlapped.statistics.inFlightReuseCount));
+	std::printf("  resources         : per-object %u committed buffers, frame ring %u pages\n", kConstantsMaxDrawCount, run.statistics.pageCount);
+	std::printf("  speed             : allocate %.1f ns\n", allocateNs);
+	return check.Report();
+}
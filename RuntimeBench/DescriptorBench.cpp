@@ -0,0 +1,527 @@
+﻿#include "BenchCommon.h"
+
+#include "RHI/DescriptorAllocator.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/// 小さいページで伸びとページの境界を起こす
+	constexpr uint32_t kDescriptorPageSize = 256;
+	constexpr uint32_t kDescriptorMaxPageCount = 8;
+	constexpr uint32_t kDescriptorFrameCount = 2;
+	constexpr uint32_t kDescriptorFrameSize = 512;
+	/// GPU は kDescriptorGpuLatency フレーム前までを終えている
+	constexpr uint64_t kDescriptorGpuLatency = 2;
+	constexpr size_t kDescriptorFuzzFrames = 4100;
+	constexpr uint32_t kDescriptorOperationsPerFrame = 24;
+	constexpr uint32_t kDescriptorMaxRange = 32;
+	constexpr uint32_t kDescriptorThreadCount = 4;
+	constexpr size_t kDescriptorTimingIterations = 1000000;
+	/// 1 フレームの描画数と、その中のテクスチャーの種類（4 つに 1 つは 2 枚使うマテリアル）
+	constexpr uint32_t kGatherDrawCount = 2000;
+	constexpr uint32_t kGatherTextureCount = 64;
+	constexpr size_t kGatherFrames = 60;
+
+	/// 以前の DescriptorHeapManager と同じ、解放したインデックスをすぐ再利用する空きリスト
+	struct ImmediateDescriptorFreeList
+	{
+		uint32_t capacity = 0;
+		uint32_t nextIndex = 0;
+		std::vector<uint32_t> freeList;
+
+		uint32_t Allocate()
+		{
+			if (!freeList.empty())
+			{
+				const uint32_t index = freeList.back();
+				freeList.pop_back();
+				return index;
+			}
+			return nextIndex < capacity ? nextIndex++ : DescriptorAllocator::kInvalidIndex;
+		}
+		void Free(uint32_t index) { freeList.push_back(index); }
+	};
+
+	DescriptorAllocatorDesc MakeDescriptorBenchDesc(uint32_t initialPageCount)
+	{
+		DescriptorAllocatorDesc desc;
+		desc.pageSize = kDescriptorPageSize;
+		desc.initialPageCount = initialPageCount;
+		desc.maxPageCount = kDescriptorMaxPageCount;
+		desc.frameCount = kDescriptorFrameCount;
+		desc.frameDescriptorCount = kDescriptorFrameSize;
+		return desc;
+	}
+
+	/// 各インデックスの状態を別に持ち、乱数の確保・解放で DescriptorAllocator と突き合わせる
+	void FuzzDescriptorAllocator(CheckResults& check, DescriptorAllocatorStatistics& outStatistics, size_t& outPeakPageCount)
+	{
+		enum class SlotState : uint8_t { Free, Live, Pending };
+		struct LiveRange
+		{
+			uint32_t first;
+			uint32_t count;
+		};
+		struct PendingRange
+		{
+			uint32_t first;
+			uint32_t count;
+			uint64_t fenceValue;
+		};
+
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(1));
+		const uint32_t persistentLimit = kDescriptorPageSize * kDescriptorMaxPageCount;
+		std::vector<SlotState> slots(persistentLimit, SlotState::Free);
+		std::vector<LiveRange> live;
+		std::deque<PendingRange> pending;
+		uint32_t liveCount = 0;
+		uint32_t pendingCount = 0;
+		bool isOverlapFree = true;
+		bool isWithinPage = true;
+		bool isFailureJustified = true;
+		bool isFrameRangeValid = true;
+		bool doStatisticsMatch = true;
+		uint32_t previousFrameBase = DescriptorAllocator::kInvalidIndex;
+		outPeakPageCount = 0;
+
+		uint32_t state = 2024;
+		auto next = [&state]()
+		{
+			state = state * 1664525u + 1013904223u;
+			return state >> 8;
+		};
+
+		for (size_t frame = 0; frame < kDescriptorFuzzFrames; ++frame)
+		{
+			const uint64_t frameFence = frame + 1;
+			const uint64_t completedFence = frame >= kDescriptorGpuLatency ? frame + 1 - kDescriptorGpuLatency : 0;
+			allocator.BeginFrame(frameFence, completedFence);
+			while (!pending.empty() && pending.front().fenceValue <= completedFence)
+			{
+				for (uint32_t i = 0; i < pending.front().count; ++i)
+				{
+					slots[pending.front().first + i] = SlotState::Free;
+				}
+				pendingCount -= pending.front().count;
+				pending.pop_front();
+			}
+
+			// 確保が多いフレームと解放が多いフレームを交互に続けて、伸びと断片化を起こす
+			const bool isGrowing = (frame / 200) % 2 == 0;
+			for (uint32_t operation = 0; operation < kDescriptorOperationsPerFrame; ++operation)
+			{
+				const bool isAllocate = live.empty() || next() % 100 < (isGrowing ? 65u : 35u);
+				if (!isAllocate)
+				{
+					const size_t index = next() % live.size();
+					const LiveRange range = live[index];
+					live[index] = live.back();
+					live.pop_back();
+					allocator.Free(range.first, range.count);
+					for (uint32_t i = 0; i < range.count; ++i)
+					{
+						slots[range.first + i] = SlotState::Pending;
+					}
+					liveCount -= range.count;
+					pending.push_back({ range.first, range.count, frameFence });
+					pendingCount += range.count;
+					continue;
+				}
+
+				const uint32_t count = next() % 4 == 0 ? 1 + next() % kDescriptorMaxRange : 1;
+				const uint32_t first = allocator.Allocate(count);
+				if (first == DescriptorAllocator::kInvalidIndex)
+				{
+					// 最大ページまで伸びていて、どのページにも count 個の連続した空きが無いときだけ失敗してよい
+					const DescriptorAllocatorStatistics statistics = allocator.GetStatistics();
+					uint32_t run = 0;
+					bool hasRoom = false;
+					for (uint32_t index = 0; index < persistentLimit && !hasRoom; ++index)
+					{
+						run = (index % kDescriptorPageSize == 0) ? 0 : run;
+						run = slots[index] == SlotState::Free ? run + 1 : 0;
+						hasRoom = run >= count;
+					}
+					isFailureJustified = isFailureJustified && statistics.pageCount == kDescriptorMaxPageCount && !hasRoom;
+					continue;
+				}
+
+				isWithinPage = isWithinPage && first / kDescriptorPageSize == (first + count - 1) / kDescriptorPageSize &&
+					first + count <= persistentLimit;
+				for (uint32_t i = 0; i < count && first + i < persistentLimit; ++i)
+				{
+					isOverlapFree = isOverlapFree && slots[first + i] == SlotState::Free;
+					slots[first + i] = SlotState::Live;
+				}
+				live.push_back({ first, count });
+				liveCount += count;
+			}
+
+			// フレームの領域: 1 つ前のフレーム（GPU がまだ使っているかもしれない）と別の場所から切り出す
+			const uint32_t frameCount = 1 + next() % 64;
+			const uint32_t frameFirst = allocator.AllocateFrame(frameCount);
+			const uint32_t frameBase = frameFirst - (frameFirst - persistentLimit) % kDescriptorFrameSize;
+			isFrameRangeValid = isFrameRangeValid && frameFirst != DescriptorAllocator::kInvalidIndex && frameFirst >= persistentLimit &&
+				(frameFirst - persistentLimit) % kDescriptorFrameSize + frameCount <= kDescriptorFrameSize && frameBase != previousFrameBase;
+			previousFrameBase = frameBase;
+
+			const DescriptorAllocatorStatistics statistics = allocator.GetStatistics();
+			outPeakPageCount = (std::max)(outPeakPageCount, static_cast<size_t>(statistics.pageCount));
+			doStatisticsMatch = doStatisticsMatch && statistics.usedCount == liveCount && statistics.pendingFreeCount == pendingCount &&
+				statistics.freeCount == statistics.capacity - liveCount - pendingCount && statistics.largestFreeRange <= kDescriptorPageSize;
+		}
+
+		check(isOverlapFree, "allocations never overlap live or pending descriptors");
+		check(isWithinPage, "ranges stay inside one page");
+		check(isFailureJustified, "allocation only fails when every page is full or fragmented");
+		check(isFrameRangeValid, "frame ranges fit their region and alternate between regions");
+		check(doStatisticsMatch, "used / pending / free counts match the shadow copy");
+		check(outPeakPageCount > 1, "the persistent region grows past its first page");
+		outStatistics = allocator.GetStatistics();
+	}
+}
+
+int RunDescriptorBenchmark()
+{
+	CheckResults check;
+
+	DescriptorAllocatorStatistics fuzzStatistics;
+	size_t peakPageCount = 0;
+	FuzzDescriptorAllocator(check, fuzzStatistics, peakPageCount);
+
+	// 解放したディスクリプタは、そのフレームのフェンスが完了するまで返らない
+	{
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(1));
+		allocator.BeginFrame(1, 0);
+		const uint32_t freed = allocator.Allocate();
+		allocator.Free(freed);
+		allocator.BeginFrame(2, 0);
+		bool isReused = false;
+		for (uint32_t i = 0; i + 1 < kDescriptorPageSize * kDescriptorMaxPageCount; ++i)
+		{
+			const uint32_t index = allocator.Allocate();
+			isReused = isReused || index == freed;
+		}
+		check(!isReused && allocator.GetStatistics().pendingFreeCount == 1, "a freed descriptor is not reused before its fence completes");
+		check(allocator.Allocate() == DescriptorAllocator::kInvalidIndex && allocator.GetStatistics().failedAllocationCount == 1,
+			"allocation fails once every page is used");
+		allocator.BeginFrame(3, 1);
+		check(allocator.Allocate() == freed, "the descriptor returns once its fence completes");
+
+		DescriptorAllocator beforeFrames(MakeDescriptorBenchDesc(1));
+		const uint32_t index = beforeFrames.Allocate();
+		beforeFrames.Free(index);
+		check(beforeFrames.Allocate() == index, "descriptors freed before the first frame are reused immediately");
+
+		DescriptorAllocator ranges(MakeDescriptorBenchDesc(1));
+		check(ranges.Allocate(kDescriptorPageSize + 1) == DescriptorAllocator::kInvalidIndex, "a range larger than a page is rejected");
+		const uint32_t head = ranges.Allocate(1);
+		const uint32_t page = ranges.Allocate(kDescriptorPageSize);
+		check(head == 0 && page == kDescriptorPageSize && ranges.GetStatistics().pageCount == 2,
+			"a range that does not fit the first page starts a new page");
+		ranges.Free(head);
+		ranges.Free(page, kDescriptorPageSize);
+		const DescriptorAllocatorStatistics merged = ranges.GetStatistics();
+		check(merged.freeRangeCount == 2 && merged.largestFreeRange == kDescriptorPageSize && merged.fragmentation == 0.0f,
+			"freed ranges merge inside a page but not across pages");
+
+		DescriptorAllocator cleared(MakeDescriptorBenchDesc(1));
+		cleared.Reset();
+		cleared.Free(0);
+		check(cleared.Allocate() == DescriptorAllocator::kInvalidIndex && cleared.GetStatistics().freeCount == 0,
+			"a cleared allocator ignores stale frees");
+	}
+
+	// 以前の空きリストを同じ確保・解放で動かし、GPU がまだ参照しているインデックスを渡した回数を数える
+	size_t immediateHazardCount = 0;
+	size_t deferredHazardCount = 0;
+	{
+		ImmediateDescriptorFreeList freeList;
+		freeList.capacity = kDescriptorPageSize * kDescriptorMaxPageCount;
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(1));
+		std::vector<uint64_t> immediateFreedFence(freeList.capacity, 0);
+		std::vector<uint64_t> deferredFreedFence(freeList.capacity, 0);
+		std::vector<uint32_t> immediateLive;
+		std::vector<uint32_t> deferredLive;
+		uint32_t state = 7;
+		for (uint64_t frame = 0; frame < kDescriptorFuzzFrames; ++frame)
+		{
+			const uint64_t frameFence = frame + 1;
+			const uint64_t completedFence = frame >= kDescriptorGpuLatency ? frame + 1 - kDescriptorGpuLatency : 0;
+			allocator.BeginFrame(frameFence, completedFence);
+			for (uint32_t operation = 0; operation < kDescriptorOperationsPerFrame; ++operation)
+			{
+				state = state * 1664525u + 1013904223u;
+				const bool isAllocate = immediateLive.empty() || (state >> 8) % 2 == 0 || immediateLive.size() < 64;
+				if (isAllocate)
+				{
+					const uint32_t immediate = freeList.Allocate();
+					const uint32_t deferred = allocator.Allocate();
+					if (immediate != DescriptorAllocator::kInvalidIndex)
+					{
+						immediateHazardCount += immediateFreedFence[immediate] > completedFence ? 1 : 0;
+						immediateLive.push_back(immediate);
+					}
+					if (deferred != DescriptorAllocator::kInvalidIndex)
+					{
+						deferredHazardCount += deferredFreedFence[deferred] > completedFence ? 1 : 0;
+						deferredLive.push_back(deferred);
+					}
+					continue;
+				}
+				const size_t slot = (state >> 16) % immediateLive.size();
+				immediateFreedFence[immediateLive[slot]] = frameFence;
+				freeList.Free(immediateLive[slot]);
+				immediateLive[slot] = immediateLive.back();
+				immediateLive.pop_back();
+				if (slot < deferredLive.size())
+				{
+					deferredFreedFence[deferredLive[slot]] = frameFence;
+					allocator.Free(deferredLive[slot]);
+					deferredLive[slot] = deferredLive.back();
+					deferredLive.pop_back();
+				}
+			}
+		}
+		check(deferredHazardCount == 0, "deferred frees never hand out a descriptor the GPU may still read");
+	}
+
+	// フレームの領域を複数スレッドから同時に切り出す
+	size_t threadedAllocationCount = 0;
+	{
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(1));
+		allocator.BeginFrame(1, 0);
+		std::vector<std::vector<std::pair<uint32_t, uint32_t>>> ranges(kDescriptorThreadCount);
+		std::vector<std::thread> threads;
+		std::atomic<bool> isStarted{ false };
+		for (uint32_t t = 0; t < kDescriptorThreadCount; ++t)
+		{
+			threads.emplace_back([&allocator, &ranges, &isStarted, t]()
+			{
+				while (!isStarted.load())
+				{
+					std::this_thread::yield();
+				}
+				for (uint32_t i = 0; ; ++i)
+				{
+					const uint32_t count = 1 + (i + t) % 3;
+					const uint32_t first = allocator.AllocateFrame(count);
+					if (first == DescriptorAllocator::kInvalidIndex)
+					{
+						break;
+					}
+					ranges[t].emplace_back(first, count);
+				}
+			});
+		}
+		isStarted = true;
+		for (std::thread& thread : threads)
+		{
+			thread.join();
+		}
+
+		const uint32_t persistentLimit = kDescriptorPageSize * kDescriptorMaxPageCount;
+		std::vector<uint8_t> used(kDescriptorFrameSize * kDescriptorFrameCount, 0);
+		bool isDisjoint = true;
+		uint32_t usedCount = 0;
+		for (const auto& threadRanges : ranges)
+		{
+			threadedAllocationCount += threadRanges.size();
+			for (const auto& range : threadRanges)
+			{
+				for (uint32_t i = 0; i < range.second; ++i)
+				{
+					const uint32_t offset = range.first + i - persistentLimit;
+					isDisjoint = isDisjoint && range.first >= persistentLimit && offset < used.size() && used[offset] == 0;
+					if (offset < used.size())
+					{
+						used[offset] = 1;
+					}
+				}
+				usedCount += range.second;
+			}
+		}
+		const DescriptorAllocatorStatistics statistics = allocator.GetStatistics();
+		check(isDisjoint, "concurrent frame allocations never overlap");
+		check(usedCount <= kDescriptorFrameSize && usedCount + 3 > kDescriptorFrameSize, "concurrent frame allocations fill the region");
+		check(statistics.frameOverflowCount >= kDescriptorThreadCount, "every thread sees the region overflow");
+		allocator.BeginFrame(2, 1);
+		check(allocator.GetStatistics().frameUsedCount == 0 && allocator.GetStatistics().framePeakCount >= usedCount,
+			"BeginFrame empties the next region and keeps the peak");
+	}
+
+	// 1 個ずつの確保と解放（テクスチャの SRV）と、フレームの領域の切り出しの速度
+	double persistentNs = 0.0;
+	double frameNs = 0.0;
+	{
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(kDescriptorMaxPageCount));
+		std::vector<uint32_t> indices(kDescriptorPageSize);
+		auto begin = std::chrono::steady_clock::now();
+		for (size_t iteration = 0; iteration < kDescriptorTimingIterations / kDescriptorPageSize; ++iteration)
+		{
+			for (uint32_t& index : indices)
+			{
+				index = allocator.Allocate();
+			}
+			for (const uint32_t index : indices)
+			{
+				allocator.Free(index);
+			}
+		}
+		persistentNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() /
+			static_cast<double>(kDescriptorTimingIterations / kDescriptorPageSize * kDescriptorPageSize);
+
+		uint64_t sum = 0;
+		begin = std::chrono::steady_clock::now();
+		for (size_t iteration = 0; iteration < kDescriptorTimingIterations / kDescriptorFrameSize; ++iteration)
+		{
+			allocator.BeginFrame(iteration + 1, iteration + 1);
+			for (uint32_t i = 0; i < kDescriptorFrameSize; ++i)
+			{
+				sum += allocator.AllocateFrame();
+			}
+		}
+		frameNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() /
+			static_cast<double>(kDescriptorTimingIterations / kDescriptorFrameSize * kDescriptorFrameSize);
+		check(sum > 0, "frame allocations return indices");
+	}
+
+	// 描画ごとにステージングのディスクリプタをフレームの領域へ集める（内容はテクスチャーの番号で模す）
+	size_t gatheredCopyCount = 0;
+	size_t perDrawCopyCount = 0;
+	uint32_t gatherPeakCount = 0;
+	double gatherMs = 0.0;
+	{
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(1));
+		std::vector<uint32_t> stagingHeap(kGatherTextureCount);
+		std::vector<uint32_t> stagingIndices(kGatherTextureCount);
+		for (uint32_t texture = 0; texture < kGatherTextureCount; ++texture)
+		{
+			stagingIndices[texture] = allocator.Allocate();
+			stagingHeap[texture] = texture;
+		}
+		const uint32_t persistentLimit = kDescriptorPageSize * kDescriptorMaxPageCount;
+		std::vector<uint32_t> shaderVisibleHeap(kDescriptorFrameSize * kDescriptorFrameCount, UINT32_MAX);
+
+		DescriptorTableCache cache;
+		bool isContentCorrect = true;
+		bool isReusedOnlyWithinFrame = true;
+		uint32_t state = 99;
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < kGatherFrames; ++frame)
+		{
+			allocator.BeginFrame(frame + 1, frame);
+			cache.Clear();
+			for (uint32_t draw = 0; draw < kGatherDrawCount; ++draw)
+			{
+				state = state * 1664525u + 1013904223u;
+				// 2 枚目はマテリアルごとに決まっている（法線マップなど）
+				const uint32_t texture = (state >> 8) % kGatherTextureCount;
+				const uint32_t textures[2] = { texture, (texture * 7 + 1) % kGatherTextureCount };
+				const uint32_t count = draw % 4 == 0 ? 2u : 1u;
+				const uint32_t sources[2] = { stagingIndices[textures[0]], stagingIndices[textures[1]] };
+				perDrawCopyCount += count;
+
+				uint32_t table = cache.Find(sources, count);
+				if (table == DescriptorAllocator::kInvalidIndex)
+				{
+					table = allocator.AllocateFrame(count);
+					if (table == DescriptorAllocator::kInvalidIndex)
+					{
+						isContentCorrect = false;
+						continue;
+					}
+					for (uint32_t i = 0; i < count; ++i)
+					{
+						shaderVisibleHeap[table - persistentLimit + i] = stagingHeap[sources[i]];
+					}
+					cache.Insert(sources, count, table);
+					gatheredCopyCount += count;
+				}
+				const uint32_t region = (table - persistentLimit) / kDescriptorFrameSize;
+				isReusedOnlyWithinFrame = isReusedOnlyWithinFrame && region == (frame + 1) % kDescriptorFrameCount;
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					isContentCorrect = isContentCorrect && shaderVisibleHeap[table - persistentLimit + i] == textures[i];
+				}
+			}
+			gatherPeakCount = (std::max)(gatherPeakCount, allocator.GetStatistics().frameUsedCount);
+		}
+		gatherMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / kGatherFrames;
+		check(isContentCorrect, "every draw binds a table holding its own textures in order");
+		check(isReusedOnlyWithinFrame, "tables are only shared within the frame that gathered them");
+		check(gatheredCopyCount < perDrawCopyCount, "shared texture combinations are copied once per frame");
+
+		const uint32_t ab[2] = { stagingIndices[1], stagingIndices[2] };
+		const uint32_t ba[2] = { stagingIndices[2], stagingIndices[1] };
+		cache.Clear();
+		cache.Insert(ab, 2, 7);
+		check(cache.Find(ab, 2) == 7 && cache.Find(ba, 2) == DescriptorAllocator::kInvalidIndex &&
+			cache.Find(ab, 1) == DescriptorAllocator::kInvalidIndex, "tables are keyed by the exact order and length");
+	}
+
+	// 同じ描画をバインドレスで行う。テクスチャーを作ったときに永続領域へ 1 回写し、描画ではインデックス（ルート定数）を渡すだけ
+	size_t bindlessCopyCount = 0;
+	uint32_t bindlessFramePeakCount = 0;
+	double bindlessMs = 0.0;
+	{
+		DescriptorAllocator allocator(MakeDescriptorBenchDesc(1));
+		std::vector<uint32_t> shaderVisibleHeap(kDescriptorPageSize * kDescriptorMaxPageCount, UINT32_MAX);
+		std::vector<uint32_t> bindlessIndices(kGatherTextureCount);
+		for (uint32_t texture = 0; texture < kGatherTextureCount; ++texture)
+		{
+			bindlessIndices[texture] = allocator.Allocate();
+			shaderVisibleHeap[bindlessIndices[texture]] = texture;
+			++bindlessCopyCount;
+		}
+
+		bool isContentCorrect = true;
+		uint32_t rootConstants[2] = {};
+		uint32_t state = 99;
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < kGatherFrames; ++frame)
+		{
+			allocator.BeginFrame(frame + 1, frame);
+			for (uint32_t draw = 0; draw < kGatherDrawCount; ++draw)
+			{
+				state = state * 1664525u + 1013904223u;
+				const uint32_t texture = (state >> 8) % kGatherTextureCount;
+				const uint32_t textures[2] = { texture, (texture * 7 + 1) % kGatherTextureCount };
+				const uint32_t count = draw % 4 == 0 ? 2u : 1u;
+				for (uint32_t i = 0; i < count; ++i)
+				{
+					rootConstants[i] = bindlessIndices[textures[i]];
+					// シェーダーは g_textures[index] で読む
+					isContentCorrect = isContentCorrect && shaderVisibleHeap[rootConstants[i]] == textures[i];
+				}
+			}
+			bindlessFramePeakCount = (std::max)(bindlessFramePeakCount, allocator.GetStatistics().frameUsedCount);
+		}
+		bindlessMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / kGatherFrames;
+		check(isContentCorrect, "bindless indices read each draw's own textures");
+		check(bindlessFramePeakCount == 0, "bindless draws use no per-frame descriptors");
+		check(bindlessCopyCount < gatheredCopyCount, "bindless copies each texture once instead of once per frame");
+	}
+
+	std::printf("%u-descriptor pages (max %u), %u x %u per-frame descriptors, GPU %llu frames behind\n", kDescriptorPageSize,
+		kDescriptorMaxPageCount, kDescriptorFrameCount, kDescriptorFrameSize, static_cast<unsigned long long>(kDescriptorGpuLatency));
+	std::printf("  fuzz              : %zu frames, %zu pages at peak, %u / %u used, %u pending, %u free ranges (largest %u, fragmentation %.2f), %llu failed\n",
+		kDescriptorFuzzFrames, peakPageCount, fuzzStatistics.usedCount, fuzzStatistics.capacity, fuzzStatistics.pendingFreeCount,
+		fuzzStatistics.freeRangeCount, fuzzStatistics.largestFreeRange, fuzzStatistics.fragmentation,
+		static_cast<unsigned long long>(fuzzStatistics.failedAllocationCount));
+	std::printf("  in-flight reuse   : immediate free list %zu, deferred frees %zu\n", immediateHazardCount, deferredHazardCount);
+	std::printf("  frame region      : %zu ranges from %u threads without a lock\n", threadedAllocationCount, kDescriptorThreadCount);
+	std::printf("  speed             : persistent allocate + free %.1f ns, frame allocate %.1f ns\n", persistentNs, frameNs);
+	std::printf("  gather            : %u draws x %zu frames, %zu descriptors copied (per-draw %zu), peak %u / %u per frame, %.3f ms per frame\n",
+		kGatherDrawCount, kGatherFrames, gatheredCopyCount, perDrawCopyCount, gatherPeakCount, kDescriptorFrameSize, gatherMs);
+	std::printf("  bindless          : %zu descriptors copied once, %u per-frame descriptors, %.3f ms per frame\n",
+		bindlessCopyCount, bindlessFramePeakCount, bindlessMs);
+	return check.Report();
+}
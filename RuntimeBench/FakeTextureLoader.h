@@ -0,0 +1,117 @@
+﻿#pragma once
+
+#include "Analyzer/TextureAtlas.h"
+#include "RHI/TextureAssetManager.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+///=======================================================================
+/// TextureAssetManager を GPU なしで動かすための疑似ローダー（textures / atlas / residency / handles で共通）
+///=======================================================================
+
+/// 疑似ローダーの 1 枚あたりのデコード時間（ディスク読み込み + WIC を想定）
+constexpr auto kFakeDecodeTime = std::chrono::milliseconds(8);
+
+/// GPU リソースの代わりにパスだけを持つテクスチャ
+class FakeTexture final : public RHITexture
+{
+public:
+	explicit FakeTexture(std::string path) : m_Path(std::move(path)) {}
+	void* GetTextureBuffer() const override { return nullptr; }
+	const std::string& GetPath() const { return m_Path; }
+
+private:
+	std::string m_Path;
+};
+
+struct FakeDecodedTexture final : DecodedTexture
+{
+	std::string path;
+};
+
+/// 一定時間スリープしてデコードを模すローダー。"missing" を含むパスは失敗させます。
+class FakeTextureLoader final : public ITextureLoader
+{
+public:
+	bool IsAvailable() const override { return true; }
+
+	std::unique_ptr<DecodedTexture> Decode(const std::string& path) override
+	{
+		std::this_thread::sleep_for(kFakeDecodeTime);
+		if (path.find("missing") != std::string::npos)
+		{
+			return nullptr;
+		}
+		auto decoded = std::make_unique<FakeDecodedTexture>();
+		decoded->path = path;
+		return decoded;
+	}
+
+	std::shared_ptr<RHITexture> CreateTexture(const DecodedTexture& decoded) override
+	{
+		return std::make_shared<FakeTexture>(static_cast<const FakeDecodedTexture&>(decoded).path);
+	}
+
+	std::shared_ptr<RHITexture> CreatePlaceholderTexture() override
+	{
+		return std::make_shared<FakeTexture>("placeholder");
+	}
+
+	/// アトラス用: "large" を含むパスは大きすぎる画像、それ以外は 32x32
+	bool DecodePixels(const std::string& path, TextureAtlas::Image& outImage) override
+	{
+		if (path.find("missing") != std::string::npos)
+		{
+			return false;
+		}
+		outImage.width = path.find("large") != std::string::npos ? 1024 : 32;
+		outImage.height = outImage.width;
+		outImage.pixels.assign(static_cast<size_t>(outImage.width) * outImage.height * 4, 0xFF);
+		return true;
+	}
+
+	std::unique_ptr<DecodedTexture> DecodeAtlasPage(const TextureAtlas::Image& page, uint32_t padding) override
+	{
+		(void)page;
+		(void)padding;
+		auto decoded = std::make_unique<FakeDecodedTexture>();
+		decoded->path = "atlas_page_" + std::to_string(m_PageCount++);
+		return decoded;
+	}
+
+	/// 常駐の管理用: "stream" を含むパスは 256x256 の RGBA8（全ミップ）として扱う
+	bool GetMipLayout(const DecodedTexture& decoded, uint32_t& outWidth, uint32_t& outHeight, std::vector<uint64_t>& outMipBytes) override
+	{
+		if (static_cast<const FakeDecodedTexture&>(decoded).path.find("stream") == std::string::npos)
+		{
+			return false;
+		}
+		outWidth = 256;
+		outHeight = 256;
+		outMipBytes.clear();
+		for (uint32_t size = 256; size > 0; size /= 2)
+		{
+			outMipBytes.push_back(static_cast<uint64_t>(size) * size * 4);
+		}
+		return true;
+	}
+
+	std::shared_ptr<RHITexture> CreateTextureMips(const DecodedTexture& decoded, uint32_t firstMip) override
+	{
+		return std::make_shared<FakeTexture>(static_cast<const FakeDecodedTexture&>(decoded).path + "#mip" + std::to_string(firstMip));
+	}
+
+private:
+	std::atomic<int> m_PageCount{ 0 };
+};
+
+inline const std::string& GetFakeTexturePath(const std::shared_ptr<RHITexture>& texture)
+{
+	static const std::string kNone = "(null)";
+	return texture != nullptr ? static_cast<const FakeTexture&>(*texture).GetPath() : kNone;
+}
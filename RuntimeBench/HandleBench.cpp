@@ -0,0 +1,294 @@
+﻿#include "BenchCommon.h"
+#include "FakeTextureLoader.h"
+
+#include "RHI/TextureAssetManager.h"
+#include "System/HandleTable.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t kHandleTextureCount = 256;
+	constexpr size_t kHandleThreadCounts[] = { 1, 2, 4, 8 };
+	constexpr size_t kHandleLookupsPerThread = 1u << 20;
+	/// ローダーが書き込む間隔（公開や参照の追加を模す）
+	constexpr auto kHandleWriteInterval = std::chrono::microseconds(20);
+
+	/// 以前の TextureAssetManager::GetTexture と同じ、ミューテックスと unordered_map による引き方
+	class MutexTextureTable
+	{
+	public:
+		void Add(TextureHandle handle, std::shared_ptr<RHITexture> texture)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Entries[handle].texture = std::move(texture);
+		}
+
+		/// ローダーの公開を模して、ロックの中で内容を書き換える
+		void Touch(TextureHandle handle)
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			const auto it = m_Entries.find(handle);
+			if (it != m_Entries.end())
+			{
+				it->second.region.u1 = 1.0f - it->second.region.u1;
+			}
+		}
+
+		std::shared_ptr<RHITexture> GetTexture(TextureHandle handle, TextureRegion* outRegion) const
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			const auto it = m_Entries.find(handle);
+			if (it == m_Entries.end())
+			{
+				return nullptr;
+			}
+			*outRegion = it->second.region;
+			return it->second.texture;
+		}
+
+	private:
+		struct Entry
+		{
+			std::shared_ptr<RHITexture> texture;
+			TextureRegion region;
+		};
+
+		mutable std::mutex m_Mutex;
+		std::unordered_map<TextureHandle, Entry> m_Entries;
+	};
+
+	/// readerCount 本のスレッドで lookup を繰り返し、その間 1 本のスレッドで write を続けたときの
+	/// 1 秒あたりの検索数（百万回）。lookup は見つかった場合に true
+	double MeasureLookups(size_t readerCount, const std::vector<TextureHandle>& handles,
+		const std::function<bool(TextureHandle)>& lookup, const std::function<void(size_t)>& write, size_t& outMissCount)
+	{
+		std::atomic<bool> isDone{ false };
+		std::atomic<size_t> missCount{ 0 };
+		std::thread writer([&]()
+		{
+			for (size_t i = 0; !isDone.load(); ++i)
+			{
+				write(i);
+				std::this_thread::sleep_for(kHandleWriteInterval);
+			}
+		});
+
+		std::vector<std::thread> readers;
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t reader = 0; reader < readerCount; ++reader)
+		{
+			readers.emplace_back([&, reader]()
+			{
+				size_t misses = 0;
+				size_t index = reader * 7919;
+				for (size_t i = 0; i < kHandleLookupsPerThread; ++i)
+				{
+					index = (index + 97) % handles.size();
+					misses += lookup(handles[index]) ? 0 : 1;
+				}
+				missCount += misses;
+			});
+		}
+		for (std::thread& reader : readers)
+		{
+			reader.join();
+		}
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		isDone = true;
+		writer.join();
+		outMissCount += missCount.load();
+		return static_cast<double>(readerCount * kHandleLookupsPerThread) / seconds / 1000000.0;
+	}
+
+	/// 消したときに数える値（HandleTable の遅延解放の確認用）
+	struct CountedValue
+	{
+		explicit CountedValue(std::atomic<int>* counter, uint32_t value = 0, uint32_t check = 0) : counter(counter), value(value), check(check) {}
+		~CountedValue() { ++*counter; }
+		std::atomic<int>* counter;
+		uint32_t value;
+		/// 読み取り側が途中までの書き込みを見ていないか確かめる（value と handle から決まる）
+		uint32_t check;
+	};
+
+	void CheckHandleTable(CheckResults& check)
+	{
+		std::atomic<int> destroyedCount{ 0 };
+		{
+			HandleTable<CountedValue> table;
+			const HandleTable<CountedValue>::Handle handle = table.Allocate();
+			check(handle != 0 && table.Find(handle) == nullptr, "allocated handles are non-zero and empty until published");
+			table.Publish(handle, std::make_unique<CountedValue>(&destroyedCount, 1));
+			table.Publish(handle, std::make_unique<CountedValue>(&destroyedCount, 2));
+			check(table.Find(handle) != nullptr && table.Find(handle)->value == 2 && table.GetRetiredCount() == 1 && destroyedCount == 0,
+				"replaced values are retired instead of destroyed");
+			table.Reclaim();
+			const bool isKeptOneFrame = destroyedCount == 0;
+			table.Reclaim();
+			check(isKeptOneFrame && destroyedCount == 1, "retired values are destroyed after the grace period");
+
+			// 同じスロットを使い回しても、ハンドルは 0 にならず、世代が一周しても前のハンドルと重ならない
+			table.Free(handle);
+			bool isUnique = table.Find(handle) == nullptr;
+			std::unordered_set<HandleTable<CountedValue>::Handle> usedHandles = { handle };
+			for (int i = 0; i < 10000; ++i)
+			{
+				const HandleTable<CountedValue>::Handle reused = table.Allocate();
+				isUnique = isUnique && reused != 0 && usedHandles.insert(reused).second;
+				table.Free(reused);
+			}
+			check(isUnique, "reused slots never hand out a handle twice");
+			check(table.GetExhaustedSlotCount() == 2, "slots whose generation would wrap are not reused");
+
+			// 空いたスロットは古く空いた順に使い回す
+			const HandleTable<CountedValue>::Handle first = table.Allocate();
+			const HandleTable<CountedValue>::Handle second = table.Allocate();
+			table.Free(first);
+			table.Free(second);
+			const HandleTable<CountedValue>::Handle next = table.Allocate();
+			check(HandleTable<CountedValue>::GetIndex(next) == HandleTable<CountedValue>::GetIndex(first),
+				"freed slots are reused oldest first");
+			table.Free(next);
+		}
+		check(destroyedCount == 2, "the table destroys retired and live values");
+
+		// 書き込みと同時に読み、ほかのハンドルの値や書きかけの値が見えないことを確かめる
+		HandleTable<CountedValue> table;
+		std::vector<HandleTable<CountedValue>::Handle> handles;
+		for (uint32_t i = 0; i < kHandleTextureCount; ++i)
+		{
+			handles.push_back(table.Allocate());
+			table.Publish(handles.back(), std::make_unique<CountedValue>(&destroyedCount, 0, handles.back()));
+		}
+		std::atomic<bool> isDone{ false };
+		std::atomic<size_t> mismatchCount{ 0 };
+		std::vector<std::thread> readers;
+		for (size_t reader = 0; reader < 4; ++reader)
+		{
+			readers.emplace_back([&]()
+			{
+				while (!isDone.load())
+				{
+					for (HandleTable<CountedValue>::Handle handle : handles)
+					{
+						const CountedValue* value = table.Find(handle);
+						// 解放中のハンドルは見つからなくてよいが、見つかったなら自分の値
+						if (value != nullptr && value->check != handle + value->value * 2)
+						{
+							++mismatchCount;
+						}
+					}
+				}
+			});
+		}
+		for (uint32_t round = 1; round <= 200; ++round)
+		{
+			for (size_t i = 0; i < handles.size(); ++i)
+			{
+				// 半分は置き換え、残りは解放して確保し直す（読み取り中なので Reclaim はしない）
+				if (i % 2 == 0)
+				{
+					table.Publish(handles[i], std::make_unique<CountedValue>(&destroyedCount, round, handles[i] + round * 2));
+					continue;
+				}
+				table.Free(handles[i]);
+				handles[i] = table.Allocate();
+				table.Publish(handles[i], std::make_unique<CountedValue>(&destroyedCount, round, handles[i] + round * 2));
+			}
+		}
+		isDone = true;
+		for (std::thread& reader : readers)
+		{
+			reader.join();
+		}
+		check(mismatchCount == 0, "concurrent readers only see complete values of their own handle");
+	}
+}
+
+int RunHandleBenchmark()
+{
+	CheckResults check;
+
+	CheckHandleTable(check);
+
+	TextureAssetManager& manager = TextureAssetManager::Get();
+	manager.SetLoader(std::make_shared<FakeTextureLoader>());
+	std::vector<TextureHandle> handles;
+	MutexTextureTable mutexTable;
+	for (uint32_t i = 0; i < kHandleTextureCount; ++i)
+	{
+		const std::string path = "handle_" + std::to_string(i) + ".png";
+		handles.push_back(manager.AcquireTexture(path.c_str()));
+		mutexTable.Add(handles.back(), std::make_shared<FakeTexture>(path));
+	}
+	size_t frames = 0;
+	while (manager.GetPendingCount() > 0 && frames++ < kMaxTextureFrames)
+	{
+		manager.ProcessPendingTextures();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	manager.ProcessPendingTextures();
+
+	bool isResolved = true;
+	for (uint32_t i = 0; i < kHandleTextureCount; ++i)
+	{
+		const RHITexture* texture = manager.PeekTexture(handles[i]);
+		isResolved = isResolved && texture != nullptr &&
+			static_cast<const FakeTexture*>(texture)->GetPath() == "handle_" + std::to_string(i) + ".png" &&
+			texture == manager.GetTexture(handles[i]).get();
+	}
+	check(isResolved, "PeekTexture and GetTexture resolve the same texture");
+
+	std::printf("%u textures, %zu lookups per thread, writer every %lld us\n", kHandleTextureCount, kHandleLookupsPerThread,
+		static_cast<long long>(std::chrono::duration_cast<std::chrono::microseconds>(kHandleWriteInterval).count()));
+	std::printf("  threads  mutex+map   GetTexture  PeekTexture  (M lookups/s)\n");
+	size_t missCount = 0;
+	const TextureHandle churnHandle = handles.front();
+	for (size_t threadCount : kHandleThreadCounts)
+	{
+		const double mutexRate = MeasureLookups(threadCount, handles, [&mutexTable](TextureHandle handle)
+		{
+			TextureRegion region;
+			return mutexTable.GetTexture(handle, &region) != nullptr;
+		}, [&](size_t i) { mutexTable.Touch(handles[i % handles.size()]); }, missCount);
+
+		// 書き込み側はロックを取る操作（参照の追加と解放）を続ける
+		auto churn = [&](size_t) { manager.ReleaseTexture(manager.AcquireTexture("handle_0.png")); };
+		const double getRate = MeasureLookups(threadCount, handles, [&manager](TextureHandle handle)
+		{
+			TextureRegion region;
+			return manager.GetTexture(handle, nullptr, &region) != nullptr;
+		}, churn, missCount);
+		const double peekRate = MeasureLookups(threadCount, handles, [&manager](TextureHandle handle)
+		{
+			TextureRegion region;
+			return manager.PeekTexture(handle, nullptr, &region) != nullptr;
+		}, churn, missCount);
+		std::printf("  %7zu  %9.1f   %10.1f  %11.1f   (x%.1f / x%.1f)\n", threadCount, mutexRate, getRate, peekRate,
+			getRate / mutexRate, peekRate / mutexRate);
+	}
+	check(missCount == 0, "every lookup of a live handle succeeds during concurrent writes");
+	check(manager.GetTexture(churnHandle) != nullptr, "reference churn keeps the shared texture alive");
+
+	// 解放したハンドルは、同じスロットを使い回した後も見つからない
+	const TextureHandle released = handles.back();
+	manager.ReleaseTexture(released);
+	const TextureHandle reused = manager.AcquireTexture("handle_reused.png");
+	check(manager.PeekTexture(released) == nullptr && manager.GetTexture(released) == nullptr && reused != released &&
+		HandleTable<int>::GetIndex(reused) == HandleTable<int>::GetIndex(released), "released handles stay invalid after their slot is reused");
+	manager.Clear();
+	check(manager.PeekTexture(handles.front()) == nullptr && manager.PeekTexture(reused) == nullptr, "Clear invalidates every handle");
+
+	manager.SetLoader(nullptr);
+	return check.Report();
+}
@@ -0,0 +1,336 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/MappedFile.h"
+#include "Analyzer/TextureAtlas.h"
+#include "Analyzer/TextureMips.h"
+#include "RHI/TextureAssetManager.h"
+#include "System/ContentHash.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr uint32_t kHotReloadTextureCount = 32;
+	constexpr uint32_t kHotReloadTextureSize = 512;
+	/// 編集を模して書き換える範囲の一辺
+	constexpr uint32_t kHotReloadEditSize = 16;
+	/// 検証中はスレッドに頼らず PollHotReload で進め、反映時間の計測だけスレッドで監視する
+	constexpr auto kHotReloadManualInterval = std::chrono::hours(1);
+	constexpr auto kHotReloadWatchInterval = std::chrono::milliseconds(10);
+
+	/// 先頭に幅と高さ（uint32_t）を置いた RGBA8 のファイル
+	void WriteRawTexture(const std::filesystem::path& path, uint32_t width, uint32_t height, uint32_t seed, size_t truncateTo = SIZE_MAX)
+	{
+		std::vector<uint8_t> bytes(8 + static_cast<size_t>(width) * height * 4);
+		std::memcpy(&bytes[0], &width, 4);
+		std::memcpy(&bytes[4], &height, 4);
+		for (size_t i = 8; i < bytes.size(); ++i)
+		{
+			bytes[i] = static_cast<uint8_t>((i >> 2) * 7 + seed);
+		}
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>((std::min)(truncateTo, bytes.size())));
+	}
+
+	/// 左上の一部だけを塗り替えます（アーティストの小さな編集を模す）。
+	void EditRawTexture(const std::filesystem::path& path, uint8_t value)
+	{
+		std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+		uint32_t width = 0;
+		stream.read(reinterpret_cast<char*>(&width), 4);
+		const std::vector<char> row(static_cast<size_t>(kHotReloadEditSize) * 4, static_cast<char>(value));
+		for (uint32_t y = 0; y < kHotReloadEditSize; ++y)
+		{
+			stream.seekp(8 + static_cast<std::streamoff>(y) * width * 4);
+			stream.write(row.data(), static_cast<std::streamsize>(row.size()));
+		}
+	}
+
+	struct RawDecodedTexture final : DecodedTexture
+	{
+		std::vector<TextureMips::Level> levels;
+	};
+
+	/// ミップごとの内容のハッシュだけを持つテクスチャ。UpdateTextureMips で書き換えられる
+	class RawTexture final : public RHITexture
+	{
+	public:
+		void* GetTextureBuffer() const override { return nullptr; }
+
+		uint32_t width = 0;
+		uint32_t height = 0;
+		std::vector<uint64_t> mipHashes;
+	};
+
+	/// ファイルを読んで Box フィルタでミップを作るローダー。サイズの合わないファイル（書き込み途中）は失敗
+	class RawTextureLoader final : public ITextureLoader
+	{
+	public:
+		bool IsAvailable() const override { return true; }
+
+		std::unique_ptr<DecodedTexture> Decode(const std::string& path) override
+		{
+			TextureAtlas::Image image;
+			if (!DecodePixels(path, image))
+			{
+				return nullptr;
+			}
+			auto decoded = std::make_unique<RawDecodedTexture>();
+			decoded->levels = TextureMips::Generate(image.pixels.data(), image.width, image.height,
+				static_cast<size_t>(image.width) * 4, TextureMips::Filter::Box, false);
+			return decoded;
+		}
+
+		std::shared_ptr<RHITexture> CreateTexture(const DecodedTexture& decoded) override
+		{
+			const RawDecodedTexture& raw = static_cast<const RawDecodedTexture&>(decoded);
+			auto texture = std::make_shared<RawTexture>();
+			texture->width = raw.levels.front().width;
+			texture->height = raw.levels.front().height;
+			GetMipHashes(decoded, texture->mipHashes);
+			++createCount;
+			return texture;
+		}
+
+		std::shared_ptr<RHITexture> CreatePlaceholderTexture() override
+		{
+			return std::make_shared<RawTexture>();
+		}
+
+		bool DecodePixels(const std::string& path, TextureAtlas::Image& outImage) override
+		{
+			MappedFile file;
+			if (!file.Open(path) || file.GetSize() < 8)
+			{
+				return false;
+			}
+			std::memcpy(&outImage.width, file.GetData(), 4);
+			std::memcpy(&outImage.height, file.GetData() + 4, 4);
+			const size_t pixelBytes = static_cast<size_t>(outImage.width) * outImage.height * 4;
+			if (outImage.width == 0 || outImage.height == 0 || file.GetSize() != 8 + pixelBytes)
+			{
+				return false;
+			}
+			outImage.pixels.assign(file.GetData() + 8, file.GetData() + 8 + pixelBytes);
+			return true;
+		}
+
+		std::unique_ptr<DecodedTexture> DecodeAtlasPage(const TextureAtlas::Image& page, uint32_t padding) override
+		{
+			(void)padding;
+			auto decoded = std::make_unique<RawDecodedTexture>();
+			decoded->levels = TextureMips::Generate(page.pixels.data(), page.width, page.height,
+				static_cast<size_t>(page.width) * 4, TextureMips::Filter::Box, false);
+			return decoded;
+		}
+
+		bool GetMipLayout(const DecodedTexture& decoded, uint32_t& outWidth, uint32_t& outHeight, std::vector<uint64_t>& outMipBytes) override
+		{
+			const RawDecodedTexture& raw = static_cast<const RawDecodedTexture&>(decoded);
+			outWidth = raw.levels.front().width;
+			outHeight = raw.levels.front().height;
+			outMipBytes.clear();
+			for (const TextureMips::Level& level : raw.levels)
+			{
+				outMipBytes.push_back(level.pixels.size());
+			}
+			return true;
+		}
+
+		bool GetMipHashes(const DecodedTexture& decoded, std::vector<uint64_t>& outHashes) override
+		{
+			outHashes.clear();
+			for (const TextureMips::Level& level : static_cast<const RawDecodedTexture&>(decoded).levels)
+			{
+				outHashes.push_back(ContentHash::Compute(level.pixels.data(), level.pixels.size()));
+			}
+			return true;
+		}
+
+		bool UpdateTextureMips(RHITexture& texture, const DecodedTexture& decoded, const std::vector<uint32_t>& mips) override
+		{
+			RawTexture& raw = static_cast<RawTexture&>(texture);
+			std::vector<uint64_t> hashes;
+			GetMipHashes(decoded, hashes);
+			const TextureMips::Level& top = static_cast<const RawDecodedTexture&>(decoded).levels.front();
+			if (top.width != raw.width || top.height != raw.height || hashes.size() != raw.mipHashes.size())
+			{
+				return false;
+			}
+			for (uint32_t mip : mips)
+			{
+				raw.mipHashes[mip] = hashes[mip];
+				++updatedMipCount;
+			}
+			return true;
+		}
+
+		std::atomic<size_t> createCount{ 0 };
+		std::atomic<size_t> updatedMipCount{ 0 };
+	};
+}
+
+int RunHotReloadBenchmark()
+{
+	CheckResults check;
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "RuntimeBench_hotreload";
+	std::filesystem::remove_all(directory);
+	std::filesystem::create_directories(directory);
+	std::vector<std::string> paths;
+	for (uint32_t i = 0; i < kHotReloadTextureCount; ++i)
+	{
+		paths.push_back((directory / ("texture_" + std::to_string(i) + ".raw")).string());
+		WriteRawTexture(paths.back(), kHotReloadTextureSize, kHotReloadTextureSize, i);
+	}
+
+	TextureAssetManager& manager = TextureAssetManager::Get();
+	auto loader = std::make_shared<RawTextureLoader>();
+	manager.SetLoader(loader);
+	auto finishPending = [&manager]()
+	{
+		size_t frames = 0;
+		manager.ProcessPendingTextures(0);
+		while (manager.GetPendingCount() > 0 && frames++ < kMaxTextureFrames)
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			manager.ProcessPendingTextures(0);
+		}
+	};
+	// 1 回目で変化を見つけ、2 回目で書き終わっていることを確かめる
+	auto detectAndReload = [&manager, &finishPending]()
+	{
+		manager.PollHotReload();
+		manager.PollHotReload();
+		finishPending();
+	};
+
+	// PIE の再起動に相当する、全テクスチャの読み込み。監視はエディターと同じく読み込む前から有効にする
+	// （有効にする前に読み込んだものはミップのハッシュが無く、最初の反映で全ミップを書き込む）
+	manager.SetHotReloadEnabled(true, kHotReloadManualInterval);
+	const auto fullBegin = std::chrono::steady_clock::now();
+	std::vector<TextureHandle> handles;
+	for (const std::string& path : paths)
+	{
+		handles.push_back(manager.AcquireTexture(path.c_str()));
+	}
+	finishPending();
+	const double fullMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - fullBegin).count();
+
+	check(manager.GetHotReloadStatistics().watchedFileCount == kHotReloadTextureCount, "loaded textures are watched");
+
+	// 同じ大きさの編集は、今のテクスチャの変わったミップだけに書き込む
+	const std::shared_ptr<RHITexture> edited = manager.GetTexture(handles[0]);
+	const std::vector<uint64_t> editedHashes = static_cast<const RawTexture&>(*edited).mipHashes;
+	EditRawTexture(paths[0], 0x10);
+	detectAndReload();
+	TextureAssetManager::HotReloadStatistics statistics = manager.GetHotReloadStatistics();
+	const std::vector<uint64_t>& reloadedHashes = static_cast<const RawTexture&>(*manager.GetTexture(handles[0])).mipHashes;
+	size_t expectedMips = 0;
+	for (size_t mip = 0; mip < editedHashes.size(); ++mip)
+	{
+		expectedMips += editedHashes[mip] != reloadedHashes[mip] ? 1 : 0;
+	}
+	check(statistics.inPlaceCount == 1 && manager.GetTexture(handles[0]) == edited, "same-size edit updates the existing texture");
+	check(reloadedHashes.front() != editedHashes.front() && statistics.uploadedMipCount == expectedMips &&
+		loader->updatedMipCount == expectedMips, "only changed mips are uploaded");
+	const uint64_t editMips = statistics.uploadedMipCount;
+	const uint64_t editBytes = statistics.uploadedBytes;
+
+	// 内容の同じ保存は何も書き込まない
+	WriteRawTexture(paths[1], kHotReloadTextureSize, kHotReloadTextureSize, 1);
+	detectAndReload();
+	statistics = manager.GetHotReloadStatistics();
+	check(statistics.unchangedCount == 1 && statistics.uploadedMipCount == editMips, "saving identical content uploads nothing");
+
+	// 大きさが変わったら新しいテクスチャに差し替え、ハンドルはそのまま
+	const std::shared_ptr<RHITexture> resized = manager.GetTexture(handles[2]);
+	const size_t createCount = loader->createCount;
+	WriteRawTexture(paths[2], kHotReloadTextureSize / 2, kHotReloadTextureSize, 2);
+	detectAndReload();
+	TextureAssetManager::TextureState state = TextureAssetManager::TextureState::Failed;
+	const std::shared_ptr<RHITexture> swapped = manager.GetTexture(handles[2], &state);
+	check(manager.GetHotReloadStatistics().swappedCount == 1 && swapped != resized && loader->createCount == createCount + 1 &&
+		state == TextureAssetManager::TextureState::Ready && static_cast<const RawTexture&>(*swapped).width == kHotReloadTextureSize / 2,
+		"resized texture is swapped behind the same handle");
+
+	// 書き込み途中のファイルは読めないので前のまま。書き終われば反映する
+	const std::shared_ptr<RHITexture> partial = manager.GetTexture(handles[3]);
+	WriteRawTexture(paths[3], kHotReloadTextureSize, kHotReloadTextureSize, 99, 1000);
+	detectAndReload();
+	check(manager.GetHotReloadStatistics().failedCount == 1 && manager.GetTexture(handles[3], &state) == partial &&
+		state == TextureAssetManager::TextureState::Ready, "failed reload keeps the previous texture");
+	WriteRawTexture(paths[3], kHotReloadTextureSize, kHotReloadTextureSize, 99);
+	detectAndReload();
+	check(manager.GetHotReloadStatistics().inPlaceCount == 2 && manager.GetTexture(handles[3]) == partial, "completed write is reloaded");
+
+	// 解放したテクスチャは監視から外れる
+	const size_t reloadCount = manager.GetHotReloadStatistics().reloadCount;
+	manager.ReleaseTexture(handles[4]);
+	EditRawTexture(paths[4], 0x20);
+	detectAndReload();
+	statistics = manager.GetHotReloadStatistics();
+	check(statistics.watchedFileCount == kHotReloadTextureCount - 1 && statistics.reloadCount == reloadCount, "released texture is no longer watched");
+
+	// アトラスに入っていたテクスチャは、書き換わると単独のテクスチャとして読み込み直す
+	std::vector<std::string> spritePaths;
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		spritePaths.push_back((directory / ("sprite_" + std::to_string(i) + ".raw")).string());
+		WriteRawTexture(spritePaths.back(), 32, 32, 200 + i);
+	}
+	const TextureHandle atlas = manager.AcquireAtlas(spritePaths);
+	finishPending();
+	const TextureHandle sprite = manager.AcquireTexture(spritePaths[0].c_str());
+	TextureRegion region;
+	const std::shared_ptr<RHITexture> page = manager.GetTexture(sprite, nullptr, &region);
+	check(page != nullptr && page == manager.GetTexture(atlas) && region.u1 < 1.0f, "sprite resolves into the atlas page");
+	EditRawTexture(spritePaths[0], 0x30);
+	detectAndReload();
+	const std::shared_ptr<RHITexture> standalone = manager.GetTexture(sprite, &state, &region);
+	check(standalone != page && state == TextureAssetManager::TextureState::Ready && region.u0 == 0.0f && region.u1 == 1.0f &&
+		manager.GetTexture(atlas) == page, "edited sprite leaves the atlas without touching the page");
+	manager.ReleaseTexture(sprite);
+	manager.ReleaseTexture(atlas);
+
+	// 監視のスレッドで、保存してから反映されるまでの時間
+	manager.SetHotReloadEnabled(true, kHotReloadWatchInterval);
+	const size_t reloadsBefore = manager.GetHotReloadStatistics().reloadCount;
+	const auto editBegin = std::chrono::steady_clock::now();
+	EditRawTexture(paths[5], 0x40);
+	size_t frames = 0;
+	while (manager.GetHotReloadStatistics().reloadCount == reloadsBefore && frames++ < kMaxTextureFrames)
+	{
+		manager.ProcessPendingTextures();
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	const double watchMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - editBegin).count();
+	check(manager.GetHotReloadStatistics().reloadCount == reloadsBefore + 1, "watcher thread picks up the edit");
+
+	statistics = manager.GetHotReloadStatistics();
+	std::printf("%u textures %ux%u RGBA8, edit %ux%u texels\n", kHotReloadTextureCount, kHotReloadTextureSize, kHotReloadTextureSize,
+		kHotReloadEditSize, kHotReloadEditSize);
+	std::printf("  reload everything (PIE restart): %8.2f ms\n", fullMs);
+	std::printf("  hot reload one edit            : %8.2f ms from save to publish (%lld ms poll interval, %.2f ms of it decoding and publishing)\n",
+		watchMs, static_cast<long long>(kHotReloadWatchInterval.count()), statistics.lastLatencyMs);
+	std::printf("  edit uploaded %llu of %zu mips (%.1f KB)\n", static_cast<unsigned long long>(editMips), editedHashes.size(), editBytes / 1024.0);
+	std::printf("  manager  : %s\n", manager.FormatHotReloadReport().c_str());
+
+	manager.Clear();
+	check(manager.GetHotReloadStatistics().watchedFileCount == 0, "Clear stops watching every file");
+
+	manager.SetHotReloadEnabled(false);
+	manager.SetLoader(nullptr);
+	std::error_code ec;
+	std::filesystem::remove_all(directory, ec);
+	return check.Report();
+}
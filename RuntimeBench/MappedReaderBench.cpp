@@ -0,0 +1,324 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/MappedFile.h"
+#include "Analyzer/PMDMappedReader.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+	/// 読み込み時間を平均する回数
+	constexpr int kMappedLoadIterations = 20;
+	/// ヘッダーと必須セクションの境目のほかに、ファイル全体を等分して切り詰める位置の数
+	constexpr size_t kTruncationSteps = 48;
+
+	/// 以前の PMDAnalyzer が読み込み先にしていた頂点（先頭の 38 バイトに読み、残りはパディング）
+	struct LegacyVertex
+	{
+		float pos[3];
+		float normal[3];
+		float uv[2];
+		unsigned short boneIndex[2];
+		unsigned char boneWeight;
+		unsigned char edgeFlag;
+	};
+
+	std::FILE* OpenForRead(const std::filesystem::path& path)
+	{
+		std::FILE* file = nullptr;
+#ifdef _WIN32
+		_wfopen_s(&file, path.c_str(), L"rb");
+#else
+		file = std::fopen(path.c_str(), "rb");
+#endif
+		return file;
+	}
+
+	/// 以前の PMDAnalyzer と同じ読み込み。ヘッダーと頂点数を読み、頂点ごとに 38 バイトずつ fread します。
+	bool LoadVerticesWithFread(const std::filesystem::path& path, std::vector<LegacyVertex>& outVertices)
+	{
+		std::FILE* file = OpenForRead(path);
+		if (file == nullptr)
+		{
+			return false;
+		}
+		PMD::HeaderRecord header;
+		uint32_t vertexCount = 0;
+		bool isRead = std::fread(&header, sizeof(header), 1, file) == 1 &&
+			std::fread(&vertexCount, sizeof(vertexCount), 1, file) == 1;
+		if (isRead)
+		{
+			outVertices.resize(vertexCount);
+			for (uint32_t i = 0; i < vertexCount && isRead; ++i)
+			{
+				isRead = std::fread(&outVertices[i], sizeof(PMD::VertexRecord), 1, file) == 1;
+			}
+		}
+		std::fclose(file);
+		return isRead;
+	}
+
+	/// 今の PMDAnalyzer と同じ読み込み。マップして全セクションを検証し、頂点セクションを 1 回の走査で写します。
+	bool LoadVerticesWithMapping(const std::filesystem::path& path, std::vector<LegacyVertex>& outVertices)
+	{
+		PMDMappedReader reader;
+		if (!reader.Open(path))
+		{
+			return false;
+		}
+		const auto vertices = reader.GetVertices();
+		outVertices.resize(vertices.Size());
+		const uint8_t* source = vertices.RawData();
+		for (size_t i = 0; i < outVertices.size(); ++i)
+		{
+			std::memcpy(&outVertices[i], source + i * sizeof(PMD::VertexRecord), sizeof(PMD::VertexRecord));
+		}
+		return true;
+	}
+
+	/// 1 回あたりの読み込み時間（ミリ秒）。1 回目でファイルをキャッシュに載せてから計測します。
+	template <typename TLoad>
+	double MeasureLoadMs(const std::filesystem::path& path, TLoad load)
+	{
+		std::vector<LegacyVertex> vertices;
+		load(path, vertices);
+		const auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < kMappedLoadIterations; ++i)
+		{
+			std::vector<LegacyVertex> timedVertices;
+			load(path, timedVertices);
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / kMappedLoadIterations;
+	}
+
+	bool AreVerticesEqual(const std::vector<LegacyVertex>& a, const std::vector<LegacyVertex>& b)
+	{
+		if (a.size() != b.size())
+		{
+			return false;
+		}
+		for (size_t i = 0; i < a.size(); ++i)
+		{
+			if (std::memcmp(&a[i], &b[i], sizeof(PMD::VertexRecord)) != 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::vector<uint8_t> ReadFileBytes(const std::filesystem::path& path)
+	{
+		std::ifstream stream(path, std::ios::binary);
+		return std::vector<uint8_t>(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+	}
+
+	void WriteFileBytes(const std::filesystem::path& path, const uint8_t* data, size_t size)
+	{
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		stream.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(size));
+	}
+
+	/// view が全てマップ領域の中にあるか
+	template <typename TRecord>
+	bool IsViewInside(const PMDMappedReader& reader, const PMDRecordView<TRecord>& view)
+	{
+		if (view.Empty())
+		{
+			return true;
+		}
+		const uint8_t* begin = reader.GetFileData();
+		return view.RawData() >= begin && view.RawData() + view.SizeInBytes() <= begin + reader.GetFileSize();
+	}
+
+	/// 開けたリーダーの全てのビュー（IK のチェーンと表情の頂点を含む）がファイルの中にあるか
+	bool AreViewsInside(const PMDMappedReader& reader)
+	{
+		bool isInside = IsViewInside(reader, reader.GetVertices()) && IsViewInside(reader, reader.GetIndices()) &&
+			IsViewInside(reader, reader.GetMaterials()) && IsViewInside(reader, reader.GetBones()) &&
+			IsViewInside(reader, reader.GetSkinDisplays()) && IsViewInside(reader, reader.GetBoneDisplayNames()) &&
+			IsViewInside(reader, reader.GetBoneDisplays()) && IsViewInside(reader, reader.GetEnglishBoneNames()) &&
+			IsViewInside(reader, reader.GetEnglishSkinNames()) && IsViewInside(reader, reader.GetEnglishBoneDisplayNames()) &&
+			IsViewInside(reader, reader.GetToonTextures());
+		for (const PMDIKView& ik : reader.GetIKs())
+		{
+			isInside = isInside && IsViewInside(reader, ik.chain);
+		}
+		for (const PMDSkinView& skin : reader.GetSkins())
+		{
+			isInside = isInside && IsViewInside(reader, skin.vertices);
+		}
+		return isInside;
+	}
+
+	/// MappedFile の開閉・ムーブ・空のファイル・存在しないファイルの扱いを確認します。
+	void CheckMappedFile(const std::filesystem::path& directory, const std::vector<uint8_t>& contents, CheckResults& check)
+	{
+		const std::filesystem::path path = directory / "contents.bin";
+		WriteFileBytes(path, contents.data(), contents.size());
+
+		MappedFile file;
+		check(file.Open(path) && file.IsOpen(), "MappedFile opens an existing file");
+		check(file.GetSize() == contents.size() && std::memcmp(file.GetData(), contents.data(), contents.size()) == 0,
+			"MappedFile maps the same bytes as a stream read");
+
+		MappedFile moved(std::move(file));
+		check(!file.IsOpen() && file.GetData() == nullptr && file.GetSize() == 0, "a moved-from MappedFile is closed");
+		check(moved.IsOpen() && moved.GetSize() == contents.size() && moved.GetData()[0] == contents[0],
+			"a moved-to MappedFile keeps the mapping");
+		moved.Close();
+		check(!moved.IsOpen() && moved.GetData() == nullptr && moved.GetSize() == 0, "Close releases the mapping");
+
+		const std::filesystem::path emptyPath = directory / "empty.bin";
+		WriteFileBytes(emptyPath, nullptr, 0);
+		MappedFile empty;
+		check(empty.Open(emptyPath) && empty.GetSize() == 0 && empty.GetData() == nullptr,
+			"an empty file opens without a mapping");
+
+		MappedFile missing;
+		check(!missing.Open(directory / "missing.bin") && !missing.IsOpen(), "a missing file does not open");
+	}
+
+	///=================================================================
+	/// 1 体のモデルを切り詰めたり数を書き換えたりして開き直し、必須のセクション（枠表示まで）が
+	/// 欠けたファイルは開けないこと、開けた場合もビューがファイルの外を指さないことを確認します。
+	///=================================================================
+	void CheckDamagedModel(const std::filesystem::path& directory, const std::vector<uint8_t>& contents,
+		const PMDMappedReader& original, CheckResults& check)
+	{
+		const std::filesystem::path path = directory / "damaged.pmd";
+		const auto boneDisplays = original.GetBoneDisplays();
+		const size_t requiredSize = static_cast<size_t>(boneDisplays.RawData() + boneDisplays.SizeInBytes() - original.GetFileData());
+
+		std::vector<size_t> cuts = { 0, 1, sizeof(PMD::HeaderRecord) - 1, sizeof(PMD::HeaderRecord),
+			sizeof(PMD::HeaderRecord) + 3, requiredSize - 1, requiredSize, contents.size() - 1 };
+		for (size_t step = 1; step < kTruncationSteps; ++step)
+		{
+			cuts.push_back(contents.size() * step / kTruncationSteps);
+		}
+
+		bool isShortRejected = true;
+		bool isInside = true;
+		for (size_t cut : cuts)
+		{
+			WriteFileBytes(path, contents.data(), cut);
+			PMDMappedReader reader;
+			const bool isOpened = reader.Open(path);
+			isShortRejected = isShortRejected && (cut >= requiredSize || (!isOpened && !reader.IsValid()));
+			isInside = isInside && (!isOpened || AreViewsInside(reader));
+		}
+		check(isShortRejected, "a file cut before the end of the bone display section does not open");
+		check(isInside, "a truncated file that still opens has every view inside the file");
+
+		// 数を書き換えて、それ以降のセクションがファイルの外にはみ出すようにする
+		const auto openPatched = [&](size_t offset, const void* value, size_t size)
+		{
+			std::vector<uint8_t> patched = contents;
+			std::memcpy(patched.data() + offset, value, size);
+			WriteFileBytes(path, patched.data(), patched.size());
+			PMDMappedReader reader;
+			return reader.Open(path);
+		};
+		const auto offsetOf = [&](const void* field)
+		{
+			return static_cast<size_t>(static_cast<const uint8_t*>(field) - original.GetFileData());
+		};
+		const uint32_t hugeCount = 0xFFFFFFFFu;
+		check(!openPatched(0, "Pmx", 3), "a file with another signature does not open");
+		check(!openPatched(sizeof(PMD::HeaderRecord), &hugeCount, sizeof(hugeCount)), "a vertex count past the end does not open");
+		check(!openPatched(offsetOf(original.GetIndices().RawData()) - sizeof(uint32_t), &hugeCount, sizeof(hugeCount)),
+			"an index count past the end does not open");
+		if (!original.GetSkins().empty())
+		{
+			check(!openPatched(offsetOf(&original.GetSkins().back().record->vertexCount), &hugeCount, sizeof(hugeCount)),
+				"a morph vertex count past the end does not open");
+		}
+	}
+}
+
+///=======================================================================
+/// <summary>
+/// MappedFile と PMDMappedReader を確かめ、頂点の読み込みを以前の PMDAnalyzer（頂点ごとの fread）と比べます。
+/// 指定したモデルごとに、2 つの読み込みで頂点が一致すること、切り詰めたり数を書き換えたりしたファイルを
+/// 開けないことを確認します。どちらもファイルがキャッシュに載った状態での時間です。
+/// </summary>
+///=======================================================================
+int RunMappedReaderBenchmark(const std::vector<std::filesystem::path>& inputs)
+{
+	CheckResults check;
+	check(!inputs.empty(), "at least one model is given");
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "RuntimeBench_mapped";
+	std::error_code ec;
+	std::filesystem::remove_all(directory, ec);
+	std::filesystem::create_directories(directory);
+
+	double totalFreadMs = 0.0;
+	double totalMappedMs = 0.0;
+	size_t openedCount = 0;
+	size_t matchedCount = 0;
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		const std::filesystem::path& input = inputs[i];
+		PMDMappedReader reader;
+		if (!reader.Open(input))
+		{
+			std::printf("%s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+			continue;
+		}
+		++openedCount;
+
+		std::vector<LegacyVertex> freadVertices;
+		std::vector<LegacyVertex> mappedVertices;
+		const bool isMatched = LoadVerticesWithFread(input, freadVertices) && LoadVerticesWithMapping(input, mappedVertices) &&
+			AreVerticesEqual(freadVertices, mappedVertices);
+		matchedCount += isMatched ? 1 : 0;
+
+		const std::vector<uint8_t> contents = ReadFileBytes(input);
+		if (i == 0)
+		{
+			CheckMappedFile(directory, contents, check);
+		}
+		CheckDamagedModel(directory, contents, reader, check);
+
+		const double freadMs = MeasureLoadMs(input, LoadVerticesWithFread);
+		const double mappedMs = MeasureLoadMs(input, LoadVerticesWithMapping);
+		totalFreadMs += freadMs;
+		totalMappedMs += mappedMs;
+		std::printf("%s (vertices %zu, %zu bytes): fread %.3f ms, mapped %.3f ms (x%.1f)%s\n",
+			ToDisplayString(input.filename()).c_str(), reader.GetVertices().Size(), contents.size(), freadMs, mappedMs,
+			mappedMs > 0.0 ? freadMs / mappedMs : 0.0, isMatched ? "" : "  MISMATCH");
+	}
+
+	if (openedCount > 0)
+	{
+		PMDMappedReader reader;
+		reader.Open(inputs.front());
+		bool isThrown = false;
+		try
+		{
+			reader.GetVertices().At(reader.GetVertices().Size());
+		}
+		catch (const std::out_of_range&)
+		{
+			isThrown = true;
+		}
+		check(isThrown, "PMDRecordView::At throws past the last record");
+	}
+
+	std::filesystem::remove_all(directory, ec);
+
+	std::printf("total: fread %.3f ms, mapped %.3f ms (x%.1f)\n", totalFreadMs, totalMappedMs,
+		totalMappedMs > 0.0 ? totalFreadMs / totalMappedMs : 0.0);
+	check(openedCount == inputs.size(), "every model opens with PMDMappedReader");
+	check(matchedCount == openedCount, "the mapped reader yields the same vertices as the per-vertex fread");
+	return check.Report();
+}
@@ -0,0 +1,317 @@
+﻿#include "BenchCommon.h"
+
+#include "System/ResourceAccounting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kMemoryQuadCount = 500;
+	/// 前半でクアッドを増やし、後半で半分を破棄する
+	constexpr size_t kMemoryFrames = 120;
+	constexpr size_t kMemoryTextureCount = 32;
+	constexpr uint32_t kMemoryTextureSize = 256;
+	/// D3D12 のコミット済みリソースの配置単位と、定数バッファビューの整列
+	constexpr uint64_t kMemoryPlacementAlignment = 64ull * 1024;
+	constexpr uint64_t kMemoryConstantBufferAlignment = 256;
+	/// QuadRenderObject の頂点（位置 + UV）4 つ、インデックス 6 つ、ワールド行列 1 つ
+	constexpr uint64_t kMemoryQuadVertexBytes = 4 * 20;
+	constexpr uint64_t kMemoryQuadIndexBytes = 6 * sizeof(uint16_t);
+	constexpr uint64_t kMemoryQuadConstantBytes = 16 * sizeof(float);
+	constexpr uint32_t kMemoryDescriptorCount = 1000;
+	constexpr uint64_t kMemoryDescriptorBytes = 32;
+
+	///=======================================================================
+	/// <summary>
+	/// GPU の代わりに D3D12 の配置規則だけを模して ResourceAccounting に報告するデバイス。
+	/// コミット済みリソースは 64KB 単位で確保され、ディスクリプタは 1 つのヒープから取ります。
+	/// </summary>
+	///=======================================================================
+	class NullResourceDevice
+	{
+	public:
+		explicit NullResourceDevice(ResourceAccounting& accounting) : m_Accounting(accounting)
+		{
+			m_Heap = m_Accounting.TrackScoped(ResourceCategory::Descriptor, "Null", "GlobalTextureHeap",
+				0, static_cast<uint64_t>(kMemoryDescriptorCount) * kMemoryDescriptorBytes);
+		}
+
+		static uint64_t AlignUp(uint64_t value, uint64_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+		ResourceAccounting::TrackedAllocation CreateCommitted(ResourceCategory category, const char* owner, uint64_t requestedBytes,
+			uint64_t resourceBytes)
+		{
+			return m_Accounting.TrackScoped(category, "Null", owner, requestedBytes, AlignUp(resourceBytes, kMemoryPlacementAlignment));
+		}
+
+		/// 空きが無ければ false
+		bool AllocateDescriptor()
+		{
+			if (m_UsedDescriptors >= kMemoryDescriptorCount)
+			{
+				return false;
+			}
+			++m_UsedDescriptors;
+			m_Heap.SetRequestedBytes(static_cast<uint64_t>(m_UsedDescriptors) * kMemoryDescriptorBytes);
+			return true;
+		}
+
+		void FreeDescriptor()
+		{
+			--m_UsedDescriptors;
+			m_Heap.SetRequestedBytes(static_cast<uint64_t>(m_UsedDescriptors) * kMemoryDescriptorBytes);
+		}
+
+	private:
+		ResourceAccounting& m_Accounting;
+		ResourceAccounting::TrackedAllocation m_Heap;
+		uint32_t m_UsedDescriptors = 0;
+	};
+
+	/// QuadRenderObject と同じく、頂点・インデックス・定数バッファを 1 つずつコミット済みリソースにする
+	struct NullQuad
+	{
+		NullQuad(NullResourceDevice& device, bool isConstantBufferShared) : m_Device(device)
+		{
+			vertexBuffer = device.CreateCommitted(ResourceCategory::VertexBuffer, "QuadRenderObject", kMemoryQuadVertexBytes, kMemoryQuadVertexBytes);
+			indexBuffer = device.CreateCommitted(ResourceCategory::IndexBuffer, "QuadRenderObject", kMemoryQuadIndexBytes, kMemoryQuadIndexBytes);
+			if (!isConstantBufferShared)
+			{
+				constantBuffer = device.CreateCommitted(ResourceCategory::ConstantBuffer, "DX12FrameConstantBuffer", kMemoryQuadConstantBytes,
+					NullResourceDevice::AlignUp(kMemoryQuadConstantBytes, kMemoryConstantBufferAlignment));
+				hasDescriptor = device.AllocateDescriptor();
+			}
+		}
+		~NullQuad()
+		{
+			if (hasDescriptor)
+			{
+				m_Device.FreeDescriptor();
+			}
+		}
+		NullQuad(const NullQuad&) = delete;
+		NullQuad& operator=(const NullQuad&) = delete;
+
+		NullResourceDevice& m_Device;
+		ResourceAccounting::TrackedAllocation vertexBuffer;
+		ResourceAccounting::TrackedAllocation indexBuffer;
+		ResourceAccounting::TrackedAllocation constantBuffer;
+		bool hasDescriptor = false;
+	};
+
+	/// 区切り文字で数えた列の数
+	size_t CountColumns(const std::string& line)
+	{
+		return static_cast<size_t>(std::count(line.begin(), line.end(), ',')) + 1;
+	}
+
+	size_t CountOccurrences(const std::string& text, const std::string& pattern)
+	{
+		size_t count = 0;
+		for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + pattern.size()))
+		{
+			++count;
+		}
+		return count;
+	}
+
+	std::string ReadTextFile(const std::filesystem::path& path)
+	{
+		std::ifstream file(path, std::ios::binary);
+		return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+	}
+
+	/// ResourceAccounting のトレース（拡張子が .json なら JSON、それ以外は CSV）に kMemoryFrames フレーム分があるか
+	void CheckMemoryTrace(const std::filesystem::path& path, CheckResults& check)
+	{
+		const std::string text = ReadTextFile(path);
+		std::printf("  trace: %s (%zu bytes)\n", ToDisplayString(path).c_str(), text.size());
+		if (path.extension() == ".json")
+		{
+			check(text.size() > 4 && text.compare(0, 2, "[\n") == 0 && text.compare(text.size() - 3, 3, "\n]\n") == 0 &&
+				CountOccurrences(text, "{\"frame\":") == kMemoryFrames, "the JSON trace is an array with one object per frame");
+			return;
+		}
+
+		// ヘッダーと各フレームの列の数が揃っている
+		std::vector<std::string> lines;
+		for (size_t start = 0; start < text.size();)
+		{
+			const size_t end = text.find('\n', start);
+			lines.push_back(text.substr(start, end - start));
+			start = end == std::string::npos ? text.size() : end + 1;
+		}
+		bool isAligned = lines.size() == kMemoryFrames + 1 && lines.front() + "\n" == ResourceAccounting::FormatCsvHeader();
+		for (const std::string& line : lines)
+		{
+			isAligned = isAligned && CountColumns(line) == CountColumns(lines.front());
+		}
+		check(isAligned, "the CSV trace has a header and one aligned row per frame");
+	}
+
+	///=======================================================================
+	/// <summary>
+	/// null デバイスで 1 つのシーンを動かします。前半で kMemoryQuadCount 個のクアッドを作り、後半で半分を破棄します。
+	/// 定数バッファを共有する場合は、全クアッド分の行列を 256 バイト整列で並べた 1 つのバッファにします。
+	/// </summary>
+	///=======================================================================
+	ResourceAccounting::FrameSnapshot SimulateMemoryScene(ResourceAccounting& accounting, bool isConstantBufferShared,
+		CheckResults& check)
+	{
+		NullResourceDevice device(accounting);
+		ResourceAccounting::TrackedAllocation staging = device.CreateCommitted(ResourceCategory::UploadBuffer, "DX12UploadBackend",
+			16ull * 1024 * 1024, 16ull * 1024 * 1024);
+		std::vector<ResourceAccounting::TrackedAllocation> textures;
+		for (size_t i = 0; i < kMemoryTextureCount; ++i)
+		{
+			uint64_t bytes = 0;
+			for (uint32_t size = kMemoryTextureSize; size > 0; size /= 2)
+			{
+				bytes += static_cast<uint64_t>(size) * size * 4;
+			}
+			textures.push_back(device.CreateCommitted(ResourceCategory::Texture, "DX12Texture", bytes, bytes));
+			device.AllocateDescriptor();
+		}
+		ResourceAccounting::TrackedAllocation sharedConstants;
+		if (isConstantBufferShared)
+		{
+			const uint64_t bytes = kMemoryQuadCount * NullResourceDevice::AlignUp(kMemoryQuadConstantBytes, kMemoryConstantBufferAlignment);
+			sharedConstants = device.CreateCommitted(ResourceCategory::ConstantBuffer, "FrameConstantsRing", kMemoryQuadCount * kMemoryQuadConstantBytes, bytes);
+			device.AllocateDescriptor();
+		}
+
+		std::deque<std::unique_ptr<NullQuad>> quads;
+		const size_t quadsPerFrame = (kMemoryQuadCount + kMemoryFrames / 2 - 1) / (kMemoryFrames / 2);
+		bool isFrameCountConsistent = true;
+		ResourceAccounting::FrameSnapshot latest;
+		for (size_t frame = 0; frame < kMemoryFrames; ++frame)
+		{
+			size_t created = 0;
+			size_t released = 0;
+			if (frame < kMemoryFrames / 2)
+			{
+				for (size_t i = 0; i < quadsPerFrame && quads.size() < kMemoryQuadCount; ++i, ++created)
+				{
+					quads.push_back(std::make_unique<NullQuad>(device, isConstantBufferShared));
+				}
+			}
+			else if (quads.size() > kMemoryQuadCount / 2)
+			{
+				for (size_t i = 0; i < quadsPerFrame && quads.size() > kMemoryQuadCount / 2; ++i, ++released)
+				{
+					quads.pop_front();
+				}
+			}
+			latest = accounting.CaptureFrame();
+			// 最初のフレームはテクスチャーなども含むので数えない
+			if (frame > 0)
+			{
+				isFrameCountConsistent = isFrameCountConsistent &&
+					latest.categories[static_cast<size_t>(ResourceCategory::VertexBuffer)].createdCount == created &&
+					latest.categories[static_cast<size_t>(ResourceCategory::VertexBuffer)].releasedCount == released &&
+					latest.categories[static_cast<size_t>(ResourceCategory::VertexBuffer)].usage.count == quads.size();
+			}
+		}
+		check(isFrameCountConsistent, "per-frame created / released counts follow the simulated scene");
+		check(latest.total.count == accounting.GetTotalUsage().count && latest.frameIndex == kMemoryFrames,
+			"the last snapshot matches the live totals");
+
+		const ResourceAccounting::Usage quadVertices = accounting.GetUsage(ResourceCategory::VertexBuffer, "Null", "QuadRenderObject");
+		check(quadVertices.count == quads.size() && quadVertices.requestedBytes == quads.size() * kMemoryQuadVertexBytes &&
+			quadVertices.allocatedBytes == quads.size() * kMemoryPlacementAlignment, "query by category / backend / owner");
+		check(accounting.GetUsage(ResourceCategory::VertexBuffer, "DirectX12").count == 0, "other backends are filtered out");
+
+		quads.clear();
+		textures.clear();
+		staging.Reset();
+		sharedConstants.Reset();
+		return latest;
+	}
+}
+
+int RunMemoryBenchmark(const std::filesystem::path& tracePathArgument)
+{
+	CheckResults check;
+
+	const std::filesystem::path tracePath = tracePathArgument.empty()
+		? std::filesystem::temp_directory_path() / "RuntimeBench_memory.csv" : tracePathArgument;
+	// 2 つ目のシーンはもう一方の形式で書き出す
+	const std::filesystem::path sharedTracePath = std::filesystem::temp_directory_path() /
+		(tracePath.extension() == ".json" ? "RuntimeBench_memory_shared.csv" : "RuntimeBench_memory_shared.json");
+
+	ResourceAccounting accounting;
+	check(accounting.StartTrace(tracePath), "the trace file can be opened");
+	const auto begin = std::chrono::steady_clock::now();
+	const ResourceAccounting::FrameSnapshot perQuad = SimulateMemoryScene(accounting, false, check);
+	const double perQuadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	accounting.StopTrace();
+	check(accounting.GetTotalUsage().count == 0 && accounting.GetOwnerUsage().empty(), "releasing every resource returns the totals to zero");
+
+	ResourceAccounting sharedAccounting;
+	check(sharedAccounting.StartTrace(sharedTracePath), "the trace file of the shared scene can be opened");
+	const ResourceAccounting::FrameSnapshot shared = SimulateMemoryScene(sharedAccounting, true, check);
+	sharedAccounting.StopTrace();
+
+	std::printf("%zu quads (half destroyed), %zu textures, %zu frames, %.2f ms including accounting\n",
+		kMemoryQuadCount, kMemoryTextureCount, kMemoryFrames, perQuadMs);
+	std::printf("  latest frame with per-quad constant buffers:\n");
+	std::printf("  category         count   requested KB   allocated KB\n");
+	for (size_t index = 0; index < static_cast<size_t>(ResourceCategory::Count); ++index)
+	{
+		const ResourceAccounting::Usage& usage = perQuad.categories[index].usage;
+		std::printf("  %-15s %6llu   %12.1f   %12.1f\n", ResourceCategoryToString(static_cast<ResourceCategory>(index)),
+			static_cast<unsigned long long>(usage.count), usage.requestedBytes / 1024.0, usage.allocatedBytes / 1024.0);
+	}
+	const ResourceAccounting::Usage& perQuadConstants = perQuad.categories[static_cast<size_t>(ResourceCategory::ConstantBuffer)].usage;
+	const ResourceAccounting::Usage& sharedConstants = shared.categories[static_cast<size_t>(ResourceCategory::ConstantBuffer)].usage;
+	const double perQuadRatio = static_cast<double>(perQuadConstants.allocatedBytes) / static_cast<double>(perQuadConstants.requestedBytes);
+	const double sharedRatio = static_cast<double>(sharedConstants.allocatedBytes) / static_cast<double>(sharedConstants.requestedBytes);
+	std::printf("  constant buffers: per-quad %.1f KB allocated for %.1f KB of matrices (x%.0f), shared %.1f KB (x%.1f)\n",
+		perQuadConstants.allocatedBytes / 1024.0, perQuadConstants.requestedBytes / 1024.0, perQuadRatio,
+		sharedConstants.allocatedBytes / 1024.0, sharedRatio);
+	std::printf("  total allocated: per-quad %.1f MB, shared %.1f MB\n",
+		perQuad.total.allocatedBytes / (1024.0 * 1024.0), shared.total.allocatedBytes / (1024.0 * 1024.0));
+	check(perQuadRatio > 100.0 && sharedRatio < 8.0, "the accounting exposes the per-quad constant buffer overhead");
+	const ResourceAccounting::Usage& descriptors = perQuad.categories[static_cast<size_t>(ResourceCategory::Descriptor)].usage;
+	check(descriptors.count == 1 && descriptors.allocatedBytes == kMemoryDescriptorCount * kMemoryDescriptorBytes &&
+		descriptors.requestedBytes == (kMemoryTextureCount + kMemoryQuadCount / 2) * kMemoryDescriptorBytes,
+		"descriptor heap occupancy is reported as requested bytes");
+	check(!perQuad.owners.empty() && perQuad.owners.front().owner == "DX12UploadBackend", "owners are sorted by allocated bytes");
+
+	CheckMemoryTrace(tracePath, check);
+	CheckMemoryTrace(sharedTracePath, check);
+
+	// 報告の移動と履歴の上限
+	ResourceAccounting scratch;
+	ResourceAccounting::TrackedAllocation first = scratch.TrackScoped(ResourceCategory::Texture, "Null", "Scratch", 10, 0);
+	ResourceAccounting::TrackedAllocation moved = std::move(first);
+	check(!first.IsValid() && scratch.GetUsage(ResourceCategory::Texture).count == 1 &&
+		scratch.GetUsage(ResourceCategory::Texture).allocatedBytes == 10, "moving a tracked allocation keeps it reported once");
+	moved.SetRequestedBytes(4);
+	check(scratch.GetUsage(ResourceCategory::Texture).requestedBytes == 4 &&
+		scratch.GetUsage(ResourceCategory::Texture, nullptr, "Scratch").allocatedBytes == 10, "SetRequestedBytes leaves the allocated bytes alone");
+	moved.Reset();
+	for (size_t frame = 0; frame < ResourceAccounting::kHistoryCapacity + 10; ++frame)
+	{
+		scratch.CaptureFrame();
+	}
+	const std::vector<ResourceAccounting::FrameSnapshot> history = scratch.GetHistory();
+	check(history.size() == ResourceAccounting::kHistoryCapacity && history.back().frameIndex == ResourceAccounting::kHistoryCapacity + 10 &&
+		history.front().categories[0].releasedCount == 0, "the history keeps the most recent frames");
+
+	std::error_code error;
+	if (tracePathArgument.empty())
+	{
+		std::filesystem::remove(tracePath, error);
+	}
+	std::filesystem::remove(sharedTracePath, error);
+
+	return check.Report();
+}
@@ -0,0 +1,290 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/MeshOptimizer.h"
+#include "Analyzer/PMDMappedReader.h"
+#include "Analyzer/PMDModelData.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	/// MeshCooker と同じメッシュレットの上限
+	constexpr size_t kMeshletMaxVertices = 64;
+	constexpr size_t kMeshletMaxTriangles = 124;
+	/// 32 ビットのインデックスで確かめる合成グリッドの 1 辺のセル数（頂点数が 16 ビットを超える大きさ）
+	constexpr uint32_t kGridCells = 300;
+
+	/// 三角形を、頂点の巡回順を保ったまま最小の番号が先頭に来るよう回して並べた一覧にします。
+	/// 並べ替えの前後でこの一覧が一致すれば、三角形の集合と向きが保たれています。
+	template <typename TIndex>
+	std::vector<std::array<uint32_t, 3>> GetCanonicalTriangles(const TIndex* indices, size_t indexCount)
+	{
+		std::vector<std::array<uint32_t, 3>> triangles(indexCount / 3);
+		for (size_t t = 0; t < triangles.size(); ++t)
+		{
+			const uint32_t a = indices[t * 3];
+			const uint32_t b = indices[t * 3 + 1];
+			const uint32_t c = indices[t * 3 + 2];
+			if (a <= b && a <= c)
+			{
+				triangles[t] = { a, b, c };
+			}
+			else if (b <= a && b <= c)
+			{
+				triangles[t] = { b, c, a };
+			}
+			else
+			{
+				triangles[t] = { c, a, b };
+			}
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	bool IsPermutation(const std::vector<uint32_t>& remap, size_t vertexCount)
+	{
+		if (remap.size() != vertexCount)
+		{
+			return false;
+		}
+		std::vector<uint8_t> isUsed(vertexCount, 0);
+		for (uint32_t v : remap)
+		{
+			if (v >= vertexCount || isUsed[v])
+			{
+				return false;
+			}
+			isUsed[v] = 1;
+		}
+		return true;
+	}
+
+	/// メッシュレットの局所番号から三角形列を組み立て直し、元の列と一致して上限を守っているか
+	template <typename TIndex>
+	bool AreMeshletsValid(const TIndex* indices, size_t indexCount, size_t vertexCount)
+	{
+		std::vector<MeshOptimizer::Meshlet> meshlets;
+		std::vector<uint32_t> meshletVertices;
+		std::vector<uint8_t> meshletTriangles;
+		if (!MeshOptimizer::BuildMeshlets(indices, indexCount, vertexCount, kMeshletMaxVertices, kMeshletMaxTriangles,
+			meshlets, meshletVertices, meshletTriangles))
+		{
+			return false;
+		}
+		size_t index = 0;
+		for (const MeshOptimizer::Meshlet& meshlet : meshlets)
+		{
+			if (meshlet.vertexCount > kMeshletMaxVertices || meshlet.triangleCount > kMeshletMaxTriangles ||
+				meshlet.triangleOffset != index)
+			{
+				return false;
+			}
+			for (uint32_t i = 0; i < meshlet.triangleCount * 3; ++i, ++index)
+			{
+				const uint8_t local = meshletTriangles[meshlet.triangleOffset + i];
+				if (local >= meshlet.vertexCount || meshletVertices[meshlet.vertexOffset + local] != indices[index])
+				{
+					return false;
+				}
+			}
+		}
+		return index == indexCount;
+	}
+
+	/// 読み込み時の手順。ranges（マテリアルごとの [先頭, 数)）ごとに三角形を並べ替えてから、全体で頂点を並べ替えます。
+	template <typename TIndex>
+	bool OptimizeMesh(std::vector<TIndex>& indices, const std::vector<std::pair<size_t, size_t>>& ranges,
+		const float* positions, size_t vertexCount, size_t positionStride, std::vector<uint32_t>& outRemap)
+	{
+		for (const auto& range : ranges)
+		{
+			if (!MeshOptimizer::OptimizeTriangleOrder(indices.data() + range.first, range.second, positions, vertexCount, positionStride))
+			{
+				return false;
+			}
+		}
+		return MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), vertexCount, outRemap);
+	}
+
+	///=================================================================
+	/// OptimizeMesh の結果（optimized と remap）を確かめます。同じ入力からもう一度作って一致すること、
+	/// 再配置表が置換であること、元の三角形を表で変換したものとマテリアルごとに三角形と向きが一致すること、
+	/// メッシュレットが上限を守って元の列を組み立て直せることを確認します。
+	///=================================================================
+	template <typename TIndex>
+	void CheckOptimizedMesh(const std::vector<TIndex>& source, const std::vector<TIndex>& optimized, const std::vector<uint32_t>& remap,
+		const std::vector<std::pair<size_t, size_t>>& ranges, const float* positions, size_t vertexCount, size_t positionStride,
+		CheckResults& check)
+	{
+		std::vector<TIndex> again = source;
+		std::vector<uint32_t> againRemap;
+		const bool isOptimizedAgain = OptimizeMesh(again, ranges, positions, vertexCount, positionStride, againRemap);
+		check(isOptimizedAgain && again == optimized && againRemap == remap, "the same input gives the same indices and remap");
+
+		const bool isPermutation = IsPermutation(remap, vertexCount);
+		check(isPermutation, "the vertex remap is a permutation of every vertex");
+		if (!isPermutation || optimized.size() != source.size())
+		{
+			return;
+		}
+
+		std::vector<TIndex> mappedSource(source.size());
+		for (size_t i = 0; i < source.size(); ++i)
+		{
+			mappedSource[i] = static_cast<TIndex>(remap[source[i]]);
+		}
+		bool isWindingKept = true;
+		for (const auto& range : ranges)
+		{
+			isWindingKept = isWindingKept && GetCanonicalTriangles(mappedSource.data() + range.first, range.second) ==
+				GetCanonicalTriangles(optimized.data() + range.first, range.second);
+		}
+		check(isWindingKept, "each material keeps the same triangles with the same winding");
+
+		// 頂点番号をそのまま頂点の中身にして並べ替え、各頂点が remap の位置に移ったかを見る
+		std::vector<uint32_t> vertexIds(vertexCount);
+		std::vector<uint32_t> remappedIds(vertexCount);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			vertexIds[v] = static_cast<uint32_t>(v);
+		}
+		MeshOptimizer::RemapVertexBuffer(remappedIds.data(), vertexIds.data(), vertexCount, sizeof(uint32_t), remap);
+		bool isBufferRemapped = true;
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			isBufferRemapped = isBufferRemapped && remappedIds[remap[v]] == v;
+		}
+		check(isBufferRemapped, "RemapVertexBuffer moves each vertex to its remapped slot");
+		check(AreMeshletsValid(optimized.data(), optimized.size(), vertexCount), "meshlets stay within their limits and rebuild the index list");
+	}
+
+	/// 不正な入力では false を返し、インデックスを書き換えないこと
+	void CheckInvalidInput(CheckResults& check)
+	{
+		const float positions[4 * 3] = { 0, 0, 0, 1, 0, 0, 0, 1, 0, 1, 1, 0 };
+		const std::vector<uint16_t> source = { 0, 1, 2, 2, 1, 3 };
+		std::vector<uint16_t> indices = source;
+		std::vector<uint32_t> remap;
+		check(!MeshOptimizer::OptimizeVertexCache(indices.data(), 5, 4) && indices == source,
+			"an index count that is not a multiple of 3 is rejected");
+		check(!MeshOptimizer::OptimizeTriangleOrder(indices.data(), indices.size(), positions, 3, sizeof(float) * 3) && indices == source,
+			"an index past the vertex count is rejected");
+		check(!MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), 3, remap) && indices == source,
+			"the vertex fetch pass rejects an index past the vertex count");
+		check(MeshOptimizer::AnalyzeVertexCache(indices.data(), indices.size(), 3).vertexTransforms == 0,
+			"statistics of an invalid mesh are empty");
+	}
+
+	/// 1 辺 kGridCells のセルを 2 つの三角形に分けた平面（行ごとに並べた、キャッシュに不利な順）
+	void BuildGrid(std::vector<uint32_t>& outIndices, std::vector<float>& outPositions)
+	{
+		const uint32_t side = kGridCells + 1;
+		outPositions.clear();
+		for (uint32_t y = 0; y < side; ++y)
+		{
+			for (uint32_t x = 0; x < side; ++x)
+			{
+				outPositions.insert(outPositions.end(), { static_cast<float>(x), static_cast<float>(y), 0.0f });
+			}
+		}
+		outIndices.clear();
+		for (uint32_t y = 0; y < kGridCells; ++y)
+		{
+			for (uint32_t x = 0; x < kGridCells; ++x)
+			{
+				const uint32_t v = y * side + x;
+				outIndices.insert(outIndices.end(), { v, v + side, v + 1, v + 1, v + side, v + side + 1 });
+			}
+		}
+	}
+}
+
+///=======================================================================
+/// <summary>
+/// MeshOptimizer の各パスを確かめ、指定したモデルの ACMR / ATVR を並べ替えの前後で比べます。
+/// モデルは MeshCooker と同じくマテリアルごとに三角形を並べ替えてから、全体で頂点を並べ替えます。
+/// 16 ビットを超える頂点数の合成グリッドで 32 ビットのインデックスも確かめます。
+/// </summary>
+///=======================================================================
+int RunMeshOptimizerBenchmark(const std::vector<std::filesystem::path>& inputs)
+{
+	CheckResults check;
+	check(!inputs.empty(), "at least one model is given");
+	CheckInvalidInput(check);
+
+	size_t loadedCount = 0;
+	size_t optimizedCount = 0;
+	size_t improvedCount = 0;
+	uint64_t totalTriangles = 0;
+	double totalAcmrBefore = 0.0;
+	double totalAcmrAfter = 0.0;
+	for (const auto& input : inputs)
+	{
+		PMDMappedReader reader;
+		PMDModelData data;
+		if (!reader.Open(input) || !BuildPMDModelData(reader, data))
+		{
+			std::printf("%s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+			continue;
+		}
+		++loadedCount;
+
+		const size_t vertexCount = reader.GetVertices().Size();
+		const float* positions = vertexCount > 0 ? &reader.GetVertices()[0].pos.x : nullptr;
+		std::vector<std::pair<size_t, size_t>> ranges;
+		for (size_t i = 0; i < data.materials.Size(); ++i)
+		{
+			ranges.emplace_back(data.materials.indexOffset[i], data.materials.indexCount[i]);
+		}
+
+		std::vector<uint16_t> optimized = data.indices;
+		std::vector<uint32_t> remap;
+		const auto begin = std::chrono::steady_clock::now();
+		const bool isOptimized = OptimizeMesh(optimized, ranges, positions, vertexCount, sizeof(PMD::VertexRecord), remap);
+		const double optimizeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		optimizedCount += isOptimized ? 1 : 0;
+		CheckOptimizedMesh(data.indices, optimized, remap, ranges, positions, vertexCount, sizeof(PMD::VertexRecord), check);
+
+		const MeshOptimizer::VertexCacheStatistics before = MeshOptimizer::AnalyzeVertexCache(data.indices.data(), data.indices.size(), vertexCount);
+		const MeshOptimizer::VertexCacheStatistics after = MeshOptimizer::AnalyzeVertexCache(optimized.data(), optimized.size(), vertexCount);
+		improvedCount += after.vertexTransforms <= before.vertexTransforms ? 1 : 0;
+		totalTriangles += data.indices.size() / 3;
+		totalAcmrBefore += before.vertexTransforms;
+		totalAcmrAfter += after.vertexTransforms;
+		std::printf("%s (faces %zu): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f, %.3f ms\n",
+			ToDisplayString(input.filename()).c_str(), data.indices.size() / 3, before.acmr, after.acmr, before.atvr, after.atvr, optimizeMs);
+	}
+	if (totalTriangles > 0)
+	{
+		std::printf("total (faces %llu): ACMR %.3f -> %.3f\n", static_cast<unsigned long long>(totalTriangles),
+			totalAcmrBefore / totalTriangles, totalAcmrAfter / totalTriangles);
+	}
+
+	std::vector<uint32_t> gridIndices;
+	std::vector<float> gridPositions;
+	BuildGrid(gridIndices, gridPositions);
+	const size_t gridVertexCount = gridPositions.size() / 3;
+	const std::vector<std::pair<size_t, size_t>> gridRanges = { { 0, gridIndices.size() } };
+	std::vector<uint32_t> optimizedGrid = gridIndices;
+	std::vector<uint32_t> gridRemap;
+	const bool isGridOptimized = OptimizeMesh(optimizedGrid, gridRanges, gridPositions.data(), gridVertexCount, sizeof(float) * 3, gridRemap);
+	CheckOptimizedMesh(gridIndices, optimizedGrid, gridRemap, gridRanges, gridPositions.data(), gridVertexCount, sizeof(float) * 3, check);
+	const MeshOptimizer::VertexCacheStatistics gridBefore = MeshOptimizer::AnalyzeVertexCache(gridIndices.data(), gridIndices.size(), gridVertexCount);
+	const MeshOptimizer::VertexCacheStatistics gridAfter = MeshOptimizer::AnalyzeVertexCache(optimizedGrid.data(), optimizedGrid.size(), gridVertexCount);
+	std::printf("grid (32-bit, vertices %zu, faces %zu): ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n",
+		gridVertexCount, gridIndices.size() / 3, gridBefore.acmr, gridAfter.acmr, gridBefore.atvr, gridAfter.atvr);
+
+	check(loadedCount == inputs.size(), "every model opens and builds PMDModelData");
+	check(optimizedCount == loadedCount && isGridOptimized, "every optimizer pass accepts the meshes");
+	check(improvedCount == loadedCount, "no model transforms more vertices after optimization");
+	check(gridAfter.acmr < gridBefore.acmr, "the grid transforms fewer vertices after optimization");
+	return check.Report();
+}
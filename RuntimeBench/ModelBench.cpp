@@ -0,0 +1,170 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/PMDMappedReader.h"
+#include "Analyzer/PMDModelData.h"
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	/// 読み込み時間を平均する回数
+	constexpr int kModelLoadIterations = 10;
+
+	/// PMDModelData の各テーブルの列数と、テーブルをまたぐ添字が範囲に収まっているか
+	bool IsModelDataConsistent(const PMDMappedReader& reader, const PMDModelData& data)
+	{
+		const size_t vertexCount = reader.GetVertices().Size();
+		const size_t boneCount = data.bones.Size();
+		if (data.indices.size() != reader.GetIndices().Size() ||
+			data.materials.Size() != reader.GetMaterials().Size() ||
+			boneCount != reader.GetBones().Size() ||
+			data.iks.Size() != reader.GetIKs().size() ||
+			data.morphs.Size() != reader.GetSkins().size())
+		{
+			return false;
+		}
+
+		for (uint16_t index : data.indices)
+		{
+			if (index >= vertexCount)
+			{
+				return false;
+			}
+		}
+
+		// マテリアルはインデックス配列を先頭から隙間なく分け合う
+		uint64_t indexOffset = 0;
+		for (size_t i = 0; i < data.materials.Size(); ++i)
+		{
+			if (data.materials.indexOffset[i] != indexOffset)
+			{
+				return false;
+			}
+			indexOffset += data.materials.indexCount[i];
+		}
+		if (indexOffset != data.indices.size())
+		{
+			return false;
+		}
+
+		for (size_t i = 0; i < boneCount; ++i)
+		{
+			if (data.bones.parentIndex[i] != PMD::kNoBone && data.bones.parentIndex[i] >= boneCount)
+			{
+				return false;
+			}
+		}
+
+		// IK のチェーンはファイルの並びのまま、1 本の配列に詰めてある
+		size_t chainBoneCount = 0;
+		for (size_t i = 0; i < data.iks.Size(); ++i)
+		{
+			const PMDIKView& ik = reader.GetIKs()[i];
+			if (data.iks.boneIndex[i] >= boneCount || data.iks.targetBoneIndex[i] >= boneCount ||
+				data.iks.chainOffset[i] != chainBoneCount || data.iks.chainLength[i] != ik.chain.Size())
+			{
+				return false;
+			}
+			for (size_t link = 0; link < ik.chain.Size(); ++link)
+			{
+				const uint16_t boneIndex = data.iks.chainBoneIndex[chainBoneCount + link];
+				if (boneIndex >= boneCount || boneIndex != ik.chain[link].boneIndex)
+				{
+					return false;
+				}
+			}
+			chainBoneCount += ik.chain.Size();
+		}
+		if (chainBoneCount != data.iks.chainBoneIndex.size())
+		{
+			return false;
+		}
+
+		// base は頂点番号、それ以外は base 内の番号を持つ
+		const size_t baseVertexCount = data.morphs.Size() > 0 ? data.morphs.vertexCount[0] : 0;
+		for (size_t i = 0; i < data.morphs.Size(); ++i)
+		{
+			const size_t first = data.morphs.vertexOffset[i];
+			const size_t count = data.morphs.vertexCount[i];
+			if (first + count > data.morphs.vertexIndex.size())
+			{
+				return false;
+			}
+			const size_t limit = data.morphs.type[i] == 0 ? vertexCount : baseVertexCount;
+			for (size_t v = first; v < first + count; ++v)
+			{
+				if (data.morphs.vertexIndex[v] >= limit)
+				{
+					return false;
+				}
+			}
+		}
+
+		for (uint16_t skinIndex : data.display.skinIndex)
+		{
+			if (skinIndex >= data.morphs.Size())
+			{
+				return false;
+			}
+		}
+		for (size_t i = 0; i < data.display.boneIndex.size(); ++i)
+		{
+			if (data.display.boneIndex[i] >= boneCount || data.display.boneFrameIndex[i] == 0 ||
+				data.display.boneFrameIndex[i] > data.display.boneFrameName.size())
+			{
+				return false;
+			}
+		}
+		return data.toonTextureFileNames.empty() || data.toonTextureFileNames.size() == PMD::kToonTextureCount;
+	}
+}
+
+///=======================================================================
+/// <summary>
+/// 指定したモデルを GPU を使わずに読み込み、PMDModelData を作って中身の整合性を確かめます。
+/// 1 体あたりの読み込み（マップ + 検証 + テーブルの構築）の時間も計測します。
+/// </summary>
+///=======================================================================
+int RunModelBenchmark(const std::vector<std::filesystem::path>& inputs)
+{
+	CheckResults check;
+	check(!inputs.empty(), "at least one model is given");
+
+	size_t loadedCount = 0;
+	size_t consistentCount = 0;
+	for (const auto& input : inputs)
+	{
+		PMDMappedReader reader;
+		PMDModelData data;
+		if (!reader.Open(input) || !BuildPMDModelData(reader, data))
+		{
+			std::printf("%s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+			continue;
+		}
+		++loadedCount;
+		const bool isConsistent = IsModelDataConsistent(reader, data);
+		consistentCount += isConsistent ? 1 : 0;
+
+		const auto begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < kModelLoadIterations; ++i)
+		{
+			PMDMappedReader timedReader;
+			PMDModelData timedData;
+			timedReader.Open(input);
+			BuildPMDModelData(timedReader, timedData);
+		}
+		const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() / kModelLoadIterations;
+
+		std::printf("%s (vertices %zu, faces %zu, materials %zu, bones %zu, IKs %zu, morphs %zu): %.3f ms%s\n",
+			ToDisplayString(input.filename()).c_str(), reader.GetVertices().Size(), data.indices.size() / 3, data.materials.Size(),
+			data.bones.Size(), data.iks.Size(), data.morphs.Size(), loadMs, isConsistent ? "" : "  INCONSISTENT");
+	}
+
+	check(loadedCount == inputs.size(), "every model opens and builds PMDModelData");
+	check(consistentCount == loadedCount, "every table matches the file and its cross-table indices are in range");
+	std::printf("%zu / %zu models loaded\n", loadedCount, inputs.size());
+	return check.Report();
+}
@@ -0,0 +1,93 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/PMDMappedReader.h"
+#include "Analyzer/PMDModelData.h"
+#include "Animation/MorphBlender.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kMorphCharacterCounts[] = { 1, 10, 100 };
+	constexpr size_t kMorphFrames = 600;
+	/// 同時に動かす表情の数（まばたき・口・眉などを想定）
+	constexpr size_t kActiveMorphCount = 4;
+}
+
+int RunMorphBenchmark(const std::vector<std::filesystem::path>& inputs)
+{
+	for (const auto& input : inputs)
+	{
+		PMDMappedReader reader;
+		PMDModelData modelData;
+		if (!reader.Open(input) || !BuildPMDModelData(reader, modelData))
+		{
+			std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+			return 1;
+		}
+		MorphTargetSet targets;
+		if (!targets.BuildFromPMD(modelData.morphs, reader.GetVertices().Size()))
+		{
+			std::fprintf(stderr, "error: %s: invalid morph data\n", ToDisplayString(input).c_str());
+			return 1;
+		}
+		const size_t vertexStride = sizeof(PMD::VertexRecord);
+		const size_t vertexBufferBytes = reader.GetVertices().SizeInBytes();
+		std::printf("%s (vertices %zu, morphs %zu, morph vertices %zu, entries %zu)\n", ToDisplayString(input).c_str(),
+			reader.GetVertices().Size(), targets.GetMorphCount(), targets.GetTargetCount(), targets.GetEntrySlots().size());
+		if (targets.GetMorphCount() <= 1)
+		{
+			continue;
+		}
+
+		for (size_t characterCount : kMorphCharacterCounts)
+		{
+			// キャラクターごとに頂点配列の写しと合成状態を持つ
+			std::vector<std::vector<uint8_t>> vertices(characterCount,
+				std::vector<uint8_t>(reader.GetVertices().RawData(), reader.GetVertices().RawData() + vertexBufferBytes));
+			std::vector<MorphBlender> blenders(characterCount);
+			for (MorphBlender& blender : blenders)
+			{
+				blender.Initialize(targets);
+			}
+
+			size_t uploadBytes = 0;
+			size_t rangeCount = 0;
+			double totalMs = 0.0;
+			for (size_t frame = 0; frame < kMorphFrames; ++frame)
+			{
+				for (size_t character = 0; character < characterCount; ++character)
+				{
+					for (size_t active = 0; active < kActiveMorphCount; ++active)
+					{
+						const size_t morph = 1 + (character + active * 7) % (targets.GetMorphCount() - 1);
+						blenders[character].SetWeight(morph, 0.5f + 0.5f * std::sin(0.1f * static_cast<float>(frame + character + active)));
+					}
+				}
+
+				const auto begin = std::chrono::steady_clock::now();
+				for (size_t character = 0; character < characterCount; ++character)
+				{
+					for (const MorphDirtyRange& range : blenders[character].Apply(vertices[character].data(), vertexStride))
+					{
+						uploadBytes += range.vertexCount * vertexStride;
+						++rangeCount;
+					}
+				}
+				totalMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+			}
+
+			const double frames = static_cast<double>(kMorphFrames);
+			const double fullBytes = static_cast<double>(vertexBufferBytes * characterCount);
+			std::printf("  %3zu characters: %7.3f ms/frame, upload %8.1f KB/frame in %6.1f ranges (full buffers %8.1f KB, %.1f%%)\n",
+				characterCount, totalMs / frames, static_cast<double>(uploadBytes) / frames / 1024.0,
+				static_cast<double>(rangeCount) / frames, fullBytes / 1024.0,
+				100.0 * static_cast<double>(uploadBytes) / frames / fullBytes);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,204 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/PMDModelData.h"
+#include "Animation/MotionSampler.h"
+#include "Animation/PoseEvaluator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kMotionInstanceCounts[] = { 1, 10, 100, 1000 };
+	/// 計測ごとにサンプリングするチャンネルの延べ数の目安
+	constexpr size_t kMotionSamplesPerMeasure = 2000000;
+	/// 合成モーション: 2 分、ボーンは 3 フレームごと、表情は 10 フレームごとにキー
+	constexpr uint32_t kSyntheticMotionFrames = 30 * 120;
+	constexpr uint32_t kSyntheticBoneKeyInterval = 3;
+	constexpr uint32_t kSyntheticMorphKeyInterval = 10;
+	/// 再生は 60fps（VMD の 30fps に対して 0.5 フレームずつ進める）
+	constexpr float kPlaybackStep = 0.5f;
+
+	template <typename TRecord>
+	void CopyName(const std::string& name, TRecord& record, char (TRecord::*field)[VMD::kNameLength])
+	{
+		std::memcpy(record.*field, name.data(), (std::min)(name.size(), VMD::kNameLength));
+	}
+
+	///=================================================================
+	/// モデルの全ボーンと表情にキーを打った VMD を書き出します。
+	/// 実際のファイルと同じくキーはフレーム順に混在させ、半分のボーンは非線形の補間曲線にします。
+	///=================================================================
+	bool WriteSyntheticMotion(const std::filesystem::path& path, const PMDModelData& modelData)
+	{
+		std::vector<VMD::BoneKeyRecord> boneKeys;
+		std::vector<VMD::MorphKeyRecord> morphKeys;
+		for (uint32_t frame = 0; frame <= kSyntheticMotionFrames; ++frame)
+		{
+			for (size_t bone = 0; frame % kSyntheticBoneKeyInterval == 0 && bone < modelData.bones.Size(); ++bone)
+			{
+				VMD::BoneKeyRecord record = {};
+				CopyName(modelData.bones.name[bone], record, &VMD::BoneKeyRecord::boneName);
+				record.frame = frame;
+				const float angle = 0.3f * std::sin(0.02f * static_cast<float>(frame) + static_cast<float>(bone));
+				record.position = { 0.0f, 0.1f * angle, 0.0f };
+				record.rotation = { std::sin(angle * 0.5f), 0.0f, 0.0f, std::cos(angle * 0.5f) };
+				const uint8_t control[4] = { 20, 20, 107, 107 };
+				const uint8_t easeInOut[4] = { 64, 0, 64, 127 };
+				for (int row = 0; row < 16; ++row)
+				{
+					record.interpolation[row] = (bone % 2 == 0 ? easeInOut : control)[row / 4];
+				}
+				boneKeys.push_back(record);
+			}
+			for (size_t morph = 1; frame % kSyntheticMorphKeyInterval == 0 && morph < modelData.morphs.Size(); ++morph)
+			{
+				VMD::MorphKeyRecord record = {};
+				CopyName(modelData.morphs.name[morph], record, &VMD::MorphKeyRecord::morphName);
+				record.frame = frame;
+				record.weight = 0.5f + 0.5f * std::sin(0.05f * static_cast<float>(frame + morph));
+				morphKeys.push_back(record);
+			}
+		}
+
+		std::ofstream stream(path, std::ios::binary | std::ios::trunc);
+		VMD::HeaderRecord header = {};
+		std::memcpy(header.signature, "Vocaloid Motion Data 0002", 25);
+		const uint32_t boneKeyCount = static_cast<uint32_t>(boneKeys.size());
+		const uint32_t morphKeyCount = static_cast<uint32_t>(morphKeys.size());
+		stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		stream.write(reinterpret_cast<const char*>(&boneKeyCount), sizeof(boneKeyCount));
+		stream.write(reinterpret_cast<const char*>(boneKeys.data()), boneKeys.size() * sizeof(VMD::BoneKeyRecord));
+		stream.write(reinterpret_cast<const char*>(&morphKeyCount), sizeof(morphKeyCount));
+		stream.write(reinterpret_cast<const char*>(morphKeys.data()), morphKeys.size() * sizeof(VMD::MorphKeyRecord));
+		return static_cast<bool>(stream);
+	}
+
+	/// 全インスタンスを kPlaybackStep ずつ進めながらサンプリングし、1 フレームあたりの時間（ミリ秒）を返します。
+	double MeasureMotionFrame(const MotionClip& clip, const MotionBinding& binding, PoseBatch& poses,
+		std::vector<MotionSampler>& samplers, size_t frameCount, bool useCursor)
+	{
+		const float length = static_cast<float>(clip.GetLastFrame()) + 1.0f;
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < frameCount; ++frame)
+		{
+			for (size_t instance = 0; instance < samplers.size(); ++instance)
+			{
+				// インスタンスごとに再生位置をずらす
+				const float time = std::fmod(static_cast<float>(instance * 37) + kPlaybackStep * static_cast<float>(frame), length);
+				if (!useCursor)
+				{
+					samplers[instance].Reset();
+				}
+				samplers[instance].SampleBones(clip, binding, time, poses.GetLocalRotations(instance), poses.GetLocalTranslations(instance));
+			}
+		}
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - begin).count() / static_cast<double>(frameCount);
+	}
+}
+
+int RunMotionBenchmark(const std::filesystem::path& input, std::filesystem::path motionPath)
+{
+	PMDModelData modelData;
+	Skeleton skeleton;
+	if (!LoadSkeleton(input, modelData, skeleton))
+	{
+		return 1;
+	}
+	if (motionPath.empty())
+	{
+		motionPath = std::filesystem::temp_directory_path() / "RuntimeBench_synthetic.vmd";
+		if (!WriteSyntheticMotion(motionPath, modelData))
+		{
+			std::fprintf(stderr, "error: %s: failed to write synthetic motion\n", ToDisplayString(motionPath).c_str());
+			return 1;
+		}
+	}
+
+	auto loadBegin = std::chrono::steady_clock::now();
+	VMDMappedReader reader;
+	if (!reader.Open(motionPath))
+	{
+		std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(motionPath).c_str(), reader.GetLastError().c_str());
+		return 1;
+	}
+	MotionClip clip;
+	clip.BuildFromVMD(reader);
+	const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadBegin).count();
+
+	MotionBinding binding;
+	binding.Bind(clip, skeleton, &modelData.morphs);
+	std::printf("%s + %s (frames %u, bone channels %zu / bound %zu, keys %zu, load %.2f ms)\n",
+		ToDisplayString(input).c_str(), ToDisplayString(motionPath).c_str(), clip.GetLastFrame(),
+		clip.GetBoneChannels().size(), binding.GetBoundBoneCount(), clip.GetKeyCount(), loadMs);
+	if (binding.GetBoundBoneCount() == 0)
+	{
+		return 0;
+	}
+
+	for (size_t instanceCount : kMotionInstanceCounts)
+	{
+		PoseBatch poses;
+		poses.Resize(skeleton, instanceCount);
+		std::vector<MotionSampler> samplers(instanceCount);
+		const size_t frameCount = (std::max)(static_cast<size_t>(10),
+			kMotionSamplesPerMeasure / (instanceCount * binding.GetBoundBoneCount()));
+		const double cursorMs = MeasureMotionFrame(clip, binding, poses, samplers, frameCount, true);
+		const double searchMs = MeasureMotionFrame(clip, binding, poses, samplers, frameCount, false);
+		const double channelSamples = static_cast<double>(instanceCount * binding.GetBoundBoneCount());
+		std::printf("  %4zu instances x %zu bones: cursor %8.3f ms/frame (%6.1f ns/channel), binary search %8.3f ms/frame (%6.1f ns/channel)\n",
+			instanceCount, binding.GetBoundBoneCount(), cursorMs, cursorMs * 1.0e6 / channelSamples,
+			searchMs, searchMs * 1.0e6 / channelSamples);
+	}
+
+	// ストリーミング再生: 全体を読み込んだ場合と同じ値になることと常駐キー数を確認する
+	loadBegin = std::chrono::steady_clock::now();
+	MotionStream stream;
+	if (!stream.Open(motionPath))
+	{
+		std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(motionPath).c_str(), stream.GetLastError().c_str());
+		return 1;
+	}
+	const double openMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadBegin).count();
+
+	PoseBatch fullPose;
+	PoseBatch streamPose;
+	fullPose.Resize(skeleton, 1);
+	streamPose.Resize(skeleton, 1);
+	MotionSampler fullSampler;
+	MotionSampler streamSampler;
+	size_t maxWindowKeys = 0;
+	size_t mismatchCount = 0;
+	double streamMs = 0.0;
+	for (float time = 0.0f; time <= static_cast<float>(stream.GetLastFrame()); time += kPlaybackStep)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		const MotionClip& window = stream.Update(time);
+		streamSampler.SampleBones(window, binding, time, streamPose.GetLocalRotations(0), streamPose.GetLocalTranslations(0));
+		streamMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		maxWindowKeys = (std::max)(maxWindowKeys, window.GetKeyCount());
+
+		fullSampler.SampleBones(clip, binding, time, fullPose.GetLocalRotations(0), fullPose.GetLocalTranslations(0));
+		if (std::memcmp(fullPose.GetLocalRotations(0), streamPose.GetLocalRotations(0), skeleton.GetBoneCount() * sizeof(DirectX::XMFLOAT4)) != 0 ||
+			std::memcmp(fullPose.GetLocalTranslations(0), streamPose.GetLocalTranslations(0), skeleton.GetBoneCount() * sizeof(DirectX::XMFLOAT3)) != 0)
+		{
+			++mismatchCount;
+		}
+	}
+	// 索引はキーあたりフレームとレコード番号、展開したボーンキーはフレーム・移動・回転・補間曲線を持つ
+	const size_t indexBytesPerKey = sizeof(uint32_t) * 2;
+	const size_t decodedBytesPerKey = sizeof(uint32_t) + sizeof(DirectX::XMFLOAT3) + sizeof(DirectX::XMFLOAT4) + sizeof(MotionClip::BoneKeyCurves);
+	std::printf("  streaming: open %.2f ms, resident %zu KB (index) + %zu KB (window) vs %zu KB, %zu windows, %.3f ms total, %s\n",
+		openMs, stream.GetIndexedKeyCount() * indexBytesPerKey / 1024, maxWindowKeys * decodedBytesPerKey / 1024,
+		clip.GetKeyCount() * decodedBytesPerKey / 1024, stream.GetWindowLoadCount(), streamMs,
+		mismatchCount == 0 ? "matches full clip" : "MISMATCH");
+	return mismatchCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,135 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/PMDMappedReader.h"
+#include "Analyzer/PMDModelData.h"
+#include "Animation/PoseEvaluator.h"
+#include "System/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <future>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kPoseInstanceCounts[] = { 1, 10, 100, 1000, 4000 };
+	/// 計測ごとに評価するインスタンスの延べ数の目安
+	constexpr size_t kPoseEvaluationsPerMeasure = 20000;
+	constexpr double kFrameMilliseconds = 1000.0 / 60.0;
+
+	/// インスタンスごとに異なる姿勢（回転と IK 目標の移動）を与えます。
+	void ApplyTestPose(const Skeleton& skeleton, PoseBatch& poses, size_t instance, size_t frame)
+	{
+		poses.ResetInstance(instance);
+		DirectX::XMFLOAT4* rotations = poses.GetLocalRotations(instance);
+		DirectX::XMFLOAT3* translations = poses.GetLocalTranslations(instance);
+		const float phase = 0.37f * static_cast<float>(instance) + 0.05f * static_cast<float>(frame);
+		for (size_t bone = 0; bone < skeleton.GetBoneCount(); ++bone)
+		{
+			const float angle = 0.2f * std::sin(phase + static_cast<float>(bone));
+			rotations[bone] = DirectX::XMFLOAT4(std::sin(angle * 0.5f), 0.0f, 0.0f, std::cos(angle * 0.5f));
+		}
+		for (const Skeleton::IKChain& chain : skeleton.GetIKChains())
+		{
+			translations[chain.ikBone] = DirectX::XMFLOAT3(0.5f * std::sin(phase), 1.0f + std::cos(phase), -0.5f);
+		}
+	}
+
+	/// フレームごとに全インスタンスを評価し、1 フレームあたりの平均時間（ミリ秒）を返します。
+	double MeasurePoseFrame(const Skeleton& skeleton, PoseBatch& poses, size_t frameCount, JobSystem* jobSystem)
+	{
+		const size_t instanceCount = poses.GetInstanceCount();
+		double totalMs = 0.0;
+		for (size_t frame = 0; frame < frameCount; ++frame)
+		{
+			for (size_t instance = 0; instance < instanceCount; ++instance)
+			{
+				ApplyTestPose(skeleton, poses, instance, frame);
+			}
+
+			const auto begin = std::chrono::steady_clock::now();
+			if (jobSystem == nullptr)
+			{
+				PoseEvaluator::Evaluate(skeleton, poses, 0, instanceCount);
+			}
+			else
+			{
+				// ワーカー数の 4 倍に分けて偏りをならす
+				const size_t jobCount = (std::min)(instanceCount, jobSystem->GetWorkerCount() * 4);
+				std::vector<std::future<void>> futures;
+				futures.reserve(jobCount);
+				for (size_t job = 0; job < jobCount; ++job)
+				{
+					const size_t first = instanceCount * job / jobCount;
+					const size_t last = instanceCount * (job + 1) / jobCount;
+					futures.push_back(jobSystem->Submit([&skeleton, &poses, first, last]()
+					{
+						PoseEvaluator::Evaluate(skeleton, poses, first, last - first);
+					}));
+				}
+				for (auto& future : futures)
+				{
+					future.get();
+				}
+			}
+			const auto end = std::chrono::steady_clock::now();
+			totalMs += std::chrono::duration<double, std::milli>(end - begin).count();
+		}
+		return totalMs / static_cast<double>(frameCount);
+	}
+}
+
+bool LoadSkeleton(const std::filesystem::path& input, PMDModelData& outModelData, Skeleton& outSkeleton)
+{
+	PMDMappedReader reader;
+	if (!reader.Open(input) || !BuildPMDModelData(reader, outModelData))
+	{
+		std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+		return false;
+	}
+	if (!outSkeleton.BuildFromPMD(outModelData))
+	{
+		std::fprintf(stderr, "error: %s: invalid bone hierarchy\n", ToDisplayString(input).c_str());
+		return false;
+	}
+	return true;
+}
+
+int RunPoseBenchmark(const std::filesystem::path& input)
+{
+	PMDModelData modelData;
+	Skeleton skeleton;
+	if (!LoadSkeleton(input, modelData, skeleton))
+	{
+		return 1;
+	}
+	std::printf("%s (bones %zu, IK chains %zu)\n", ToDisplayString(input).c_str(),
+		skeleton.GetBoneCount(), skeleton.GetIKChains().size());
+
+	JobSystem& jobSystem = JobSystem::Get();
+	for (size_t instanceCount : kPoseInstanceCounts)
+	{
+		PoseBatch poses;
+		poses.Resize(skeleton, instanceCount);
+		const size_t frameCount = (std::max)(static_cast<size_t>(3), kPoseEvaluationsPerMeasure / instanceCount);
+		const double serialMs = MeasurePoseFrame(skeleton, poses, frameCount, nullptr);
+		const double parallelMs = MeasurePoseFrame(skeleton, poses, frameCount, &jobSystem);
+		const double microsecondsPerInstance = serialMs * 1000.0 / static_cast<double>(instanceCount);
+		std::printf("  %5zu instances: serial %8.3f ms/frame (%6.2f us/instance), parallel %8.3f ms/frame (%zu workers)\n",
+			instanceCount, serialMs, microsecondsPerInstance, parallelMs, jobSystem.GetWorkerCount());
+	}
+
+	// 最大数での計測から 1 フレームに収まるインスタンス数を見積もる
+	PoseBatch poses;
+	const size_t largest = kPoseInstanceCounts[std::size(kPoseInstanceCounts) - 1];
+	poses.Resize(skeleton, largest);
+	const double serialMs = MeasurePoseFrame(skeleton, poses, 3, nullptr);
+	const double parallelMs = MeasurePoseFrame(skeleton, poses, 3, &jobSystem);
+	std::printf("  instances per %.2f ms frame: serial %.0f, parallel %.0f\n", kFrameMilliseconds,
+		serialMs > 0.0 ? kFrameMilliseconds * static_cast<double>(largest) / serialMs : 0.0,
+		parallelMs > 0.0 ? kFrameMilliseconds * static_cast<double>(largest) / parallelMs : 0.0);
+	return 0;
+}
@@ -0,0 +1,352 @@
+﻿#include "BenchCommon.h"
+#include "FakeTextureLoader.h"
+
+#include "RHI/TextureAssetManager.h"
+#include "RHI/TextureResidency.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <deque>
+#include <functional>
+#include <numeric>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	/// 16x16 枚の 2048x2048 BC1（全ミップで約 683MB）を 128MB の予算で回す
+	constexpr uint32_t kResidencyGridSize = 16;
+	constexpr uint32_t kResidencyTextureSize = 2048;
+	constexpr uint64_t kResidencyBudgetBytes = 128ull * 1024 * 1024;
+	constexpr size_t kResidencyFrames = 600;
+	/// カメラからこの距離（格子の間隔単位）までのテクスチャを描く
+	constexpr float kResidencyViewRadius = 3.0f;
+	/// 真下のテクスチャの画面上の大きさ（ピクセル）。離れるほど小さく描く
+	constexpr float kResidencyNearScreenSize = 2048.0f;
+	/// 読み込みと作り直しが終わるまでのフレーム数
+	constexpr uint64_t kResidencyTransitionFrames = 3;
+
+	/// BC1 の 1 ミップのバイト数（4x4 ブロックあたり 8 バイト）
+	uint64_t GetBc1MipBytes(uint32_t size, uint32_t mip)
+	{
+		const uint64_t blocks = (std::max)(1u, (size >> mip) / 4);
+		return blocks * blocks * 8;
+	}
+
+	/// 予算の小さな状況で LRU の順、追い出した後の読み込み直し、固定と tail の扱いを確認します。
+	void CheckResidencyPolicy(CheckResults& check)
+	{
+		// ミップ 0（64）と tail（16 + 4 + 1）の 2 単位だけのテクスチャを 4 つと、報告しない固定のもの
+		TextureResidency residency;
+		TextureResidency::Settings settings;
+		settings.budgetBytes = 200;
+		settings.tailMipBytes = 16;
+		residency.SetSettings(settings);
+		const std::vector<uint64_t> mipBytes = { 64, 16, 4, 1 };
+		for (TextureResidency::TextureId id = 1; id <= 5; ++id)
+		{
+			residency.Register(id, 8, 8, mipBytes);
+		}
+
+		std::vector<TextureResidency::Transition> streams;
+		std::vector<TextureResidency::Transition> evictions;
+		auto update = [&]()
+		{
+			residency.Update(streams, evictions);
+			for (const TextureResidency::Transition& transition : streams)
+			{
+				residency.CompleteTransition(transition.id, transition.firstMip, true);
+			}
+			for (const TextureResidency::Transition& transition : evictions)
+			{
+				residency.CompleteTransition(transition.id, transition.firstMip, true);
+			}
+		};
+		auto hasTransition = [](const std::vector<TextureResidency::Transition>& transitions, TextureResidency::TextureId id, uint32_t firstMip)
+		{
+			return std::any_of(transitions.begin(), transitions.end(), [&](const TextureResidency::Transition& transition)
+			{
+				return transition.id == id && transition.firstMip == firstMip;
+			});
+		};
+
+		// 全て tail だけ使う: 使われていないミップ 0 を追い出して予算に収める
+		for (TextureResidency::TextureId id = 1; id <= 4; ++id)
+		{
+			residency.RequestMip(id, 3);
+		}
+		update();
+		check(evictions.size() == 4 && streams.empty() && residency.GetStatistics().residentBytes == 4 * 21 + 85,
+			"unused fine mips are evicted down to the tail to fit the budget");
+
+		// 追い出せるものが無ければ予算を超えて読み込まない
+		residency.RequestMip(1, 0);
+		for (TextureResidency::TextureId id = 2; id <= 4; ++id)
+		{
+			residency.RequestMip(id, 3);
+		}
+		update();
+		check(streams.empty() && evictions.empty() && residency.GetStatistics().starvedCount == 1,
+			"requests that cannot fit are starved instead of exceeding the budget");
+
+		// 使われなくなった tail は丸ごと追い出して空ける（同じ古さならハンドル順）
+		residency.RequestMip(1, 0);
+		update();
+		check(hasTransition(streams, 1, 0) && evictions.size() == 2 && hasTransition(evictions, 2, 4) && hasTransition(evictions, 3, 4),
+			"stale tails are evicted in LRU order to stream in a requested mip");
+
+		// 4 だけ使い、次に 2 を読み込み直す: 最も古い 1 のミップ 0 から追い出す（4 の tail は残る）
+		residency.RequestMip(4, 3);
+		update();
+		residency.RequestMip(2, 3);
+		update();
+		check(hasTransition(streams, 2, 1) && evictions.size() == 1 && hasTransition(evictions, 1, 1) && residency.GetResidentMip(4) == 1,
+			"evicted textures are streamed back in when requested again, evicting the least recently used mip");
+		check(residency.GetResidentMip(5) == 0 && residency.GetStatistics().pinnedCount == 1, "pinned textures are never evicted");
+
+		// 予算を下げると、報告の無いものを追い出せるだけ追い出す（固定のものは残る）
+		settings.budgetBytes = 0;
+		residency.SetSettings(settings);
+		update();
+		check(residency.GetStatistics().residentBytes == 85 && residency.GetResidentMip(1) == 4, "lowering the budget evicts everything but pinned textures");
+
+		check(TextureResidency::ComputeDesiredMip(2048, 2048, 512.0f, 512.0f, 12) == 2 &&
+			TextureResidency::ComputeDesiredMip(2048, 1024, 4096.0f, 4096.0f, 12) == 0 &&
+			TextureResidency::ComputeDesiredMip(2048, 2048, 0.0f, 0.0f, 12) == 11, "desired mip follows the on-screen size");
+	}
+
+	/// TextureAssetManager から使い、追い出したテクスチャーがプレースホルダーに戻って読み込み直されることを確認します。
+	void CheckManagedResidency(CheckResults& check)
+	{
+		TextureAssetManager& manager = TextureAssetManager::Get();
+		manager.SetLoader(std::make_shared<FakeTextureLoader>());
+		TextureResidency::Settings settings;
+		settings.budgetBytes = 512 * 1024;
+		settings.tailMipBytes = 16 * 1024;
+		manager.SetResidencySettings(settings);
+
+		std::vector<TextureHandle> handles;
+		for (size_t i = 0; i < 4; ++i)
+		{
+			handles.push_back(manager.AcquireTexture(("stream_" + std::to_string(i) + ".png").c_str()));
+		}
+		// 報告を毎フレーム繰り返して、読み込みと作り直しが終わるまで回す
+		auto pump = [&manager](const std::function<void()>& report)
+		{
+			size_t frames = 0;
+			do
+			{
+				report();
+				manager.ProcessPendingTextures();
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			} while (manager.GetPendingCount() > 0 && ++frames < kMaxTextureFrames);
+		};
+		pump([]() {});
+		check(manager.GetResidencyStatistics().pinnedCount == 4, "textures are pinned until their usage is reported");
+
+		pump([&]()
+		{
+			for (TextureHandle handle : handles)
+			{
+				manager.ReportTextureUsage(handle, 0.0f, 0.0f);
+			}
+		});
+		// 先に公開されたもの（使われていない期間が長い）から細かいミップを追い出す
+		size_t rebuiltCount = 0;
+		for (TextureHandle handle : handles)
+		{
+			rebuiltCount += GetFakeTexturePath(manager.GetTexture(handle)).find("#mip") != std::string::npos ? 1 : 0;
+		}
+		check(rebuiltCount > 0 && manager.GetResidencyStatistics().residentBytes <= settings.budgetBytes,
+			"off-screen textures are rebuilt without their unused fine mips");
+
+		pump([&]() { manager.ReportTextureUsage(handles[0], 256.0f, 256.0f); });
+		check(GetFakeTexturePath(manager.GetTexture(handles[0])) == "stream_0.png#mip0", "textures drawn at full size stream their fine mips back in");
+
+		settings.budgetBytes = 40 * 1024;
+		manager.SetResidencySettings(settings);
+		pump([]() {});
+		TextureAssetManager::TextureState state = TextureAssetManager::TextureState::Ready;
+		check(GetFakeTexturePath(manager.GetTexture(handles[1], &state)) == "placeholder" && state == TextureAssetManager::TextureState::Evicted,
+			"fully evicted textures fall back to the placeholder");
+		check(manager.GetResidencyStatistics().residentBytes <= settings.budgetBytes, "the manager keeps resident mips within the budget");
+
+		settings.budgetBytes = 512 * 1024;
+		manager.SetResidencySettings(settings);
+		pump([&]() { manager.ReportTextureUsage(handles[1], 1.0f, 1.0f); });
+		check(GetFakeTexturePath(manager.GetTexture(handles[1], &state)) == "stream_1.png#mip2" && state == TextureAssetManager::TextureState::Ready,
+			"evicted textures are streamed back in once they are drawn again");
+
+		manager.ReleaseTexture(handles[1]);
+		check(manager.GetResidencyStatistics().textureCount == 3, "released textures leave the residency budget");
+		std::printf("  manager  : %s\n", manager.FormatResidencyReport().c_str());
+
+		manager.Clear();
+		manager.SetLoader(nullptr);
+		manager.SetResidencySettings({});
+	}
+}
+
+int RunResidencyBenchmark()
+{
+	CheckResults check;
+
+	// 格子状に並べたテクスチャの上をカメラが往復し、近いものほど大きく描く
+	TextureResidency residency;
+	TextureResidency::Settings settings;
+	settings.budgetBytes = kResidencyBudgetBytes;
+	residency.SetSettings(settings);
+	const uint32_t mipCount = static_cast<uint32_t>(std::log2(kResidencyTextureSize)) + 1;
+	std::vector<uint64_t> mipBytes;
+	uint32_t tailMip = mipCount - 1;
+	for (uint32_t mip = 0; mip < mipCount; ++mip)
+	{
+		mipBytes.push_back(GetBc1MipBytes(kResidencyTextureSize, mip));
+		if (mipBytes.back() <= settings.tailMipBytes && tailMip == mipCount - 1)
+		{
+			tailMip = mip;
+		}
+	}
+	uint64_t totalBytes = 0;
+	for (TextureResidency::TextureId id = 0; id < kResidencyGridSize * kResidencyGridSize; ++id)
+	{
+		residency.Register(id, kResidencyTextureSize, kResidencyTextureSize, mipBytes);
+		totalBytes += std::accumulate(mipBytes.begin(), mipBytes.end(), uint64_t(0));
+		// 読み込み時に一度描いた扱いにして固定を外す
+		residency.RequestMip(id, mipCount - 1);
+	}
+
+	// ミップごとに最後に要求したフレームを手元でも記録し、追い出しが LRU の順か確かめる
+	const size_t textureCount = static_cast<size_t>(kResidencyGridSize) * kResidencyGridSize;
+	std::vector<std::vector<uint64_t>> lastRequested(textureCount, std::vector<uint64_t>(mipCount, 0));
+	std::vector<uint32_t> requestedMips(textureCount, mipCount - 1);
+	struct PendingTransition
+	{
+		uint64_t completeFrame;
+		TextureResidency::Transition transition;
+	};
+	std::deque<PendingTransition> pending;
+	std::vector<bool> isInTransition(textureCount, false);
+	std::vector<bool> wasEvicted(textureCount, false);
+
+	bool isWithinBudget = true;
+	bool isUsedMipKept = true;
+	bool isLruOrder = true;
+	size_t restreamCount = 0;
+	double updateMs = 0.0;
+	double residentSum = 0.0;
+	uint64_t peakBytes = 0;
+	std::vector<TextureResidency::Transition> streams;
+	std::vector<TextureResidency::Transition> evictions;
+	for (size_t frame = 0; frame < kResidencyFrames; ++frame)
+	{
+		const uint64_t frameIndex = residency.GetFrameIndex() + 1;
+		const float phase = static_cast<float>(frame) / static_cast<float>(kResidencyFrames);
+		const float cameraX = static_cast<float>(kResidencyGridSize - 1) * (0.5f - 0.5f * std::cos(phase * 2.0f * 3.14159265f));
+		const float cameraY = static_cast<float>(kResidencyGridSize - 1) * 0.5f;
+		for (uint32_t y = 0; y < kResidencyGridSize; ++y)
+		{
+			for (uint32_t x = 0; x < kResidencyGridSize; ++x)
+			{
+				const float distance = std::hypot(static_cast<float>(x) - cameraX, static_cast<float>(y) - cameraY);
+				const TextureResidency::TextureId id = y * kResidencyGridSize + x;
+				if (frame == 0)
+				{
+					std::fill(lastRequested[id].begin() + (std::min)(mipCount - 1, tailMip), lastRequested[id].end(), frameIndex);
+				}
+				if (distance > kResidencyViewRadius)
+				{
+					continue;
+				}
+				const float screenSize = kResidencyNearScreenSize / (1.0f + distance);
+				residency.RequestScreenSize(id, screenSize, screenSize);
+				const uint32_t mip = (std::min)(tailMip, TextureResidency::ComputeDesiredMip(kResidencyTextureSize, kResidencyTextureSize, screenSize, screenSize, mipCount));
+				std::fill(lastRequested[id].begin() + mip, lastRequested[id].end(), frameIndex);
+			}
+		}
+
+		std::vector<uint32_t> residentBefore(textureCount);
+		for (TextureResidency::TextureId id = 0; id < textureCount; ++id)
+		{
+			residentBefore[id] = residency.GetResidentMip(id);
+		}
+		const auto begin = std::chrono::steady_clock::now();
+		residency.Update(streams, evictions);
+		updateMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+
+		const TextureResidency::Statistics statistics = residency.GetStatistics();
+		isWithinBudget = isWithinBudget && statistics.residentBytes <= statistics.budgetBytes;
+		residentSum += static_cast<double>(statistics.residentBytes);
+		peakBytes = (std::max)(peakBytes, statistics.residentBytes);
+
+		// 追い出したミップはこのフレームで使われておらず、残った追い出せる単位はどれもそれより新しい
+		uint64_t newestEvicted = 0;
+		for (const TextureResidency::Transition& eviction : evictions)
+		{
+			for (uint32_t mip = residentBefore[eviction.id]; mip < eviction.firstMip; ++mip)
+			{
+				isUsedMipKept = isUsedMipKept && lastRequested[eviction.id][mip] < frameIndex;
+				newestEvicted = (std::max)(newestEvicted, lastRequested[eviction.id][mip]);
+			}
+			wasEvicted[eviction.id] = true;
+		}
+		for (TextureResidency::TextureId id = 0; id < textureCount && !evictions.empty(); ++id)
+		{
+			const uint32_t resident = residency.GetResidentMip(id);
+			if (isInTransition[id] || resident >= mipCount || lastRequested[id][resident] >= frameIndex)
+			{
+				continue;
+			}
+			isLruOrder = isLruOrder && lastRequested[id][resident] >= newestEvicted;
+		}
+
+		for (const TextureResidency::Transition& stream : streams)
+		{
+			restreamCount += wasEvicted[stream.id] ? 1 : 0;
+			wasEvicted[stream.id] = false;
+		}
+		// 読み込みと作り直しは数フレーム後に終わる（すべて解放するものは待たない）
+		for (const std::vector<TextureResidency::Transition>* transitions : { &streams, &evictions })
+		{
+			for (const TextureResidency::Transition& transition : *transitions)
+			{
+				if (transition.firstMip < mipCount)
+				{
+					pending.push_back({ frameIndex + kResidencyTransitionFrames, transition });
+					isInTransition[transition.id] = true;
+				}
+			}
+		}
+		while (!pending.empty() && pending.front().completeFrame <= frameIndex)
+		{
+			residency.CompleteTransition(pending.front().transition.id, pending.front().transition.firstMip, true);
+			isInTransition[pending.front().transition.id] = false;
+			pending.pop_front();
+		}
+	}
+	check(isWithinBudget, "resident mips stay within the budget every frame");
+	check(isUsedMipKept, "mips requested in the current frame are never evicted");
+	check(isLruOrder, "evictions take the least recently used mips first");
+	check(restreamCount > 0, "evicted mips are streamed back in when the camera returns");
+
+	CheckResidencyPolicy(check);
+
+	const TextureResidency::Statistics statistics = residency.GetStatistics();
+	const double megabyte = 1024.0 * 1024.0;
+	const double frames = static_cast<double>(kResidencyFrames);
+	std::printf("%zu textures %ux%u BC1 (%u mips, tail from mip %u), %zu frames, budget %.0f MB\n", textureCount,
+		kResidencyTextureSize, kResidencyTextureSize, mipCount, tailMip, kResidencyFrames, kResidencyBudgetBytes / megabyte);
+	std::printf("  all resident: %8.1f MB\n", totalBytes / megabyte);
+	std::printf("  residency   : %8.1f MB average, %.1f MB peak (%.1f%% of all resident)\n", residentSum / frames / megabyte,
+		peakBytes / megabyte, 100.0 * residentSum / frames / static_cast<double>(totalBytes));
+	std::printf("  streamed %.1f MB in %llu (%zu after eviction), evicted %.1f MB in %llu, starved %llu, update %.3f ms/frame\n",
+		statistics.streamedBytes / megabyte, static_cast<unsigned long long>(statistics.streamCount), restreamCount,
+		statistics.evictedBytes / megabyte, static_cast<unsigned long long>(statistics.evictionCount),
+		static_cast<unsigned long long>(statistics.starvedCount), updateMs / frames);
+
+	CheckManagedResidency(check);
+	return check.Report();
+}
@@ -0,0 +1,103 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/PMDMappedReader.h"
+#include "Animation/Skinning.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	constexpr int kSkinningIterations = 100;
+
+	/// ボーンごとに異なる回転と平行移動を持つパレットを作ります（毎回同じ値）。
+	std::vector<Skinning::BoneMatrix> MakeTestPalette(size_t boneCount)
+	{
+		std::vector<Skinning::BoneMatrix> palette(boneCount);
+		for (size_t i = 0; i < boneCount; ++i)
+		{
+			const float angle = 0.05f * static_cast<float>(i);
+			const float c = std::cos(angle);
+			const float s = std::sin(angle);
+			Skinning::BoneMatrix& m = palette[i];
+			m.m[0][0] = c;		m.m[0][1] = 0.0f;	m.m[0][2] = s;		m.m[0][3] = 0.1f * static_cast<float>(i % 7);
+			m.m[1][0] = 0.0f;	m.m[1][1] = 1.0f;	m.m[1][2] = 0.0f;	m.m[1][3] = 0.2f * static_cast<float>(i % 5);
+			m.m[2][0] = -s;		m.m[2][1] = 0.0f;	m.m[2][2] = c;		m.m[2][3] = -0.1f * static_cast<float>(i % 3);
+		}
+		return palette;
+	}
+
+	bool IsBitExact(const Skinning::SkinnedVertices& a, const Skinning::SkinnedVertices& b)
+	{
+		const size_t bytes = a.vertexCount * sizeof(float);
+		return a.vertexCount == b.vertexCount &&
+			std::memcmp(a.positionX.data(), b.positionX.data(), bytes) == 0 &&
+			std::memcmp(a.positionY.data(), b.positionY.data(), bytes) == 0 &&
+			std::memcmp(a.positionZ.data(), b.positionZ.data(), bytes) == 0 &&
+			std::memcmp(a.normalX.data(), b.normalX.data(), bytes) == 0 &&
+			std::memcmp(a.normalY.data(), b.normalY.data(), bytes) == 0 &&
+			std::memcmp(a.normalZ.data(), b.normalZ.data(), bytes) == 0;
+	}
+}
+
+int RunSkinningBenchmark(const std::vector<std::filesystem::path>& inputs)
+{
+	const Skinning::IsaLevel levels[] = { Skinning::IsaLevel::Scalar, Skinning::IsaLevel::SSE2, Skinning::IsaLevel::AVX };
+	int failedCount = 0;
+	for (const auto& input : inputs)
+	{
+		PMDMappedReader reader;
+		if (!reader.Open(input))
+		{
+			std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(input).c_str(), reader.GetLastError().c_str());
+			++failedCount;
+			continue;
+		}
+		if (reader.GetVertices().Empty())
+		{
+			continue;
+		}
+
+		Skinning::SourceVertices source;
+		Skinning::BuildSourceVertices(reader.GetVertices(), source);
+		const size_t boneCount = (std::max)(reader.GetBones().Size(), static_cast<size_t>(source.maxBoneIndex) + 1);
+		const std::vector<Skinning::BoneMatrix> palette = MakeTestPalette(boneCount);
+		std::printf("%s (vertices %zu, bones %zu)\n", ToDisplayString(input).c_str(), source.vertexCount, boneCount);
+
+		Skinning::SkinnedVertices reference;
+		Skinning::SkinVertices(source, palette.data(), boneCount, reference, Skinning::IsaLevel::Scalar);
+		for (Skinning::IsaLevel isa : levels)
+		{
+			if (!Skinning::IsIsaLevelSupported(isa))
+			{
+				std::printf("  %-6s : not supported\n", Skinning::GetIsaLevelName(isa));
+				continue;
+			}
+
+			Skinning::SkinnedVertices skinned;
+			const auto begin = std::chrono::steady_clock::now();
+			for (int i = 0; i < kSkinningIterations; ++i)
+			{
+				Skinning::SkinVertices(source, palette.data(), boneCount, skinned, isa);
+			}
+			const auto end = std::chrono::steady_clock::now();
+			const double seconds = std::chrono::duration<double>(end - begin).count();
+			const double verticesPerSecond = seconds > 0.0
+				? static_cast<double>(source.vertexCount) * kSkinningIterations / seconds
+				: 0.0;
+			const bool exact = IsBitExact(reference, skinned);
+			std::printf("  %-6s : %8.2f Mverts/s  %s\n", Skinning::GetIsaLevelName(isa), verticesPerSecond / 1.0e6,
+				exact ? "bit-exact" : "MISMATCH");
+			if (!exact)
+			{
+				++failedCount;
+			}
+		}
+	}
+	return failedCount == 0 ? 0 : 1;
+}
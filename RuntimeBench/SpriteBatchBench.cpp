@@ -0,0 +1,249 @@
+﻿#include "BenchCommon.h"
+
+#include "SpriteRenderers/SpriteBatch.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	/// 画面より一回り広い範囲に置くので、一部は画面の外で捨てられる
+	constexpr uint32_t kSpriteCount = 100000;
+	constexpr uint32_t kSpriteMaterialCount = 4;
+	constexpr uint32_t kSpriteTextureCount = 256;
+	constexpr size_t kSpriteFrames = 60;
+
+	/// 1 フレームのスプライト（一部は画面の外）。マテリアルとテクスチャーは乱数で選ぶ
+	struct SpriteSource
+	{
+		uint32_t materialId = 0;
+		uint32_t textureId = 0;
+		SpriteInstance instance;
+	};
+
+	std::vector<SpriteSource> MakeSpriteSources()
+	{
+		std::vector<SpriteSource> sources(kSpriteCount);
+		uint32_t state = 4242;
+		auto next = [&state]()
+			{
+				state = state * 1664525u + 1013904223u;
+				return state >> 8;
+			};
+		for (uint32_t i = 0; i < kSpriteCount; ++i)
+		{
+			SpriteSource& source = sources[i];
+			source.materialId = next() % kSpriteMaterialCount;
+			source.textureId = next() % kSpriteTextureCount;
+			SpriteInstance& instance = source.instance;
+			instance.centerX = static_cast<float>(next() % 2401) / 1000.0f - 1.2f;
+			instance.centerY = static_cast<float>(next() % 2401) / 1000.0f - 1.2f;
+			instance.width = static_cast<float>(next() % 40 + 5) / 1000.0f;
+			instance.height = static_cast<float>(next() % 40 + 5) / 1000.0f;
+			instance.textureIndex = source.textureId;
+			// 並べ替えの確認用に Add の順を持たせる
+			instance.reserved[0] = i;
+		}
+		return sources;
+	}
+
+	void GatherSprites(const std::vector<SpriteSource>& sources, SpriteBatch& batch, bool isTexturePerInstance)
+	{
+		batch.Clear();
+		for (const SpriteSource& source : sources)
+		{
+			batch.Add(source.materialId, source.textureId, source.instance);
+		}
+		batch.Build(isTexturePerInstance);
+	}
+
+	/// バッチの区切りと並びが期待どおりか（isTexturePerInstance なら区切りはマテリアルだけ）
+	bool IsBatchLayoutValid(const std::vector<SpriteSource>& sources, const SpriteBatch& batch, bool isTexturePerInstance)
+	{
+		const std::vector<SpriteInstance>& instances = batch.GetInstances();
+		uint32_t expectedFirst = 0;
+		uint32_t previousMaterialId = 0;
+		uint32_t previousTextureId = 0;
+		for (const SpriteBatchRange& range : batch.GetBatches())
+		{
+			if (range.firstInstance != expectedFirst || range.instanceCount == 0)
+			{
+				return false;
+			}
+			if (expectedFirst > 0 && (range.materialId < previousMaterialId ||
+				(!isTexturePerInstance && range.materialId == previousMaterialId && range.textureId <= previousTextureId) ||
+				(isTexturePerInstance && range.materialId == previousMaterialId)))
+			{
+				return false;
+			}
+			for (uint32_t i = range.firstInstance; i < range.firstInstance + range.instanceCount; ++i)
+			{
+				const SpriteSource& source = sources[instances[i].reserved[0]];
+				if (source.materialId != range.materialId || (!isTexturePerInstance && source.textureId != range.textureId))
+				{
+					return false;
+				}
+			}
+			expectedFirst += range.instanceCount;
+			previousMaterialId = range.materialId;
+			previousTextureId = range.textureId;
+		}
+		return expectedFirst == instances.size();
+	}
+}
+
+int RunSpriteBatchBenchmark()
+{
+	CheckResults check;
+
+	std::vector<SpriteSource> sources = MakeSpriteSources();
+
+	// 画面と重なるかどうかと、キーの組み合わせを別に数えておく
+	std::vector<uint32_t> visibleIds;
+	std::vector<uint64_t> visibleKeys;
+	for (uint32_t i = 0; i < kSpriteCount; ++i)
+	{
+		const SpriteInstance& instance = sources[i].instance;
+		const bool isVisible = std::fabs(instance.centerX) - instance.width * 0.5f <= 1.0f &&
+			std::fabs(instance.centerY) - instance.height * 0.5f <= 1.0f;
+		if (isVisible)
+		{
+			visibleIds.push_back(i);
+			visibleKeys.push_back((static_cast<uint64_t>(sources[i].materialId) << 32) | sources[i].textureId);
+		}
+	}
+	std::vector<uint64_t> distinctKeys = visibleKeys;
+	std::sort(distinctKeys.begin(), distinctKeys.end());
+	distinctKeys.erase(std::unique(distinctKeys.begin(), distinctKeys.end()), distinctKeys.end());
+	std::vector<uint64_t> distinctMaterials;
+	for (uint64_t key : distinctKeys)
+	{
+		if (distinctMaterials.empty() || distinctMaterials.back() != (key >> 32))
+		{
+			distinctMaterials.push_back(key >> 32);
+		}
+	}
+
+	SpriteBatch batch;
+	batch.Reserve(kSpriteCount);
+	GatherSprites(sources, batch, true);
+	const SpriteBatchStatistics statistics = batch.GetStatistics();
+	check(statistics.submittedCount == kSpriteCount && statistics.instanceCount + statistics.culledCount == kSpriteCount,
+		"every sprite is either kept or culled");
+	check(statistics.instanceCount == visibleIds.size(), "only sprites outside the screen are culled");
+	{
+		// 並べ替えた結果を、同じキーと Add の順での安定ソートと比べる
+		std::vector<uint32_t> expected = visibleIds;
+		std::stable_sort(expected.begin(), expected.end(), [&sources](uint32_t a, uint32_t b)
+			{
+				const uint64_t keyA = (static_cast<uint64_t>(sources[a].materialId) << 32) | sources[a].textureId;
+				const uint64_t keyB = (static_cast<uint64_t>(sources[b].materialId) << 32) | sources[b].textureId;
+				return keyA < keyB;
+			});
+		const std::vector<SpriteInstance>& instances = batch.GetInstances();
+		bool isSameOrder = instances.size() == expected.size();
+		bool isSameContent = isSameOrder;
+		for (size_t i = 0; isSameOrder && i < instances.size(); ++i)
+		{
+			isSameOrder = instances[i].reserved[0] == expected[i];
+			isSameContent = isSameContent && isSameOrder &&
+				std::memcmp(&instances[i], &sources[expected[i]].instance, sizeof(SpriteInstance)) == 0;
+		}
+		check(isSameOrder, "sprites are sorted by material and texture, keeping submission order within a key");
+		check(isSameContent, "instances are copied unchanged");
+	}
+	check(statistics.sortPassCount == 2, "digits that are equal for every key are skipped");
+	check(statistics.batchCount == distinctMaterials.size() && IsBatchLayoutValid(sources, batch, true),
+		"with per-instance textures only material changes split batches");
+	const uint32_t bindlessBatchCount = statistics.batchCount;
+
+	GatherSprites(sources, batch, false);
+	check(batch.GetStatistics().batchCount == distinctKeys.size() && IsBatchLayoutValid(sources, batch, false),
+		"with bound textures every material and texture pair is its own batch");
+	const uint32_t tableBatchCount = batch.GetStatistics().batchCount;
+
+	{
+		SpriteBatch small;
+		small.Build(true);
+		check(small.GetBatches().empty() && small.GetInstances().empty(), "an empty frame has no batches");
+		SpriteInstance instance;
+		instance.width = 0.1f;
+		instance.height = 0.1f;
+		instance.centerX = 1.04f;
+		check(small.Add(7, 3, instance), "a sprite overlapping the edge is kept");
+		instance.centerX = 1.06f;
+		check(!small.Add(7, 3, instance), "a sprite just outside the edge is culled");
+		instance.centerX = -0.5f;
+		small.Add(UINT32_MAX, UINT32_MAX, instance);
+		small.Build(false);
+		check(small.GetBatches().size() == 2 && small.GetBatches()[1].materialId == UINT32_MAX &&
+			small.GetBatches()[1].textureId == UINT32_MAX && small.GetStatistics().sortPassCount == 8,
+			"the largest keys sort last");
+		small.Clear();
+		small.Build(false);
+		check(small.GetBatches().empty() && small.GetStatistics().submittedCount == 0, "Clear starts a new frame");
+	}
+
+	// 集める + 並べ替える時間（スプライトは毎フレーム少しずつ動かす）
+	double gatherMs = 0.0;
+	double tableGatherMs = 0.0;
+	double stableSortMs = 0.0;
+	{
+		size_t batchSum = 0;
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < kSpriteFrames; ++frame)
+		{
+			for (SpriteSource& source : sources)
+			{
+				source.instance.centerX += 0.0001f;
+			}
+			GatherSprites(sources, batch, true);
+			batchSum += batch.GetBatches().size();
+		}
+		gatherMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() /
+			static_cast<double>(kSpriteFrames);
+
+		const auto tableBegin = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < kSpriteFrames; ++frame)
+		{
+			GatherSprites(sources, batch, false);
+			batchSum += batch.GetBatches().size();
+		}
+		tableGatherMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - tableBegin).count() /
+			static_cast<double>(kSpriteFrames);
+		check(batchSum > 0, "timed frames produce batches");
+
+		// 比較: キーとインデックスの組を std::stable_sort で並べ替える
+		std::vector<std::pair<uint64_t, uint32_t>> pairs;
+		pairs.reserve(kSpriteCount);
+		size_t orderSum = 0;
+		const auto sortBegin = std::chrono::steady_clock::now();
+		for (size_t frame = 0; frame < kSpriteFrames; ++frame)
+		{
+			pairs.clear();
+			for (uint32_t i = 0; i < kSpriteCount; ++i)
+			{
+				pairs.emplace_back((static_cast<uint64_t>(sources[i].materialId) << 32) | sources[i].textureId, i);
+			}
+			std::stable_sort(pairs.begin(), pairs.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+			orderSum += pairs.front().second;
+		}
+		stableSortMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sortBegin).count() /
+			static_cast<double>(kSpriteFrames);
+		(void)orderSum;
+	}
+
+	std::printf("%u sprites (%u materials x %u textures), %zu frames\n", kSpriteCount, kSpriteMaterialCount, kSpriteTextureCount, kSpriteFrames);
+	std::printf("  culling           : %u kept, %u outside the screen\n", statistics.instanceCount, statistics.culledCount);
+	std::printf("  draws             : per-sprite %u, per material/texture %u, bindless %u\n",
+		statistics.instanceCount, tableBatchCount, bindlessBatchCount);
+	std::printf("  gather + sort     : bindless %.3f ms, per texture %.3f ms per frame (%.1f%% of a 60 fps frame), %u radix passes\n",
+		gatherMs, tableGatherMs, gatherMs * 100.0 / (1000.0 / 60.0), statistics.sortPassCount);
+	std::printf("  std::stable_sort  : %.3f ms per frame (keys only)\n", stableSortMs);
+	std::printf("  instance buffer   : %.1f KB per frame\n", static_cast<double>(statistics.instanceCount) * sizeof(SpriteInstance) / 1024.0);
+	return check.Report();
+}
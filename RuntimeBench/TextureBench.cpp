@@ -0,0 +1,97 @@
+﻿#include "BenchCommon.h"
+#include "FakeTextureLoader.h"
+
+#include "RHI/TextureAssetManager.h"
+#include "System/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kTextureCount = 32;
+}
+
+int RunTextureBenchmark()
+{
+	TextureAssetManager& manager = TextureAssetManager::Get();
+	manager.SetLoader(std::make_shared<FakeTextureLoader>());
+	manager.ProcessPendingTextures();
+	CheckResults check;
+
+	// 同期読み込み: 従来の AcquireTexture はデコードの間ロックを持ったまま戻らない
+	FakeTextureLoader syncLoader;
+	const auto syncBegin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kTextureCount; ++i)
+	{
+		syncLoader.Decode("sync_" + std::to_string(i) + ".png");
+	}
+	const double syncMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - syncBegin).count();
+
+	// 非同期: 1 フレームで全テクスチャを要求し、毎フレーム公開処理を回す
+	std::vector<TextureHandle> handles;
+	double maxAcquireUs = 0.0;
+	const auto asyncBegin = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < kTextureCount; ++i)
+	{
+		const auto begin = std::chrono::steady_clock::now();
+		handles.push_back(manager.AcquireTexture(("texture_" + std::to_string(i) + ".png").c_str()));
+		maxAcquireUs = (std::max)(maxAcquireUs, std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - begin).count());
+	}
+	const TextureHandle missing = manager.AcquireTexture("missing.png");
+	const TextureHandle released = manager.AcquireTexture("released_while_pending.png");
+	check(manager.AcquireTexture("texture_0.png") == handles[0], "same path shares a handle");
+	manager.ReleaseTexture(handles[0]);
+
+	TextureAssetManager::TextureState state = TextureAssetManager::TextureState::Ready;
+	check(GetFakeTexturePath(manager.GetTexture(handles[0], &state)) == "placeholder" && state == TextureAssetManager::TextureState::Pending,
+		"pending texture returns the placeholder");
+	manager.ReleaseTexture(released);
+
+	size_t frames = 0;
+	double maxFrameMs = 0.0;
+	while (manager.GetPendingCount() > 0 && frames < kMaxTextureFrames)
+	{
+		const auto frameBegin = std::chrono::steady_clock::now();
+		manager.ProcessPendingTextures();
+		maxFrameMs = (std::max)(maxFrameMs, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - frameBegin).count());
+		++frames;
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	const double asyncMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - asyncBegin).count();
+
+	for (size_t i = 0; i < kTextureCount; ++i)
+	{
+		const std::shared_ptr<RHITexture> texture = manager.GetTexture(handles[i], &state);
+		check(state == TextureAssetManager::TextureState::Ready && GetFakeTexturePath(texture) == "texture_" + std::to_string(i) + ".png",
+			"decoded texture is published under its handle");
+	}
+	check(GetFakeTexturePath(manager.GetTexture(missing, &state)) == "placeholder" && state == TextureAssetManager::TextureState::Failed,
+		"failed decode keeps the placeholder");
+	check(manager.GetTexture(released) == nullptr, "texture released while pending is dropped");
+
+	// Clear の前に開始したデコードは、振り直した同じ番号のハンドルに公開されない
+	manager.AcquireTexture("cleared.png");
+	manager.Clear();
+	const TextureHandle reused = manager.AcquireTexture("after_clear.png");
+	while (manager.GetPendingCount() > 0 && frames < kMaxTextureFrames)
+	{
+		manager.ProcessPendingTextures(0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	check(GetFakeTexturePath(manager.GetTexture(reused)) == "after_clear.png", "decode started before Clear is discarded");
+
+	std::printf("%zu textures, %lld ms decode each, %zu workers\n", kTextureCount,
+		static_cast<long long>(kFakeDecodeTime.count()), JobSystem::Get().GetWorkerCount());
+	std::printf("  sync : blocks %8.2f ms\n", syncMs);
+	std::printf("  async: acquire max %8.2f us, publish max %6.3f ms/frame, all ready after %zu frames (%.2f ms)\n",
+		maxAcquireUs, maxFrameMs, frames, asyncMs);
+
+	manager.Clear();
+	manager.SetLoader(nullptr);
+	return check.Report();
+}
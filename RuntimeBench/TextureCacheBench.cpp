@@ -0,0 +1,205 @@
+﻿#include "BenchCommon.h"
+
+#include "Analyzer/MappedFile.h"
+#include "Analyzer/TextureCache.h"
+#include "Analyzer/TextureMips.h"
+#include "System/ContentHash.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kCacheTextureCount = 24;
+	constexpr uint32_t kCacheTextureSize = 512;
+
+	/// 合成した元画像（RGBA8 を詰めて並べただけのファイル）を書き出します。
+	std::vector<std::filesystem::path> WriteCacheSources(const std::filesystem::path& directory)
+	{
+		std::vector<std::filesystem::path> paths;
+		std::vector<uint8_t> pixels(static_cast<size_t>(kCacheTextureSize) * kCacheTextureSize * 4);
+		for (size_t i = 0; i < kCacheTextureCount; ++i)
+		{
+			uint32_t state = static_cast<uint32_t>(i) * 2654435761u + 1;
+			for (uint32_t y = 0; y < kCacheTextureSize; ++y)
+			{
+				for (uint32_t x = 0; x < kCacheTextureSize; ++x)
+				{
+					state = state * 1664525u + 1013904223u;
+					uint8_t* texel = &pixels[(static_cast<size_t>(y) * kCacheTextureSize + x) * 4];
+					texel[0] = static_cast<uint8_t>(x * 255 / kCacheTextureSize);
+					texel[1] = static_cast<uint8_t>(y * 255 / kCacheTextureSize);
+					texel[2] = static_cast<uint8_t>(state >> 24);
+					texel[3] = static_cast<uint8_t>((x / 32 + y / 32 + i) % 2 == 0 ? 255 : 128);
+				}
+			}
+			paths.push_back(directory / ("source_" + std::to_string(i) + ".rgba"));
+			std::ofstream stream(paths.back(), std::ios::binary | std::ios::trunc);
+			stream.write(reinterpret_cast<const char*>(pixels.data()), static_cast<std::streamsize>(pixels.size()));
+		}
+		return paths;
+	}
+
+	/// 1 枚分の読み込み。キャッシュを引き、外れたらミップを生成して保存します。
+	/// GPU への転送の代わりにステージング領域へ写し、写した内容のハッシュを返します。
+	uint64_t ImportCachedTexture(const std::filesystem::path& path, uint64_t settingsHash, std::vector<uint8_t>& staging)
+	{
+		MappedFile source;
+		if (!source.Open(path))
+		{
+			return 0;
+		}
+		TextureCache& cache = TextureCache::Get();
+		const uint64_t key = TextureCache::ComputeKey(source.GetData(), source.GetSize(), settingsHash);
+
+		uint64_t hash = ContentHash::kOffsetBasis;
+		CachedTextureFile cached;
+		if (cache.Lookup(key, cached))
+		{
+			for (uint32_t mip = 0; mip < cached.GetMipCount(); ++mip)
+			{
+				const size_t size = static_cast<size_t>(cached.GetMip(mip).slicePitch);
+				staging.resize((std::max)(staging.size(), size));
+				std::memcpy(staging.data(), cached.GetMipPixels(mip), size);
+				hash = ContentHash::Compute(staging.data(), size, hash);
+			}
+			return hash;
+		}
+
+		const std::vector<TextureMips::Level> levels = TextureMips::Generate(source.GetData(), kCacheTextureSize, kCacheTextureSize,
+			static_cast<size_t>(kCacheTextureSize) * 4, TextureMips::Filter::Kaiser, true);
+		std::vector<TextureCache::MipData> mips(levels.size());
+		for (size_t mip = 0; mip < levels.size(); ++mip)
+		{
+			mips[mip].pixels = levels[mip].pixels.data();
+			mips[mip].rowPitch = static_cast<size_t>(levels[mip].width) * 4;
+			mips[mip].slicePitch = levels[mip].pixels.size();
+			mips[mip].width = levels[mip].width;
+			mips[mip].height = levels[mip].height;
+
+			staging.resize((std::max)(staging.size(), levels[mip].pixels.size()));
+			std::memcpy(staging.data(), levels[mip].pixels.data(), levels[mip].pixels.size());
+			hash = ContentHash::Compute(staging.data(), levels[mip].pixels.size(), hash);
+		}
+		cache.Store(key, 28 /* DXGI_FORMAT_R8G8B8A8_UNORM */, kCacheTextureSize, kCacheTextureSize, mips.data(), static_cast<uint32_t>(mips.size()));
+		return hash;
+	}
+}
+
+int RunTextureCacheBenchmark()
+{
+	CheckResults check;
+
+	const std::filesystem::path root = std::filesystem::temp_directory_path() / "RuntimeBench_texcache";
+	const std::filesystem::path cacheDirectory = root / "cache";
+	std::error_code ec;
+	std::filesystem::remove_all(root, ec);
+	std::filesystem::create_directories(root);
+	const std::vector<std::filesystem::path> sources = WriteCacheSources(root);
+	const uint64_t settingsHash = 1;
+
+	TextureCache& cache = TextureCache::Get();
+	std::vector<uint8_t> staging;
+	auto runStartup = [&](std::vector<uint64_t>& outHashes)
+	{
+		// 起動ごとにディレクトリを開き直す（エントリーの列挙も時間に含める）
+		const auto begin = std::chrono::steady_clock::now();
+		cache.Close();
+		cache.Open(cacheDirectory);
+		cache.ResetStatistics();
+		outHashes.clear();
+		for (const auto& source : sources)
+		{
+			outHashes.push_back(ImportCachedTexture(source, settingsHash, staging));
+		}
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	};
+
+	std::vector<uint64_t> coldHashes;
+	std::vector<uint64_t> warmHashes;
+	const double coldMs = runStartup(coldHashes);
+	const TextureCache::Statistics cold = cache.GetStatistics();
+	const std::string coldReport = cache.FormatReport();
+	const double warmMs = runStartup(warmHashes);
+	const TextureCache::Statistics warm = cache.GetStatistics();
+	const std::string warmReport = cache.FormatReport();
+
+	check(cold.misses == kCacheTextureCount && cold.hits == 0 && cold.stores == kCacheTextureCount, "cold start misses and stores every texture");
+	check(warm.hits == kCacheTextureCount && warm.misses == 0, "warm start hits every texture");
+	check(coldHashes == warmHashes, "cached payload matches the generated mips");
+
+	CachedTextureFile entry;
+	{
+		MappedFile source;
+		source.Open(sources[0]);
+		check(cache.Lookup(TextureCache::ComputeKey(source.GetData(), source.GetSize(), settingsHash), entry) && entry.VerifyPayloadHash(),
+			"entry payload hash verifies");
+		check(entry.IsValid() && entry.GetMipCount() == TextureMips::GetMipCount(kCacheTextureSize, kCacheTextureSize) &&
+			entry.GetMip(1).offset % TextureCacheFormat::kPayloadAlignment == 0, "entry stores the full aligned mip chain");
+		entry.Close();
+
+		cache.ResetStatistics();
+		check(!cache.Lookup(TextureCache::ComputeKey(source.GetData(), source.GetSize(), settingsHash + 1), entry),
+			"different import settings miss");
+	}
+
+	// 元データを 1 バイト変えると別のキーになる
+	{
+		std::fstream stream(sources[1], std::ios::binary | std::ios::in | std::ios::out);
+		stream.seekp(100);
+		stream.put('\x7F');
+	}
+	std::vector<uint8_t> scratch;
+	cache.ResetStatistics();
+	ImportCachedTexture(sources[1], settingsHash, scratch);
+	check(cache.GetStatistics().misses == 1, "edited source misses");
+
+	// 壊れたエントリーはミスとして扱われ、作り直される
+	{
+		MappedFile source;
+		source.Open(sources[0]);
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.texc",
+			static_cast<unsigned long long>(TextureCache::ComputeKey(source.GetData(), source.GetSize(), settingsHash)));
+		std::filesystem::resize_file(cacheDirectory / name, 1000);
+	}
+	cache.Close();
+	cache.Open(cacheDirectory);
+	cache.ResetStatistics();
+	for (const auto& source : sources)
+	{
+		ImportCachedTexture(source, settingsHash, scratch);
+	}
+	const TextureCache::Statistics repaired = cache.GetStatistics();
+	check(repaired.misses == 1 && repaired.stores == 1, "truncated entry misses and is rewritten");
+
+	// 上限を半分にして開き直すと、最後に使ったものを残して古いものから消える
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	cache.ResetStatistics();
+	const uint64_t recentHash = ImportCachedTexture(sources[5], settingsHash, scratch);
+	const uint64_t fullBytes = cache.GetStatistics().totalBytes;
+	cache.Close();
+	cache.Open(cacheDirectory, fullBytes / 2);
+	const TextureCache::Statistics evicted = cache.GetStatistics();
+	check(evicted.evictions > 0 && evicted.totalBytes <= fullBytes / 2, "reopening with a smaller limit evicts down to it");
+	cache.ResetStatistics();
+	check(ImportCachedTexture(sources[5], settingsHash, scratch) == recentHash && cache.GetStatistics().hits == 1,
+		"most recently used entry survives eviction");
+
+	std::printf("%zu textures %ux%u RGBA8, Kaiser mips, %.1f MB cached\n", kCacheTextureCount, kCacheTextureSize, kCacheTextureSize,
+		static_cast<double>(warm.hitBytes) / (1024.0 * 1024.0));
+	std::printf("  cold: %9.2f ms (%7.3f ms/texture)  %s\n", coldMs, coldMs / kCacheTextureCount, coldReport.c_str());
+	std::printf("  warm: %9.2f ms (%7.3f ms/texture)  %s\n", warmMs, warmMs / kCacheTextureCount, warmReport.c_str());
+	std::printf("  warm start is %.1fx faster\n", warmMs > 0.0 ? coldMs / warmMs : 0.0);
+
+	cache.Close();
+	std::filesystem::remove_all(root, ec);
+	return check.Report();
+}
@@ -0,0 +1,489 @@
+﻿#include "BenchCommon.h"
+
+#include "RHI/GpuUploadQueue.h"
+#include "RHI/TextureAssetManager.h"
+#include "RHI/UploadRing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <vector>
+
+namespace
+{
+	constexpr size_t kUploadTextureCount = 300;
+	/// 実機の既定（16MB）より小さくして、折り返しと分割転送を起こす
+	constexpr uint64_t kUploadStagingSize = 4ull * 1024 * 1024;
+	/// 疑似 DXGI_FORMAT（R8G8B8A8_UNORM / BC1_UNORM）
+	constexpr uint32_t kUploadFormatRgba8 = 28;
+	constexpr uint32_t kUploadFormatBc1 = 71;
+	/// UploadBuffer の確認に使う小さなステージング（1 つのバッファで何度も折り返す大きさ）
+	constexpr uint64_t kBufferStagingSize = 64 * 1024;
+	constexpr size_t kUploadBufferCount = 400;
+	/// UploadRing を乱数で動かす回数と、そのときの容量
+	constexpr size_t kRingFuzzSteps = 200000;
+	constexpr uint64_t kRingFuzzCapacity = 4096;
+
+	/// 転送先のテクスチャー（サブリソースごとに詰めた行を持つ）
+	struct FakeGpuTexture
+	{
+		uint32_t format = 0;
+		std::vector<std::vector<uint8_t>> subresources;
+		std::vector<uint64_t> rowBytes;
+	};
+
+	/// 転送先のバッファ
+	struct FakeGpuBuffer
+	{
+		std::vector<uint8_t> bytes;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// GPU を持たない転送先。提出したコピーは 1 つ後の提出が来るまで完了扱いにせず、
+	/// 実行中のステージングを上書きすれば内容の不一致として現れるようにします。
+	/// </summary>
+	///====================================================================
+	class FakeUploadBackend final : public IGpuUploadBackend
+	{
+	public:
+		explicit FakeUploadBackend(uint64_t stagingSize) : m_Staging(static_cast<size_t>(stagingSize)) {}
+
+		uint8_t* GetStagingData() override { return m_Staging.data(); }
+		uint64_t GetStagingSize() const override { return m_Staging.size(); }
+
+		void RecordBufferCopy(void* destination, uint64_t destinationOffset, uint64_t stagingOffset, uint64_t size) override
+		{
+			if (stagingOffset % GpuUploadQueue::kStagingAlignment != 0)
+			{
+				++m_MisalignedCount;
+			}
+			Copy copy;
+			copy.buffer = static_cast<FakeGpuBuffer*>(destination);
+			copy.destinationOffset = destinationOffset;
+			copy.stagingOffset = stagingOffset;
+			copy.size = size;
+			m_Recorded.push_back(copy);
+		}
+
+		void RecordTextureCopy(void* destination, uint32_t subresource, uint32_t destinationY, uint64_t stagingOffset, const TextureFootprint& footprint) override
+		{
+			if (stagingOffset % GpuUploadQueue::kTexturePlacementAlignment != 0 || footprint.rowPitch % GpuUploadQueue::kTextureRowPitchAlignment != 0)
+			{
+				++m_MisalignedCount;
+			}
+			// 実行時に読むのでステージングの内容はここで写さない
+			Copy copy;
+			copy.texture = static_cast<FakeGpuTexture*>(destination);
+			copy.subresource = subresource;
+			copy.destinationY = destinationY;
+			copy.stagingOffset = stagingOffset;
+			copy.footprint = footprint;
+			m_Recorded.push_back(copy);
+		}
+
+		uint64_t Submit() override
+		{
+			const uint64_t fenceValue = ++m_LastFence;
+			m_Submitted.push_back({ fenceValue, std::move(m_Recorded) });
+			m_Recorded.clear();
+			return fenceValue;
+		}
+
+		uint64_t GetCompletedFenceValue() override
+		{
+			return m_CompletedFence;
+		}
+
+		void WaitForFence(uint64_t fenceValue) override
+		{
+			if (fenceValue > m_CompletedFence)
+			{
+				++m_WaitCount;
+			}
+			Complete(fenceValue);
+		}
+
+		/// 最新の 1 つを残して完了させます（1 フレーム遅れの GPU を模す）。
+		void AdvanceFrame()
+		{
+			if (m_LastFence > 1)
+			{
+				Complete(m_LastFence - 1);
+			}
+		}
+
+		size_t GetMisalignedCount() const { return m_MisalignedCount; }
+		size_t GetOutOfBoundsCount() const { return m_OutOfBoundsCount; }
+		/// キューが自分で完了を待った（ステージングが空かずに止まった）回数
+		size_t GetWaitCount() const { return m_WaitCount; }
+
+	private:
+		struct Copy
+		{
+			FakeGpuTexture* texture = nullptr;
+			uint32_t subresource = 0;
+			uint32_t destinationY = 0;
+			TextureFootprint footprint;
+			FakeGpuBuffer* buffer = nullptr;
+			uint64_t destinationOffset = 0;
+			uint64_t size = 0;
+			uint64_t stagingOffset = 0;
+		};
+
+		struct Submission
+		{
+			uint64_t fenceValue;
+			std::vector<Copy> copies;
+		};
+
+		void Complete(uint64_t fenceValue)
+		{
+			while (!m_Submitted.empty() && m_Submitted.front().fenceValue <= fenceValue)
+			{
+				for (const Copy& copy : m_Submitted.front().copies)
+				{
+					Execute(copy);
+				}
+				m_CompletedFence = m_Submitted.front().fenceValue;
+				m_Submitted.pop_front();
+			}
+		}
+
+		void Execute(const Copy& copy)
+		{
+			if (copy.buffer != nullptr)
+			{
+				std::vector<uint8_t>& target = copy.buffer->bytes;
+				if (copy.destinationOffset + copy.size > target.size() || copy.stagingOffset + copy.size > m_Staging.size())
+				{
+					++m_OutOfBoundsCount;
+					return;
+				}
+				std::memcpy(&target[static_cast<size_t>(copy.destinationOffset)], &m_Staging[static_cast<size_t>(copy.stagingOffset)], static_cast<size_t>(copy.size));
+				return;
+			}
+			const uint32_t rowHeight = copy.footprint.format == kUploadFormatBc1 ? 4 : 1;
+			std::vector<uint8_t>& target = copy.texture->subresources[copy.subresource];
+			const uint64_t rowBytes = copy.texture->rowBytes[copy.subresource];
+			const uint64_t firstRow = copy.destinationY / rowHeight;
+			const uint64_t rowCount = (std::min)(static_cast<uint64_t>(copy.footprint.height / rowHeight), target.size() / rowBytes - firstRow);
+			for (uint64_t row = 0; row < rowCount; ++row)
+			{
+				std::memcpy(&target[(firstRow + row) * rowBytes], &m_Staging[copy.stagingOffset + row * copy.footprint.rowPitch], static_cast<size_t>(rowBytes));
+			}
+		}
+
+		std::vector<uint8_t> m_Staging;
+		std::vector<Copy> m_Recorded;
+		std::deque<Submission> m_Submitted;
+		uint64_t m_LastFence = 0;
+		uint64_t m_CompletedFence = 0;
+		size_t m_MisalignedCount = 0;
+		size_t m_OutOfBoundsCount = 0;
+		size_t m_WaitCount = 0;
+	};
+
+	///====================================================================
+	/// <summary>
+	/// UploadRing に確保・提出・完了を乱数で与え、確保した領域を別に持った写しと突き合わせます。
+	/// 新しい領域は境界に揃い、容量に収まり、完了していない領域と重ならないこと、
+	/// 全て完了すればどこにいてもキューの 1 回の最大（容量の半分）を確保できることを確認します。
+	/// </summary>
+	///====================================================================
+	void CheckUploadRing(CheckResults& check)
+	{
+		// 折り返し：末尾に収まらない確保は先頭から始まり、飛ばした末尾も使用中に数える
+		UploadRing ring(1024);
+		uint64_t offset = 0;
+		check(ring.Allocate(600, 16, offset) && offset == 0, "the first allocation starts at offset 0");
+		ring.CloseSubmission(1);
+		check(!ring.Allocate(600, 16, offset), "an allocation that overlaps a pending submission fails");
+		ring.Reclaim(0);
+		check(!ring.Allocate(600, 16, offset), "a submission is not reused before its fence completes");
+		ring.Reclaim(1);
+		check(ring.Allocate(600, 16, offset) && offset == 0 && ring.GetUsedSize() == 1024,
+			"an allocation past the end wraps to the start and counts the skipped tail");
+		check(!ring.Allocate(1, 1, offset), "a full ring refuses even one byte");
+		check(!ring.Allocate(0, 16, offset) && !ring.Allocate(1025, 16, offset), "empty and oversized allocations fail");
+
+		struct Allocation
+		{
+			uint64_t offset;
+			uint64_t size;
+			uint64_t fenceValue;	// 0 はまだ提出していない
+		};
+		std::vector<Allocation> live;
+		ring.Reset(kRingFuzzCapacity);
+		uint64_t nextFence = 1;
+		uint64_t completedFence = 0;
+		uint32_t state = 777;
+		const auto random = [&state](uint32_t range)
+		{
+			state = state * 1664525u + 1013904223u;
+			return (state >> 8) % range;
+		};
+		size_t allocatedCount = 0;
+		size_t wrapCount = 0;
+		bool isPlacementValid = true;
+		bool isFullAfterIdle = true;
+		uint64_t lastOffset = 0;
+		for (size_t step = 0; step < kRingFuzzSteps; ++step)
+		{
+			const uint32_t action = random(16);
+			if (action < 11)
+			{
+				const uint64_t size = 1 + random(900);
+				const uint64_t alignment = uint64_t(1) << random(9);
+				if (!ring.Allocate(size, alignment, offset))
+				{
+					continue;
+				}
+				++allocatedCount;
+				wrapCount += offset < lastOffset ? 1 : 0;
+				lastOffset = offset;
+				isPlacementValid = isPlacementValid && offset % alignment == 0 && offset + size <= kRingFuzzCapacity;
+				for (const Allocation& other : live)
+				{
+					isPlacementValid = isPlacementValid && (offset + size <= other.offset || other.offset + other.size <= offset);
+				}
+				live.push_back({ offset, size, 0 });
+			}
+			else if (action < 14)
+			{
+				ring.CloseSubmission(nextFence);
+				for (Allocation& allocation : live)
+				{
+					allocation.fenceValue = allocation.fenceValue == 0 ? nextFence : allocation.fenceValue;
+				}
+				++nextFence;
+			}
+			else
+			{
+				// GPU は提出の順に、ときどきまとめて進む
+				completedFence += random(static_cast<uint32_t>(nextFence - completedFence));
+				ring.Reclaim(completedFence);
+				live.erase(std::remove_if(live.begin(), live.end(), [completedFence](const Allocation& allocation)
+				{
+					return allocation.fenceValue != 0 && allocation.fenceValue <= completedFence;
+				}), live.end());
+			}
+
+			if (step % 1000 == 999)
+			{
+				// 全て提出して完了させれば、折り返しを挟んでも容量の半分は必ず確保できる
+				UploadRing idle = ring;
+				idle.CloseSubmission(nextFence);
+				idle.Reclaim(nextFence);
+				uint64_t idleOffset = 0;
+				isFullAfterIdle = isFullAfterIdle && idle.GetUsedSize() == 0 && idle.Allocate(kRingFuzzCapacity / 2, GpuUploadQueue::kTexturePlacementAlignment, idleOffset);
+			}
+		}
+		check(isPlacementValid, "ring allocations are aligned, in range and never overlap an in-flight region");
+		check(isFullAfterIdle, "an idle ring can always hand out half its capacity");
+		check(allocatedCount > kRingFuzzSteps / 4 && wrapCount > 100, "the ring fuzz allocates and wraps many times");
+	}
+
+	///====================================================================
+	/// <summary>
+	/// 大きさと書き込み先のオフセットがばらばらなバッファを、小さなステージングで GpuUploadQueue に流します。
+	/// isGpuStalled では GPU が自分では進まず、キューが自分で完了を待って領域を空けるしかない場合を確かめます。
+	/// </summary>
+	///====================================================================
+	void CheckBufferUploads(bool isGpuStalled, CheckResults& check)
+	{
+		std::vector<FakeGpuBuffer> targets(kUploadBufferCount);
+		std::vector<std::vector<uint8_t>> expected(kUploadBufferCount);
+		std::vector<std::vector<uint8_t>> sources(kUploadBufferCount);
+		std::vector<uint64_t> offsets(kUploadBufferCount);
+		uint32_t state = isGpuStalled ? 99 : 42;
+		uint64_t totalBytes = 0;
+		for (size_t i = 0; i < kUploadBufferCount; ++i)
+		{
+			state = state * 1664525u + 1013904223u;
+			// 10 個に 1 個はステージングの半分を超えて分割され、たまに 3 倍を超える
+			const uint64_t size = i % 10 == 0 ? kBufferStagingSize / 2 + (state >> 8) % (kBufferStagingSize * 3) : 1 + (state >> 8) % 5000;
+			offsets[i] = (state >> 4) % 64;
+			sources[i].resize(static_cast<size_t>(size));
+			for (uint8_t& value : sources[i])
+			{
+				state = state * 1664525u + 1013904223u;
+				value = static_cast<uint8_t>(state >> 24);
+			}
+			// 書き込まない前後の領域は 0xCD のまま残るはず
+			targets[i].bytes.assign(static_cast<size_t>(offsets[i] + size + 32), 0xCD);
+			expected[i] = targets[i].bytes;
+			std::copy(sources[i].begin(), sources[i].end(), expected[i].begin() + static_cast<ptrdiff_t>(offsets[i]));
+			totalBytes += size;
+		}
+
+		FakeUploadBackend backend(kBufferStagingSize);
+		GpuUploadQueue queue(backend);
+		bool isAccepted = true;
+		for (size_t i = 0; i < kUploadBufferCount; ++i)
+		{
+			isAccepted = isAccepted && queue.UploadBuffer(&targets[i], offsets[i], sources[i].data(), sources[i].size());
+			// 呼び出しから戻った後は元データを破棄してかまわない
+			std::fill(sources[i].begin(), sources[i].end(), uint8_t(0));
+			if (i % 8 == 7)
+			{
+				queue.Flush();
+				if (!isGpuStalled)
+				{
+					backend.AdvanceFrame();
+				}
+			}
+		}
+		const size_t waitCount = backend.GetWaitCount();
+		queue.WaitIdle();
+
+		const char* label = isGpuStalled ? "stalled GPU" : "GPU one frame behind";
+		std::printf("  UploadBuffer (%s): %zu buffers, %.1f MB through %.0f KB staging, %llu submits, %zu waits\n",
+			label, kUploadBufferCount, static_cast<double>(totalBytes) / (1024.0 * 1024.0),
+			static_cast<double>(kBufferStagingSize) / 1024.0, static_cast<unsigned long long>(queue.GetSubmitCount()), waitCount);
+		check(isAccepted, "UploadBuffer accepts every buffer");
+		check(targets.size() == expected.size() && std::equal(targets.begin(), targets.end(), expected.begin(),
+			[](const FakeGpuBuffer& target, const std::vector<uint8_t>& bytes) { return target.bytes == bytes; }),
+			"every buffer byte arrives and the bytes around it are untouched");
+		check(backend.GetMisalignedCount() == 0 && backend.GetOutOfBoundsCount() == 0, "buffer copies are aligned and in bounds");
+		check(queue.GetUploadedBytes() == totalBytes, "uploaded buffer byte count matches");
+		check(totalBytes > kBufferStagingSize * 10 && queue.GetSubmitCount() > kUploadBufferCount / 8,
+			"the staging ring is reused many times over");
+		if (isGpuStalled)
+		{
+			check(waitCount > 0, "a full ring waits for the oldest fence instead of overwriting in-flight data");
+		}
+	}
+
+	void CheckInvalidUploads(CheckResults& check)
+	{
+		FakeUploadBackend backend(kBufferStagingSize);
+		GpuUploadQueue queue(backend);
+		FakeGpuBuffer target;
+		target.bytes.resize(16);
+		const uint8_t data[16] = {};
+		check(!queue.UploadBuffer(nullptr, 0, data, sizeof(data)) && !queue.UploadBuffer(&target, 0, nullptr, sizeof(data)) &&
+			!queue.UploadBuffer(&target, 0, data, 0), "UploadBuffer rejects a missing destination, missing data and size 0");
+		check(queue.Flush() == 0 && queue.GetSubmitCount() == 0, "rejected uploads do not submit anything");
+	}
+}
+
+int RunUploadBenchmark()
+{
+	CheckResults check;
+
+	// 大きさとフォーマットの混ざったミップ付きテクスチャー（元データ）
+	struct SourceTexture
+	{
+		uint32_t format;
+		std::vector<std::vector<uint8_t>> mips;
+		std::vector<GpuUploadQueue::TextureSubresource> subresources;
+	};
+	std::vector<SourceTexture> sources(kUploadTextureCount);
+	uint64_t totalBytes = 0;
+	size_t subresourceCount = 0;
+	uint32_t state = 12345;
+	for (size_t i = 0; i < kUploadTextureCount; ++i)
+	{
+		SourceTexture& source = sources[i];
+		source.format = i % 3 == 0 ? kUploadFormatRgba8 : kUploadFormatBc1;
+		// 20 枚に 1 枚はステージングの半分を超える 2048x2048
+		const uint32_t size = i % 20 == 0 ? 2048 : (64u << (i % 4));
+		for (uint32_t width = size, height = size; ; width = (std::max)(width / 2, 1u), height = (std::max)(height / 2, 1u))
+		{
+			GpuUploadQueue::TextureSubresource subresource;
+			subresource.width = width;
+			subresource.height = height;
+			if (source.format == kUploadFormatBc1)
+			{
+				subresource.rowHeight = 4;
+				subresource.rowPitch = static_cast<uint64_t>((width + 3) / 4) * 8;
+				subresource.rowCount = (height + 3) / 4;
+			}
+			else
+			{
+				subresource.rowPitch = static_cast<uint64_t>(width) * 4;
+				subresource.rowCount = height;
+			}
+			std::vector<uint8_t> pixels(static_cast<size_t>(subresource.rowPitch * subresource.rowCount));
+			for (uint8_t& value : pixels)
+			{
+				state = state * 1664525u + 1013904223u;
+				value = static_cast<uint8_t>(state >> 24);
+			}
+			totalBytes += pixels.size();
+			source.mips.push_back(std::move(pixels));
+			source.subresources.push_back(subresource);
+			if (width == 1 && height == 1)
+			{
+				break;
+			}
+		}
+		for (size_t mip = 0; mip < source.mips.size(); ++mip)
+		{
+			source.subresources[mip].pixels = source.mips[mip].data();
+		}
+		subresourceCount += source.mips.size();
+	}
+
+	std::vector<FakeGpuTexture> targets(kUploadTextureCount);
+	FakeUploadBackend backend(kUploadStagingSize);
+	size_t frames = 0;
+	double uploadMs = 0.0;
+	{
+		GpuUploadQueue queue(backend);
+		for (size_t i = 0; i < kUploadTextureCount; ++i)
+		{
+			FakeGpuTexture& target = targets[i];
+			target.format = sources[i].format;
+			for (const auto& subresource : sources[i].subresources)
+			{
+				target.subresources.emplace_back(static_cast<size_t>(subresource.rowPitch * subresource.rowCount), 0);
+				target.rowBytes.push_back(subresource.rowPitch);
+			}
+		}
+
+		// 描画スレッドと同じく 1 フレームで kDefaultPublishesPerFrame 枚を作り、描画前に Flush する
+		const auto begin = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < kUploadTextureCount; ++i)
+		{
+			for (size_t mip = 0; mip < sources[i].subresources.size(); ++mip)
+			{
+				check(queue.UploadTexture(&targets[i], static_cast<uint32_t>(mip), sources[i].format, sources[i].subresources[mip]),
+					"UploadTexture accepts the subresource");
+			}
+			if ((i + 1) % TextureAssetManager::kDefaultPublishesPerFrame == 0 || i + 1 == kUploadTextureCount)
+			{
+				queue.Flush();
+				backend.AdvanceFrame();
+				++frames;
+			}
+		}
+		uploadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+		queue.WaitIdle();
+
+		check(backend.GetMisalignedCount() == 0, "staging placement and row pitch are aligned");
+		check(queue.GetUploadedBytes() == totalBytes, "uploaded byte count matches");
+		bool matches = true;
+		for (size_t i = 0; i < kUploadTextureCount; ++i)
+		{
+			matches = matches && targets[i].subresources == sources[i].mips;
+		}
+		check(matches, "every texel reaches its destination");
+
+		std::printf("%zu textures (%zu subresources, %.1f MB), %.0f MB staging\n", kUploadTextureCount, subresourceCount,
+			static_cast<double>(totalBytes) / (1024.0 * 1024.0), static_cast<double>(kUploadStagingSize) / (1024.0 * 1024.0));
+		std::printf("  per-texture writes : %zu WriteToSubresource calls into CPU-visible memory\n", subresourceCount);
+		std::printf("  upload ring        : %llu submits over %zu frames, %.2f ms recording\n",
+			static_cast<unsigned long long>(queue.GetSubmitCount()), frames, uploadMs);
+	}
+
+	CheckBufferUploads(false, check);
+	CheckBufferUploads(true, check);
+	CheckInvalidUploads(check);
+	CheckUploadRing(check);
+	return check.Report();
+}
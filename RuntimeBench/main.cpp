@@ -0,0 +1,211 @@
+﻿///=======================================================================
+/// RuntimeBench
+///   実行時処理（CPU 側）の計測用コマンドラインツール。
+///
+///   RuntimeBench models <入力 .pmd またはディレクトリ>...
+///   RuntimeBench mapped <入力 .pmd またはディレクトリ>...
+///   RuntimeBench meshopt <入力 .pmd またはディレクトリ>...
+///   RuntimeBench skinning <入力 .pmd またはディレクトリ>...
+///   RuntimeBench pose <入力 .pmd>
+///   RuntimeBench vmd <入力 .pmd> [モーション .vmd]
+///   RuntimeBench morph <入力 .pmd またはディレクトリ>...
+///   RuntimeBench textures
+///   RuntimeBench texcache
+///   RuntimeBench upload
+///   RuntimeBench atlas
+///   RuntimeBench residency
+///   RuntimeBench handles
+///   RuntimeBench memory [トレース .csv または .json]
+///   RuntimeBench decode [画像ファイルまたはディレクトリ]...
+///   RuntimeBench hotreload
+///   RuntimeBench descriptors
+///   RuntimeBench constants
+///   RuntimeBench sprites
+///
+///   models   : モデルを GPU を使わずに読み込んで PMDModelData を作り、各テーブルの数がファイルと一致し、
+///              テーブルをまたぐ添字（インデックス、親ボーン、IK のチェーン、表情、表示枠）が範囲に収まるか
+///              確認します。1 体あたりの読み込み時間も計測します。
+///   mapped   : 頂点の読み込みを以前の PMDAnalyzer（頂点ごとの fread）と PMDMappedReader で比べ、結果が一致するか
+///              確認します。MappedFile の開閉とムーブ、切り詰めたり数を書き換えたりしたファイルを開けないこと、
+///              開けた場合もビューがファイルの外を指さないことも確認します。
+///   meshopt  : モデルの三角形をマテリアルごとに並べ替えてから頂点を並べ替え（MeshCooker と同じ手順）、ACMR / ATVR を
+///              前後で比べます。同じ入力で同じ結果になること、三角形と向きが保たれること、再配置表が置換であること、
+///              メッシュレットの上限、不正な入力の扱い、32 ビットのインデックス（合成グリッド）も確認します。
+///   skinning : 命令セットごとのスキニング速度（頂点/秒）を計測し、
+///              スカラー版との結果がビット単位で一致するか確認します。
+///   pose     : インスタンス数を変えて姿勢評価（ワールド行列 + IK）の時間を計測し、
+///              1 フレーム（60fps）で評価できるインスタンス数を見積もります。
+///   vmd      : キーのサンプリング時間をインスタンス数を変えて計測し、カーソルと
+///              二分探索を比べます。ストリーミング再生の常駐キー数と一致も確認します。
+///              .vmd を省略した場合はモデルの全ボーンを動かす合成モーションを使います。
+///   morph    : キャラクター数を変えて表情の合成時間を計測し、書き換えた範囲の
+///              転送量を頂点バッファ全体の転送と比べます。
+///   textures : デコードに時間のかかる疑似ローダーで TextureAssetManager を動かし、
+///              AcquireTexture の待ち時間と公開までのフレーム数を同期読み込みと比べます。
+///              プレースホルダー・読み込み中の解放・Clear の扱いも確認します。
+///   texcache : 合成した元画像を TextureCache 経由で読み込み、キャッシュが空の起動（ミップ生成 +
+///              保存）と 2 回目の起動（マップのみ）の時間を比べます。内容の一致、キーの変化、
+///              サイズ上限での追い出し、壊れたエントリーの扱いも確認します。
+///   upload   : GPU を模した転送先で GpuUploadQueue にテクスチャーを流し、提出回数を
+///              テクスチャーごとの書き込みと比べます。行ピッチの整列、ステージングの折り返し、
+///              大きなミップの分割転送で内容が壊れないことも確認します。
+///              UploadBuffer も小さなステージングで何度も折り返させ、GPU が遅れている場合と止まっている場合に
+///              内容と前後の領域が壊れないことを確かめ、UploadRing を乱数で動かして完了前の領域を再利用しないことも確認します。
+///   atlas    : 大きさの異なる合成スプライトをアトラスに詰め、時間・充填率と、描画 1 フレームで
+///              切り替えるテクスチャの数を 1 枚ずつの場合と比べます。重なり、ガターの内容、
+///              ミップでのにじみ、定義ファイルの往復、TextureAssetManager での UV の解決も確認します。
+///   residency: 予算より大きなテクスチャー群の上をカメラが往復する負荷で TextureResidency を動かし、
+///              常駐量と読み込み・追い出しの量を全て常駐させる場合と比べます。予算を超えないこと、
+///              LRU の順、読み込み直し、固定と tail の扱い、TextureAssetManager での追い出しも確認します。
+///   handles  : 書き込みを続けながら複数スレッドでテクスチャーを引き、以前のミューテックスと
+///              unordered_map による検索と HandleTable（GetTexture / PeekTexture）の速度を比べます。
+///              解放済みハンドルの無効化、遅延解放、同時に読んだときの値の一貫性も確認します。
+///   memory   : D3D12 の配置規則（コミット済みリソースは 64KB 単位）を模した null デバイスで
+///              クアッドの生成と破棄を繰り返し、ResourceAccounting の集計とフレームごとのトレースを
+///              確認します。クアッドごとの定数バッファの無駄を 1 つのバッファにまとめた場合と比べます。
+///              トレースのパスを指定した場合はそこに書き出します（省略時は一時ファイル）。
+///   decode   : 合成した PNG / BMP / TGA を組み込みのデコーダーで読み、フィルターの復元をスカラーと
+///              SSE2 で比べます。全カラータイプ・ビット深度・Adam7・各フィルター・Deflate のブロック種別、
+///              BMP / TGA の各形式の往復と、壊れたデータの扱いも確認します。画像を指定した場合は
+///              その実ファイルのデコード時間も計測します（組み込みで読めない形式は WIC 任せとして数えます）。
+///   hotreload: 一時ディレクトリの画像を TextureAssetManager で読み込んで監視し、書き換えてから画面に
+///              反映されるまでの時間を、全テクスチャを読み込み直す場合（PIE の再起動）と比べます。
+///              ハンドルが変わらないこと、同じ大きさなら今のリソースに書き込むこと、大きさが変わったら
+///              差し替えること、書き込み途中のファイル、解放したテクスチャ、アトラスからの切り離しも確認します。
+///   descriptors: GPU が 2 フレーム遅れて進むとして DescriptorAllocator に確保・範囲確保・解放を乱数で
+///              与え、割り当てを別に持った写しと突き合わせます（重なり、ページをまたぐ範囲、フェンスの完了前の
+///              再利用、統計）。以前の即時に再利用する空きリストで使用中のディスクリプタを上書きした回数と比べ、
+///              複数スレッドからのフレームの領域の確保と、確保・解放の速度も計測します。
+///              スプライトの描画を模して DescriptorTableCache でテーブルを集め、内容と、描画ごとに
+///              集める場合とのコピー数も比べます。同じ描画をバインドレス（テクスチャーごとに永続領域へ
+///              1 回だけ写し、描画ではインデックスを渡すだけ）で行った場合のコピー数と時間も比べます。
+///   constants: 描画ごとの定数を FrameLinearAllocator でフレームの組のページから切り出し、GPU が 2 フレーム
+///              遅れて読むとして、読み終わる前に上書きされていないか・境界・ページの切り替えを確かめます。
+///              以前のオブジェクトごとのバッファを毎フレーム上書きした場合に読み込み中の値を書き換えた回数、
+///              コミット済みリソースの数と比べ、確保の速度も計測します。
+///   sprites  : 10 万枚のスプライトを SpriteBatch に集めてマテリアル・テクスチャーの順に並べ、1 フレームの
+///              時間を std::stable_sort と比べます。並びと安定性、画面外の除外、バッチの区切り（バインドレスなら
+///              マテリアルごと、そうでなければテクスチャーごと）と、描画の回数をスプライトごとの場合と比べます。
+///=======================================================================
+#include "BenchCommon.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+namespace
+{
+	int Run(const std::vector<std::filesystem::path>& args)
+	{
+		if (args.size() >= 2 && args[0] == "models")
+		{
+			return RunModelBenchmark(CollectInputs(args, 1));
+		}
+		if (args.size() >= 2 && args[0] == "mapped")
+		{
+			return RunMappedReaderBenchmark(CollectInputs(args, 1));
+		}
+		if (args.size() >= 2 && args[0] == "meshopt")
+		{
+			return RunMeshOptimizerBenchmark(CollectInputs(args, 1));
+		}
+		if (args.size() >= 2 && args[0] == "skinning")
+		{
+			return RunSkinningBenchmark(CollectInputs(args, 1));
+		}
+		if (args.size() == 2 && args[0] == "pose")
+		{
+			return RunPoseBenchmark(args[1]);
+		}
+		if ((args.size() == 2 || args.size() == 3) && args[0] == "vmd")
+		{
+			return RunMotionBenchmark(args[1], args.size() == 3 ? args[2] : std::filesystem::path());
+		}
+		if (args.size() >= 2 && args[0] == "morph")
+		{
+			return RunMorphBenchmark(CollectInputs(args, 1));
+		}
+		if (args.size() == 1 && args[0] == "textures")
+		{
+			return RunTextureBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "texcache")
+		{
+			return RunTextureCacheBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "upload")
+		{
+			return RunUploadBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "atlas")
+		{
+			return RunAtlasBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "residency")
+		{
+			return RunResidencyBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "handles")
+		{
+			return RunHandleBenchmark();
+		}
+		if ((args.size() == 1 || args.size() == 2) && args[0] == "memory")
+		{
+			return RunMemoryBenchmark(args.size() == 2 ? args[1] : std::filesystem::path());
+		}
+		if (args.size() >= 1 && args[0] == "decode")
+		{
+			return RunDecodeBenchmark(CollectFiles(args, 1));
+		}
+		if (args.size() == 1 && args[0] == "hotreload")
+		{
+			return RunHotReloadBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "descriptors")
+		{
+			return RunDescriptorBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "constants")
+		{
+			return RunConstantsBenchmark();
+		}
+		if (args.size() == 1 && args[0] == "sprites")
+		{
+			return RunSpriteBatchBenchmark();
+		}
+		std::fprintf(stderr, "usage: RuntimeBench models <input.pmd | directory>...\n");
+		std::fprintf(stderr, "       RuntimeBench mapped <input.pmd | directory>...\n");
+		std::fprintf(stderr, "       RuntimeBench meshopt <input.pmd | directory>...\n");
+		std::fprintf(stderr, "       RuntimeBench skinning <input.pmd | directory>...\n");
+		std::fprintf(stderr, "       RuntimeBench pose <input.pmd>\n");
+		std::fprintf(stderr, "       RuntimeBench vmd <input.pmd> [motion.vmd]\n");
+		std::fprintf(stderr, "       RuntimeBench morph <input.pmd | directory>...\n");
+		std::fprintf(stderr, "       RuntimeBench textures\n");
+		std::fprintf(stderr, "       RuntimeBench texcache\n");
+		std::fprintf(stderr, "       RuntimeBench upload\n");
+		std::fprintf(stderr, "       RuntimeBench atlas\n");
+		std::fprintf(stderr, "       RuntimeBench residency\n");
+		std::fprintf(stderr, "       RuntimeBench handles\n");
+		std::fprintf(stderr, "       RuntimeBench memory [trace.csv | trace.json]\n");
+		std::fprintf(stderr, "       RuntimeBench decode [image | directory]...\n");
+		std::fprintf(stderr, "       RuntimeBench hotreload\n");
+		std::fprintf(stderr, "       RuntimeBench descriptors\n");
+		std::fprintf(stderr, "       RuntimeBench constants\n");
+		std::fprintf(stderr, "       RuntimeBench sprites\n");
+		return 1;
+	}
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t** argv)
+#else
+int main(int argc, char** argv)
+#endif
+{
+	std::vector<std::filesystem::path> args;
+	for (int i = 1; i < argc; ++i)
+	{
+		args.emplace_back(argv[i]);
+	}
+	return Run(args);
+}
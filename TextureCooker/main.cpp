@@ -0,0 +1,453 @@
+﻿///=======================================================================
+/// TextureCooker
+///   テクスチャにミップを付けてブロック圧縮し、元ファイルの隣に .dds で保存するツール。
+///
+///   TextureCooker [--bench] [--force] [--filter box|kaiser] [--format auto|none|bc1|bc3|bc4|bc5|bc7] [--hq] [--linear]
+///                 [--atlas <出力.atlas>] <入力画像またはディレクトリ>...
+///
+///   --bench  : クックに加えて、ミップフィルタと各フォーマットのエンコード速度（Mtexel/秒）、
+///              RGBA8 と比べたサイズとサンプリング時の帯域（1 テクセルあたりのバイト数）を表示します。
+///   --force  : 元画像より新しく、同じ設定でクックした .dds があっても作り直します。
+///   --filter : ミップの縮小フィルタ（既定は kaiser）
+///   --format : 圧縮フォーマット（既定は auto: 不透明は BC1、アルファありは BC3）
+///   --hq     : auto でアルファありの場合に BC7 を使います。
+///   --linear : 色を sRGB ではなく線形として扱います（マスクなどのデータ用）。
+///   --atlas  : 入力を 1 枚ずつクックする代わりにアトラスへ詰め、ページ（<名前>_<番号>.png とその .dds）と
+///              定義ファイルを書き出します。ページのミップは Box フィルタで、ガターが残る段までです。
+///=======================================================================
+#include "Analyzer/TextureAtlas.h"
+#include "Analyzer/TextureCooker.h"
+
+#include <Windows.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace
+{
+	struct Options
+	{
+		bool runBenchmark = false;
+		/// 最新の .dds も作り直す
+		bool isForced = false;
+		TextureCooker::Settings settings;
+		/// 空でなければアトラスを作る
+		std::filesystem::path atlasPath;
+		std::vector<std::filesystem::path> inputs;
+	};
+
+	/// ベンチマークで比べるフォーマット
+	constexpr TextureCooker::Compression kBenchmarkCompressions[] =
+	{
+		TextureCooker::Compression::None,
+		TextureCooker::Compression::BC1,
+		TextureCooker::Compression::BC3,
+		TextureCooker::Compression::BC7,
+	};
+
+	std::string ToDisplayString(const std::filesystem::path& path)
+	{
+		return path.u8string();
+	}
+
+	/// WIC で読める画像か（PMD のスフィアマップ .sph/.spa は中身が BMP）
+	bool IsImageFile(const std::filesystem::path& path)
+	{
+		std::wstring extension = path.extension().wstring();
+		std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c)
+		{
+			return (c >= L'A' && c <= L'Z') ? static_cast<wchar_t>(c - L'A' + L'a') : c;
+		});
+		return extension == L".png" || extension == L".bmp" || extension == L".jpg" || extension == L".jpeg" ||
+			extension == L".tif" || extension == L".tiff" || extension == L".sph" || extension == L".spa";
+	}
+
+	bool ParseCompression(const std::filesystem::path& name, TextureCooker::Compression& outCompression)
+	{
+		const struct { const char* name; TextureCooker::Compression compression; } kNames[] =
+		{
+			{ "auto", TextureCooker::Compression::Auto },
+			{ "none", TextureCooker::Compression::None },
+			{ "bc1", TextureCooker::Compression::BC1 },
+			{ "bc3", TextureCooker::Compression::BC3 },
+			{ "bc4", TextureCooker::Compression::BC4 },
+			{ "bc5", TextureCooker::Compression::BC5 },
+			{ "bc7", TextureCooker::Compression::BC7 },
+		};
+		for (const auto& entry : kNames)
+		{
+			if (name == entry.name)
+			{
+				outCompression = entry.compression;
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool ParseArguments(const std::vector<std::filesystem::path>& args, Options& outOptions)
+	{
+		for (size_t i = 0; i < args.size(); ++i)
+		{
+			const std::filesystem::path& arg = args[i];
+			if (arg == "--bench")
+			{
+				outOptions.runBenchmark = true;
+			}
+			else if (arg == "--force")
+			{
+				outOptions.isForced = true;
+			}
+			else if (arg == "--hq")
+			{
+				outOptions.settings.highQuality = true;
+			}
+			else if (arg == "--linear")
+			{
+				outOptions.settings.isSrgb = false;
+			}
+			else if (arg == "--filter")
+			{
+				if (i + 1 >= args.size() || (args[i + 1] != "box" && args[i + 1] != "kaiser"))
+				{
+					return false;
+				}
+				outOptions.settings.mipFilter = args[++i] == "box" ? TextureMips::Filter::Box : TextureMips::Filter::Kaiser;
+			}
+			else if (arg == "--atlas")
+			{
+				if (i + 1 >= args.size())
+				{
+					return false;
+				}
+				outOptions.atlasPath = args[++i];
+			}
+			else if (arg == "--format")
+			{
+				if (i + 1 >= args.size() || !ParseCompression(args[i + 1], outOptions.settings.compression))
+				{
+					return false;
+				}
+				++i;
+			}
+			else if (std::filesystem::is_directory(arg))
+			{
+				for (const auto& entry : std::filesystem::directory_iterator(arg))
+				{
+					if (entry.is_regular_file() && IsImageFile(entry.path()))
+					{
+						outOptions.inputs.push_back(entry.path());
+					}
+				}
+			}
+			else
+			{
+				outOptions.inputs.push_back(arg);
+			}
+		}
+		std::sort(outOptions.inputs.begin(), outOptions.inputs.end());
+		return !outOptions.inputs.empty();
+	}
+
+	const char* GetFormatName(DXGI_FORMAT format)
+	{
+		switch (format)
+		{
+		case DXGI_FORMAT_R8G8B8A8_UNORM:	return "RGBA8";
+		case DXGI_FORMAT_BC1_UNORM:			return "BC1";
+		case DXGI_FORMAT_BC3_UNORM:			return "BC3";
+		case DXGI_FORMAT_BC4_UNORM:			return "BC4";
+		case DXGI_FORMAT_BC5_UNORM:			return "BC5";
+		case DXGI_FORMAT_BC7_UNORM:			return "BC7";
+		default:							return "?";
+		}
+	}
+
+	/// ミップチェーン全体のテクセル数（エンコード速度の分母）
+	double CountChainTexels(uint32_t width, uint32_t height)
+	{
+		double texels = 0.0;
+		for (uint32_t mip = 0; mip < TextureMips::GetMipCount(width, height); ++mip)
+		{
+			texels += static_cast<double>((std::max)(width >> mip, 1u)) * static_cast<double>((std::max)(height >> mip, 1u));
+		}
+		return texels;
+	}
+
+	///=================================================================
+	/// フィルタとフォーマットを変えてクックし、速度とサイズを比べます。
+	///   帯域は 1 テクセルのサンプリングで読むバイト数で、RGBA8 を基準にします。
+	///=================================================================
+	void RunBenchmark(const std::filesystem::path& input, const Options& options)
+	{
+		// 組み込みのデコーダーと WIC のデコード時間を比べる（扱えない形式なら WIC のみ）
+		DirectX::ScratchImage source;
+		auto decodeBegin = std::chrono::steady_clock::now();
+		if (TextureCooker::DecodeSourceImage(input, source) == ImageDecodeStatus::Decoded)
+		{
+			const double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeBegin).count();
+			std::printf("  decode (built-in) %.3f ms\n", decodeMs);
+		}
+		DirectX::ScratchImage wicSource;
+		decodeBegin = std::chrono::steady_clock::now();
+		if (SUCCEEDED(DirectX::LoadFromWICFile(input.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, wicSource)))
+		{
+			const double decodeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - decodeBegin).count();
+			std::printf("  decode (WIC) %.3f ms\n", decodeMs);
+			if (source.GetImageCount() == 0)
+			{
+				source = std::move(wicSource);
+			}
+		}
+		if (source.GetImageCount() == 0)
+		{
+			return;
+		}
+
+		const TextureMips::Filter filters[] = { TextureMips::Filter::Box, TextureMips::Filter::Kaiser };
+		for (TextureMips::Filter filter : filters)
+		{
+			TextureCooker::Settings settings = options.settings;
+			settings.mipFilter = filter;
+			settings.compression = TextureCooker::Compression::None;
+			DirectX::ScratchImage cooked;
+			TextureCooker::CookStatistics stats;
+			if (TextureCooker::Cook(source, settings, cooked, &stats))
+			{
+				std::printf("  mips %-6s: %8.3f ms (%6.1f Mtexel/s)\n", filter == TextureMips::Filter::Box ? "box" : "kaiser",
+					stats.mipMilliseconds, CountChainTexels(stats.width, stats.height) / 1000.0 / (std::max)(stats.mipMilliseconds, 1.0e-3));
+			}
+		}
+
+		for (TextureCooker::Compression compression : kBenchmarkCompressions)
+		{
+			TextureCooker::Settings settings = options.settings;
+			settings.compression = compression;
+			DirectX::ScratchImage cooked;
+			TextureCooker::CookStatistics stats;
+			std::string error;
+			if (!TextureCooker::Cook(source, settings, cooked, &stats, &error))
+			{
+				std::printf("  failed: %s\n", error.c_str());
+				continue;
+			}
+			const double rgbaChainBytes = CountChainTexels(stats.width, stats.height) * 4.0;
+			std::printf("  %-6s: encode %9.3f ms (%7.2f Mtexel/s), %8zu bytes (%5.1f%% of RGBA8 + mips), %.2f bytes/texel sampled (x%.1f less bandwidth)\n",
+				GetFormatName(stats.format), stats.encodeMilliseconds,
+				CountChainTexels(stats.width, stats.height) / 1000.0 / (std::max)(stats.encodeMilliseconds, 1.0e-3),
+				stats.cookedBytes, 100.0 * static_cast<double>(stats.cookedBytes) / rgbaChainBytes,
+				TextureCooker::GetBytesPerTexel(stats.format), 4.0 / TextureCooker::GetBytesPerTexel(stats.format));
+		}
+	}
+
+	bool CookFile(const Options& options, const std::filesystem::path& input)
+	{
+		if (!options.isForced && TextureCooker::IsCookedUpToDate(input, options.settings))
+		{
+			std::printf("%s: up to date\n", ToDisplayString(input).c_str());
+			if (options.runBenchmark)
+			{
+				RunBenchmark(input, options);
+			}
+			return true;
+		}
+
+		TextureCooker::CookStatistics stats;
+		std::string error;
+		if (!TextureCooker::CookFile(input, options.settings, &stats, &error))
+		{
+			std::fprintf(stderr, "error: %s: %s\n", ToDisplayString(input).c_str(), error.c_str());
+			return false;
+		}
+
+		const auto sourceSize = std::filesystem::file_size(input);
+		std::printf("%s -> %s (%ux%u, %u mips, %s, %zu bytes vs %zu bytes RGBA8 level 0, file %llu bytes)\n",
+			ToDisplayString(input).c_str(), ToDisplayString(TextureCooker::GetCookedPath(input)).c_str(),
+			stats.width, stats.height, stats.mipCount, GetFormatName(stats.format),
+			stats.cookedBytes, stats.uncompressedBytes, static_cast<unsigned long long>(sourceSize));
+
+		if (options.runBenchmark)
+		{
+			RunBenchmark(input, options);
+		}
+		return true;
+	}
+
+	bool LoadPixels(const std::filesystem::path& input, TextureAtlas::Image& outImage)
+	{
+		// 組み込みのデコーダーで扱える形式は outImage へ直接デコードする
+		ImageInfo info;
+		if (ImageDecoderRegistry::Get().DecodeFile(input, info, outImage.pixels) == ImageDecodeStatus::Decoded)
+		{
+			outImage.width = info.width;
+			outImage.height = info.height;
+			return true;
+		}
+
+		DirectX::ScratchImage source;
+		DirectX::ScratchImage converted;
+		if (FAILED(DirectX::LoadFromWICFile(input.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, source)))
+		{
+			return false;
+		}
+		const DirectX::Image* image = source.GetImage(0, 0, 0);
+		if (image->format != DXGI_FORMAT_R8G8B8A8_UNORM)
+		{
+			if (FAILED(DirectX::Convert(*image, DXGI_FORMAT_R8G8B8A8_UNORM, DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted)))
+			{
+				return false;
+			}
+			image = converted.GetImage(0, 0, 0);
+		}
+
+		outImage.width = static_cast<uint32_t>(image->width);
+		outImage.height = static_cast<uint32_t>(image->height);
+		outImage.pixels.resize(static_cast<size_t>(outImage.width) * outImage.height * 4);
+		const size_t packedPitch = static_cast<size_t>(outImage.width) * 4;
+		for (uint32_t y = 0; y < outImage.height; ++y)
+		{
+			std::memcpy(&outImage.pixels[y * packedPitch], image->pixels + y * image->rowPitch, packedPitch);
+		}
+		return true;
+	}
+
+	/// ページを PNG で保存し、ミップを制限してクックした .dds をその隣に置きます。
+	bool WritePage(const TextureAtlas::Image& page, const std::filesystem::path& pagePath, const TextureCooker::Settings& settings, std::string& outError)
+	{
+		DirectX::Image image = {};
+		image.width = page.width;
+		image.height = page.height;
+		image.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		image.rowPitch = static_cast<size_t>(page.width) * 4;
+		image.slicePitch = image.rowPitch * page.height;
+		image.pixels = const_cast<uint8_t*>(page.pixels.data());
+		if (FAILED(DirectX::SaveToWICFile(image, DirectX::WIC_FLAGS_NONE, DirectX::GetWICCodec(DirectX::WIC_CODEC_PNG), pagePath.c_str())))
+		{
+			outError = "failed to write atlas page";
+			return false;
+		}
+
+		// 実行時は元画像より新しい .dds を読むので、PNG の後に書く
+		DirectX::ScratchImage source;
+		DirectX::ScratchImage cooked;
+		if (FAILED(source.InitializeFromImage(image)) || !TextureCooker::Cook(source, settings, cooked, nullptr, &outError))
+		{
+			return false;
+		}
+		return TextureCooker::SaveCookedFile(cooked, settings, TextureCooker::GetCookedPath(pagePath), &outError);
+	}
+
+	///=================================================================
+	/// 入力をアトラスに詰めて、ページと定義ファイルを書き出します。
+	///   スプライトの名前はファイル名で、実行時は同じファイル名のテクスチャの取得がアトラスに解決されます。
+	///=================================================================
+	int BuildAtlas(const Options& options)
+	{
+		std::vector<TextureAtlas::Image> images(options.inputs.size());
+		std::vector<const TextureAtlas::Image*> sources(options.inputs.size(), nullptr);
+		std::vector<std::string> names;
+		for (size_t i = 0; i < options.inputs.size(); ++i)
+		{
+			names.push_back(options.inputs[i].filename().u8string());
+			if (LoadPixels(options.inputs[i], images[i]))
+			{
+				sources[i] = &images[i];
+			}
+			else
+			{
+				std::fprintf(stderr, "error: %s: failed to decode source image\n", ToDisplayString(options.inputs[i]).c_str());
+			}
+		}
+
+		const TextureAtlas::Settings atlasSettings;
+		const TextureAtlas::Atlas atlas = TextureAtlas::Build(names, sources, atlasSettings);
+
+		TextureCooker::Settings pageSettings = options.settings;
+		pageSettings.mipFilter = TextureMips::Filter::Box;
+		pageSettings.maxMipCount = TextureAtlas::GetSafeMipCount(atlasSettings.padding,
+			pageSettings.compression == TextureCooker::Compression::None ? 1u : 4u);
+
+		TextureAtlas::Manifest manifest;
+		const std::filesystem::path directory = options.atlasPath.parent_path();
+		for (size_t page = 0; page < atlas.pages.size(); ++page)
+		{
+			TextureAtlas::Manifest::Page manifestPage;
+			manifestPage.fileName = options.atlasPath.stem().u8string() + "_" + std::to_string(page) + ".png";
+			manifestPage.width = atlas.pages[page].width;
+			manifestPage.height = atlas.pages[page].height;
+
+			std::string error;
+			if (!WritePage(atlas.pages[page], directory / std::filesystem::u8path(manifestPage.fileName), pageSettings, error))
+			{
+				std::fprintf(stderr, "error: %s: %s\n", manifestPage.fileName.c_str(), error.c_str());
+				return 1;
+			}
+			std::printf("page %zu: %ux%u, %u mips\n", page, manifestPage.width, manifestPage.height, pageSettings.maxMipCount);
+			manifest.pages.push_back(std::move(manifestPage));
+		}
+		manifest.placements = atlas.placements;
+		if (!TextureAtlas::SaveManifest(options.atlasPath, manifest))
+		{
+			std::fprintf(stderr, "error: %s: failed to write atlas manifest\n", ToDisplayString(options.atlasPath).c_str());
+			return 1;
+		}
+
+		for (const std::string& name : atlas.rejected)
+		{
+			std::printf("  not packed (too large or unreadable): %s\n", name.c_str());
+		}
+		// 同じページを使うスプライトはテクスチャを切り替えずに描画できる
+		std::printf("%s: %zu sprites in %zu pages, occupancy %.1f%%, textures to bind %zu -> %zu\n",
+			ToDisplayString(options.atlasPath).c_str(), atlas.statistics.spriteCount, atlas.pages.size(),
+			100.0 * atlas.statistics.GetOccupancy(), atlas.statistics.spriteCount, atlas.pages.size());
+		return atlas.rejected.empty() ? 0 : 1;
+	}
+
+	int Run(const std::vector<std::filesystem::path>& args)
+	{
+		Options options;
+		if (!ParseArguments(args, options))
+		{
+			std::fprintf(stderr, "usage: TextureCooker [--bench] [--force] [--filter box|kaiser] [--format auto|none|bc1|bc3|bc4|bc5|bc7] [--hq] [--linear] [--atlas <output.atlas>] <image | directory>...\n");
+			return 1;
+		}
+		if (!options.atlasPath.empty())
+		{
+			return BuildAtlas(options);
+		}
+
+		int failedCount = 0;
+		for (const auto& input : options.inputs)
+		{
+			if (!CookFile(options, input))
+			{
+				++failedCount;
+			}
+		}
+		return failedCount == 0 ? 0 : 1;
+	}
+}
+
+int wmain(int argc, wchar_t** argv)
+{
+	// WIC の読み込みに COM が必要
+	const HRESULT comHr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+
+	std::vector<std::filesystem::path> args;
+	for (int i = 1; i < argc; ++i)
+	{
+		args.emplace_back(argv[i]);
+	}
+	const int result = Run(args);
+
+	if (SUCCEEDED(comHr))
+	{
+		CoUninitialize();
+	}
+	return result;
+}